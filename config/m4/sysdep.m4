@@ -52,6 +52,14 @@ AC_CHECK_DECLS([ethtool_cmd_speed, SPEED_UNKNOWN], [], [],
                [#include <linux/ethtool.h>])
 
 
+#
+# TCP zero-copy send
+#
+AC_CHECK_DECLS([MSG_ZEROCOPY, SO_ZEROCOPY, SO_EE_ORIGIN_ZEROCOPY], [], [],
+               [#include <sys/socket.h>
+#include <linux/errqueue.h>])
+
+
 #
 # PowerPC query for TB frequency
 #
@@ -296,6 +296,43 @@ run_ucx_perftest_mpi() {
 	done
 }
 
+#
+# Run UCX performance test with JSON output, and parse the result
+#
+test_ucx_perftest_json() {
+	echo "==== Running ucx_perftest with JSON output ===="
+	UCX_PERFTEST=$ucx_inst/bin/ucx_perftest
+	tcp_port=$((10000 + EXECUTOR_NUMBER))
+
+	# the test name has characters which must be escaped in JSON, and both
+	# sides read the batch file, since the server gets only the command line
+	# parameters of the client
+	printf '%s\n' 'put"lat\ -t put_lat -n 1000' > perftest_json.batch
+
+	$UCX_PERFTEST -p ${tcp_port} -b perftest_json.batch &
+	perftest_server_pid=$!
+
+	sleep 5
+
+	$UCX_PERFTEST $(hostname) -p ${tcp_port} -b perftest_json.batch \
+		-x mm -d posix -w 100 -f json -L 50,99 > perftest_json.out
+	wait ${perftest_server_pid}
+
+	python -c '
+import json, sys
+result = json.loads(sys.stdin.readline())
+assert result["batch"] == ["put\"lat\\"], result["batch"]
+assert result["test"] == "put_lat"
+assert result["transport"] == "mm"
+assert result["device"] == "posix"
+assert result["iterations"] == 1000
+percentiles = result["latency_usec"]["percentiles"]
+assert sorted(percentiles.keys()) == ["50", "99"], percentiles
+assert 0 < percentiles["50"] <= percentiles["99"], percentiles
+' < perftest_json.out
+	rm -f perftest_json.batch perftest_json.out
+}
+
 #
 # Test malloc hooks with mpi
 #
@@ -468,6 +505,7 @@ run_tests() {
 	do_distributed_task 1 4 run_ucp_hello
 	do_distributed_task 2 4 run_uct_hello
 	do_distributed_task 3 4 test_profiling
+	do_distributed_task 0 4 test_ucx_perftest_json
 
 	# all are running gtest
 	run_gtest
@@ -25,6 +25,7 @@ static void usage() {
     printf("  -e         UCP endpoint\n");
     printf("  -u         UCP features to use. String of one or more of:\n");
     printf("                'a' : atomic operations\n");
+    printf("                'm' : active messages\n");
     printf("                'r' : remote memory access\n");
     printf("                't' : tag matching \n");
     printf("                'w' : wakeup\n");
@@ -99,6 +100,9 @@ int main(int argc, char **argv)
                 case 'a':
                     ucp_features |= UCP_FEATURE_AMO32|UCP_FEATURE_AMO64;
                     break;
+                case 'm':
+                    ucp_features |= UCP_FEATURE_AM;
+                    break;
                 case 'r':
                     ucp_features |= UCP_FEATURE_RMA;
                     break;
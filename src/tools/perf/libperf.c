@@ -7,11 +7,18 @@
 * See file LICENSE for terms.
 */
 
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
 #include "libperf_int.h"
 
 #include <ucs/debug/log.h>
+#include <ucs/sys/sys.h>
 #include <malloc.h>
 #include <unistd.h>
+#include <sched.h>
+#include <math.h>
 
 
 typedef struct {
@@ -88,6 +95,15 @@ static ucs_time_t __find_median_quick_select(ucs_time_t arr[], int n)
     }
 }
 
+/*
+ * Number of threads which use the same test buffers, each at its own offset
+ */
+static unsigned ucx_perf_buffer_thread_count(const ucx_perf_params_t *params)
+{
+    return (params->thread_model == UCX_PERF_THREAD_MODEL_WORKER) ? 1 :
+           params->thread_count;
+}
+
 static ucs_status_t uct_perf_test_alloc_mem(ucx_perf_context_t *perf,
                                             ucx_perf_params_t *params)
 {
@@ -108,7 +124,7 @@ static ucs_status_t uct_perf_test_alloc_mem(ucx_perf_context_t *perf,
 
     /* Allocate send buffer memory */
     status = uct_iface_mem_alloc(perf->uct.iface, 
-                                 buffer_size * params->thread_count,
+                                 buffer_size * ucx_perf_buffer_thread_count(params),
                                  flags, "perftest", &perf->uct.send_mem);
     if (status != UCS_OK) {
         ucs_error("Failed allocate send buffer: %s", ucs_status_string(status));
@@ -120,7 +136,7 @@ static ucs_status_t uct_perf_test_alloc_mem(ucx_perf_context_t *perf,
 
     /* Allocate receive buffer memory */
     status = uct_iface_mem_alloc(perf->uct.iface, 
-                                 buffer_size * params->thread_count,
+                                 buffer_size * ucx_perf_buffer_thread_count(params),
                                  flags, "perftest", &perf->uct.recv_mem);
     if (status != UCS_OK) {
         ucs_error("Failed allocate receive buffer: %s", ucs_status_string(status));
@@ -134,7 +150,7 @@ static ucs_status_t uct_perf_test_alloc_mem(ucx_perf_context_t *perf,
     perf->params.msg_size_cnt = params->msg_size_cnt;
     perf->uct.iov             = malloc(sizeof(*perf->uct.iov) *
                                        perf->params.msg_size_cnt *
-                                       params->thread_count);
+                                       ucx_perf_buffer_thread_count(params));
     if (NULL == perf->uct.iov) {
         status = UCS_ERR_NO_MEMORY;
         ucs_error("Failed allocate send IOV(%lu) buffer: %s",
@@ -194,6 +210,66 @@ static void ucx_perf_test_reset(ucx_perf_context_t *perf,
     for (i = 0; i < TIMING_QUEUE_SIZE; ++i) {
         perf->timing_queue[i] = 0;
     }
+    memset(perf->latency_hist, 0, sizeof(perf->latency_hist));
+}
+
+double ucx_perf_hist_value(unsigned index)
+{
+    unsigned shift;
+
+    if (index < UCX_PERF_HIST_SUB_COUNT) {
+        return index;
+    }
+
+    shift = (index >> UCX_PERF_HIST_SUB_BITS) - 1;
+    return (double)(((index & (UCX_PERF_HIST_SUB_COUNT - 1)) +
+                     UCX_PERF_HIST_SUB_COUNT) << shift) +
+           (UCS_BIT(shift) - 1) / 2.0;
+}
+
+void ucx_perf_hist_merge(ucx_perf_context_t *perf,
+                         const ucx_perf_context_t *other)
+{
+    unsigned index;
+
+    for (index = 0; index < UCX_PERF_HIST_SIZE; ++index) {
+        perf->latency_hist[index] += other->latency_hist[index];
+    }
+}
+
+void ucx_perf_calc_percentiles(ucx_perf_context_t *perf,
+                               ucx_perf_result_t *result, double time_unit)
+{
+    ucx_perf_counter_t total, count, rank_count;
+    unsigned i, index;
+
+    total = 0;
+    for (index = 0; index < UCX_PERF_HIST_SIZE; ++index) {
+        total += perf->latency_hist[index];
+    }
+
+    result->percentiles_cnt = ucs_min(perf->params.percentiles_cnt,
+                                      UCX_PERF_MAX_PERCENTILES);
+    for (i = 0; i < result->percentiles_cnt; ++i) {
+        result->percentiles[i].rank    = perf->params.percentiles[i];
+        result->percentiles[i].latency = 0.0;
+        if (total == 0) {
+            continue;
+        }
+
+        /* Smallest bucket which covers at least rank% of the samples */
+        rank_count = ucs_max((ucx_perf_counter_t)
+                             ceil(total * perf->params.percentiles[i] / 100.0), 1);
+        count      = 0;
+        for (index = 0; index < UCX_PERF_HIST_SIZE; ++index) {
+            count += perf->latency_hist[index];
+            if (count >= rank_count) {
+                break;
+            }
+        }
+
+        result->percentiles[i].latency = ucx_perf_hist_value(index) / time_unit;
+    }
 }
 
 void ucx_perf_calc_result(ucx_perf_context_t *perf, ucx_perf_result_t *result)
@@ -257,10 +333,15 @@ void ucx_perf_calc_result(ucx_perf_context_t *perf, ucx_perf_result_t *result)
         perf->current.msgs * sec_value
         / (double)(perf->current.time - perf->start_time);
 
+
+    /* Latency distribution */
+
+    ucx_perf_calc_percentiles(perf, result, sec_value * latency_factor);
 }
 
 static ucs_status_t ucx_perf_test_check_params(ucx_perf_params_t *params)
 {
+    unsigned i;
     size_t it;
 
     if (ucx_perf_get_message_size(params) < 1) {
@@ -277,6 +358,24 @@ static ucs_status_t ucx_perf_test_check_params(ucx_perf_params_t *params)
         return UCS_ERR_INVALID_PARAM;
     }
 
+    if (params->percentiles_cnt > UCX_PERF_MAX_PERCENTILES) {
+        if (params->flags & UCX_PERF_TEST_FLAG_VERBOSE) {
+            ucs_error("Too many percentiles (%u), maximum is %d",
+                      params->percentiles_cnt, UCX_PERF_MAX_PERCENTILES);
+        }
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    for (i = 0; i < params->percentiles_cnt; ++i) {
+        if ((params->percentiles[i] < 0.0) || (params->percentiles[i] > 100.0)) {
+            if (params->flags & UCX_PERF_TEST_FLAG_VERBOSE) {
+                ucs_error("Invalid percentile %g, need to be in 0..100",
+                          params->percentiles[i]);
+            }
+            return UCS_ERR_INVALID_PARAM;
+        }
+    }
+
     /* check if particular message size fit into stride size */
     if (params->iov_stride) {
         for (it = 0; it < params->msg_size_cnt; ++it) {
@@ -718,6 +817,9 @@ static ucs_status_t ucp_perf_test_check_params(ucx_perf_params_t *params,
     case UCX_PERF_CMD_TAG:
         *features = UCP_FEATURE_TAG;
         break;
+    case UCX_PERF_CMD_AM:
+        *features = UCP_FEATURE_AM;
+        break;
     default:
         if (params->flags & UCX_PERF_TEST_FLAG_VERBOSE) {
             ucs_error("Invalid test command");
@@ -770,7 +872,7 @@ static ucs_status_t ucp_perf_test_alloc_mem(ucx_perf_context_t *perf, ucx_perf_p
                                 UCP_MEM_MAP_PARAM_FIELD_LENGTH |
                                 UCP_MEM_MAP_PARAM_FIELD_FLAGS;
     mem_map_params.address    = perf->send_buffer;
-    mem_map_params.length     = buffer_size * params->thread_count;
+    mem_map_params.length     = buffer_size * ucx_perf_buffer_thread_count(params);
     mem_map_params.flags      = (params->flags & UCX_PERF_TEST_FLAG_MAP_NONBLOCK) ?
                                  UCP_MEM_MAP_NONBLOCK : 0;
 
@@ -788,7 +890,7 @@ static ucs_status_t ucp_perf_test_alloc_mem(ucx_perf_context_t *perf, ucx_perf_p
                                 UCP_MEM_MAP_PARAM_FIELD_LENGTH |
                                 UCP_MEM_MAP_PARAM_FIELD_FLAGS;
     mem_map_params.address    = perf->recv_buffer;
-    mem_map_params.length     = buffer_size * params->thread_count;
+    mem_map_params.length     = buffer_size * ucx_perf_buffer_thread_count(params);
     mem_map_params.flags      = 0;
 
     status = ucp_mem_map(perf->ucp.context, &mem_map_params, &perf->ucp.recv_memh);
@@ -801,14 +903,16 @@ static ucs_status_t ucp_perf_test_alloc_mem(ucx_perf_context_t *perf, ucx_perf_p
     perf->params.msg_size_cnt = params->msg_size_cnt;
     perf->ucp.send_iov        = NULL;
     status = ucp_perf_test_alloc_iov_mem(params->ucp.send_datatype, perf->params.msg_size_cnt,
-                                         params->thread_count, &perf->ucp.send_iov);
+                                         ucx_perf_buffer_thread_count(params),
+                                         &perf->ucp.send_iov);
     if (UCS_OK != status) {
         goto err_free_buffers;
     }
 
     perf->ucp.recv_iov        = NULL;
     status = ucp_perf_test_alloc_iov_mem(params->ucp.recv_datatype, perf->params.msg_size_cnt,
-                                         params->thread_count, &perf->ucp.recv_iov);
+                                         ucx_perf_buffer_thread_count(params),
+                                         &perf->ucp.recv_iov);
     if (UCS_OK != status) {
         goto err_free_send_iov_buffers;
     }
@@ -1153,32 +1257,36 @@ static void uct_perf_cleanup(ucx_perf_context_t *perf)
     ucs_async_context_cleanup(&perf->uct.async);
 }
 
-static ucs_status_t ucp_perf_setup(ucx_perf_context_t *perf, ucx_perf_params_t *params)
+/*
+ * Additional threads of the worker thread model open their own interface,
+ * and those of the endpoint thread model connect their own endpoints on the
+ * interface of the first thread.
+ */
+static ucs_status_t uct_perf_thread_setup(ucx_perf_context_t *perf,
+                                          ucx_perf_params_t *params)
 {
-    ucp_params_t ucp_params;
-    ucp_worker_params_t worker_params;
-    ucp_config_t *config;
-    ucs_status_t status;
-    uint64_t features;
-
-    status = ucp_perf_test_check_params(params, &features);
-    if (status != UCS_OK) {
-        goto err;
+    if (params->thread_model == UCX_PERF_THREAD_MODEL_EP) {
+        return uct_perf_test_setup_endpoints(perf);
     }
 
-    status = ucp_config_read(NULL, NULL, &config);
-    if (status != UCS_OK) {
-        goto err;
-    }
-
-    ucp_params.field_mask      = UCP_PARAM_FIELD_FEATURES;
-    ucp_params.features        = features;
+    return uct_perf_setup(perf, params);
+}
 
-    status = ucp_init(&ucp_params, config, &perf->ucp.context);
-    ucp_config_release(config);
-    if (status != UCS_OK) {
-        goto err;
+static void uct_perf_thread_cleanup(ucx_perf_context_t *perf)
+{
+    if (perf->params.thread_model == UCX_PERF_THREAD_MODEL_EP) {
+        uct_perf_test_cleanup_endpoints(perf);
+    } else {
+        uct_perf_cleanup(perf);
     }
+}
+
+static ucs_status_t ucp_perf_worker_setup(ucx_perf_context_t *perf,
+                                          ucx_perf_params_t *params,
+                                          uint64_t features)
+{
+    ucp_worker_params_t worker_params;
+    ucs_status_t status;
 
     worker_params.field_mask  = UCP_WORKER_PARAM_FIELD_THREAD_MODE;
     worker_params.thread_mode = params->thread_mode;
@@ -1186,7 +1294,7 @@ static ucs_status_t ucp_perf_setup(ucx_perf_context_t *perf, ucx_perf_params_t *
     status = ucp_worker_create(perf->ucp.context, &worker_params,
                                &perf->ucp.worker);
     if (status != UCS_OK) {
-        goto err_cleanup;
+        goto err;
     }
 
     status = ucp_perf_test_alloc_mem(perf, params);
@@ -1209,28 +1317,97 @@ err_free_mem:
     ucp_perf_test_free_mem(perf);
 err_destroy_worker:
     ucp_worker_destroy(perf->ucp.worker);
-err_cleanup:
-    ucp_cleanup(perf->ucp.context);
 err:
     return status;
 }
 
-static void ucp_perf_cleanup(ucx_perf_context_t *perf)
+static void ucp_perf_worker_cleanup(ucx_perf_context_t *perf)
 {
     ucp_perf_test_cleanup_endpoints(perf);
     rte_call(perf, barrier);
     ucp_perf_test_free_mem(perf);
     ucp_worker_destroy(perf->ucp.worker);
+}
+
+static ucs_status_t ucp_perf_setup(ucx_perf_context_t *perf, ucx_perf_params_t *params)
+{
+    ucp_params_t ucp_params;
+    ucp_config_t *config;
+    ucs_status_t status;
+    uint64_t features;
+
+    status = ucp_perf_test_check_params(params, &features);
+    if (status != UCS_OK) {
+        goto err;
+    }
+
+    status = ucp_config_read(NULL, NULL, &config);
+    if (status != UCS_OK) {
+        goto err;
+    }
+
+    ucp_params.field_mask      = UCP_PARAM_FIELD_FEATURES;
+    ucp_params.features        = features;
+
+    status = ucp_init(&ucp_params, config, &perf->ucp.context);
+    ucp_config_release(config);
+    if (status != UCS_OK) {
+        goto err;
+    }
+
+    status = ucp_perf_worker_setup(perf, params, features);
+    if (status != UCS_OK) {
+        goto err_cleanup;
+    }
+
+    return UCS_OK;
+
+err_cleanup:
     ucp_cleanup(perf->ucp.context);
+err:
+    return status;
+}
+
+static void ucp_perf_cleanup(ucx_perf_context_t *perf)
+{
+    ucp_perf_worker_cleanup(perf);
+    ucp_cleanup(perf->ucp.context);
+}
+
+/*
+ * Additional threads of the worker thread model create their own workers on
+ * the context of the first thread.
+ */
+static ucs_status_t ucp_perf_thread_setup(ucx_perf_context_t *perf,
+                                          ucx_perf_params_t *params)
+{
+    ucs_status_t status;
+    uint64_t features;
+
+    status = ucp_perf_test_check_params(params, &features);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    return ucp_perf_worker_setup(perf, params, features);
+}
+
+static void ucp_perf_thread_cleanup(ucx_perf_context_t *perf)
+{
+    ucp_perf_worker_cleanup(perf);
 }
 
 static struct {
     ucs_status_t (*setup)(ucx_perf_context_t *perf, ucx_perf_params_t *params);
     void         (*cleanup)(ucx_perf_context_t *perf);
     ucs_status_t (*run)(ucx_perf_context_t *perf);
+    ucs_status_t (*thread_setup)(ucx_perf_context_t *perf, ucx_perf_params_t *params);
+    void         (*thread_cleanup)(ucx_perf_context_t *perf);
 } ucx_perf_funcs[] = {
-    [UCX_PERF_API_UCT] = {uct_perf_setup, uct_perf_cleanup, uct_perf_test_dispatch},
-    [UCX_PERF_API_UCP] = {ucp_perf_setup, ucp_perf_cleanup, ucp_perf_test_dispatch}
+    [UCX_PERF_API_UCT] = {uct_perf_setup, uct_perf_cleanup, uct_perf_test_dispatch,
+                          uct_perf_thread_setup, uct_perf_thread_cleanup},
+    [UCX_PERF_API_UCP] = {ucp_perf_setup, ucp_perf_cleanup, ucp_perf_test_dispatch,
+                          ucp_perf_thread_setup, ucp_perf_thread_cleanup}
 };
 
 static int ucx_perf_thread_spawn(ucx_perf_params_t* params,
@@ -1253,10 +1430,11 @@ ucs_status_t ucx_perf_run(ucx_perf_params_t *params, ucx_perf_result_t *result)
         goto out;
     }
 
-    if (UCS_THREAD_MODE_SINGLE != params->thread_mode) {
+    if ((params->thread_count > 1) ||
+        (UCS_THREAD_MODE_SINGLE != params->thread_mode)) {
         return ucx_perf_thread_spawn(params, result);
     }
-        
+
     ucx_perf_test_reset(&perf, params);
 
     status = ucx_perf_funcs[params->api].setup(&perf, params);
@@ -1289,12 +1467,37 @@ out:
     return status;
 }
 
+ucs_status_t ucx_perf_parse_cpu_list(const char *str, unsigned *cpus,
+                                     unsigned max_cpus, unsigned *cpus_cnt)
+{
+    const char *p = str;
+    char *endptr;
+    unsigned count;
+
+    count = 0;
+    do {
+        if (count >= max_cpus) {
+            ucs_error("Too many CPUs in '%s' (max: %u)", str, max_cpus);
+            return UCS_ERR_INVALID_PARAM;
+        }
+
+        cpus[count++] = strtoul(p, &endptr, 10);
+        if ((endptr == p) || ((*endptr != ',') && (*endptr != '\0'))) {
+            ucs_error("Invalid CPU list '%s'", str);
+            return UCS_ERR_INVALID_PARAM;
+        }
+        p = endptr + 1;
+    } while (*endptr == ',');
+
+    *cpus_cnt = count;
+    return UCS_OK;
+}
+
 #if _OPENMP
-/* multiple threads sharing the same worker/iface */
+/* multiple threads, sharing communication objects according to the thread model */
 #include <omp.h>
 
 typedef struct {
-    pthread_t           pt;
     int                 tid;
     int                 ntid;
     ucs_status_t*       statuses;
@@ -1304,83 +1507,294 @@ typedef struct {
 } ucx_perf_thread_context_t;
 
 
+static void ucx_perf_thread_set_affinity(ucx_perf_thread_context_t* tctx)
+{
+    ucx_perf_params_t* params = &tctx->params;
+    cpu_set_t cpuset;
+    unsigned cpu;
+
+    if (params->thread_cpus == NULL) {
+        return;
+    }
+
+    cpu = params->thread_cpus[tctx->tid % params->thread_cpus_cnt];
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    if (sched_setaffinity(ucs_get_tid(), sizeof(cpuset), &cpuset)) {
+        ucs_warn("failed to bind thread %d to cpu %u: %m", tctx->tid, cpu);
+    }
+}
+
+static void ucx_perf_thread_reset(ucx_perf_thread_context_t* tctx)
+{
+    ptrdiff_t offset = tctx->perf.offset;
+
+    ucx_perf_test_reset(&tctx->perf, &tctx->params);
+    tctx->perf.offset = offset;
+    if (tctx->tid != 0) {
+        /* Only the master thread reports intermediate results */
+        tctx->perf.report_interval = -1;
+    }
+}
+
+static int ucx_perf_thread_check_statuses(ucx_perf_thread_context_t* tctx)
+{
+    int i;
+
+    for (i = 0; i < tctx->ntid; i++) {
+        if (UCS_OK != tctx->statuses[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
 static void* ucx_perf_thread_run_test(void* arg) {
     ucx_perf_thread_context_t* tctx = (ucx_perf_thread_context_t*) arg;
     ucx_perf_params_t* params = &tctx->params;
-    ucx_perf_result_t* result = &tctx->result;
     ucx_perf_context_t* perf = &tctx->perf;
     ucs_status_t* statuses = tctx->statuses;
     int tid = tctx->tid;
-    int i;
+
+    ucx_perf_thread_set_affinity(tctx);
+    ucx_perf_thread_reset(tctx);
 
     if (params->warmup_iter > 0) {
         ucx_perf_set_warmup(perf, params);
         statuses[tid] = ucx_perf_funcs[params->api].run(perf);
         rte_call(perf, barrier);
-        for (i = 0; i < tctx->ntid; i++) {
-            if (UCS_OK != statuses[i]) {
-                goto out;
-            }
+#pragma omp barrier
+        if (!ucx_perf_thread_check_statuses(tctx)) {
+            goto out;
         }
-#pragma omp master
-        ucx_perf_test_reset(perf, params);
+        ucx_perf_thread_reset(tctx);
     }
 
     /* Run test */
 #pragma omp barrier
     statuses[tid] = ucx_perf_funcs[params->api].run(perf);
     rte_call(perf, barrier);
-    for (i = 0; i < tctx->ntid; i++) {
-        if (UCS_OK != statuses[i]) {
-            goto out;
-        }
-    }
-#pragma omp master
-    {
-        /* Assuming all threads are fairly treated, reporting only tid==0
-            TODO: aggregate reports */
-        ucx_perf_calc_result(perf, result);
-        rte_call(perf, report, result, perf->params.report_arg, 1);
+#pragma omp barrier
+    if (!ucx_perf_thread_check_statuses(tctx)) {
+        goto out;
     }
 
+    ucx_perf_calc_result(perf, &tctx->result);
+
 out:
     return &statuses[tid];
 }
 
+static ucs_status_t ucx_perf_thread_check_params(ucx_perf_params_t* params)
+{
+    if (params->thread_model >= UCX_PERF_THREAD_MODEL_LAST) {
+        ucs_error("Invalid thread model");
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    if ((params->thread_model != UCX_PERF_THREAD_MODEL_WORKER) &&
+        (params->thread_count > 1) &&
+        (params->thread_mode != UCS_THREAD_MODE_MULTI)) {
+        ucs_error("Threads which share a worker require multi-thread mode");
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    if (params->thread_model == UCX_PERF_THREAD_MODEL_EP) {
+        if (params->api == UCX_PERF_API_UCP) {
+            ucs_error("UCP has a single endpoint per remote worker, use the "
+                      "worker thread model instead");
+            return UCS_ERR_UNSUPPORTED;
+        }
+        if (params->command == UCX_PERF_CMD_AM) {
+            ucs_error("Active message handlers are per interface, cannot use "
+                      "the endpoint thread model");
+            return UCS_ERR_UNSUPPORTED;
+        }
+    }
+
+    if ((params->thread_cpus != NULL) && (params->thread_cpus_cnt == 0)) {
+        ucs_error("Empty thread CPU list");
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    return UCS_OK;
+}
+
+/*
+ * Make the context of an additional thread out of the master thread context.
+ */
+static ucs_status_t ucx_perf_thread_setup(ucx_perf_thread_context_t* tctx,
+                                          const ucx_perf_context_t* master_perf)
+{
+    ucx_perf_params_t* params = &tctx->params;
+    ucx_perf_context_t* perf  = &tctx->perf;
+    size_t message_size       = ucx_perf_get_message_size(params);
+    size_t iovcnt             = params->msg_size_cnt;
+    int ti                    = tctx->tid;
+
+    *perf = *master_perf;
+    if (params->thread_model == UCX_PERF_THREAD_MODEL_WORKER) {
+        return ucx_perf_funcs[params->api].thread_setup(perf, params);
+    }
+
+    /* Doctor the src and dst buffers to make them thread specific */
+    perf->send_buffer += ti * message_size;
+    perf->recv_buffer += ti * message_size;
+    if (params->api == UCX_PERF_API_UCT) {
+        perf->uct.iov += ti * iovcnt;
+    } else {
+        if (perf->ucp.send_iov != NULL) {
+            perf->ucp.send_iov += ti * iovcnt;
+        }
+        if (perf->ucp.recv_iov != NULL) {
+            perf->ucp.recv_iov += ti * iovcnt;
+        }
+    }
+
+    if (params->thread_model == UCX_PERF_THREAD_MODEL_EP) {
+        /* The peer gets the thread specific receive buffer as remote address */
+        return ucx_perf_funcs[params->api].thread_setup(perf, params);
+    }
+
+    perf->offset = ti * message_size;
+    return UCS_OK;
+}
+
+static void ucx_perf_thread_cleanup(ucx_perf_thread_context_t* tctx)
+{
+    if (tctx->params.thread_model != UCX_PERF_THREAD_MODEL_SHARED) {
+        ucx_perf_funcs[tctx->params.api].thread_cleanup(&tctx->perf);
+    }
+}
+
+static void ucx_perf_calc_spread(const ucx_perf_thread_context_t* tctx,
+                                 int nti, size_t offset,
+                                 ucx_perf_spread_t* spread)
+{
+    double value, sum, sum_sq, mean;
+    int ti;
+
+    sum    = 0.0;
+    sum_sq = 0.0;
+    for (ti = 0; ti < nti; ti++) {
+        value = *(const double*)((const char*)&tctx[ti].result + offset);
+        if ((ti == 0) || (value < spread->min)) {
+            spread->min = value;
+        }
+        if ((ti == 0) || (value > spread->max)) {
+            spread->max = value;
+        }
+        sum    += value;
+        sum_sq += value * value;
+    }
+
+    mean           = sum / nti;
+    spread->stddev = sqrt(ucs_max(sum_sq / nti - mean * mean, 0.0));
+}
+
+/*
+ * The result of the whole test: counters, bandwidth and message rate are the
+ * sums over the threads, latency is the average over the threads, and the
+ * percentiles are taken from the histograms of all threads merged together.
+ */
+static void ucx_perf_calc_thread_results(ucx_perf_thread_context_t* tctx,
+                                         int nti, ucx_perf_result_t* result,
+                                         ucx_perf_result_t* results,
+                                         ucx_perf_thread_results_t* threads)
+{
+    ucx_perf_context_t* perf = &tctx[0].perf;
+    const ucx_perf_result_t* tres;
+    double time_unit;
+    int ti;
+
+    memset(result, 0, sizeof(*result));
+    for (ti = 0; ti < nti; ti++) {
+        tres                              = &tctx[ti].result;
+        results[ti]                       = *tres;
+        result->iters                    += tres->iters;
+        result->bytes                    += tres->bytes;
+        result->elapsed_time              = ucs_max(result->elapsed_time,
+                                                    tres->elapsed_time);
+        result->latency.typical          += tres->latency.typical / nti;
+        result->latency.moment_average   += tres->latency.moment_average / nti;
+        result->latency.total_average    += tres->latency.total_average / nti;
+        result->bandwidth.moment_average += tres->bandwidth.moment_average;
+        result->bandwidth.total_average  += tres->bandwidth.total_average;
+        result->msgrate.moment_average   += tres->msgrate.moment_average;
+        result->msgrate.total_average    += tres->msgrate.total_average;
+    }
+
+    /* Thread results are already calculated, so merge into the master */
+    for (ti = 1; ti < nti; ti++) {
+        ucx_perf_hist_merge(perf, &tctx[ti].perf);
+    }
+    time_unit = ucs_time_from_sec(1.0) *
+                ((perf->params.test_type == UCX_PERF_TEST_TYPE_PINGPONG) ? 2.0 : 1.0);
+    ucx_perf_calc_percentiles(perf, result, time_unit);
+
+    threads->count   = nti;
+    threads->results = results;
+    ucx_perf_calc_spread(tctx, nti,
+                         ucs_offsetof(ucx_perf_result_t, latency.total_average),
+                         &threads->latency);
+    ucx_perf_calc_spread(tctx, nti,
+                         ucs_offsetof(ucx_perf_result_t, bandwidth.total_average),
+                         &threads->bandwidth);
+    ucx_perf_calc_spread(tctx, nti,
+                         ucs_offsetof(ucx_perf_result_t, msgrate.total_average),
+                         &threads->msgrate);
+}
+
 static int ucx_perf_thread_spawn(ucx_perf_params_t* params,
                                  ucx_perf_result_t* result) {
-    ucx_perf_context_t perf;
-    ucs_status_t status = UCS_OK;
-    size_t message_size;
+    ucx_perf_thread_context_t* tctx;
+    ucx_perf_thread_results_t threads;
+    ucx_perf_result_t* results;
+    ucs_status_t* statuses;
+    ucs_status_t status;
     int ti, nti;
 
-    message_size = ucx_perf_get_message_size(params);
-    omp_set_num_threads(params->thread_count);
+    status = ucx_perf_thread_check_params(params);
+    if (UCS_OK != status) {
+        return status;
+    }
+
     nti = params->thread_count;
+    omp_set_num_threads(nti);
 
-    ucx_perf_thread_context_t* tctx =
-        calloc(nti, sizeof(ucx_perf_thread_context_t));
-    ucs_status_t* statuses =
-        calloc(nti, sizeof(ucs_status_t));
+    tctx     = calloc(nti, sizeof(ucx_perf_thread_context_t));
+    statuses = calloc(nti, sizeof(ucs_status_t));
+    results  = calloc(nti, sizeof(ucx_perf_result_t));
+    if ((tctx == NULL) || (statuses == NULL) || (results == NULL)) {
+        status = UCS_ERR_NO_MEMORY;
+        goto out_free;
+    }
 
-    ucx_perf_test_reset(&perf, params);
-    status = ucx_perf_funcs[params->api].setup(&perf, params);
+    for (ti = 0; ti < nti; ti++) {
+        tctx[ti].tid      = ti;
+        tctx[ti].ntid     = nti;
+        tctx[ti].statuses = statuses;
+        tctx[ti].params   = *params;
+    }
+
+    /* Set up the threads one by one, so the peers exchange addresses of the
+     * same thread */
+    ucx_perf_test_reset(&tctx[0].perf, params);
+    status = ucx_perf_funcs[params->api].setup(&tctx[0].perf, params);
     if (UCS_OK != status) {
-        goto out_cleanup;
+        goto out_free;
+    }
+
+    for (ti = 1; ti < nti; ti++) {
+        status = ucx_perf_thread_setup(&tctx[ti], &tctx[0].perf);
+        if (UCS_OK != status) {
+            goto out_cleanup;
+        }
     }
 
 #pragma omp parallel private(ti)
 {
     ti = omp_get_thread_num();
-    tctx[ti].tid = ti;
-    tctx[ti].ntid = nti;
-    tctx[ti].statuses = statuses;
-    tctx[ti].params = *params;
-    tctx[ti].perf = perf;
-    /* Doctor the src and dst buffers to make them thread specific */
-    tctx[ti].perf.send_buffer += ti * message_size;
-    tctx[ti].perf.recv_buffer += ti * message_size;
-    tctx[ti].perf.offset = ti * message_size;
     ucx_perf_thread_run_test((void*)&tctx[ti]);
 }
     for (ti = 0; ti < nti; ti++) {
@@ -1390,12 +1804,24 @@ static int ucx_perf_thread_spawn(ucx_perf_params_t* params,
         }
     }
 
-    ucx_perf_funcs[params->api].cleanup(&perf);
+    if (UCS_OK == status) {
+        ucx_perf_calc_thread_results(tctx, nti, result, results, &threads);
+        rte_call(&tctx[0].perf, report, result, params->report_arg, 1);
+        if (params->rte->report_threads != NULL) {
+            params->rte->report_threads(params->rte_group, &threads,
+                                        params->report_arg);
+        }
+    }
 
 out_cleanup:
+    while (--ti > 0) {
+        ucx_perf_thread_cleanup(&tctx[ti]);
+    }
+    ucx_perf_funcs[params->api].cleanup(&tctx[0].perf);
+out_free:
+    free(results);
     free(statuses);
     free(tctx);
-
     return status;
 }
 #else
@@ -44,6 +44,7 @@ typedef enum {
     UCX_PERF_TEST_TYPE_PINGPONG,         /* Ping-pong mode */
     UCX_PERF_TEST_TYPE_STREAM_UNI,       /* Unidirectional stream */
     UCX_PERF_TEST_TYPE_STREAM_BI,        /* Bidirectional stream */
+    UCX_PERF_TEST_TYPE_MANY2ONE,         /* All peers stream to the first one */
     UCX_PERF_TEST_TYPE_LAST
 } ucx_perf_test_type_t;
 
@@ -70,6 +71,15 @@ typedef enum {
 } ucx_perf_wait_mode_t;
 
 
+typedef enum {
+    UCX_PERF_THREAD_MODEL_SHARED,    /* All threads share the worker and endpoints */
+    UCX_PERF_THREAD_MODEL_WORKER,    /* Every thread has its own worker and endpoints */
+    UCX_PERF_THREAD_MODEL_EP,        /* Threads share the worker, every thread has
+                                        its own endpoints */
+    UCX_PERF_THREAD_MODEL_LAST
+} ucx_perf_thread_model_t;
+
+
 enum ucx_perf_test_flags {
     UCX_PERF_TEST_FLAG_VALIDATE     = UCS_BIT(1), /* Validate data. Affects performance. */
     UCX_PERF_TEST_FLAG_ONE_SIDED    = UCS_BIT(2), /* For test which involve only one side,
@@ -79,7 +89,9 @@ enum ucx_perf_test_flags {
 };
 
 enum {
-    UCT_PERF_TEST_MAX_FC_WINDOW   = 127         /* Maximal flow-control window */
+    UCT_PERF_TEST_MAX_FC_WINDOW   = 127,        /* Maximal flow-control window */
+    UCX_PERF_MAX_PERCENTILES      = 8           /* Maximal number of reported latency
+                                                   percentiles */
 };
 
 /**
@@ -104,9 +116,36 @@ typedef struct ucx_perf_result {
         double              total_average;  /* Average of the whole test */
     }
     latency, bandwidth, msgrate;
+    unsigned                percentiles_cnt;
+    struct {
+        double              rank;           /* Percentile, 0..100 */
+        double              latency;        /* Latency at this percentile */
+    } percentiles[UCX_PERF_MAX_PERCENTILES];
 } ucx_perf_result_t;
 
 
+/*
+ * Distribution of a result value across the threads of a test.
+ */
+typedef struct ucx_perf_spread {
+    double                  min;
+    double                  max;
+    double                  stddev;
+} ucx_perf_spread_t;
+
+
+/*
+ * Per-thread results of a multi-threaded test.
+ */
+typedef struct ucx_perf_thread_results {
+    unsigned                count;          /* Number of threads */
+    const ucx_perf_result_t *results;       /* Result of every thread */
+    ucx_perf_spread_t       latency;        /* Spread of the total averages */
+    ucx_perf_spread_t       bandwidth;
+    ucx_perf_spread_t       msgrate;
+} ucx_perf_thread_results_t;
+
+
 /**
  * RTE used to bring-up the test
  */
@@ -131,6 +170,11 @@ typedef struct ucx_perf_rte {
     void        (*report)(void *rte_group, const ucx_perf_result_t *result,
                           void *arg, int is_final);
 
+    /* Handle per-thread results of a multi-threaded test, may be NULL */
+    void        (*report_threads)(void *rte_group,
+                                  const ucx_perf_thread_results_t *threads,
+                                  void *arg);
+
 } ucx_perf_rte_t;
 
 
@@ -143,6 +187,11 @@ typedef struct ucx_perf_params {
     ucx_perf_test_type_t   test_type;       /* Test communication type */
     ucs_thread_mode_t      thread_mode;     /* Thread mode for communication objects */
     unsigned               thread_count;    /* Number of threads in the test program */
+    ucx_perf_thread_model_t thread_model;   /* What the threads share */
+    const unsigned         *thread_cpus;    /* CPUs to bind the threads to, NULL - don't
+                                               bind. The size of the array is in
+                                               thread_cpus_cnt */
+    unsigned               thread_cpus_cnt; /* Number of CPUs in thread_cpus */
     ucs_async_mode_t       async_mode;      /* how async progress and locking is done */
     ucx_perf_wait_mode_t   wait_mode;       /* How to wait */
     unsigned               flags;           /* See ucx_perf_test_flags. */
@@ -161,6 +210,9 @@ typedef struct ucx_perf_params {
     ucx_perf_counter_t     max_iter;        /* Iterations limit, 0 - unlimited */
     double                 max_time;        /* Time limit (seconds), 0 - unlimited */
     double                 report_interval; /* Interval at which to call the report callback */
+    double                 percentiles[UCX_PERF_MAX_PERCENTILES]; /* Latency percentiles
+                                               to report, 0..100 */
+    unsigned               percentiles_cnt; /* Number of entries in percentiles */
 
     void                   *rte_group;      /* Opaque RTE group handle */
     ucx_perf_rte_t         *rte;            /* RTE functions used to exchange data */
@@ -188,6 +240,19 @@ typedef struct ucx_perf_params {
 ucs_status_t ucx_perf_run(ucx_perf_params_t *params, ucx_perf_result_t *result);
 
 
+/**
+ * Parse a comma-separated list of CPU numbers, such as "0,2,4", to be used as
+ * the thread_cpus parameter.
+ *
+ * @param [in]  str       List to parse.
+ * @param [out] cpus      Filled with the CPU numbers.
+ * @param [in]  max_cpus  Size of the cpus array.
+ * @param [out] cpus_cnt  Filled with the number of CPUs in the list.
+ */
+ucs_status_t ucx_perf_parse_cpu_list(const char *str, unsigned *cpus,
+                                     unsigned max_cpus, unsigned *cpus_cnt);
+
+
 END_C_DECLS
 
 #endif /* UCX_PERF_H_ */
@@ -15,11 +15,23 @@ BEGIN_C_DECLS
 
 #include <ucs/time/time.h>
 #include <ucs/async/async.h>
+#include <ucs/arch/bitops.h>
 
 
 #define TIMING_QUEUE_SIZE    2048
 #define UCT_PERF_TEST_AM_ID  5
 
+/*
+ * Latency histogram with logarithmic buckets: every power of 2 is split into
+ * UCX_PERF_HIST_SUB_COUNT linear sub-buckets, so a value is recorded with a
+ * relative error of at most 1/UCX_PERF_HIST_SUB_COUNT over the whole range
+ * of ucs_time_t.
+ */
+#define UCX_PERF_HIST_SUB_BITS   5
+#define UCX_PERF_HIST_SUB_COUNT  UCS_BIT(UCX_PERF_HIST_SUB_BITS)
+#define UCX_PERF_HIST_SIZE       ((64 - UCX_PERF_HIST_SUB_BITS + 1) * \
+                                  UCX_PERF_HIST_SUB_COUNT)
+
 
 typedef struct ucx_perf_context  ucx_perf_context_t;
 typedef struct uct_peer          uct_peer_t;
@@ -49,6 +61,7 @@ struct ucx_perf_context {
 
     ucs_time_t                   timing_queue[TIMING_QUEUE_SIZE];
     unsigned                     timing_queue_head;
+    ucx_perf_counter_t           latency_hist[UCX_PERF_HIST_SIZE];
 
     union {
         struct {
@@ -111,6 +124,20 @@ ucs_status_t ucp_perf_test_dispatch(ucx_perf_context_t *perf);
 void ucx_perf_calc_result(ucx_perf_context_t *perf, ucx_perf_result_t *result);
 
 
+/* Middle of the range of values counted by a histogram bucket */
+double ucx_perf_hist_value(unsigned index);
+
+
+/* Add the latency histogram of another context, e.g of a thread, to perf */
+void ucx_perf_hist_merge(ucx_perf_context_t *perf,
+                         const ucx_perf_context_t *other);
+
+
+/* Fill the latency percentiles of the result from the histogram of perf */
+void ucx_perf_calc_percentiles(ucx_perf_context_t *perf,
+                               ucx_perf_result_t *result, double time_unit);
+
+
 static UCS_F_ALWAYS_INLINE int ucx_perf_context_done(ucx_perf_context_t *perf)
 {
     return ucs_unlikely((perf->current.iters >= perf->max_iter) ||
@@ -118,6 +145,20 @@ static UCS_F_ALWAYS_INLINE int ucx_perf_context_done(ucx_perf_context_t *perf)
 }
 
 
+static UCS_F_ALWAYS_INLINE unsigned ucx_perf_hist_index(ucs_time_t value)
+{
+    unsigned shift;
+
+    if (value < UCX_PERF_HIST_SUB_COUNT) {
+        return value;
+    }
+
+    shift = ucs_ilog2(value) - UCX_PERF_HIST_SUB_BITS;
+    return ((shift + 1) << UCX_PERF_HIST_SUB_BITS) + (value >> shift) -
+           UCX_PERF_HIST_SUB_COUNT;
+}
+
+
 static inline void ucx_perf_update(ucx_perf_context_t *perf, ucx_perf_counter_t iters,
                                    size_t bytes)
 {
@@ -130,6 +171,7 @@ static inline void ucx_perf_update(ucx_perf_context_t *perf, ucx_perf_counter_t
 
     perf->timing_queue[perf->timing_queue_head++] = perf->current.time - perf->prev_time;
     perf->timing_queue_head %= TIMING_QUEUE_SIZE;
+    ++perf->latency_hist[ucx_perf_hist_index(perf->current.time - perf->prev_time)];
     perf->prev_time = perf->current.time;
 
     if (perf->current.time - perf->prev.time >= perf->report_interval) {
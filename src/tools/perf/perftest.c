@@ -34,6 +34,7 @@
 #endif
 
 #define MAX_BATCH_FILES  32
+#define MAX_CPUS         1024
 
 
 enum {
@@ -42,7 +43,8 @@ enum {
     TEST_FLAG_SET_AFFINITY  = UCS_BIT(8),
     TEST_FLAG_NUMERIC_FMT   = UCS_BIT(9),
     TEST_FLAG_PRINT_FINAL   = UCS_BIT(10),
-    TEST_FLAG_PRINT_CSV     = UCS_BIT(11)
+    TEST_FLAG_PRINT_CSV     = UCS_BIT(11),
+    TEST_FLAG_PRINT_JSON    = UCS_BIT(12)
 };
 
 typedef struct sock_rte_group {
@@ -62,12 +64,14 @@ typedef struct test_type {
 
 struct perftest_context {
     ucx_perf_params_t            params;
+    const ucx_perf_params_t      *test_params; /* Parameters of the running test */
     const char                   *server_addr;
     int                          port;
 #if HAVE_MPI
     int                          mpi;
 #endif
-    unsigned                     cpu;
+    unsigned                     cpus[MAX_CPUS];
+    unsigned                     num_cpus;
     unsigned                     flags;
 
     unsigned                     num_batch_files;
@@ -77,7 +81,7 @@ struct perftest_context {
     sock_rte_group_t             sock_rte_group;
 };
 
-#define TEST_PARAMS_ARGS   "t:n:s:W:O:w:D:i:H:oqM:T:d:x:A:B"
+#define TEST_PARAMS_ARGS   "t:n:s:W:O:w:D:i:H:oqM:T:m:L:d:x:A:B"
 
 
 test_type_t tests[] = {
@@ -111,12 +115,21 @@ test_type_t tests[] = {
     {"add_mr", UCX_PERF_API_UCT, UCX_PERF_CMD_ADD, UCX_PERF_TEST_TYPE_STREAM_UNI,
      "atomic add message rate"},
 
+    {"am_m2o", UCX_PERF_API_UCT, UCX_PERF_CMD_AM, UCX_PERF_TEST_TYPE_MANY2ONE,
+     "active message many-to-one bandwidth / message rate"},
+
     {"tag_lat", UCX_PERF_API_UCP, UCX_PERF_CMD_TAG, UCX_PERF_TEST_TYPE_PINGPONG,
      "UCP tag match latency"},
 
     {"tag_bw", UCX_PERF_API_UCP, UCX_PERF_CMD_TAG, UCX_PERF_TEST_TYPE_STREAM_UNI,
      "UCP tag match bandwidth"},
 
+    {"ucp_am_lat", UCX_PERF_API_UCP, UCX_PERF_CMD_AM, UCX_PERF_TEST_TYPE_PINGPONG,
+     "UCP active message latency"},
+
+    {"ucp_am_bw", UCX_PERF_API_UCP, UCX_PERF_CMD_AM, UCX_PERF_TEST_TYPE_STREAM_UNI,
+     "UCP active message bandwidth"},
+
     {"ucp_put_lat", UCX_PERF_API_UCP, UCX_PERF_CMD_PUT, UCX_PERF_TEST_TYPE_PINGPONG,
      "UCP put latency"},
 
@@ -141,6 +154,19 @@ test_type_t tests[] = {
     {NULL}
 };
 
+static const char *wait_mode_names[] = {
+    [UCX_PERF_WAIT_MODE_PROGRESS] = "progress",
+    [UCX_PERF_WAIT_MODE_SLEEP]    = "sleep",
+    [UCX_PERF_WAIT_MODE_SPIN]     = "spin",
+    [UCX_PERF_WAIT_MODE_LAST]     = "default"
+};
+
+static const char *thread_model_names[] = {
+    [UCX_PERF_THREAD_MODEL_SHARED] = "shared",
+    [UCX_PERF_THREAD_MODEL_WORKER] = "worker",
+    [UCX_PERF_THREAD_MODEL_EP]     = "ep"
+};
+
 static int safe_send(int sock, void *data, size_t size)
 {
     size_t total = 0;
@@ -173,13 +199,152 @@ static int safe_recv(int sock, void *data, size_t size)
     return 0;
 }
 
-static void print_progress(char **test_names, unsigned num_names,
-                           const ucx_perf_result_t *result, unsigned flags,
-                           int final)
+static const test_type_t *find_test(const ucx_perf_params_t *params)
 {
-    static const char *fmt_csv     =  "%.0f,%.3f,%.3f,%.3f,%.2f,%.2f,%.0f,%.0f\n";
-    static const char *fmt_numeric =  "%'14.0f %9.3f %9.3f %9.3f %10.2f %10.2f %'11.0f %'11.0f\n";
-    static const char *fmt_plain   =  "%14.0f %9.3f %9.3f %9.3f %10.2f %10.2f %11.0f %11.0f\n";
+    test_type_t *test;
+
+    for (test = tests; test->name; ++test) {
+        if ((test->api == params->api) && (test->command == params->command) &&
+            (test->test_type == params->test_type)) {
+            return test;
+        }
+    }
+    return NULL;
+}
+
+static const char *data_layout_str(const ucx_perf_params_t *params)
+{
+    if (params->api == UCX_PERF_API_UCP) {
+        return (params->ucp.send_datatype == UCP_PERF_DATATYPE_IOV) ? "iov" :
+                                                                       "contig";
+    }
+
+    switch (params->uct.data_layout) {
+    case UCT_PERF_DATA_LAYOUT_SHORT:
+        return "short";
+    case UCT_PERF_DATA_LAYOUT_BCOPY:
+        return "bcopy";
+    case UCT_PERF_DATA_LAYOUT_ZCOPY:
+        return "zcopy";
+    default:
+        return "(undefined)";
+    }
+}
+
+static void print_csv_params(const ucx_perf_params_t *params)
+{
+    const test_type_t *test = find_test(params);
+
+    printf("%s,%s,%s,%s,%zu,%u,%u,%s,%u,%s,",
+           (test != NULL) ? test->name : "", params->uct.tl_name,
+           params->uct.dev_name, data_layout_str(params),
+           ucx_perf_get_message_size(params), params->max_outstanding,
+           params->uct.fc_window, wait_mode_names[params->wait_mode],
+           params->thread_count, thread_model_names[params->thread_model]);
+}
+
+/*
+ * Print a JSON string value, escaping the characters which may not appear in
+ * it as is.
+ */
+static void print_json_string(const char *str)
+{
+    putchar('"');
+    for (; *str != '\0'; ++str) {
+        if ((*str == '"') || (*str == '\\')) {
+            printf("\\%c", *str);
+        } else if ((unsigned char)*str < ' ') {
+            printf("\\u%04x", (unsigned char)*str);
+        } else {
+            putchar(*str);
+        }
+    }
+    putchar('"');
+}
+
+/*
+ * Print the final result of a test as a single-line JSON object, which
+ * includes all parameters of the test.
+ */
+static void print_json(struct perftest_context *ctx,
+                       const ucx_perf_result_t *result)
+{
+    const ucx_perf_params_t *params = ctx->test_params;
+    const test_type_t *test         = find_test(params);
+    unsigned i;
+
+    printf("{");
+    if (ctx->num_batch_files > 0) {
+        printf("\"batch\":[");
+        for (i = 0; i < ctx->num_batch_files; ++i) {
+            printf("%s", (i == 0) ? "" : ",");
+            print_json_string(ctx->test_names[i]);
+        }
+        printf("],");
+    }
+
+    printf("\"test\":");
+    print_json_string((test != NULL) ? test->name : "");
+    printf(",\"transport\":");
+    print_json_string(params->uct.tl_name);
+    printf(",\"device\":");
+    print_json_string(params->uct.dev_name);
+
+    printf(",\"data_layout\":\"%s\",\"msg_size\":%zu,\"outstanding\":%u,"
+           "\"fc_window\":%u,\"wait_mode\":\"%s\",\"threads\":%u,"
+           "\"thread_model\":\"%s\",\"warmup_iters\":%lu,",
+           data_layout_str(params),
+           ucx_perf_get_message_size(params), params->max_outstanding,
+           params->uct.fc_window, wait_mode_names[params->wait_mode],
+           params->thread_count, thread_model_names[params->thread_model],
+           (unsigned long)params->warmup_iter);
+
+    printf("\"iterations\":%lu,\"bytes\":%lu,\"elapsed_sec\":%.6f,",
+           (unsigned long)result->iters, (unsigned long)result->bytes,
+           ucs_time_to_sec((ucs_time_t)result->elapsed_time));
+
+    printf("\"latency_usec\":{\"typical\":%.3f,\"average\":%.3f,"
+           "\"overall\":%.3f,\"percentiles\":{",
+           result->latency.typical * 1000000.0,
+           result->latency.moment_average * 1000000.0,
+           result->latency.total_average * 1000000.0);
+    for (i = 0; i < result->percentiles_cnt; ++i) {
+        printf("%s\"%g\":%.3f", (i == 0) ? "" : ",",
+               result->percentiles[i].rank,
+               result->percentiles[i].latency * 1000000.0);
+    }
+
+    printf("}},\"bandwidth_mbs\":{\"average\":%.2f,\"overall\":%.2f},"
+           "\"msgrate\":{\"average\":%.0f,\"overall\":%.0f}}\n",
+           result->bandwidth.moment_average / (1024.0 * 1024.0),
+           result->bandwidth.total_average / (1024.0 * 1024.0),
+           result->msgrate.moment_average,
+           result->msgrate.total_average);
+}
+
+static void print_percentiles(const ucx_perf_result_t *result)
+{
+    char buf[128];
+    unsigned i, pos;
+
+    buf[0] = '\0';
+    pos    = 0;
+    for (i = 0; (i < result->percentiles_cnt) && (pos < sizeof(buf)); ++i) {
+        pos += snprintf(buf + pos, sizeof(buf) - pos, " %g%%: %.3f",
+                        result->percentiles[i].rank,
+                        result->percentiles[i].latency * 1000000.0);
+    }
+
+    printf("| percentiles (usec):%-69.69s |\n", buf);
+}
+
+static void print_progress(struct perftest_context *ctx,
+                           const ucx_perf_result_t *result, int final)
+{
+    static const char *fmt_csv     =  "%.0f,%.3f,%.3f,%.3f,%.2f,%.2f,%.0f,%.0f";
+    static const char *fmt_numeric =  "%'14.0f %9.3f %9.3f %9.3f %10.2f %10.2f %'11.0f %'11.0f";
+    static const char *fmt_plain   =  "%14.0f %9.3f %9.3f %9.3f %10.2f %10.2f %11.0f %11.0f";
+    unsigned flags = ctx->flags;
     unsigned i;
 
     if (!(flags & TEST_FLAG_PRINT_RESULTS) ||
@@ -188,10 +353,19 @@ static void print_progress(char **test_names, unsigned num_names,
         return;
     }
 
+    if (flags & TEST_FLAG_PRINT_JSON) {
+        if (final) {
+            print_json(ctx, result);
+            fflush(stdout);
+        }
+        return;
+    }
+
     if (flags & TEST_FLAG_PRINT_CSV) {
-        for (i = 0; i < num_names; ++i) {
-            printf("%s,", test_names[i]);
+        for (i = 0; i < ctx->num_batch_files; ++i) {
+            printf("%s,", ctx->test_names[i]);
         }
+        print_csv_params(ctx->test_params);
     }
 
     printf((flags & TEST_FLAG_PRINT_CSV)   ? fmt_csv :
@@ -205,6 +379,55 @@ static void print_progress(char **test_names, unsigned num_names,
            result->bandwidth.total_average / (1024.0 * 1024.0),
            result->msgrate.moment_average,
            result->msgrate.total_average);
+
+    if (flags & TEST_FLAG_PRINT_CSV) {
+        for (i = 0; i < result->percentiles_cnt; ++i) {
+            printf(",%.3f", result->percentiles[i].latency * 1000000.0);
+        }
+        printf("\n");
+    } else {
+        printf("\n");
+        if (final && (result->percentiles_cnt > 0)) {
+            print_percentiles(result);
+        }
+    }
+    fflush(stdout);
+}
+
+static void print_thread_results(const ucx_perf_thread_results_t *threads,
+                                 unsigned flags)
+{
+    static const char *fmt_thread = "| %6u | %12.0f | %14.3f | %16.2f | %20.0f |\n";
+    static const char *fmt_spread = "| %-6s |              | %14.3f | %16.2f | %20.0f |\n";
+    static const char *separator  = "+--------+--------------+----------------+------------------+----------------------+\n";
+    const ucx_perf_result_t *result;
+    unsigned i;
+
+    /* The CSV and JSON outputs have one record per test, so they show only
+     * the total */
+    if (!(flags & TEST_FLAG_PRINT_RESULTS) ||
+        (flags & (TEST_FLAG_PRINT_CSV | TEST_FLAG_PRINT_JSON))) {
+        return;
+    }
+
+    printf("%s", separator);
+    printf("| thread | # iterations | overall (usec) | overall (MB/s)   | overall (msg/s)      |\n");
+    printf("%s", separator);
+    for (i = 0; i < threads->count; ++i) {
+        result = &threads->results[i];
+        printf(fmt_thread, i, (double)result->iters,
+               result->latency.total_average * 1000000.0,
+               result->bandwidth.total_average / (1024.0 * 1024.0),
+               result->msgrate.total_average);
+    }
+    printf("%s", separator);
+    printf(fmt_spread, "min", threads->latency.min * 1000000.0,
+           threads->bandwidth.min / (1024.0 * 1024.0), threads->msgrate.min);
+    printf(fmt_spread, "max", threads->latency.max * 1000000.0,
+           threads->bandwidth.max / (1024.0 * 1024.0), threads->msgrate.max);
+    printf(fmt_spread, "stddev", threads->latency.stddev * 1000000.0,
+           threads->bandwidth.stddev / (1024.0 * 1024.0), threads->msgrate.stddev);
+    printf("%s", separator);
     fflush(stdout);
 }
 
@@ -253,12 +476,23 @@ static void print_header(struct perftest_context *ctx)
         }
     }
 
+    if (ctx->flags & TEST_FLAG_PRINT_JSON) {
+        /* Every result is a self-contained object */
+        return;
+    }
+
     if (ctx->flags & TEST_FLAG_PRINT_CSV) {
         if (ctx->flags & TEST_FLAG_PRINT_RESULTS) {
             for (i = 0; i < ctx->num_batch_files; ++i) {
                 printf("%s,", basename(ctx->batch_files[i]));
             }
-            printf("iterations,typical_lat,avg_lat,overall_lat,avg_bw,overall_bw,avg_mr,overall_mr\n");
+            printf("test,transport,device,data_layout,msg_size,outstanding,"
+                   "fc_window,wait_mode,threads,thread_model,");
+            printf("iterations,typical_lat,avg_lat,overall_lat,avg_bw,overall_bw,avg_mr,overall_mr");
+            for (i = 0; i < ctx->params.percentiles_cnt; ++i) {
+                printf(",lat_p%g", ctx->params.percentiles[i]);
+            }
+            printf("\n");
         }
     } else {
         if (ctx->flags & TEST_FLAG_PRINT_RESULTS) {
@@ -278,7 +512,8 @@ static void print_test_name(struct perftest_context *ctx)
     char buf[200];
     unsigned i, pos;
 
-    if (!(ctx->flags & TEST_FLAG_PRINT_CSV) && (ctx->num_batch_files > 0)) {
+    if (!(ctx->flags & (TEST_FLAG_PRINT_CSV | TEST_FLAG_PRINT_JSON)) &&
+        (ctx->num_batch_files > 0)) {
         strcpy(buf, "+--------------+---------+---------+---------+----------+----------+-----------+-----------+");
 
         pos = 1;
@@ -300,6 +535,7 @@ static void print_test_name(struct perftest_context *ctx)
 static void usage(struct perftest_context *ctx, const char *program)
 {
     test_type_t *test;
+    unsigned i;
 
     printf("Usage: %s [ server-hostname ] [ options ]\n", program);
     printf("\n");
@@ -328,7 +564,8 @@ static void usage(struct perftest_context *ctx, const char *program)
     printf("\n");
     printf("     -d <device>    Device to use for testing.\n");
     printf("     -x <tl>        Transport to use for testing.\n");
-    printf("     -c <cpu>       Set affinity to this CPU. (off)\n");
+    printf("     -c <cpu>[,<cpu>...]  Set affinity to these CPUs. With \"-T\", bind every\n");
+    printf("                    thread to the next CPU of the list. (off)\n");
     printf("     -n <iters>     Number of iterations to run. (%ld)\n",
                                 ctx->params.max_iter);
     printf("     -s <size>      List of buffer sizes separated by comma, which "
@@ -344,9 +581,20 @@ static void usage(struct perftest_context *ctx, const char *program)
                                 ctx->params.max_outstanding);
     printf("     -i <count>     Distance between starting address of consecutive "
                                 "IOV entries. The same as UCT uct_iov_t stride.\n");
+    printf("     -L <pct>[,<pct>...]  Latency percentiles to report, up to %d. (",
+                                UCX_PERF_MAX_PERCENTILES);
+    for (i = 0; i < ctx->params.percentiles_cnt; ++i) {
+        printf("%s%g", (i == 0) ? "" : ",", ctx->params.percentiles[i]);
+    }
+    printf(")\n");
     printf("     -N             Use numeric formatting - thousands separator.\n");
-    printf("     -f             Print only final numbers.\n");
-    printf("     -v             Print CSV-formatted output.\n");
+    printf("     -f <format>    Output format. (plain)\n");
+    printf("                        plain      : Human-readable table.\n");
+    printf("                        csv        : Final numbers and test parameters in CSV.\n");
+    printf("                        json       : Final numbers and test parameters, a JSON\n");
+    printf("                                     object per line.\n");
+    printf("     -F             Print only final numbers.\n");
+    printf("     -v             Print CSV-formatted output, including intermediate numbers.\n");
     printf("     -p <port>      TCP port to use for data exchange. (%d)\n", ctx->port);
     printf("     -b <batchfile> Batch mode. Read and execute tests from a file.\n");
     printf("                       Every line of the file is a test to run. "
@@ -358,7 +606,12 @@ static void usage(struct perftest_context *ctx, const char *program)
     printf("                        serialized : One thread can access at a time.\n");
     printf("                        multi      : Multiple threads can access.\n");
     printf("     -T <threads>   Number of threads in the test (1); "
-                                "also implies \"-M multi\".\n");
+                                "implies \"-M multi\" unless\n");
+    printf("                    \"-m worker\" is used.\n");
+    printf("     -m <model>     What the threads of \"-T\" share. (shared)\n");
+    printf("                        shared     : The worker and the endpoints.\n");
+    printf("                        worker     : Nothing, every thread has its own worker.\n");
+    printf("                        ep         : The worker, every thread has its own endpoints (UCT only).\n");
     printf("     -A <mode>      Async progress mode. (thread)\n");
     printf("                        thread     : Use separate progress thread.\n");
     printf("                        signal     : Use signal based timer.\n"); 
@@ -439,13 +692,46 @@ static ucs_status_t parse_message_sizes_params(const char *optarg,
     return UCS_OK;
 }
 
+static ucs_status_t parse_percentiles(const char *optarg,
+                                      ucx_perf_params_t *params)
+{
+    const char *p = optarg;
+    unsigned count;
+    char *endptr;
+
+    count = 0;
+    do {
+        if (count >= UCX_PERF_MAX_PERCENTILES) {
+            ucs_error("Too many percentiles for -L (max: %d)",
+                      UCX_PERF_MAX_PERCENTILES);
+            return UCS_ERR_INVALID_PARAM;
+        }
+
+        params->percentiles[count] = strtod(p, &endptr);
+        if ((endptr == p) || ((*endptr != ',') && (*endptr != '\0')) ||
+            (params->percentiles[count] < 0.0) ||
+            (params->percentiles[count] > 100.0)) {
+            ucs_error("Invalid option argument for -L");
+            return UCS_ERR_INVALID_PARAM;
+        }
+        ++count;
+        p = endptr + 1;
+    } while (*endptr == ',');
+
+    params->percentiles_cnt = count;
+    return UCS_OK;
+}
+
 static void init_test_params(ucx_perf_params_t *params)
 {
     params->api             = UCX_PERF_API_LAST;
     params->command         = UCX_PERF_CMD_LAST;
     params->test_type       = UCX_PERF_TEST_TYPE_LAST;
-    params->thread_mode     = UCS_THREAD_MODE_SINGLE;
+    params->thread_mode     = UCS_THREAD_MODE_LAST; /* Set by -M or by -T */
     params->thread_count    = 1;
+    params->thread_model    = UCX_PERF_THREAD_MODEL_SHARED;
+    params->thread_cpus     = NULL;
+    params->thread_cpus_cnt = 0;
     params->async_mode      = UCS_ASYNC_MODE_THREAD;
     params->wait_mode       = UCX_PERF_WAIT_MODE_LAST;
     params->max_outstanding = 1;
@@ -455,6 +741,10 @@ static void init_test_params(ucx_perf_params_t *params)
     params->max_iter        = 1000000l;
     params->max_time        = 0.0;
     params->report_interval = 1.0;
+    params->percentiles[0]  = 50.0;
+    params->percentiles[1]  = 99.0;
+    params->percentiles[2]  = 99.9;
+    params->percentiles_cnt = 3;
     params->flags           = UCX_PERF_TEST_FLAG_VERBOSE;
     params->uct.fc_window   = UCT_PERF_TEST_MAX_FC_WINDOW;
     params->uct.data_layout = UCT_PERF_DATA_LAYOUT_SHORT;
@@ -564,8 +854,23 @@ static ucs_status_t parse_test_params(ucx_perf_params_t *params, char opt, const
         }
     case 'T':
         params->thread_count = atoi(optarg);
-        params->thread_mode = UCS_THREAD_MODE_MULTI;
         return UCS_OK;
+    case 'm':
+        if (0 == strcmp(optarg, "shared")) {
+            params->thread_model = UCX_PERF_THREAD_MODEL_SHARED;
+            return UCS_OK;
+        } else if (0 == strcmp(optarg, "worker")) {
+            params->thread_model = UCX_PERF_THREAD_MODEL_WORKER;
+            return UCS_OK;
+        } else if (0 == strcmp(optarg, "ep")) {
+            params->thread_model = UCX_PERF_THREAD_MODEL_EP;
+            return UCS_OK;
+        } else {
+            ucs_error("Invalid option argument for -m");
+            return UCS_ERR_INVALID_PARAM;
+        }
+    case 'L':
+        return parse_percentiles(optarg, params);
     case 'A':
         if (0 == strcmp(optarg, "thread")) {
             params->async_mode = UCS_ASYNC_MODE_THREAD;
@@ -582,6 +887,17 @@ static ucs_status_t parse_test_params(ucx_perf_params_t *params, char opt, const
     }
 }
 
+static void set_thread_mode(ucx_perf_params_t *params)
+{
+    if ((params->thread_count > 1) &&
+        (params->thread_model != UCX_PERF_THREAD_MODEL_WORKER)) {
+        /* Threads share a worker */
+        params->thread_mode = UCS_THREAD_MODE_MULTI;
+    } else if (params->thread_mode == UCS_THREAD_MODE_LAST) {
+        params->thread_mode = UCS_THREAD_MODE_SINGLE;
+    }
+}
+
 static ucs_status_t read_batch_file(FILE *batch_file, ucx_perf_params_t *params,
                                     char** test_name_p)
 {
@@ -623,6 +939,24 @@ static ucs_status_t read_batch_file(FILE *batch_file, ucx_perf_params_t *params,
     return UCS_OK;
 }
 
+static ucs_status_t parse_cpu_list(const char *optarg,
+                                   struct perftest_context *ctx)
+{
+    ucs_status_t status;
+
+    status = ucx_perf_parse_cpu_list(optarg, ctx->cpus, MAX_CPUS,
+                                     &ctx->num_cpus);
+    if (status != UCS_OK) {
+        ucs_error("Invalid option argument for -c");
+        return status;
+    }
+
+    ctx->flags                  |= TEST_FLAG_SET_AFFINITY;
+    ctx->params.thread_cpus      = ctx->cpus;
+    ctx->params.thread_cpus_cnt  = ctx->num_cpus;
+    return UCS_OK;
+}
+
 static ucs_status_t parse_opts(struct perftest_context *ctx, int argc, char **argv)
 {
     ucs_status_t status;
@@ -633,14 +967,16 @@ static ucs_status_t parse_opts(struct perftest_context *ctx, int argc, char **ar
     init_test_params(&ctx->params);
     ctx->server_addr            = NULL;
     ctx->num_batch_files        = 0;
+    ctx->test_params            = &ctx->params;
     ctx->port                   = 13337;
     ctx->flags                  = 0;
+    ctx->num_cpus               = 0;
 #if HAVE_MPI
     ctx->mpi                    = !isatty(0);
 #endif
 
     optind = 1;
-    while ((c = getopt (argc, argv, "p:b:Nfvc:P:h" TEST_PARAMS_ARGS)) != -1) {
+    while ((c = getopt (argc, argv, "p:b:Nf:Fvc:P:h" TEST_PARAMS_ARGS)) != -1) {
         switch (c) {
         case 'p':
             ctx->port = atoi(optarg);
@@ -654,14 +990,32 @@ static ucs_status_t parse_opts(struct perftest_context *ctx, int argc, char **ar
             ctx->flags |= TEST_FLAG_NUMERIC_FMT;
             break;
         case 'f':
+            if (0 == strcmp(optarg, "plain")) {
+                ctx->flags &= ~(TEST_FLAG_PRINT_CSV | TEST_FLAG_PRINT_JSON);
+            } else if (0 == strcmp(optarg, "csv")) {
+                ctx->flags |= TEST_FLAG_PRINT_CSV | TEST_FLAG_PRINT_FINAL;
+                ctx->flags &= ~TEST_FLAG_PRINT_JSON;
+            } else if (0 == strcmp(optarg, "json")) {
+                ctx->flags |= TEST_FLAG_PRINT_JSON | TEST_FLAG_PRINT_FINAL;
+                ctx->flags &= ~TEST_FLAG_PRINT_CSV;
+            } else {
+                ucs_error("Invalid option argument for -f");
+                usage(ctx, __basename(argv[0]));
+                return UCS_ERR_INVALID_PARAM;
+            }
+            break;
+        case 'F':
             ctx->flags |= TEST_FLAG_PRINT_FINAL;
             break;
         case 'v':
             ctx->flags |= TEST_FLAG_PRINT_CSV;
             break;
         case 'c':
-            ctx->flags |= TEST_FLAG_SET_AFFINITY;
-            ctx->cpu = atoi(optarg);
+            status = parse_cpu_list(optarg, ctx);
+            if (status != UCS_OK) {
+                usage(ctx, __basename(argv[0]));
+                return status;
+            }
             break;
         case 'P':
 #if HAVE_MPI
@@ -701,6 +1055,7 @@ static unsigned sock_rte_group_index(void *rte_group)
 
 static void sock_rte_barrier(void *rte_group)
 {
+#pragma omp barrier
 #pragma omp master
   {
     sock_rte_group_t *group = rte_group;
@@ -758,8 +1113,15 @@ static void sock_rte_report(void *rte_group, const ucx_perf_result_t *result,
                             void *arg, int is_final)
 {
     struct perftest_context *ctx = arg;
-    print_progress(ctx->test_names, ctx->num_batch_files, result, ctx->flags,
-                   is_final);
+    print_progress(ctx, result, is_final);
+}
+
+static void sock_rte_report_threads(void *rte_group,
+                                    const ucx_perf_thread_results_t *threads,
+                                    void *arg)
+{
+    struct perftest_context *ctx = arg;
+    print_thread_results(threads, ctx->flags);
 }
 
 static ucx_perf_rte_t sock_rte = {
@@ -770,6 +1132,7 @@ static ucx_perf_rte_t sock_rte = {
     .recv          = sock_rte_recv,
     .exchange_vec  = (void*)ucs_empty_function,
     .report        = sock_rte_report,
+    .report_threads = sock_rte_report_threads,
 };
 
 static ucs_status_t setup_sock_rte(struct perftest_context *ctx)
@@ -838,6 +1201,15 @@ static ucs_status_t setup_sock_rte(struct perftest_context *ctx)
                       sizeof(*ctx->params.msg_size_list) * ctx->params.msg_size_cnt);
         }
 
+        /* Thread binding is a local option, the pointer is not valid here */
+        if (ctx->flags & TEST_FLAG_SET_AFFINITY) {
+            ctx->params.thread_cpus     = ctx->cpus;
+            ctx->params.thread_cpus_cnt = ctx->num_cpus;
+        } else {
+            ctx->params.thread_cpus     = NULL;
+            ctx->params.thread_cpus_cnt = 0;
+        }
+
         ctx->sock_rte_group.connfd    = connfd;
         ctx->sock_rte_group.is_server = 1;
     } else {
@@ -915,6 +1287,7 @@ static unsigned mpi_rte_group_index(void *rte_group)
 
 static void mpi_rte_barrier(void *rte_group)
 {
+#pragma omp barrier
 #pragma omp master
     MPI_Barrier(MPI_COMM_WORLD);
 #pragma omp barrier
@@ -972,8 +1345,15 @@ static void mpi_rte_report(void *rte_group, const ucx_perf_result_t *result,
                            void *arg, int is_final)
 {
     struct perftest_context *ctx = arg;
-    print_progress(ctx->test_names, ctx->num_batch_files, result, ctx->flags,
-                   is_final);
+    print_progress(ctx, result, is_final);
+}
+
+static void mpi_rte_report_threads(void *rte_group,
+                                   const ucx_perf_thread_results_t *threads,
+                                   void *arg)
+{
+    struct perftest_context *ctx = arg;
+    print_thread_results(threads, ctx->flags);
 }
 
 static ucx_perf_rte_t mpi_rte = {
@@ -984,6 +1364,7 @@ static ucx_perf_rte_t mpi_rte = {
     .recv          = mpi_rte_recv,
     .exchange_vec  = (void*)ucs_empty_function,
     .report        = mpi_rte_report,
+    .report_threads = mpi_rte_report_threads,
 };
 #elif HAVE_RTE
 static unsigned ext_rte_group_size(void *rte_group)
@@ -1000,6 +1381,7 @@ static unsigned ext_rte_group_index(void *rte_group)
 
 static void ext_rte_barrier(void *rte_group)
 {
+#pragma omp barrier
 #pragma omp master
   {
     rte_group_t group = (rte_group_t)rte_group;
@@ -1090,8 +1472,15 @@ static void ext_rte_report(void *rte_group, const ucx_perf_result_t *result,
                            void *arg, int is_final)
 {
     struct perftest_context *ctx = arg;
-    print_progress(ctx->test_names, ctx->num_batch_files, result, ctx->flags,
-                   is_final);
+    print_progress(ctx, result, is_final);
+}
+
+static void ext_rte_report_threads(void *rte_group,
+                                   const ucx_perf_thread_results_t *threads,
+                                   void *arg)
+{
+    struct perftest_context *ctx = arg;
+    print_thread_results(threads, ctx->flags);
 }
 
 static ucx_perf_rte_t ext_rte = {
@@ -1099,6 +1488,7 @@ static ucx_perf_rte_t ext_rte = {
     .group_index   = ext_rte_group_index,
     .barrier       = ext_rte_barrier,
     .report        = ext_rte_report,
+    .report_threads = ext_rte_report_threads,
     .post_vec      = ext_rte_post_vec,
     .recv          = ext_rte_recv,
     .exchange_vec  = ext_rte_exchange_vec,
@@ -1168,11 +1558,13 @@ static ucs_status_t check_system(struct perftest_context *ctx)
 
     memset(&cpuset, 0, sizeof(cpuset));
     if (ctx->flags & TEST_FLAG_SET_AFFINITY) {
-        if (ctx->cpu >= nr_cpus) {
-            ucs_error("cpu (%u) ot of range (0..%u)", ctx->cpu, nr_cpus - 1);
-            return UCS_ERR_INVALID_PARAM;
+        for (i = 0; i < ctx->num_cpus; ++i) {
+            if (ctx->cpus[i] >= nr_cpus) {
+                ucs_error("cpu (%u) ot of range (0..%u)", ctx->cpus[i], nr_cpus - 1);
+                return UCS_ERR_INVALID_PARAM;
+            }
+            CPU_SET(ctx->cpus[i], &cpuset);
         }
-        CPU_SET(ctx->cpu, &cpuset);
 
         ret = sched_setaffinity(0, sizeof(cpuset), &cpuset);
         if (ret) {
@@ -1213,8 +1605,15 @@ static ucs_status_t run_test_recurs(struct perftest_context *ctx,
     ucs_trace_func("depth=%u, num_files=%u", depth, ctx->num_batch_files);
 
     if (depth >= ctx->num_batch_files) {
+        /* Options of all batch files are parsed, select the thread mode */
+        params = *parent_params;
+        set_thread_mode(&params);
+
         print_test_name(ctx);
-        return ucx_perf_run(parent_params, &result);
+        ctx->test_params = &params;
+        status = ucx_perf_run(&params, &result);
+        ctx->test_params = parent_params;
+        return status;
     }
 
     batch_file = fopen(ctx->batch_files[depth], "r");
@@ -19,16 +19,39 @@ template <ucx_perf_cmd_t CMD, ucx_perf_test_type_t TYPE, bool ONESIDED>
 class ucp_perf_test_runner {
 public:
     static const ucp_tag_t TAG = 0x1337a880u;
+    static const uint16_t  AM_ID = 0x13;
 
     typedef uint8_t psn_t;
 
     ucp_perf_test_runner(ucx_perf_context_t &perf) :
         m_perf(perf),
         m_outstanding(0),
-        m_max_outstanding(m_perf.params.max_outstanding)
+        m_max_outstanding(m_perf.params.max_outstanding),
+        m_am_count(0)
 
     {
         ucs_assert_always(m_max_outstanding > 0);
+        if (CMD == UCX_PERF_CMD_AM) {
+            ucp_worker_set_am_handler(m_perf.ucp.worker, AM_ID, am_handler,
+                                      this, 0);
+        }
+    }
+
+    ~ucp_perf_test_runner()
+    {
+        if (CMD == UCX_PERF_CMD_AM) {
+            ucp_worker_set_am_handler(m_perf.ucp.worker, AM_ID, NULL, NULL, 0);
+        }
+    }
+
+    static ucs_status_t am_handler(void *arg, void *data, size_t length,
+                                   unsigned flags)
+    {
+        ucp_perf_test_runner *self = (ucp_perf_test_runner*)arg;
+
+        /* The data is consumed in place, without copying it */
+        ++self->m_am_count;
+        return UCS_OK;
     }
 
     void create_iov_buffer(ucp_dt_iov_t *iov, void *buffer)
@@ -56,7 +79,7 @@ public:
                                               size_t *length, void **buffer_p)
     {
         ucp_datatype_t type = ucp_dt_make_contig(1);
-        if (UCX_PERF_CMD_TAG == CMD) {
+        if ((UCX_PERF_CMD_TAG == CMD) || (UCX_PERF_CMD_AM == CMD)) {
             if (UCP_PERF_DATATYPE_IOV == datatype) {
                 *buffer_p = iov;
                 *length   = m_perf.params.msg_size_cnt;
@@ -117,6 +140,10 @@ public:
             request = ucp_tag_send_nb(ep, buffer, length, datatype, TAG,
                                       (ucp_send_callback_t)ucs_empty_function);
             return wait(request, true);
+        case UCX_PERF_CMD_AM:
+            request = ucp_am_send_nb(ep, AM_ID, buffer, length, datatype,
+                                     (ucp_send_callback_t)ucs_empty_function);
+            return wait(request, true);
         case UCX_PERF_CMD_PUT:
             *((uint8_t*)buffer + length - 1) = sn;
             return ucp_put(ep, buffer, length, remote_addr, rkey);
@@ -171,6 +198,13 @@ public:
             request = ucp_tag_recv_nb(worker, buffer, length, datatype, TAG, 0,
                                       (ucp_tag_recv_callback_t)ucs_empty_function);
             return wait(request, false);
+        case UCX_PERF_CMD_AM:
+            /* Wait for the next message to be consumed by the handler */
+            while (m_am_count == 0) {
+                progress_responder();
+            }
+            --m_am_count;
+            return UCS_OK;
         case UCX_PERF_CMD_PUT:
             switch (TYPE) {
             case UCX_PERF_TEST_TYPE_PINGPONG:
@@ -338,6 +372,7 @@ private:
     ucx_perf_context_t &m_perf;
     unsigned           m_outstanding;
     const unsigned     m_max_outstanding;
+    volatile unsigned  m_am_count;
 };
 
 
@@ -359,6 +394,8 @@ ucs_status_t ucp_perf_test_dispatch(ucx_perf_context_t *perf)
     UCS_PP_FOREACH(TEST_CASE_ALL_OSD, perf,
         (UCX_PERF_CMD_TAG,   UCX_PERF_TEST_TYPE_PINGPONG),
         (UCX_PERF_CMD_TAG,   UCX_PERF_TEST_TYPE_STREAM_UNI),
+        (UCX_PERF_CMD_AM,    UCX_PERF_TEST_TYPE_PINGPONG),
+        (UCX_PERF_CMD_AM,    UCX_PERF_TEST_TYPE_STREAM_UNI),
         (UCX_PERF_CMD_PUT,   UCX_PERF_TEST_TYPE_PINGPONG),
         (UCX_PERF_CMD_PUT,   UCX_PERF_TEST_TYPE_STREAM_UNI),
         (UCX_PERF_CMD_GET,   UCX_PERF_TEST_TYPE_STREAM_UNI),
@@ -24,7 +24,9 @@ public:
     uct_perf_test_runner(ucx_perf_context_t &perf) :
         m_perf(perf),
         m_max_outstanding(m_perf.params.max_outstanding),
-        m_send_b_count(0)
+        m_send_b_count(0),
+        m_m2o_recvd(0),
+        m_m2o_done(0)
 
     {
         ucs_assert_always(m_max_outstanding > 0);
@@ -37,8 +39,13 @@ public:
         status = uct_iface_query(m_perf.uct.iface, &attr);
         ucs_assert_always(status == UCS_OK);
         if (attr.cap.flags & (UCT_IFACE_FLAG_AM_SHORT|UCT_IFACE_FLAG_AM_BCOPY|UCT_IFACE_FLAG_AM_ZCOPY)) {
-            status = uct_iface_set_am_handler(m_perf.uct.iface, UCT_PERF_TEST_AM_ID,
-                                              am_hander, m_perf.recv_buffer, UCT_AM_CB_FLAG_SYNC);
+            if (TYPE == UCX_PERF_TEST_TYPE_MANY2ONE) {
+                status = uct_iface_set_am_handler(m_perf.uct.iface, UCT_PERF_TEST_AM_ID,
+                                                  am_m2o_handler, this, UCT_AM_CB_FLAG_SYNC);
+            } else {
+                status = uct_iface_set_am_handler(m_perf.uct.iface, UCT_PERF_TEST_AM_ID,
+                                                  am_hander, m_perf.recv_buffer, UCT_AM_CB_FLAG_SYNC);
+            }
             ucs_assert_always(status == UCS_OK);
         }
     }
@@ -131,6 +138,19 @@ public:
         return UCS_OK;
     }
 
+    static ucs_status_t am_m2o_handler(void *arg, void *data, size_t length,
+                                       void *desc)
+    {
+        uct_perf_test_runner *self = (uct_perf_test_runner *)arg;
+
+        if (*(psn_t*)data == M2O_SN_DONE) {
+            ++self->m_m2o_done;
+        } else {
+            ++self->m_m2o_recvd;
+        }
+        return UCS_OK;
+    }
+
     static size_t pack_cb(void *dest, void *arg)
     {
         uct_perf_test_runner *self = (uct_perf_test_runner *)arg;
@@ -480,6 +500,74 @@ public:
         return UCS_OK;
     }
 
+    ucs_status_t run_many2one()
+    {
+        ucx_perf_counter_t prev_recvd;
+        unsigned group_size;
+        unsigned my_index;
+        unsigned length;
+        void *buffer;
+        uct_ep_h ep;
+
+        length = ucx_perf_get_message_size(&m_perf.params);
+        ucs_assert(length >= sizeof(psn_t));
+
+        memset(m_perf.send_buffer, 0, length);
+
+        uct_perf_test_prepare_iov_buffer();
+
+        group_size  = rte_call(&m_perf, group_size);
+        my_index    = rte_call(&m_perf, group_index);
+        m_m2o_recvd = 0;
+        m_m2o_done  = 0;
+
+        rte_call(&m_perf, barrier);
+
+        ucx_perf_test_start_clock(&m_perf);
+
+        if (my_index == 0) {
+            /* Receive until every sender reports it has finished. The result
+             * of this side is the aggregate rate of all senders. */
+            prev_recvd = 0;
+            while (m_m2o_done < group_size - 1) {
+                progress_responder();
+                if (m_m2o_recvd != prev_recvd) {
+                    ucx_perf_update(&m_perf, m_m2o_recvd - prev_recvd,
+                                    (m_m2o_recvd - prev_recvd) * length);
+                    prev_recvd = m_m2o_recvd;
+                }
+            }
+        } else {
+            ep     = m_perf.uct.peers[0].ep;
+            buffer = m_perf.send_buffer;
+
+            UCX_PERF_TEST_FOREACH(&m_perf) {
+                while (outstanding() >= m_max_outstanding) {
+                    progress_requestor();
+                }
+                send_b(ep, M2O_SN_DATA, M2O_SN_DATA, buffer, length, 0, 0,
+                       &m_completion);
+                ucx_perf_update(&m_perf, 1, length);
+            }
+
+            /* Send "sentinel" value */
+            while (outstanding() >= m_max_outstanding) {
+                progress_requestor();
+            }
+            *(psn_t*)buffer = M2O_SN_DONE;
+            send_b(ep, M2O_SN_DONE, M2O_SN_DATA, buffer, length, 0, 0,
+                   &m_completion);
+        }
+
+        uct_perf_iface_flush_b(&m_perf);
+        ucs_assert(outstanding() == 0);
+        if (my_index != 0) {
+            ucx_perf_update(&m_perf, 0, 0);
+        }
+
+        return UCS_OK;
+    }
+
     ucs_status_t run()
     {
         bool zcopy = (DATA == UCT_PERF_DATA_LAYOUT_ZCOPY);
@@ -516,6 +604,13 @@ public:
             default:
                 return UCS_ERR_INVALID_PARAM;
             }
+        case UCX_PERF_TEST_TYPE_MANY2ONE:
+            switch (CMD) {
+            case UCX_PERF_CMD_AM:
+                return run_many2one();
+            default:
+                return UCS_ERR_INVALID_PARAM;
+            }
         case UCX_PERF_TEST_TYPE_STREAM_BI:
         default:
             return UCS_ERR_INVALID_PARAM;
@@ -531,7 +626,11 @@ private:
     const unsigned     m_max_outstanding;
     uct_completion_t   m_completion;
     int                m_send_b_count;
+    ucx_perf_counter_t m_m2o_recvd;
+    unsigned           m_m2o_done;
     const static int   N_SEND_B_PER_PROGRESS = 16;
+    const static psn_t M2O_SN_DATA           = 0;
+    const static psn_t M2O_SN_DONE           = 1;
 };
 
 
@@ -564,7 +663,8 @@ ucs_status_t uct_perf_test_dispatch(ucx_perf_context_t *perf)
         (UCX_PERF_CMD_ADD, UCX_PERF_TEST_TYPE_STREAM_UNI),
         (UCX_PERF_CMD_FADD, UCX_PERF_TEST_TYPE_STREAM_UNI),
         (UCX_PERF_CMD_SWAP, UCX_PERF_TEST_TYPE_STREAM_UNI),
-        (UCX_PERF_CMD_CSWAP, UCX_PERF_TEST_TYPE_STREAM_UNI)
+        (UCX_PERF_CMD_CSWAP, UCX_PERF_TEST_TYPE_STREAM_UNI),
+        (UCX_PERF_CMD_AM,  UCX_PERF_TEST_TYPE_MANY2ONE)
         );
 
     ucs_error("Invalid test case");
@@ -49,12 +49,19 @@ typedef struct options {
 } options_t;
 
 
+typedef struct {
+    const ucs_profile_thread_header_t   *header;
+    const ucs_profile_thread_location_t *locations;
+    const ucs_profile_record_t          *records;
+} profile_thread_data_t;
+
+
 typedef struct {
     void                         *mem;
     size_t                       length;
     const ucs_profile_header_t   *header;
     const ucs_profile_location_t *locations;
-    const ucs_profile_record_t   *records;
+    profile_thread_data_t        *threads;
 } profile_data_t;
 
 
@@ -73,7 +80,10 @@ static const char* time_units_str[] = {
 
 static int read_profile_data(const char *file_name, profile_data_t *data)
 {
+    uint32_t num_locations, thread_idx;
+    profile_thread_data_t *thread;
     struct stat stat;
+    const void *ptr;
     int ret, fd;
 
     fd = open(file_name, O_RDONLY);
@@ -100,7 +110,25 @@ static int read_profile_data(const char *file_name, profile_data_t *data)
 
     data->header    = data->mem;
     data->locations = (const void*)(data->header + 1);
-    data->records   = (const void*)(data->locations + data->header->num_locations);
+    num_locations   = data->header->num_locations;
+
+    data->threads   = calloc(data->header->num_threads, sizeof(*data->threads));
+    if ((data->threads == NULL) && (data->header->num_threads > 0)) {
+        fprintf(stderr, "Failed to allocate threads array\n");
+        munmap(data->mem, data->length);
+        ret = -1;
+        goto out_close;
+    }
+
+    /* every thread section is: header, location counters, records */
+    ptr = data->locations + num_locations;
+    for (thread_idx = 0; thread_idx < data->header->num_threads; ++thread_idx) {
+        thread            = &data->threads[thread_idx];
+        thread->header    = ptr;
+        thread->locations = (const void*)(thread->header + 1);
+        thread->records   = (const void*)(thread->locations + num_locations);
+        ptr               = thread->records + thread->header->num_records;
+    }
 
     ret = 0;
 
@@ -112,6 +140,7 @@ out:
 
 static void release_profile_data(profile_data_t *data)
 {
+    free(data->threads);
     munmap(data->mem, data->length);
 }
 
@@ -136,25 +165,45 @@ static int compare_locations(const void *l1, const void *l2)
            0;
 }
 
-static void show_profile_data_accum(profile_data_t *data, options_t *opts)
+/*
+ * Show accumulated times of all threads if thread is NULL, otherwise only of
+ * the given thread.
+ */
+static void show_profile_data_accum(profile_data_t *data, options_t *opts,
+                                    const profile_thread_data_t *thread)
 {
     uint32_t num_locations = data->header->num_locations;
     ucs_profile_location_t *sorted_locations;
     ucs_profile_location_t *loc;
+    uint32_t i;
 
     sorted_locations = malloc(sizeof(*sorted_locations) * num_locations);
     if (sorted_locations == NULL) {
         return;
     }
 
-    /* Sort locations */
     memcpy(sorted_locations, data->locations, sizeof(*sorted_locations) * num_locations);
+    if (thread != NULL) {
+        printf("thread %d:\n", thread->header->tid);
+        for (i = 0; i < num_locations; ++i) {
+            sorted_locations[i].total_time = thread->locations[i].total_time;
+            sorted_locations[i].count      = thread->locations[i].count;
+        }
+    } else if (data->header->num_threads > 1) {
+        printf("all %d threads:\n", data->header->num_threads);
+    }
+
+    /* Sort locations */
     qsort(sorted_locations, num_locations, sizeof(*sorted_locations), compare_locations);
 
     /* Print locations */
     printf("%25s %13s %13s %10s             FILE     FUNCTION\n",
            "NAME", "AVG", "TOTAL", "COUNT");
     for (loc = sorted_locations; loc < sorted_locations + num_locations; ++loc) {
+        if (loc->count == 0) {
+            continue;
+        }
+
         switch (loc->type) {
         case UCS_PROFILE_TYPE_SAMPLE:
             printf("%25s %13s %13s %10ld %15s:%-4d %s()\n",
@@ -182,9 +231,10 @@ static void show_profile_data_accum(profile_data_t *data, options_t *opts)
 
 KHASH_MAP_INIT_INT64(request_ids, int)
 
-static void show_profile_data_log(profile_data_t *data, options_t *opts)
+static void show_profile_data_log(profile_data_t *data, options_t *opts,
+                                  const profile_thread_data_t *thread)
 {
-    size_t num_recods               = data->header->num_records;
+    size_t num_recods               = thread->header->num_records;
     const ucs_profile_record_t **stack[UCS_PROFILE_STACK_MAX * 2];
     const ucs_profile_record_t **scope_ends;
     const ucs_profile_location_t *loc;
@@ -223,14 +273,17 @@ static void show_profile_data_log(profile_data_t *data, options_t *opts)
 
     memset(stack, 0, sizeof(stack));
 
+    printf("%sthread %d%s, %zu records:\n", NAME_COLOR, thread->header->tid,
+           CLEAR_COLOR, num_recods);
+
     /* Find the first record with minimal nesting level, which is the base of call stack */
     nesting         = 0;
     min_nesting     = 0;
-    for (rec = data->records; rec < data->records + num_recods; ++rec) {
+    for (rec = thread->records; rec < thread->records + num_recods; ++rec) {
         loc = &data->locations[rec->location];
         switch (loc->type) {
         case UCS_PROFILE_TYPE_SCOPE_BEGIN:
-            stack[nesting + UCS_PROFILE_STACK_MAX] = &scope_ends[rec - data->records];
+            stack[nesting + UCS_PROFILE_STACK_MAX] = &scope_ends[rec - thread->records];
             ++nesting;
             break;
         case UCS_PROFILE_TYPE_SCOPE_END:
@@ -249,7 +302,7 @@ static void show_profile_data_log(profile_data_t *data, options_t *opts)
     }
 
     if (num_recods > 0) {
-        prev_time = data->records[0].timestamp;
+        prev_time = thread->records[0].timestamp;
     } else {
         prev_time = 0;
     }
@@ -258,11 +311,11 @@ static void show_profile_data_log(profile_data_t *data, options_t *opts)
 
     /* Display records */
     nesting = -min_nesting;
-    for (rec = data->records; rec < data->records + num_recods; ++rec) {
+    for (rec = thread->records; rec < thread->records + num_recods; ++rec) {
         loc = &data->locations[rec->location];
         switch (loc->type) {
         case UCS_PROFILE_TYPE_SCOPE_BEGIN:
-            se = scope_ends[rec - data->records];
+            se = scope_ends[rec - thread->records];
             if (se != NULL) {
                 snprintf(buf, sizeof(buf), RECORD_FMT"  %s%s%s %s%.3f%s {",
                          RECORD_ARG(rec->timestamp - prev_time),
@@ -362,9 +415,11 @@ static int redirect_output(const ucs_profile_header_t *hdr)
 
     num_lines = 6 + /* header */
                 ((hdr->mode & UCS_BIT(UCS_PROFILE_MODE_ACCUM)) ?
-                                (hdr->num_locations + 2) : 0) +
+                                ((hdr->num_locations + 3) *
+                                 ((hdr->num_threads > 1) ?
+                                  (hdr->num_threads + 1) : 1)) : 0) +
                 ((hdr->mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) ?
-                                (hdr->num_records    + 1) : 0) +
+                                (hdr->num_records + 2 * hdr->num_threads) : 0) +
                 1; /* footer */
 
     if (num_lines <= wsz.ws_row) {
@@ -417,12 +472,14 @@ static void show_header(profile_data_t *data, options_t *opts)
     printf("   command : %s\n", data->header->cmdline);
     printf("   host    : %s\n", data->header->hostname);
     printf("   pid     : %d\n", data->header->pid);
+    printf("   threads : %d\n", data->header->num_threads);
     printf("   units   : %s\n", time_units_str[opts->time_units]);
     printf("\n");
 }
 
 static int show_profile_data(profile_data_t *data, options_t *opts)
 {
+    uint32_t thread_idx;
     int ret;
 
     if (!opts->raw) {
@@ -435,13 +492,23 @@ static int show_profile_data(profile_data_t *data, options_t *opts)
     show_header(data, opts);
 
     if (data->header->mode & UCS_BIT(UCS_PROFILE_MODE_ACCUM)) {
-        show_profile_data_accum(data, opts);
+        show_profile_data_accum(data, opts, NULL);
         printf("\n");
+        if (data->header->num_threads > 1) {
+            for (thread_idx = 0; thread_idx < data->header->num_threads;
+                 ++thread_idx) {
+                show_profile_data_accum(data, opts, &data->threads[thread_idx]);
+                printf("\n");
+            }
+        }
     }
 
     if (data->header->mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) {
-        show_profile_data_log(data, opts);
-        printf("\n");
+        for (thread_idx = 0; thread_idx < data->header->num_threads;
+             ++thread_idx) {
+            show_profile_data_log(data, opts, &data->threads[thread_idx]);
+            printf("\n");
+        }
     }
 
     return 0;
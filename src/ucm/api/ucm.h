@@ -38,7 +38,8 @@ typedef enum ucm_event_type {
     UCM_EVENT_VM_UNMAPPED     = UCS_BIT(17),
 
     /* Auxiliary flags */
-    UCM_EVENT_FLAG_NO_INSTALL = UCS_BIT(24)
+    UCM_EVENT_FLAG_NO_INSTALL = UCS_BIT(24),
+    UCM_EVENT_FLAG_ADDR_RANGES = UCS_BIT(25)
 
 } ucm_event_type_t;
 
@@ -205,6 +206,11 @@ ucs_status_t ucm_config_modify(const char *name, const char *value);
  *       only @cb handler will be registered for @a events. No memory
  *       events/hooks will be installed.
  *
+ * @note If UCM_EVENT_FLAG_ADDR_RANGES flag is passed in @a events argument,
+ *       @a cb is called for UCM_EVENT_VM_MAPPED and UCM_EVENT_VM_UNMAPPED
+ *       events only if they may overlap an address range added by
+ *       @ref ucm_add_event_range. Initially, no ranges are added.
+ *
  * @return Status code.
  */
 ucs_status_t ucm_set_event_handler(int events, int priority,
@@ -222,6 +228,38 @@ ucs_status_t ucm_set_event_handler(int events, int priority,
 void ucm_unset_event_handler(int events, ucm_event_callback_t cb, void *arg);
 
 
+/**
+ * @brief Subscribe a handler to memory events on an address range.
+ *
+ * Applies to handlers which were installed with UCM_EVENT_FLAG_ADDR_RANGES.
+ * Ranges are reference-counted, so every call should be matched by a call to
+ * @ref ucm_remove_event_range with the same parameters. The filter has
+ * a coarse granularity, so the handler may be called also for events which do
+ * not overlap any range.
+ *
+ * @param [in]  cb         Event-handling callback.
+ * @param [in]  arg        User-defined argument for the callback.
+ * @param [in]  address    Start of the address range.
+ * @param [in]  size       Size of the address range.
+ */
+void ucm_add_event_range(ucm_event_callback_t cb, void *arg, void *address,
+                         size_t size);
+
+
+/**
+ * @brief Unsubscribe a handler from memory events on an address range.
+ *
+ * @param [in]  cb         Event-handling callback.
+ * @param [in]  arg        User-defined argument for the callback.
+ * @param [in]  address    Start of the address range, as passed to
+ *                          @ref ucm_add_event_range.
+ * @param [in]  size       Size of the address range, as passed to
+ *                          @ref ucm_add_event_range.
+ */
+void ucm_remove_event_range(ucm_event_callback_t cb, void *arg, void *address,
+                            size_t size);
+
+
 /**
  * @brief Add memory events to the external events list.
  *
@@ -16,10 +16,12 @@
 #include <ucm/util/ucm_config.h>
 #include <ucm/util/log.h>
 #include <ucm/util/sys.h>
+#include <ucs/arch/atomic.h>
 #include <ucs/arch/cpu.h>
 
 #include <sys/mman.h>
 #include <pthread.h>
+#include <sched.h>
 #include <sys/shm.h>
 #include <sys/ipc.h>
 #include <stdlib.h>
@@ -27,10 +29,39 @@
 #include <errno.h>
 
 
-static pthread_rwlock_t ucm_event_lock = PTHREAD_RWLOCK_INITIALIZER;
+/* Address ranges filter: a counting hash of 2MB granules */
+#define UCM_EVENT_RANGES_SHIFT   21
+#define UCM_EVENT_RANGES_BITS    10
+#define UCM_EVENT_RANGES_COUNT   UCS_BIT(UCM_EVENT_RANGES_BITS)
+
+
+struct ucm_event_ranges {
+    volatile uint32_t     refcount[UCM_EVENT_RANGES_COUNT];
+};
+
+
+/*
+ * Snapshot of the handlers list, which is used by the event dispatch without
+ * taking any lock. Updates build a new snapshot, publish it, and release the
+ * old one only when no reader could be using it.
+ */
+typedef struct ucm_event_handlers {
+    int                   events;    /* Union of all handlers' events */
+    unsigned              count;     /* Number of handlers */
+    size_t                size;      /* Mapped size, 0 for the static snapshot */
+    ucm_event_handler_t   **handlers;
+} ucm_event_handlers_t;
+
+
+/* Protects the handlers list and the snapshot updates */
+static pthread_mutex_t ucm_event_update_lock = PTHREAD_MUTEX_INITIALIZER;
 static ucs_list_link_t ucm_event_handlers;
 static int ucm_external_events = 0;
 
+/* Number of readers which entered during even/odd epochs */
+static volatile uint32_t ucm_event_readers[2] = {0, 0};
+static volatile uint32_t ucm_event_epoch      = 0;
+
 static size_t ucm_shm_size(int shmid)
 {
     struct shmid_ds ds;
@@ -110,72 +141,224 @@ static ucs_list_link_t ucm_event_handlers =
                 UCS_LIST_INITIALIZER(&ucm_event_orig_handler.list,
                                      &ucm_event_orig_handler.list);
 
+static ucm_event_handler_t *ucm_event_orig_handlers[] = {
+    &ucm_event_orig_handler
+};
+static ucm_event_handlers_t ucm_event_orig_snapshot = {
+    .events   = UCM_EVENT_MMAP | UCM_EVENT_MUNMAP | UCM_EVENT_MREMAP |
+                UCM_EVENT_SHMAT | UCM_EVENT_SHMDT | UCM_EVENT_SBRK,
+    .count    = 1,
+    .size     = 0,
+    .handlers = ucm_event_orig_handlers
+};
+static ucm_event_handlers_t * volatile ucm_event_snapshot =
+                &ucm_event_orig_snapshot;
+
 
-static void ucm_event_dispatch(ucm_event_type_t event_type, ucm_event_t *event)
+static UCS_F_ALWAYS_INLINE unsigned
+ucm_event_ranges_hash(uintptr_t granule)
 {
-    ucm_event_handler_t *handler;
+    return (granule * 0x9e3779b97f4a7c15ul) >> (64 - UCM_EVENT_RANGES_BITS);
+}
 
-    ucs_list_for_each(handler, &ucm_event_handlers, list) {
-        if (handler->events & event_type) {
-            handler->cb(event_type, event, handler->arg);
+/*
+ * Check if a handler may be interested in the given address range. False
+ * positives are possible, false negatives are not.
+ */
+static int ucm_event_ranges_test(const ucm_event_ranges_t *ranges,
+                                 void *address, size_t size)
+{
+    uintptr_t first, last, granule;
+
+    if (size == 0) {
+        return 0;
+    }
+
+    first = (uintptr_t)address >> UCM_EVENT_RANGES_SHIFT;
+    last  = ((uintptr_t)address + size - 1) >> UCM_EVENT_RANGES_SHIFT;
+    if (last - first >= UCM_EVENT_RANGES_COUNT) {
+        return 1;
+    }
+
+    for (granule = first; granule <= last; ++granule) {
+        if (ranges->refcount[ucm_event_ranges_hash(granule)] != 0) {
+            return 1;
         }
     }
+    return 0;
 }
 
-#define ucm_event_lock(_lock_func) \
-    { \
-        int ret; \
-        do { \
-            ret = _lock_func(&ucm_event_lock); \
-        } while (ret == EAGAIN); \
-        if (ret != 0) { \
-            ucm_fatal("%s() failed: %s", #_lock_func, strerror(ret)); \
-        } \
+static void ucm_event_ranges_update(ucm_event_ranges_t *ranges, void *address,
+                                    size_t size, int delta)
+{
+    uintptr_t first, last, granule;
+    unsigned i;
+
+    if (size == 0) {
+        return;
     }
 
-static void ucm_event_enter()
+    first = (uintptr_t)address >> UCM_EVENT_RANGES_SHIFT;
+    last  = ((uintptr_t)address + size - 1) >> UCM_EVENT_RANGES_SHIFT;
+    if (last - first >= UCM_EVENT_RANGES_COUNT) {
+        /* Covers all buckets anyway */
+        for (i = 0; i < UCM_EVENT_RANGES_COUNT; ++i) {
+            ucs_atomic_add32(&ranges->refcount[i], delta);
+        }
+        return;
+    }
+
+    for (granule = first; granule <= last; ++granule) {
+        ucs_atomic_add32(&ranges->refcount[ucm_event_ranges_hash(granule)],
+                         delta);
+    }
+}
+
+/*
+ * Enter a read-side section, in which the returned handlers snapshot may be
+ * used. The section must not contain handler updates.
+ */
+static UCS_F_ALWAYS_INLINE unsigned
+ucm_event_enter(ucm_event_handlers_t **handlers_p)
 {
-    ucm_event_lock(pthread_rwlock_rdlock);
+    unsigned idx = ucm_event_epoch & 1;
+
+    ucs_atomic_add32(&ucm_event_readers[idx], 1);
+    ucs_memory_cpu_fence();
+    *handlers_p = ucm_event_snapshot;
+    return idx;
 }
 
-static void ucm_event_enter_exclusive()
+static UCS_F_ALWAYS_INLINE void ucm_event_leave(unsigned idx)
+{
+    ucs_memory_cpu_fence();
+    ucs_atomic_add32(&ucm_event_readers[idx], -1);
+}
+
+/*
+ * Wait until all readers which could have seen a previous snapshot leave.
+ * Every pass moves the new readers to the other counter and drains the old
+ * one; after two passes, both counters were empty at some point after the
+ * new snapshot was published.
+ */
+static void ucm_event_synchronize()
+{
+    unsigned i, idx;
+
+    for (i = 0; i < 2; ++i) {
+        idx = ucm_event_epoch & 1;
+        ucs_atomic_add32(&ucm_event_epoch, 1);
+        ucs_memory_cpu_fence();
+        while (ucm_event_readers[idx] != 0) {
+            sched_yield();
+        }
+    }
+}
+
+/*
+ * Publish a snapshot of the current handlers list. Must be called with
+ * ucm_event_update_lock held.
+ *
+ * The snapshot is mapped with the original mmap(), so it does not generate
+ * events nor depend on the state of malloc hooks.
+ */
+static void ucm_event_handlers_publish()
 {
-    ucm_event_lock(pthread_rwlock_wrlock);
+    ucm_event_handlers_t *handlers, *old_handlers;
+    ucm_event_handler_t *elem;
+    size_t size;
+    void *ptr;
+
+    size = sizeof(*handlers) + (ucs_list_length(&ucm_event_handlers) *
+                                sizeof(*handlers->handlers));
+    ptr  = ucm_orig_mmap(NULL, size, PROT_READ|PROT_WRITE,
+                         MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        ucm_fatal("failed to allocate event handlers snapshot: %m");
+    }
+
+    handlers           = ptr;
+    handlers->events   = 0;
+    handlers->count    = 0;
+    handlers->size     = size;
+    handlers->handlers = (ucm_event_handler_t**)(handlers + 1);
+    ucs_list_for_each(elem, &ucm_event_handlers, list) {
+        handlers->handlers[handlers->count++] = elem;
+        handlers->events                     |= elem->events;
+    }
+
+    old_handlers = ucm_event_snapshot;
+    ucs_memory_cpu_store_fence();
+    ucm_event_snapshot = handlers;
+
+    ucm_event_synchronize();
+
+    if (old_handlers->size != 0) {
+        ucm_orig_munmap(old_handlers, old_handlers->size);
+    }
 }
 
-static void ucm_event_leave()
+static void ucm_event_dispatch(ucm_event_handlers_t *handlers,
+                               ucm_event_type_t event_type, ucm_event_t *event)
 {
-    pthread_rwlock_unlock(&ucm_event_lock);
+    ucm_event_handler_t *handler;
+    unsigned i;
+
+    for (i = 0; i < handlers->count; ++i) {
+        handler = handlers->handlers[i];
+        if (handler->events & event_type) {
+            handler->cb(event_type, event, handler->arg);
+        }
+    }
 }
 
 static UCS_F_ALWAYS_INLINE void
-ucm_dispatch_vm_mmap(void *addr, size_t length)
+ucm_event_dispatch_vm(ucm_event_handlers_t *handlers, ucm_event_type_t event_type,
+                      void *addr, size_t length)
 {
+    ucm_event_handler_t *handler;
     ucm_event_t event;
+    unsigned i;
 
+    if (!(handlers->events & event_type)) {
+        return;
+    }
+
+    /* vm_mapped and vm_unmapped have the same layout */
     event.vm_mapped.address = addr;
     event.vm_mapped.size    = length;
-    ucm_event_dispatch(UCM_EVENT_VM_MAPPED, &event);
+    for (i = 0; i < handlers->count; ++i) {
+        handler = handlers->handlers[i];
+        if ((handler->events & event_type) &&
+            ((handler->ranges == NULL) ||
+             ucm_event_ranges_test(handler->ranges, addr, length))) {
+            handler->cb(event_type, &event, handler->arg);
+        }
+    }
 }
 
 static UCS_F_ALWAYS_INLINE void
-ucm_dispatch_vm_munmap(void *addr, size_t length)
+ucm_dispatch_vm_mmap(ucm_event_handlers_t *handlers, void *addr, size_t length)
 {
-    ucm_event_t event;
+    ucm_event_dispatch_vm(handlers, UCM_EVENT_VM_MAPPED, addr, length);
+}
 
-    event.vm_unmapped.address = addr;
-    event.vm_unmapped.size    = length;
-    ucm_event_dispatch(UCM_EVENT_VM_UNMAPPED, &event);
+static UCS_F_ALWAYS_INLINE void
+ucm_dispatch_vm_munmap(ucm_event_handlers_t *handlers, void *addr, size_t length)
+{
+    ucm_event_dispatch_vm(handlers, UCM_EVENT_VM_UNMAPPED, addr, length);
 }
 
 void *ucm_mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset)
 {
+    ucm_event_handlers_t *handlers;
     ucm_event_t event;
+    unsigned idx;
 
     ucm_trace("ucm_mmap(addr=%p length=%lu prot=0x%x flags=0x%x fd=%d offset=%ld)",
               addr, length, prot, flags, fd, offset);
 
-    ucm_event_enter();
+    idx = ucm_event_enter(&handlers);
 
     event.mmap.result  = MAP_FAILED;
     event.mmap.address = addr;
@@ -184,92 +367,104 @@ void *ucm_mmap(void *addr, size_t length, int prot, int flags, int fd, off_t off
     event.mmap.flags   = flags;
     event.mmap.fd      = fd;
     event.mmap.offset  = offset;
-    ucm_event_dispatch(UCM_EVENT_MMAP, &event);
+    ucm_event_dispatch(handlers, UCM_EVENT_MMAP, &event);
 
     if (event.mmap.result != MAP_FAILED) {
         /* Use original length */
-        ucm_dispatch_vm_mmap(event.mmap.result, length);
+        ucm_dispatch_vm_mmap(handlers, event.mmap.result, length);
     }
 
-    ucm_event_leave();
+    ucm_event_leave(idx);
 
     return event.mmap.result;
 }
 
 int ucm_munmap(void *addr, size_t length)
 {
+    ucm_event_handlers_t *handlers;
     ucm_event_t event;
+    unsigned idx;
 
-    ucm_event_enter();
+    idx = ucm_event_enter(&handlers);
 
     ucm_trace("ucm_munmap(addr=%p length=%lu)", addr, length);
 
-    ucm_dispatch_vm_munmap(addr, length);
+    ucm_dispatch_vm_munmap(handlers, addr, length);
 
     event.munmap.result  = -1;
     event.munmap.address = addr;
     event.munmap.size    = length;
-    ucm_event_dispatch(UCM_EVENT_MUNMAP, &event);
+    ucm_event_dispatch(handlers, UCM_EVENT_MUNMAP, &event);
 
-    ucm_event_leave();
+    ucm_event_leave(idx);
 
     return event.munmap.result;
 }
 
 void ucm_vm_mmap(void *addr, size_t length)
 {
-    ucm_event_enter();
+    ucm_event_handlers_t *handlers;
+    unsigned idx;
+
+    idx = ucm_event_enter(&handlers);
 
     ucm_trace("ucm_vm_mmap(addr=%p length=%lu)", addr, length);
-    ucm_dispatch_vm_mmap(addr, length);
+    ucm_dispatch_vm_mmap(handlers, addr, length);
 
-    ucm_event_leave();
+    ucm_event_leave(idx);
 }
 
 void ucm_vm_munmap(void *addr, size_t length)
 {
-    ucm_event_enter();
+    ucm_event_handlers_t *handlers;
+    unsigned idx;
+
+    idx = ucm_event_enter(&handlers);
 
     ucm_trace("ucm_vm_munmap(addr=%p length=%lu)", addr, length);
-    ucm_dispatch_vm_munmap(addr, length);
+    ucm_dispatch_vm_munmap(handlers, addr, length);
 
-    ucm_event_leave();
+    ucm_event_leave(idx);
 }
 
 void *ucm_mremap(void *old_address, size_t old_size, size_t new_size, int flags)
 {
+    ucm_event_handlers_t *handlers;
     ucm_event_t event;
+    unsigned idx;
 
-    ucm_event_enter();
+    idx = ucm_event_enter(&handlers);
 
     ucm_trace("ucm_mremap(old_address=%p old_size=%lu new_size=%ld flags=0x%x)",
               old_address, old_size, new_size, flags);
 
-    ucm_dispatch_vm_munmap(old_address, old_size);
+    ucm_dispatch_vm_munmap(handlers, old_address, old_size);
 
     event.mremap.result   = MAP_FAILED;
     event.mremap.address  = old_address;
     event.mremap.old_size = old_size;
     event.mremap.new_size = new_size;
     event.mremap.flags    = flags;
-    ucm_event_dispatch(UCM_EVENT_MREMAP, &event);
+    ucm_event_dispatch(handlers, UCM_EVENT_MREMAP, &event);
 
     if (event.mremap.result != MAP_FAILED) {
         /* Use original new_size */
-        ucm_dispatch_vm_mmap(event.mremap.result, new_size);
+        ucm_dispatch_vm_mmap(handlers, event.mremap.result, new_size);
     }
 
-    ucm_event_leave();
+    ucm_event_leave(idx);
 
     return event.mremap.result;
 }
 
 void *ucm_shmat(int shmid, const void *shmaddr, int shmflg)
 {
+    ucm_event_handlers_t *handlers;
     ucm_event_t event;
+    unsigned idx;
     size_t size;
 
-    ucm_event_enter();
+    idx = ucm_event_enter(&handlers);
 
     ucm_trace("ucm_shmat(shmid=%d shmaddr=%p shmflg=0x%x)",
               shmid, shmaddr, shmflg);
@@ -279,83 +474,104 @@ void *ucm_shmat(int shmid, const void *shmaddr, int shmflg)
     event.shmat.shmid   = shmid;
     event.shmat.shmaddr = shmaddr;
     event.shmat.shmflg  = shmflg;
-    ucm_event_dispatch(UCM_EVENT_SHMAT, &event);
+    ucm_event_dispatch(handlers, UCM_EVENT_SHMAT, &event);
 
     if (event.shmat.result != MAP_FAILED) {
-        ucm_dispatch_vm_mmap(event.shmat.result, size);
+        ucm_dispatch_vm_mmap(handlers, event.shmat.result, size);
     }
 
-    ucm_event_leave();
+    ucm_event_leave(idx);
 
     return event.shmat.result;
 }
 
 int ucm_shmdt(const void *shmaddr)
 {
+    ucm_event_handlers_t *handlers;
     ucm_event_t event;
+    unsigned idx;
 
-    ucm_event_enter();
+    idx = ucm_event_enter(&handlers);
 
     ucm_debug("ucm_shmdt(shmaddr=%p)", shmaddr);
 
-    ucm_dispatch_vm_munmap((void*)shmaddr, ucm_get_shm_seg_size(shmaddr));
+    ucm_dispatch_vm_munmap(handlers, (void*)shmaddr, ucm_get_shm_seg_size(shmaddr));
 
     event.shmdt.result  = -1;
     event.shmdt.shmaddr = shmaddr;
-    ucm_event_dispatch(UCM_EVENT_SHMDT, &event);
+    ucm_event_dispatch(handlers, UCM_EVENT_SHMDT, &event);
 
-    ucm_event_leave();
+    ucm_event_leave(idx);
 
     return event.shmdt.result;
 }
 
 void *ucm_sbrk(intptr_t increment)
 {
+    ucm_event_handlers_t *handlers;
     ucm_event_t event;
+    unsigned idx;
 
-    ucm_event_enter();
+    idx = ucm_event_enter(&handlers);
 
     ucm_trace("ucm_sbrk(increment=%+ld)", increment);
 
     if (increment < 0) {
-        ucm_dispatch_vm_munmap(ucm_orig_sbrk(0) + increment, -increment);
+        ucm_dispatch_vm_munmap(handlers, ucm_orig_sbrk(0) + increment, -increment);
     }
 
     event.sbrk.result    = MAP_FAILED;
     event.sbrk.increment = increment;
-    ucm_event_dispatch(UCM_EVENT_SBRK, &event);
+    ucm_event_dispatch(handlers, UCM_EVENT_SBRK, &event);
 
     if ((increment > 0) && (event.sbrk.result != MAP_FAILED)) {
-        ucm_dispatch_vm_mmap(ucm_orig_sbrk(0) - increment, increment);
+        ucm_dispatch_vm_mmap(handlers, ucm_orig_sbrk(0) - increment, increment);
     }
 
-    ucm_event_leave();
+    ucm_event_leave(idx);
 
     return event.sbrk.result;
 }
 
+static void ucm_event_lock()
+{
+    int ret;
+
+    ret = pthread_mutex_lock(&ucm_event_update_lock);
+    if (ret != 0) {
+        ucm_fatal("pthread_mutex_lock() failed: %s", strerror(ret));
+    }
+}
+
+static void ucm_event_unlock()
+{
+    pthread_mutex_unlock(&ucm_event_update_lock);
+}
+
 void ucm_event_handler_add(ucm_event_handler_t *handler)
 {
     ucm_event_handler_t *elem;
 
-    ucm_event_enter_exclusive();
+    ucm_event_lock();
     ucs_list_for_each(elem, &ucm_event_handlers, list) {
         if (handler->priority < elem->priority) {
             ucs_list_insert_before(&elem->list, &handler->list);
-            ucm_event_leave();
-            return;
+            goto out;
         }
     }
 
     ucs_list_add_tail(&ucm_event_handlers, &handler->list);
-    ucm_event_leave();
+out:
+    ucm_event_handlers_publish();
+    ucm_event_unlock();
 }
 
 void ucm_event_handler_remove(ucm_event_handler_t *handler)
 {
-    ucm_event_enter_exclusive();
+    ucm_event_lock();
     ucs_list_del(&handler->list);
-    ucm_event_leave();
+    ucm_event_handlers_publish();
+    ucm_event_unlock();
 }
 
 static ucs_status_t ucm_event_install(int events)
@@ -364,7 +580,8 @@ static ucs_status_t ucm_event_install(int events)
     int native_events;
 
     /* Replace aggregate events with the native events which make them */
-    native_events = events & ~(UCM_EVENT_VM_MAPPED | UCM_EVENT_VM_UNMAPPED);
+    native_events = events & ~(UCM_EVENT_VM_MAPPED | UCM_EVENT_VM_UNMAPPED |
+                               UCM_EVENT_FLAG_ADDR_RANGES);
     if (events & UCM_EVENT_VM_MAPPED) {
         native_events |= UCM_EVENT_MMAP | UCM_EVENT_MREMAP |
                          UCM_EVENT_SHMAT | UCM_EVENT_SBRK;
@@ -419,6 +636,16 @@ ucs_status_t ucm_set_event_handler(int events, int priority,
         return UCS_ERR_NO_MEMORY;
     }
 
+    if (events & UCM_EVENT_FLAG_ADDR_RANGES) {
+        handler->ranges = calloc(1, sizeof(*handler->ranges));
+        if (handler->ranges == NULL) {
+            free(handler);
+            return UCS_ERR_NO_MEMORY;
+        }
+    } else {
+        handler->ranges = NULL;
+    }
+
     handler->events   = events;
     handler->priority = priority;
     handler->cb       = cb;
@@ -433,16 +660,16 @@ ucs_status_t ucm_set_event_handler(int events, int priority,
 
 void ucm_set_external_event(int events)
 {
-    ucm_event_enter_exclusive();
+    ucm_event_lock();
     ucm_external_events |= events;
-    ucm_event_leave();
+    ucm_event_unlock();
 }
 
 void ucm_unset_external_event(int events)
 {
-    ucm_event_enter_exclusive();
+    ucm_event_lock();
     ucm_external_events &= ~events;
-    ucm_event_leave();
+    ucm_event_unlock();
 }
 
 void ucm_unset_event_handler(int events, ucm_event_callback_t cb, void *arg)
@@ -450,22 +677,56 @@ void ucm_unset_event_handler(int events, ucm_event_callback_t cb, void *arg)
     ucm_event_handler_t *elem, *tmp;
     UCS_LIST_HEAD(gc_list);
 
-    ucm_event_enter_exclusive();
+    ucm_event_lock();
     ucs_list_for_each_safe(elem, tmp, &ucm_event_handlers, list) {
         if ((cb == elem->cb) && (arg == elem->arg)) {
             elem->events &= ~events;
-            if (elem->events == 0) {
+            if ((elem->events & ~(UCM_EVENT_FLAG_NO_INSTALL |
+                                  UCM_EVENT_FLAG_ADDR_RANGES)) == 0) {
                 ucs_list_del(&elem->list);
                 ucs_list_add_tail(&gc_list, &elem->list);
             }
         }
     }
-    ucm_event_leave();
+    /* After publishing, no reader can see the removed handlers */
+    ucm_event_handlers_publish();
+    ucm_event_unlock();
 
     /* Do not release memory while we hold event lock - may deadlock */
     while (!ucs_list_is_empty(&gc_list)) {
         elem = ucs_list_extract_head(&gc_list, ucm_event_handler_t, list);
+        free(elem->ranges);
         free(elem);
     }
 }
 
+static void ucm_event_range_update(ucm_event_callback_t cb, void *arg,
+                                   void *address, size_t size, int delta)
+{
+    ucm_event_handlers_t *handlers;
+    ucm_event_handler_t *handler;
+    unsigned i, idx;
+
+    idx = ucm_event_enter(&handlers);
+    for (i = 0; i < handlers->count; ++i) {
+        handler = handlers->handlers[i];
+        if ((cb == handler->cb) && (arg == handler->arg) &&
+            (handler->ranges != NULL)) {
+            ucm_event_ranges_update(handler->ranges, address, size, delta);
+        }
+    }
+    ucm_event_leave(idx);
+}
+
+void ucm_add_event_range(ucm_event_callback_t cb, void *arg, void *address,
+                         size_t size)
+{
+    ucm_event_range_update(cb, arg, address, size, 1);
+}
+
+void ucm_remove_event_range(ucm_event_callback_t cb, void *arg, void *address,
+                            size_t size)
+{
+    ucm_event_range_update(cb, arg, address, size, -1);
+}
+
@@ -13,12 +13,16 @@
 #include <ucs/type/status.h>
 
 
+typedef struct ucm_event_ranges ucm_event_ranges_t;
+
+
 typedef struct ucm_event_handler {
     ucs_list_link_t       list;
     int                   events;
     int                   priority;
     ucm_event_callback_t  cb;
     void                  *arg;
+    ucm_event_ranges_t    *ranges;   /* Address filter, NULL - all addresses */
 } ucm_event_handler_t;
 
 
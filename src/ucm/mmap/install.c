@@ -65,6 +65,7 @@ static ucs_status_t ucm_mmap_test(int events)
     handler.priority = -1;
     handler.cb       = ucm_mmap_event_test_callback;
     handler.arg      = &out_events;
+    handler.ranges   = NULL;
     out_events       = 0;
 
     ucm_event_handler_add(&handler);
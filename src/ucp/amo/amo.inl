@@ -8,6 +8,8 @@
 #ifndef UCP_AMO_INL_
 #define UCP_AMO_INL_
 
+#include "amo_aggr.h"
+
 #include <inttypes.h>
 #include <ucp/core/ucp_request.inl>
 #include <ucp/core/ucp_mm.h>
@@ -91,6 +93,11 @@ UCP_POST_AMO_DECL(uint32_t, uct_ep_atomic_add32)
             return status; \
         } \
         UCP_THREAD_CS_ENTER_CONDITIONAL(&(_ep)->worker->mt_lock); \
+        if ((_ep)->worker->amo_aggr.entries != NULL) { \
+            status = ucp_amo_aggr_add(_ep, _param, _size, _remote_addr, _rkey); \
+            UCP_THREAD_CS_EXIT_CONDITIONAL(&(_ep)->worker->mt_lock); \
+            return status; \
+        } \
         for (;;) { \
             UCP_EP_RESOLVE_RKEY_AMO(_ep, _rkey, lane, uct_rkey); \
             status = UCS_PROFILE_CALL(_uct_func, \
@@ -262,4 +269,46 @@ static inline void init_amo_post(ucp_request_t *req, ucp_ep_h ep, ucp_atomic_pos
     init_amo_common(req, ep, remote_addr, rkey, value);
     req->send.uct.func = ucp_amo_post_select_uct_func(op, op_size);
 }
+
+/*
+ * Post an atomic addition, or add it to the pending queue if there are no send
+ * resources. Must be called with the worker lock held.
+ */
+static inline ucs_status_t ucp_amo_post_add(ucp_ep_h ep, uint64_t value,
+                                            size_t op_size, uint64_t remote_addr,
+                                            ucp_rkey_h rkey)
+{
+    ucs_status_ptr_t status_p;
+    ucp_lane_index_t lane;
+    uct_rkey_t uct_rkey;
+    ucs_status_t status;
+    ucp_request_t *req;
+
+    UCP_EP_RESOLVE_RKEY_AMO(ep, rkey, lane, uct_rkey);
+    if (op_size == sizeof(uint32_t)) {
+        status = UCS_PROFILE_CALL(uct_ep_atomic_add32, ep->uct_eps[lane],
+                                  (uint32_t)value, remote_addr, uct_rkey);
+    } else if (op_size == sizeof(uint64_t)) {
+        status = UCS_PROFILE_CALL(uct_ep_atomic_add64, ep->uct_eps[lane],
+                                  (uint64_t)value, remote_addr, uct_rkey);
+    } else {
+        return UCS_ERR_INVALID_PARAM;
+    }
+    if (ucs_likely(status != UCS_ERR_NO_RESOURCE)) {
+        return status;
+    }
+
+    req = ucp_request_get(ep->worker);
+    if (ucs_unlikely(NULL == req)) {
+        return UCS_ERR_NO_MEMORY;
+    }
+    init_amo_post(req, ep, UCP_ATOMIC_POST_OP_ADD, op_size, remote_addr, rkey,
+                  value);
+    status_p = ucp_amo_send_request(req, (ucp_send_callback_t)ucs_empty_function);
+    if (UCS_PTR_IS_PTR(status_p)) {
+        ucp_request_release(status_p);
+        return UCS_INPROGRESS;
+    }
+    return UCS_PTR_STATUS(status_p);
+}
 #endif
@@ -0,0 +1,231 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#include "amo_aggr.h"
+#include "amo.inl"
+
+#include <ucp/core/ucp_worker.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/math.h>
+
+
+static inline ucp_amo_aggr_entry_t *
+ucp_amo_aggr_entry_find(ucp_amo_aggr_t *aggr, ucp_ep_h ep, uint64_t remote_addr)
+{
+    uint64_t hash;
+
+    /* Counters are usually consecutive words, so mix the low address bits */
+    hash = ((remote_addr >> 2) ^ (uintptr_t)ep) * 0x9e3779b97f4a7c15ull;
+    return &aggr->entries[(hash >> 32) & aggr->mask];
+}
+
+static void ucp_amo_aggr_entry_remove(ucp_worker_h worker,
+                                      ucp_amo_aggr_entry_t *entry)
+{
+    --entry->rkey->amo_aggr_refs;
+    entry->ep = NULL;
+    if (--worker->amo_aggr.count == 0) {
+        uct_worker_slowpath_progress_unregister(worker->uct,
+                                                &worker->amo_aggr.cbq_elem);
+    }
+}
+
+static ucs_status_t ucp_amo_aggr_entry_send(ucp_worker_h worker,
+                                            ucp_amo_aggr_entry_t *entry)
+{
+    ucp_ep_h ep = entry->ep;
+    ucs_status_t status;
+
+    ucs_trace_data("ep %p: post aggregated atomic add%zu 0x%"PRIx64" to "
+                   "0x%"PRIx64, ep, entry->op_size * 8, entry->value,
+                   entry->remote_addr);
+
+    status = ucp_amo_post_add(ep, entry->value, entry->op_size,
+                              entry->remote_addr, entry->rkey);
+    if (status < 0) {
+        /* Keep the value, it is posted again by the next flush */
+        return status;
+    }
+
+    /* Sent or added to pending queue */
+    ucp_amo_aggr_entry_remove(worker, entry);
+    return UCS_OK;
+}
+
+static void ucp_amo_aggr_slow_path_callback(ucs_callbackq_slow_elem_t *self)
+{
+    ucp_worker_h worker = ucs_container_of(self, ucp_worker_t, amo_aggr.cbq_elem);
+    ucs_status_t status;
+
+    status = ucp_amo_aggr_flush(worker, NULL);
+    if (status != UCS_OK) {
+        ucs_error("failed to post aggregated atomic operations: %s",
+                  ucs_status_string(status));
+    }
+}
+
+ucs_status_t ucp_amo_aggr_init(ucp_worker_h worker)
+{
+    ucp_amo_aggr_t *aggr = &worker->amo_aggr;
+    unsigned num_entries = worker->context->config.ext.amo_aggregate;
+
+    aggr->count       = 0;
+    aggr->cbq_elem.cb = ucp_amo_aggr_slow_path_callback;
+
+    if (num_entries == 0) {
+        aggr->entries = NULL;
+        aggr->mask    = 0;
+        return UCS_OK;
+    }
+
+    num_entries   = ucs_roundup_pow2(num_entries);
+    aggr->entries = ucs_calloc(num_entries, sizeof(*aggr->entries),
+                               "ucp_amo_aggr");
+    if (aggr->entries == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    aggr->mask = num_entries - 1;
+    return UCS_OK;
+}
+
+void ucp_amo_aggr_cleanup(ucp_worker_h worker)
+{
+    ucs_assert(worker->amo_aggr.count == 0);
+    ucs_free(worker->amo_aggr.entries);
+}
+
+ucs_status_t ucp_amo_aggr_add(ucp_ep_h ep, uint64_t value, size_t op_size,
+                              uint64_t remote_addr, ucp_rkey_h rkey)
+{
+    ucp_worker_h worker = ep->worker;
+    ucp_lane_index_t UCS_V_UNUSED lane;
+    uct_rkey_t UCS_V_UNUSED uct_rkey;
+    ucp_amo_aggr_entry_t *entry;
+    ucs_status_t status;
+
+    entry = ucp_amo_aggr_entry_find(&worker->amo_aggr, ep, remote_addr);
+    if (ucs_likely((entry->ep == ep) && (entry->remote_addr == remote_addr) &&
+                   (entry->rkey == rkey) && (entry->op_size == op_size))) {
+        entry->value += value;
+        return UCS_OK;
+    }
+
+    if ((op_size != sizeof(uint32_t)) && (op_size != sizeof(uint64_t))) {
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    /* Report an unreachable destination now, rather than when sending */
+    UCP_EP_RESOLVE_RKEY_AMO(ep, rkey, lane, uct_rkey);
+
+    if (ucs_unlikely(rkey->worker != worker)) {
+        /* Only the worker which unpacked the key can flush the additions which
+         * use it when the key is destroyed */
+        status = ucp_amo_post_add(ep, value, op_size, remote_addr, rkey);
+        return (status == UCS_INPROGRESS) ? UCS_OK : status;
+    }
+
+    if (entry->ep != NULL) {
+        status = ucp_amo_aggr_entry_send(worker, entry);
+        if (status != UCS_OK) {
+            /* The entry keeps its own value for the next flush, which reports
+             * the error. Don't fail this operation for it, post it directly. */
+            status = ucp_amo_post_add(ep, value, op_size, remote_addr, rkey);
+            return (status == UCS_INPROGRESS) ? UCS_OK : status;
+        }
+    }
+
+    if (worker->amo_aggr.count++ == 0) {
+        uct_worker_slowpath_progress_register(worker->uct,
+                                              &worker->amo_aggr.cbq_elem);
+    }
+
+    ++rkey->amo_aggr_refs;
+    entry->ep          = ep;
+    entry->rkey        = rkey;
+    entry->remote_addr = remote_addr;
+    entry->value       = value;
+    entry->op_size     = op_size;
+    return UCS_OK;
+}
+
+ucs_status_t ucp_amo_aggr_flush(ucp_worker_h worker, ucp_ep_h ep)
+{
+    ucp_amo_aggr_t *aggr = &worker->amo_aggr;
+    ucp_amo_aggr_entry_t *entry;
+    ucs_status_t status;
+    unsigned i;
+
+    for (i = 0; (aggr->count > 0) && (i <= aggr->mask); ++i) {
+        entry = &aggr->entries[i];
+        if ((entry->ep != NULL) && ((ep == NULL) || (entry->ep == ep))) {
+            status = ucp_amo_aggr_entry_send(worker, entry);
+            if (status != UCS_OK) {
+                return status;
+            }
+        }
+    }
+
+    return UCS_OK;
+}
+
+ucs_status_t ucp_amo_aggr_flush_addr(ucp_ep_h ep, uint64_t remote_addr)
+{
+    ucp_worker_h worker = ep->worker;
+    ucp_amo_aggr_entry_t *entry;
+
+    if (ucs_likely(worker->amo_aggr.count == 0)) {
+        return UCS_OK;
+    }
+
+    entry = ucp_amo_aggr_entry_find(&worker->amo_aggr, ep, remote_addr);
+    if ((entry->ep != ep) || (entry->remote_addr != remote_addr)) {
+        return UCS_OK;
+    }
+
+    return ucp_amo_aggr_entry_send(worker, entry);
+}
+
+void ucp_amo_aggr_flush_rkey(ucp_rkey_h rkey)
+{
+    ucp_worker_h worker  = rkey->worker;
+    ucp_amo_aggr_t *aggr = &worker->amo_aggr;
+    ucp_amo_aggr_entry_t *entry;
+    ucs_status_t status;
+    unsigned i;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+    for (i = 0; (rkey->amo_aggr_refs > 0) && (i <= aggr->mask); ++i) {
+        entry = &aggr->entries[i];
+        if ((entry->ep == NULL) || (entry->rkey != rkey)) {
+            continue;
+        }
+
+        status = ucp_amo_aggr_entry_send(worker, entry);
+        if (status != UCS_OK) {
+            /* The key is released, so the addition cannot be sent later */
+            ucs_error("ep %p: failed to post aggregated atomic add to 0x%"PRIx64
+                      " before releasing its rkey: %s", entry->ep,
+                      entry->remote_addr, ucs_status_string(status));
+            ucp_amo_aggr_entry_remove(worker, entry);
+        }
+    }
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+}
+
+void ucp_amo_aggr_discard(ucp_worker_h worker, ucp_ep_h ep)
+{
+    ucp_amo_aggr_t *aggr = &worker->amo_aggr;
+    unsigned i;
+
+    for (i = 0; (aggr->count > 0) && (i <= aggr->mask); ++i) {
+        if (aggr->entries[i].ep == ep) {
+            ucs_debug("ep %p: discarding aggregated atomic add to 0x%"PRIx64,
+                      ep, aggr->entries[i].remote_addr);
+            ucp_amo_aggr_entry_remove(worker, &aggr->entries[i]);
+        }
+    }
+}
@@ -0,0 +1,73 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#ifndef UCP_AMO_AGGR_H_
+#define UCP_AMO_AGGR_H_
+
+#include <ucp/api/ucp_def.h>
+#include <ucs/datastruct/callbackq.h>
+
+
+/**
+ * Posted atomic addition which was not sent yet. Additions to the same remote
+ * address accumulate in the entry until it is sent as a single atomic.
+ */
+typedef struct ucp_amo_aggr_entry {
+    ucp_ep_h                      ep;          /* Endpoint, NULL if unused */
+    ucp_rkey_h                    rkey;        /* Remote memory key */
+    uint64_t                      remote_addr; /* Remote address */
+    uint64_t                      value;       /* Accumulated addition */
+    size_t                        op_size;     /* Operand size, 4 or 8 */
+} ucp_amo_aggr_entry_t;
+
+
+/**
+ * Direct-mapped cache of posted atomic additions, per worker. The entries are
+ * sent when evicted by a conflicting address, from the next worker progress,
+ * before any flush or fence, and when their remote key is destroyed.
+ */
+typedef struct ucp_amo_aggr {
+    ucp_amo_aggr_entry_t          *entries;    /* Cache entries, NULL if disabled */
+    unsigned                      mask;        /* Number of entries - 1 */
+    unsigned                      count;       /* Number of used entries */
+    ucs_callbackq_slow_elem_t     cbq_elem;    /* Sends the entries from progress */
+} ucp_amo_aggr_t;
+
+
+ucs_status_t ucp_amo_aggr_init(ucp_worker_h worker);
+
+void ucp_amo_aggr_cleanup(ucp_worker_h worker);
+
+/**
+ * Add to the remote value, possibly combining with previous additions.
+ * Must be called with the worker lock held.
+ */
+ucs_status_t ucp_amo_aggr_add(ucp_ep_h ep, uint64_t value, size_t op_size,
+                              uint64_t remote_addr, ucp_rkey_h rkey);
+
+/**
+ * Send the pending additions of an endpoint, or of all endpoints if @a ep is
+ * NULL. Must be called with the worker lock held.
+ */
+ucs_status_t ucp_amo_aggr_flush(ucp_worker_h worker, ucp_ep_h ep);
+
+/**
+ * Send the pending addition to a remote address, if there is one, so it would
+ * be ordered before a fetching atomic on the same address.
+ */
+ucs_status_t ucp_amo_aggr_flush_addr(ucp_ep_h ep, uint64_t remote_addr);
+
+/**
+ * Send the pending additions which use a remote key, before it is destroyed.
+ */
+void ucp_amo_aggr_flush_rkey(ucp_rkey_h rkey);
+
+/**
+ * Drop the pending additions of a destroyed endpoint.
+ */
+void ucp_amo_aggr_discard(ucp_worker_h worker, ucp_ep_h ep);
+
+#endif
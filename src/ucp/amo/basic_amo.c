@@ -25,6 +25,11 @@
             return status; \
         } \
         UCP_THREAD_CS_ENTER_CONDITIONAL(&(_ep)->worker->mt_lock); \
+        status = ucp_amo_aggr_flush_addr(_ep, _remote_addr); \
+        if (status != UCS_OK) { \
+            UCP_THREAD_CS_EXIT_CONDITIONAL(&(_ep)->worker->mt_lock); \
+            return status; \
+        } \
         comp.count = 2; \
         \
         for (;;) { \
@@ -136,8 +136,30 @@ enum ucp_feature {
                                            operations support */
     UCP_FEATURE_AMO64  = UCS_BIT(3),  /**< Request 64-bit atomic
                                            operations support */
-    UCP_FEATURE_WAKEUP = UCS_BIT(4)   /**< Request interrupt notification
+    UCP_FEATURE_WAKEUP = UCS_BIT(4),  /**< Request interrupt notification
                                            support */
+    UCP_FEATURE_AM     = UCS_BIT(5)   /**< Request active message support */
+};
+
+
+/**
+ * @ingroup UCP_COMM
+ * @brief Active message handler flags.
+ *
+ * The enumeration is used both when setting a handler with
+ * @ref ucp_worker_set_am_handler, and as the flags argument of
+ * @ref ucp_am_callback_t.
+ */
+enum ucp_am_cb_flags {
+    UCP_AM_FLAG_PERSISTENT_DATA = UCS_BIT(0) /**< The data passed to the
+                                                  handler may be kept by
+                                                  returning UCS_INPROGRESS, and
+                                                  released later by
+                                                  @ref ucp_am_data_release.
+                                                  When set on the handler, UCP
+                                                  copies the data to the receive
+                                                  descriptor if it was not
+                                                  received there. */
 };
 
 
@@ -1020,8 +1042,10 @@ void ucp_worker_release_address(ucp_worker_h worker, ucp_address_t *address);
  * communication progress.
  *
  * @param [in]  worker    Worker to progress.
+ *
+ * @return Non-zero if any communication was progressed, zero otherwise.
  */
-void ucp_worker_progress(ucp_worker_h worker);
+unsigned ucp_worker_progress(ucp_worker_h worker);
 
 
 /**
@@ -1068,6 +1092,12 @@ ucs_status_t ucp_worker_get_efd(ucp_worker_h worker, int *fd);
  * file descriptor obtained per worker using @ref ucp_worker_get_efd and the
  * second is waiting on the next event internally (this function).
  *
+ * Before blocking, the routine polls the worker with @ref ucp_worker_progress
+ * for a short time (see UCX_WAKEUP_SPIN_TIME), and returns immediately if any
+ * event is processed. The polling time adapts to the traffic pattern, so
+ * back-to-back events are served with polling latency while an idle worker
+ * goes to sleep quickly.
+ *
  * @note During the blocking call the wake-up mechanism relies on other means of
  * notification and may not progress some of the requests as it would when
  * calling @ref ucp_worker_progress (which is not invoked in that duration).
@@ -1236,6 +1266,36 @@ void ucp_ep_print_info(ucp_ep_h ep, FILE *stream);
 ucs_status_t ucp_ep_flush(ucp_ep_h ep);
 
 
+/**
+ * @ingroup UCP_ENDPOINT
+ *
+ * @brief Non-blocking flush of outstanding AMO and RMA operations on the
+ * @ref ucp_ep_h "endpoint".
+ *
+ * This routine starts a flush of all outstanding AMO and RMA communications on
+ * the @ref ucp_ep_h "endpoint". All the AMO and RMA operations issued on the
+ * @a ep prior to this call are completed both at the origin and at the target
+ * @ref ucp_ep_h "endpoint" when the returned request is completed. Unlike
+ * @ref ucp_disconnect_nb, the endpoint remains usable after the flush.
+ *
+ * @param [in] ep        UCP endpoint.
+ * @param [in] flags     Flags for flush operation. Reserved for future use.
+ * @param [in] cb        Callback which is called when the flush operation
+ *                       completes, unless it completed in place.
+ *
+ * @return UCS_OK           - The flush operation was completed immediately.
+ * @return UCS_PTR_IS_ERR(_ptr) - The flush operation failed.
+ * @return otherwise        - Flush operation was scheduled and can be completed
+ *                          in any point in time. The request handle is returned
+ *                          to the application in order to track progress. The
+ *                          application is responsible to release the handle
+ *                          using @ref ucp_request_release "ucp_request_release()"
+ *                          routine.
+ */
+ucs_status_ptr_t ucp_ep_flush_nb(ucp_ep_h ep, unsigned flags,
+                                 ucp_send_callback_t cb);
+
+
 /**
  * @ingroup UCP_MEM
  * @brief Map or allocate memory for zero-copy operations.
@@ -1582,6 +1642,79 @@ ucs_status_ptr_t ucp_tag_send_sync_nb(ucp_ep_h ep, const void *buffer, size_t co
                                       ucp_send_callback_t cb);
 
 
+/**
+ * @ingroup UCP_WORKER
+ * @brief Set an active message handler on the worker.
+ *
+ * This routine installs a handler for the active messages with id @a id which
+ * arrive to @a worker. The handler is called from @ref ucp_worker_progress
+ * directly when the message arrives, without any tag matching. Messages which
+ * arrive when no handler is set for their id are dropped.
+ *
+ * @note The worker must be created on a context with @ref UCP_FEATURE_AM.
+ *
+ * @param [in]  worker      Worker to set the handler on.
+ * @param [in]  id          Active message id.
+ * @param [in]  cb          Handler callback, or NULL to remove the handler.
+ * @param [in]  arg         Argument to pass to the handler.
+ * @param [in]  flags       Handler flags, see @ref ucp_am_cb_flags.
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucp_worker_set_am_handler(ucp_worker_h worker, uint16_t id,
+                                       ucp_am_callback_t cb, void *arg,
+                                       uint32_t flags);
+
+
+/**
+ * @ingroup UCP_COMM
+ * @brief Non-blocking active message send operation.
+ *
+ * This routine sends a message, described by @a buffer, @a count and
+ * @a datatype, to the handler with id @a id on the remote worker of @a ep.
+ * Messages which are sent on the same endpoint are delivered in order. Large
+ * messages are sent in fragments and passed to the handler only when they are
+ * complete.
+ *
+ * @param [in]  ep          Destination endpoint handle.
+ * @param [in]  id          Active message id of the remote handler.
+ * @param [in]  buffer      Pointer to the message buffer (payload).
+ * @param [in]  count       Number of elements to send.
+ * @param [in]  datatype    Datatype descriptor for the elements in the buffer.
+ * @param [in]  cb          Callback function that is invoked whenever the
+ *                          send operation is completed. It is important to note
+ *                          that the call-back is only invoked in a case when
+ *                          the operation cannot be completed in place.
+ *
+ * @return UCS_OK           - The send operation was completed immediately.
+ * @return UCS_PTR_IS_ERR(_ptr) - The send operation failed.
+ * @return otherwise        - Operation was scheduled for send and can be
+ *                          completed in any point in time. The request handle
+ *                          is returned to the application in order to track
+ *                          progress of the message. The application is
+ *                          responsible to release the handle using
+ *                          @ref ucp_request_release "ucp_request_release()"
+ *                          routine.
+ */
+ucs_status_ptr_t ucp_am_send_nb(ucp_ep_h ep, uint16_t id, const void *buffer,
+                                size_t count, ucp_datatype_t datatype,
+                                ucp_send_callback_t cb);
+
+
+/**
+ * @ingroup UCP_COMM
+ * @brief Release active message data which was kept by a handler.
+ *
+ * This routine releases the data of an active message, which was kept by
+ * returning UCS_INPROGRESS from the @ref ucp_am_callback_t "handler". It must
+ * not be called from the handler itself.
+ *
+ * @param [in]  worker      Worker on which the message was received.
+ * @param [in]  data        Data pointer which was passed to the handler.
+ */
+void ucp_am_data_release(ucp_worker_h worker, void *data);
+
+
 /**
  * @ingroup UCP_COMM
  * @brief Non-blocking tagged-receive operation.
@@ -1796,6 +1929,52 @@ ucs_status_t ucp_put_nbi(ucp_ep_h ep, const void *buffer, size_t length,
                          uint64_t remote_addr, ucp_rkey_h rkey);
 
 
+/**
+ * @ingroup UCP_COMM
+ * @brief Non-blocking remote memory put operation.
+ *
+ * This routine initiates a storage of contiguous block of data that is
+ * described by the local address @a buffer in the remote contiguous memory
+ * region described by @a remote_addr address and the @ref ucp_rkey_h "memory
+ * handle" @a rkey. The routine returns immediately and @b does @b not
+ * guarantee re-usability of the source address @e buffer. If the operation is
+ * completed immediately the routine returns UCS_OK, otherwise a request handle
+ * is returned, and the call-back function @a cb is invoked when the source
+ * address @e buffer can be reused.
+ *
+ * @note Unlike @ref ucp_put_nbi, completion of each operation can be tracked
+ * separately, without flushing the endpoint or the worker. Completion of the
+ * request does not guarantee remote completion of the operation; use
+ * @ref ucp_ep_flush_nb "ucp_ep_flush_nb()" for that.
+ *
+ * @param [in]  ep           Remote endpoint handle.
+ * @param [in]  buffer       Pointer to the local source address.
+ * @param [in]  length       Length of the data (in bytes) stored under the
+ *                           source address.
+ * @param [in]  remote_addr  Pointer to the destination remote address
+ *                           to write to.
+ * @param [in]  rkey         Remote memory key associated with the
+ *                           remote address.
+ * @param [in]  cb           Callback function that is invoked whenever the
+ *                           operation is completed and the source buffer can
+ *                           be reused. It is not invoked if the operation
+ *                           completes immediately.
+ *
+ * @return UCS_OK           - The operation was completed immediately.
+ * @return UCS_PTR_IS_ERR(_ptr) - The operation failed.
+ * @return otherwise        - Operation was scheduled and can be completed
+ *                          in any point in time. The request handle is returned
+ *                          to the application in order to track progress of
+ *                          the operation. The application is responsible to
+ *                          release the handle using
+ *                          @ref ucp_request_release "ucp_request_release()"
+ *                          routine.
+ */
+ucs_status_ptr_t ucp_put_nb(ucp_ep_h ep, const void *buffer, size_t length,
+                            uint64_t remote_addr, ucp_rkey_h rkey,
+                            ucp_send_callback_t cb);
+
+
 /**
  * @ingroup UCP_COMM
  * @brief Blocking remote memory get operation.
@@ -1851,6 +2030,43 @@ ucs_status_t ucp_get_nbi(ucp_ep_h ep, void *buffer, size_t length,
                          uint64_t remote_addr, ucp_rkey_h rkey);
 
 
+/**
+ * @ingroup UCP_COMM
+ * @brief Non-blocking remote memory get operation.
+ *
+ * This routine initiates a load of contiguous block of data that is described
+ * by the remote address @a remote_addr and the @ref ucp_rkey_h "memory handle"
+ * @a rkey in the local contiguous memory region described by @a buffer
+ * address. The routine returns immediately. If the operation is completed
+ * immediately the routine returns UCS_OK, otherwise a request handle is
+ * returned, and the call-back function @a cb is invoked when the remote data
+ * is loaded and stored under the local address @e buffer.
+ *
+ * @param [in]  ep           Remote endpoint handle.
+ * @param [in]  buffer       Pointer to the local destination address.
+ * @param [in]  length       Length of the data (in bytes) to load.
+ * @param [in]  remote_addr  Pointer to the source remote address to read from.
+ * @param [in]  rkey         Remote memory key associated with the
+ *                           remote address.
+ * @param [in]  cb           Callback function that is invoked whenever the
+ *                           data is stored in the local buffer. It is not
+ *                           invoked if the operation completes immediately.
+ *
+ * @return UCS_OK           - The operation was completed immediately.
+ * @return UCS_PTR_IS_ERR(_ptr) - The operation failed.
+ * @return otherwise        - Operation was scheduled and can be completed
+ *                          in any point in time. The request handle is returned
+ *                          to the application in order to track progress of
+ *                          the operation. The application is responsible to
+ *                          release the handle using
+ *                          @ref ucp_request_release "ucp_request_release()"
+ *                          routine.
+ */
+ucs_status_ptr_t ucp_get_nb(ucp_ep_h ep, void *buffer, size_t length,
+                            uint64_t remote_addr, ucp_rkey_h rkey,
+                            ucp_send_callback_t cb);
+
+
 /**
  * @ingroup UCP_COMM
  * @brief Blocking atomic add operation for 32 bit integers
@@ -2203,6 +2419,38 @@ ucs_status_t ucp_dt_create_generic(const ucp_generic_dt_ops_t *ops, void *contex
                                    ucp_datatype_t *datatype_p);
 
 
+/**
+ * @ingroup UCP_DATATYPE
+ * @brief Create a strided datatype.
+ *
+ * This routine creates a strided datatype object, which describes @a count
+ * blocks of @a blocklength elements of @a elem_datatype each, where the
+ * beginnings of successive blocks are @a stride bytes apart. The element
+ * datatype can be either contiguous or strided, so multi-dimensional strided
+ * layouts, such as a sub-array of a matrix, are created by nesting strided
+ * datatypes. The data of a strided datatype is transferred without an
+ * intermediate pack to a contiguous buffer by the application.
+ * When a buffer holds several items of a strided datatype, successive items
+ * start (@a count - 1) * @a stride + @a blocklength * <element extent> bytes
+ * apart, where the extent of a contiguous element is its size.
+ * The application is responsible to release the @a datatype_p object using
+ * @ref ucp_dt_destroy "ucp_dt_destroy()" routine. The element datatype may be
+ * released once this routine returns.
+ *
+ * @param [in]  count          Number of blocks.
+ * @param [in]  blocklength    Number of elements in every block.
+ * @param [in]  stride         Distance between the beginnings of successive
+ *                             blocks, in bytes.
+ * @param [in]  elem_datatype  Datatype of the elements, contiguous or strided.
+ * @param [out] datatype_p     A pointer to datatype object.
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucp_dt_create_strided(size_t count, size_t blocklength,
+                                   size_t stride, ucp_datatype_t elem_datatype,
+                                   ucp_datatype_t *datatype_p);
+
+
 /**
  * @ingroup UCP_DATATYPE
  * @brief Destroy a datatype and release its resources.
@@ -2210,7 +2458,8 @@ ucs_status_t ucp_dt_create_generic(const ucp_generic_dt_ops_t *ops, void *contex
  * This routine destroys the @a datatype object and
  * releases any resources that are associated with the object.
  * The @a datatype object must be allocated using @ref ucp_dt_create_generic
- * "ucp_dt_create_generic()" routine.
+ * "ucp_dt_create_generic()" or @ref ucp_dt_create_strided
+ * "ucp_dt_create_strided()" routine.
  *
  * @warning
  * @li Once the @a datatype object is released an access to this object may
@@ -2267,6 +2516,36 @@ ucs_status_t ucp_worker_fence(ucp_worker_h worker);
  */
 ucs_status_t ucp_worker_flush(ucp_worker_h worker);
 
+
+/**
+ * @ingroup UCP_WORKER
+ *
+ * @brief Non-blocking flush of outstanding AMO and RMA operations on the
+ * @ref ucp_worker_h "worker"
+ *
+ * This routine starts a flush of all outstanding AMO and RMA communications on
+ * the @ref ucp_worker_h "worker". All the AMO and RMA operations issued on the
+ * @a worker prior to this call are completed both at the origin and at the
+ * target when the returned request is completed. The flush progresses from
+ * @ref ucp_worker_progress "ucp_worker_progress()".
+ *
+ * @param [in] worker    UCP worker.
+ * @param [in] flags     Flags for flush operation. Reserved for future use.
+ * @param [in] cb        Callback which is called when the flush operation
+ *                       completes, unless it completed in place.
+ *
+ * @return UCS_OK           - The flush operation was completed immediately.
+ * @return UCS_PTR_IS_ERR(_ptr) - The flush operation failed.
+ * @return otherwise        - Flush operation was scheduled and can be completed
+ *                          in any point in time. The request handle is returned
+ *                          to the application in order to track progress. The
+ *                          application is responsible to release the handle
+ *                          using @ref ucp_request_release "ucp_request_release()"
+ *                          routine.
+ */
+ucs_status_ptr_t ucp_worker_flush_nb(ucp_worker_h worker, unsigned flags,
+                                     ucp_send_callback_t cb);
+
 /**
  * @ingroup UCP_COMM
  * @brief Atomic operation requested for ucp_atomic_post
@@ -235,4 +235,29 @@ typedef void (*ucp_tag_recv_callback_t)(void *request, ucs_status_t status,
                                         ucp_tag_recv_info_t *info);
 
 
+/**
+ * @ingroup UCP_COMM
+ * @brief Callback to process an incoming active message.
+ *
+ * This callback routine is invoked on the receiver side whenever a message
+ * which was sent by @ref ucp_am_send_nb arrives, with the handler which was
+ * set by @ref ucp_worker_set_am_handler for the message id. It is called from
+ * the context of @ref ucp_worker_progress, and must not call communication
+ * routines of the same worker.
+ *
+ * @param [in]  arg      User-defined argument.
+ * @param [in]  data     Points to the received data.
+ * @param [in]  length   Length of the received data.
+ * @param [in]  flags    If @ref UCP_AM_FLAG_PERSISTENT_DATA is set, the data
+ *                       may be kept after the callback returns.
+ *
+ * @retval UCS_OK         The data was consumed, and can be released by UCP.
+ * @retval UCS_INPROGRESS The data is owned by the callee, which must release it
+ *                        later with @ref ucp_am_data_release. Allowed only if
+ *                        @ref UCP_AM_FLAG_PERSISTENT_DATA is set in @a flags.
+ */
+typedef ucs_status_t (*ucp_am_callback_t)(void *arg, void *data, size_t length,
+                                          unsigned flags);
+
+
 #endif
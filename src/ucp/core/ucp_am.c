@@ -0,0 +1,535 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#include "ucp_am.h"
+
+#include <ucp/core/ucp_worker.h>
+#include <ucp/core/ucp_request.inl>
+#include <ucp/proto/proto_am.inl>
+#include <ucp/tag/eager.h>
+#include <ucs/debug/log.h>
+#include <ucs/debug/memtrack.h>
+#include <string.h>
+
+
+ucs_status_t ucp_worker_set_am_handler(ucp_worker_h worker, uint16_t id,
+                                       ucp_am_callback_t cb, void *arg,
+                                       uint32_t flags)
+{
+    ucp_worker_am_entry_t *handlers;
+    ucs_status_t status;
+    unsigned num_handlers;
+
+    if (!(worker->context->config.features & UCP_FEATURE_AM)) {
+        ucs_error("worker %p: active messages are not enabled", worker);
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+
+    if (id >= worker->am.num_handlers) {
+        num_handlers = ucs_max(id + 1, 2 * worker->am.num_handlers);
+        handlers     = ucs_realloc(worker->am.handlers,
+                                   num_handlers * sizeof(*handlers),
+                                   "ucp_am_handlers");
+        if (handlers == NULL) {
+            status = UCS_ERR_NO_MEMORY;
+            goto out;
+        }
+
+        memset(handlers + worker->am.num_handlers, 0,
+               (num_handlers - worker->am.num_handlers) * sizeof(*handlers));
+        worker->am.handlers     = handlers;
+        worker->am.num_handlers = num_handlers;
+    }
+
+    worker->am.handlers[id].cb    = cb;
+    worker->am.handlers[id].arg   = arg;
+    worker->am.handlers[id].flags = flags;
+    status = UCS_OK;
+
+out:
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+    return status;
+}
+
+void ucp_am_cleanup(ucp_worker_h worker)
+{
+    ucp_am_partial_t *partial, *tmp;
+
+    ucs_list_for_each_safe(partial, tmp, &worker->am.partial, list) {
+        ucs_warn("worker %p: dropping incomplete active message id %d from "
+                 "uuid 0x%"PRIx64, worker, partial->hdr.am_id,
+                 partial->req.sender_uuid);
+        ucs_list_del(&partial->list);
+        ucs_free(partial);
+    }
+
+    ucs_free(worker->am.handlers);
+}
+
+void ucp_am_data_release(ucp_worker_h worker, void *data)
+{
+    ucp_recv_desc_t *rdesc = (ucp_recv_desc_t*)(data - sizeof(ucp_am_hdr_t)) - 1;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+
+    if (rdesc->flags & UCP_RECV_DESC_FLAG_MALLOC) {
+        ucs_free(ucs_container_of(rdesc, ucp_am_partial_t, rdesc));
+    } else {
+        uct_iface_release_am_desc(rdesc);
+    }
+
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+}
+
+/* packing start */
+
+static size_t ucp_am_pack_single_dt(void *dest, void *arg)
+{
+    ucp_am_hdr_t *hdr = dest;
+    ucp_request_t *req = arg;
+    size_t length;
+
+    hdr->am_id    = req->send.am_id;
+    hdr->reserved = 0;
+    hdr->padding  = 0;
+
+    ucs_assert(req->send.state.offset == 0);
+    length = ucp_tag_pack_dt_copy(hdr + 1, req->send.buffer,
+                                  &req->send.state, req->send.length,
+                                  req->send.datatype);
+    ucs_assert(length == req->send.length);
+    return sizeof(*hdr) + length;
+}
+
+static size_t ucp_am_pack_first_dt(void *dest, void *arg)
+{
+    ucp_am_first_hdr_t *hdr = dest;
+    ucp_request_t *req = arg;
+    size_t length;
+
+    length                = ucp_ep_config(req->send.ep)->am.max_bcopy -
+                            sizeof(*hdr);
+    hdr->super.am_id      = req->send.am_id;
+    hdr->super.reserved   = 0;
+    hdr->super.padding    = 0;
+    hdr->req.sender_uuid  = req->send.ep->worker->uuid;
+    hdr->req.reqptr       = (uintptr_t)req;
+    hdr->total_len        = req->send.length;
+
+    ucs_assert(req->send.state.offset == 0);
+    ucs_assert(req->send.length > length);
+    return sizeof(*hdr) + ucp_tag_pack_dt_copy(hdr + 1, req->send.buffer,
+                                               &req->send.state,
+                                               length, req->send.datatype);
+}
+
+static size_t ucp_am_pack_middle_dt(void *dest, void *arg)
+{
+    ucp_am_mid_hdr_t *hdr = dest;
+    ucp_request_t *req = arg;
+    size_t length;
+
+    length               = ucp_ep_config(req->send.ep)->am.max_bcopy -
+                           sizeof(*hdr);
+    hdr->req.sender_uuid = req->send.ep->worker->uuid;
+    hdr->req.reqptr      = (uintptr_t)req;
+    return sizeof(*hdr) + ucp_tag_pack_dt_copy(hdr + 1, req->send.buffer,
+                                               &req->send.state,
+                                               length, req->send.datatype);
+}
+
+static size_t ucp_am_pack_last_dt(void *dest, void *arg)
+{
+    ucp_am_mid_hdr_t *hdr = dest;
+    ucp_request_t *req = arg;
+    size_t length, ret_length;
+
+    length               = req->send.length - req->send.state.offset;
+    hdr->req.sender_uuid = req->send.ep->worker->uuid;
+    hdr->req.reqptr      = (uintptr_t)req;
+    ret_length           = ucp_tag_pack_dt_copy(hdr + 1, req->send.buffer,
+                                                &req->send.state, length,
+                                                req->send.datatype);
+    ucs_assertv(ret_length == length, "length=%zu, max_length=%zu",
+                ret_length, length);
+    return sizeof(*hdr) + ret_length;
+}
+
+/* send */
+
+static UCS_F_ALWAYS_INLINE ucs_status_t
+ucp_am_send_short(ucp_ep_t *ep, uint16_t id, const void *buffer, size_t length)
+{
+    union {
+        ucp_am_hdr_t hdr;
+        uint64_t     u64;
+    } am;
+
+    UCS_STATIC_ASSERT(sizeof(ucp_am_hdr_t) == sizeof(uint64_t));
+    am.hdr.am_id    = id;
+    am.hdr.reserved = 0;
+    am.hdr.padding  = 0;
+    return uct_ep_am_short(ucp_ep_get_am_uct_ep(ep), UCP_AM_ID_AM_ONLY, am.u64,
+                           buffer, length);
+}
+
+static ucs_status_t ucp_am_contig_short(uct_pending_req_t *self)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+    ucs_status_t status;
+
+    req->send.lane = ucp_ep_get_am_lane(req->send.ep);
+    status = ucp_am_send_short(req->send.ep, req->send.am_id, req->send.buffer,
+                               req->send.length);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    ucp_request_complete_send(req, UCS_OK);
+    return UCS_OK;
+}
+
+static ucs_status_t ucp_am_bcopy_single(uct_pending_req_t *self)
+{
+    ucs_status_t status = ucp_do_am_bcopy_single(self, UCP_AM_ID_AM_ONLY,
+                                                 ucp_am_pack_single_dt);
+    if (status == UCS_OK) {
+        ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+        ucp_request_send_generic_dt_finish(req);
+        ucp_request_complete_send(req, UCS_OK);
+    }
+    return status;
+}
+
+static ucs_status_t ucp_am_bcopy_multi(uct_pending_req_t *self)
+{
+    ucs_status_t status = ucp_do_am_bcopy_multi(self,
+                                                UCP_AM_ID_AM_FIRST,
+                                                UCP_AM_ID_AM_MIDDLE,
+                                                UCP_AM_ID_AM_LAST,
+                                                sizeof(ucp_am_mid_hdr_t),
+                                                ucp_am_pack_first_dt,
+                                                ucp_am_pack_middle_dt,
+                                                ucp_am_pack_last_dt);
+    if (status == UCS_OK) {
+        ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+        ucp_request_send_generic_dt_finish(req);
+        ucp_request_complete_send(req, UCS_OK);
+    }
+    return status;
+}
+
+static void ucp_am_zcopy_req_complete(ucp_request_t *req)
+{
+    ucp_request_send_buffer_dereg(req, req->send.lane);
+    ucp_request_complete_send(req, UCS_OK);
+}
+
+static ucs_status_t ucp_am_zcopy_single(uct_pending_req_t *self)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+    ucp_am_hdr_t hdr;
+
+    hdr.am_id    = req->send.am_id;
+    hdr.reserved = 0;
+    hdr.padding  = 0;
+    return ucp_do_am_zcopy_single(self, UCP_AM_ID_AM_ONLY, &hdr, sizeof(hdr),
+                                  ucp_am_zcopy_req_complete);
+}
+
+static ucs_status_t ucp_am_zcopy_multi(uct_pending_req_t *self)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+    ucp_am_first_hdr_t first_hdr;
+    ucp_am_mid_hdr_t mid_hdr;
+
+    first_hdr.super.am_id     = req->send.am_id;
+    first_hdr.super.reserved  = 0;
+    first_hdr.super.padding   = 0;
+    first_hdr.req.sender_uuid = req->send.ep->worker->uuid;
+    first_hdr.req.reqptr      = (uintptr_t)req;
+    first_hdr.total_len       = req->send.length;
+    mid_hdr.req               = first_hdr.req;
+    return ucp_do_am_zcopy_multi(self,
+                                 UCP_AM_ID_AM_FIRST,
+                                 UCP_AM_ID_AM_MIDDLE,
+                                 UCP_AM_ID_AM_LAST,
+                                 &first_hdr, sizeof(first_hdr),
+                                 &mid_hdr, sizeof(mid_hdr),
+                                 ucp_am_zcopy_req_complete);
+}
+
+static void ucp_am_zcopy_completion(uct_completion_t *self,
+                                    ucs_status_t status)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct_comp);
+    ucp_am_zcopy_req_complete(req);
+}
+
+static const ucp_proto_t ucp_am_proto = {
+    .contig_short            = ucp_am_contig_short,
+    .bcopy_single            = ucp_am_bcopy_single,
+    .bcopy_multi             = ucp_am_bcopy_multi,
+    .zcopy_single            = ucp_am_zcopy_single,
+    .zcopy_multi             = ucp_am_zcopy_multi,
+    .zcopy_completion        = ucp_am_zcopy_completion,
+    .only_hdr_size           = sizeof(ucp_am_hdr_t),
+    .first_hdr_size          = sizeof(ucp_am_first_hdr_t),
+    .mid_hdr_size            = sizeof(ucp_am_mid_hdr_t)
+};
+
+/* Will be called if request is completed internally before returned to user */
+static void ucp_am_stub_send_completion(void *request, ucs_status_t status)
+{
+    ucs_assertv(status == UCS_OK, "status=%s", ucs_status_string(status));
+}
+
+ucs_status_ptr_t ucp_am_send_nb(ucp_ep_h ep, uint16_t id, const void *buffer,
+                                size_t count, ucp_datatype_t datatype,
+                                ucp_send_callback_t cb)
+{
+    ucs_status_t status;
+    ucp_request_t *req;
+    size_t length;
+    ucs_status_ptr_t ret;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&ep->worker->mt_lock);
+
+    ucs_trace_req("am_send_nb buffer %p count %zu id %d to %s cb %p",
+                  buffer, count, id, ucp_ep_peer_name(ep), cb);
+
+    if (ucs_likely(UCP_DT_IS_CONTIG(datatype))) {
+        length = ucp_contig_dt_length(datatype, count);
+        if (ucs_likely((ssize_t)length <= ucp_ep_config(ep)->am.max_eager_short)) {
+            status = ucp_am_send_short(ep, id, buffer, length);
+            if (ucs_likely(status != UCS_ERR_NO_RESOURCE)) {
+                ret = UCS_STATUS_PTR(status); /* UCS_OK also goes here */
+                goto out;
+            }
+        }
+    }
+
+    req = ucp_request_get(ep->worker);
+    if (req == NULL) {
+        ret = UCS_STATUS_PTR(UCS_ERR_NO_MEMORY);
+        goto out;
+    }
+
+    req->flags             = 0;
+    req->send.ep           = ep;
+    req->send.buffer       = buffer;
+    req->send.datatype     = datatype;
+    req->send.cb           = ucp_am_stub_send_completion;
+    req->send.am_id        = id;
+    req->send.state.offset = 0;
+#if ENABLE_ASSERT
+    req->send.lane         = UCP_NULL_LANE;
+#endif
+
+    /* Active messages are always sent eagerly, so disable rendezvous */
+    ret = ucp_tag_send_req(req, count,
+                           ucp_ep_config(ep)->am.max_eager_short,
+                           ucp_ep_config(ep)->am.zcopy_thresh,
+                           SIZE_MAX, SIZE_MAX, cb, &ucp_am_proto);
+out:
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&ep->worker->mt_lock);
+    return ret;
+}
+
+/* receive */
+
+static UCS_F_ALWAYS_INLINE ucs_status_t
+ucp_am_invoke_handler(ucp_worker_h worker, uint16_t am_id, void *data,
+                      size_t length, unsigned flags)
+{
+    ucp_worker_am_entry_t *handler;
+    ucs_status_t status;
+
+    if (ucs_unlikely((am_id >= worker->am.num_handlers) ||
+                     (worker->am.handlers[am_id].cb == NULL))) {
+        ucs_warn("worker %p: no handler for active message id %d, dropping "
+                 "%zu bytes", worker, am_id, length);
+        return UCS_OK;
+    }
+
+    handler = &worker->am.handlers[am_id];
+    status  = handler->cb(handler->arg, data, length, flags);
+    ucs_assertv((status == UCS_OK) ||
+                ((status == UCS_INPROGRESS) &&
+                 (flags & UCP_AM_FLAG_PERSISTENT_DATA)),
+                "am_id=%d status=%s", am_id, ucs_status_string(status));
+    return status;
+}
+
+static ucs_status_t ucp_am_only_handler(void *arg, void *data, size_t length,
+                                        void *desc)
+{
+    ucp_worker_h worker    = arg;
+    ucp_am_hdr_t *hdr      = data;
+    ucp_recv_desc_t *rdesc = desc;
+    uint16_t am_id         = hdr->am_id;
+    unsigned flags;
+
+    ucs_assert(length >= sizeof(*hdr));
+
+    if (data == rdesc + 1) {
+        flags = UCP_AM_FLAG_PERSISTENT_DATA;
+    } else if ((am_id < worker->am.num_handlers) &&
+               (worker->am.handlers[am_id].flags & UCP_AM_FLAG_PERSISTENT_DATA)) {
+        memcpy(rdesc + 1, data, length);
+        flags = UCP_AM_FLAG_PERSISTENT_DATA;
+    } else {
+        return ucp_am_invoke_handler(worker, am_id, hdr + 1,
+                                     length - sizeof(*hdr), 0);
+    }
+
+    rdesc->flags = 0;
+    return ucp_am_invoke_handler(worker, am_id, (ucp_am_hdr_t*)(rdesc + 1) + 1,
+                                 length - sizeof(*hdr), flags);
+}
+
+static ucs_status_t ucp_am_first_handler(void *arg, void *data, size_t length,
+                                         void *desc)
+{
+    ucp_worker_h worker         = arg;
+    ucp_am_first_hdr_t *hdr     = data;
+    size_t recv_len             = length - sizeof(*hdr);
+    ucp_am_partial_t *partial;
+
+    ucs_assert(length >= sizeof(*hdr));
+    ucs_assert(hdr->total_len >= recv_len);
+
+    partial = ucs_malloc(sizeof(*partial) + hdr->total_len, "ucp_am_partial");
+    if (partial == NULL) {
+        ucs_error("worker %p: failed to allocate %zu bytes for active message "
+                  "id %d", worker, hdr->total_len, hdr->super.am_id);
+        return UCS_OK;
+    }
+
+    /* The data is passed to the handler right after rdesc and hdr */
+    UCS_STATIC_ASSERT(ucs_offsetof(ucp_am_partial_t, hdr) ==
+                      ucs_offsetof(ucp_am_partial_t, rdesc) +
+                      sizeof(ucp_recv_desc_t));
+    UCS_STATIC_ASSERT(sizeof(ucp_am_partial_t) ==
+                      ucs_offsetof(ucp_am_partial_t, hdr) + sizeof(ucp_am_hdr_t));
+
+    partial->req          = hdr->req;
+    partial->offset       = recv_len;
+    partial->rdesc.length = hdr->total_len;
+    partial->rdesc.flags  = UCP_RECV_DESC_FLAG_MALLOC;
+    partial->hdr          = hdr->super;
+    memcpy(partial + 1, hdr + 1, recv_len);
+    ucs_list_add_tail(&worker->am.partial, &partial->list);
+    return UCS_OK;
+}
+
+static UCS_F_ALWAYS_INLINE ucs_status_t
+ucp_am_middle_handler_common(ucp_worker_h worker, void *data, size_t length,
+                             int is_last)
+{
+    ucp_am_mid_hdr_t *hdr = data;
+    size_t recv_len       = length - sizeof(*hdr);
+    ucp_am_partial_t *partial;
+    ucs_status_t status;
+
+    ucs_assert(length >= sizeof(*hdr));
+
+    ucs_list_for_each(partial, &worker->am.partial, list) {
+        if ((partial->req.sender_uuid == hdr->req.sender_uuid) &&
+            (partial->req.reqptr == hdr->req.reqptr)) {
+            goto found;
+        }
+    }
+
+    ucs_error("worker %p: no active message from uuid 0x%"PRIx64" request "
+              "0x%lx, dropping fragment", worker, hdr->req.sender_uuid,
+              hdr->req.reqptr);
+    return UCS_OK;
+
+found:
+    ucs_assertv(partial->offset + recv_len <= partial->rdesc.length,
+                "offset=%zu recv_len=%zu total_len=%zu", partial->offset,
+                recv_len, partial->rdesc.length);
+    memcpy((void*)(partial + 1) + partial->offset, hdr + 1, recv_len);
+    partial->offset += recv_len;
+
+    if (!is_last) {
+        return UCS_OK;
+    }
+
+    ucs_assert(partial->offset == partial->rdesc.length);
+    ucs_list_del(&partial->list);
+    status = ucp_am_invoke_handler(worker, partial->hdr.am_id, partial + 1,
+                                   partial->rdesc.length,
+                                   UCP_AM_FLAG_PERSISTENT_DATA);
+    if (status == UCS_OK) {
+        ucs_free(partial);
+    }
+    return UCS_OK;
+}
+
+static ucs_status_t ucp_am_middle_handler(void *arg, void *data, size_t length,
+                                          void *desc)
+{
+    return ucp_am_middle_handler_common(arg, data, length, 0);
+}
+
+static ucs_status_t ucp_am_last_handler(void *arg, void *data, size_t length,
+                                        void *desc)
+{
+    return ucp_am_middle_handler_common(arg, data, length, 1);
+}
+
+static void ucp_am_dump(ucp_worker_h worker, uct_am_trace_type_t type,
+                        uint8_t id, const void *data, size_t length,
+                        char *buffer, size_t max)
+{
+    const ucp_am_first_hdr_t *first_hdr = data;
+    const ucp_am_mid_hdr_t *mid_hdr     = data;
+    const ucp_am_hdr_t *hdr             = data;
+    size_t header_len;
+    char *p;
+
+    switch (id) {
+    case UCP_AM_ID_AM_ONLY:
+        snprintf(buffer, max, "AM id %d", hdr->am_id);
+        header_len = sizeof(*hdr);
+        break;
+    case UCP_AM_ID_AM_FIRST:
+        snprintf(buffer, max, "AM_F id %d len %zu uuid %"PRIx64" request 0x%lx",
+                 first_hdr->super.am_id, first_hdr->total_len,
+                 first_hdr->req.sender_uuid, first_hdr->req.reqptr);
+        header_len = sizeof(*first_hdr);
+        break;
+    case UCP_AM_ID_AM_MIDDLE:
+        snprintf(buffer, max, "AM_M uuid %"PRIx64" request 0x%lx",
+                 mid_hdr->req.sender_uuid, mid_hdr->req.reqptr);
+        header_len = sizeof(*mid_hdr);
+        break;
+    case UCP_AM_ID_AM_LAST:
+        snprintf(buffer, max, "AM_L uuid %"PRIx64" request 0x%lx",
+                 mid_hdr->req.sender_uuid, mid_hdr->req.reqptr);
+        header_len = sizeof(*mid_hdr);
+        break;
+    default:
+        return;
+    }
+
+    p = buffer + strlen(buffer);
+    ucp_dump_payload(worker->context, p, buffer + max - p, data + header_len,
+                     length - header_len);
+}
+
+UCP_DEFINE_AM(UCP_FEATURE_AM, UCP_AM_ID_AM_ONLY, ucp_am_only_handler,
+              ucp_am_dump, UCT_AM_CB_FLAG_SYNC);
+UCP_DEFINE_AM(UCP_FEATURE_AM, UCP_AM_ID_AM_FIRST, ucp_am_first_handler,
+              ucp_am_dump, UCT_AM_CB_FLAG_SYNC);
+UCP_DEFINE_AM(UCP_FEATURE_AM, UCP_AM_ID_AM_MIDDLE, ucp_am_middle_handler,
+              ucp_am_dump, UCT_AM_CB_FLAG_SYNC);
+UCP_DEFINE_AM(UCP_FEATURE_AM, UCP_AM_ID_AM_LAST, ucp_am_last_handler,
+              ucp_am_dump, UCT_AM_CB_FLAG_SYNC);
@@ -0,0 +1,60 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#ifndef UCP_AM_H_
+#define UCP_AM_H_
+
+#include "ucp_request.h"
+
+#include <ucp/proto/proto.h>
+
+
+/*
+ * AM_ONLY
+ */
+typedef struct {
+    uint16_t                  am_id;     /* User active message id */
+    uint16_t                  reserved;
+    uint32_t                  padding;
+} UCS_S_PACKED ucp_am_hdr_t;
+
+
+/*
+ * AM_FIRST
+ */
+typedef struct {
+    ucp_am_hdr_t              super;
+    ucp_request_hdr_t         req;       /* Identifies the message fragments */
+    size_t                    total_len; /* Total length of the message */
+} UCS_S_PACKED ucp_am_first_hdr_t;
+
+
+/*
+ * AM_MIDDLE, AM_LAST
+ */
+typedef struct {
+    ucp_request_hdr_t         req;       /* Same as in the first fragment */
+} UCS_S_PACKED ucp_am_mid_hdr_t;
+
+
+/**
+ * Active message which is being reassembled from fragments. The data follows
+ * the structure, and is passed to the handler in the same way as a single
+ * fragment message in a UCT descriptor: right after a receive descriptor and
+ * an active message header.
+ */
+typedef struct ucp_am_partial {
+    ucs_list_link_t           list;      /* Entry in worker list */
+    ucp_request_hdr_t         req;       /* Sender of the message */
+    size_t                    offset;    /* How much data was received */
+    ucp_recv_desc_t           rdesc;     /* Receive descriptor */
+    ucp_am_hdr_t              hdr;       /* First fragment header */
+} ucp_am_partial_t;
+
+
+void ucp_am_cleanup(ucp_worker_h worker);
+
+#endif
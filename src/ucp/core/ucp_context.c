@@ -89,6 +89,27 @@ static ucs_config_field_t ucp_config_table[] = {
    "the eager_zcopy protocol",
    ucs_offsetof(ucp_config_t, ctx.rndv_perf_diff), UCS_CONFIG_TYPE_DOUBLE},
 
+  {"MAX_RNDV_LANES", "1",
+   "Maximal number of lanes which are used together to transfer the data of a\n"
+   "zero-copy rendezvous message. The message is split between the lanes\n"
+   "proportionally to their bandwidth. Only devices of the memory domain of the\n"
+   "best rendezvous lane are used as additional lanes.",
+   ucs_offsetof(ucp_config_t, ctx.max_rndv_lanes), UCS_CONFIG_TYPE_UINT},
+
+  {"RNDV_FRAG_SIZE", "64k",
+   "Size of the staging buffers used by the pipelined rendezvous protocol. The\n"
+   "actual fragment size is also limited by the zero-copy active message size\n"
+   "of the transport.",
+   ucs_offsetof(ucp_config_t, ctx.rndv_frag_size), UCS_CONFIG_TYPE_MEMUNITS},
+
+  {"RNDV_PIPELINE_DEPTH", "4",
+   "Maximal number of staging buffers in flight for a single pipelined\n"
+   "rendezvous message. The pipelined protocol copies the data of a rendezvous\n"
+   "message to pre-registered buffers and sends them with zero-copy active\n"
+   "messages, while the next fragments are being copied. It is used when the\n"
+   "send buffer is not registered for zero-copy. 0 disables the protocol.",
+   ucs_offsetof(ucp_config_t, ctx.rndv_pipeline_depth), UCS_CONFIG_TYPE_UINT},
+
   {"ZCOPY_THRESH", "auto",
    "Threshold for switching from buffer copy to zero copy protocol",
    ucs_offsetof(ucp_config_t, ctx.zcopy_thresh), UCS_CONFIG_TYPE_MEMUNITS},
@@ -121,6 +142,30 @@ static ucs_config_field_t ucp_config_table[] = {
    "y      - Use mutex for multithreading support in UCP.\n",
    ucs_offsetof(ucp_config_t, ctx.use_mt_mutex), UCS_CONFIG_TYPE_BOOL},
 
+  {"WAKEUP_SPIN_TIME", "10us",
+   "Maximal time to busy-poll for events in ucp_worker_wait() before arming\n"
+   "the wakeup mechanism and blocking. The actual spin time adapts to the\n"
+   "traffic: it is reset to this value when an event is found by polling, and\n"
+   "is reduced every time polling finds nothing. 0 disables polling.",
+   ucs_offsetof(ucp_config_t, ctx.wakeup_spin_time), UCS_CONFIG_TYPE_TIME},
+
+  {"REQUEST_THREAD_CACHE", "32",
+   "Number of requests moved at once between per-thread request caches of a\n"
+   "multi-threaded worker. With thread caches, requests are allocated and\n"
+   "released by application threads without contending on the worker lock.\n"
+   "0 disables the thread caches.",
+   ucs_offsetof(ucp_config_t, ctx.request_thread_cache), UCS_CONFIG_TYPE_UINT},
+
+  {"AMO_AGGREGATE", "0",
+   "Number of entries in a per-worker cache which combines posted atomic\n"
+   "additions to the same remote address, rounded up to a power of 2. The\n"
+   "combined addition is sent as a single atomic operation when the entry is\n"
+   "replaced, on the next worker progress, before a flush or a fence, or when\n"
+   "its remote key is destroyed. Fetching atomics send the pending addition\n"
+   "to their address first.\n"
+   "0 disables the aggregation.",
+   ucs_offsetof(ucp_config_t, ctx.amo_aggregate), UCS_CONFIG_TYPE_UINT},
+
   {NULL}
 };
 
@@ -797,10 +842,6 @@ ucs_status_t ucp_init_version(unsigned api_major_version, unsigned api_minor_ver
         goto err_free_config;
     }
 
-    /* initialize tag matching */
-    ucs_queue_head_init(&context->tag.expected);
-    ucs_queue_head_init(&context->tag.unexpected);
-
     ucs_debug("created ucp context %p [%d mds %d tls] features 0x%lx", context,
               context->num_mds, context->num_tls, context->config.features);
 
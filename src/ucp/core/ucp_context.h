@@ -172,6 +172,11 @@ enum {
                                           rndv (bcopy) */
     UCP_AM_ID_RNDV_DATA_LAST    =  13, /* The last rndv data fragment when using
                                           software rndv (bcopy) */
+
+    UCP_AM_ID_AM_ONLY           =  14, /* Single packet user active message */
+    UCP_AM_ID_AM_FIRST          =  15, /* First user active message fragment */
+    UCP_AM_ID_AM_MIDDLE         =  16, /* Middle user active message fragment */
+    UCP_AM_ID_AM_LAST           =  17, /* Last user active message fragment */
     UCP_AM_ID_LAST
 };
 
@@ -199,6 +204,12 @@ typedef struct ucp_context_config {
     /** The percentage allowed for performance difference between rendezvous
      *  and the eager_zcopy protocol */
     double                                 rndv_perf_diff;
+    /** Maximal number of lanes for zero-copy rendezvous data */
+    unsigned                               max_rndv_lanes;
+    /** Size of staging buffers for pipelined rendezvous */
+    size_t                                 rndv_frag_size;
+    /** Maximal number of in-flight fragments of a pipelined rendezvous */
+    unsigned                               rndv_pipeline_depth;
     /** Threshold for switching UCP to zero copy protocol */
     size_t                                 zcopy_thresh;
     /** Estimation of bcopy bandwidth */
@@ -211,6 +222,12 @@ typedef struct ucp_context_config {
     ucp_atomic_mode_t                      atomic_mode;
     /** If use mutex for MT support or not */
     int                                    use_mt_mutex;
+    /** Maximal time to busy-poll in ucp_worker_wait() before blocking */
+    double                                 wakeup_spin_time;
+    /** Batch size of per-thread request caches in multi-threaded workers */
+    unsigned                               request_thread_cache;
+    /** Number of entries in the cache of posted atomic additions */
+    unsigned                               amo_aggregate;
 } ucp_context_config_t;
 
 
@@ -276,11 +293,6 @@ typedef struct ucp_context {
     ucp_tl_resource_desc_t        *tl_rscs;   /* Array of communication resources */
     ucp_rsc_index_t               num_tls;    /* Number of resources in the array*/
 
-    struct {
-        ucs_queue_head_t          expected;   /* Expected requests */
-        ucs_queue_head_t          unexpected; /* Unexpected received descriptors */
-    } tag;
-
     struct {
 
         /* Bitmap of features supported by the context */
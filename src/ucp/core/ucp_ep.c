@@ -52,10 +52,10 @@ ucs_status_t ucp_ep_new(ucp_worker_h worker, uint64_t dest_uuid,
     key.amo_lane_map     = 0;
     key.reachable_md_map = 0;
     key.am_lane          = UCP_NULL_RESOURCE;
-    key.rndv_lane        = UCP_NULL_RESOURCE;
     key.wireup_msg_lane  = UCP_NULL_LANE;
     key.num_lanes        = 0;
     memset(key.amo_lanes, UCP_NULL_LANE, sizeof(key.amo_lanes));
+    memset(key.rndv_lanes, UCP_NULL_LANE, sizeof(key.rndv_lanes));
 
     ep->worker           = worker;
     ep->dest_uuid        = dest_uuid;
@@ -132,11 +132,12 @@ ucs_status_t ucp_ep_create_stub(ucp_worker_h worker, uint64_t dest_uuid,
     key.amo_lane_map     = 1;
     key.reachable_md_map = 0; /* TODO */
     key.am_lane          = 0;
-    key.rndv_lane        = 0;
     key.wireup_msg_lane  = 0;
     key.lanes[0]         = UCP_NULL_RESOURCE;
     key.num_lanes        = 1;
     memset(key.amo_lanes, UCP_NULL_LANE, sizeof(key.amo_lanes));
+    memset(key.rndv_lanes, UCP_NULL_LANE, sizeof(key.rndv_lanes));
+    key.rndv_lanes[0]    = 0;
 
     ep->cfg_index        = ucp_worker_get_ep_config(worker, &key);
     ep->am_lane          = 0;
@@ -418,6 +419,8 @@ void ucp_ep_destroy_internal(ucp_ep_h ep, const char *message)
 
     ucs_debug("destroy ep %p%s", ep, message);
 
+    ucp_amo_aggr_discard(ep->worker, ep);
+
     for (lane = 0; lane < ucp_ep_num_lanes(ep); ++lane) {
         uct_ep = ep->uct_eps[lane];
         if (uct_ep == NULL) {
@@ -450,12 +453,18 @@ static void ucp_ep_disconnected(ucp_request_t *req)
     ucp_ep_destroy_internal(ep, " from disconnect");
 }
 
-static ucs_status_ptr_t ucp_disconnect_nb_internal(ucp_ep_h ep)
+static ucs_status_ptr_t
+ucp_ep_flush_internal(ucp_ep_h ep, ucp_request_callback_t flushed_cb)
 {
     ucs_status_t status;
     ucp_request_t *req;
 
-    ucs_debug("disconnect ep %p", ep);
+    ucs_debug("flush ep %p", ep);
+
+    status = ucp_amo_aggr_flush(ep->worker, ep);
+    if (status != UCS_OK) {
+        return UCS_STATUS_PTR(status);
+    }
 
     req = ucs_mpool_get(&ep->worker->req_mp);
     if (req == NULL) {
@@ -470,13 +479,15 @@ static ucs_status_ptr_t ucp_disconnect_nb_internal(ucp_ep_h ep)
      * flushed. req->send.flush.lanes keeps track of which lanes we still have
      * to start flush on.
      *  If a flush is completed from a pending/completion callback, we need to
-     * schedule slow-path callback to release the endpoint later, since a UCT
-     * endpoint cannot be released from pending/completion callback context.
+     * schedule slow-path callback to call flushed_cb later, since it may
+     * release the endpoint, and a UCT endpoint cannot be released from
+     * pending/completion callback context.
      */
     req->flags                  = 0;
     req->status                 = UCS_OK;
     req->send.ep                = ep;
-    req->send.flush.flushed_cb  = ucp_ep_disconnected;
+    req->send.cb                = NULL;
+    req->send.flush.flushed_cb  = flushed_cb;
     req->send.flush.lanes       = UCS_MASK(ucp_ep_num_lanes(ep));
     req->send.flush.cbq_elem.cb = ucp_ep_flushed_slow_path_callback;
     req->send.flush.cbq_elem_on = 0;
@@ -489,7 +500,7 @@ static ucs_status_ptr_t ucp_disconnect_nb_internal(ucp_ep_h ep)
 
     if (req->send.uct_comp.count == 0) {
         status = req->status;
-        ucp_ep_disconnected(req);
+        flushed_cb(req);
         ucs_trace_req("ep %p: releasing flush request %p, returning status %s",
                       ep, req, ucs_status_string(status));
         ucs_mpool_put(req);
@@ -501,6 +512,12 @@ static ucs_status_ptr_t ucp_disconnect_nb_internal(ucp_ep_h ep)
     return req + 1;
 }
 
+static ucs_status_ptr_t ucp_disconnect_nb_internal(ucp_ep_h ep)
+{
+    ucs_debug("disconnect ep %p", ep);
+    return ucp_ep_flush_internal(ep, ucp_ep_disconnected);
+}
+
 ucs_status_ptr_t ucp_disconnect_nb(ucp_ep_h ep)
 {
     ucp_worker_h worker = ep->worker;
@@ -517,6 +534,34 @@ ucs_status_ptr_t ucp_disconnect_nb(ucp_ep_h ep)
     return request;
 }
 
+static void ucp_ep_flushed_callback(ucp_request_t *req)
+{
+    /* User callback is set only if the flush was not completed in place */
+    if (req->send.cb != NULL) {
+        req->send.cb(req + 1, req->status);
+    }
+}
+
+ucs_status_ptr_t ucp_ep_flush_nb(ucp_ep_h ep, unsigned flags,
+                                 ucp_send_callback_t cb)
+{
+    ucp_worker_h worker = ep->worker;
+    void *request;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+
+    UCS_ASYNC_BLOCK(&worker->async);
+    request = ucp_ep_flush_internal(ep, ucp_ep_flushed_callback);
+    if (UCS_PTR_IS_PTR(request)) {
+        ((ucp_request_t*)request - 1)->send.cb = cb;
+    }
+    UCS_ASYNC_UNBLOCK(&worker->async);
+
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+
+    return request;
+}
+
 void ucp_ep_destroy(ucp_ep_h ep)
 {
     ucp_worker_h worker = ep->worker;
@@ -555,9 +600,9 @@ int ucp_ep_config_is_equal(const ucp_ep_config_key_t *key1,
         (key1->rma_lane_map     != key2->rma_lane_map) ||
         (key1->amo_lane_map     != key2->amo_lane_map) ||
         memcmp(key1->amo_lanes, key2->amo_lanes, sizeof(key1->amo_lanes)) ||
+        memcmp(key1->rndv_lanes, key2->rndv_lanes, sizeof(key1->rndv_lanes)) ||
         (key1->reachable_md_map != key2->reachable_md_map) ||
         (key1->am_lane          != key2->am_lane) ||
-        (key1->rndv_lane        != key2->rndv_lane) ||
         (key1->wireup_msg_lane  != key2->wireup_msg_lane))
     {
         return 0;
@@ -645,6 +690,39 @@ static void ucp_ep_config_set_am_rndv_thresh(ucp_context_h context, uct_iface_at
     config->rndv.am_thresh = rndv_thresh;
 }
 
+static void ucp_ep_config_set_rndv_lanes(ucp_worker_h worker,
+                                         ucp_ep_config_t *config)
+{
+    double total_bw = 0;
+    uct_iface_attr_t *iface_attr;
+    ucp_rsc_index_t rsc_index;
+    ucp_lane_index_t i;
+
+    for (i = 0; i < UCP_MAX_LANES; ++i) {
+        config->rndv.max_get_zcopy[i] = SIZE_MAX;
+        config->rndv.scale[i]         = 1.0;
+    }
+
+    for (i = 0; (i < UCP_MAX_LANES) &&
+                (config->key.rndv_lanes[i] != UCP_NULL_LANE); ++i) {
+        rsc_index = config->key.lanes[config->key.rndv_lanes[i]];
+        if (rsc_index != UCP_NULL_RESOURCE) {
+            iface_attr                    = &worker->iface_attrs[rsc_index];
+            config->rndv.max_get_zcopy[i] = iface_attr->cap.get.max_zcopy;
+            config->rndv.scale[i]         = iface_attr->bandwidth;
+            total_bw                     += iface_attr->bandwidth;
+        }
+    }
+    config->rndv.num_lanes = i;
+
+    /* Every lane gets a part of the message according to its bandwidth */
+    if (total_bw > 0) {
+        for (i = 0; i < config->rndv.num_lanes; ++i) {
+            config->rndv.scale[i] /= total_bw;
+        }
+    }
+}
+
 void ucp_ep_config_init(ucp_worker_h worker, ucp_ep_config_t *config)
 {
     ucp_context_h context = worker->context;
@@ -663,8 +741,8 @@ void ucp_ep_config_init(ucp_worker_h worker, ucp_ep_config_t *config)
     config->am.zcopy_auto_thresh  = 0;
     config->bcopy_thresh          = context->config.ext.bcopy_thresh;
     config->rndv.rma_thresh       = SIZE_MAX;
-    config->rndv.max_get_zcopy    = SIZE_MAX;
     config->rndv.am_thresh        = SIZE_MAX;
+    config->rndv.num_lanes        = 0;
     config->p2p_lanes             = 0;
 
     /* Collect p2p lanes */
@@ -781,8 +859,9 @@ void ucp_ep_config_init(ucp_worker_h worker, ucp_ep_config_t *config)
     }
 
     /* Configuration for Rendezvous data */
-    if (config->key.rndv_lane != UCP_NULL_LANE) {
-        lane        = config->key.rndv_lane;
+    ucp_ep_config_set_rndv_lanes(worker, config);
+    if (config->key.rndv_lanes[0] != UCP_NULL_LANE) {
+        lane        = config->key.rndv_lanes[0];
         rsc_index   = config->key.lanes[lane];
         if (rsc_index != UCP_NULL_RESOURCE) {
             iface_attr = &worker->iface_attrs[rsc_index];
@@ -806,7 +885,6 @@ void ucp_ep_config_init(ucp_worker_h worker, ucp_ep_config_t *config)
             rndv_thresh                = ucs_max(rndv_thresh,
                                                  iface_attr->cap.get.min_zcopy);
 
-            config->rndv.max_get_zcopy = iface_attr->cap.get.max_zcopy;
             config->rndv.rma_thresh    = rndv_thresh;
         } else {
             ucs_debug("rendezvous (get_zcopy) protocol is not supported ");
@@ -829,6 +907,19 @@ static ucp_lane_index_t ucp_ep_get_amo_lane_index(const ucp_ep_config_key_t *key
     return UCP_NULL_LANE;
 }
 
+int ucp_ep_config_is_rndv_lane(const ucp_ep_config_key_t *key,
+                               ucp_lane_index_t lane)
+{
+    ucp_lane_index_t i;
+
+    for (i = 0; (i < UCP_MAX_LANES) && (key->rndv_lanes[i] != UCP_NULL_LANE); ++i) {
+        if (key->rndv_lanes[i] == lane) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 ucp_md_map_t ucp_ep_config_get_rma_md_map(const ucp_ep_config_key_t *key,
                                           ucp_lane_index_t lane)
 {
@@ -949,7 +1040,7 @@ static void ucp_ep_config_print(FILE *stream, ucp_worker_h worker,
         if (md_map) {
             ucp_ep_config_print_md_map(stream, " amo", md_map);
         }
-        if (lane == config->key.rndv_lane) {
+        if (ucp_ep_config_is_rndv_lane(&config->key, lane)) {
             fprintf(stream, " zcopy_rndv");
         }
         if (lane == config->key.wireup_msg_lane) {
@@ -977,6 +1068,13 @@ static void ucp_ep_config_print(FILE *stream, ucp_worker_h worker,
                                        config->rndv.am_thresh);
      }
 
+     if (context->config.features & UCP_FEATURE_AM) {
+         ucp_ep_config_print_tag_proto(stream, "am_send",
+                                       config->am.max_eager_short,
+                                       config->am.zcopy_thresh[0],
+                                       SIZE_MAX, SIZE_MAX);
+     }
+
      if (context->config.features & UCP_FEATURE_RMA) {
          for (lane = 0; lane < config->key.num_lanes; ++lane) {
              if (!ucp_ep_config_get_rma_md_map(&config->key, lane)) {
@@ -66,8 +66,13 @@ typedef struct ucp_ep_config_key {
      */
     ucp_md_map_t           reachable_md_map;
 
+    /* Lanes for zcopy Rendezvous data, sorted by bandwidth. The first lane is
+     * used for memory registration, and the rest of the lanes use the same
+     * local and remote memory domains. Unused entries are NULL.
+     */
+    ucp_lane_index_t       rndv_lanes[UCP_MAX_LANES];
+
     ucp_lane_index_t       am_lane;             /* Lane for AM (can be NULL) */
-    ucp_lane_index_t       rndv_lane;           /* Lane for zcopy Rendezvous (can be NULL) */
     ucp_lane_index_t       wireup_msg_lane;     /* Lane for wireup messages (can be NULL) */
     ucp_rsc_index_t        lanes[UCP_MAX_LANES];/* Resource index for every lane */
     ucp_lane_index_t       num_lanes;           /* Number of lanes */
@@ -120,8 +125,12 @@ typedef struct ucp_ep_config {
     size_t                 bcopy_thresh;
 
     struct {
-        /* Maximal total size of rndv_get_zcopy */
-        size_t                 max_get_zcopy;
+        /* Maximal size of rndv_get_zcopy, for every rendezvous lane */
+        size_t                 max_get_zcopy[UCP_MAX_LANES];
+        /* Part of the message to send on every rendezvous lane */
+        double                 scale[UCP_MAX_LANES];
+        /* Number of rendezvous lanes */
+        ucp_lane_index_t       num_lanes;
         /* Threshold for switching from eager to RMA based rendezvous */
         size_t                 rma_thresh;
         /* Threshold for switching from eager to AM based rendezvous */
@@ -170,6 +179,9 @@ void ucp_ep_config_init(ucp_worker_h worker, ucp_ep_config_t *config);
 int ucp_ep_config_is_equal(const ucp_ep_config_key_t *key1,
                            const ucp_ep_config_key_t *key2);
 
+int ucp_ep_config_is_rndv_lane(const ucp_ep_config_key_t *key,
+                               ucp_lane_index_t lane);
+
 ucp_md_map_t ucp_ep_config_get_rma_md_map(const ucp_ep_config_key_t *key,
                                           ucp_lane_index_t lane);
 
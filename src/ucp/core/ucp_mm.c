@@ -357,3 +357,52 @@ ucp_mem_advise(ucp_context_h context, ucp_mem_h memh,
     UCP_THREAD_CS_EXIT(&context->mt_lock);
     return status;
 }
+
+static ucs_status_t ucp_reg_mpool_chunk_alloc(ucs_mpool_t *mp, size_t *size_p,
+                                              void **chunk_p)
+{
+    ucp_context_h context = *(ucp_context_h*)ucs_mpool_priv(mp);
+    ucp_mem_map_params_t params;
+    ucp_mem_desc_t *chunk_hdr;
+    ucp_mem_h memh;
+    ucs_status_t status;
+
+    params.field_mask = UCP_MEM_MAP_PARAM_FIELD_ADDRESS |
+                        UCP_MEM_MAP_PARAM_FIELD_LENGTH;
+    params.address    = NULL;
+    params.length     = sizeof(*chunk_hdr) + *size_p;
+
+    status = ucp_mem_map(context, &params, &memh);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    chunk_hdr       = memh->address;
+    chunk_hdr->memh = memh;
+    *size_p         = memh->length - sizeof(*chunk_hdr);
+    *chunk_p        = chunk_hdr + 1;
+    return UCS_OK;
+}
+
+static void ucp_reg_mpool_chunk_release(ucs_mpool_t *mp, void *chunk)
+{
+    ucp_context_h context = *(ucp_context_h*)ucs_mpool_priv(mp);
+    ucp_mem_desc_t *chunk_hdr = chunk - sizeof(*chunk_hdr);
+
+    ucp_mem_unmap(context, chunk_hdr->memh);
+}
+
+static void ucp_reg_mpool_obj_init(ucs_mpool_t *mp, void *obj, void *chunk)
+{
+    ucp_mem_desc_t *elem_hdr  = obj;
+    ucp_mem_desc_t *chunk_hdr = chunk - sizeof(*chunk_hdr);
+
+    elem_hdr->memh = chunk_hdr->memh;
+}
+
+ucs_mpool_ops_t ucp_reg_mpool_ops = {
+    .chunk_alloc   = ucp_reg_mpool_chunk_alloc,
+    .chunk_release = ucp_reg_mpool_chunk_release,
+    .obj_init      = ucp_reg_mpool_obj_init,
+    .obj_cleanup   = NULL
+};
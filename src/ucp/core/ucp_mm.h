@@ -12,6 +12,7 @@
 #include <ucp/core/ucp_ep.h>
 #include <uct/api/uct.h>
 #include <ucs/arch/bitops.h>
+#include <ucs/datastruct/mpool.h>
 #include <ucs/debug/log.h>
 
 #include <inttypes.h>
@@ -25,6 +26,8 @@
  */
 typedef struct ucp_rkey {
     ucp_md_map_t                  md_map;  /* Which *remote* MDs have valid memory handles */
+    ucp_worker_h                  worker;  /* Worker of the endpoint which unpacked the key */
+    unsigned                      amo_aggr_refs; /* Aggregated atomics which use the key */
     uct_rkey_bundle_t             uct[0];  /* Remote key for every MD */
 } ucp_rkey_t;
 
@@ -45,4 +48,33 @@ typedef struct ucp_mem {
 } ucp_mem_t;
 
 
+/**
+ * Header of an element in a memory pool of registered buffers. The buffer
+ * follows the header, and is registered on all memory domains which support
+ * registration, as described by memh.
+ */
+typedef struct ucp_mem_desc {
+    ucp_mem_h                     memh;         /* Memory handle of the chunk */
+} ucp_mem_desc_t;
+
+
+/* Memory pool operations for registered buffers. The pool private area must
+ * hold the ucp context. */
+extern ucs_mpool_ops_t ucp_reg_mpool_ops;
+
+
+/**
+ * @return UCT memory handle of memory domain 'md_index', or
+ *         UCT_INVALID_MEM_HANDLE if the memory is not registered on it.
+ */
+static inline uct_mem_h ucp_memh2uct(ucp_mem_h memh, ucp_rsc_index_t md_index)
+{
+    if (!(memh->md_map & UCS_BIT(md_index))) {
+        return UCT_INVALID_MEM_HANDLE;
+    }
+
+    return memh->uct[ucs_count_one_bits(memh->md_map & UCS_MASK(md_index))];
+}
+
+
 #endif
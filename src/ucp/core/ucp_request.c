@@ -9,6 +9,7 @@
 #include "ucp_request.inl"
 
 #include <ucp/tag/match.h>
+#include <ucp/dt/dt_strided.h>
 #include <ucs/datastruct/mpool.inl>
 #include <ucs/debug/debug.h>
 #include <ucs/debug/log.h>
@@ -44,13 +45,17 @@ void ucp_request_release(void *request)
     ucs_assert(!(req->flags & UCP_REQUEST_FLAG_EXTERNAL));
 
     if ((req->flags |= UCP_REQUEST_FLAG_RELEASED) & UCP_REQUEST_FLAG_COMPLETED) {
-        ucp_worker_h UCS_V_UNUSED worker = ucs_container_of(ucs_mpool_obj_owner(req), ucp_worker_t, req_mp);
-
-        UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+        ucp_worker_h worker = ucs_container_of(ucs_mpool_obj_owner(req), ucp_worker_t, req_mp);
 
         ucs_trace_data("put %p to mpool", req);
-        ucs_mpool_put_inline(req);
+        if (worker->req_mp.mt != NULL) {
+            /* Thread-safe pool, the request goes to this thread's cache */
+            ucs_mpool_put_inline(req);
+            return;
+        }
 
+        UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+        ucs_mpool_put_inline(req);
         UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
     }
 }
@@ -65,12 +70,10 @@ void ucp_request_cancel(ucp_worker_h worker, void *request)
 
     if (req->flags & UCP_REQUEST_FLAG_EXPECTED) {
         UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
-        UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->context->mt_lock);
 
-        ucp_tag_cancel_expected(worker->context, req);
+        ucp_tag_cancel_expected(worker, req);
         ucp_request_complete_recv(req, UCS_ERR_CANCELED, NULL);
 
-        UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->context->mt_lock);
         UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
     }
 }
@@ -116,7 +119,10 @@ int ucp_request_pending_add(ucp_request_t *req, ucs_status_t *req_status)
     uct_ep_h uct_ep;
 
     uct_ep = req->send.ep->uct_eps[req->send.lane];
-    status = uct_ep_pending_add(uct_ep, &req->send.uct);
+    status = uct_ep_pending_add_prio(uct_ep, &req->send.uct,
+                                     (req->flags & UCP_REQUEST_FLAG_CONTROL) ?
+                                     UCT_PENDING_PRIO_CONTROL :
+                                     UCT_PENDING_PRIO_BULK);
     if (status == UCS_OK) {
         ucs_trace_data("ep %p: added pending uct request %p to lane[%d]=%p",
                        req->send.ep, req, req->send.lane, uct_ep);
@@ -221,6 +227,12 @@ ucs_status_t ucp_request_send_buffer_reg(ucp_request_t *req, ucp_lane_index_t la
         }
         state->dt.iov.memh = memh;
         break;
+    case UCP_DATATYPE_STRIDED:
+        status = uct_md_mem_reg(uct_md, (void *)req->send.buffer,
+                                ucp_dt_strided_span(req->send.datatype,
+                                                    req->send.length),
+                                0, &state->dt.strided.memh);
+        break;
     default:
         status = UCS_ERR_INVALID_PARAM;
         ucs_error("Invalid data type %lx", req->send.datatype);
@@ -259,6 +271,11 @@ void ucp_request_send_buffer_dereg(ucp_request_t *req, ucp_lane_index_t lane)
         }
         ucs_free(state->dt.iov.memh);
         break;
+    case UCP_DATATYPE_STRIDED:
+        if (state->dt.strided.memh != UCT_INVALID_MEM_HANDLE) {
+            uct_md_mem_dereg(uct_md, state->dt.strided.memh);
+        }
+        break;
     default:
         ucs_error("Invalid data type");
     }
@@ -14,6 +14,7 @@
 #include <ucp/api/ucp.h>
 #include <uct/api/uct.h>
 #include <ucs/datastruct/mpool.h>
+#include <ucs/datastruct/list_types.h>
 #include <ucs/datastruct/queue_types.h>
 #include <ucp/wireup/wireup.h>
 
@@ -31,7 +32,10 @@ enum {
     UCP_REQUEST_FLAG_EXTERNAL             = UCS_BIT(6),
     UCP_REQUEST_FLAG_RECV                 = UCS_BIT(7),
     UCP_REQUEST_FLAG_SYNC                 = UCS_BIT(8),
-    UCP_REQUEST_FLAG_RNDV                 = UCS_BIT(9)
+    UCP_REQUEST_FLAG_RNDV                 = UCS_BIT(9),
+    UCP_REQUEST_FLAG_CONTROL              = UCS_BIT(10) /* Protocol control message,
+                                                           sent ahead of pending
+                                                           data on the same lane */
 };
 
 
@@ -39,11 +43,12 @@ enum {
  * Receive descriptor flags.
  */
 enum {
-    UCP_RECV_DESC_FLAG_FIRST = UCS_BIT(0),
-    UCP_RECV_DESC_FLAG_LAST  = UCS_BIT(1),
-    UCP_RECV_DESC_FLAG_EAGER = UCS_BIT(2),
-    UCP_RECV_DESC_FLAG_SYNC  = UCS_BIT(3),
-    UCP_RECV_DESC_FLAG_RNDV  = UCS_BIT(4),
+    UCP_RECV_DESC_FLAG_FIRST  = UCS_BIT(0),
+    UCP_RECV_DESC_FLAG_LAST   = UCS_BIT(1),
+    UCP_RECV_DESC_FLAG_EAGER  = UCS_BIT(2),
+    UCP_RECV_DESC_FLAG_SYNC   = UCS_BIT(3),
+    UCP_RECV_DESC_FLAG_RNDV   = UCS_BIT(4),
+    UCP_RECV_DESC_FLAG_MALLOC = UCS_BIT(5)  /* Allocated by UCP, not by UCT */
 };
 
 
@@ -66,6 +71,9 @@ typedef struct ucp_frag_state {
         struct {
             void                  *state;
         } generic;
+        struct {
+            uct_mem_h             memh;           /* Covers the span of the data */
+        } strided;
     } dt;
 } ucp_frag_state_t;
 
@@ -87,6 +95,7 @@ struct ucp_request {
 
             union {
                 ucp_tag_t         tag;      /* Tagged send */
+                uint16_t          am_id;    /* Active message send */
                 ucp_wireup_msg_t  wireup;
 
                 struct {
@@ -111,14 +120,34 @@ struct ucp_request {
                     uintptr_t     remote_request; /* pointer to the sender's send request */
                     uct_rkey_bundle_t rkey_bundle;
                     ucp_request_t *rreq;    /* receive request on the recv side */
+                    ucp_lane_index_t lane_idx; /* Index of the next rendezvous lane */
+                    struct ucp_rndv_get_iov *remote_iov; /* sender's IOV entries, or NULL
+                                                            if its buffer is contiguous */
+                    size_t        remote_iovcnt; /* Number of sender's IOV entries */
+                    size_t        remote_iov_index;  /* Current sender's IOV entry */
+                    size_t        remote_iov_offset; /* Offset in the current entry */
                 } rndv_get;
 
+                struct {
+                    uintptr_t     rreq_ptr; /* receive request ptr on the recv side */
+                    void          *frag;    /* Packed fragment which was not sent yet */
+                    unsigned      num_inflight; /* Number of fragments in flight */
+                    uint8_t       waiting;  /* Whether waiting for a free slot */
+                    ucs_callbackq_slow_elem_t cbq_elem; /* Resumes the send when
+                                                           a slot is freed */
+                } rndv_pipeline;
+
                 struct {
                     ucp_request_callback_t    flushed_cb;/* Called when flushed */
                     ucs_callbackq_slow_elem_t cbq_elem;  /* Slow-path callback */
                     uint8_t                   cbq_elem_on;
                     ucp_lane_map_t            lanes;     /* Which lanes need to be flushed */
                 } flush;
+                struct {
+                    ucp_worker_h              worker;    /* Worker to flush */
+                    ucs_callbackq_slow_elem_t cbq_elem;  /* Slow-path progress */
+                    ucp_rsc_index_t           rsc_index; /* Next interface to flush */
+                } flush_worker;
                 struct {
                     uint64_t              remote_addr; /* Remote address */
                     ucp_atomic_fetch_op_t op; /* Requested AMO */
@@ -141,6 +170,7 @@ struct ucp_request {
             size_t                count;    /* Receive count */
             ucp_tag_t             tag;      /* Expected tag */
             ucp_tag_t             tag_mask; /* Expected tag mask */
+            uint64_t              sn;       /* Tag match sequence */
             ucp_tag_recv_callback_t cb;     /* Completion callback */
             ucp_tag_recv_info_t   info;     /* Completion info to fill */
             ucp_frag_state_t      state;
@@ -153,7 +183,7 @@ struct ucp_request {
  * Unexpected receive descriptor.
  */
 typedef struct ucp_recv_desc {
-    ucs_queue_elem_t              queue;    /* Queue element */
+    ucs_list_link_t               tag_list[2]; /* Hash list and all-list */
     size_t                        length;   /* Received length */
     uint16_t                      hdr_len;  /* Header size */
     uint16_t                      flags;    /* Flags */
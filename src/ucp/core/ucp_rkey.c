@@ -8,6 +8,8 @@
 #include "ucp_request.h"
 #include "ucp_ep.inl"
 
+#include <ucp/amo/amo_aggr.h>
+
 #include <inttypes.h>
 
 
@@ -146,9 +148,11 @@ ucs_status_t ucp_ep_rkey_unpack(ucp_ep_h ep, void *rkey_buffer, ucp_rkey_h *rkey
         goto err;
     }
 
-    rkey->md_map    = 0;
-    remote_md_index = 0; /* Index of remote MD */
-    rkey_index      = 0; /* Index of the rkey in the array */
+    rkey->md_map        = 0;
+    rkey->worker        = ep->worker;
+    rkey->amo_aggr_refs = 0;
+    remote_md_index     = 0; /* Index of remote MD */
+    rkey_index          = 0; /* Index of the rkey in the array */
 
     /* Unpack rkey of each UCT MD */
     while (md_map > 0) {
@@ -212,6 +216,11 @@ void ucp_rkey_destroy(ucp_rkey_h rkey)
         return;
     }
 
+    if (rkey->amo_aggr_refs > 0) {
+        /* Aggregated atomic additions still refer to the key */
+        ucp_amo_aggr_flush_rkey(rkey);
+    }
+
     num_rkeys = ucs_count_one_bits(rkey->md_map);
 
     for (i = 0; i < num_rkeys; ++i) {
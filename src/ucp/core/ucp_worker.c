@@ -7,10 +7,12 @@
 
 #include "ucp_worker.h"
 #include "ucp_request.inl"
+#include "ucp_am.h"
 
 #include <ucp/wireup/address.h>
 #include <ucp/wireup/stub_ep.h>
 #include <ucp/tag/eager.h>
+#include <ucp/tag/rndv.h>
 #include <ucs/datastruct/mpool.inl>
 #include <ucs/type/cpu_set.h>
 
@@ -120,11 +122,12 @@ static void ucp_worker_am_tracer(void *arg, uct_am_trace_type_t type,
 }
 
 static ucs_status_t ucp_worker_wakeup_context_init(ucp_worker_wakeup_t *wakeup,
-                                                   ucp_rsc_index_t num_tls)
+                                                   ucp_context_h context)
 {
     ucs_status_t status;
 
-    wakeup->iface_wakeups = ucs_calloc(num_tls, sizeof(*wakeup->iface_wakeups),
+    wakeup->iface_wakeups = ucs_calloc(context->num_tls,
+                                       sizeof(*wakeup->iface_wakeups),
                                        "ucp iface_wakeups");
     if (wakeup->iface_wakeups == NULL) {
         return UCS_ERR_NO_MEMORY;
@@ -148,7 +151,9 @@ static ucs_status_t ucp_worker_wakeup_context_init(ucp_worker_wakeup_t *wakeup,
         return status;
     }
 
-    wakeup->wakeup_efd = -1;
+    wakeup->wakeup_efd    = -1;
+    wakeup->max_spin_time = ucs_time_from_sec(context->config.ext.wakeup_spin_time);
+    wakeup->spin_time     = wakeup->max_spin_time;
     return UCS_OK;
 
 pipe_cleanup:
@@ -500,6 +505,7 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
     worker->ep_config_max   = config_count;
     worker->ep_config_count = 0;
     ucs_list_head_init(&worker->stub_ep_list);
+    ucs_list_head_init(&worker->am.partial);
 
     name_length = ucs_min(UCP_WORKER_NAME_MAX,
                           context->config.ext.max_worker_name + 1);
@@ -508,11 +514,22 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
 
     kh_init_inplace(ucp_worker_ep_hash, &worker->ep_hash);
 
+    /* Initialize tag matching */
+    status = ucp_tag_match_init(&worker->tm);
+    if (status != UCS_OK) {
+        goto err_free;
+    }
+
+    status = ucp_amo_aggr_init(worker);
+    if (status != UCS_OK) {
+        goto err_tag_match_cleanup;
+    }
+
     worker->ifaces = ucs_calloc(context->num_tls, sizeof(*worker->ifaces),
                                 "ucp iface");
     if (worker->ifaces == NULL) {
         status = UCS_ERR_NO_MEMORY;
-        goto err_free;
+        goto err_amo_aggr_cleanup;
     }
 
     worker->iface_attrs = ucs_calloc(context->num_tls,
@@ -529,7 +546,7 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
         goto err_free_attrs;
     }
 
-    status = ucp_worker_wakeup_context_init(&worker->wakeup, context->num_tls);
+    status = ucp_worker_wakeup_context_init(&worker->wakeup, context);
     if (status != UCS_OK) {
         goto err_free_stats;
     }
@@ -554,6 +571,27 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
         goto err_destroy_uct_worker;
     }
 
+    /* Let application threads release requests without taking the worker lock */
+    if ((thread_mode == UCS_THREAD_MODE_MULTI) &&
+        (context->config.ext.request_thread_cache > 0)) {
+        status = ucs_mpool_set_thread_safe(&worker->req_mp,
+                                           context->config.ext.request_thread_cache);
+        if (status != UCS_OK) {
+            goto err_req_mp_cleanup;
+        }
+    }
+
+    /* Create memory pool of registered staging buffers for rendezvous */
+    status = ucs_mpool_init(&worker->rndv_frag_mp, sizeof(ucp_context_h),
+                            sizeof(ucp_rndv_frag_t) + context->config.ext.rndv_frag_size,
+                            0, UCS_SYS_CACHE_LINE_SIZE,
+                            ucs_max(context->config.ext.rndv_pipeline_depth, 1),
+                            UINT_MAX, &ucp_reg_mpool_ops, "ucp_rndv_frags");
+    if (status != UCS_OK) {
+        goto err_req_mp_cleanup;
+    }
+    *(ucp_context_h*)ucs_mpool_priv(&worker->rndv_frag_mp) = context;
+
     /* Open all resources as interfaces on this worker */
     for (tl_id = 0; tl_id < context->num_tls; ++tl_id) {
         if (params->field_mask & UCP_WORKER_PARAM_FIELD_CPU_MASK) {
@@ -575,6 +613,8 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
 
 err_close_ifaces:
     ucp_worker_close_ifaces(worker);
+    ucs_mpool_cleanup(&worker->rndv_frag_mp, 1);
+err_req_mp_cleanup:
     ucs_mpool_cleanup(&worker->req_mp, 1);
 err_destroy_uct_worker:
     uct_worker_destroy(worker->uct);
@@ -588,6 +628,10 @@ err_free_attrs:
     ucs_free(worker->iface_attrs);
 err_free_ifaces:
     ucs_free(worker->ifaces);
+err_amo_aggr_cleanup:
+    ucp_amo_aggr_cleanup(worker);
+err_tag_match_cleanup:
+    ucp_tag_match_cleanup(&worker->tm);
 err_free:
     UCP_THREAD_LOCK_FINALIZE_CONDITIONAL(&worker->mt_lock);
     ucs_free(worker);
@@ -609,12 +653,16 @@ void ucp_worker_destroy(ucp_worker_h worker)
     ucp_worker_remove_am_handlers(worker);
     ucp_worker_destroy_eps(worker);
     ucp_worker_close_ifaces(worker);
+    ucs_mpool_cleanup(&worker->rndv_frag_mp, 1);
     ucs_mpool_cleanup(&worker->req_mp, 1);
     uct_worker_destroy(worker->uct);
     ucs_async_context_cleanup(&worker->async);
     ucp_worker_wakeup_context_cleanup(&worker->wakeup);
     ucs_free(worker->iface_attrs);
     ucs_free(worker->ifaces);
+    ucp_amo_aggr_cleanup(worker);
+    ucp_tag_match_cleanup(&worker->tm);
+    ucp_am_cleanup(worker);
     kh_destroy_inplace(ucp_worker_ep_hash, &worker->ep_hash);
     UCP_THREAD_LOCK_FINALIZE_CONDITIONAL(&worker->mt_lock);
     UCS_STATS_NODE_FREE(worker->stats);
@@ -635,21 +683,25 @@ ucs_status_t ucp_worker_query(ucp_worker_h worker,
     return UCS_OK;
 }
 
-void ucp_worker_progress(ucp_worker_h worker)
+unsigned ucp_worker_progress(ucp_worker_h worker)
 {
+    unsigned count;
+
     /* worker->inprogress is used only for assertion check.
      * coverity[assert_side_effect]
      */
     UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
 
     ucs_assert(worker->inprogress++ == 0);
-    uct_worker_progress(worker->uct);
+    count = uct_worker_progress(worker->uct);
     ucs_async_check_miss(&worker->async);
 
     /* coverity[assert_side_effect] */
     ucs_assert(--worker->inprogress == 0);
 
     UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+
+    return count;
 }
 
 ucs_status_t ucp_worker_get_efd(ucp_worker_h worker, int *fd)
@@ -738,6 +790,35 @@ ucs_status_t ucp_worker_arm(ucp_worker_h worker)
     return UCS_OK;
 }
 
+/*
+ * Busy-poll the worker for up to the current spin time. Returns nonzero if
+ * any event was processed. The spin time is restored to the maximum when
+ * polling pays off, and halved (down to a 1/16 of the maximum) when it does
+ * not, so bursty traffic is served by polling while idle periods quickly
+ * fall back to blocking.
+ */
+static int ucp_worker_wait_spin(ucp_worker_h worker)
+{
+    ucp_worker_wakeup_t *wakeup = &worker->wakeup;
+    ucs_time_t deadline;
+
+    if (wakeup->spin_time == 0) {
+        return 0;
+    }
+
+    deadline = ucs_get_time() + wakeup->spin_time;
+    do {
+        if (ucp_worker_progress(worker) > 0) {
+            wakeup->spin_time = wakeup->max_spin_time;
+            return 1;
+        }
+    } while (ucs_get_time() < deadline);
+
+    wakeup->spin_time = ucs_max(wakeup->spin_time / 2,
+                                wakeup->max_spin_time / 16);
+    return 0;
+}
+
 ucs_status_t ucp_worker_wait(ucp_worker_h worker)
 {
     int res;
@@ -748,6 +829,11 @@ ucs_status_t ucp_worker_wait(ucp_worker_h worker)
 
     UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
 
+    if (ucp_worker_wait_spin(worker)) {
+        status = UCS_OK;
+        goto out;
+    }
+
     status = ucp_worker_get_efd(worker, &epoll_fd);
     if (status != UCS_OK) {
         goto out;
@@ -864,10 +950,11 @@ ucp_request_t *ucp_worker_allocate_reply(ucp_worker_h worker, uint64_t dest_uuid
     return req;
 }
 
-void ucp_worker_progress_stub_eps(void *arg)
+unsigned ucp_worker_progress_stub_eps(void *arg)
 {
     ucp_worker_h worker = arg;
     ucp_stub_ep_t *stub_ep, *tmp;
+    unsigned count = 0;
 
     /*
      * We switch the endpoint in this function (instead in wireup code) since
@@ -880,9 +967,10 @@ void ucp_worker_progress_stub_eps(void *arg)
 
     UCS_ASYNC_BLOCK(&worker->async);
     ucs_list_for_each_safe(stub_ep, tmp, &worker->stub_ep_list, list) {
-        ucp_stub_ep_progress(stub_ep);
+        count += ucp_stub_ep_progress(stub_ep);
     }
     UCS_ASYNC_UNBLOCK(&worker->async);
+    return count;
 }
 
 void ucp_worker_stub_ep_add(ucp_worker_h worker, ucp_stub_ep_t *stub_ep)
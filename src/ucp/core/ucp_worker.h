@@ -10,6 +10,9 @@
 
 #include "ucp_ep.h"
 
+#include <ucp/amo/amo_aggr.h>
+#include <ucp/tag/tag_match.h>
+
 #include <ucs/datastruct/mpool.h>
 #include <ucs/datastruct/khash.h>
 #include <ucs/async/async.h>
@@ -74,9 +77,21 @@ typedef struct ucp_worker_wakeup {
     int                           wakeup_efd;     /* Allocated (on-demand) epoll fd for wakeup */
     int                           wakeup_pipe[2]; /* Pipe to support signal() calls */
     uct_wakeup_h                  *iface_wakeups; /* Array of interface wake-up handles */
+    ucs_time_t                    max_spin_time;  /* Configured polling time before blocking */
+    ucs_time_t                    spin_time;      /* Current adaptive polling time */
 } ucp_worker_wakeup_t;
 
 
+/**
+ * User active message handler.
+ */
+typedef struct ucp_worker_am_entry {
+    ucp_am_callback_t             cb;       /* Handler callback, or NULL */
+    void                          *arg;     /* Handler argument */
+    uint32_t                      flags;    /* Handler flags (UCP_AM_FLAG_xx) */
+} ucp_worker_am_entry_t;
+
+
 /**
  * UCP worker (thread context).
  */
@@ -86,8 +101,17 @@ typedef struct ucp_worker {
     uint64_t                      uuid;          /* Unique ID for wireup */
     uct_worker_h                  uct;           /* UCT worker handle */
     ucs_mpool_t                   req_mp;        /* Memory pool for requests */
+    ucs_mpool_t                   rndv_frag_mp;  /* Staging buffers for pipelined rndv */
     ucp_worker_wakeup_t           wakeup;        /* Wakeup-related context */
     uint64_t                      atomic_tls;    /* Which resources can be used for atomics */
+    ucp_tag_match_t               tm;            /* Tag matching queues */
+    ucp_amo_aggr_t                amo_aggr;      /* Posted atomics being combined */
+
+    struct {
+        ucp_worker_am_entry_t     *handlers;     /* User active message handlers, by id */
+        unsigned                  num_handlers;  /* Size of the handlers array */
+        ucs_list_link_t           partial;       /* Messages being reassembled */
+    } am;
 
     int                           inprogress;
     char                          name[UCP_WORKER_NAME_MAX]; /* Worker name */
@@ -113,7 +137,7 @@ ucp_request_t *ucp_worker_allocate_reply(ucp_worker_h worker, uint64_t dest_uuid
 unsigned ucp_worker_get_ep_config(ucp_worker_h worker,
                                   const ucp_ep_config_key_t *key);
 
-void ucp_worker_progress_stub_eps(void *arg);
+unsigned ucp_worker_progress_stub_eps(void *arg);
 
 void ucp_worker_stub_ep_add(ucp_worker_h worker, ucp_stub_ep_t *stub_ep);
 
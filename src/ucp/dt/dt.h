@@ -11,6 +11,7 @@
 #include <ucp/dt/dt_contig.h>
 #include <ucp/dt/dt_iov.h>
 #include <ucp/dt/dt_generic.h>
+#include <ucp/dt/dt_strided.h>
 #include <ucp/core/ucp_request.h>
 
 
@@ -31,6 +32,9 @@ size_t ucp_dt_length(ucp_datatype_t datatype, size_t count,
         ucs_assert(NULL != iov);
         return ucp_dt_iov_length(iov, count);
 
+    case UCP_DATATYPE_STRIDED:
+        return ucp_dt_strided_length(datatype, count);
+
     case UCP_DATATYPE_GENERIC:
         dt_gen = ucp_dt_generic(datatype);
         ucs_assert(NULL != state);
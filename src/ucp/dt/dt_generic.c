@@ -5,6 +5,7 @@
  */
 
 #include "dt_generic.h"
+#include "dt_strided.h"
 
 #include <ucs/debug/memtrack.h>
 
@@ -36,6 +37,9 @@ void ucp_dt_destroy(ucp_datatype_t datatype)
         dt = ucp_dt_generic(datatype);
         ucs_free(dt);
         break;
+    case UCP_DATATYPE_STRIDED:
+        ucs_free(ucp_dt_strided(datatype));
+        break;
     default:
         break;
     }
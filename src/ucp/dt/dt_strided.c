@@ -0,0 +1,342 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#include "dt_strided.h"
+#include "dt_contig.h"
+
+#include <ucs/debug/log.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/math.h>
+#include <string.h>
+
+
+/*
+ * Position in data of strided datatype
+ */
+typedef struct {
+    char                     *item;   /* Address of the current item */
+    size_t                   idx[UCP_DT_STRIDED_MAX_DIMS]; /* Index in every dimension */
+    size_t                   block_offset; /* Offset in the current block */
+} ucp_dt_strided_pos_t;
+
+
+static void ucp_dt_strided_remove_dim(ucp_dt_strided_t *dt, unsigned dim)
+{
+    memmove(&dt->dims[dim], &dt->dims[dim + 1],
+            (dt->num_dims - dim - 1) * sizeof(dt->dims[0]));
+    --dt->num_dims;
+}
+
+/*
+ * Merge the dimensions which do not need a separate index: the ones with a
+ * single element, the innermost ones which continue the contiguous block, and
+ * the ones whose elements are laid out back to back with the next dimension.
+ */
+static void ucp_dt_strided_normalize(ucp_dt_strided_t *dt)
+{
+    unsigned dim;
+
+    dim = 0;
+    while (dim < dt->num_dims) {
+        if (dt->dims[dim].count == 1) {
+            ucp_dt_strided_remove_dim(dt, dim);
+        } else {
+            ++dim;
+        }
+    }
+
+    dim = 0;
+    while (dim + 1 < dt->num_dims) {
+        if (dt->dims[dim].stride ==
+            dt->dims[dim + 1].count * dt->dims[dim + 1].stride) {
+            dt->dims[dim + 1].count *= dt->dims[dim].count;
+            ucp_dt_strided_remove_dim(dt, dim);
+        } else {
+            ++dim;
+        }
+    }
+
+    while ((dt->num_dims > 0) &&
+           (dt->dims[dt->num_dims - 1].stride == dt->block)) {
+        dt->block *= dt->dims[dt->num_dims - 1].count;
+        --dt->num_dims;
+    }
+
+    if (dt->num_dims == 0) {
+        /* the datatype is contiguous, keep a dimension to avoid special cases */
+        dt->dims[0].count  = 1;
+        dt->dims[0].stride = dt->block;
+        dt->num_dims       = 1;
+    }
+}
+
+ucs_status_t ucp_dt_create_strided(size_t count, size_t blocklength,
+                                   size_t stride, ucp_datatype_t elem_datatype,
+                                   ucp_datatype_t *datatype_p)
+{
+    const ucp_dt_strided_t *elem_dt;
+    ucp_dt_strided_t *dt;
+    size_t elem_size;
+
+    if ((count == 0) || (blocklength == 0)) {
+        ucs_error("invalid strided datatype count %zu blocklength %zu",
+                  count, blocklength);
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    dt = ucs_memalign(UCS_BIT(UCP_DATATYPE_SHIFT), sizeof(*dt), "strided_dt");
+    if (dt == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    switch (elem_datatype & UCP_DATATYPE_CLASS_MASK) {
+    case UCP_DATATYPE_CONTIG:
+        elem_size = ucp_contig_dt_elem_size(elem_datatype);
+        if (elem_size == 0) {
+            ucs_error("invalid strided datatype element size 0");
+            goto err_free;
+        }
+
+        dt->block          = blocklength * elem_size;
+        dt->size           = count * dt->block;
+        dt->extent         = ((count - 1) * stride) + dt->block;
+        dt->num_dims       = 1;
+        dt->dims[0].count  = count;
+        dt->dims[0].stride = stride;
+        break;
+    case UCP_DATATYPE_STRIDED:
+        elem_dt = ucp_dt_strided(elem_datatype);
+        if (elem_dt->num_dims + 2 > UCP_DT_STRIDED_MAX_DIMS) {
+            ucs_error("strided datatype nesting is too deep");
+            ucs_free(dt);
+            return UCS_ERR_UNSUPPORTED;
+        }
+
+        dt->block          = elem_dt->block;
+        dt->size           = count * blocklength * elem_dt->size;
+        dt->extent         = ((count - 1) * stride) + (blocklength * elem_dt->extent);
+        dt->num_dims       = elem_dt->num_dims + 2;
+        dt->dims[0].count  = count;
+        dt->dims[0].stride = stride;
+        dt->dims[1].count  = blocklength;
+        dt->dims[1].stride = elem_dt->extent;
+        memcpy(&dt->dims[2], elem_dt->dims,
+               elem_dt->num_dims * sizeof(dt->dims[0]));
+        break;
+    default:
+        ucs_error("strided datatype element must be contiguous or strided");
+        goto err_free;
+    }
+
+    ucp_dt_strided_normalize(dt);
+
+    ucs_debug("created strided datatype %p: block %zu size %zu extent %zu dims %u",
+              dt, dt->block, dt->size, dt->extent, dt->num_dims);
+    *datatype_p = ((uintptr_t)dt) | UCP_DATATYPE_STRIDED;
+    return UCS_OK;
+
+err_free:
+    ucs_free(dt);
+    return UCS_ERR_INVALID_PARAM;
+}
+
+static void ucp_dt_strided_pos_init(ucp_dt_strided_pos_t *pos,
+                                    const ucp_dt_strided_t *dt,
+                                    const void *buffer, size_t offset)
+{
+    size_t item, block;
+    unsigned dim;
+
+    item              = offset / dt->size;
+    offset           -= item * dt->size;
+    block             = offset / dt->block;
+    pos->block_offset = offset - (block * dt->block);
+    pos->item         = (char*)buffer + (item * dt->extent);
+
+    for (dim = dt->num_dims; dim-- > 0; ) {
+        pos->idx[dim] = block % dt->dims[dim].count;
+        block        /= dt->dims[dim].count;
+    }
+}
+
+static UCS_F_ALWAYS_INLINE char*
+ucp_dt_strided_pos_block(const ucp_dt_strided_pos_t *pos,
+                         const ucp_dt_strided_t *dt)
+{
+    char *ptr = pos->item;
+    unsigned dim;
+
+    for (dim = 0; dim < dt->num_dims; ++dim) {
+        ptr += pos->idx[dim] * dt->dims[dim].stride;
+    }
+    return ptr;
+}
+
+/* Advance by a number of blocks which does not exceed the innermost dimension */
+static UCS_F_ALWAYS_INLINE void
+ucp_dt_strided_pos_advance(ucp_dt_strided_pos_t *pos, const ucp_dt_strided_t *dt,
+                           size_t num_blocks)
+{
+    unsigned dim = dt->num_dims - 1;
+
+    pos->idx[dim] += num_blocks;
+    while (pos->idx[dim] == dt->dims[dim].count) {
+        pos->idx[dim] = 0;
+        if (dim == 0) {
+            pos->item += dt->extent;
+            break;
+        }
+        ++pos->idx[--dim];
+    }
+}
+
+#define UCP_DT_STRIDED_COPY_BLOCKS(_dst, _dst_stride, _src, _src_stride, \
+                                   _block, _count) \
+    { \
+        size_t _i; \
+        for (_i = 0; _i < (_count); ++_i) { \
+            memcpy((_dst) + (_i * (_dst_stride)), (_src) + (_i * (_src_stride)), \
+                   (_block)); \
+        } \
+    }
+
+/*
+ * Copy blocks of the innermost dimension. Common block sizes have a constant
+ * length, so the compiler emits plain (vector) loads and stores instead of a
+ * memcpy call per block.
+ */
+static UCS_F_ALWAYS_INLINE void
+ucp_dt_strided_copy_blocks(char *dst, size_t dst_stride, const char *src,
+                           size_t src_stride, size_t block, size_t count)
+{
+    switch (block) {
+    case 4:
+        UCP_DT_STRIDED_COPY_BLOCKS(dst, dst_stride, src, src_stride, 4, count);
+        break;
+    case 8:
+        UCP_DT_STRIDED_COPY_BLOCKS(dst, dst_stride, src, src_stride, 8, count);
+        break;
+    case 16:
+        UCP_DT_STRIDED_COPY_BLOCKS(dst, dst_stride, src, src_stride, 16, count);
+        break;
+    case 32:
+        UCP_DT_STRIDED_COPY_BLOCKS(dst, dst_stride, src, src_stride, 32, count);
+        break;
+    case 64:
+        UCP_DT_STRIDED_COPY_BLOCKS(dst, dst_stride, src, src_stride, 64, count);
+        break;
+    default:
+        UCP_DT_STRIDED_COPY_BLOCKS(dst, dst_stride, src, src_stride, block, count);
+        break;
+    }
+}
+
+static UCS_F_ALWAYS_INLINE void
+ucp_dt_strided_copy(char *packed, void *buffer, ucp_datatype_t datatype,
+                    size_t offset, size_t length, int is_pack)
+{
+    const ucp_dt_strided_t *dt = ucp_dt_strided(datatype);
+    size_t inner_count         = dt->dims[dt->num_dims - 1].count;
+    size_t inner_stride        = dt->dims[dt->num_dims - 1].stride;
+    ucp_dt_strided_pos_t pos;
+    size_t num_blocks, copy_len;
+    char *ptr;
+
+    ucp_dt_strided_pos_init(&pos, dt, buffer, offset);
+
+    while (length > 0) {
+        ptr = ucp_dt_strided_pos_block(&pos, dt);
+
+        if ((pos.block_offset > 0) || (length < dt->block)) {
+            /* part of a block */
+            copy_len = ucs_min(dt->block - pos.block_offset, length);
+            if (is_pack) {
+                memcpy(packed, ptr + pos.block_offset, copy_len);
+            } else {
+                memcpy(ptr + pos.block_offset, packed, copy_len);
+            }
+
+            pos.block_offset += copy_len;
+            if (pos.block_offset == dt->block) {
+                pos.block_offset = 0;
+                ucp_dt_strided_pos_advance(&pos, dt, 1);
+            }
+        } else {
+            /* whole blocks, up to the end of the innermost dimension */
+            num_blocks = ucs_min(inner_count - pos.idx[dt->num_dims - 1],
+                                 length / dt->block);
+            copy_len   = num_blocks * dt->block;
+            if (is_pack) {
+                ucp_dt_strided_copy_blocks(packed, dt->block, ptr, inner_stride,
+                                           dt->block, num_blocks);
+            } else {
+                ucp_dt_strided_copy_blocks(ptr, inner_stride, packed, dt->block,
+                                           dt->block, num_blocks);
+            }
+            ucp_dt_strided_pos_advance(&pos, dt, num_blocks);
+        }
+
+        packed += copy_len;
+        length -= copy_len;
+    }
+}
+
+void ucp_dt_strided_gather(void *dest, const void *src, ucp_datatype_t datatype,
+                           size_t offset, size_t length)
+{
+    ucp_dt_strided_copy(dest, (void*)src, datatype, offset, length, 1);
+}
+
+void ucp_dt_strided_scatter(void *dest, const void *src, ucp_datatype_t datatype,
+                            size_t offset, size_t length)
+{
+    ucp_dt_strided_copy((void*)src, dest, datatype, offset, length, 0);
+}
+
+size_t ucp_dt_strided_to_uct_iov(uct_iov_t *iov, size_t *iovcnt, size_t max_iov,
+                                 const void *buffer, ucp_datatype_t datatype,
+                                 uct_mem_h memh, size_t offset, size_t length_max)
+{
+    const ucp_dt_strided_t *dt = ucp_dt_strided(datatype);
+    size_t length_it           = 0;
+    ucp_dt_strided_pos_t pos;
+    size_t iov_it;
+
+    ucp_dt_strided_pos_init(&pos, dt, buffer, offset);
+
+    for (iov_it = 0; (iov_it < max_iov) && (length_it < length_max); ++iov_it) {
+        iov[iov_it].buffer = ucp_dt_strided_pos_block(&pos, dt) + pos.block_offset;
+        iov[iov_it].length = ucs_min(dt->block - pos.block_offset,
+                                     length_max - length_it);
+        iov[iov_it].memh   = memh;
+        iov[iov_it].stride = 0;
+        iov[iov_it].count  = 1;
+        length_it         += iov[iov_it].length;
+
+        pos.block_offset   = 0;
+        ucp_dt_strided_pos_advance(&pos, dt, 1);
+    }
+
+    *iovcnt = iov_it;
+    return length_it;
+}
+
+size_t ucp_dt_strided_num_blocks(ucp_datatype_t datatype, size_t offset,
+                                 size_t length)
+{
+    const ucp_dt_strided_t *dt = ucp_dt_strided(datatype);
+    size_t first_block, last_block;
+
+    if (length == 0) {
+        return 0;
+    }
+
+    /* blocks do not cross item boundaries, since the item size is a multiple
+     * of the block size */
+    first_block = offset / dt->block;
+    last_block  = (offset + length - 1) / dt->block;
+    return last_block - first_block + 1;
+}
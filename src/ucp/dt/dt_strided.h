@@ -0,0 +1,124 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+
+#ifndef UCP_DT_STRIDED_H_
+#define UCP_DT_STRIDED_H_
+
+#include <ucp/api/ucp.h>
+#include <uct/api/uct.h>
+
+
+#define UCP_DT_STRIDED_MAX_DIMS   8
+
+
+/**
+ * Strided datatype structure.
+ *
+ * A strided datatype, including a nested one, is flattened to a set of
+ * dimensions over a contiguous block. The data of a single item is the
+ * sequence of blocks which starts at the item address plus the sum of
+ * idx[d] * dims[d].stride, for every idx[d] < dims[d].count. The last
+ * dimension is the innermost one. Successive items of a buffer are @a extent
+ * bytes apart.
+ */
+typedef struct ucp_dt_strided {
+    size_t                   block;    /* Size of a contiguous block, in bytes */
+    size_t                   size;     /* Packed size of an item, in bytes */
+    size_t                   extent;   /* Distance between items, in bytes */
+    unsigned                 num_dims; /* Number of dimensions */
+    struct {
+        size_t               count;    /* Number of elements */
+        size_t               stride;   /* Distance between elements, in bytes */
+    } dims[UCP_DT_STRIDED_MAX_DIMS];
+} ucp_dt_strided_t;
+
+
+static inline ucp_dt_strided_t* ucp_dt_strided(ucp_datatype_t datatype)
+{
+    return (ucp_dt_strided_t*)(void*)(datatype & ~UCP_DATATYPE_CLASS_MASK);
+}
+
+#define UCP_DT_IS_STRIDED(_datatype) \
+          (((_datatype) & UCP_DATATYPE_CLASS_MASK) == UCP_DATATYPE_STRIDED)
+
+
+/**
+ * Get the packed length of @a count items of strided datatype.
+ */
+static inline size_t ucp_dt_strided_length(ucp_datatype_t datatype, size_t count)
+{
+    return count * ucp_dt_strided(datatype)->size;
+}
+
+
+/**
+ * Get the size of the memory region which holds the data of @a length packed
+ * bytes of strided datatype, starting at the buffer address.
+ */
+static inline size_t ucp_dt_strided_span(ucp_datatype_t datatype, size_t length)
+{
+    const ucp_dt_strided_t *dt = ucp_dt_strided(datatype);
+
+    return (length + dt->size - 1) / dt->size * dt->extent;
+}
+
+
+/**
+ * Copy data of strided datatype to a contiguous buffer.
+ *
+ * @param [in]  dest      Destination contiguous buffer.
+ * @param [in]  src       Source buffer, described by @a datatype.
+ * @param [in]  datatype  Strided datatype.
+ * @param [in]  offset    Packed offset in the source data to start copying from.
+ * @param [in]  length    Number of bytes to copy.
+ */
+void ucp_dt_strided_gather(void *dest, const void *src, ucp_datatype_t datatype,
+                           size_t offset, size_t length);
+
+
+/**
+ * Copy a contiguous buffer to data of strided datatype.
+ *
+ * @param [in]  dest      Destination buffer, described by @a datatype.
+ * @param [in]  src       Source contiguous buffer.
+ * @param [in]  datatype  Strided datatype.
+ * @param [in]  offset    Packed offset in the destination data to start copying to.
+ * @param [in]  length    Number of bytes to copy.
+ */
+void ucp_dt_strided_scatter(void *dest, const void *src, ucp_datatype_t datatype,
+                            size_t offset, size_t length);
+
+
+/**
+ * Describe data of strided datatype by an array of @ref uct_iov_t, one entry
+ * per contiguous block, for zero-copy operations.
+ *
+ * @param [out] iov         Filled with the blocks of the data.
+ * @param [out] iovcnt      Filled with the number of entries in @a iov.
+ * @param [in]  max_iov     Maximal number of entries in @a iov.
+ * @param [in]  buffer      Buffer, described by @a datatype.
+ * @param [in]  datatype    Strided datatype.
+ * @param [in]  memh        Memory handle which covers the buffer.
+ * @param [in]  offset      Packed offset in the data to start from.
+ * @param [in]  length_max  Maximal number of bytes to describe.
+ *
+ * @return Number of bytes described by @a iov, which is less than
+ *         @a length_max if more than @a max_iov entries are needed.
+ */
+size_t ucp_dt_strided_to_uct_iov(uct_iov_t *iov, size_t *iovcnt, size_t max_iov,
+                                 const void *buffer, ucp_datatype_t datatype,
+                                 uct_mem_h memh, size_t offset, size_t length_max);
+
+
+/**
+ * Get the number of contiguous blocks which hold @a length bytes of data of
+ * strided datatype, starting at packed offset @a offset.
+ */
+size_t ucp_dt_strided_num_blocks(ucp_datatype_t datatype, size_t offset,
+                                 size_t length);
+
+#endif
@@ -134,6 +134,11 @@ size_t ucp_dt_iov_copy_uct(uct_iov_t *iov, size_t *iovcnt, size_t max_dst_iov,
         state->dt.iov.iovcnt_offset = src_it;
         *iovcnt                     = dst_it;
         break;
+    case UCP_DATATYPE_STRIDED:
+        length_it = ucp_dt_strided_to_uct_iov(iov, iovcnt, max_dst_iov, src_iov,
+                                              datatype, state->dt.strided.memh,
+                                              state->offset, length_max);
+        break;
     default:
         ucs_error("Invalid data type");
     }
@@ -204,6 +209,10 @@ ucs_status_t ucp_do_am_zcopy_multi(uct_pending_req_t *self, uint8_t am_id_first,
         /* This flag should guarantee middle stage usage if iovcnt exceeded */
         flag_iov_mid = ((state->dt.iov.iovcnt_offset + max_iov) <
                         state->dt.iov.iovcnt);
+    } else if (UCP_DT_IS_STRIDED(req->send.datatype)) {
+        flag_iov_mid = (ucp_dt_strided_num_blocks(req->send.datatype, offset,
+                                                  req->send.length - offset) >
+                        max_iov);
     }
 
     if (offset == 0) {
@@ -30,6 +30,24 @@ typedef ucs_status_t
         return UCS_ERR_INVALID_PARAM; \
     }
 
+
+#define UCP_RMA_CHECK_PARAMS_PTR(_buffer, _length) \
+    if ((_length) == 0) { \
+        return UCS_STATUS_PTR(UCS_OK); \
+    } \
+    if (ENABLE_PARAMS_CHECK && ((_buffer) == NULL)) { \
+        return UCS_STATUS_PTR(UCS_ERR_INVALID_PARAM); \
+    }
+
+/* Same as UCP_EP_RESOLVE_RKEY_RMA, for functions which return a request */
+static UCS_F_ALWAYS_INLINE ucs_status_t
+ucp_rma_resolve_rkey(ucp_ep_h ep, ucp_rkey_h rkey, ucp_lane_index_t *lane_p,
+                     uct_rkey_t *uct_rkey_p, ucp_ep_rma_config_t **rma_config_p)
+{
+    UCP_EP_RESOLVE_RKEY_RMA(ep, rkey, *lane_p, *uct_rkey_p, *rma_config_p);
+    return UCS_OK;
+}
+
 static UCS_F_ALWAYS_INLINE int 
 ucp_rma_put_is_zcopy(ucp_ep_rma_config_t *rma_config, size_t length)
 {
@@ -42,6 +60,20 @@ ucp_rma_get_is_zcopy(ucp_ep_rma_config_t *rma_config, size_t length)
     return length >= rma_config->get_zcopy_thresh;
 }
 
+/* Complete the request, and call the user callback if it was set. The callback
+ * is set only for ucp_put_nb()/ucp_get_nb() requests which were returned to the
+ * user, so it is not called if the operation completes in place.
+ */
+static UCS_F_ALWAYS_INLINE void
+ucp_rma_request_complete(ucp_request_t *req, ucs_status_t status)
+{
+    if (req->send.cb != NULL) {
+        ucp_request_complete_send(req, status);
+    } else {
+        ucp_request_put(req, status);
+    }
+}
+
 /* request can be released if 
  *  - all fragments were sent (length == 0) (bcopy & zcopy mix)
  *  - all zcopy fragments are done (uct_comp.count == 0)
@@ -69,7 +101,7 @@ ucp_rma_request_advance(ucp_request_t *req, size_t frag_length,
                                  UCT_INVALID_MEM_HANDLE)) {
                     ucp_request_send_buffer_dereg(req, req->send.lane);
                 }
-                ucp_request_put(req, UCS_OK);
+                ucp_rma_request_complete(req, UCS_OK);
             }
             return UCS_OK;
         } 
@@ -87,7 +119,7 @@ ucp_rma_request_bcopy_completion(uct_completion_t *self, ucs_status_t status)
     ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct_comp);
 
     if (ucs_likely(req->send.length == 0)) {
-        ucp_request_put(req, UCS_OK);
+        ucp_rma_request_complete(req, UCS_OK);
     }
 }
 
@@ -97,7 +129,7 @@ static void ucp_rma_request_zcopy_completion(uct_completion_t *self, ucs_status_
 
     if (ucs_likely(req->send.length == 0)) {
         ucp_request_send_buffer_dereg(req, req->send.lane);
-        ucp_request_put(req, UCS_OK);
+        ucp_rma_request_complete(req, UCS_OK);
     }
 }
 
@@ -117,9 +149,7 @@ ucp_rma_request_init(ucp_request_t *req, ucp_ep_h ep, const void *buffer,
     req->send.uct.func        = cb;
     req->send.lane            = lane;
     req->send.uct_comp.count  = 0; 
-#if ENABLE_ASSERT
     req->send.cb              = NULL;
-#endif
     if (ucs_unlikely(zcopy)) {
         req->send.uct_comp.func = ucp_rma_request_zcopy_completion;
         return ucp_request_send_buffer_reg(req, lane);
@@ -373,6 +403,71 @@ ucp_rma_nbi(ucp_ep_h ep, const void *buffer, size_t length, uint64_t remote_addr
     } while (1);
 }
 
+static UCS_F_ALWAYS_INLINE ucs_status_ptr_t
+ucp_rma_nb(ucp_ep_h ep, const void *buffer, size_t length, uint64_t remote_addr,
+           ucp_rkey_h rkey, ucp_ep_rma_config_t *rma_config,
+           ucp_lane_index_t lane, uct_rkey_t uct_rkey,
+           ucp_rma_send_func_t send_func, int zcopy, ucp_send_callback_t cb)
+{
+    ucs_status_t status;
+    ucp_request_t *req;
+
+    ucs_assert((send_func == ucp_progress_put_inner) ||
+               (send_func == ucp_progress_get_inner));
+
+    req = ucp_request_get(ep->worker);
+    if (req == NULL) {
+        return UCS_STATUS_PTR(UCS_ERR_NO_MEMORY);
+    }
+
+    status = ucp_rma_request_init(req, ep, buffer, length, remote_addr, rkey,
+                                  send_func == ucp_progress_put_inner ?
+                                  ucp_progress_put_nbi : ucp_progress_get_nbi,
+                                  lane, 0, zcopy);
+    if (ucs_unlikely(status != UCS_OK)) {
+        ucs_mpool_put(req);
+        return UCS_STATUS_PTR(status);
+    }
+
+    /* The callback is not set yet, so if all fragments complete during the
+     * loop, the request is only marked as completed */
+    do {
+        status = send_func(req, uct_rkey, rma_config, zcopy);
+        if (ucs_unlikely(status == UCS_ERR_NO_RESOURCE)) {
+            if (ucp_request_pending_add(req, &status)) {
+                break;
+            }
+        } else if (status != UCS_INPROGRESS) {
+            break;
+        }
+    } while (1);
+
+    if (ucs_likely(req->flags & UCP_REQUEST_FLAG_COMPLETED)) {
+        ucs_trace_req("rma request %p completed in place", req);
+        ucs_mpool_put(req);
+        return UCS_STATUS_PTR(UCS_OK);
+    } else if (ucs_unlikely(status < 0)) {
+        if (req->send.uct_comp.count == 0) {
+            if (req->send.state.dt.contig.memh != UCT_INVALID_MEM_HANDLE) {
+                ucp_request_send_buffer_dereg(req, req->send.lane);
+            }
+            ucs_mpool_put(req);
+        } else {
+            /* Fragments which are still in flight reference the request. The
+             * user never gets it, so let the last completion release it. No
+             * more fragments are sent, so the completion does not wait for
+             * the rest of the data. */
+            req->send.length  = 0;
+            req->flags       |= UCP_REQUEST_FLAG_RELEASED;
+        }
+        return UCS_STATUS_PTR(status);
+    }
+
+    req->send.cb = cb;
+    ucs_trace_req("returning rma request %p (%p)", req, req + 1);
+    return req + 1;
+}
+
 ucs_status_t ucp_put_nbi(ucp_ep_h ep, const void *buffer, size_t length,
                          uint64_t remote_addr, ucp_rkey_h rkey)
 {
@@ -403,6 +498,43 @@ out:
     return status;
 }
 
+UCS_PROFILE_FUNC(ucs_status_ptr_t, ucp_put_nb,
+                 (ep, buffer, length, remote_addr, rkey, cb),
+                 ucp_ep_h ep, const void *buffer, size_t length,
+                 uint64_t remote_addr, ucp_rkey_h rkey, ucp_send_callback_t cb)
+{
+    ucp_ep_rma_config_t *rma_config;
+    ucp_lane_index_t lane;
+    uct_rkey_t uct_rkey;
+    ucs_status_t status;
+    void *request;
+
+    UCP_RMA_CHECK_PARAMS_PTR(buffer, length);
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&ep->worker->mt_lock);
+    status = ucp_rma_resolve_rkey(ep, rkey, &lane, &uct_rkey, &rma_config);
+    if (ucs_unlikely(status != UCS_OK)) {
+        request = UCS_STATUS_PTR(status);
+        goto out;
+    }
+
+    /* Fast path for a single short message */
+    if (length <= rma_config->max_put_short) {
+        status = UCS_PROFILE_CALL(uct_ep_put_short, ep->uct_eps[lane], buffer,
+                                  length, remote_addr, uct_rkey);
+        if (ucs_likely(status != UCS_ERR_NO_RESOURCE)) {
+            request = UCS_STATUS_PTR(status);
+            goto out;
+        }
+    }
+
+    request = ucp_rma_nb(ep, buffer, length, remote_addr, rkey, rma_config,
+                         lane, uct_rkey, ucp_progress_put_inner,
+                         ucp_rma_put_is_zcopy(rma_config, length), cb);
+out:
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&ep->worker->mt_lock);
+    return request;
+}
+
 UCS_PROFILE_FUNC(ucs_status_t, ucp_put, (ep, buffer, length, remote_addr, rkey),
                  ucp_ep_h ep, const void *buffer, size_t length,
                  uint64_t remote_addr, ucp_rkey_h rkey)
@@ -484,6 +616,33 @@ ucs_status_t ucp_get_nbi(ucp_ep_h ep, void *buffer, size_t length,
     return status;
 }
 
+UCS_PROFILE_FUNC(ucs_status_ptr_t, ucp_get_nb,
+                 (ep, buffer, length, remote_addr, rkey, cb),
+                 ucp_ep_h ep, void *buffer, size_t length,
+                 uint64_t remote_addr, ucp_rkey_h rkey, ucp_send_callback_t cb)
+{
+    ucp_ep_rma_config_t *rma_config;
+    uct_rkey_t uct_rkey;
+    ucp_lane_index_t lane;
+    ucs_status_t status;
+    void *request;
+
+    UCP_RMA_CHECK_PARAMS_PTR(buffer, length);
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&ep->worker->mt_lock);
+    status = ucp_rma_resolve_rkey(ep, rkey, &lane, &uct_rkey, &rma_config);
+    if (ucs_unlikely(status != UCS_OK)) {
+        request = UCS_STATUS_PTR(status);
+        goto out;
+    }
+
+    request = ucp_rma_nb(ep, buffer, length, remote_addr, rkey, rma_config,
+                         lane, uct_rkey, ucp_progress_get_inner,
+                         ucp_rma_get_is_zcopy(rma_config, length), cb);
+out:
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&ep->worker->mt_lock);
+    return request;
+}
+
 UCS_PROFILE_FUNC(ucs_status_t, ucp_worker_fence, (worker), ucp_worker_h worker)
 {
     unsigned rsc_index;
@@ -491,6 +650,11 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_worker_fence, (worker), ucp_worker_h worker)
 
     UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
 
+    status = ucp_amo_aggr_flush(worker, NULL);
+    if (status != UCS_OK) {
+        goto out;
+    }
+
     for (rsc_index = 0; rsc_index < worker->context->num_tls; ++rsc_index) {
         if (worker->ifaces[rsc_index] == NULL) {
             continue;
@@ -511,9 +675,15 @@ out:
 UCS_PROFILE_FUNC(ucs_status_t, ucp_worker_flush, (worker), ucp_worker_h worker)
 {
     unsigned rsc_index;
+    ucs_status_t status;
 
     UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
 
+    status = ucp_amo_aggr_flush(worker, NULL);
+    if (status != UCS_OK) {
+        goto out;
+    }
+
     while (worker->stub_pend_count > 0) {
         ucp_worker_progress(worker);
     }
@@ -529,11 +699,108 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_worker_flush, (worker), ucp_worker_h worker)
         }
     }
 
+out:
     UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+    return status;
+}
+
+/*
+ * Check whether all operations which were started on the worker before the
+ * flush are completed. Interfaces before *rsc_index_p were already flushed, so
+ * they are not checked again.
+ */
+static ucs_status_t ucp_worker_flush_check(ucp_worker_h worker,
+                                           ucp_rsc_index_t *rsc_index_p)
+{
+    ucp_rsc_index_t rsc_index;
+    ucs_status_t status;
+
+    if (worker->stub_pend_count > 0) {
+        return UCS_INPROGRESS;
+    }
+
+    for (rsc_index = *rsc_index_p; rsc_index < worker->context->num_tls;
+         ++rsc_index) {
+        if (worker->ifaces[rsc_index] == NULL) {
+            continue;
+        }
 
+        status = uct_iface_flush(worker->ifaces[rsc_index], 0, NULL);
+        if (status != UCS_OK) {
+            *rsc_index_p = rsc_index;
+            return status;
+        }
+    }
+
+    *rsc_index_p = rsc_index;
     return UCS_OK;
 }
 
+static void ucp_worker_flush_slow_path_callback(ucs_callbackq_slow_elem_t *self)
+{
+    ucp_request_t *req  = ucs_container_of(self, ucp_request_t,
+                                           send.flush_worker.cbq_elem);
+    ucp_worker_h worker = req->send.flush_worker.worker;
+    ucs_status_t status;
+
+    status = ucp_worker_flush_check(worker, &req->send.flush_worker.rsc_index);
+    if ((status == UCS_INPROGRESS) || (status == UCS_ERR_NO_RESOURCE)) {
+        return;
+    }
+
+    ucs_trace_req("flush worker %p request %p completed: %s", worker, req,
+                  ucs_status_string(status));
+    uct_worker_slowpath_progress_unregister(worker->uct, self);
+    ucp_request_complete_send(req, status);
+}
+
+UCS_PROFILE_FUNC(ucs_status_ptr_t, ucp_worker_flush_nb, (worker, flags, cb),
+                 ucp_worker_h worker, unsigned flags, ucp_send_callback_t cb)
+{
+    ucp_rsc_index_t rsc_index = 0;
+    ucs_status_t status;
+    ucp_request_t *req;
+    void *request;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+
+    status = ucp_amo_aggr_flush(worker, NULL);
+    if (status != UCS_OK) {
+        request = UCS_STATUS_PTR(status);
+        goto out;
+    }
+
+    status = ucp_worker_flush_check(worker, &rsc_index);
+    if ((status != UCS_INPROGRESS) && (status != UCS_ERR_NO_RESOURCE)) {
+        request = UCS_STATUS_PTR(status);
+        goto out;
+    }
+
+    req = ucp_request_get(worker);
+    if (req == NULL) {
+        request = UCS_STATUS_PTR(UCS_ERR_NO_MEMORY);
+        goto out;
+    }
+
+    /* Keep checking the interfaces from the progress, until all are flushed */
+    req->flags                         = 0;
+    req->status                        = UCS_OK;
+    req->send.ep                       = NULL;
+    req->send.cb                       = cb;
+    req->send.flush_worker.worker      = worker;
+    req->send.flush_worker.rsc_index   = rsc_index;
+    req->send.flush_worker.cbq_elem.cb = ucp_worker_flush_slow_path_callback;
+    uct_worker_slowpath_progress_register(worker->uct,
+                                          &req->send.flush_worker.cbq_elem);
+
+    ucs_trace_req("flush worker %p: return inprogress request %p (%p)", worker,
+                  req, req + 1);
+    request = req + 1;
+out:
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+    return request;
+}
+
 UCS_PROFILE_FUNC(ucs_status_t, ucp_ep_flush, (ep), ucp_ep_h ep)
 {
     ucp_lane_index_t lane;
@@ -541,6 +808,11 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_ep_flush, (ep), ucp_ep_h ep)
 
     UCP_THREAD_CS_ENTER_CONDITIONAL(&ep->worker->mt_lock);
 
+    status = ucp_amo_aggr_flush(ep->worker, ep);
+    if (status != UCS_OK) {
+        goto out;
+    }
+
     for (lane = 0; lane < ucp_ep_num_lanes(ep); ++lane) {
         for (;;) {
             status = uct_ep_flush(ep->uct_eps[lane], 0, NULL);
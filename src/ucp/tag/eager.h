@@ -60,6 +60,11 @@ void ucp_tag_eager_sync_send_ack(ucp_worker_h worker, uint64_t sender_uuid,
 
 void ucp_tag_eager_sync_completion(ucp_request_t *req, uint16_t flag);
 
+ucs_status_ptr_t
+ucp_tag_send_req(ucp_request_t *req, size_t count, ssize_t max_short,
+                 size_t *zcopy_thresh, size_t rndv_rma_thresh, size_t rndv_am_thresh,
+                 ucp_send_callback_t cb, const ucp_proto_t *proto);
+
 
 static inline ucs_status_t ucp_tag_send_eager_short(ucp_ep_t *ep, ucp_tag_t tag,
                                                     const void *buffer, size_t length)
@@ -5,7 +5,7 @@
  */
 
 #include "eager.h"
-#include "match.h"
+#include "tag_match.inl"
 
 #include <ucp/core/ucp_context.h>
 #include <ucp/core/ucp_worker.h>
@@ -20,57 +20,51 @@ ucp_eager_handler(void *arg, void *data, size_t length, void *desc,
     ucp_worker_h worker = arg;
     ucp_eager_hdr_t *eager_hdr = data;
     ucp_eager_first_hdr_t *eager_first_hdr = data;
-    ucp_context_h context = worker->context;
     ucp_recv_desc_t *rdesc = desc;
+    ucs_queue_head_t *queue;
     ucp_request_t *req;
     ucs_queue_iter_t iter;
     ucs_status_t status;
     size_t recv_len;
     ucp_tag_t recv_tag;
 
-    UCP_THREAD_CS_ENTER_CONDITIONAL(&context->mt_lock);
-
     ucs_assert(length >= hdr_len);
     recv_tag = eager_hdr->super.tag;
 
     /* Search in expected queue */
-    ucs_queue_for_each_safe(req, iter, &context->tag.expected, recv.queue) {
-        req = ucs_container_of(*iter, ucp_request_t, recv.queue);
-        if (ucp_tag_recv_is_match(recv_tag, flags, req->recv.tag, req->recv.tag_mask,
-                                  req->recv.state.offset, req->recv.info.sender_tag))
-        {
-            recv_len = length - hdr_len;
-            ucp_tag_log_match(recv_tag, recv_len, req, req->recv.tag,
-                              req->recv.tag_mask, req->recv.state.offset, "expected");
-            status = ucp_tag_process_recv(req->recv.buffer, req->recv.count,
-                                          req->recv.datatype, &req->recv.state,
-                                          data + hdr_len, recv_len,
-                                          flags & UCP_RECV_DESC_FLAG_LAST);
-
-            /* First fragment fills the receive information */
-            if (flags & UCP_RECV_DESC_FLAG_FIRST) {
-                UCP_WORKER_STAT_EAGER_MSG(worker, flags);
-                req->recv.info.sender_tag = recv_tag;
-                if (flags & UCP_RECV_DESC_FLAG_LAST) {
-                    req->recv.info.length = recv_len;
-                } else {
-                    req->recv.info.length = eager_first_hdr->total_len;
-                }
-            }
-
-            /* Last fragment completes the request */
+    req = ucp_tag_exp_search(&worker->tm, recv_tag, flags, &queue, &iter);
+    if (req != NULL) {
+        recv_len = length - hdr_len;
+        ucp_tag_log_match(recv_tag, recv_len, req, req->recv.tag,
+                          req->recv.tag_mask, req->recv.state.offset, "expected");
+        status = ucp_tag_process_recv(req->recv.buffer, req->recv.count,
+                                      req->recv.datatype, &req->recv.state,
+                                      data + hdr_len, recv_len,
+                                      flags & UCP_RECV_DESC_FLAG_LAST);
+
+        /* First fragment fills the receive information */
+        if (flags & UCP_RECV_DESC_FLAG_FIRST) {
+            UCP_WORKER_STAT_EAGER_MSG(worker, flags);
+            req->recv.info.sender_tag = recv_tag;
             if (flags & UCP_RECV_DESC_FLAG_LAST) {
-                ucs_queue_del_iter(&context->tag.expected, iter);
-                ucp_request_complete_recv(req, status, &req->recv.info);
+                req->recv.info.length = recv_len;
             } else {
-                req->recv.state.offset += recv_len;
+                req->recv.info.length = eager_first_hdr->total_len;
             }
-            UCP_WORKER_STAT_EAGER_CHUNK(worker, EXP);
-            /* TODO In case an error status is returned from ucp_tag_process_recv,
-             * need to discard the rest of the messages */
-            status = UCS_OK;
-            goto out;
         }
+
+        /* Last fragment completes the request */
+        if (flags & UCP_RECV_DESC_FLAG_LAST) {
+            ucs_queue_del_iter(queue, iter);
+            ucp_request_complete_recv(req, status, &req->recv.info);
+        } else {
+            req->recv.state.offset += recv_len;
+        }
+        UCP_WORKER_STAT_EAGER_CHUNK(worker, EXP);
+        /* TODO In case an error status is returned from ucp_tag_process_recv,
+         * need to discard the rest of the messages */
+        status = UCS_OK;
+        goto out;
     }
 
     ucs_trace_req("unexp recv %c%c%c tag %"PRIx64" length %zu desc %p",
@@ -86,11 +80,10 @@ ucp_eager_handler(void *arg, void *data, size_t length, void *desc,
     rdesc->length  = length;
     rdesc->hdr_len = hdr_len;
     rdesc->flags   = flags;
-    ucs_queue_push(&context->tag.unexpected, &rdesc->queue);
+    ucp_tag_unexp_add(&worker->tm, rdesc, recv_tag);
 
     status = UCS_INPROGRESS;
 out:
-    UCP_THREAD_CS_EXIT_CONDITIONAL(&context->mt_lock);
     return status;
 }
 
@@ -31,7 +31,7 @@ typedef struct {
 } UCS_S_PACKED ucp_tag_hdr_t;
 
 
-void ucp_tag_cancel_expected(ucp_context_h context, ucp_request_t *req);
+void ucp_tag_cancel_expected(ucp_worker_h worker, ucp_request_t *req);
 
 size_t ucp_tag_pack_dt_copy(void *dest, const void *src, ucp_frag_state_t *state,
                             size_t length, ucp_datatype_t datatype);
@@ -98,6 +98,16 @@ ucp_tag_process_recv(void *buffer, size_t count, ucp_datatype_t datatype,
                            &state->dt.iov.iovcnt_offset);
         return UCS_OK;
 
+    case UCP_DATATYPE_STRIDED:
+        buffer_size = ucp_dt_strided_length(datatype, count);
+        if (ucs_unlikely(recv_length + offset > buffer_size)) {
+            ucs_debug("message truncated: recv_length %zu offset %zu buffer_size %zu",
+                      recv_length, offset, buffer_size);
+            return UCS_ERR_MESSAGE_TRUNCATED;
+        }
+        ucp_dt_strided_scatter(buffer, recv_data, datatype, offset, recv_length);
+        return UCS_OK;
+
     case UCP_DATATYPE_GENERIC:
         dt_gen = ucp_dt_generic(datatype);
 
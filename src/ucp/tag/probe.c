@@ -4,8 +4,8 @@
  * See file LICENSE for terms.
  */
 
-#include "match.h"
 #include "eager.h"
+#include "tag_match.inl"
 #include "rndv.h"
 
 #include <ucp/api/ucp.h>
@@ -14,16 +14,20 @@
 
 
 static UCS_F_ALWAYS_INLINE ucp_recv_desc_t*
-ucp_tag_probe_search(ucp_context_h context, ucp_tag_t tag, uint64_t tag_mask,
+ucp_tag_probe_search(ucp_worker_h worker, ucp_tag_t tag, uint64_t tag_mask,
                      ucp_tag_recv_info_t *info, int remove)
 {
+    ucs_list_link_t *list;
     ucp_recv_desc_t *rdesc;
     ucp_tag_hdr_t *hdr;
-    ucs_queue_iter_t iter;
     ucp_tag_t recv_tag;
     unsigned flags;
+    int i;
 
-    ucs_queue_for_each_safe(rdesc, iter, &context->tag.unexpected, queue) {
+    list = ucp_tag_unexp_get_list(&worker->tm, tag, tag_mask, &i);
+    for (rdesc = ucp_tag_unexp_list_elem(list->next, i);
+         &rdesc->tag_list[i] != list;
+         rdesc = ucp_tag_unexp_list_next(rdesc, i)) {
         hdr      = (void*)(rdesc + 1);
         recv_tag = hdr->tag;
         flags    = rdesc->flags;
@@ -44,7 +48,7 @@ ucp_tag_probe_search(ucp_context_h context, ucp_tag_t tag, uint64_t tag_mask,
             }
 
             if (remove) {
-                ucs_queue_del_iter(&context->tag.unexpected, iter);
+                ucp_tag_unexp_remove(rdesc);
             }
             return rdesc;
         }
@@ -57,16 +61,13 @@ ucp_tag_message_h ucp_tag_probe_nb(ucp_worker_h worker, ucp_tag_t tag,
                                    ucp_tag_t tag_mask, int remove,
                                    ucp_tag_recv_info_t *info)
 {
-    ucp_context_h context = worker->context;
     ucp_recv_desc_t *ret;
 
     UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
-    UCP_THREAD_CS_ENTER_CONDITIONAL(&context->mt_lock);
 
     ucs_trace_req("probe_nb tag %"PRIx64"/%"PRIx64, tag, tag_mask);
-    ret = ucp_tag_probe_search(context, tag, tag_mask, info, remove);
+    ret = ucp_tag_probe_search(worker, tag, tag_mask, info, remove);
 
-    UCP_THREAD_CS_EXIT_CONDITIONAL(&context->mt_lock);
     UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
 
     return ret;
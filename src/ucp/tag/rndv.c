@@ -5,6 +5,8 @@
  */
 
 #include "rndv.h"
+#include "tag_match.inl"
+#include <ucp/dt/dt.h>
 #include <ucp/proto/proto_am.inl>
 #include <ucp/core/ucp_request.inl>
 #include <ucs/datastruct/queue.h>
@@ -25,9 +27,16 @@ static int ucp_tag_rndv_is_get_op_possible(ucp_ep_h ep, uct_rkey_t rkey)
 
 static void ucp_rndv_rma_request_send_buffer_dereg(ucp_request_t *sreq)
 {
-    if ((UCP_DT_IS_CONTIG(sreq->send.datatype)) &&
-        (ucp_ep_is_rndv_lane_present(sreq->send.ep))) {
+    if (!ucp_ep_is_rndv_lane_present(sreq->send.ep)) {
+        return;
+    }
+
+    if (UCP_DT_IS_CONTIG(sreq->send.datatype)) {
+        ucp_request_send_buffer_dereg(sreq, ucp_ep_get_rndv_get_lane(sreq->send.ep));
+    } else if ((UCP_DT_IS_IOV(sreq->send.datatype)) &&
+               (sreq->send.state.dt.iov.memh != NULL)) {
         ucp_request_send_buffer_dereg(sreq, ucp_ep_get_rndv_get_lane(sreq->send.ep));
+        sreq->send.state.dt.iov.memh = NULL;
     }
 }
 
@@ -57,6 +66,69 @@ static size_t ucp_tag_rndv_pack_rkey(ucp_request_t *sreq,
     return packed_rkey;
 }
 
+/*
+ * Pack the descriptor of the sender's IOV buffer, so the receiver could read
+ * every IOV item with get_zcopy. If the descriptor does not fit in the RTS, or
+ * the buffer could not be registered, nothing is packed and the receiver would
+ * ask for the data with an RTR.
+ */
+static size_t ucp_tag_rndv_pack_iov(ucp_request_t *sreq,
+                                    ucp_rndv_rts_hdr_t *rndv_rts_hdr)
+{
+    ucp_ep_h ep             = sreq->send.ep;
+    const ucp_dt_iov_t *iov = sreq->send.buffer;
+    size_t iovcnt           = sreq->send.state.dt.iov.iovcnt;
+    ucp_rndv_rts_iov_entry_t *entry;
+    ucp_lane_index_t lane;
+    size_t iov_it, rkey_size;
+    int need_rkey;
+    void *ptr;
+
+    if (!ucp_ep_is_rndv_lane_present(ep)) {
+        return 0;
+    }
+
+    lane      = ucp_ep_get_rndv_get_lane(ep);
+    need_rkey = !!(ucp_ep_rndv_md_flags(ep) & UCT_MD_FLAG_NEED_RKEY);
+    rkey_size = need_rkey ? ucp_ep_md_attr(ep, lane)->rkey_packed_size : 0;
+
+    if (sizeof(*rndv_rts_hdr) + (iovcnt * (sizeof(*entry) + rkey_size)) >
+        ucp_ep_config(ep)->am.max_bcopy) {
+        return 0;
+    }
+
+    if (need_rkey && (ucp_request_send_buffer_reg(sreq, lane) != UCS_OK)) {
+        sreq->send.state.dt.iov.memh = NULL;
+        return 0;
+    }
+
+    /* zero-length items are not packed */
+    ptr                  = rndv_rts_hdr + 1;
+    rndv_rts_hdr->iovcnt = 0;
+    for (iov_it = 0; iov_it < iovcnt; ++iov_it) {
+        if (iov[iov_it].length == 0) {
+            continue;
+        }
+
+        entry          = ptr;
+        entry->address = (uintptr_t)iov[iov_it].buffer;
+        entry->length  = iov[iov_it].length;
+        ptr            = entry + 1;
+        if (need_rkey) {
+            uct_md_mkey_pack(ucp_ep_md(ep, lane),
+                             sreq->send.state.dt.iov.memh[iov_it], ptr);
+            ptr += rkey_size;
+        }
+        ++rndv_rts_hdr->iovcnt;
+    }
+
+    rndv_rts_hdr->flags |= UCP_RNDV_RTS_FLAG_IOV;
+    if (need_rkey) {
+        rndv_rts_hdr->flags |= UCP_RNDV_RTS_FLAG_PACKED_RKEY;
+    }
+    return ptr - (void*)(rndv_rts_hdr + 1);
+}
+
 static size_t ucp_tag_rndv_rts_pack(void *dest, void *arg)
 {
     ucp_request_t *sreq = arg;   /* the sender's request */
@@ -72,7 +144,11 @@ static size_t ucp_tag_rndv_rts_pack(void *dest, void *arg)
     if (UCP_DT_IS_CONTIG(sreq->send.datatype)) {
         rndv_rts_hdr->address = (uintptr_t) sreq->send.buffer;
         packed_len += ucp_tag_rndv_pack_rkey(sreq, rndv_rts_hdr);
-    } else if (UCP_DT_IS_GENERIC(sreq->send.datatype)) {
+    } else if (UCP_DT_IS_IOV(sreq->send.datatype)) {
+        rndv_rts_hdr->address = 0;
+        packed_len += ucp_tag_rndv_pack_iov(sreq, rndv_rts_hdr);
+    } else if (UCP_DT_IS_GENERIC(sreq->send.datatype) ||
+               UCP_DT_IS_STRIDED(sreq->send.datatype)) {
         rndv_rts_hdr->address = 0;
     }
 
@@ -125,6 +201,8 @@ void ucp_tag_send_start_rndv(ucp_request_t *sreq)
 
     if (UCP_DT_IS_CONTIG(sreq->send.datatype)) {
         sreq->send.state.dt.contig.memh = UCT_INVALID_MEM_HANDLE;
+    } else if (UCP_DT_IS_IOV(sreq->send.datatype)) {
+        sreq->send.state.dt.iov.memh    = NULL;
     }
 
     sreq->send.uct.func = ucp_proto_progress_rndv_rts;
@@ -135,6 +213,7 @@ static void ucp_rndv_send_ats(ucp_request_t *rndv_req, uintptr_t remote_request)
     ucs_trace_req("ep: %p send ats. rndv_req: %p, remote_request: %zu",
                   rndv_req->send.ep, rndv_req, remote_request);
 
+    rndv_req->flags            |= UCP_REQUEST_FLAG_CONTROL;
     rndv_req->send.lane         = ucp_ep_get_am_lane(rndv_req->send.ep);
     rndv_req->send.uct.func     = ucp_proto_progress_am_bcopy_single;
     rndv_req->send.proto.am_id  = UCP_AM_ID_RNDV_ATS;
@@ -144,6 +223,28 @@ static void ucp_rndv_send_ats(ucp_request_t *rndv_req, uintptr_t remote_request)
     ucp_request_start_send(rndv_req);
 }
 
+/* Release the sender's rkeys which were unpacked from the RTS */
+static void ucp_rndv_get_release_rkeys(ucp_request_t *rndv_req)
+{
+    ucp_rndv_get_iov_t *remote_iov = rndv_req->send.rndv_get.remote_iov;
+    size_t iov_it;
+
+    if (remote_iov == NULL) {
+        if (rndv_req->send.rndv_get.rkey_bundle.rkey != UCT_INVALID_RKEY) {
+            uct_rkey_release(&rndv_req->send.rndv_get.rkey_bundle);
+        }
+        return;
+    }
+
+    for (iov_it = 0; iov_it < rndv_req->send.rndv_get.remote_iovcnt; ++iov_it) {
+        if (remote_iov[iov_it].rkey_bundle.rkey != UCT_INVALID_RKEY) {
+            uct_rkey_release(&remote_iov[iov_it].rkey_bundle);
+        }
+    }
+    ucs_free(remote_iov);
+    rndv_req->send.rndv_get.remote_iov = NULL;
+}
+
 static void ucp_rndv_complete_rndv_get(ucp_request_t *rndv_req)
 {
     ucp_request_t *rreq = rndv_req->send.rndv_get.rreq;
@@ -152,10 +253,7 @@ static void ucp_rndv_complete_rndv_get(ucp_request_t *rndv_req)
 
     ucp_request_complete_recv(rreq, UCS_OK, &rreq->recv.info);
 
-    if (rndv_req->send.rndv_get.rkey_bundle.rkey != UCT_INVALID_RKEY) {
-        uct_rkey_release(&rndv_req->send.rndv_get.rkey_bundle);
-    }
-
+    ucp_rndv_get_release_rkeys(rndv_req);
     ucp_rndv_rma_request_send_buffer_dereg(rndv_req);
 
     ucp_rndv_send_ats(rndv_req, rndv_req->send.rndv_get.remote_request);
@@ -176,8 +274,7 @@ static ucs_status_t ucp_rndv_truncated(uct_pending_req_t *self)
 }
 
 static void ucp_rndv_recv_am(ucp_request_t *rndv_req, ucp_request_t *rreq,
-                             uintptr_t sender_reqptr, size_t total_size,
-                             int contig)
+                             uintptr_t sender_reqptr, size_t total_size)
 {
     size_t recv_size;
 
@@ -185,6 +282,7 @@ static void ucp_rndv_recv_am(ucp_request_t *rndv_req, ucp_request_t *rreq,
                   "recv request: %p", rndv_req, rreq);
 
     /* rndv_req is the request that would send the RTR message to the sender */
+    rndv_req->flags        |= UCP_REQUEST_FLAG_CONTROL;
     rndv_req->send.lane     = ucp_ep_get_am_lane(rndv_req->send.ep);
     rndv_req->send.uct.func = ucp_proto_progress_rndv_rtr;
     /* save the sender's send request and send it in the RTR */
@@ -192,13 +290,8 @@ static void ucp_rndv_recv_am(ucp_request_t *rndv_req, ucp_request_t *rreq,
     rndv_req->send.proto.status         = UCS_OK;
     rndv_req->send.proto.rreq_ptr       = (uintptr_t) rreq;
 
-    if (contig) {
-        recv_size = ucp_contig_dt_length(rreq->recv.datatype, rreq->recv.count);
-    } else {
-        ucp_dt_generic_t *dt_gen;
-        dt_gen = ucp_dt_generic(rreq->recv.datatype);
-        recv_size = dt_gen->ops.packed_size(rreq->recv.state.dt.generic.state);
-    }
+    recv_size = ucp_dt_length(rreq->recv.datatype, rreq->recv.count,
+                              rreq->recv.buffer, &rreq->recv.state);
     if (ucs_unlikely(recv_size < total_size)) {
         ucs_trace_req("rndv msg truncated: rndv_req: %p. received %zu. "
                       "expected %zu on rreq: %p ",
@@ -207,33 +300,131 @@ static void ucp_rndv_recv_am(ucp_request_t *rndv_req, ucp_request_t *rreq,
     }
 }
 
+/*
+ * Find the next chunk of data which can be read with a single get_zcopy, which
+ * ends at the end of the current IOV item of either the local buffer or the
+ * sender's buffer.
+ */
+static size_t ucp_rndv_get_next_chunk(ucp_request_t *rndv_req, void **buffer,
+                                      uct_mem_h *memh, uint64_t *remote_address,
+                                      uct_rkey_t *rkey)
+{
+    ucp_frag_state_t *state        = &rndv_req->send.state;
+    ucp_rndv_get_iov_t *remote_iov = rndv_req->send.rndv_get.remote_iov;
+    const ucp_dt_iov_t *iov;
+    size_t length, remote_length;
+
+    if (UCP_DT_IS_CONTIG(rndv_req->send.datatype)) {
+        *buffer = (void*)rndv_req->send.buffer + state->offset;
+        *memh   = state->dt.contig.memh;
+        length  = rndv_req->send.length - state->offset;
+    } else {
+        /* skip the local IOV items which were completely read or are empty */
+        iov = rndv_req->send.buffer;
+        while (iov[state->dt.iov.iovcnt_offset].length ==
+               state->dt.iov.iov_offset) {
+            ++state->dt.iov.iovcnt_offset;
+            state->dt.iov.iov_offset = 0;
+        }
+        iov    += state->dt.iov.iovcnt_offset;
+        *buffer = iov->buffer + state->dt.iov.iov_offset;
+        *memh   = state->dt.iov.memh[state->dt.iov.iovcnt_offset];
+        length  = iov->length - state->dt.iov.iov_offset;
+    }
+
+    if (remote_iov == NULL) {
+        *remote_address = rndv_req->send.rndv_get.remote_address + state->offset;
+        *rkey           = rndv_req->send.rndv_get.rkey_bundle.rkey;
+        remote_length   = rndv_req->send.length - state->offset;
+    } else {
+        remote_iov     += rndv_req->send.rndv_get.remote_iov_index;
+        *remote_address = remote_iov->address +
+                          rndv_req->send.rndv_get.remote_iov_offset;
+        *rkey           = remote_iov->rkey_bundle.rkey;
+        remote_length   = remote_iov->length -
+                          rndv_req->send.rndv_get.remote_iov_offset;
+    }
+
+    return ucs_min(length, remote_length);
+}
+
+static void ucp_rndv_get_advance(ucp_request_t *rndv_req, size_t length)
+{
+    ucp_rndv_get_iov_t *remote_iov = rndv_req->send.rndv_get.remote_iov;
+
+    rndv_req->send.state.offset += length;
+    if (UCP_DT_IS_IOV(rndv_req->send.datatype)) {
+        rndv_req->send.state.dt.iov.iov_offset += length;
+    }
+
+    if (remote_iov != NULL) {
+        rndv_req->send.rndv_get.remote_iov_offset += length;
+        if (rndv_req->send.rndv_get.remote_iov_offset ==
+            remote_iov[rndv_req->send.rndv_get.remote_iov_index].length) {
+            ++rndv_req->send.rndv_get.remote_iov_index;
+            rndv_req->send.rndv_get.remote_iov_offset = 0;
+        }
+    }
+}
+
+static int ucp_rndv_get_is_reg_needed(ucp_request_t *rndv_req)
+{
+    if (UCP_DT_IS_CONTIG(rndv_req->send.datatype)) {
+        return rndv_req->send.state.dt.contig.memh == UCT_INVALID_MEM_HANDLE;
+    } else {
+        return rndv_req->send.state.dt.iov.memh == NULL;
+    }
+}
+
 ucs_status_t ucp_proto_progress_rndv_get_zcopy(uct_pending_req_t *self)
 {
     ucp_request_t *rndv_req = ucs_container_of(self, ucp_request_t, send.uct);
+    ucp_rndv_get_iov_t *remote_iov = rndv_req->send.rndv_get.remote_iov;
+    ucp_ep_config_t *config;
     ucs_status_t status;
-    size_t offset, length, ucp_mtu, align;
+    size_t offset, length, chunk_length, ucp_mtu, align;
+    uint64_t remote_address;
     uct_iov_t iov[1];
     ucp_rsc_index_t rsc_index;
+    ucp_lane_index_t lane_idx;
+    ucp_request_t *rreq;
+    uintptr_t remote_request;
+    uct_rkey_t rkey;
+    uct_mem_h memh;
+    void *buffer;
 
     if (ucp_ep_is_stub(rndv_req->send.ep)) {
         return UCS_ERR_NO_RESOURCE;
     }
 
-    if (!(ucp_tag_rndv_is_get_op_possible(rndv_req->send.ep,
-                                          rndv_req->send.rndv_get.rkey_bundle.rkey))) {
-        /* can't perform get_zcopy - switch to AM rndv */
-        ucp_rndv_recv_am(rndv_req, rndv_req->send.rndv_get.rreq,
-                         rndv_req->send.rndv_get.remote_request,
-                         rndv_req->send.length, 1);
-
-        if (rndv_req->send.rndv_get.rkey_bundle.rkey != UCT_INVALID_RKEY) {
-            uct_rkey_release(&rndv_req->send.rndv_get.rkey_bundle);
-        }
+    rkey = (remote_iov == NULL) ? rndv_req->send.rndv_get.rkey_bundle.rkey :
+           remote_iov[rndv_req->send.rndv_get.remote_iov_index].rkey_bundle.rkey;
+    if (!(ucp_tag_rndv_is_get_op_possible(rndv_req->send.ep, rkey))) {
+        /* can't perform get_zcopy - switch to AM rndv. release the rkeys
+         * first, since the AM rndv state overrides the get state */
+        rreq           = rndv_req->send.rndv_get.rreq;
+        remote_request = rndv_req->send.rndv_get.remote_request;
+        ucp_rndv_get_release_rkeys(rndv_req);
+        ucp_rndv_recv_am(rndv_req, rreq, remote_request, rndv_req->send.length);
         return UCS_INPROGRESS;
     }
 
-    /* reset the lane to rndv since it might have been set to 0 since it was stub on RTS receive */
-    rndv_req->send.lane = ucp_ep_get_rndv_get_lane(rndv_req->send.ep);
+    /* rndv_req is the internal request to perform the get operation */
+    if (ucp_rndv_get_is_reg_needed(rndv_req)) {
+        /* TODO Not all UCTs need registration on the recv side */
+        status = ucp_request_send_buffer_reg(rndv_req,
+                                             ucp_ep_get_rndv_get_lane(rndv_req->send.ep));
+        ucs_assert_always(status == UCS_OK);
+    }
+
+    /* set the lane to rndv since it might have been set to 0 since it was stub
+     * on RTS receive. the fragments are sent on the rndv lanes round-robin. */
+    config   = ucp_ep_config(rndv_req->send.ep);
+    lane_idx = rndv_req->send.rndv_get.lane_idx;
+    if (lane_idx >= config->rndv.num_lanes) {
+        lane_idx = 0;
+    }
+    rndv_req->send.lane = config->key.rndv_lanes[lane_idx];
     rsc_index = ucp_ep_get_rsc_index(rndv_req->send.ep, rndv_req->send.lane);
     align     = rndv_req->send.ep->worker->iface_attrs[rsc_index].cap.get.opt_zcopy_align;
     ucp_mtu   = rndv_req->send.ep->worker->iface_attrs[rsc_index].cap.get.align_mtu;
@@ -241,46 +432,46 @@ ucs_status_t ucp_proto_progress_rndv_get_zcopy(uct_pending_req_t *self)
     ucs_trace_data("ep: %p try to progress get_zcopy for rndv get. rndv_req: %p. lane: %d",
                    rndv_req->send.ep, rndv_req, rndv_req->send.lane);
 
-    /* rndv_req is the internal request to perform the get operation */
-    if (rndv_req->send.state.dt.contig.memh == UCT_INVALID_MEM_HANDLE) {
-        /* TODO Not all UCTs need registration on the recv side */
-        status = ucp_request_send_buffer_reg(rndv_req, rndv_req->send.lane);
-        ucs_assert_always(status == UCS_OK);
-    }
-
-    offset = rndv_req->send.state.offset;
+    offset       = rndv_req->send.state.offset;
+    chunk_length = ucp_rndv_get_next_chunk(rndv_req, &buffer, &memh,
+                                           &remote_address, &rkey);
 
-    if ((offset == 0) && ((uintptr_t)rndv_req->send.buffer % align) &&
-        (rndv_req->send.length > ucp_mtu )) {
-        length = ucp_mtu - ((uintptr_t)rndv_req->send.buffer % align);
+    if ((offset == 0) && ((uintptr_t)buffer % align) && (chunk_length > ucp_mtu)) {
+        length = ucp_mtu - ((uintptr_t)buffer % align);
     } else {
-        length = ucs_min(rndv_req->send.length - offset,
-                         ucp_ep_config(rndv_req->send.ep)->rndv.max_get_zcopy);
+        /* every lane gets a part of the message according to its bandwidth */
+        length = ucs_min(chunk_length,
+                         ucs_min(config->rndv.max_get_zcopy[lane_idx],
+                                 (size_t)(config->rndv.scale[lane_idx] *
+                                          rndv_req->send.length) + 1));
     }
 
     ucs_trace_data("offset %zu remainder %zu. read to %p len %zu",
-                   offset, (uintptr_t)rndv_req->send.buffer % align,
-                   (void*)rndv_req->send.buffer + offset, length);
+                   offset, (uintptr_t)buffer % align, buffer, length);
 
-    iov[0].buffer = (void*)rndv_req->send.buffer + offset;
+    iov[0].buffer = buffer;
     iov[0].length = length;
-    iov[0].memh   = rndv_req->send.state.dt.contig.memh;
+    iov[0].memh   = memh;
     iov[0].count  = 1;
     iov[0].stride = 0;
     rndv_req->send.uct_comp.count++;
-    status = uct_ep_get_zcopy(ucp_ep_get_rndv_data_uct_ep(rndv_req->send.ep),
-                              iov, 1,
-                              rndv_req->send.rndv_get.remote_address + offset,
-                              rndv_req->send.rndv_get.rkey_bundle.rkey,
+    status = uct_ep_get_zcopy(rndv_req->send.ep->uct_eps[rndv_req->send.lane],
+                              iov, 1, remote_address, rkey,
                               &rndv_req->send.uct_comp);
 
     if ((status == UCS_OK) || (status == UCS_INPROGRESS)) {
-        rndv_req->send.state.offset += length;
+        if (status == UCS_OK) {
+            /* locally-completed, the uct_comp callback won't be called for
+             * this fragment */
+            rndv_req->send.uct_comp.count--;
+        }
+        ucp_rndv_get_advance(rndv_req, length);
+        rndv_req->send.rndv_get.lane_idx = lane_idx + 1;
         if (rndv_req->send.state.offset == rndv_req->send.length) {
-            if (status == UCS_OK) {
-                rndv_req->send.uct_comp.count--;
-                /* if the zcopy operation was locally-completed, the uct_comp callback
-                 * won't be called, so do the completion procedure here */
+            /* all fragments were posted, release the reference which was
+             * taken when the operation started. if all fragments were
+             * already completed, do the completion procedure here */
+            if (--rndv_req->send.uct_comp.count == 0) {
                 ucp_rndv_complete_rndv_get(rndv_req);
             }
             return UCS_OK;
@@ -301,12 +492,72 @@ static void ucp_rndv_get_completion(uct_completion_t *self, ucs_status_t status)
     ucp_rndv_complete_rndv_get(rndv_req);
 }
 
-static void ucp_rndv_handle_recv_contig(ucp_request_t *rndv_req, ucp_request_t *rreq,
+/*
+ * Unpack the descriptor of the sender's IOV buffer from the RTS.
+ */
+static ucs_status_t ucp_rndv_unpack_iov(ucp_request_t *rndv_req,
                                         ucp_rndv_rts_hdr_t *rndv_rts_hdr)
 {
+    ucp_ep_h ep = rndv_req->send.ep;
+    ucp_rndv_rts_iov_entry_t *entry;
+    ucp_rndv_get_iov_t *remote_iov;
+    size_t iov_it, rkey_size;
+    void *ptr;
+
+    remote_iov = ucs_malloc(sizeof(*remote_iov) * rndv_rts_hdr->iovcnt,
+                            "rndv_get_iov");
+    if (remote_iov == NULL) {
+        ucs_error("failed to allocate rndv IOV descriptor of %"PRIu64" items",
+                  rndv_rts_hdr->iovcnt);
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    /* the rkeys were packed by the same kind of memory domain as the local
+     * rndv lane */
+    rkey_size = (rndv_rts_hdr->flags & UCP_RNDV_RTS_FLAG_PACKED_RKEY) ?
+                ucp_ep_md_attr(ep, ucp_ep_get_rndv_get_lane(ep))->rkey_packed_size :
+                0;
+
+    ptr = rndv_rts_hdr + 1;
+    for (iov_it = 0; iov_it < rndv_rts_hdr->iovcnt; ++iov_it) {
+        entry                                = ptr;
+        remote_iov[iov_it].address           = entry->address;
+        remote_iov[iov_it].length            = entry->length;
+        remote_iov[iov_it].rkey_bundle.rkey  = UCT_INVALID_RKEY;
+        ptr                                  = entry + 1;
+        if (rkey_size > 0) {
+            uct_rkey_unpack(ptr, &remote_iov[iov_it].rkey_bundle);
+            ptr += rkey_size;
+        }
+    }
+
+    rndv_req->send.rndv_get.remote_iov        = remote_iov;
+    rndv_req->send.rndv_get.remote_iovcnt     = rndv_rts_hdr->iovcnt;
+    rndv_req->send.rndv_get.remote_iov_index  = 0;
+    rndv_req->send.rndv_get.remote_iov_offset = 0;
+    return UCS_OK;
+}
+
+static void ucp_rndv_handle_recv_am(ucp_request_t *rndv_req, ucp_request_t *rreq,
+                                    ucp_rndv_rts_hdr_t *rndv_rts_hdr)
+{
+
+    ucs_trace_req("handle generic datatype on rndv receive. local rndv_req: %p, "
+                  "recv request: %p", rndv_req, rreq);
+
+    ucp_rndv_recv_am(rndv_req, rreq, rndv_rts_hdr->sreq.reqptr,
+                     rndv_rts_hdr->size);
+
+    ucp_request_start_send(rndv_req);
+}
+
+static void ucp_rndv_handle_recv_get(ucp_request_t *rndv_req, ucp_request_t *rreq,
+                                     ucp_rndv_rts_hdr_t *rndv_rts_hdr)
+{
+    ucs_status_t status;
     size_t recv_size;
 
-    ucs_trace_req("handle contig datatype on rndv receive. local rndv_req: %p, "
+    ucs_trace_req("handle get on rndv receive. local rndv_req: %p, "
                   "recv request: %p", rndv_req, rreq);
 
     /* rndv_req is the request that would perform the get operation */
@@ -315,8 +566,10 @@ static void ucp_rndv_handle_recv_contig(ucp_request_t *rndv_req, ucp_request_t *
     rndv_req->send.rndv_get.remote_request = rndv_rts_hdr->sreq.reqptr;
     rndv_req->send.rndv_get.remote_address = rndv_rts_hdr->address;
     rndv_req->send.rndv_get.rreq = rreq;
+    rndv_req->send.rndv_get.remote_iov = NULL;
 
-    recv_size = ucp_contig_dt_length(rreq->recv.datatype, rreq->recv.count);
+    recv_size = ucp_dt_length(rreq->recv.datatype, rreq->recv.count,
+                              rreq->recv.buffer, &rreq->recv.state);
     if (ucs_unlikely(recv_size < rndv_rts_hdr->size)) {
         ucs_trace_req("rndv msg truncated: rndv_req: %p. received %zu. "
                       "expected %zu on rreq: %p ",
@@ -327,32 +580,38 @@ static void ucp_rndv_handle_recv_contig(ucp_request_t *rndv_req, ucp_request_t *
         rndv_req->send.proto.remote_request = rndv_rts_hdr->sreq.reqptr;
         rndv_req->send.proto.rreq_ptr       = (uintptr_t) rreq;
     } else {
-        if (rndv_rts_hdr->flags & UCP_RNDV_RTS_FLAG_PACKED_RKEY) {
+        if (rndv_rts_hdr->flags & UCP_RNDV_RTS_FLAG_IOV) {
+            rndv_req->send.rndv_get.remote_address = 0;
+            status = ucp_rndv_unpack_iov(rndv_req, rndv_rts_hdr);
+            if (status != UCS_OK) {
+                /* ask the sender to send the data with AM messages */
+                ucp_rndv_handle_recv_am(rndv_req, rreq, rndv_rts_hdr);
+                return;
+            }
+        } else if (rndv_rts_hdr->flags & UCP_RNDV_RTS_FLAG_PACKED_RKEY) {
             uct_rkey_unpack(rndv_rts_hdr + 1, &rndv_req->send.rndv_get.rkey_bundle);
         }
         rndv_req->send.length         = rndv_rts_hdr->size;
         rndv_req->send.uct_comp.func  = ucp_rndv_get_completion;
-        rndv_req->send.uct_comp.count = 0;
+        /* keep the request alive until the last fragment is posted, even if
+         * all fragments posted so far are completed while the next one is
+         * waiting in the pending queue */
+        rndv_req->send.uct_comp.count = 1;
         rndv_req->send.state.offset   = 0;
         rndv_req->send.lane           = ucp_ep_get_rndv_get_lane(rndv_req->send.ep);
-        rndv_req->send.state.dt.contig.memh = UCT_INVALID_MEM_HANDLE;
+        rndv_req->send.rndv_get.lane_idx = 0;
+        if (UCP_DT_IS_CONTIG(rreq->recv.datatype)) {
+            rndv_req->send.state.dt.contig.memh = UCT_INVALID_MEM_HANDLE;
+        } else {
+            rndv_req->send.state.dt.iov.iov_offset    = 0;
+            rndv_req->send.state.dt.iov.iovcnt_offset = 0;
+            rndv_req->send.state.dt.iov.iovcnt        = rreq->recv.count;
+            rndv_req->send.state.dt.iov.memh          = NULL;
+        }
     }
     ucp_request_start_send(rndv_req);
 }
 
-static void ucp_rndv_handle_recv_am(ucp_request_t *rndv_req, ucp_request_t *rreq,
-                                    ucp_rndv_rts_hdr_t *rndv_rts_hdr, int contig)
-{
-
-    ucs_trace_req("handle generic datatype on rndv receive. local rndv_req: %p, "
-                  "recv request: %p", rndv_req, rreq);
-
-    ucp_rndv_recv_am(rndv_req, rreq, rndv_rts_hdr->sreq.reqptr,
-                     rndv_rts_hdr->size, contig);
-
-    ucp_request_start_send(rndv_req);
-}
-
 void ucp_rndv_matched(ucp_worker_h worker, ucp_request_t *rreq,
                       ucp_rndv_rts_hdr_t *rndv_rts_hdr)
 {
@@ -386,21 +645,25 @@ void ucp_rndv_matched(ucp_worker_h worker, ucp_request_t *rreq,
                   ucp_ep_get_am_lane(ep));
     }
 
-    if (UCP_DT_IS_CONTIG(rreq->recv.datatype)) {
-        if ((rndv_rts_hdr->address != 0) && ucp_ep_is_rndv_lane_present(ep)) {
-            /* read the data from the sender with a get_zcopy operation on the
-             * rndv lane */
-            ucp_rndv_handle_recv_contig(rndv_req, rreq, rndv_rts_hdr);
+    if (UCP_DT_IS_CONTIG(rreq->recv.datatype) ||
+        UCP_DT_IS_IOV(rreq->recv.datatype)) {
+        if (((rndv_rts_hdr->address != 0) ||
+             (rndv_rts_hdr->flags & UCP_RNDV_RTS_FLAG_IOV)) &&
+            ucp_ep_is_rndv_lane_present(ep)) {
+            /* read the data from the sender with get_zcopy operations on the
+             * rndv lanes, item by item if either of the buffers is an IOV */
+            ucp_rndv_handle_recv_get(rndv_req, rreq, rndv_rts_hdr);
         } else {
             /* if the sender didn't specify its address in the RTS, can't do a
              * get operation, so send an RTR and the sender will send the data
              * with AM messages */
-            ucp_rndv_handle_recv_am(rndv_req, rreq, rndv_rts_hdr, 1);
+            ucp_rndv_handle_recv_am(rndv_req, rreq, rndv_rts_hdr);
         }
-    } else if (UCP_DT_IS_GENERIC(rreq->recv.datatype)) {
-        /* if the recv side has a generic datatype,
+    } else if (UCP_DT_IS_GENERIC(rreq->recv.datatype) ||
+               UCP_DT_IS_STRIDED(rreq->recv.datatype)) {
+        /* if the recv side has a generic or strided datatype,
          * send an RTR and the sender will send the data with AM messages */
-        ucp_rndv_handle_recv_am(rndv_req, rreq, rndv_rts_hdr, 0);
+        ucp_rndv_handle_recv_am(rndv_req, rreq, rndv_rts_hdr);
     } else {
         ucs_fatal("datatype isn't implemented");
     }
@@ -413,31 +676,25 @@ ucp_rndv_rts_handler(void *arg, void *data, size_t length, void *desc)
 {
     ucp_worker_h worker = arg;
     ucp_rndv_rts_hdr_t *rndv_rts_hdr = data;
-    ucp_context_h context = worker->context;
     ucp_recv_desc_t *rdesc = desc;
     ucp_tag_t recv_tag = rndv_rts_hdr->super.tag;
+    ucs_queue_head_t *queue;
     ucp_request_t *rreq;
     ucs_queue_iter_t iter;
     ucs_status_t status;
 
-    UCP_THREAD_CS_ENTER_CONDITIONAL(&context->mt_lock);
-
     /* Search in expected queue */
-    ucs_queue_for_each_safe(rreq, iter, &context->tag.expected, recv.queue) {
-        rreq = ucs_container_of(*iter, ucp_request_t, recv.queue);
-        if (ucp_tag_recv_is_match(recv_tag, UCP_RECV_DESC_FLAG_FIRST, rreq->recv.tag,
-                                  rreq->recv.tag_mask, rreq->recv.state.offset,
-                                  rreq->recv.info.sender_tag))
-        {
-            ucp_tag_log_match(recv_tag, rndv_rts_hdr->size, rreq, rreq->recv.tag,
-                              rreq->recv.tag_mask, rreq->recv.state.offset,
-                              "expected-rndv");
-            ucs_queue_del_iter(&context->tag.expected, iter);
-            ucp_rndv_matched(worker, rreq, rndv_rts_hdr);
-            status = UCS_OK;
-            UCP_WORKER_STAT_RNDV(worker, EXP);
-            goto out;
-        }
+    rreq = ucp_tag_exp_search(&worker->tm, recv_tag, UCP_RECV_DESC_FLAG_FIRST,
+                              &queue, &iter);
+    if (rreq != NULL) {
+        ucp_tag_log_match(recv_tag, rndv_rts_hdr->size, rreq, rreq->recv.tag,
+                          rreq->recv.tag_mask, rreq->recv.state.offset,
+                          "expected-rndv");
+        ucs_queue_del_iter(queue, iter);
+        ucp_rndv_matched(worker, rreq, rndv_rts_hdr);
+        status = UCS_OK;
+        UCP_WORKER_STAT_RNDV(worker, EXP);
+        goto out;
     }
 
     ucs_trace_req("unexp rndv recv tag %"PRIx64" length %zu desc %p",
@@ -450,11 +707,10 @@ ucp_rndv_rts_handler(void *arg, void *data, size_t length, void *desc)
     rdesc->hdr_len = sizeof(*rndv_rts_hdr);
     rdesc->flags   = UCP_RECV_DESC_FLAG_FIRST | UCP_RECV_DESC_FLAG_LAST |
                      UCP_RECV_DESC_FLAG_RNDV;
-    ucs_queue_push(&context->tag.unexpected, &rdesc->queue);
+    ucp_tag_unexp_add(&worker->tm, rdesc, recv_tag);
 
     status = UCS_INPROGRESS;
 out:
-    UCP_THREAD_CS_EXIT_CONDITIONAL(&context->mt_lock);
     return status;
 }
 
@@ -629,6 +885,154 @@ static void ucp_rndv_prepare_zcopy(ucp_request_t *sreq, ucp_ep_h ep)
     }
 }
 
+static void ucp_rndv_pipeline_complete(ucp_request_t *sreq, ucs_status_t status)
+{
+    ucp_request_send_generic_dt_finish(sreq);
+    ucp_request_complete_send(sreq, status);
+}
+
+static void ucp_rndv_pipeline_resume_slow_path_callback(ucs_callbackq_slow_elem_t *self)
+{
+    ucp_request_t *sreq = ucs_container_of(self, ucp_request_t,
+                                           send.rndv_pipeline.cbq_elem);
+
+    uct_worker_slowpath_progress_unregister(sreq->send.ep->worker->uct,
+                                            &sreq->send.rndv_pipeline.cbq_elem);
+    ucp_request_start_send(sreq);
+}
+
+static void ucp_rndv_pipeline_frag_completion(uct_completion_t *self,
+                                              ucs_status_t status)
+{
+    ucp_rndv_frag_t *frag = ucs_container_of(self, ucp_rndv_frag_t, comp);
+    ucp_request_t *sreq   = frag->sreq;
+
+    ucs_mpool_put(frag);
+    --sreq->send.rndv_pipeline.num_inflight;
+
+    if (sreq->send.state.offset == sreq->send.length) {
+        if ((sreq->send.rndv_pipeline.frag == NULL) &&
+            (sreq->send.rndv_pipeline.num_inflight == 0)) {
+            ucp_rndv_pipeline_complete(sreq, UCS_OK);
+        }
+    } else if (sreq->send.rndv_pipeline.waiting) {
+        /* a staging buffer slot is free, resume copying the next fragment.
+         * do it from the worker progress, since sending from here would
+         * re-enter the transport from its own completion callback */
+        sreq->send.rndv_pipeline.waiting     = 0;
+        sreq->send.rndv_pipeline.cbq_elem.cb =
+                        ucp_rndv_pipeline_resume_slow_path_callback;
+        uct_worker_slowpath_progress_register(sreq->send.ep->worker->uct,
+                                              &sreq->send.rndv_pipeline.cbq_elem);
+    }
+}
+
+static ucs_status_t ucp_rndv_progress_pipeline_send(uct_pending_req_t *self)
+{
+    ucp_request_t *sreq     = ucs_container_of(self, ucp_request_t, send.uct);
+    ucp_ep_t *ep            = sreq->send.ep;
+    ucp_worker_h worker     = ep->worker;
+    ucp_context_h context   = worker->context;
+    ucp_rndv_frag_t *frag   = sreq->send.rndv_pipeline.frag;
+    ucp_rndv_data_hdr_t hdr;
+    size_t max_length;
+    ucs_status_t status;
+    uct_iov_t iov;
+    uint8_t am_id;
+
+    sreq->send.lane = ucp_ep_get_am_lane(ep);
+
+    if (frag == NULL) {
+        /* copy the next fragment to a staging buffer, unless enough fragments
+         * are already in flight */
+        if (sreq->send.rndv_pipeline.num_inflight >=
+            context->config.ext.rndv_pipeline_depth) {
+            sreq->send.rndv_pipeline.waiting = 1;
+            return UCS_OK;
+        }
+
+        frag = ucs_mpool_get_inline(&worker->rndv_frag_mp);
+        if (frag == NULL) {
+            if (sreq->send.rndv_pipeline.num_inflight > 0) {
+                sreq->send.rndv_pipeline.waiting = 1;
+                return UCS_OK;
+            }
+            ucs_error("failed to allocate rendezvous staging buffer");
+            ucp_rndv_pipeline_complete(sreq, UCS_ERR_NO_MEMORY);
+            return UCS_OK;
+        }
+
+        max_length   = ucs_min(context->config.ext.rndv_frag_size,
+                               ucp_ep_config(ep)->am.max_zcopy - sizeof(hdr));
+        frag->sreq   = sreq;
+        frag->length = ucp_tag_pack_dt_copy(frag + 1, sreq->send.buffer,
+                                            &sreq->send.state,
+                                            ucs_min(max_length, sreq->send.length -
+                                                    sreq->send.state.offset),
+                                            sreq->send.datatype);
+        sreq->send.rndv_pipeline.frag = frag;
+    }
+
+    ucs_trace_data("send on sreq %p with pipeline, am lane: %d, offset: %zu, "
+                   "fragment %p length: %zu, inflight: %u", sreq, sreq->send.lane,
+                   sreq->send.state.offset, frag, frag->length,
+                   sreq->send.rndv_pipeline.num_inflight);
+
+    hdr.rreq_ptr = sreq->send.rndv_pipeline.rreq_ptr;
+    am_id        = (sreq->send.state.offset == sreq->send.length) ?
+                   UCP_AM_ID_RNDV_DATA_LAST : UCP_AM_ID_RNDV_DATA;
+
+    iov.buffer = frag + 1;
+    iov.length = frag->length;
+    iov.memh   = ucp_memh2uct(frag->super.memh,
+                              ucp_ep_md_index(ep, sreq->send.lane));
+    iov.count  = 1;
+    iov.stride = 0;
+
+    frag->comp.func  = ucp_rndv_pipeline_frag_completion;
+    frag->comp.count = 1;
+
+    status = uct_ep_am_zcopy(ep->uct_eps[sreq->send.lane], am_id, &hdr,
+                             sizeof(hdr), &iov, 1, &frag->comp);
+    if (status == UCS_OK) {
+        /* the data was sent, the staging buffer can be reused right away */
+        ucs_mpool_put(frag);
+    } else if (status == UCS_INPROGRESS) {
+        ++sreq->send.rndv_pipeline.num_inflight;
+    } else {
+        /* keep the packed fragment and send it on the next attempt */
+        return status;
+    }
+
+    sreq->send.rndv_pipeline.frag = NULL;
+
+    if (sreq->send.state.offset < sreq->send.length) {
+        return UCS_INPROGRESS;
+    }
+
+    if (sreq->send.rndv_pipeline.num_inflight == 0) {
+        ucp_rndv_pipeline_complete(sreq, UCS_OK);
+    }
+    return UCS_OK;
+}
+
+/**
+ * Whether the data of a rendezvous send request which was not registered for
+ * zero-copy should be sent through registered staging buffers, overlapping the
+ * copy of a fragment with the transfer of the previous ones.
+ */
+static int ucp_rndv_is_pipeline_possible(ucp_request_t *sreq, ucp_ep_h ep)
+{
+    ucp_context_h context   = ep->worker->context;
+    ucp_ep_config_t *config = ucp_ep_config(ep);
+    ucp_lane_index_t lane   = ucp_ep_get_am_lane(ep);
+
+    return (context->config.ext.rndv_pipeline_depth > 0) &&
+           (config->am.max_zcopy > sizeof(ucp_rndv_data_hdr_t)) &&
+           (ucp_ep_md_attr(ep, lane)->cap.flags & UCT_MD_FLAG_REG) &&
+           (sreq->send.length > config->am.max_bcopy - sizeof(ucp_rndv_data_hdr_t));
+}
+
 static ucs_status_t
 ucp_rndv_rtr_handler(void *arg, void *data, size_t length, void *desc)
 {
@@ -644,15 +1048,25 @@ ucp_rndv_rtr_handler(void *arg, void *data, size_t length, void *desc)
         (sreq->send.length >= ucp_ep_config(ep)->am.zcopy_thresh[0])) {
         /* send with zcopy */
         ucp_rndv_prepare_zcopy(sreq, ep);
+        sreq->send.proto.rreq_ptr = rndv_rtr_hdr->rreq_ptr;
+    } else if (ucp_rndv_is_pipeline_possible(sreq, ep)) {
+        /* send with bcopy to registered staging buffers, and zcopy from them */
+        ucp_rndv_rma_request_send_buffer_dereg(sreq);
+
+        sreq->send.uct.func                   = ucp_rndv_progress_pipeline_send;
+        sreq->send.rndv_pipeline.rreq_ptr     = rndv_rtr_hdr->rreq_ptr;
+        sreq->send.rndv_pipeline.frag         = NULL;
+        sreq->send.rndv_pipeline.num_inflight = 0;
+        sreq->send.rndv_pipeline.waiting      = 0;
     } else {
         /* send with bcopy */
         /* deregister the sender's buffer if it was registered */
         ucp_rndv_rma_request_send_buffer_dereg(sreq);
 
-        sreq->send.uct.func = ucp_rndv_progress_bcopy_send;
+        sreq->send.uct.func       = ucp_rndv_progress_bcopy_send;
+        sreq->send.proto.rreq_ptr = rndv_rtr_hdr->rreq_ptr;
     }
 
-    sreq->send.proto.rreq_ptr = rndv_rtr_hdr->rreq_ptr;
     ucp_request_start_send(sreq);
     return UCS_OK;
 }
@@ -10,11 +10,13 @@
 #include "match.h"
 
 #include <ucp/api/ucp.h>
+#include <ucp/core/ucp_mm.h>
 #include <ucp/core/ucp_request.h>
 #include <ucp/proto/proto.h>
 
 enum {
-    UCP_RNDV_RTS_FLAG_PACKED_RKEY  = UCS_BIT(0)
+    UCP_RNDV_RTS_FLAG_PACKED_RKEY  = UCS_BIT(0),
+    UCP_RNDV_RTS_FLAG_IOV          = UCS_BIT(1)  /* IOV descriptor follows */
 };
 
 /*
@@ -23,12 +25,23 @@ enum {
 typedef struct {
     ucp_tag_hdr_t             super;
     ucp_request_hdr_t         sreq;     /* send request on the rndv initiator side */
-    uint64_t                  address;  /* holds the address of the data buffer on the sender's side */
+    union {
+        uint64_t              address;  /* holds the address of the data buffer on the sender's side */
+        uint64_t              iovcnt;   /* number of IOV entries, if UCP_RNDV_RTS_FLAG_IOV is set */
+    };
     size_t                    size;     /* size of the data for sending */
     uint16_t                  flags;
-    /* packed rkeys follow */
+    /* packed rkey, or IOV entries each followed by its packed rkey, follow */
 } UCS_S_PACKED ucp_rndv_rts_hdr_t;
 
+/*
+ * Entry of the sender's IOV descriptor in the RTS
+ */
+typedef struct {
+    uint64_t                  address;  /* address of the IOV item on the sender's side */
+    uint64_t                  length;   /* length of the IOV item */
+} UCS_S_PACKED ucp_rndv_rts_iov_entry_t;
+
 /*
  * Rendezvous RTR
  */
@@ -44,6 +57,26 @@ typedef struct {
     uintptr_t                 rreq_ptr; /* request on the rndv receiver side */
 } UCS_S_PACKED ucp_rndv_data_hdr_t;
 
+/*
+ * Staging buffer of the pipelined rendezvous protocol, taken from the worker's
+ * pool of registered buffers. The fragment data follows the structure.
+ */
+typedef struct {
+    ucp_mem_desc_t            super;
+    uct_completion_t          comp;     /* completion of the fragment send */
+    ucp_request_t             *sreq;    /* send request the fragment belongs to */
+    size_t                    length;   /* length of the packed data */
+} ucp_rndv_frag_t;
+
+/*
+ * Entry of the sender's IOV buffer which the receiver reads with get_zcopy
+ */
+typedef struct ucp_rndv_get_iov {
+    uint64_t                  address;  /* address of the IOV item on the sender's side */
+    size_t                    length;   /* length of the IOV item */
+    uct_rkey_bundle_t         rkey_bundle;
+} ucp_rndv_get_iov_t;
+
 
 void ucp_tag_send_start_rndv(ucp_request_t *req);
 
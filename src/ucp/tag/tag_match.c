@@ -0,0 +1,52 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#include "tag_match.inl"
+
+#include <ucs/debug/log.h>
+#include <ucs/debug/memtrack.h>
+
+
+ucs_status_t ucp_tag_match_init(ucp_tag_match_t *tm)
+{
+    size_t bucket;
+
+    tm->sn = 0;
+    ucs_queue_head_init(&tm->expected.wildcard);
+    ucs_list_head_init(&tm->unexpected.all);
+
+    tm->expected.hash = ucs_malloc(sizeof(*tm->expected.hash) *
+                                   UCP_TAG_MATCH_HASH_SIZE, "ucp_tm_exp_hash");
+    if (tm->expected.hash == NULL) {
+        ucs_error("failed to allocate expected tag matching hash");
+        goto err;
+    }
+
+    tm->unexpected.hash = ucs_malloc(sizeof(*tm->unexpected.hash) *
+                                     UCP_TAG_MATCH_HASH_SIZE, "ucp_tm_unexp_hash");
+    if (tm->unexpected.hash == NULL) {
+        ucs_error("failed to allocate unexpected tag matching hash");
+        goto err_free_exp;
+    }
+
+    for (bucket = 0; bucket < UCP_TAG_MATCH_HASH_SIZE; ++bucket) {
+        ucs_queue_head_init(&tm->expected.hash[bucket]);
+        ucs_list_head_init(&tm->unexpected.hash[bucket]);
+    }
+
+    return UCS_OK;
+
+err_free_exp:
+    ucs_free(tm->expected.hash);
+err:
+    return UCS_ERR_NO_MEMORY;
+}
+
+void ucp_tag_match_cleanup(ucp_tag_match_t *tm)
+{
+    ucs_free(tm->unexpected.hash);
+    ucs_free(tm->expected.hash);
+}
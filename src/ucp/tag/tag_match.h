@@ -0,0 +1,61 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#ifndef UCP_TAG_TAG_MATCH_H_
+#define UCP_TAG_TAG_MATCH_H_
+
+#include <ucp/api/ucp.h>
+#include <ucs/datastruct/list_types.h>
+#include <ucs/datastruct/queue_types.h>
+#include <ucs/type/status.h>
+
+
+#define UCP_TAG_MASK_FULL            0xffffffffffffffffUL  /* All 1-s */
+#define UCP_TAG_MATCH_HASH_SIZE      1021                  /* Prime number */
+
+
+/**
+ * Lists which an unexpected receive descriptor belongs to
+ */
+enum {
+    UCP_RDESC_HASH_LIST = 0,   /* Descriptors with the same tag hash */
+    UCP_RDESC_ALL_LIST  = 1    /* All descriptors, in arrival order */
+};
+
+
+/**
+ * Tag matching engine.
+ *
+ * Requests posted with a full tag mask are kept in hash buckets by their tag,
+ * so an incoming message with a given tag has to check only the requests of
+ * its bucket. Requests with a partial mask are kept in a separate wildcard
+ * queue. Every request is assigned a sequence number when it is posted, and
+ * the oldest matching request among the bucket and the wildcard queue is
+ * selected, which keeps the MPI ordering semantics.
+ *
+ * Unexpected descriptors are kept both in a bucket by their tag, and in a list
+ * of all descriptors in arrival order which is used for wildcard receives.
+ */
+typedef struct ucp_tag_match {
+    uint64_t                  sn;         /* Sequence number of next request */
+
+    struct {
+        ucs_queue_head_t      *hash;      /* Requests with full tag mask */
+        ucs_queue_head_t      wildcard;   /* Requests with partial tag mask */
+    } expected;
+
+    struct {
+        ucs_list_link_t       *hash;      /* Descriptors, bucketed by tag */
+        ucs_list_link_t       all;        /* All descriptors in arrival order */
+    } unexpected;
+} ucp_tag_match_t;
+
+
+ucs_status_t ucp_tag_match_init(ucp_tag_match_t *tm);
+
+void ucp_tag_match_cleanup(ucp_tag_match_t *tm);
+
+#endif
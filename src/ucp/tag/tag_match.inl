@@ -0,0 +1,154 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#ifndef UCP_TAG_MATCH_INL_
+#define UCP_TAG_MATCH_INL_
+
+#include "tag_match.h"
+#include "match.h"
+
+#include <ucp/core/ucp_request.h>
+#include <ucs/datastruct/list.h>
+#include <ucs/datastruct/queue.h>
+
+
+static UCS_F_ALWAYS_INLINE size_t ucp_tag_match_calc_hash(ucp_tag_t tag)
+{
+    return tag % UCP_TAG_MATCH_HASH_SIZE;
+}
+
+static UCS_F_ALWAYS_INLINE ucs_queue_head_t*
+ucp_tag_exp_get_queue(ucp_tag_match_t *tm, ucp_tag_t tag, ucp_tag_t tag_mask)
+{
+    if (tag_mask == UCP_TAG_MASK_FULL) {
+        return &tm->expected.hash[ucp_tag_match_calc_hash(tag)];
+    } else {
+        return &tm->expected.wildcard;
+    }
+}
+
+/**
+ * Add a receive request to the expected queue. The request tag and tag mask
+ * must be already set.
+ */
+static UCS_F_ALWAYS_INLINE void
+ucp_tag_exp_push(ucp_tag_match_t *tm, ucp_request_t *req)
+{
+    req->recv.sn = tm->sn++;
+    ucs_queue_push(ucp_tag_exp_get_queue(tm, req->recv.tag, req->recv.tag_mask),
+                   &req->recv.queue);
+}
+
+static UCS_F_ALWAYS_INLINE ucp_request_t*
+ucp_tag_exp_search_queue(ucs_queue_head_t *queue, ucp_tag_t recv_tag,
+                         unsigned recv_flags, ucs_queue_iter_t *iter_p)
+{
+    ucs_queue_iter_t iter;
+    ucp_request_t *req;
+
+    for (iter = ucs_queue_iter_begin(queue); !ucs_queue_iter_end(queue, iter);
+         iter = ucs_queue_iter_next(iter)) {
+        req = ucs_queue_iter_elem(req, iter, recv.queue);
+        if (ucp_tag_recv_is_match(recv_tag, recv_flags, req->recv.tag,
+                                  req->recv.tag_mask, req->recv.state.offset,
+                                  req->recv.info.sender_tag)) {
+            *iter_p = iter;
+            return req;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Find the oldest expected request which matches an incoming fragment.
+ *
+ * @param [in]  tm          Tag matching context.
+ * @param [in]  recv_tag    Tag of the incoming fragment.
+ * @param [in]  recv_flags  Fragment flags (UCP_RECV_DESC_FLAG_xx).
+ * @param [out] queue_p     Filled with the queue of the returned request.
+ * @param [out] iter_p      Filled with the iterator of the returned request,
+ *                          which can be passed to ucs_queue_del_iter().
+ *
+ * @return Matching request, or NULL if not found.
+ */
+static UCS_F_ALWAYS_INLINE ucp_request_t*
+ucp_tag_exp_search(ucp_tag_match_t *tm, ucp_tag_t recv_tag, unsigned recv_flags,
+                   ucs_queue_head_t **queue_p, ucs_queue_iter_t *iter_p)
+{
+    ucs_queue_head_t *hash_queue;
+    ucs_queue_iter_t wild_iter;
+    ucp_request_t *req, *wild_req;
+
+    hash_queue = &tm->expected.hash[ucp_tag_match_calc_hash(recv_tag)];
+    req        = ucp_tag_exp_search_queue(hash_queue, recv_tag, recv_flags,
+                                          iter_p);
+    *queue_p   = hash_queue;
+
+    if (ucs_likely(ucs_queue_is_empty(&tm->expected.wildcard))) {
+        return req;
+    }
+
+    /* If both queues have a matching request, take the one posted first */
+    wild_req = ucp_tag_exp_search_queue(&tm->expected.wildcard, recv_tag,
+                                        recv_flags, &wild_iter);
+    if ((wild_req != NULL) && ((req == NULL) || (wild_req->recv.sn < req->recv.sn))) {
+        *queue_p = &tm->expected.wildcard;
+        *iter_p  = wild_iter;
+        return wild_req;
+    }
+
+    return req;
+}
+
+static UCS_F_ALWAYS_INLINE ucs_list_link_t*
+ucp_tag_unexp_get_list(ucp_tag_match_t *tm, ucp_tag_t tag, ucp_tag_t tag_mask,
+                       int *i_p)
+{
+    if (tag_mask == UCP_TAG_MASK_FULL) {
+        *i_p = UCP_RDESC_HASH_LIST;
+        return &tm->unexpected.hash[ucp_tag_match_calc_hash(tag)];
+    } else {
+        *i_p = UCP_RDESC_ALL_LIST;
+        return &tm->unexpected.all;
+    }
+}
+
+/* Get the descriptor which contains the i-th tag list link */
+static UCS_F_ALWAYS_INLINE ucp_recv_desc_t*
+ucp_tag_unexp_list_elem(ucs_list_link_t *link, int i)
+{
+    return ucs_container_of(link - i, ucp_recv_desc_t, tag_list);
+}
+
+static UCS_F_ALWAYS_INLINE ucp_recv_desc_t*
+ucp_tag_unexp_list_next(ucp_recv_desc_t *rdesc, int i)
+{
+    return ucp_tag_unexp_list_elem(rdesc->tag_list[i].next, i);
+}
+
+static UCS_F_ALWAYS_INLINE int
+ucp_tag_unexp_is_empty(ucp_tag_match_t *tm)
+{
+    return ucs_list_is_empty(&tm->unexpected.all);
+}
+
+static UCS_F_ALWAYS_INLINE void
+ucp_tag_unexp_add(ucp_tag_match_t *tm, ucp_recv_desc_t *rdesc, ucp_tag_t tag)
+{
+    ucs_list_add_tail(&tm->unexpected.hash[ucp_tag_match_calc_hash(tag)],
+                      &rdesc->tag_list[UCP_RDESC_HASH_LIST]);
+    ucs_list_add_tail(&tm->unexpected.all, &rdesc->tag_list[UCP_RDESC_ALL_LIST]);
+}
+
+static UCS_F_ALWAYS_INLINE void
+ucp_tag_unexp_remove(ucp_recv_desc_t *rdesc)
+{
+    ucs_list_del(&rdesc->tag_list[UCP_RDESC_HASH_LIST]);
+    ucs_list_del(&rdesc->tag_list[UCP_RDESC_ALL_LIST]);
+}
+
+#endif
@@ -4,9 +4,9 @@
  * See file LICENSE for terms.
  */
 
-#include "match.h"
 #include "eager.h"
 #include "rndv.h"
+#include "tag_match.inl"
 
 #include <ucp/core/ucp_worker.h>
 #include <ucp/core/ucp_request.inl>
@@ -20,15 +20,18 @@ ucp_tag_search_unexp(ucp_worker_h worker, void *buffer, size_t count,
                      ucp_datatype_t datatype, ucp_tag_t tag, uint64_t tag_mask,
                      ucp_request_t *req, ucp_tag_recv_info_t *info, unsigned *save_rreq)
 {
-    ucp_context_h context = worker->context;
-    ucp_recv_desc_t *rdesc;
+    ucp_recv_desc_t *rdesc, *next;
+    ucs_list_link_t *list;
     ucp_tag_hdr_t *hdr;
-    ucs_queue_iter_t iter;
     ucs_status_t status;
     ucp_tag_t recv_tag;
     unsigned flags;
+    int i;
 
-    ucs_queue_for_each_safe(rdesc, iter, &context->tag.unexpected, queue) {
+    list = ucp_tag_unexp_get_list(&worker->tm, tag, tag_mask, &i);
+    for (rdesc = ucp_tag_unexp_list_elem(list->next, i);
+         &rdesc->tag_list[i] != list; rdesc = next) {
+        next     = ucp_tag_unexp_list_next(rdesc, i);
         hdr      = (void*)(rdesc + 1);
         recv_tag = hdr->tag;
         flags    = rdesc->flags;
@@ -46,7 +49,7 @@ ucp_tag_search_unexp(ucp_worker_h worker, void *buffer, size_t count,
         {
             ucp_tag_log_match(recv_tag, rdesc->length - rdesc->hdr_len, req, tag,
                               tag_mask, req->recv.state.offset, "unexpected");
-            ucs_queue_del_iter(&context->tag.unexpected, iter);
+            ucp_tag_unexp_remove(rdesc);
             if (rdesc->flags & UCP_RECV_DESC_FLAG_EAGER) {
                 status = ucp_eager_unexp_match(worker, rdesc, recv_tag, flags,
                                                buffer, count, datatype,
@@ -162,7 +165,7 @@ ucp_tag_recv_common(ucp_worker_h worker, void *buffer, size_t count,
         req->recv.datatype = datatype;
         req->recv.tag      = tag;
         req->recv.tag_mask = tag_mask;
-        ucs_queue_push(&worker->context->tag.expected, &req->recv.queue);
+        ucp_tag_exp_push(&worker->tm, req);
         ucs_trace_req("recv_nb%c returning expected request %p (%p)",
                       (req->flags & UCP_REQUEST_FLAG_EXTERNAL) ? 'r' : ' ',
                       req, req + 1);
@@ -179,7 +182,6 @@ ucs_status_t ucp_tag_recv_nbr(ucp_worker_h worker, void *buffer, size_t count,
     ucs_status_t status;
 
     UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
-    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->context->mt_lock);
 
     ucp_tag_recv_request_init(req, worker, buffer, count, datatype,
                               UCP_REQUEST_FLAG_EXTERNAL);
@@ -195,7 +197,6 @@ ucs_status_t ucp_tag_recv_nbr(ucp_worker_h worker, void *buffer, size_t count,
         ucp_tag_recv_request_completed(req, status, &req->recv.info, "recv_nbr");
     }
 
-    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->context->mt_lock);
     UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
     return status;
 }
@@ -210,7 +211,6 @@ ucs_status_ptr_t ucp_tag_recv_nb(ucp_worker_h worker, void *buffer,
     ucs_status_ptr_t ret;
 
     UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
-    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->context->mt_lock);
 
     req = ucp_tag_recv_request_get(worker, buffer, count, datatype);
     if (ucs_unlikely(req == NULL)) {
@@ -233,7 +233,6 @@ ucs_status_ptr_t ucp_tag_recv_nb(ucp_worker_h worker, void *buffer,
 
     ret = req + 1;
 out:
-    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->context->mt_lock);
     UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
     return ret;
 }
@@ -251,7 +250,6 @@ ucs_status_ptr_t ucp_tag_msg_recv_nb(ucp_worker_h worker, void *buffer,
     ucs_status_ptr_t ret;
 
     UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
-    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->context->mt_lock);
 
     ucs_trace_req("msg_recv_nb buffer %p count %zu message %p", buffer, count,
                   message);
@@ -293,9 +291,11 @@ ucs_status_ptr_t ucp_tag_msg_recv_nb(ucp_worker_h worker, void *buffer,
     /* Since the message contains only the first fragment, we might want
      * to receive additional fragments.
      */
-    if (status == UCS_INPROGRESS) {
-        status = ucp_tag_search_unexp(worker, buffer, count, datatype, 0,
-                                      -1, req, &req->recv.info, &save_rreq);
+    if ((status == UCS_INPROGRESS) && save_rreq) {
+        status = ucp_tag_search_unexp(worker, buffer, count, datatype,
+                                      req->recv.info.sender_tag,
+                                      UCP_TAG_MASK_FULL, req, &req->recv.info,
+                                      &save_rreq);
     }
 
     if (status != UCS_INPROGRESS) {
@@ -310,24 +310,28 @@ ucs_status_ptr_t ucp_tag_msg_recv_nb(ucp_worker_h worker, void *buffer,
         req->recv.buffer   = buffer;
         req->recv.count    = count;
         req->recv.datatype = datatype;
-        ucs_queue_push(&worker->context->tag.expected, &req->recv.queue);
+        req->recv.tag      = req->recv.info.sender_tag;
+        req->recv.tag_mask = UCP_TAG_MASK_FULL;
+        ucp_tag_exp_push(&worker->tm, req);
     }
 
     ret = req + 1;
 out:
-    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->context->mt_lock);
     UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
     return ret;
 }
 
-void ucp_tag_cancel_expected(ucp_context_h context, ucp_request_t *req)
+void ucp_tag_cancel_expected(ucp_worker_h worker, ucp_request_t *req)
 {
+    ucs_queue_head_t *queue;
     ucs_queue_iter_t iter;
     ucp_request_t *qreq;
 
-    ucs_queue_for_each_safe(qreq, iter, &context->tag.expected, recv.queue) {
+    queue = ucp_tag_exp_get_queue(&worker->tm, req->recv.tag,
+                                  req->recv.tag_mask);
+    ucs_queue_for_each_safe(qreq, iter, queue, recv.queue) {
         if (qreq == req) {
-            ucs_queue_del_iter(&context->tag.expected, iter);
+            ucs_queue_del_iter(queue, iter);
             UCS_INSTRUMENT_RECORD(UCS_INSTRUMENT_TYPE_UCP_RX,
                                   "ucp_tag_cancel_expected",
                                   req, 0);
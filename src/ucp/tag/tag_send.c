@@ -57,6 +57,20 @@ static ucs_status_t ucp_tag_req_start(ucp_request_t *req, size_t count,
                                worker->context,
                                worker->iface_attrs[rsc_index].bandwidth);
         }
+    } else if (UCP_DT_IS_STRIDED(req->send.datatype)) {
+        length          = ucp_dt_strided_length(req->send.datatype, count);
+        flag_iov_single = (ucp_dt_strided_num_blocks(req->send.datatype, 0,
+                                                     length) <=
+                           config->am.max_iovcnt);
+        /* Zero copy is worth only if the blocks are large enough to fill a
+         * fragment with the iov entries available */
+        if ((length == 0) ||
+            ((ucp_dt_strided(req->send.datatype)->block * config->am.max_iovcnt) <
+             ucs_min(length, config->am.max_zcopy - only_hdr_size))) {
+            zcopy_thresh = SIZE_MAX;
+        } else {
+            zcopy_thresh = zcopy_thresh_arr[0];
+        }
     } else {
         length       = ucp_contig_dt_length(req->send.datatype, count);
         zcopy_thresh = count ? zcopy_thresh_arr[0] : SIZE_MAX;
@@ -69,12 +83,12 @@ static ucs_status_t ucp_tag_req_start(ucp_request_t *req, size_t count,
                   req, req->send.datatype, req->send.buffer, length, max_short,
                   rndv_rma_thresh, rndv_am_thresh, zcopy_thresh);
 
-    if (((ssize_t)length <= max_short) && !is_iov) {
+    if (((ssize_t)length <= max_short) && UCP_DT_IS_CONTIG(req->send.datatype)) {
         /* short */
         req->send.uct.func = proto->contig_short;
-    } else if ((((config->key.rndv_lane != UCP_NULL_RESOURCE) &&
-               (length >= rndv_rma_thresh)) ||
-               (length >= rndv_am_thresh)) && !is_iov) {
+    } else if (((config->key.rndv_lanes[0] != UCP_NULL_LANE) &&
+                (length >= rndv_rma_thresh)) ||
+               (length >= rndv_am_thresh)) {
         /* RMA/AM rendezvous */
         ucp_tag_send_start_rndv(req);
     } else if (length < zcopy_thresh) {
@@ -142,7 +156,7 @@ static void ucp_send_req_stat(ucp_request_t *req)
     }
 }
 
-static inline ucs_status_ptr_t
+ucs_status_ptr_t
 ucp_tag_send_req(ucp_request_t *req, size_t count, ssize_t max_short,
                  size_t *zcopy_thresh, size_t rndv_rma_thresh, size_t rndv_am_thresh,
                  ucp_send_callback_t cb, const ucp_proto_t *proto)
@@ -152,6 +166,7 @@ ucp_tag_send_req(ucp_request_t *req, size_t count, ssize_t max_short,
     switch (req->send.datatype & UCP_DATATYPE_CLASS_MASK) {
     case UCP_DATATYPE_CONTIG:
     case UCP_DATATYPE_IOV:
+    case UCP_DATATYPE_STRIDED:
         status = ucp_tag_req_start(req, count, max_short, zcopy_thresh,
                                    rndv_rma_thresh, rndv_am_thresh, proto);
         if (status != UCS_OK) {
@@ -312,6 +327,7 @@ void ucp_tag_eager_sync_send_ack(ucp_worker_h worker, uint64_t sender_uuid,
                   sender_uuid, remote_request);
 
     req = ucp_worker_allocate_reply(worker, sender_uuid);
+    req->flags                    |= UCP_REQUEST_FLAG_CONTROL;
     req->send.uct.func             = ucp_proto_progress_am_bcopy_single;
     req->send.proto.am_id          = UCP_AM_ID_EAGER_SYNC_ACK;
     req->send.proto.remote_request = remote_request;
@@ -345,6 +361,11 @@ size_t ucp_tag_pack_dt_copy(void *dest, const void *src, ucp_frag_state_t *state
         result_len = length;
         break;
 
+    case UCP_DATATYPE_STRIDED:
+        ucp_dt_strided_gather(dest, src, datatype, state->offset, length);
+        result_len = length;
+        break;
+
     case UCP_DATATYPE_GENERIC:
         dt = ucp_dt_generic(datatype);
         result_len = dt->ops.pack(state->dt.generic.state, state->offset, dest,
@@ -29,6 +29,7 @@ typedef struct {
     uint32_t          usage;
     double            rma_score;
     double            amo_score;
+    double            rndv_score;
 } ucp_wireup_lane_desc_t;
 
 
@@ -324,6 +325,7 @@ ucp_wireup_add_lane_desc(ucp_wireup_lane_desc_t *lane_descs,
     lane_desc->usage        = usage;
     lane_desc->rma_score    = 0.0;
     lane_desc->amo_score    = 0.0;
+    lane_desc->rndv_score   = 0.0;
 
 out_update_score:
     if (usage & UCP_WIREUP_LANE_USAGE_RMA) {
@@ -332,6 +334,9 @@ out_update_score:
     if (usage & UCP_WIREUP_LANE_USAGE_AMO) {
         lane_desc->amo_score = score;
     }
+    if (usage & UCP_WIREUP_LANE_USAGE_RNDV) {
+        lane_desc->rndv_score = score;
+    }
 }
 
 static int ucp_wireup_compare_score(double score1, double score2)
@@ -358,6 +363,16 @@ static int ucp_wireup_compare_lane_amo_score(const void *elem1, const void *elem
     return ucp_wireup_compare_score(lanes[*lane1].amo_score, lanes[*lane2].amo_score);
 }
 
+static int ucp_wireup_compare_lane_rndv_score(const void *elem1, const void *elem2,
+                                              void *arg)
+{
+    const ucp_lane_index_t *lane1  = elem1;
+    const ucp_lane_index_t *lane2  = elem2;
+    const ucp_wireup_lane_desc_t *lanes = arg;
+
+    return ucp_wireup_compare_score(lanes[*lane1].rndv_score, lanes[*lane2].rndv_score);
+}
+
 static UCS_F_NOINLINE ucs_status_t
 ucp_wireup_add_memaccess_lanes(ucp_ep_h ep, unsigned address_count,
                                const ucp_address_entry_t *address_list,
@@ -568,7 +583,7 @@ static ucs_status_t ucp_wireup_add_am_lane(ucp_ep_h ep, unsigned address_count,
     int need_am;
 
     /* Check if we need active messages, for wireup */
-    if (!(ucp_ep_get_context_features(ep) & UCP_FEATURE_TAG)) {
+    if (!(ucp_ep_get_context_features(ep) & (UCP_FEATURE_TAG | UCP_FEATURE_AM))) {
         need_am = 0;
         for (lane = 0; lane < *num_lanes_p; ++lane) {
             need_am = need_am || ucp_worker_is_tl_p2p(ep->worker,
@@ -588,8 +603,8 @@ static ucs_status_t ucp_wireup_add_am_lane(ucp_ep_h ep, unsigned address_count,
     criteria.local_iface_flags  = UCT_IFACE_FLAG_AM_BCOPY;
     criteria.calc_score         = ucp_wireup_am_score_func;
 
-    if (ucs_test_all_flags(ucp_ep_get_context_features(ep), UCP_FEATURE_TAG |
-                                                            UCP_FEATURE_WAKEUP)) {
+    if ((ucp_ep_get_context_features(ep) & UCP_FEATURE_WAKEUP) &&
+        (ucp_ep_get_context_features(ep) & (UCP_FEATURE_TAG | UCP_FEATURE_AM))) {
         criteria.remote_iface_flags |= UCT_IFACE_FLAG_WAKEUP;
     }
 
@@ -605,22 +620,25 @@ static ucs_status_t ucp_wireup_add_am_lane(ucp_ep_h ep, unsigned address_count,
     return UCS_OK;
 }
 
-static ucs_status_t ucp_wireup_add_rndv_lane(ucp_ep_h ep, unsigned address_count,
-                                             const ucp_address_entry_t *address_list,
-                                             ucp_wireup_lane_desc_t *lane_descs,
-                                             ucp_lane_index_t *num_lanes_p)
+static ucs_status_t ucp_wireup_add_rndv_lanes(ucp_ep_h ep, unsigned address_count,
+                                              const ucp_address_entry_t *address_list,
+                                              ucp_wireup_lane_desc_t *lane_descs,
+                                              ucp_lane_index_t *num_lanes_p)
 {
+    ucp_context_h context = ep->worker->context;
     ucp_wireup_criteria_t criteria;
-    ucp_rsc_index_t rsc_index;
+    ucp_rsc_index_t rsc_index, md_index, dst_md_index, tl_id;
+    unsigned num_rndv_lanes;
     ucs_status_t status;
     unsigned addr_index;
+    uint64_t tl_bitmap;
     double score;
 
     if (!(ucp_ep_get_context_features(ep) & UCP_FEATURE_TAG)) {
         return UCS_OK;
     }
 
-    /* Select one lane for the Rendezvous protocol (for the actual data. not for rts/rtr) */
+    /* Select lanes for the Rendezvous protocol (for the actual data. not for rts/rtr) */
     criteria.title              = "rendezvous";
     criteria.local_md_flags     = UCT_MD_FLAG_REG;
     criteria.remote_md_flags    = UCT_MD_FLAG_REG;  /* TODO not all ucts need reg on remote side */
@@ -635,12 +653,42 @@ static ucs_status_t ucp_wireup_add_rndv_lane(ucp_ep_h ep, unsigned address_count
 
     status = ucp_wireup_select_transport(ep, address_list, address_count, &criteria,
                                          -1, -1, 0, &rsc_index, &addr_index, &score);
-    if ((status == UCS_OK) &&
+    if ((status != UCS_OK) ||
         /* a temporary workaround to prevent the ugni uct from using rndv */
-        (strstr(ep->worker->context->tl_rscs[rsc_index].tl_rsc.tl_name, "ugni") == NULL)) {
-         ucp_wireup_add_lane_desc(lane_descs, num_lanes_p, rsc_index, addr_index,
-                                 address_list[addr_index].md_index, score,
-                                 UCP_WIREUP_LANE_USAGE_RNDV);
+        (strstr(context->tl_rscs[rsc_index].tl_rsc.tl_name, "ugni") != NULL)) {
+        return UCS_OK;
+    }
+
+    dst_md_index = address_list[addr_index].md_index;
+    md_index     = context->tl_rscs[rsc_index].md_index;
+    ucp_wireup_add_lane_desc(lane_descs, num_lanes_p, rsc_index, addr_index,
+                             dst_md_index, score, UCP_WIREUP_LANE_USAGE_RNDV);
+
+    /* Additional lanes must use the same local and remote memory domains, so
+     * the buffers registered for the first lane could be used on all of them.
+     */
+    tl_bitmap = 0;
+    for (tl_id = 0; tl_id < context->num_tls; ++tl_id) {
+        if ((tl_id != rsc_index) && (context->tl_rscs[tl_id].md_index == md_index)) {
+            tl_bitmap |= UCS_BIT(tl_id);
+        }
+    }
+
+    for (num_rndv_lanes = 1;
+         (num_rndv_lanes < context->config.ext.max_rndv_lanes) &&
+         (*num_lanes_p < UCP_MAX_LANES) && (tl_bitmap != 0);
+         ++num_rndv_lanes) {
+        status = ucp_wireup_select_transport(ep, address_list, address_count,
+                                             &criteria, tl_bitmap,
+                                             UCS_BIT(dst_md_index), 0,
+                                             &rsc_index, &addr_index, &score);
+        if (status != UCS_OK) {
+            break;
+        }
+
+        ucp_wireup_add_lane_desc(lane_descs, num_lanes_p, rsc_index, addr_index,
+                                 dst_md_index, score, UCP_WIREUP_LANE_USAGE_RNDV);
+        tl_bitmap &= ~UCS_BIT(rsc_index);
     }
 
     return UCS_OK;
@@ -713,6 +761,7 @@ ucs_status_t ucp_wireup_select_lanes(ucp_ep_h ep, unsigned address_count,
 {
     ucp_worker_h worker            = ep->worker;
     ucp_lane_index_t num_amo_lanes = 0;
+    ucp_lane_index_t num_rndv_lanes = 0;
     ucp_wireup_lane_desc_t lane_descs[UCP_MAX_LANES];
     ucp_rsc_index_t rsc_index, dst_md_index;
     ucp_lane_index_t lane;
@@ -739,8 +788,8 @@ ucs_status_t ucp_wireup_select_lanes(ucp_ep_h ep, unsigned address_count,
         return status;
     }
 
-    status = ucp_wireup_add_rndv_lane(ep, address_count, address_list,
-                                      lane_descs, &key->num_lanes);
+    status = ucp_wireup_add_rndv_lanes(ep, address_count, address_list,
+                                       lane_descs, &key->num_lanes);
     if (status != UCS_OK) {
         return status;
     }
@@ -763,7 +812,6 @@ ucs_status_t ucp_wireup_select_lanes(ucp_ep_h ep, unsigned address_count,
      * - if AM lane exists and fits for wireup messages, select it for this purpose.
      */
     key->am_lane   = UCP_NULL_LANE;
-    key->rndv_lane = UCP_NULL_LANE;
     for (lane = 0; lane < key->num_lanes; ++lane) {
         rsc_index          = lane_descs[lane].rsc_index;
         dst_md_index       = lane_descs[lane].dst_md_index;
@@ -783,8 +831,8 @@ ucs_status_t ucp_wireup_select_lanes(ucp_ep_h ep, unsigned address_count,
             ++num_amo_lanes;
         }
         if (lane_descs[lane].usage & UCP_WIREUP_LANE_USAGE_RNDV) {
-            ucs_assert(key->rndv_lane == UCP_NULL_LANE);
-            key->rndv_lane = lane;
+            key->rndv_lanes[num_rndv_lanes] = lane;
+            ++num_rndv_lanes;
         }
     }
 
@@ -800,6 +848,13 @@ ucs_status_t ucp_wireup_select_lanes(ucp_ep_h ep, unsigned address_count,
         }
     }
 
+    /* Sort rendezvous lanes, the best one is used for memory registration */
+    ucs_qsort_r(key->rndv_lanes, num_rndv_lanes, sizeof(*key->rndv_lanes),
+                ucp_wireup_compare_lane_rndv_score, lane_descs);
+    for (lane = num_rndv_lanes; lane < UCP_MAX_LANES; ++lane) {
+        key->rndv_lanes[lane] = UCP_NULL_LANE;
+    }
+
     key->reachable_md_map = ucp_wireup_get_reachable_mds(worker, address_count,
                                                          address_list);
     key->wireup_msg_lane  = ucp_wireup_select_wireup_msg_lane(worker, address_list,
@@ -47,7 +47,7 @@ static ucs_status_t ucp_stub_ep_connect_to_ep(uct_ep_h uct_ep,
     return uct_ep_connect_to_ep(stub_ep->next_ep, dev_addr, ep_addr);
 }
 
-void ucp_stub_ep_progress(ucp_stub_ep_t *stub_ep)
+unsigned ucp_stub_ep_progress(ucp_stub_ep_t *stub_ep)
 {
     ucp_ep_h ep = stub_ep->ep;
     ucs_queue_head_t tmp_pending_queue;
@@ -61,7 +61,7 @@ void ucp_stub_ep_progress(ucp_stub_ep_t *stub_ep)
 
     /* If we still have pending wireup messages, send them out first */
     if (stub_ep->pending_count != 0) {
-        return;
+        return 0;
     }
 
     ucs_trace("ep %p: switching stub_ep %p to ready state", ep, stub_ep);
@@ -97,6 +97,8 @@ void ucp_stub_ep_progress(ucp_stub_ep_t *stub_ep)
         ucp_request_start_send(req);
         --ep->worker->stub_pend_count;
     }
+
+    return 1;
 }
 
 static ucs_status_t ucp_stub_ep_send_func(uct_ep_h uct_ep)
@@ -154,7 +156,9 @@ static void ucp_stub_ep_pending_req_release(uct_pending_req_t *self,
     ucs_mpool_put(proxy_req);
 }
 
-static ucs_status_t ucp_stub_pending_add(uct_ep_h uct_ep, uct_pending_req_t *req)
+static ucs_status_t ucp_stub_pending_add_prio(uct_ep_h uct_ep,
+                                              uct_pending_req_t *req,
+                                              uct_pending_prio_t prio)
 {
     ucp_stub_ep_t *stub_ep = ucs_derived_of(uct_ep, ucp_stub_ep_t);
     ucp_ep_h ep = stub_ep->ep;
@@ -176,7 +180,8 @@ static ucs_status_t ucp_stub_pending_add(uct_ep_h uct_ep, uct_pending_req_t *req
         proxy_req->send.proxy.req     = req;
         proxy_req->send.proxy.stub_ep = stub_ep;
 
-        status = uct_ep_pending_add(wireup_msg_ep, &proxy_req->send.uct);
+        status = uct_ep_pending_add_prio(wireup_msg_ep, &proxy_req->send.uct,
+                                         prio);
         if (status == UCS_OK) {
             ucs_atomic_add32(&stub_ep->pending_count, +1);
         } else {
@@ -192,6 +197,11 @@ out:
     return status;
 }
 
+static ucs_status_t ucp_stub_pending_add(uct_ep_h uct_ep, uct_pending_req_t *req)
+{
+    return ucp_stub_pending_add_prio(uct_ep, req, UCT_PENDING_PRIO_BULK);
+}
+
 static void ucp_stub_pending_purge(uct_ep_h uct_ep,
                                    uct_pending_purge_callback_t cb,
                                    void *arg)
@@ -229,6 +239,7 @@ static uct_iface_t ucp_stub_iface = {
         .ep_flush             = (void*)ucs_empty_function_return_no_resource,
         .ep_destroy           = UCS_CLASS_DELETE_FUNC_NAME(ucp_stub_ep_t),
         .ep_pending_add       = ucp_stub_pending_add,
+        .ep_pending_add_prio  = ucp_stub_pending_add_prio,
         .ep_pending_purge     = ucp_stub_pending_purge,
         .ep_put_short         = (void*)ucp_stub_ep_send_func,
         .ep_put_bcopy         = (void*)ucp_stub_ep_bcopy_send_func,
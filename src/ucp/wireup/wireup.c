@@ -95,7 +95,7 @@ static ucs_status_t ucp_wireup_msg_send(ucp_ep_h ep, uint8_t type,
         return UCS_ERR_NO_MEMORY;
     }
 
-    req->flags                   = 0;
+    req->flags                   = UCP_REQUEST_FLAG_CONTROL;
     req->send.ep                 = ep;
     req->send.wireup.type        = type;
     req->send.uct.func           = ucp_wireup_msg_progress;
@@ -463,6 +463,11 @@ static void ucp_wireup_print_config(ucp_context_h context,
             p += strlen(p);
         }
 
+        if (ucp_ep_config_is_rndv_lane(key, lane)) {
+            snprintf(p, endp - p, "[rndv]");
+            p += strlen(p);
+        }
+
         if (key->wireup_msg_lane == lane) {
             snprintf(p, endp - p, "[wireup]");
             p += strlen(p);
@@ -420,6 +420,28 @@ int ucs_config_sprintf_memunits(char *buf, size_t max, void *src, const void *ar
     return 1;
 }
 
+int ucs_config_sscanf_ulunits(const char *buf, void *dest, const void *arg)
+{
+    /* Special value: infinity */
+    if (!strcasecmp(buf, "inf")) {
+        *(unsigned long*)dest = UCS_CONFIG_ULUNITS_INF;
+        return 1;
+    }
+
+    return ucs_config_sscanf_ulong(buf, dest, arg);
+}
+
+int ucs_config_sprintf_ulunits(char *buf, size_t max, void *src, const void *arg)
+{
+    unsigned long val = *(unsigned long*)src;
+
+    if (val == UCS_CONFIG_ULUNITS_INF) {
+        return snprintf(buf, max, "inf");
+    }
+
+    return ucs_config_sprintf_ulong(buf, max, src, arg);
+}
+
 int ucs_config_sscanf_range_spec(const char *buf, void *dest, const void *arg)
 {
     ucs_range_spec_t *range_spec = dest;
@@ -9,6 +9,7 @@
 
 
 #include <ucs/sys/compiler_def.h>
+#include <limits.h>
 
 /**
  * Logging levels.
@@ -79,6 +80,8 @@ typedef enum {
 #define UCS_CONFIG_MEMUNITS_INF    SIZE_MAX
 #define UCS_CONFIG_MEMUNITS_AUTO   (SIZE_MAX - 1)
 
+#define UCS_CONFIG_ULUNITS_INF     ULONG_MAX
+
 
 /**
  * Structure type for array configuration. Should be used inside the configuration
@@ -7,12 +7,25 @@
 #include "arbiter.h"
 
 #include <ucs/debug/log.h>
+#include <limits.h>
 
 #define SENTINEL ((ucs_arbiter_elem_t*)0x1)
 
 void ucs_arbiter_init(ucs_arbiter_t *arbiter)
 {
-    arbiter->current = NULL;
+    int prio;
+
+    for (prio = 0; prio < UCS_ARBITER_PRIO_LAST; ++prio) {
+        arbiter->current[prio] = NULL;
+        arbiter->weight[prio]  = 0;
+    }
+}
+
+void ucs_arbiter_set_weight(ucs_arbiter_t *arbiter, ucs_arbiter_prio_t prio,
+                            unsigned weight)
+{
+    ucs_assert(prio < UCS_ARBITER_PRIO_LAST);
+    arbiter->weight[prio] = weight;
 }
 
 void ucs_arbiter_group_init(ucs_arbiter_group_t *group)
@@ -22,7 +35,7 @@ void ucs_arbiter_group_init(ucs_arbiter_group_t *group)
 
 void ucs_arbiter_cleanup(ucs_arbiter_t *arbiter)
 {
-    ucs_assert(arbiter->current == NULL);
+    ucs_assert(ucs_arbiter_is_empty(arbiter));
 }
 
 void ucs_arbiter_group_cleanup(ucs_arbiter_group_t *group)
@@ -31,19 +44,50 @@ void ucs_arbiter_group_cleanup(ucs_arbiter_group_t *group)
 }
 
 void ucs_arbiter_group_push_elem_always(ucs_arbiter_group_t *group, ucs_arbiter_elem_t *elem)
+{
+    ucs_arbiter_group_push_elem_prio_always(group, elem, UCS_ARBITER_PRIO_BULK);
+}
+
+void ucs_arbiter_group_push_elem_prio_always(ucs_arbiter_group_t *group,
+                                             ucs_arbiter_elem_t *elem,
+                                             ucs_arbiter_prio_t prio)
 {
     ucs_arbiter_elem_t *tail = group->tail;
+    ucs_arbiter_elem_t *head, *prev;
+
+    ucs_assert(prio < UCS_ARBITER_PRIO_LAST);
+    elem->prio  = prio;
+    elem->group = group;  /* Always point to group */
 
     if (tail == NULL) {
         elem->list.next = NULL;   /* Not scheduled yet */
         elem->next      = elem;   /* Connect to itself */
-    } else {
-        elem->next = tail->next;  /* Point to first element */
-        tail->next = elem;        /* Point previous element to new one */
+        group->tail     = elem;   /* Update group tail */
+        return;
     }
 
-    elem->group = group;  /* Always point to group */
-    group->tail = elem;   /* Update group tail */
+    /* If the first element is being dispatched, its next pointer is cleared,
+     * so just add the new element at the end */
+    head = tail->next;
+    if ((tail->prio >= prio) || (head == NULL) || (head->next == NULL)) {
+        elem->next  = tail->next; /* Point to first element */
+        tail->next  = elem;       /* Point previous element to new one */
+        group->tail = elem;       /* Update group tail */
+        return;
+    }
+
+    /* Skip the first element and all elements of the same or higher priority.
+     * Since the tail has lower priority, it is never passed. */
+    prev = head;
+    while ((prev != tail) && (prev->next->prio >= prio)) {
+        prev = prev->next;
+    }
+
+    elem->next = prev->next;
+    prev->next = elem;
+    if (prev == tail) {
+        group->tail = elem;
+    }
 }
 
 void ucs_arbiter_group_head_desched(ucs_arbiter_t *arbiter,
@@ -56,9 +100,9 @@ void ucs_arbiter_group_head_desched(ucs_arbiter_t *arbiter,
     }
 
     /* If this group is the next to be scheduled, skip it */
-    if (arbiter->current == head) {
+    if (arbiter->current[head->prio] == head) {
         next = ucs_list_next(&head->list, ucs_arbiter_elem_t, list);
-        arbiter->current = (next == head) ? NULL : next;
+        arbiter->current[head->prio] = (next == head) ? NULL : next;
     }
 
     ucs_list_del(&head->list);
@@ -109,17 +153,27 @@ void ucs_arbiter_group_schedule_nonempty(ucs_arbiter_t *arbiter,
         return; /* Already scheduled */
     }
 
-    current = arbiter->current;
+    current = arbiter->current[head->prio];
     if (current == NULL) {
         ucs_list_head_init(&head->list);
-        arbiter->current = head;
+        arbiter->current[head->prio] = head;
     } else {
         ucs_list_insert_before(&current->list, &head->list);
     }
 }
 
-void ucs_arbiter_dispatch_nonempty(ucs_arbiter_t *arbiter, unsigned per_group,
-                                   ucs_arbiter_callback_t cb, void *cb_arg)
+/*
+ * Dispatch the groups of a single priority level, until either the level
+ * becomes empty, max_groups groups were dispatched, or the callback returns
+ * STOP.
+ *
+ * @return Nonzero if the callback returned STOP.
+ */
+static int ucs_arbiter_dispatch_prio(ucs_arbiter_t *arbiter,
+                                     ucs_arbiter_prio_t prio, unsigned per_group,
+                                     unsigned max_groups,
+                                     ucs_arbiter_callback_t cb, void *cb_arg,
+                                     ucs_list_link_t *resched_groups)
 {
     ucs_arbiter_elem_t *group_head, *last_elem, *elem, *next_elem;
     ucs_list_link_t *elem_list_next;
@@ -127,9 +181,8 @@ void ucs_arbiter_dispatch_nonempty(ucs_arbiter_t *arbiter, unsigned per_group,
     ucs_arbiter_group_t *group;
     ucs_arbiter_cb_result_t result;
     unsigned group_dispatch_count;
-    UCS_LIST_HEAD(resched_groups);
 
-    next_group = arbiter->current;
+    next_group = arbiter->current[prio];
     ucs_assert(next_group != NULL);
 
     do {
@@ -138,6 +191,7 @@ void ucs_arbiter_dispatch_nonempty(ucs_arbiter_t *arbiter, unsigned per_group,
         next_group    = ucs_list_next(&group_head->list, ucs_arbiter_elem_t, list);
         ucs_assert(prev_group->list.next == &group_head->list);
         ucs_assert(next_group->list.prev == &group_head->list);
+        ucs_assert(group_head->prio == prio);
 
         group_dispatch_count = 0;
         group         = group_head->group;
@@ -174,6 +228,20 @@ void ucs_arbiter_dispatch_nonempty(ucs_arbiter_t *arbiter, unsigned per_group,
                         prev_group->list.next = &next_group->list;
                         next_group->list.prev = &prev_group->list;
                     }
+                } else if (next_elem->prio != prio) {
+                    /* The next element has a different priority, move the
+                     * group to the queue of that priority */
+                    ucs_assert(elem == last_elem->next);
+                    if (group_head == prev_group) {
+                        next_group = NULL; /* No more groups */
+                    } else {
+                        prev_group->list.next = &next_group->list;
+                        next_group->list.prev = &prev_group->list;
+                    }
+                    last_elem->next      = next_elem; /* Tail points to new head */
+                    next_elem->list.next = NULL;
+                    ucs_arbiter_group_schedule_nonempty(arbiter, group);
+                    break;
                 } else {
                     /* Not only element */
                     ucs_assert(elem == last_elem->next); /* first element should be removed */
@@ -204,7 +272,7 @@ void ucs_arbiter_dispatch_nonempty(ucs_arbiter_t *arbiter, unsigned per_group,
                     next_group->list.prev = &prev_group->list;
                 }
                 if (result == UCS_ARBITER_CB_RESULT_RESCHED_GROUP) {
-                    ucs_list_add_tail(&resched_groups, &elem->list);
+                    ucs_list_add_tail(resched_groups, &elem->list);
                 }
                 break;
             } else if (result == UCS_ARBITER_CB_RESULT_STOP) {
@@ -212,16 +280,49 @@ void ucs_arbiter_dispatch_nonempty(ucs_arbiter_t *arbiter, unsigned per_group,
                 elem->list.next = elem_list_next;
                 /* make sure that next dispatch() will continue
                  * from the current group */
-                arbiter->current = group_head;
-                goto out;
+                arbiter->current[prio] = group_head;
+                return 1;
             } else {
                 elem->next = next_elem;
                 elem->list.next = elem_list_next;
                 ucs_bug("unexpected return value from arbiter callback");
             }
         } while ((elem != last_elem) && (group_dispatch_count < per_group));
-    } while (next_group != NULL);
-    arbiter->current = NULL;
+    } while ((next_group != NULL) && (--max_groups > 0));
+
+    /* continue from the next group on the next round */
+    arbiter->current[prio] = next_group;
+    return 0;
+}
+
+void ucs_arbiter_dispatch_nonempty(ucs_arbiter_t *arbiter, unsigned per_group,
+                                   ucs_arbiter_callback_t cb, void *cb_arg)
+{
+    ucs_arbiter_elem_t *elem, *next_elem;
+    unsigned max_groups;
+    int prio;
+    UCS_LIST_HEAD(resched_groups);
+
+    ucs_assert(!ucs_arbiter_is_empty(arbiter));
+
+    /* Dispatch from the highest priority level to the lowest, and repeat while
+     * there are groups left, since a level may get new groups when the first
+     * element of a group is removed, or if the weight of a level is limited */
+    do {
+        for (prio = UCS_ARBITER_PRIO_LAST - 1; prio >= 0; --prio) {
+            if (arbiter->current[prio] == NULL) {
+                continue;
+            }
+
+            max_groups = (arbiter->weight[prio] == 0) ? UINT_MAX :
+                         arbiter->weight[prio];
+            if (ucs_arbiter_dispatch_prio(arbiter, (ucs_arbiter_prio_t)prio,
+                                          per_group, max_groups, cb, cb_arg,
+                                          &resched_groups)) {
+                goto out;
+            }
+        }
+    } while (!ucs_arbiter_is_empty(arbiter));
 out:
     ucs_list_for_each_safe(elem, next_elem, &resched_groups, list) {
         ucs_list_del(&elem->list);
@@ -231,17 +332,16 @@ out:
     }
 }
 
-void ucs_arbiter_dump(ucs_arbiter_t *arbiter, FILE *stream)
+static void ucs_arbiter_dump_prio(ucs_arbiter_t *arbiter, int prio, FILE *stream)
 {
     ucs_arbiter_elem_t *first_group, *group_head, *elem;
 
-    fprintf(stream, "-------\n");
-    if (arbiter->current == NULL) {
-        fprintf(stream, "(empty)\n");
-        goto out;
+    first_group = arbiter->current[prio];
+    if (first_group == NULL) {
+        return;
     }
 
-    first_group = arbiter->current;
+    fprintf(stream, "priority %d:\n", prio);
     group_head = first_group;
     do {
         elem = group_head;
@@ -256,7 +356,8 @@ void ucs_arbiter_dump(ucs_arbiter_t *arbiter, FILE *stream)
                 fprintf(stream, " prev_g:%p", elem->list.prev);
                 fprintf(stream, " next_g:%p", elem->list.next);
             }
-            fprintf(stream, " next_e:%p grp:%p]", elem->next, elem->group);
+            fprintf(stream, " next_e:%p grp:%p prio:%d]", elem->next,
+                    elem->group, elem->prio);
             if (elem->next != group_head) {
                 fprintf(stream, "->");
             }
@@ -265,7 +366,19 @@ void ucs_arbiter_dump(ucs_arbiter_t *arbiter, FILE *stream)
         fprintf(stream, "\n");
         group_head = ucs_list_next(&group_head->list, ucs_arbiter_elem_t, list);
     } while (group_head != first_group);
+}
 
-out:
+void ucs_arbiter_dump(ucs_arbiter_t *arbiter, FILE *stream)
+{
+    int prio;
+
+    fprintf(stream, "-------\n");
+    if (ucs_arbiter_is_empty(arbiter)) {
+        fprintf(stream, "(empty)\n");
+    } else {
+        for (prio = UCS_ARBITER_PRIO_LAST - 1; prio >= 0; --prio) {
+            ucs_arbiter_dump_prio(arbiter, prio, stream);
+        }
+    }
     fprintf(stream, "-------\n");
 }
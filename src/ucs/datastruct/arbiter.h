@@ -10,6 +10,7 @@
 #include <ucs/sys/compiler.h>
 #include <ucs/datastruct/list.h>
 #include <ucs/type/status.h>
+#include <stdint.h>
 #include <stdio.h>
 
 /*
@@ -27,6 +28,20 @@
  *  - all except last element point to the next element in same group, and the
  *    last one points to the first (next).
  *
+ * Priorities:
+ *  Every element has a priority, and the arbiter keeps a separate round-robin
+ *  queue of groups for every priority level. A group is scheduled on the queue
+ *  of its first element, and moves to another queue when its first element is
+ *  removed and the next one has a different priority. An element is added to
+ *  its group after all elements of the same or higher priority, but never
+ *  before the first element, so elements of equal priority are dispatched in
+ *  order and an element which is being worked on is not bypassed.
+ *  By default, groups of a higher priority are dispatched before any group of
+ *  a lower priority (strict priority). If a weight is set for a priority
+ *  level, at most that many groups of the level are dispatched before moving
+ *  to the lower levels, and then the levels are dispatched again from the
+ *  highest one (weighted round-robin).
+ *
  * Note:
  *  Every elements holds 4 pointers. It could be done with 3 pointers, so that
  *  the pointer to the previous group is put instead of "next" pointer in the last
@@ -73,6 +88,17 @@ typedef struct ucs_arbiter_group  ucs_arbiter_group_t;
 typedef struct ucs_arbiter_elem   ucs_arbiter_elem_t;
 
 
+/**
+ * Arbitration priority levels, from the lowest to the highest.
+ */
+typedef enum {
+    UCS_ARBITER_PRIO_BULK,              /* Bulk data transfers (default) */
+    UCS_ARBITER_PRIO_LATENCY,           /* Latency-sensitive work */
+    UCS_ARBITER_PRIO_CONTROL,           /* Short control messages */
+    UCS_ARBITER_PRIO_LAST
+} ucs_arbiter_prio_t;
+
+
 /**
  * Arbitration callback result codes.
  */
@@ -111,7 +137,12 @@ typedef ucs_arbiter_cb_result_t (*ucs_arbiter_callback_t)(ucs_arbiter_t *arbiter
  * Top-level arbiter.
  */
 struct ucs_arbiter {
-    ucs_arbiter_elem_t      *current;
+    ucs_arbiter_elem_t      *current[UCS_ARBITER_PRIO_LAST]; /* Next group to
+                                                                dispatch on every
+                                                                priority level */
+    unsigned                weight[UCS_ARBITER_PRIO_LAST];  /* How many groups to
+                                                                dispatch per round,
+                                                                0 - unlimited */
 };
 
 
@@ -131,6 +162,7 @@ struct ucs_arbiter_elem {
     ucs_list_link_t         list;       /* List link in the scheduler queue */
     ucs_arbiter_elem_t      *next;      /* Next element, last points to head */
     ucs_arbiter_group_t     *group;     /* Always points to the group */
+    uint8_t                 prio;       /* Priority, @ref ucs_arbiter_prio_t */
 };
 
 
@@ -143,6 +175,19 @@ void ucs_arbiter_init(ucs_arbiter_t *arbiter);
 void ucs_arbiter_cleanup(ucs_arbiter_t *arbiter);
 
 
+/**
+ * Set the dispatch weight of a priority level. By default, all levels have
+ * weight 0, which means the arbiter dispatches them in strict priority order.
+ *
+ * @param [in]  arbiter  Arbiter object to configure.
+ * @param [in]  prio     Priority level to set the weight for.
+ * @param [in]  weight   How many groups of this level to dispatch before
+ *                       moving to the lower levels, or 0 for unlimited.
+ */
+void ucs_arbiter_set_weight(ucs_arbiter_t *arbiter, ucs_arbiter_prio_t prio,
+                            unsigned weight);
+
+
 /**
  * Initialize a group object.
  *
@@ -159,6 +204,7 @@ void ucs_arbiter_group_cleanup(ucs_arbiter_group_t *group);
 static inline void ucs_arbiter_elem_init(ucs_arbiter_elem_t *elem)
 {
     elem->next = NULL;
+    elem->prio = UCS_ARBITER_PRIO_BULK;
 }
 
 /**
@@ -167,6 +213,13 @@ static inline void ucs_arbiter_elem_init(ucs_arbiter_elem_t *elem)
 void ucs_arbiter_group_push_elem_always(ucs_arbiter_group_t *group, 
                                         ucs_arbiter_elem_t *elem);
 
+/**
+ * Add a new work element with the given priority to a group - internal function
+ */
+void ucs_arbiter_group_push_elem_prio_always(ucs_arbiter_group_t *group,
+                                             ucs_arbiter_elem_t *elem,
+                                             ucs_arbiter_prio_t prio);
+
 /**
  * Remove all elements from a group, and call the callback for each of them.
  * Callback return value is ignored.
@@ -202,7 +255,14 @@ void ucs_arbiter_group_head_desched(ucs_arbiter_t *arbiter,
  */
 static inline int ucs_arbiter_is_empty(ucs_arbiter_t *arbiter)
 {
-    return arbiter->current == NULL;
+    int prio;
+
+    for (prio = 0; prio < UCS_ARBITER_PRIO_LAST; ++prio) {
+        if (arbiter->current[prio] != NULL) {
+            return 0;
+        }
+    }
+    return 1;
 }
 
 
@@ -277,11 +337,34 @@ ucs_arbiter_group_push_elem(ucs_arbiter_group_t *group,
 }
 
 
+/**
+ * Add a new work element to a group with the given priority, if it is not
+ * already there. The element is queued after all elements of the same or
+ * higher priority, but never before the first element of the group.
+ *
+ * @param [in]  group    Group to add the element to.
+ * @param [in]  elem     Work element to add.
+ * @param [in]  prio     Priority of the element.
+ */
+static inline void
+ucs_arbiter_group_push_elem_prio(ucs_arbiter_group_t *group,
+                                 ucs_arbiter_elem_t *elem,
+                                 ucs_arbiter_prio_t prio)
+{
+    if (ucs_arbiter_elem_is_scheduled(elem)) {
+        return;
+    }
+
+    ucs_arbiter_group_push_elem_prio_always(group, elem, prio);
+}
+
+
 /**
  * Dispatch work elements in the arbiter. For every group, up to per_group work
  * elements are dispatched, as long as the callback returns REMOVE_ELEM or
  * NEXT_GROUP. Then, the same is done for the next group, until either the
- * arbiter becomes empty or the callback returns STOP. If a group is either out
+ * arbiter becomes empty or the callback returns STOP. Groups are dispatched
+ * according to the priority of their first element. If a group is either out
  * of elements, or its callback returns REMOVE_GROUP, it will be removed until
  * ucs_arbiter_group_schedule() is used to put it back on the arbiter.
  *
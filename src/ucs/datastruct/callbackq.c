@@ -108,13 +108,14 @@ static void ucs_callbackq_invoke_service_cb(ucs_callbackq_t *cbq)
  * to the callback queue on behalf of other threads, since it is guaranteed to
  * run from the thread which is dispatching the callbacks.
  */
-static void ucs_callbackq_service_cb(void *arg)
+static unsigned ucs_callbackq_service_cb(void *arg)
 {
     ucs_callbackq_t *cbq = arg;
 
     ucs_callbackq_enter(cbq);
     ucs_callbackq_invoke_service_cb(cbq);
     ucs_callbackq_leave(cbq);
+    return 0;
 }
 
 ucs_status_t ucs_callbackq_init(ucs_callbackq_t *cbq, size_t size,
@@ -257,7 +258,7 @@ ucs_status_t ucs_callbackq_remove_safe(ucs_callbackq_t *cbq, ucs_callback_t cb,
     return UCS_OK;
 }
 
-static void ucs_callbackq_slow_path_cb(void *arg)
+static unsigned ucs_callbackq_slow_path_cb(void *arg)
 {
     ucs_callbackq_t *cbq = arg;
     ucs_callbackq_slow_elem_t *elem, *tmp_elem;
@@ -273,6 +274,7 @@ static void ucs_callbackq_slow_path_cb(void *arg)
     }
 
     ucs_callbackq_leave(cbq);
+    return 0;
 }
 
 void ucs_callbackq_add_slow_path(ucs_callbackq_t *cbq,
@@ -7,10 +7,63 @@
 #include "mpool.h"
 #include "mpool.inl"
 #include "queue.h"
+#include "list.h"
 
+#include <ucs/arch/atomic.h>
+#include <ucs/arch/cpu.h>
 #include <ucs/debug/log.h>
 #include <ucs/sys/math.h>
 #include <ucs/sys/sys.h>
+#include <ucs/type/spinlock.h>
+#include <pthread.h>
+
+
+/* Number of batches the depot of a thread-safe pool can hold */
+#define UCS_MPOOL_MT_DEPOT_SIZE  256
+
+
+/*
+ * Per-thread cache of a thread-safe memory pool.
+ */
+typedef struct ucs_mpool_tcache {
+    ucs_mpool_elem_t       *freelist;  /* Elements owned by the thread */
+    unsigned               count;      /* Number of elements in freelist */
+    ucs_mpool_t            *mp;        /* Memory pool this cache belongs to */
+    ucs_list_link_t        list;       /* Entry in the list of thread caches */
+} ucs_mpool_tcache_t;
+
+
+/*
+ * Depot cell. A batch is a NULL-terminated list of exactly 'batch' elements.
+ */
+typedef struct ucs_mpool_depot_cell {
+    volatile uint64_t      seq;        /* Position the cell is ready for */
+    ucs_mpool_elem_t       *batch;     /* First element of the batch */
+} ucs_mpool_depot_cell_t;
+
+
+/*
+ * Thread-safe memory pool state. The depot is a bounded multi-producer,
+ * multi-consumer queue of element batches; when it is full or empty, the
+ * thread caches fall back to the locked freelist, which is also where the
+ * pool grows.
+ */
+struct ucs_mpool_mt {
+    pthread_key_t          key;        /* Thread cache of the calling thread */
+    unsigned               batch;      /* Elements in a batch */
+    ucs_spinlock_t         lock;       /* Protects freelist, growing, tcaches */
+    ucs_mpool_elem_t       *freelist;  /* Elements which are not in the depot */
+    ucs_list_link_t        tcaches;    /* All thread caches */
+
+    volatile uint64_t      enqueue_pos UCS_V_ALIGNED(UCS_SYS_CACHE_LINE_SIZE);
+    volatile uint64_t      dequeue_pos UCS_V_ALIGNED(UCS_SYS_CACHE_LINE_SIZE);
+    ucs_mpool_depot_cell_t depot[UCS_MPOOL_MT_DEPOT_SIZE]
+                                       UCS_V_ALIGNED(UCS_SYS_CACHE_LINE_SIZE);
+};
+
+
+static void *ucs_mpool_mt_get(ucs_mpool_t *mp);
+static void ucs_mpool_mt_cleanup(ucs_mpool_t *mp);
 
 
 static inline unsigned ucs_mpool_elem_total_size(ucs_mpool_data_t *data)
@@ -60,6 +113,7 @@ ucs_status_t ucs_mpool_init(ucs_mpool_t *mp, size_t priv_size,
     }
 
     mp->freelist           = NULL;
+    mp->mt                 = NULL;
     mp->data->elem_size    = sizeof(ucs_mpool_elem_t) + elem_size;
     mp->data->alignment    = alignment;
     mp->data->align_offset = sizeof(ucs_mpool_elem_t) + align_offset;
@@ -85,6 +139,10 @@ void ucs_mpool_cleanup(ucs_mpool_t *mp, int leak_check)
     ucs_mpool_data_t *data = mp->data;
     void *obj;
 
+    if (mp->mt != NULL) {
+        ucs_mpool_mt_cleanup(mp);
+    }
+
     /* Cleanup all elements in the freelist and set their header to NULL to mark
      * them as released for the leak check.
      */
@@ -141,6 +199,15 @@ const char *ucs_mpool_name(ucs_mpool_t *mp)
 
 int ucs_mpool_is_empty(ucs_mpool_t *mp)
 {
+    ucs_mpool_tcache_t *tcache;
+
+    if (mp->mt != NULL) {
+        tcache = pthread_getspecific(mp->mt->key);
+        return (mp->data->quota == 0) && (mp->mt->freelist == NULL) &&
+               (mp->mt->enqueue_pos == mp->mt->dequeue_pos) &&
+               ((tcache == NULL) || (tcache->freelist == NULL));
+    }
+
     return (mp->freelist == NULL) && (mp->data->quota == 0);
 }
 
@@ -154,25 +221,29 @@ void ucs_mpool_put(void *obj)
     ucs_mpool_put_inline(obj);
 }
 
-void *ucs_mpool_get_grow(ucs_mpool_t *mp)
+/*
+ * Allocate a new chunk and return its elements as a NULL-terminated list.
+ */
+static ucs_status_t ucs_mpool_grow(ucs_mpool_t *mp, ucs_mpool_elem_t **head_p,
+                                   ucs_mpool_elem_t **tail_p)
 {
     size_t chunk_size, chunk_padding;
     ucs_mpool_data_t *data = mp->data;
+    ucs_mpool_elem_t *elem, *head;
     ucs_mpool_chunk_t *chunk;
-    ucs_mpool_elem_t *elem;
     ucs_status_t status;
     unsigned i;
     void *ptr;
 
     if (data->quota == 0) {
-        return NULL;
+        return UCS_ERR_NO_MEMORY;
     }
 
     chunk_size = data->chunk_size;
     status = data->ops->chunk_alloc(mp, &chunk_size, &ptr);
     if (status != UCS_OK) {
         ucs_error("Failed to allocate memory pool chunk: %s", ucs_status_string(status));
-        return NULL;
+        return status;
     }
 
     /* Calculate padding, and update element count according to allocated size */
@@ -186,18 +257,21 @@ void *ucs_mpool_get_grow(ucs_mpool_t *mp)
     ucs_debug("mpool %s: allocated chunk %p of %lu bytes with %u elements",
               ucs_mpool_name(mp), chunk, chunk_size, chunk->num_elems);
 
+    head    = NULL;
+    *tail_p = NULL;
     for (i = 0; i < chunk->num_elems; ++i) {
         elem         = ucs_mpool_chunk_elem(data, chunk, i);
         if (data->ops->obj_init != NULL) {
             data->ops->obj_init(mp, elem + 1, chunk);
         }
 
-        ucs_mpool_add_to_freelist(mp, elem, 0);
-        if (mp->data->tail == NULL) {
-            mp->data->tail = elem;
+        elem->next = head;
+        head       = elem;
+        if (*tail_p == NULL) {
+            *tail_p = elem;
         }
     }
-
+    *head_p = head;
 
     chunk->next  = data->chunks;
     data->chunks = chunk;
@@ -211,6 +285,334 @@ void *ucs_mpool_get_grow(ucs_mpool_t *mp)
     }
 
     VALGRIND_MAKE_MEM_NOACCESS(chunk + 1, chunk_size - sizeof(*chunk));
+    return UCS_OK;
+}
+
+static inline ucs_mpool_elem_t *ucs_mpool_elem_next(ucs_mpool_elem_t *elem)
+{
+    VALGRIND_MAKE_MEM_DEFINED(elem, sizeof *elem);
+    return elem->next;
+}
+
+/* Push a list of elements to the shared freelist. Lock must be held. */
+static void ucs_mpool_mt_push_list(ucs_mpool_mt_t *mt, ucs_mpool_elem_t *head)
+{
+    ucs_mpool_elem_t *elem;
+
+    while (head != NULL) {
+        elem         = head;
+        head         = ucs_mpool_elem_next(elem);
+        elem->next   = mt->freelist;
+        mt->freelist = elem;
+    }
+}
+
+static int ucs_mpool_depot_push(ucs_mpool_mt_t *mt, ucs_mpool_elem_t *batch)
+{
+    ucs_mpool_depot_cell_t *cell;
+    uint64_t pos;
+    int64_t diff;
+
+    pos = mt->enqueue_pos;
+    for (;;) {
+        cell = &mt->depot[pos % UCS_MPOOL_MT_DEPOT_SIZE];
+        diff = (int64_t)(cell->seq - pos);
+        if (diff == 0) {
+            if (ucs_atomic_cswap64(&mt->enqueue_pos, pos, pos + 1) == pos) {
+                break;
+            }
+        } else if (diff < 0) {
+            return 0; /* Depot is full */
+        }
+        pos = mt->enqueue_pos;
+    }
+
+    cell->batch = batch;
+    ucs_memory_cpu_store_fence();
+    cell->seq   = pos + 1;
+    return 1;
+}
+
+static ucs_mpool_elem_t *ucs_mpool_depot_pop(ucs_mpool_mt_t *mt)
+{
+    ucs_mpool_depot_cell_t *cell;
+    ucs_mpool_elem_t *batch;
+    uint64_t pos;
+    int64_t diff;
+
+    pos = mt->dequeue_pos;
+    for (;;) {
+        cell = &mt->depot[pos % UCS_MPOOL_MT_DEPOT_SIZE];
+        diff = (int64_t)(cell->seq - (pos + 1));
+        if (diff == 0) {
+            if (ucs_atomic_cswap64(&mt->dequeue_pos, pos, pos + 1) == pos) {
+                break;
+            }
+        } else if (diff < 0) {
+            return NULL; /* Depot is empty */
+        }
+        pos = mt->dequeue_pos;
+    }
+
+    ucs_memory_cpu_load_fence();
+    batch = cell->batch;
+    ucs_memory_cpu_fence();
+    cell->seq = pos + UCS_MPOOL_MT_DEPOT_SIZE;
+    return batch;
+}
+
+/* Called when a thread exits, returns its cached elements to the pool */
+static void ucs_mpool_tcache_destroy(void *arg)
+{
+    ucs_mpool_tcache_t *tcache = arg;
+    ucs_mpool_mt_t *mt         = tcache->mp->mt;
+
+    ucs_spin_lock(&mt->lock);
+    ucs_list_del(&tcache->list);
+    ucs_mpool_mt_push_list(mt, tcache->freelist);
+    ucs_spin_unlock(&mt->lock);
+    ucs_free(tcache);
+}
+
+static ucs_mpool_tcache_t *ucs_mpool_tcache_get(ucs_mpool_t *mp)
+{
+    ucs_mpool_mt_t *mt = mp->mt;
+    ucs_mpool_tcache_t *tcache;
+
+    tcache = pthread_getspecific(mt->key);
+    if (ucs_likely(tcache != NULL)) {
+        return tcache;
+    }
+
+    tcache = ucs_malloc(sizeof(*tcache), "mpool_tcache");
+    if (tcache == NULL) {
+        ucs_error("mpool %s: failed to allocate thread cache", ucs_mpool_name(mp));
+        return NULL;
+    }
+
+    tcache->freelist = NULL;
+    tcache->count    = 0;
+    tcache->mp       = mp;
+
+    ucs_spin_lock(&mt->lock);
+    ucs_list_add_tail(&mt->tcaches, &tcache->list);
+    ucs_spin_unlock(&mt->lock);
+
+    pthread_setspecific(mt->key, tcache);
+    return tcache;
+}
+
+/* Fill an empty thread cache with a batch of elements */
+static int ucs_mpool_tcache_refill(ucs_mpool_t *mp, ucs_mpool_tcache_t *tcache)
+{
+    ucs_mpool_mt_t *mt = mp->mt;
+    ucs_mpool_elem_t *elem, *head, *tail;
+    ucs_status_t status;
+
+    ucs_assert(tcache->count == 0);
+
+    head = ucs_mpool_depot_pop(mt);
+    if (head != NULL) {
+        tcache->freelist = head;
+        tcache->count    = mt->batch;
+        return 1;
+    }
+
+    ucs_spin_lock(&mt->lock);
+
+    if (mt->freelist == NULL) {
+        status = ucs_mpool_grow(mp, &head, &tail);
+        if (status == UCS_OK) {
+            tail->next   = mt->freelist;
+            mt->freelist = head;
+        }
+    }
+
+    while ((mt->freelist != NULL) && (tcache->count < mt->batch)) {
+        elem             = mt->freelist;
+        mt->freelist     = ucs_mpool_elem_next(elem);
+        elem->next       = tcache->freelist;
+        tcache->freelist = elem;
+        ++tcache->count;
+    }
+
+    ucs_spin_unlock(&mt->lock);
+    return tcache->count > 0;
+}
+
+/* Move a batch of elements from a full thread cache to the depot */
+static void ucs_mpool_tcache_flush(ucs_mpool_t *mp, ucs_mpool_tcache_t *tcache)
+{
+    ucs_mpool_mt_t *mt = mp->mt;
+    ucs_mpool_elem_t *head, *tail;
+    unsigned i;
+
+    head = tail = tcache->freelist;
+    for (i = 1; i < mt->batch; ++i) {
+        tail = ucs_mpool_elem_next(tail);
+    }
+
+    tcache->freelist = ucs_mpool_elem_next(tail);
+    tcache->count   -= mt->batch;
+    tail->next       = NULL;
+
+    if (!ucs_mpool_depot_push(mt, head)) {
+        ucs_spin_lock(&mt->lock);
+        ucs_mpool_mt_push_list(mt, head);
+        ucs_spin_unlock(&mt->lock);
+    }
+}
+
+static void *ucs_mpool_mt_get(ucs_mpool_t *mp)
+{
+    ucs_mpool_tcache_t *tcache;
+    ucs_mpool_elem_t *elem;
+    void *obj;
+
+    tcache = ucs_mpool_tcache_get(mp);
+    if (tcache == NULL) {
+        return NULL;
+    }
+
+    if ((tcache->freelist == NULL) && !ucs_mpool_tcache_refill(mp, tcache)) {
+        return NULL;
+    }
+
+    elem             = tcache->freelist;
+    tcache->freelist = ucs_mpool_elem_next(elem);
+    --tcache->count;
+    elem->mpool      = mp;
+    VALGRIND_MAKE_MEM_NOACCESS(elem, sizeof *elem);
+
+    obj = elem + 1;
+    VALGRIND_MEMPOOL_ALLOC(mp, obj, mp->data->elem_size - sizeof(ucs_mpool_elem_t));
+    return obj;
+}
+
+void ucs_mpool_mt_put(ucs_mpool_t *mp, ucs_mpool_elem_t *elem)
+{
+    ucs_mpool_mt_t *mt = mp->mt;
+    ucs_mpool_tcache_t *tcache;
+
+    VALGRIND_MEMPOOL_FREE(mp, elem + 1);
+
+    tcache = ucs_mpool_tcache_get(mp);
+    if (ucs_unlikely(tcache == NULL)) {
+        ucs_spin_lock(&mt->lock);
+        elem->next   = mt->freelist;
+        mt->freelist = elem;
+        ucs_spin_unlock(&mt->lock);
+        return;
+    }
+
+    elem->next       = tcache->freelist;
+    tcache->freelist = elem;
+    if (++tcache->count >= 2 * mt->batch) {
+        ucs_mpool_tcache_flush(mp, tcache);
+    }
+}
+
+/*
+ * Move all elements back to the pool freelist, so the regular cleanup would
+ * release them. No other thread may use the pool at this point.
+ */
+static void ucs_mpool_mt_cleanup(ucs_mpool_t *mp)
+{
+    ucs_mpool_mt_t *mt = mp->mt;
+    ucs_mpool_tcache_t *tcache, *tmp;
+    ucs_mpool_elem_t *batch;
+
+    pthread_key_delete(mt->key);
+
+    ucs_list_for_each_safe(tcache, tmp, &mt->tcaches, list) {
+        ucs_mpool_mt_push_list(mt, tcache->freelist);
+        ucs_free(tcache);
+    }
+
+    while ((batch = ucs_mpool_depot_pop(mt)) != NULL) {
+        ucs_mpool_mt_push_list(mt, batch);
+    }
+
+    mp->freelist = mt->freelist;
+    mp->mt       = NULL;
+    ucs_spinlock_destroy(&mt->lock);
+    ucs_free(mt);
+}
+
+ucs_status_t ucs_mpool_set_thread_safe(ucs_mpool_t *mp, unsigned batch)
+{
+    ucs_mpool_mt_t *mt;
+    ucs_status_t status;
+    unsigned i;
+    int ret;
+
+    ucs_assert((mp->freelist == NULL) && (mp->data->chunks == NULL));
+
+    if (batch == 0) {
+        ucs_error("mpool %s: invalid thread cache batch size", ucs_mpool_name(mp));
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    mt = ucs_memalign(UCS_SYS_CACHE_LINE_SIZE, sizeof(*mt), "mpool_mt");
+    if (mt == NULL) {
+        ucs_error("mpool %s: failed to allocate thread-safe context",
+                  ucs_mpool_name(mp));
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    ret = pthread_key_create(&mt->key, ucs_mpool_tcache_destroy);
+    if (ret != 0) {
+        ucs_error("mpool %s: pthread_key_create() failed: %s",
+                  ucs_mpool_name(mp), strerror(ret));
+        status = UCS_ERR_NO_RESOURCE;
+        goto err_free;
+    }
+
+    status = ucs_spinlock_init(&mt->lock);
+    if (status != UCS_OK) {
+        goto err_key_delete;
+    }
+
+    mt->batch       = batch;
+    mt->freelist    = NULL;
+    mt->enqueue_pos = 0;
+    mt->dequeue_pos = 0;
+    ucs_list_head_init(&mt->tcaches);
+    for (i = 0; i < UCS_MPOOL_MT_DEPOT_SIZE; ++i) {
+        mt->depot[i].seq   = i;
+        mt->depot[i].batch = NULL;
+    }
+
+    mp->mt = mt;
+    ucs_debug("mpool %s: thread-safe, batch %u", ucs_mpool_name(mp), batch);
+    return UCS_OK;
+
+err_key_delete:
+    pthread_key_delete(mt->key);
+err_free:
+    ucs_free(mt);
+    return status;
+}
+
+void *ucs_mpool_get_grow(ucs_mpool_t *mp)
+{
+    ucs_mpool_elem_t *head, *tail;
+    ucs_status_t status;
+
+    if (mp->mt != NULL) {
+        return ucs_mpool_mt_get(mp);
+    }
+
+    status = ucs_mpool_grow(mp, &head, &tail);
+    if (status != UCS_OK) {
+        return NULL;
+    }
+
+    tail->next   = mp->freelist;
+    mp->freelist = head;
+    if (mp->data->tail == NULL) {
+        mp->data->tail = tail;
+    }
 
     ucs_assert(mp->freelist != NULL); /* Should not recurse */
     return ucs_mpool_get(mp);
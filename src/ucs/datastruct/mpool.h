@@ -18,6 +18,7 @@ typedef union  ucs_mpool_elem    ucs_mpool_elem_t;
 typedef struct ucs_mpool         ucs_mpool_t;
 typedef struct ucs_mpool_data    ucs_mpool_data_t;
 typedef struct ucs_mpool_ops     ucs_mpool_ops_t;
+typedef struct ucs_mpool_mt      ucs_mpool_mt_t;
 
 
 /**
@@ -34,6 +35,11 @@ typedef struct ucs_mpool_ops     ucs_mpool_ops_t;
  * +------------+--------+------+
  *                       |
  *                       This location is aligned.
+ *
+ * A memory pool may be made thread-safe by ucs_mpool_set_thread_safe(). In this
+ * mode every thread gets and puts objects to its own cache, and the caches
+ * exchange batches of objects through a shared lock-free depot. Objects may be
+ * released by a thread other than the one which allocated them.
  */
 
 
@@ -62,6 +68,7 @@ struct ucs_mpool_chunk {
 struct ucs_mpool {
     ucs_mpool_elem_t       *freelist;  /* List of available elements */
     ucs_mpool_data_t       *data;      /* Slow-path data */
+    ucs_mpool_mt_t         *mt;        /* Thread caches, NULL if not thread-safe */
 };
 
 
@@ -150,6 +157,21 @@ ucs_status_t ucs_mpool_init(ucs_mpool_t *mp, size_t priv_size,
                             ucs_mpool_ops_t *ops, const char *name);
 
 
+/**
+ * Make a memory pool thread-safe, by giving each thread a private cache of
+ * objects. Must be called after ucs_mpool_init(), before any object is taken
+ * from the pool. The FIFO debug mode is not supported for such pools.
+ *
+ * @param mp               Memory pool structure.
+ * @param batch            Number of objects moved at once between a thread
+ *                          cache and the shared depot. A thread keeps up to
+ *                          twice this number of objects in its cache.
+ *
+ * @return UCS status code.
+ */
+ucs_status_t ucs_mpool_set_thread_safe(ucs_mpool_t *mp, unsigned batch);
+
+
 /**
  * Cleanup a memory pool and release all its memory.
  *
@@ -215,6 +237,16 @@ void ucs_mpool_put(void *obj);
 void *ucs_mpool_get_grow(ucs_mpool_t *mp);
 
 
+/**
+ * Return an object to the current thread's cache of a thread-safe pool.
+ * Used internally by ucs_mpool_put().
+ *
+ * @param mp               Memory pool structure.
+ * @param elem             Element to return.
+ */
+void ucs_mpool_mt_put(ucs_mpool_t *mp, ucs_mpool_elem_t *elem);
+
+
 /**
  * heap-based chunk allocator.
  */
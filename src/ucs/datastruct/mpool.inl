@@ -72,6 +72,11 @@ static inline void ucs_mpool_put_inline(void *obj)
 
     elem = (ucs_mpool_elem_t*)obj - 1;
     mp = ucs_mpool_obj_owner(obj);
+    if (ucs_unlikely(mp->mt != NULL)) {
+        ucs_mpool_mt_put(mp, elem);
+        return;
+    }
+
     ucs_mpool_add_to_freelist(mp, elem,
                               ENABLE_DEBUG_DATA && ucs_global_opts.mpool_fifo);
     VALGRIND_MAKE_MEM_NOACCESS(elem, sizeof *elem);
@@ -7,6 +7,7 @@
 #include "pgtable.h"
 
 #include <ucs/arch/bitops.h>
+#include <ucs/arch/cpu.h>
 #include <ucs/debug/log.h>
 #include <ucs/debug/memtrack.h>
 #include <ucs/sys/math.h>
@@ -34,10 +35,13 @@
                     "ptr=%p", (_ptr)); \
     } while (0)
 
+/* The fence makes the pointed object visible to concurrent lookups before
+ * the entry itself */
 #define ucs_pgt_entry_set_region(_pte, _region) \
     do { \
         ucs_pgt_region_t *tmp = (_region); \
         ucs_pgt_check_ptr(tmp); \
+        ucs_memory_cpu_store_fence(); \
         (_pte)->value = ((uintptr_t)tmp) | UCS_PGT_ENTRY_FLAG_REGION; \
     } while (0)
 
@@ -45,6 +49,7 @@
     do { \
         ucs_pgt_dir_t *tmp = (_dir); \
         ucs_pgt_check_ptr(tmp); \
+        ucs_memory_cpu_store_fence(); \
         (_pte)->value = ((uintptr_t)tmp) | UCS_PGT_ENTRY_FLAG_DIR; \
     } while (0)
 
@@ -454,8 +459,9 @@ ucs_status_t ucs_pgtable_remove(ucs_pgtable_t *pgtable, ucs_pgt_region_t *region
 ucs_pgt_region_t *ucs_pgtable_lookup(const ucs_pgtable_t *pgtable,
                                      ucs_pgt_addr_t address)
 {
-    const ucs_pgt_entry_t *pte;
+    const volatile ucs_pgt_entry_t *pte;
     ucs_pgt_region_t *region;
+    ucs_pgt_entry_t entry;
     ucs_pgt_dir_t *dir;
     unsigned shift;
 
@@ -466,16 +472,23 @@ ucs_pgt_region_t *ucs_pgtable_lookup(const ucs_pgtable_t *pgtable,
         return NULL;
     }
 
-    /* Descend into the page table */
+    /* Descend into the page table. Every entry is read exactly once, and the
+     * result is validated, so a lookup which runs concurrently with an update
+     * could only miss.
+     */
     pte   = &pgtable->root;
     shift = pgtable->shift;
     for (;;) {
-        if (ucs_pgt_entry_test(pte, UCS_PGT_ENTRY_FLAG_REGION)) {
-            region = ucs_pgt_entry_get_region(pte);
-            ucs_assert((address >= region->start) && (address < region->end));
+        entry.value = pte->value;
+        if (ucs_pgt_entry_test(&entry, UCS_PGT_ENTRY_FLAG_REGION)) {
+            region = ucs_pgt_entry_get_region(&entry);
+            if ((address < region->start) || (address >= region->end)) {
+                return NULL;
+            }
             return region;
-        } else if (ucs_pgt_entry_test(pte, UCS_PGT_ENTRY_FLAG_DIR)) {
-            dir = ucs_pgt_entry_get_dir(pte);
+        } else if (ucs_pgt_entry_test(&entry, UCS_PGT_ENTRY_FLAG_DIR) &&
+                   (shift >= UCS_PGT_ADDR_SHIFT + UCS_PGT_ENTRY_SHIFT)) {
+            dir = ucs_pgt_entry_get_dir(&entry);
             shift -= UCS_PGT_ENTRY_SHIFT;
             pte = &dir->entries[(address >> shift) & UCS_PGT_ENTRY_MASK];
         } else {
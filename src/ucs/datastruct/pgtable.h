@@ -199,6 +199,11 @@ ucs_status_t ucs_pgtable_remove(ucs_pgtable_t *pgtable, ucs_pgt_region_t *region
 /*
  * Find a region which contains the given address.
  *
+ * The lookup may run concurrently with insert/remove operations, provided that
+ * removed regions and released directories are not reused until the lookup
+ * returns. In this case, it may fail to find a region which is being added or
+ * removed.
+ *
  * @param [in]  pgtable     Page table to search the address in.
  * @param [in]  address     Address to search.
  *
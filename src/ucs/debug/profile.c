@@ -6,6 +6,8 @@
 
 #include "profile.h"
 
+#include <ucs/arch/cpu.h>
+#include <ucs/sys/math.h>
 #include <ucs/sys/sys.h>
 
 #if HAVE_PROFILING
@@ -18,13 +20,11 @@ const char *ucs_profile_mode_names[] = {
 
 ucs_profile_global_context_t ucs_profile_ctx = {
     .locations       = NULL,
-    .log.start       = NULL,
-    .log.end         = NULL,
-    .log.current     = NULL,
-    .log.wraparound  = 0,
-    .accum.stack_top = -1,
     .num_locations   = 0,
     .max_locations   = 0,
+    .lock            = PTHREAD_MUTEX_INITIALIZER,
+    .thread_list     = UCS_LIST_INITIALIZER(&ucs_profile_ctx.thread_list,
+                                            &ucs_profile_ctx.thread_list),
 };
 
 static void ucs_profile_file_write_data(int fd, void *data, size_t size)
@@ -44,11 +44,48 @@ static void ucs_profile_file_write_records(int fd, ucs_profile_record_t *begin,
     ucs_profile_file_write_data(fd, begin, (void*)end - (void*)begin);
 }
 
+static size_t ucs_profile_thread_num_records(ucs_profile_thread_context_t *ctx)
+{
+    return ctx->log.wraparound ? (ctx->log.end     - ctx->log.start) :
+                                 (ctx->log.current - ctx->log.start);
+}
+
+static void ucs_profile_write_thread(int fd, ucs_profile_thread_context_t *ctx)
+{
+    ucs_profile_thread_location_t empty_loc = {0, 0};
+    ucs_profile_thread_header_t thread_hdr;
+    unsigned location;
+
+    thread_hdr.tid         = ctx->tid;
+    thread_hdr.start_time  = ctx->start_time;
+    thread_hdr.num_records = ucs_profile_thread_num_records(ctx);
+    ucs_profile_file_write_data(fd, &thread_hdr, sizeof(thread_hdr));
+
+    /* write location counters, the thread may not have hit the latest ones */
+    ucs_profile_file_write_data(fd, ctx->locations,
+                                sizeof(*ctx->locations) *
+                                ucs_min(ctx->max_locations,
+                                        ucs_profile_ctx.num_locations));
+    for (location = ctx->max_locations; location < ucs_profile_ctx.num_locations;
+         ++location) {
+        ucs_profile_file_write_data(fd, &empty_loc, sizeof(empty_loc));
+    }
+
+    /* write records */
+    if (ctx->log.wraparound > 0) {
+        ucs_profile_file_write_records(fd, ctx->log.current, ctx->log.end);
+    }
+    ucs_profile_file_write_records(fd, ctx->log.start, ctx->log.current);
+}
+
 static void ucs_profile_write()
 {
+    ucs_profile_thread_context_t *ctx;
     ucs_profile_header_t header;
+    ucs_profile_location_t *loc;
     char fullpath[1024] = {0};
     char filename[1024] = {0};
+    unsigned location;
     int fd;
 
     if (!ucs_global_opts.profile_mode) {
@@ -65,16 +102,32 @@ static void ucs_profile_write()
         return;
     }
 
-    /* write header */
+    pthread_mutex_lock(&ucs_profile_ctx.lock);
+
+    /* merge the counters of all threads */
     memset(&header, 0, sizeof(header));
+    for (location = 0; location < ucs_profile_ctx.num_locations; ++location) {
+        loc             = &ucs_profile_ctx.locations[location];
+        loc->total_time = 0;
+        loc->count      = 0;
+        ucs_list_for_each(ctx, &ucs_profile_ctx.thread_list, list) {
+            if (location < ctx->max_locations) {
+                loc->total_time += ctx->locations[location].total_time;
+                loc->count      += ctx->locations[location].count;
+            }
+        }
+    }
+    ucs_list_for_each(ctx, &ucs_profile_ctx.thread_list, list) {
+        header.num_records += ucs_profile_thread_num_records(ctx);
+        ++header.num_threads;
+    }
+
+    /* write header */
     ucs_read_file(header.cmdline, sizeof(header.cmdline), 1, "/proc/self/cmdline");
     strncpy(header.hostname, ucs_get_host_name(), sizeof(header.hostname) - 1);
-    header.pid = getpid();
-    header.mode = ucs_global_opts.profile_mode;
+    header.pid           = getpid();
+    header.mode          = ucs_global_opts.profile_mode;
     header.num_locations = ucs_profile_ctx.num_locations;
-    header.num_records   = ucs_profile_ctx.log.wraparound ?
-                    (ucs_profile_ctx.log.end     - ucs_profile_ctx.log.start) :
-                    (ucs_profile_ctx.log.current - ucs_profile_ctx.log.start);
     header.one_second    = ucs_time_from_sec(1.0);
     ucs_profile_file_write_data(fd, &header, sizeof(header));
 
@@ -83,13 +136,12 @@ static void ucs_profile_write()
                                 sizeof(*ucs_profile_ctx.locations) *
                                 ucs_profile_ctx.num_locations);
 
-    /* write records */
-    if (ucs_profile_ctx.log.wraparound > 0) {
-        ucs_profile_file_write_records(fd, ucs_profile_ctx.log.current,
-                                       ucs_profile_ctx.log.end);
+    /* write threads */
+    ucs_list_for_each(ctx, &ucs_profile_ctx.thread_list, list) {
+        ucs_profile_write_thread(fd, ctx);
     }
-    ucs_profile_file_write_records(fd, ucs_profile_ctx.log.start,
-                                   ucs_profile_ctx.log.current);
+
+    pthread_mutex_unlock(&ucs_profile_ctx.lock);
 
     close(fd);
 }
@@ -98,7 +150,7 @@ void ucs_profile_get_location(ucs_profile_type_t type, const char *name,
                               const char *file, int line, const char *function,
                               int *loc_id_p)
 {
-    ucs_profile_location_t *loc;
+    ucs_profile_location_t *locations, *loc;
     int location;
 
     /* Check if profiling is disabled */
@@ -107,23 +159,29 @@ void ucs_profile_get_location(ucs_profile_type_t type, const char *name,
         return;
     }
 
-    /* Location ID must be uninitialized */
-    ucs_assert(*loc_id_p == -1);
+    pthread_mutex_lock(&ucs_profile_ctx.lock);
 
-    location = ucs_profile_ctx.num_locations++;
+    /* Another thread could initialize the location */
+    if (*loc_id_p != -1) {
+        goto out_unlock;
+    }
+
+    location = ucs_profile_ctx.num_locations;
 
     /* Reallocate array if needed */
-    if (ucs_profile_ctx.num_locations > ucs_profile_ctx.max_locations) {
-        ucs_profile_ctx.max_locations = ucs_profile_ctx.num_locations * 2;
-        ucs_profile_ctx.locations = ucs_realloc(ucs_profile_ctx.locations,
-                                                sizeof(*ucs_profile_ctx.locations) *
-                                                ucs_profile_ctx.max_locations,
-                                                "profile_locations");
-        if (ucs_profile_ctx.locations == NULL) {
+    if (location + 1 > ucs_profile_ctx.max_locations) {
+        locations = ucs_realloc(ucs_profile_ctx.locations,
+                                sizeof(*ucs_profile_ctx.locations) *
+                                (location + 1) * 2,
+                                "profile_locations");
+        if (locations == NULL) {
             ucs_warn("failed to expand locations array");
             *loc_id_p = 0;
-            return;
+            goto out_unlock;
         }
+
+        ucs_profile_ctx.locations     = locations;
+        ucs_profile_ctx.max_locations = (location + 1) * 2;
     }
 
     /* Initialize new location */
@@ -136,38 +194,112 @@ void ucs_profile_get_location(ucs_profile_type_t type, const char *name,
     loc->total_time = 0;
     loc->count      = 0;
     loc->loc_id_p   = loc_id_p;
+    ++ucs_profile_ctx.num_locations;
+
+    /* Publish the location ID only after the location is initialized */
+    ucs_memory_cpu_store_fence();
     *loc_id_p       = location + 1;
+
+out_unlock:
+    pthread_mutex_unlock(&ucs_profile_ctx.lock);
 }
 
-void ucs_profile_global_init()
+static ucs_profile_thread_context_t *ucs_profile_thread_context_create()
 {
+    ucs_profile_thread_context_t *ctx;
     size_t num_records;
 
-    if (!ucs_global_opts.profile_mode) {
-        goto off;
+    ctx = ucs_calloc(1, sizeof(*ctx), "profile_thread_context");
+    if (ctx == NULL) {
+        ucs_warn("failed to allocate profiling thread context");
+        return NULL;
     }
 
-    if (!strlen(ucs_global_opts.profile_file)) {
-        ucs_warn("profiling file not specified, profiling is disabled");
-        goto disable;
-    }
+    ctx->tid             = ucs_get_tid();
+    ctx->start_time      = ucs_get_time();
+    ctx->accum.stack_top = -1;
 
+    /* the log buffer is allocated for the threads which make records only */
     if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) {
-        num_records = ucs_global_opts.profile_log_size / sizeof(ucs_profile_record_t);
-        ucs_profile_ctx.log.start = ucs_calloc(num_records,
-                                               sizeof(ucs_profile_record_t),
-                                               "profile_log");
-        if (ucs_profile_ctx.log.start == NULL) {
+        num_records    = ucs_global_opts.profile_log_size /
+                         sizeof(ucs_profile_record_t);
+        ctx->log.start = ucs_calloc(num_records, sizeof(ucs_profile_record_t),
+                                    "profile_log");
+        if (ctx->log.start == NULL) {
             ucs_warn("failed to allocate profiling log");
-            goto disable;
+            ucs_free(ctx);
+            return NULL;
         }
 
-        ucs_profile_ctx.log.end     = ucs_profile_ctx.log.start + num_records;
-        ucs_profile_ctx.log.current = ucs_profile_ctx.log.start;
+        ctx->log.end     = ctx->log.start + num_records;
+        ctx->log.current = ctx->log.start;
     }
 
-    if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_ACCUM)) {
-        ucs_profile_ctx.accum.stack_top = -1;
+    pthread_mutex_lock(&ucs_profile_ctx.lock);
+    ucs_list_add_tail(&ucs_profile_ctx.thread_list, &ctx->list);
+    pthread_mutex_unlock(&ucs_profile_ctx.lock);
+
+    pthread_setspecific(ucs_profile_ctx.tls_key, ctx);
+    return ctx;
+}
+
+ucs_profile_thread_context_t *ucs_profile_thread_context_get(int loc_id)
+{
+    ucs_profile_thread_location_t *locations;
+    ucs_profile_thread_context_t *ctx;
+    unsigned max_locations;
+
+    ctx = pthread_getspecific(ucs_profile_ctx.tls_key);
+    if (ctx == NULL) {
+        ctx = ucs_profile_thread_context_create();
+        if (ctx == NULL) {
+            return NULL;
+        }
+    }
+
+    if ((unsigned)loc_id <= ctx->max_locations) {
+        return ctx;
+    }
+
+    /* Expand location counters, under lock to avoid racing with dump */
+    pthread_mutex_lock(&ucs_profile_ctx.lock);
+    max_locations = ucs_max(ucs_profile_ctx.max_locations, loc_id);
+    locations     = ucs_realloc(ctx->locations,
+                                sizeof(*ctx->locations) * max_locations,
+                                "profile_thread_locations");
+    if (locations == NULL) {
+        pthread_mutex_unlock(&ucs_profile_ctx.lock);
+        ucs_warn("failed to expand thread locations array");
+        return NULL;
+    }
+
+    memset(locations + ctx->max_locations, 0,
+           sizeof(*locations) * (max_locations - ctx->max_locations));
+    ctx->locations     = locations;
+    ctx->max_locations = max_locations;
+    pthread_mutex_unlock(&ucs_profile_ctx.lock);
+
+    return ctx;
+}
+
+void ucs_profile_global_init()
+{
+    int ret;
+
+    if (!ucs_global_opts.profile_mode) {
+        goto off;
+    }
+
+    if (!strlen(ucs_global_opts.profile_file)) {
+        ucs_warn("profiling file not specified, profiling is disabled");
+        goto disable;
+    }
+
+    /* thread contexts are created on the first record of every thread */
+    ret = pthread_key_create(&ucs_profile_ctx.tls_key, NULL);
+    if (ret != 0) {
+        ucs_warn("failed to create profiling thread key: %s", strerror(ret));
+        goto disable;
     }
 
     ucs_info("profiling is enabled");
@@ -198,33 +330,39 @@ static void ucs_profile_reset_locations()
 
 void ucs_profile_global_cleanup()
 {
+    ucs_profile_thread_context_t *ctx, *tmp;
+
+    if (!ucs_global_opts.profile_mode) {
+        return;
+    }
+
     ucs_profile_write();
-    ucs_free(ucs_profile_ctx.log.start);
-    ucs_profile_ctx.log.start      = NULL;
-    ucs_profile_ctx.log.end        = NULL;
-    ucs_profile_ctx.log.current    = NULL;
-    ucs_profile_ctx.log.wraparound = 0;
+
+    /* thread-specific values are discarded along with the key */
+    pthread_key_delete(ucs_profile_ctx.tls_key);
+    ucs_list_for_each_safe(ctx, tmp, &ucs_profile_ctx.thread_list, list) {
+        ucs_list_del(&ctx->list);
+        ucs_free(ctx->log.start);
+        ucs_free(ctx->locations);
+        ucs_free(ctx);
+    }
+
     ucs_profile_reset_locations();
 }
 
 void ucs_profile_dump()
 {
-    ucs_profile_location_t *loc;
+    ucs_profile_thread_context_t *ctx;
 
     ucs_profile_write();
 
-    for (loc = ucs_profile_ctx.locations;
-         loc < ucs_profile_ctx.locations + ucs_profile_ctx.num_locations;
-         ++loc)
-    {
-        loc->count      = 0;
-        loc->total_time = 0;
-    }
-
-    if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) {
-        ucs_profile_ctx.log.wraparound = 0;
-        ucs_profile_ctx.log.current    = ucs_profile_ctx.log.start;
+    pthread_mutex_lock(&ucs_profile_ctx.lock);
+    ucs_list_for_each(ctx, &ucs_profile_ctx.thread_list, list) {
+        memset(ctx->locations, 0, sizeof(*ctx->locations) * ctx->max_locations);
+        ctx->log.wraparound = 0;
+        ctx->log.current    = ctx->log.start;
     }
+    pthread_mutex_unlock(&ucs_profile_ctx.lock);
 }
 
 #else
@@ -11,9 +11,11 @@
 #  include "config.h"
 #endif
 
+#include <ucs/datastruct/list.h>
 #include <ucs/sys/preprocessor.h>
 #include <ucs/time/time.h>
 #include <ucs/debug/log.h>
+#include <pthread.h>
 
 
 #define UCS_PROFILE_STACK_MAX 64
@@ -52,11 +54,36 @@ typedef struct ucs_profile_header {
     uint32_t                 pid;           /**< Process ID */
     uint32_t                 mode;          /**< Profiling mode */
     uint32_t                 num_locations; /**< Number of locations in the file */
-    uint64_t                 num_records;   /**< Number of records in the file */
+    uint32_t                 num_threads;   /**< Number of threads in the file */
+    uint64_t                 num_records;   /**< Total number of records in the file */
     uint64_t                 one_second;    /**< How much time is one second on the sampled machine */
 } UCS_S_PACKED ucs_profile_header_t;
 
 
+/**
+ * Profile output file thread header.
+ *
+ * The file contains the header, the locations, and then, for every thread
+ * which made records, the thread header followed by the thread's location
+ * counters (@ref ucs_profile_thread_location_t, one per location) and the
+ * thread's records.
+ */
+typedef struct ucs_profile_thread_header {
+    uint32_t                 tid;           /**< System thread ID */
+    uint64_t                 start_time;    /**< Time of the first record of the thread */
+    uint64_t                 num_records;   /**< Number of records of the thread */
+} UCS_S_PACKED ucs_profile_thread_header_t;
+
+
+/**
+ * Profile location counters of a single thread
+ */
+typedef struct ucs_profile_thread_location {
+    uint64_t                 total_time;    /**< Total interval from previous location */
+    size_t                   count;         /**< Number of times we've hit this location */
+} UCS_S_PACKED ucs_profile_thread_location_t;
+
+
 /**
  * Profile output file sample record
  */
@@ -78,31 +105,50 @@ typedef struct ucs_profile_location {
     int                      *loc_id_p;     /**< Back-pointer for location ID */
     int                      line;          /**< Source line number */
     uint8_t                  type;          /**< From ucs_profile_type_t */
-    uint64_t                 total_time;    /**< Total interval from previous location */
-    size_t                   count;         /**< Number of times we've hit this location */
+    uint64_t                 total_time;    /**< Total interval from previous location, of all threads */
+    size_t                   count;         /**< Number of times we've hit this location, in all threads */
 } UCS_S_PACKED ucs_profile_location_t;
 
 
 /**
- * Profiling global context
+ * Profiling context of a single thread. Only the owner thread updates it, so
+ * recording does not need any locking.
  */
-typedef struct ucs_profile_global_context {
+typedef struct ucs_profile_thread_context {
+    ucs_list_link_t                 list;          /**< Entry in the global list of threads */
+    pid_t                           tid;           /**< System thread ID */
+    ucs_time_t                      start_time;    /**< Time of the first record */
 
-    ucs_profile_location_t   *locations;    /**< Array of all locations */
-    unsigned                 num_locations; /**< Number of valid locations */
-    unsigned                 max_locations; /**< Size of locations array */
+    ucs_profile_thread_location_t   *locations;    /**< Counters, indexed by location */
+    unsigned                        max_locations; /**< Size of locations array */
 
     struct {
-        ucs_profile_record_t *start, *end;  /**< Circular log buffer */
-        ucs_profile_record_t *current;      /**< Current log pointer */
-        int                  wraparound;    /**< Whether log was rotated */
+        ucs_profile_record_t        *start, *end;  /**< Circular log buffer */
+        ucs_profile_record_t        *current;      /**< Current log pointer */
+        int                         wraparound;    /**< Whether log was rotated */
     } log;
 
     struct {
-        int                  stack_top;     /**< Index of stack top */
-        ucs_time_t           stack[UCS_PROFILE_STACK_MAX]; /**< Timestamps for each nested scope */
+        int                         stack_top;     /**< Index of stack top */
+        ucs_time_t                  stack[UCS_PROFILE_STACK_MAX]; /**< Timestamps for each nested scope */
     } accum;
 
+} ucs_profile_thread_context_t;
+
+
+/**
+ * Profiling global context
+ */
+typedef struct ucs_profile_global_context {
+
+    ucs_profile_location_t   *locations;    /**< Array of all locations */
+    unsigned                 num_locations; /**< Number of valid locations */
+    unsigned                 max_locations; /**< Size of locations array */
+
+    pthread_mutex_t          lock;          /**< Protects locations and threads list */
+    ucs_list_link_t          thread_list;   /**< List of thread contexts */
+    pthread_key_t            tls_key;       /**< Key of the current thread's context */
+
 } ucs_profile_global_context_t;
 
 
@@ -119,7 +165,8 @@ void ucs_profile_global_cleanup();
 
 
 /**
- * Save and reset profiling.
+ * Save and reset profiling. The records of all threads are saved to the same
+ * file. Should be called when other threads are not making records.
  */
 void ucs_profile_dump();
 
@@ -147,6 +194,19 @@ void ucs_profile_get_location(ucs_profile_type_t type, const char *name,
                               int *loc_id_p);
 
 
+/*
+ * Get the profiling context of the calling thread, and make sure it has
+ * counters for location @a loc_id. Creates the context on the first call from
+ * the thread.
+ * Should not be used directly - use UCS_PROFILE macros instead.
+ *
+ * @param [in]  loc_id    Location ID, as returned by ucs_profile_get_location().
+ *
+ * @return Thread context, or NULL if failed to allocate it.
+ */
+ucs_profile_thread_context_t *ucs_profile_thread_context_get(int loc_id);
+
+
 /*
  * Store a new record with the given data.
  * Should not be used directly - use UCS_PROFILE macros instead.
@@ -166,9 +226,9 @@ static inline void ucs_profile_record(ucs_profile_type_t type, const char *name,
                                       const char *function, int *loc_id_p)
 {
     extern ucs_profile_global_context_t ucs_profile_ctx;
-    ucs_profile_global_context_t *ctx = &ucs_profile_ctx;
-    ucs_profile_record_t   *rec;
-    ucs_profile_location_t *loc;
+    ucs_profile_thread_context_t *ctx;
+    ucs_profile_thread_location_t *loc;
+    ucs_profile_record_t *rec;
     ucs_time_t current_time;
     int loc_id;
 
@@ -183,6 +243,14 @@ retry:
         goto retry;
     }
 
+    ctx = pthread_getspecific(ucs_profile_ctx.tls_key);
+    if (ucs_unlikely((ctx == NULL) || ((unsigned)loc_id > ctx->max_locations))) {
+        ctx = ucs_profile_thread_context_get(loc_id);
+        if (ctx == NULL) {
+            return;
+        }
+    }
+
     current_time = ucs_get_time();
     if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_ACCUM)) {
         loc              = &ctx->locations[loc_id - 1];
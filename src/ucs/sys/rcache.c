@@ -13,6 +13,7 @@
 #include <ucs/debug/memtrack.h>
 #include <ucs/sys/sys.h>
 #include <ucm/api/ucm.h>
+#include <sched.h>
 
 
 #define ucs_rcache_region_log(_level, _message, ...) \
@@ -38,6 +39,28 @@
     ((_prot) & PROT_WRITE) ? 'w' : '-'
 
 
+#if ENABLE_STATS
+static ucs_stats_class_t ucs_rcache_stats_class = {
+    .name           = "rcache",
+    .num_counters   = UCS_RCACHE_STAT_LAST,
+    .counter_names  = {
+        [UCS_RCACHE_STAT_GETS]              = "gets",
+        [UCS_RCACHE_STAT_HITS_FAST]         = "hits_fast",
+        [UCS_RCACHE_STAT_HITS_SLOW]         = "hits_slow",
+        [UCS_RCACHE_STAT_MISSES]            = "misses",
+        [UCS_RCACHE_STAT_MERGES]            = "regions_merged",
+        [UCS_RCACHE_STAT_PUTS]              = "puts",
+        [UCS_RCACHE_STAT_DEREGS]            = "deregs",
+        [UCS_RCACHE_STAT_UNMAPS]            = "unmaps",
+        [UCS_RCACHE_STAT_UNMAP_INVALIDATES] = "unmap_invalidates",
+        [UCS_RCACHE_STAT_LRU_EVICTS]        = "lru_evicts",
+        [UCS_RCACHE_STAT_REGIONS]           = "regions",
+        [UCS_RCACHE_STAT_PINNED_BYTES]      = "pinned_bytes"
+    }
+};
+#endif
+
+
 typedef struct ucs_rcache_inv_entry {
     ucs_queue_elem_t         queue;
     ucs_pgt_addr_t           start;
@@ -45,6 +68,10 @@ typedef struct ucs_rcache_inv_entry {
 } ucs_rcache_inv_entry_t;
 
 
+static void ucs_rcache_unmapped_callback(ucm_event_type_t event_type,
+                                         ucm_event_t *event, void *arg);
+
+
 static void __ucs_rcache_region_log(const char *file, int line, const char *function,
                                     ucs_log_level_t level, ucs_rcache_t *rcache,
                                     ucs_rcache_region_t *region, const char *fmt,
@@ -79,14 +106,66 @@ static void __ucs_rcache_region_log(const char *file, int line, const char *func
 
 static ucs_pgt_dir_t *ucs_rcache_pgt_dir_alloc(const ucs_pgtable_t *pgtable)
 {
-    return ucs_memalign(UCS_PGT_ENTRY_MIN_ALIGN, sizeof(ucs_pgt_dir_t),
+    /* Leave room for an element of the retired directories queue */
+    return ucs_memalign(UCS_PGT_ENTRY_MIN_ALIGN,
+                        sizeof(ucs_pgt_dir_t) + sizeof(ucs_queue_elem_t),
                         "rcache_pgdir");
 }
 
+/* Lock must be held in write mode */
 static void ucs_rcache_pgt_dir_release(const ucs_pgtable_t *pgtable,
                                        ucs_pgt_dir_t *dir)
 {
-    ucs_free(dir);
+    ucs_rcache_t *rcache = ucs_container_of(pgtable, ucs_rcache_t, pgtable);
+
+    /* Lock-free lookups may still be traversing the directory */
+    ucs_queue_push(&rcache->retired_dirs, (ucs_queue_elem_t*)(dir + 1));
+}
+
+/*
+ * Start a lock-free lookup. The page table directories and the regions which
+ * are seen by the lookup are not released until it ends.
+ * Atomic operations imply a full memory barrier, so no extra fences are needed.
+ */
+static UCS_F_ALWAYS_INLINE unsigned ucs_rcache_read_enter(ucs_rcache_t *rcache)
+{
+    unsigned idx = rcache->epoch & 1;
+
+    ucs_atomic_add32(&rcache->readers[idx], 1);
+    return idx;
+}
+
+static UCS_F_ALWAYS_INLINE void ucs_rcache_read_leave(ucs_rcache_t *rcache,
+                                                      unsigned idx)
+{
+    ucs_atomic_add32(&rcache->readers[idx], -1);
+}
+
+/*
+ * Wait until all lookups which could see the objects removed so far have
+ * completed. Every pass moves new lookups to the other counter, and drains
+ * the current one.
+ * Lock must be held in write mode.
+ */
+static void ucs_rcache_synchronize(ucs_rcache_t *rcache)
+{
+    unsigned i, idx;
+
+    for (i = 0; i < 2; ++i) {
+        idx = rcache->epoch & 1;
+        ucs_atomic_add32(&rcache->epoch, 1);
+        while (rcache->readers[idx] != 0) {
+            sched_yield();
+        }
+    }
+}
+
+static void ucs_rcache_usage_update(ucs_rcache_t *rcache)
+{
+    UCS_STATS_SET_COUNTER(rcache->stats, UCS_RCACHE_STAT_REGIONS,
+                          rcache->num_regions);
+    UCS_STATS_SET_COUNTER(rcache->stats, UCS_RCACHE_STAT_PINNED_BYTES,
+                          rcache->total_size);
 }
 
 static ucs_status_t ucs_rcache_mp_chunk_alloc(ucs_mpool_t *mp, size_t *size_p,
@@ -156,6 +235,7 @@ static void ucs_mem_region_destroy_internal(ucs_rcache_t *rcache,
 {
     ucs_rcache_region_trace(rcache, region, "destroy");
     if (region->flags & UCS_RCACHE_REGION_FLAG_REGISTERED) {
+        UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_STAT_DEREGS, 1);
         UCS_PROFILE_CODE("mem_dereg") {
             rcache->params.ops->mem_dereg(rcache->params.context, rcache, region);
         }
@@ -165,35 +245,91 @@ static void ucs_mem_region_destroy_internal(ucs_rcache_t *rcache,
 
 /* Lock must be held in write mode */
 static void ucs_rcache_region_invalidate(ucs_rcache_t *rcache,
-                                         ucs_rcache_region_t *region,
-                                         int must_be_in_pgt,
-                                         int must_be_destroyed)
+                                         ucs_rcache_region_t *region)
 {
     ucs_status_t status;
 
     ucs_rcache_region_trace(rcache, region, "invalidate");
+    ucs_assert(region->flags & UCS_RCACHE_REGION_FLAG_PGTABLE);
 
-    /* Remove the memory region from page table, if it's there */
-    if (region->flags & UCS_RCACHE_REGION_FLAG_PGTABLE) {
-        status = ucs_pgtable_remove(&rcache->pgtable, &region->super);
-        if (status != UCS_OK) {
-            ucs_rcache_region_warn(rcache, region, "failed to remove (%s)",
-                                   ucs_status_string(status));
-        }
-        region->flags &= ~UCS_RCACHE_REGION_FLAG_PGTABLE;
-    } else {
-        ucs_assert(!must_be_in_pgt);
+    /* Remove the memory region from page table */
+    status = ucs_pgtable_remove(&rcache->pgtable, &region->super);
+    if (status != UCS_OK) {
+        ucs_rcache_region_warn(rcache, region, "failed to remove (%s)",
+                               ucs_status_string(status));
     }
+    ucm_remove_event_range(ucs_rcache_unmapped_callback, rcache,
+                           (void*)region->super.start,
+                           region->super.end - region->super.start);
+
+    --rcache->num_regions;
+    if (region->flags & UCS_RCACHE_REGION_FLAG_REGISTERED) {
+        rcache->total_size -= region->super.end - region->super.start;
+    }
+    ucs_rcache_usage_update(rcache);
+
+    region->flags &= ~UCS_RCACHE_REGION_FLAG_PGTABLE;
+    region->flags |= UCS_RCACHE_REGION_FLAG_INVALID;
 
-    /* If no one is using the region, we can completely destroy it.
-     * Otherwise, just mark it as invalid, and it would be destroyed when the
-     * reference count drops to 0.
+    /* The page table reference is released after concurrent lookups complete.
+     * Then, the region is destroyed when no one is using it.
      */
-    if (region->refcount == 0) {
-        ucs_mem_region_destroy_internal(rcache, region);
-    } else {
-        ucs_assert(!must_be_destroyed);
-        region->flags |= UCS_RCACHE_REGION_FLAG_INVALID;
+    ucs_list_del(&region->lru_list);
+    ucs_list_add_tail(&rcache->retired, &region->lru_list);
+}
+
+/* Lock must be held in write mode */
+static void ucs_rcache_release_retired(ucs_rcache_t *rcache)
+{
+    ucs_rcache_region_t *region, *tmp;
+    ucs_queue_elem_t *elem;
+
+    if (ucs_list_is_empty(&rcache->retired) &&
+        ucs_queue_is_empty(&rcache->retired_dirs)) {
+        return;
+    }
+
+    ucs_rcache_synchronize(rcache);
+
+    ucs_list_for_each_safe(region, tmp, &rcache->retired, lru_list) {
+        ucs_list_del(&region->lru_list);
+        if (ucs_atomic_fadd32(&region->refcount, -1) == 1) {
+            ucs_mem_region_destroy_internal(rcache, region);
+        }
+    }
+
+    while (!ucs_queue_is_empty(&rcache->retired_dirs)) {
+        elem = ucs_queue_pull_non_empty(&rcache->retired_dirs);
+        ucs_free((ucs_pgt_dir_t*)elem - 1);
+    }
+}
+
+/* Evict least recently used regions which are not in use, until the cache is
+ * within its limits. Regions which were used since the last scan get another
+ * chance.
+ * Lock must be held in write mode */
+static void ucs_rcache_lru_evict(ucs_rcache_t *rcache)
+{
+    ucs_rcache_region_t *region;
+    unsigned long max_scan;
+
+    /* Every region is visited at most twice: once to clear its hit flag, and
+     * once to evict it */
+    max_scan = 2 * rcache->num_regions;
+    while (((rcache->num_regions > rcache->params.max_regions) ||
+            (rcache->total_size  > rcache->params.max_size)) &&
+           (max_scan-- > 0)) {
+        region = ucs_list_head(&rcache->lru, ucs_rcache_region_t, lru_list);
+        if ((region->refcount > 1) || region->lru_hit) {
+            region->lru_hit = 0;
+            ucs_list_del(&region->lru_list);
+            ucs_list_add_tail(&rcache->lru, &region->lru_list);
+            continue;
+        }
+
+        ucs_rcache_region_trace(rcache, region, "evict");
+        ucs_rcache_region_invalidate(rcache, region);
+        UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_STAT_LRU_EVICTS, 1);
     }
 }
 
@@ -208,7 +344,9 @@ static void ucs_rcache_invalidate_range(ucs_rcache_t *rcache, ucs_pgt_addr_t sta
 
     ucs_rcache_find_regions(rcache, start, end - 1, &region_list);
     ucs_list_for_each_safe(region, tmp, &region_list, list) {
-        ucs_rcache_region_invalidate(rcache, region, 0, 0);
+        ucs_rcache_region_invalidate(rcache, region);
+        UCS_STATS_UPDATE_COUNTER(rcache->stats,
+                                 UCS_RCACHE_STAT_UNMAP_INVALIDATES, 1);
     }
 }
 
@@ -259,6 +397,7 @@ static void ucs_rcache_unmapped_callback(ucm_event_type_t event_type,
         entry->start = start;
         entry->end   = end;
         ucs_queue_push(&rcache->inv_q, &entry->queue);
+        UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_STAT_UNMAPS, 1);
     } else {
         ucs_error("Failed to allocate invalidation entry for 0x%lx..0x%lx, "
                   "data corruption may occur", start, end);
@@ -280,12 +419,17 @@ static void ucs_rcache_purge(ucs_rcache_t *rcache)
     ucs_pgtable_purge(&rcache->pgtable, ucs_rcache_region_collect_callback,
                       &region_list);
     ucs_list_for_each_safe(region, tmp, &region_list, list) {
-        if (region->refcount > 0) {
+        if (region->refcount > 1) {
             ucs_rcache_region_warn(rcache, region, "destroying inuse");
         }
         region->flags &= ~UCS_RCACHE_REGION_FLAG_PGTABLE;
+        ucs_list_del(&region->lru_list);
         ucs_mem_region_destroy_internal(rcache, region);
     }
+
+    rcache->num_regions = 0;
+    rcache->total_size  = 0;
+    ucs_rcache_usage_update(rcache);
 }
 
 static inline int ucs_rcache_region_test(ucs_rcache_region_t *region, int prot)
@@ -336,7 +480,7 @@ ucs_rcache_check_overlap(ucs_rcache_t *rcache, ucs_pgt_addr_t *start,
                                     " with mem "UCS_RCACHE_PROT_FMT,
                                     UCS_RCACHE_PROT_ARG(*prot),
                                     UCS_RCACHE_PROT_ARG(mem_prot));
-            ucs_rcache_region_invalidate(rcache, region, 1, 0);
+            ucs_rcache_region_invalidate(rcache, region);
             continue;
         }
 
@@ -362,7 +506,7 @@ ucs_rcache_check_overlap(ucs_rcache_t *rcache, ucs_pgt_addr_t *start,
                 ucs_rcache_region_trace(rcache, region,
                                         "do not merge mem "UCS_RCACHE_PROT_FMT" with",
                                         UCS_RCACHE_PROT_ARG(mem_prot));
-                ucs_rcache_region_invalidate(rcache, region, 1, 0);
+                ucs_rcache_region_invalidate(rcache, region);
                 continue;
             }
         }
@@ -372,7 +516,8 @@ ucs_rcache_check_overlap(ucs_rcache_t *rcache, ucs_pgt_addr_t *start,
                                 *start, *end, UCS_RCACHE_PROT_ARG(*prot));
         *start = ucs_min(*start, region->super.start);
         *end   = ucs_max(*end,   region->super.end);
-        ucs_rcache_region_invalidate(rcache, region, 1, 0);
+        ucs_rcache_region_invalidate(rcache, region);
+        UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_STAT_MERGES, 1);
     }
     return UCS_OK;
 }
@@ -403,7 +548,9 @@ ucs_rcache_create_region(ucs_rcache_t *rcache, void *address, size_t length,
         /* Found a matching region (it could have been added after we released
          * the lock)
          */
-        status = region->status;
+        UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_STAT_HITS_SLOW, 1);
+        region->lru_hit = 1;
+        status          = region->status;
         goto out_set_region;
     } else if (status != UCS_OK) {
         /* Could not create a region because there are overlapping regions which
@@ -412,6 +559,8 @@ ucs_rcache_create_region(ucs_rcache_t *rcache, void *address, size_t length,
         goto out_unlock;
     }
 
+    UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_STAT_MISSES, 1);
+
     /* Allocate structure for new region */
     region = ucs_memalign(UCS_PGT_ENTRY_MIN_ALIGN, rcache->params.region_struct_size,
                           "rcache_region");
@@ -422,22 +571,33 @@ ucs_rcache_create_region(ucs_rcache_t *rcache, void *address, size_t length,
 
     memset(region, 0, rcache->params.region_struct_size);
 
+    /* The page table holds a reference to the region */
     region->super.start = start;
     region->super.end   = end;
+    region->prot        = prot;
+    region->refcount    = 1;
+
+    /* Subscribe to unmap events before the region becomes visible, so an
+     * invalidation could not be missed */
+    ucm_add_event_range(ucs_rcache_unmapped_callback, rcache, (void*)start,
+                        end - start);
     status = UCS_PROFILE_CALL(ucs_pgtable_insert, &rcache->pgtable, &region->super);
     if (status != UCS_OK) {
         ucs_error("failed to insert region " UCS_PGT_REGION_FMT ": %s",
                   UCS_PGT_REGION_ARG(&region->super), ucs_status_string(status));
+        ucm_remove_event_range(ucs_rcache_unmapped_callback, rcache,
+                               (void*)start, end - start);
         ucs_free(region);
         goto out_unlock;
     }
 
+    region->flags = UCS_RCACHE_REGION_FLAG_PGTABLE;
+    ucs_list_add_tail(&rcache->lru, &region->lru_list);
+    ++rcache->num_regions;
+
     /* If memory registration failed, keep the region and mark it as invalid,
      * to avoid numerous retries of registering the region.
      */
-    region->prot     = prot;
-    region->flags    = UCS_RCACHE_REGION_FLAG_PGTABLE;
-    region->refcount = 0;
     region->status = status =
         UCS_PROFILE_NAMED_CALL("mem_reg", rcache->params.ops->mem_reg,
                                rcache->params.context, rcache, arg, region);
@@ -447,17 +607,25 @@ ucs_rcache_create_region(ucs_rcache_t *rcache, void *address, size_t length,
          */
         ucs_rcache_region_debug(rcache, region, "created with status %s",
                                 ucs_status_string(status));
+        ucs_rcache_usage_update(rcache);
         goto out_unlock;
     }
 
-    region->flags   |= UCS_RCACHE_REGION_FLAG_REGISTERED;
-    region->refcount = 1;
+    /* Lock-free lookups use the region once they see the registered flag, so
+     * the registration and the user reference must be visible before it */
+    ucs_atomic_add32(&region->refcount, 1);
+    ucs_memory_cpu_store_fence();
+    region->flags      |= UCS_RCACHE_REGION_FLAG_REGISTERED;
+    rcache->total_size += end - start;
+    ucs_rcache_usage_update(rcache);
 
     ucs_rcache_region_trace(rcache, region, "created");
 
 out_set_region:
     *region_p = region;
 out_unlock:
+    ucs_rcache_lru_evict(rcache);
+    ucs_rcache_release_retired(rcache);
     pthread_rwlock_unlock(&rcache->lock);
     return status;
 }
@@ -474,11 +642,14 @@ ucs_status_t ucs_rcache_get(ucs_rcache_t *rcache, void *address, size_t length,
     ucs_pgt_addr_t start = (uintptr_t)address;
     ucs_pgt_region_t *pgt_region;
     ucs_rcache_region_t *region;
+    unsigned idx;
 
     ucs_trace_func("rcache=%s, address=%p, length=%zu", rcache->name, address,
                    length);
 
-    pthread_rwlock_rdlock(&rcache->lock);
+    UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_STAT_GETS, 1);
+
+    idx = ucs_rcache_read_enter(rcache);
     if (ucs_queue_is_empty(&rcache->inv_q)) {
         pgt_region = ucs_pgtable_lookup(&rcache->pgtable, start);
         if (ucs_likely(pgt_region != NULL)) {
@@ -486,16 +657,30 @@ ucs_status_t ucs_rcache_get(ucs_rcache_t *rcache, void *address, size_t length,
             if (((start + length) <= region->super.end) &&
                 ucs_rcache_region_test(region, prot))
             {
+                /* The region could not be released before we leave, since
+                 * the page table reference is dropped only after that */
                 ucs_rcache_region_hold(rcache, region);
-                *region_p = region;
-                pthread_rwlock_unlock(&rcache->lock);
+                ucs_rcache_read_leave(rcache, idx);
+
+                if (ucs_unlikely(region->flags &
+                                 UCS_RCACHE_REGION_FLAG_INVALID)) {
+                    /* Removed from the page table while we were using it */
+                    ucs_rcache_region_put(rcache, region);
+                    goto slow_path;
+                }
+
+                region->lru_hit = 1;
+                *region_p       = region;
+                UCS_STATS_UPDATE_COUNTER(rcache->stats,
+                                         UCS_RCACHE_STAT_HITS_FAST, 1);
                 return UCS_OK;
             }
         }
     }
-    pthread_rwlock_unlock(&rcache->lock);
+    ucs_rcache_read_leave(rcache, idx);
 
-    /* Fall back to slow version (with rw lock) in following cases:
+slow_path:
+    /* Fall back to slow version (with write lock) in following cases:
      * - invalidation list not empty
      * - could not find cached region
      * - found unregistered region
@@ -507,15 +692,16 @@ ucs_status_t ucs_rcache_get(ucs_rcache_t *rcache, void *address, size_t length,
 void ucs_rcache_region_put(ucs_rcache_t *rcache, ucs_rcache_region_t *region)
 {
     ucs_rcache_region_trace(rcache, region, "put");
+    UCS_STATS_UPDATE_COUNTER(rcache->stats, UCS_RCACHE_STAT_PUTS, 1);
 
     ucs_assert(region->refcount > 0);
-    ucs_atomic_add32(&region->refcount, -1);
 
-    if (ucs_unlikely(region->flags & UCS_RCACHE_REGION_FLAG_INVALID) &&
-        (region->refcount == 0))
-    {
+    /* The page table holds a reference, so the last one is released only
+     * after the region was removed from it */
+    if (ucs_unlikely(ucs_atomic_fadd32(&region->refcount, -1) == 1)) {
+        ucs_assert(region->flags & UCS_RCACHE_REGION_FLAG_INVALID);
         pthread_rwlock_wrlock(&rcache->lock);
-        ucs_rcache_region_invalidate(rcache, region, 0, 1);
+        ucs_mem_region_destroy_internal(rcache, region);
         pthread_rwlock_unlock(&rcache->lock);
     }
 }
@@ -543,7 +729,15 @@ static UCS_CLASS_INIT_FUNC(ucs_rcache_t, const ucs_rcache_params_t *params,
         goto err;
     }
 
-    self->params = *params;
+    self->params      = *params;
+    self->readers[0]  = 0;
+    self->readers[1]  = 0;
+    self->epoch       = 0;
+    self->num_regions = 0;
+    self->total_size  = 0;
+    ucs_list_head_init(&self->retired);
+    ucs_queue_head_init(&self->retired_dirs);
+    ucs_list_head_init(&self->lru);
 
     self->name = strdup(name);
     if (self->name == NULL) {
@@ -551,11 +745,17 @@ static UCS_CLASS_INIT_FUNC(ucs_rcache_t, const ucs_rcache_params_t *params,
         goto err;
     }
 
+    status = UCS_STATS_NODE_ALLOC(&self->stats, &ucs_rcache_stats_class,
+                                  stats_parent, "-%s", name);
+    if (status != UCS_OK) {
+        goto err_free_name;
+    }
+
     ret = pthread_rwlock_init(&self->lock, NULL);
     if (ret) {
         ucs_error("pthread_rwlock_init() failed: %m");
         status = UCS_ERR_INVALID_PARAM;
-        goto err_free_name;
+        goto err_free_stats;
     }
 
     ret = pthread_spin_init(&self->inv_lock, 0);
@@ -577,7 +777,9 @@ static UCS_CLASS_INIT_FUNC(ucs_rcache_t, const ucs_rcache_params_t *params,
         goto err_cleanup_pgtable;
     }
 
-    status = ucm_set_event_handler(UCM_EVENT_VM_UNMAPPED, params->ucm_event_priority,
+    status = ucm_set_event_handler(UCM_EVENT_VM_UNMAPPED |
+                                   UCM_EVENT_FLAG_ADDR_RANGES,
+                                   params->ucm_event_priority,
                                    ucs_rcache_unmapped_callback, self);
     if (status != UCS_OK) {
         goto err_destroy_mp;
@@ -594,6 +796,8 @@ err_destroy_inv_q_lock:
     pthread_spin_destroy(&self->inv_lock);
 err_destroy_rwlock:
     pthread_rwlock_destroy(&self->lock);
+err_free_stats:
+    UCS_STATS_NODE_FREE(self->stats);
 err_free_name:
     free(self->name);
 err:
@@ -602,15 +806,17 @@ err:
 
 static UCS_CLASS_CLEANUP_FUNC(ucs_rcache_t)
 {
-    ucm_unset_event_handler(UCM_EVENT_VM_UNMAPPED, ucs_rcache_unmapped_callback,
-                            self);
+    ucm_unset_event_handler(UCM_EVENT_VM_UNMAPPED | UCM_EVENT_FLAG_ADDR_RANGES,
+                            ucs_rcache_unmapped_callback, self);
     ucs_rcache_check_inv_queue(self);
     ucs_rcache_purge(self);
+    ucs_rcache_release_retired(self);
 
     ucs_mpool_cleanup(&self->inv_mp, 1);
     ucs_pgtable_cleanup(&self->pgtable);
     pthread_spin_destroy(&self->inv_lock);
     pthread_rwlock_destroy(&self->lock);
+    UCS_STATS_NODE_FREE(self->stats);
     free(self->name);
 }
 
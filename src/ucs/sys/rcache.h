@@ -10,7 +10,9 @@
 /*
  * Memory registration cache - holds registered memory regions, takes care of
  * memory invalidation (if it's unmapped), merging of regions, protection flags.
- * This data structure is thread safe.
+ * This data structure is thread safe. Cache hits do not take any lock; regions
+ * and page table directories removed by updates are released only after all
+ * concurrent lookups have completed.
  */
 #include <ucs/datastruct/pgtable.h>
 #include <ucs/datastruct/list.h>
@@ -35,6 +37,27 @@ enum {
 };
 
 
+/*
+ * Registration cache statistics counters.
+ */
+enum {
+    UCS_RCACHE_STAT_GETS,              /**< Number of get operations */
+    UCS_RCACHE_STAT_HITS_FAST,         /**< Found a region with the read lock */
+    UCS_RCACHE_STAT_HITS_SLOW,         /**< Found a region with the write lock */
+    UCS_RCACHE_STAT_MISSES,            /**< Had to register a new region */
+    UCS_RCACHE_STAT_MERGES,            /**< Regions merged into a new region */
+    UCS_RCACHE_STAT_PUTS,              /**< Number of put operations */
+    UCS_RCACHE_STAT_DEREGS,            /**< Regions which were deregistered */
+    UCS_RCACHE_STAT_UNMAPS,            /**< Memory unmap events */
+    UCS_RCACHE_STAT_UNMAP_INVALIDATES, /**< Regions invalidated by unmap events */
+    UCS_RCACHE_STAT_LRU_EVICTS,        /**< Regions evicted because of the cache
+                                            size limits */
+    UCS_RCACHE_STAT_REGIONS,           /**< Current number of regions */
+    UCS_RCACHE_STAT_PINNED_BYTES,      /**< Current size of registered regions */
+    UCS_RCACHE_STAT_LAST
+};
+
+
 /*
  * Registration cache operations.
  */
@@ -90,25 +113,46 @@ struct ucs_rcache_params {
     const ucs_rcache_ops_t *ops;                /**< Memory operations functions */
     void                   *context;            /**< User-defined context that will
                                                      be passed to mem_reg/mem_dereg */
+    unsigned long          max_regions;         /**< Maximal number of regions,
+                                                     UCS_CONFIG_ULUNITS_INF - no limit */
+    size_t                 max_size;            /**< Maximal total size of registered
+                                                     regions, UCS_CONFIG_MEMUNITS_INF
+                                                     - no limit */
 };
 
 
 struct ucs_rcache_region {
     ucs_pgt_region_t       super;    /**< Base class - page table region */
     ucs_list_link_t        list;     /**< List element */
-    volatile uint32_t      refcount; /**< Usage count */
+    ucs_list_link_t        lru_list; /**< LRU list element */
+    volatile uint32_t      refcount; /**< Usage count, including a reference
+                                          held by the page table */
     ucs_status_t           status;   /**< Current status code */
     uint8_t                prot;     /**< Protection bits */
+    volatile uint8_t       lru_hit;  /**< Used since the last LRU scan */
     uint16_t               flags;    /**< Status flags. Protected by page table lock. */
 };
 
 
 struct ucs_rcache {
     ucs_rcache_params_t    params;   /**< rcache parameters (immutable) */
-    pthread_rwlock_t       lock;     /**< Protects the page table and all regions
-                                          whose refcount is 0 */
+    pthread_rwlock_t       lock;     /**< Serializes updates of the page table */
     ucs_pgtable_t          pgtable;  /**< page table to hold the regions */
 
+    volatile uint32_t      readers[2]; /**< Number of lock-free lookups which
+                                            started in even/odd epochs */
+    volatile uint32_t      epoch;    /**< Current reader epoch */
+    ucs_list_link_t        retired;  /**< Regions removed from the page table,
+                                          waiting for concurrent lookups */
+    ucs_queue_head_t       retired_dirs; /**< Page table directories waiting for
+                                              concurrent lookups */
+
+    ucs_list_link_t        lru;      /**< Regions in the page table, least
+                                          recently used first */
+    unsigned long          num_regions; /**< Number of regions in the page table */
+    size_t                 total_size;  /**< Size of registered regions in the
+                                             page table */
+
     pthread_spinlock_t     inv_lock; /**< Lock for inv_q and inv_mp. This is a
                                           separate lock because we may want to put
                                           regions on inv_q while the page table
@@ -120,6 +164,7 @@ struct ucs_rcache {
                                           The backing storage is original mmap()
                                           which does not generate memory events */
     char                   *name;
+    UCS_STATS_NODE_DECLARE(stats);   /**< Hit/miss/eviction statistics */
 };
 
 
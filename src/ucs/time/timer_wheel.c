@@ -6,11 +6,48 @@
 
 #include <ucs/time/timer_wheel.h>
 
+#include <ucs/arch/bitops.h>
 #include <ucs/debug/log.h>
 #include <ucs/debug/memtrack.h>
 #include <ucs/sys/math.h>
 
 
+/* log2 of the number of ticks covered by a single slot of the given level */
+#define UCS_TWHEEL_LEVEL_SHIFT(_level) ((_level) * UCS_TWHEEL_LEVEL_BITS)
+
+
+static inline ucs_list_link_t *ucs_twheel_slot(ucs_twheel_t *t, unsigned level,
+                                               unsigned slot)
+{
+    return &t->wheel[(level * t->num_slots) + slot];
+}
+
+static inline unsigned ucs_twheel_slot_index(uint64_t tick, unsigned level)
+{
+    return (tick >> UCS_TWHEEL_LEVEL_SHIFT(level)) & (UCS_TWHEEL_LEVEL_SLOTS - 1);
+}
+
+/* First tick of the rotation of the given level which contains 'tick' */
+static inline uint64_t ucs_twheel_rotation_start(uint64_t tick, unsigned level)
+{
+    unsigned shift = UCS_TWHEEL_LEVEL_SHIFT(level + 1);
+    return (shift >= 64) ? 0 : ((tick >> shift) << shift);
+}
+
+static void ucs_twheel_insert(ucs_twheel_t *t, ucs_wtimer_t *timer)
+{
+    uint64_t diff = timer->expires ^ t->current;
+    unsigned level, slot;
+
+    /* Put the timer on the highest level on which its slot differs from the
+     * current one, so it is reached exactly once before it expires */
+    level = (diff == 0) ? 0 : (ucs_ilog2(diff) / UCS_TWHEEL_LEVEL_BITS);
+    slot  = ucs_twheel_slot_index(timer->expires, level);
+
+    ucs_list_add_tail(ucs_twheel_slot(t, level, slot), &timer->list);
+    t->slot_map[level] |= UCS_BIT(slot);
+}
+
 ucs_status_t ucs_twheel_init(ucs_twheel_t *twheel, ucs_time_t resolution,
                              ucs_time_t current_time)
 {
@@ -18,77 +55,170 @@ ucs_status_t ucs_twheel_init(ucs_twheel_t *twheel, ucs_time_t resolution,
 
     twheel->res         = ucs_roundup_pow2(resolution);
     twheel->res_order   = (unsigned) ucs_log2(twheel->res);
-    twheel->num_slots   = 1024;
+    twheel->num_slots   = UCS_TWHEEL_LEVEL_SLOTS;
+    /* one extra bit for the carry when adding the longest delta */
+    twheel->num_levels  = ucs_div_round_up(64 - twheel->res_order + 1,
+                                           UCS_TWHEEL_LEVEL_BITS);
     twheel->current     = 0;
     twheel->now         = current_time;
-    twheel->wheel       = ucs_malloc(sizeof(*twheel->wheel) * twheel->num_slots,
-                                     "twheel");
+    twheel->wheel       = ucs_malloc(sizeof(*twheel->wheel) * twheel->num_slots *
+                                     twheel->num_levels, "twheel");
+    if (twheel->wheel == NULL) {
+        ucs_error("failed to allocate timer wheel");
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    twheel->slot_map    = ucs_calloc(twheel->num_levels,
+                                     sizeof(*twheel->slot_map), "twheel_map");
+    if (twheel->slot_map == NULL) {
+        ucs_error("failed to allocate timer wheel slot map");
+        ucs_free(twheel->wheel);
+        return UCS_ERR_NO_MEMORY;
+    }
 
-    for (i = 0; i < twheel->num_slots; i++) {
+    for (i = 0; i < twheel->num_slots * twheel->num_levels; i++) {
         ucs_list_head_init(&twheel->wheel[i]);
     }
 
-    ucs_debug("high res timer created log=%d resolution=%lf usec wanted: %lf usec",
-              twheel->res_order, ucs_time_to_usec(twheel->res), ucs_time_to_usec(resolution));
+    ucs_debug("high res timer created log=%d resolution=%lf usec wanted: %lf usec levels: %u",
+              twheel->res_order, ucs_time_to_usec(twheel->res),
+              ucs_time_to_usec(resolution), twheel->num_levels);
     return UCS_OK;
 }
 
 void ucs_twheel_cleanup(ucs_twheel_t *twheel)
 {
+    ucs_free(twheel->slot_map);
     ucs_free(twheel->wheel);
 }
 
 ucs_status_t ucs_wtimer_init(ucs_wtimer_t *t, ucs_twheel_callback_t cb)
 {
     t->cb        = cb;
+    t->expires   = 0;
     t->is_active = 0;
     return UCS_OK;
 }
 
 void __ucs_wtimer_add(ucs_twheel_t *t, ucs_wtimer_t *timer, ucs_time_t delta)
 {
-    uint64_t slot;
+    uint64_t ticks;
 
     timer->is_active = 1;
-    slot = delta>>t->res_order;
-    if (ucs_unlikely(slot == 0)) {
+    ticks = delta >> t->res_order;
+    if (ucs_unlikely(ticks == 0)) {
         /* nothing really wrong with adding timer to the current slot. However
          * we want to guard against the case we spend to much time in hi res
          * timer processing */
         ucs_fatal("Timer resolution is too low. Min resolution %lf usec, wanted %lf usec",
                 ucs_time_to_usec(t->res), ucs_time_to_usec(delta));
     }
-    ucs_assert(slot > 0);
+    ucs_assert(ticks > 0);
+
+    timer->expires = t->current + ticks;
+    ucs_twheel_insert(t, timer);
+}
+
+/*
+ * Find the next tick after the current one which has a non-empty slot on any
+ * level. Slots of a level are scanned only up to the end of its rotation;
+ * slots before the current one were already handled. Since every rotation of
+ * a level ends before the next slot of the level above it, the lowest level
+ * which has a pending slot determines the next tick.
+ */
+static int ucs_twheel_next_tick(ucs_twheel_t *t, uint64_t *tick_p)
+{
+    unsigned level, slot;
+    uint64_t pending;
+
+    for (level = 0; level < t->num_levels; ++level) {
+        slot = ucs_twheel_slot_index(t->current, level);
+        if (slot == (t->num_slots - 1)) {
+            continue;
+        }
+
+        pending = t->slot_map[level] & (UINT64_MAX << (slot + 1));
+
+        if (pending != 0) {
+            *tick_p = ucs_twheel_rotation_start(t->current, level) +
+                      ((uint64_t)ucs_ffs64(pending) << UCS_TWHEEL_LEVEL_SHIFT(level));
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Move the timers from the current slot of every level whose rotation of
+ * lower levels has just completed, to the lower levels.
+ */
+static void ucs_twheel_cascade(ucs_twheel_t *t)
+{
+    ucs_list_link_t *head, timers;
+    ucs_wtimer_t *timer, *ttimer;
+    unsigned level, top, slot;
+
+    top = 0;
+    while ((top + 1 < t->num_levels) &&
+           (ucs_twheel_slot_index(t->current, top) == 0)) {
+        ++top;
+    }
+
+    for (level = top; level > 0; --level) {
+        slot = ucs_twheel_slot_index(t->current, level);
+        if (!(t->slot_map[level] & UCS_BIT(slot))) {
+            continue;
+        }
 
-    if (ucs_unlikely(slot >= t->num_slots)) {
-        slot = t->num_slots - 1;
+        head = ucs_twheel_slot(t, level, slot);
+        t->slot_map[level] &= ~UCS_BIT(slot);
+        if (ucs_list_is_empty(head)) {
+            continue;
+        }
+
+        ucs_list_head_init(&timers);
+        ucs_list_splice_tail(&timers, head);
+        ucs_list_head_init(head);
+
+        ucs_list_for_each_safe(timer, ttimer, &timers, list) {
+            ucs_assert(timer->expires >= t->current);
+            ucs_twheel_insert(t, timer);
+        }
     }
+}
 
-    slot = (t->current + slot) % t->num_slots;
-    ucs_assert(slot != t->current);
+static void ucs_twheel_dispatch(ucs_twheel_t *t)
+{
+    unsigned slot = ucs_twheel_slot_index(t->current, 0);
+    ucs_list_link_t *head = ucs_twheel_slot(t, 0, slot);
+    ucs_wtimer_t *timer;
 
-    ucs_list_add_tail(&t->wheel[slot], &timer->list);
+    t->slot_map[0] &= ~UCS_BIT(slot);
+    while (!ucs_list_is_empty(head)) {
+        timer = ucs_list_extract_head(head, ucs_wtimer_t, list);
+        ucs_assert(timer->expires == t->current);
+        timer->is_active = 0;
+        timer->cb(timer);
+    }
 }
 
 void __ucs_twheel_sweep(ucs_twheel_t *t, ucs_time_t current_time)
 {
-    ucs_wtimer_t *timer;
-    uint64_t slot;
+    uint64_t target, tick;
 
-    slot   = (current_time - t->now) >> t->res_order;
+    /* Count the tick boundaries crossed since the last sweep, so the time
+     * between sweeps which is not a multiple of the resolution is not lost */
+    target = t->current + (current_time >> t->res_order) -
+                          (t->now >> t->res_order);
     t->now = current_time;
 
-    if (ucs_unlikely(slot >= t->num_slots)) {
-        slot = t->num_slots - 1;
+    /* Jump directly between ticks which have pending slots */
+    while (ucs_twheel_next_tick(t, &tick) && (tick <= target)) {
+        t->current = tick;
+        ucs_twheel_cascade(t);
+        ucs_twheel_dispatch(t);
     }
 
-    slot = (t->current + slot) % t->num_slots;
-
-    for (; t->current != slot; t->current = (t->current+1) % t->num_slots) {
-        while (!ucs_list_is_empty(&t->wheel[t->current])) {
-            timer = ucs_list_extract_head(&t->wheel[t->current], ucs_wtimer_t, list);
-            timer->is_active = 0;
-            timer->cb(timer);
-        }
-    }
+    t->current = target;
 }
@@ -9,6 +9,7 @@
 
 #include <ucs/datastruct/list.h>
 #include <ucs/time/time.h>
+#include <ucs/sys/math.h>
 #include <ucs/debug/log.h>
 
 
@@ -17,6 +18,11 @@ typedef struct ucs_wtimer       ucs_wtimer_t;
 typedef struct ucs_timer_wheel  ucs_twheel_t;
 
 
+/* Every level of the wheel has 2^UCS_TWHEEL_LEVEL_BITS slots */
+#define UCS_TWHEEL_LEVEL_BITS    6
+#define UCS_TWHEEL_LEVEL_SLOTS   UCS_BIT(UCS_TWHEEL_LEVEL_BITS)
+
+
 /**
  * Timer wheel callback
  */
@@ -29,17 +35,27 @@ typedef void (*ucs_twheel_callback_t)(ucs_wtimer_t *self);
 struct ucs_wtimer {
     ucs_twheel_callback_t  cb;         /* User callback */
     ucs_list_link_t        list;       /* Link in the list of timers */
+    uint64_t               expires;    /* Expiration tick */
     int                    is_active;
 };
 
 
+/**
+ * Hierarchical timer wheel. Level 0 has a slot for each of the next
+ * UCS_TWHEEL_LEVEL_SLOTS ticks, and every slot of level N covers a whole
+ * rotation of level N-1. A timer is kept on the level of the most significant
+ * slot index by which its expiration tick differs from the current tick, and
+ * is moved to a lower level when the wheel reaches its slot.
+ */
 struct ucs_timer_wheel {
     ucs_time_t             res;
     ucs_time_t             now;        /* when wheel was last updated */
-    uint64_t               current;
-    ucs_list_link_t        *wheel;
+    uint64_t               current;    /* current tick */
+    ucs_list_link_t        *wheel;     /* num_levels * num_slots timer lists */
+    uint64_t               *slot_map;  /* per-level mask of non-empty slots */
     unsigned               res_order;
-    unsigned               num_slots;
+    unsigned               num_slots;  /* number of slots on every level */
+    unsigned               num_levels;
 };
 
 
@@ -47,7 +63,8 @@ struct ucs_timer_wheel {
  * Initialize the timer queue.
  *
  * @param twheel        Timer queue to initialize.
- * @param resolution    Timer resolution. Timer wheel range is from now to now + UCS_TWHEEL_NSLOTS * res
+ * @param resolution    Timer resolution, rounded up to a power of 2. Timers of
+ *                      any length expire within one resolution tick.
  * @param current_time  Current time to initialize the timer with.
  */
 ucs_status_t ucs_twheel_init(ucs_twheel_t *twheel, ucs_time_t resolution,
@@ -82,7 +99,8 @@ ucs_status_t ucs_wtimer_init(ucs_wtimer_t *t, ucs_twheel_callback_t cb);
 void __ucs_twheel_sweep(ucs_twheel_t *t, ucs_time_t current_time);
 static inline void ucs_twheel_sweep(ucs_twheel_t *t, ucs_time_t current_time)
 {
-    if (ucs_unlikely(current_time - t->now >= t->res)) {
+    if (ucs_unlikely((current_time >> t->res_order) !=
+                     (t->now >> t->res_order))) {
         __ucs_twheel_sweep(t, current_time);
     }
 }
@@ -100,7 +118,8 @@ static inline ucs_time_t ucs_twheel_get_time(ucs_twheel_t *t)
  *
  * @param twheel     Timer queue to schedule on.
  * @param timer      Timer callback to invoke every time.
- * @param delta      Invocation time
+ * @param delta      Invocation time, relative to @ref ucs_twheel_get_time.
+ *                   Must not be shorter than the wheel resolution.
  *
  * NOTE: adding timer already in queue will do nothing
  */
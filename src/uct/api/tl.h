@@ -145,6 +145,9 @@ typedef struct uct_iface_ops {
 
     ucs_status_t (*ep_pending_add)(uct_ep_h ep, uct_pending_req_t *n);
 
+    ucs_status_t (*ep_pending_add_prio)(uct_ep_h ep, uct_pending_req_t *n,
+                                        uct_pending_prio_t prio);
+
     void         (*ep_pending_purge)(uct_ep_h ep, uct_pending_purge_callback_t cb,
                                      void * arg);
 
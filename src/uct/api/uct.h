@@ -601,8 +601,10 @@ void uct_worker_destroy(uct_worker_h worker);
  * to receive the active message requests.
  *
  * @param [in]  worker        Handle to worker.
+ *
+ * @return Non-zero if any communication was progressed, zero otherwise.
  */
-void uct_worker_progress(uct_worker_h worker);
+unsigned uct_worker_progress(uct_worker_h worker);
 
 
 /**
@@ -612,7 +614,8 @@ void uct_worker_progress(uct_worker_h worker);
  * Add a function which will be called every time a progress is made on the worker.
  *
  * @param [in]  worker        Handle to worker.
- * @param [in]  func          Pointer to callback function.
+ * @param [in]  func          Pointer to callback function. The function should
+ *                            return the number of events it has processed.
  * @param [in]  arg           Argument to the function.
  *
  * @note If the same function and argument are already on the list, their reference
@@ -1586,6 +1589,28 @@ UCT_INLINE_API ucs_status_t uct_ep_pending_add(uct_ep_h ep, uct_pending_req_t *r
 }
 
 
+/**
+ * @ingroup UCT_RESOURCE
+ * @brief Add a pending request with a priority to an endpoint.
+ *
+ *  Same as @ref uct_ep_pending_add, but the request may be dispatched before
+ * requests of lower priority, according to @ref uct_pending_prio_t.
+ * Transports which do not support priorities dispatch the request in order.
+ *
+ * @param [in]  ep    Endpoint to add the pending request to.
+ * @param [in]  req   Pending request, as in @ref uct_ep_pending_add.
+ * @param [in]  prio  Request priority.
+ *
+ * @return Same as @ref uct_ep_pending_add.
+ */
+UCT_INLINE_API ucs_status_t uct_ep_pending_add_prio(uct_ep_h ep,
+                                                    uct_pending_req_t *req,
+                                                    uct_pending_prio_t prio)
+{
+    return ep->iface->ops.ep_pending_add_prio(ep, req, prio);
+}
+
+
 /**
  * @ingroup UCT_RESOURCE
  * @brief Remove all pending requests from an endpoint.
@@ -17,7 +17,7 @@
 #define UCT_MD_COMPONENT_NAME_MAX  8
 #define UCT_MD_NAME_MAX          16
 #define UCT_DEVICE_NAME_MAX      32
-#define UCT_PENDING_REQ_PRIV_LEN 32
+#define UCT_PENDING_REQ_PRIV_LEN 40
 #define UCT_AM_ID_BITS           5
 #define UCT_AM_ID_MAX            UCS_BIT(UCT_AM_ID_BITS)
 #define UCT_INVALID_MEM_HANDLE   NULL
@@ -52,6 +52,24 @@ enum uct_am_trace_type {
 };
 
 
+/**
+ * @ingroup UCT_RESOURCE
+ * @brief Pending request priority.
+ *
+ * When send resources become available, pending requests of a higher priority
+ * are dispatched before requests of a lower priority. On the same endpoint, a
+ * request may be dispatched before requests of a lower priority which were
+ * added earlier, except the first pending request of the endpoint. Requests
+ * of the same priority are always dispatched in order.
+ */
+enum uct_pending_prio {
+    UCT_PENDING_PRIO_BULK    = 0, /**< Bulk data transfer (default) */
+    UCT_PENDING_PRIO_LATENCY,     /**< Latency-sensitive operation */
+    UCT_PENDING_PRIO_CONTROL,     /**< Short control message */
+    UCT_PENDING_PRIO_LAST
+};
+
+
 /**
  * @addtogroup UCT_RESOURCE
  * @{
@@ -74,6 +92,7 @@ typedef struct uct_pending_req   uct_pending_req_t;
 typedef struct uct_worker        *uct_worker_h;
 typedef struct uct_md            uct_md_t;
 typedef enum uct_am_trace_type   uct_am_trace_type_t;
+typedef enum uct_pending_prio    uct_pending_prio_t;
 typedef struct uct_device_addr   uct_device_addr_t;
 typedef struct uct_iface_addr    uct_iface_addr_t;
 typedef struct uct_ep_addr       uct_ep_addr_t;
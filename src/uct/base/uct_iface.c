@@ -10,6 +10,7 @@
 
 #include <uct/api/uct.h>
 #include <ucs/time/time.h>
+#include <sys/poll.h>
 
 
 #if ENABLE_STATS
@@ -205,6 +206,36 @@ void uct_wakeup_close(uct_wakeup_h wakeup)
     ucs_free(wakeup);
 }
 
+ucs_status_t uct_base_iface_wakeup_get_fd(uct_wakeup_h wakeup, int *fd_p)
+{
+    *fd_p = wakeup->fd;
+    return UCS_OK;
+}
+
+ucs_status_t uct_base_iface_wakeup_wait(uct_wakeup_h wakeup)
+{
+    struct pollfd polled = { .fd = wakeup->fd, .events = POLLIN };
+    ucs_status_t status;
+    int ret;
+
+    status = wakeup->iface->ops.iface_wakeup_arm(wakeup);
+    if (status == UCS_ERR_BUSY) {
+        return UCS_OK;
+    } else if (status != UCS_OK) {
+        return status;
+    }
+
+    do {
+        ret = poll(&polled, 1, -1);
+    } while ((ret == -1) && (errno == EINTR));
+
+    if ((ret != 1) || !(polled.revents & POLLIN)) {
+        return UCS_ERR_IO_ERROR;
+    }
+
+    return UCS_OK;
+}
+
 void uct_iface_close(uct_iface_h iface)
 {
     iface->ops.iface_close(iface);
@@ -236,6 +267,14 @@ static ucs_status_t uct_base_ep_fence(uct_ep_h tl_ep, unsigned flags)
     return UCS_OK;
 }
 
+static ucs_status_t uct_base_ep_pending_add_prio(uct_ep_h tl_ep,
+                                                 uct_pending_req_t *req,
+                                                 uct_pending_prio_t prio)
+{
+    /* Transport without priorities, dispatch in order */
+    return tl_ep->iface->ops.ep_pending_add(tl_ep, req);
+}
+
 static void uct_ep_failed_purge_cb(uct_pending_req_t *self, void *arg)
 {
     uct_pending_req_push((ucs_queue_head_t*)arg, self);
@@ -291,6 +330,7 @@ void uct_set_ep_failed(ucs_class_t *cls, uct_ep_h tl_ep, uct_iface_h tl_iface)
     ops->ep_flush           = (void*)ucs_empty_function_return_ep_timeout;
     ops->ep_destroy         = uct_ep_failed_destroy;
     ops->ep_pending_add     = (void*)ucs_empty_function_return_ep_timeout;
+    ops->ep_pending_add_prio = (void*)ucs_empty_function_return_ep_timeout;
     ops->ep_pending_purge   = uct_ep_failed_purge;
     ops->ep_put_short       = (void*)ucs_empty_function_return_ep_timeout;
     ops->ep_put_bcopy       = (void*)ucs_empty_function_return_bc_ep_timeout;
@@ -326,6 +366,10 @@ UCS_CLASS_INIT_FUNC(uct_iface_t, uct_iface_ops_t *ops)
         self->ops.ep_fence = uct_base_ep_fence;
     }
 
+    if (ops->ep_pending_add_prio == NULL) {
+        self->ops.ep_pending_add_prio = uct_base_ep_pending_add_prio;
+    }
+
     if (ops->iface_flush == NULL) {
         self->ops.iface_flush = uct_base_iface_flush;
     }
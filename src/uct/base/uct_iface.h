@@ -10,6 +10,7 @@
 #include <uct/api/uct.h>
 #include <uct/base/addr.h>
 #include <ucs/config/parser.h>
+#include <ucs/datastruct/arbiter.h>
 #include <ucs/datastruct/mpool.h>
 #include <ucs/datastruct/queue.h>
 #include <ucs/debug/log.h>
@@ -258,6 +259,7 @@ struct uct_iface_config {
 typedef struct uct_iface_mpool_config {
     unsigned          max_bufs;  /* Upper limit to number of buffers */
     unsigned          bufs_grow; /* How many buffers (approx.) are allocated every time */
+    unsigned          thread_cache; /* Thread cache batch size, 0 - not thread-safe */
 } uct_iface_mpool_config_t;
 
 
@@ -273,7 +275,13 @@ typedef struct uct_iface_mpool_config {
     {_prefix "BUFS_GROW", UCS_PP_QUOTE(_dfl_grow), \
      "How much buffers are added every time the " _mp_name " memory pool grows.\n" \
      "0 means the value is chosen by the transport.", \
-     (_offset) + ucs_offsetof(uct_iface_mpool_config_t, bufs_grow), UCS_CONFIG_TYPE_UINT}
+     (_offset) + ucs_offsetof(uct_iface_mpool_config_t, bufs_grow), UCS_CONFIG_TYPE_UINT}, \
+    \
+    {_prefix "THREAD_CACHE", "0", \
+     "Number of " _mp_name " buffers moved at once between per-thread caches of the\n" \
+     "memory pool, which make the pool safe to use from multiple threads.\n" \
+     "0 disables the thread caches.", \
+     (_offset) + ucs_offsetof(uct_iface_mpool_config_t, thread_cache), UCS_CONFIG_TYPE_UINT}
 
 
 /**
@@ -428,6 +436,19 @@ static inline uct_pending_req_priv_t* uct_pending_req_priv(uct_pending_req_t *re
 }
 
 
+/**
+ * @return Arbiter priority of a pending request priority.
+ */
+static inline ucs_arbiter_prio_t uct_pending_arb_prio(uct_pending_prio_t prio)
+{
+    UCS_STATIC_ASSERT((int)UCT_PENDING_PRIO_BULK    == (int)UCS_ARBITER_PRIO_BULK);
+    UCS_STATIC_ASSERT((int)UCT_PENDING_PRIO_LATENCY == (int)UCS_ARBITER_PRIO_LATENCY);
+    UCS_STATIC_ASSERT((int)UCT_PENDING_PRIO_CONTROL == (int)UCS_ARBITER_PRIO_CONTROL);
+    ucs_assert(prio < UCT_PENDING_PRIO_LAST);
+    return (ucs_arbiter_prio_t)prio;
+}
+
+
 extern ucs_config_field_t uct_iface_config_table[];
 
 
@@ -461,6 +482,20 @@ void uct_iface_mpool_empty_warn(uct_base_iface_t *iface, ucs_mpool_t *mp);
 
 void uct_set_ep_failed(ucs_class_t* cls, uct_ep_h tl_ep, uct_iface_h tl_iface);
 
+
+/**
+ * Return the file descriptor which was set on the wakeup handle by the
+ * transport's wakeup_open.
+ */
+ucs_status_t uct_base_iface_wakeup_get_fd(uct_wakeup_h wakeup, int *fd_p);
+
+
+/**
+ * Arm the wakeup handle and block until its file descriptor becomes readable.
+ * Returns immediately if the transport has events to process.
+ */
+ucs_status_t uct_base_iface_wakeup_wait(uct_wakeup_h wakeup);
+
 /**
  * Invoke active message handler.
  *
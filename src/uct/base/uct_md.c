@@ -16,6 +16,9 @@
 #include <ucs/datastruct/callbackq.inl>
 #include <malloc.h>
 
+
+#define UCT_MD_RCACHE_DEFAULT_ALIGN 16
+
 UCS_LIST_HEAD(uct_md_components_list);
 
 ucs_config_field_t uct_md_config_table[] = {
@@ -23,6 +26,35 @@ ucs_config_field_t uct_md_config_table[] = {
   {NULL}
 };
 
+ucs_config_field_t uct_md_config_rcache_table[] = {
+  {"RCACHE", "try", "Enable using memory registration cache",
+   ucs_offsetof(uct_md_rcache_config_t, enable), UCS_CONFIG_TYPE_TERNARY},
+
+  {"RCACHE_ADDR_ALIGN", UCS_PP_MAKE_STRING(UCT_MD_RCACHE_DEFAULT_ALIGN),
+   "Registration cache address alignment, must be power of 2\n"
+   "between "UCS_PP_MAKE_STRING(UCS_PGT_ADDR_ALIGN)"and system page size",
+   ucs_offsetof(uct_md_rcache_config_t, alignment), UCS_CONFIG_TYPE_UINT},
+
+  {"RCACHE_MEM_PRIO", "1000", "Registration cache memory event priority",
+   ucs_offsetof(uct_md_rcache_config_t, event_prio), UCS_CONFIG_TYPE_UINT},
+
+  {"RCACHE_OVERHEAD", "90ns", "Registration cache lookup overhead",
+   ucs_offsetof(uct_md_rcache_config_t, overhead), UCS_CONFIG_TYPE_TIME},
+
+  {"RCACHE_MAX_REGIONS", "inf",
+   "Maximal number of regions in the registration cache. Least recently used\n"
+   "regions which are not in use are evicted when the limit is exceeded.",
+   ucs_offsetof(uct_md_rcache_config_t, max_regions), UCS_CONFIG_TYPE_ULUNITS},
+
+  {"RCACHE_MAX_SIZE", "inf",
+   "Maximal total size of registered memory regions in the registration cache.\n"
+   "Least recently used regions which are not in use are evicted when the limit\n"
+   "is exceeded.",
+   ucs_offsetof(uct_md_rcache_config_t, max_size), UCS_CONFIG_TYPE_MEMUNITS},
+
+  {NULL}
+};
+
 /**
  * Keeps information about allocated configuration structure, to be used when
  * releasing the options.
@@ -211,6 +243,42 @@ ucs_status_t uct_md_stub_rkey_unpack(uct_md_component_t *mdc,
     return UCS_OK;
 }
 
+ucs_status_t uct_md_rcache_create(const uct_md_rcache_config_t *config,
+                                  ucs_rcache_params_t *params, const char *name
+                                  UCS_STATS_ARG(ucs_stats_node_t *stats_parent),
+                                  ucs_rcache_t **rcache_p)
+{
+    ucs_status_t status;
+
+    UCS_STATIC_ASSERT(UCS_PGT_ADDR_ALIGN >= UCT_MD_RCACHE_DEFAULT_ALIGN);
+
+    *rcache_p = NULL;
+    if (config->enable == UCS_NO) {
+        return UCS_OK;
+    }
+
+    params->alignment          = config->alignment;
+    params->ucm_event_priority = config->event_prio;
+    params->max_regions        = config->max_regions;
+    params->max_size           = config->max_size;
+
+    status = ucs_rcache_create(params, name UCS_STATS_ARG(stats_parent),
+                               rcache_p);
+    if (status != UCS_OK) {
+        *rcache_p = NULL;
+        if (config->enable == UCS_YES) {
+            ucs_error("Failed to create registration cache for %s: %s", name,
+                      ucs_status_string(status));
+            return status;
+        }
+
+        ucs_debug("Could not create registration cache for %s: %s", name,
+                  ucs_status_string(status));
+    }
+
+    return UCS_OK;
+}
+
 static UCS_CLASS_INIT_FUNC(uct_worker_t, ucs_async_context_t *async,
                            ucs_thread_mode_t thread_mode)
 {
@@ -226,9 +294,9 @@ static UCS_CLASS_CLEANUP_FUNC(uct_worker_t)
     ucs_callbackq_cleanup(&self->progress_q);
 }
 
-void uct_worker_progress(uct_worker_h worker)
+unsigned uct_worker_progress(uct_worker_h worker)
 {
-    ucs_callbackq_dispatch(&worker->progress_q);
+    return ucs_callbackq_dispatch(&worker->progress_q);
 }
 
 void uct_worker_progress_register(uct_worker_h worker,
@@ -14,6 +14,7 @@
 #include <ucs/debug/memtrack.h>
 #include <ucs/type/component.h>
 #include <ucs/config/parser.h>
+#include <ucs/sys/rcache.h>
 
 
 typedef struct uct_md_component uct_md_component_t;
@@ -48,6 +49,21 @@ struct uct_md_config {
 };
 
 
+/**
+ * Registration cache configuration, for MDs which can cache their memory
+ * registrations. It is embedded in the MD configuration with
+ * uct_md_config_rcache_table.
+ */
+typedef struct uct_md_rcache_config {
+    ucs_ternary_value_t    enable;       /**< Enable registration cache */
+    size_t                 alignment;    /**< Force address alignment */
+    unsigned               event_prio;   /**< Memory events priority */
+    double                 overhead;     /**< Lookup overhead estimation */
+    unsigned long          max_regions;  /**< Maximal number of regions */
+    size_t                 max_size;     /**< Maximal total size of regions */
+} uct_md_rcache_config_t;
+
+
 /**
  * MD->Transport
  */
@@ -173,6 +189,25 @@ ucs_status_t uct_md_stub_rkey_unpack(uct_md_component_t *mdc,
                                      const void *rkey_buffer, uct_rkey_t *rkey_p,
                                      void **handle_p);
 
+/**
+ * Create a registration cache for a memory domain, according to the cache
+ * configuration of the MD.
+ *
+ * @param [in]  config        Registration cache configuration.
+ * @param [in]  params        Cache parameters. The caller sets the operations,
+ *                            context and region structure size, and the rest
+ *                            is set from the configuration.
+ * @param [in]  name          Registration cache name, for debugging.
+ * @param [in]  stats_parent  Parent statistics node of the cache.
+ * @param [out] rcache_p      Filled with the registration cache, or with NULL
+ *                            if the cache is disabled, or could not be created
+ *                            and is not mandatory.
+ */
+ucs_status_t uct_md_rcache_create(const uct_md_rcache_config_t *config,
+                                  ucs_rcache_params_t *params, const char *name
+                                  UCS_STATS_ARG(ucs_stats_node_t *stats_parent),
+                                  ucs_rcache_t **rcache_p);
+
 
 #define uct_worker_tl_data_get(_worker, _key, _type, _cmp_fn, _init_fn, ...) \
     ({ \
@@ -212,5 +247,6 @@ ucs_status_t uct_md_stub_rkey_unpack(uct_md_component_t *mdc,
 
 extern ucs_list_link_t uct_md_components_list;
 extern ucs_config_field_t uct_md_config_table[];
+extern ucs_config_field_t uct_md_config_rcache_table[];
 
 #endif
@@ -331,6 +331,14 @@ ucs_status_t uct_iface_mpool_init(uct_base_iface_t *iface, ucs_mpool_t *mp,
         return status;
     }
 
+    if (config->thread_cache > 0) {
+        status = ucs_mpool_set_thread_safe(mp, config->thread_cache);
+        if (status != UCS_OK) {
+            ucs_mpool_cleanup(mp, 0);
+            return status;
+        }
+    }
+
     uct_iface_mp_priv(mp)->iface       = iface;
     uct_iface_mp_priv(mp)->init_obj_cb = init_obj_cb;
     return UCS_OK;
@@ -23,7 +23,6 @@
                                   IBV_ACCESS_REMOTE_WRITE | \
                                   IBV_ACCESS_REMOTE_READ | \
                                   IBV_ACCESS_REMOTE_ATOMIC)
-#define UCT_IB_MD_RCACHE_DEFAULT_ALIGN 16
 
 #ifndef UCT_MD_DISABLE_NUMA
 #if HAVE_STRUCT_BITMASK
@@ -63,19 +62,8 @@ static ucs_config_field_t uct_ib_md_config_table[] = {
   {"", "", NULL,
    ucs_offsetof(uct_ib_md_config_t, super), UCS_CONFIG_TYPE_TABLE(uct_md_config_table)},
 
-  {"RCACHE", "try", "Enable using memory registration cache",
-   ucs_offsetof(uct_ib_md_config_t, rcache.enable), UCS_CONFIG_TYPE_TERNARY},
-
-  {"RCACHE_ADDR_ALIGN", UCS_PP_MAKE_STRING(UCT_IB_MD_RCACHE_DEFAULT_ALIGN),
-   "Registration cache address alignment, must be power of 2\n"
-   "between "UCS_PP_MAKE_STRING(UCS_PGT_ADDR_ALIGN)"and system page size",
-   ucs_offsetof(uct_ib_md_config_t, rcache.alignment), UCS_CONFIG_TYPE_UINT},
-
-  {"RCACHE_MEM_PRIO", "1000", "Registration cache memory event priority",
-   ucs_offsetof(uct_ib_md_config_t, rcache.event_prio), UCS_CONFIG_TYPE_UINT},
-
-  {"RCACHE_OVERHEAD", "90ns", "Registration cache lookup overhead",
-   ucs_offsetof(uct_ib_md_config_t, rcache.overhead), UCS_CONFIG_TYPE_TIME},
+  {"", "", NULL,
+   ucs_offsetof(uct_ib_md_config_t, rcache), UCS_CONFIG_TYPE_TABLE(uct_md_config_rcache_table)},
 
   {"MEM_REG_OVERHEAD", "16us", "Memory registration overhead", /* TODO take default from device */
    ucs_offsetof(uct_ib_md_config_t, uc_reg_cost.overhead), UCS_CONFIG_TYPE_TIME},
@@ -1168,30 +1156,20 @@ uct_ib_md_open(const char *md_name, const uct_md_config_t *uct_md_config, uct_md
         goto err_dealloc_pd;
     }
 
-    if (md_config->rcache.enable != UCS_NO) {
-        UCS_STATIC_ASSERT(UCS_PGT_ADDR_ALIGN >= UCT_IB_MD_RCACHE_DEFAULT_ALIGN);
-        rcache_params.region_struct_size = sizeof(uct_ib_rcache_region_t);
-        rcache_params.alignment          = md_config->rcache.alignment;
-        rcache_params.ucm_event_priority = md_config->rcache.event_prio;
-        rcache_params.context            = md;
-        rcache_params.ops                = &uct_ib_rcache_ops;
-        status = ucs_rcache_create(&rcache_params, uct_ib_device_name(&md->dev)
-                                   UCS_STATS_ARG(md->stats), &md->rcache);
-        if (status == UCS_OK) {
-            md->super.ops         = &uct_ib_md_rcache_ops;
-            md->reg_cost.overhead = md_config->rcache.overhead;
-            md->reg_cost.growth   = 0; /* It's close enough to 0 */
-        } else {
-            ucs_assert(md->rcache == NULL);
-            if (md_config->rcache.enable == UCS_YES) {
-                ucs_error("Failed to create registration cache: %s",
-                          ucs_status_string(status));
-                goto err_destroy_umr_qp;
-            } else {
-                ucs_debug("Could not create registration cache for: %s",
-                          ucs_status_string(status));
-            }
-        }
+    rcache_params.region_struct_size = sizeof(uct_ib_rcache_region_t);
+    rcache_params.context            = md;
+    rcache_params.ops                = &uct_ib_rcache_ops;
+    status = uct_md_rcache_create(&md_config->rcache, &rcache_params,
+                                  uct_ib_device_name(&md->dev)
+                                  UCS_STATS_ARG(md->stats), &md->rcache);
+    if (status != UCS_OK) {
+        goto err_destroy_umr_qp;
+    }
+
+    if (md->rcache != NULL) {
+        md->super.ops         = &uct_ib_md_rcache_ops;
+        md->reg_cost.overhead = md_config->rcache.overhead;
+        md->reg_cost.growth   = 0; /* It's close enough to 0 */
     }
 
     status = uct_ib_md_parse_device_config(md, md_config);
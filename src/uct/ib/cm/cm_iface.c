@@ -38,11 +38,12 @@ static ucs_config_field_t uct_cm_iface_config_table[] = {
 static uct_ib_iface_ops_t uct_cm_iface_ops;
 
 
-static void uct_cm_iface_progress(void *arg)
+static unsigned uct_cm_iface_progress(void *arg)
 {
     uct_cm_pending_req_priv_t *priv;
     uct_cm_iface_t *iface = arg;
     uct_cm_iface_op_t *op;
+    unsigned count = 0;
 
     uct_cm_enter(iface);
 
@@ -52,6 +53,7 @@ static void uct_cm_iface_progress(void *arg)
     ucs_queue_for_each_extract(op, &iface->outstanding_q, queue, !op->is_id) {
         uct_invoke_completion(op->comp, UCS_OK);
         ucs_free(op);
+        ++count;
     }
 
     /* Dispatch pending operations */
@@ -62,6 +64,7 @@ static void uct_cm_iface_progress(void *arg)
 
     ucs_callbackq_remove(&uct_cm_iface_worker(iface)->progress_q,
                          uct_cm_iface_progress, iface);
+    return count;
 }
 
 ucs_status_t uct_cm_iface_flush_do(uct_iface_h tl_iface, uct_completion_t *comp)
@@ -497,7 +497,7 @@ ucs_status_t uct_dc_mlx5_ep_flush(uct_ep_h tl_ep, unsigned flags, uct_completion
     return status;
 }
 
-static UCS_F_ALWAYS_INLINE void
+static UCS_F_ALWAYS_INLINE unsigned
 uct_dc_mlx5_poll_tx(uct_dc_mlx5_iface_t *iface)
 {
     uint8_t dci;
@@ -509,7 +509,7 @@ uct_dc_mlx5_poll_tx(uct_dc_mlx5_iface_t *iface)
     cqe = uct_ib_mlx5_get_cqe(&iface->super.super.super, &iface->mlx5_common.tx.cq,
                               iface->mlx5_common.tx.cq.cqe_size_log);
     if (cqe == NULL) {
-        return;
+        return 0;
     }
     UCS_STATS_UPDATE_COUNTER(iface->super.super.stats, UCT_RC_IFACE_STAT_TX_COMPLETION, 1);
 
@@ -533,18 +533,20 @@ uct_dc_mlx5_poll_tx(uct_dc_mlx5_iface_t *iface)
     }
     ucs_arbiter_dispatch(uct_dc_iface_tx_waitq(&iface->super), 1, 
                          uct_dc_iface_dci_do_pending_tx, NULL);
+    return 1;
 }
 
 /* TODO: make a macro that defines progress func */
-static void uct_dc_mlx5_iface_progress(void *arg)
+static unsigned uct_dc_mlx5_iface_progress(void *arg)
 {
     uct_dc_mlx5_iface_t *iface = arg;
-    ucs_status_t status;
+    unsigned count;
 
-    status = uct_rc_mlx5_iface_common_poll_rx(&iface->mlx5_common, &iface->super.super);
-    if (status == UCS_ERR_NO_PROGRESS) {
-        uct_dc_mlx5_poll_tx(iface);
+    count = uct_rc_mlx5_iface_common_poll_rx(&iface->mlx5_common, &iface->super.super);
+    if (count > 0) {
+        return count;
     }
+    return uct_dc_mlx5_poll_tx(iface);
 }
 
 static UCS_F_NOINLINE void uct_dc_mlx5_iface_handle_failure(uct_ib_iface_t *ib_iface,
@@ -658,6 +660,7 @@ static uct_rc_iface_ops_t uct_dc_mlx5_iface_ops = {
             .ep_flush                 = uct_dc_mlx5_ep_flush,
 
             .ep_pending_add           = uct_dc_ep_pending_add,
+            .ep_pending_add_prio      = uct_dc_ep_pending_add_prio,
             .ep_pending_purge         = uct_dc_ep_pending_purge,
         },
         .arm_tx_cq                = uct_ib_iface_arm_tx_cq,
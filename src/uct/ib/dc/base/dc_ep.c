@@ -51,7 +51,8 @@ static UCS_CLASS_CLEANUP_FUNC(uct_dc_ep_t)
    currently pending code supports only dcs policy
    support hash/random policies
  */
-ucs_status_t uct_dc_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *r)
+ucs_status_t uct_dc_ep_pending_add_prio(uct_ep_h tl_ep, uct_pending_req_t *r,
+                                        uct_pending_prio_t prio)
 {
     uct_dc_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_dc_iface_t);
     uct_dc_ep_t *ep = ucs_derived_of(tl_ep, uct_dc_ep_t);
@@ -82,16 +83,24 @@ ucs_status_t uct_dc_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *r)
      *  dci allocation.
      */
     if (ep->dci == UCT_DC_EP_NO_DCI) {
-        ucs_arbiter_group_push_elem(&ep->arb_group, (ucs_arbiter_elem_t*)r->priv);
+        ucs_arbiter_group_push_elem_prio(&ep->arb_group,
+                                         (ucs_arbiter_elem_t*)r->priv,
+                                         uct_pending_arb_prio(prio));
         uct_dc_iface_schedule_dci_alloc(iface, ep);
         return UCS_OK;
     }
 
-    ucs_arbiter_group_push_elem(&ep->arb_group, (ucs_arbiter_elem_t*)r->priv);
+    ucs_arbiter_group_push_elem_prio(&ep->arb_group, (ucs_arbiter_elem_t*)r->priv,
+                                     uct_pending_arb_prio(prio));
     uct_dc_iface_dci_sched_tx(iface, ep);
     return UCS_OK;
 }
 
+ucs_status_t uct_dc_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *r)
+{
+    return uct_dc_ep_pending_add_prio(tl_ep, r, UCT_PENDING_PRIO_BULK);
+}
+
 /**
  * dispatch requests waiting for dci allocation
  */
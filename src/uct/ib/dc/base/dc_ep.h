@@ -42,6 +42,9 @@ uct_dc_iface_dci_do_pending_tx(ucs_arbiter_t *arbiter,
                                void *arg);
 
 ucs_status_t uct_dc_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *r);
+
+ucs_status_t uct_dc_ep_pending_add_prio(uct_ep_h tl_ep, uct_pending_req_t *r,
+                                        uct_pending_prio_t prio);
 void uct_dc_ep_pending_purge(uct_ep_h tl_ep, uct_pending_purge_callback_t cb, void *arg);
 
 static inline void uct_dc_iface_dci_sched_tx(uct_dc_iface_t *iface, uct_dc_ep_t *ep)
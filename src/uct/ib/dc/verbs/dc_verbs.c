@@ -668,7 +668,7 @@ ucs_status_t uct_dc_verbs_ep_fc_ctrl(uct_ep_h tl_ep, unsigned op,
     return UCS_OK;
 }
 
-static UCS_F_ALWAYS_INLINE void
+static UCS_F_ALWAYS_INLINE unsigned
 uct_dc_verbs_poll_tx(uct_dc_verbs_iface_t *iface)
 {
     int i;
@@ -700,18 +700,20 @@ uct_dc_verbs_poll_tx(uct_dc_verbs_iface_t *iface)
     }
     ucs_arbiter_dispatch(uct_dc_iface_tx_waitq(&iface->super), 1, 
                          uct_dc_iface_dci_do_pending_tx, NULL);
+    return num_wcs;
 }
 
 /* TODO: make a macro that defines progress func */
-static void uct_dc_verbs_iface_progress(void *arg)
+static unsigned uct_dc_verbs_iface_progress(void *arg)
 {
     uct_dc_verbs_iface_t *iface = arg;
-    ucs_status_t status;
+    unsigned count;
 
-    status = uct_rc_verbs_iface_poll_rx_common(&iface->super.super);
-    if (status == UCS_ERR_NO_PROGRESS) {
-        uct_dc_verbs_poll_tx(iface);
+    count = uct_rc_verbs_iface_poll_rx_common(&iface->super.super);
+    if (count > 0) {
+        return count;
     }
+    return uct_dc_verbs_poll_tx(iface);
 }
 
 static void UCS_CLASS_DELETE_FUNC_NAME(uct_dc_verbs_iface_t)(uct_iface_t*);
@@ -755,6 +757,7 @@ static uct_rc_iface_ops_t uct_dc_verbs_iface_ops = {
             .ep_flush                 = uct_dc_verbs_ep_flush,
 
             .ep_pending_add           = uct_dc_ep_pending_add,
+            .ep_pending_add_prio      = uct_dc_ep_pending_add_prio,
             .ep_pending_purge         = uct_dc_ep_pending_purge
         },
         .arm_tx_cq                = uct_ib_iface_arm_tx_cq,
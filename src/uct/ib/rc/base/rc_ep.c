@@ -317,7 +317,8 @@ void uct_rc_ep_send_completion_proxy_handler(uct_rc_iface_send_op_t *op,
     UCS_INSTRUMENT_RECORD(UCS_INSTRUMENT_TYPE_IB_TX, __FUNCTION__, op);
 }
 
-ucs_status_t uct_rc_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n)
+ucs_status_t uct_rc_ep_pending_add_prio(uct_ep_h tl_ep, uct_pending_req_t *n,
+                                        uct_pending_prio_t prio)
 {
     uct_rc_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_rc_iface_t);
     uct_rc_ep_t *ep = ucs_derived_of(tl_ep, uct_rc_ep_t);
@@ -329,7 +330,8 @@ ucs_status_t uct_rc_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n)
 
     UCS_STATIC_ASSERT(sizeof(ucs_arbiter_elem_t) <= UCT_PENDING_REQ_PRIV_LEN);
     ucs_arbiter_elem_init((ucs_arbiter_elem_t *)n->priv);
-    ucs_arbiter_group_push_elem(&ep->arb_group, (ucs_arbiter_elem_t*)n->priv);
+    ucs_arbiter_group_push_elem_prio(&ep->arb_group, (ucs_arbiter_elem_t*)n->priv,
+                                     uct_pending_arb_prio(prio));
 
     if (uct_rc_ep_has_tx_resources(ep)) {
         /* If we have ep (but not iface) resources, we need to schedule the ep */
@@ -339,6 +341,11 @@ ucs_status_t uct_rc_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n)
     return UCS_OK;
 }
 
+ucs_status_t uct_rc_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n)
+{
+    return uct_rc_ep_pending_add_prio(tl_ep, n, UCT_PENDING_PRIO_BULK);
+}
+
 ucs_arbiter_cb_result_t uct_rc_ep_process_pending(ucs_arbiter_t *arbiter,
                                                   ucs_arbiter_elem_t *elem,
                                                   void *arg)
@@ -201,6 +201,9 @@ void uct_rc_ep_send_completion_proxy_handler(uct_rc_iface_send_op_t *op,
 
 ucs_status_t uct_rc_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n);
 
+ucs_status_t uct_rc_ep_pending_add_prio(uct_ep_h tl_ep, uct_pending_req_t *n,
+                                        uct_pending_prio_t prio);
+
 void uct_rc_ep_pending_purge(uct_ep_h ep, uct_pending_purge_callback_t cb,
                              void*arg);
 
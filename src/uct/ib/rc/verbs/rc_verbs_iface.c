@@ -76,7 +76,7 @@ static UCS_F_NOINLINE void uct_rc_verbs_handle_failure(uct_ib_iface_t *ib_iface,
     }
 }
 
-static UCS_F_ALWAYS_INLINE void
+static UCS_F_ALWAYS_INLINE unsigned
 uct_rc_verbs_iface_poll_tx(uct_rc_verbs_iface_t *iface)
 {
     uct_rc_verbs_ep_t *ep;
@@ -102,17 +102,19 @@ uct_rc_verbs_iface_poll_tx(uct_rc_verbs_iface_t *iface)
     }
     iface->super.tx.cq_available += num_wcs;
     ucs_arbiter_dispatch(&iface->super.tx.arbiter, 1, uct_rc_ep_process_pending, NULL);
+    return num_wcs;
 }
 
-void uct_rc_verbs_iface_progress(void *arg)
+unsigned uct_rc_verbs_iface_progress(void *arg)
 {
     uct_rc_verbs_iface_t *iface = arg;
-    ucs_status_t status;
+    unsigned count;
 
-    status = uct_rc_verbs_iface_poll_rx_common(&iface->super);
-    if (status == UCS_ERR_NO_PROGRESS) {
-        uct_rc_verbs_iface_poll_tx(iface);
+    count = uct_rc_verbs_iface_poll_rx_common(&iface->super);
+    if (count > 0) {
+        return count;
     }
+    return uct_rc_verbs_iface_poll_tx(iface);
 }
 
 static ucs_status_t uct_rc_verbs_iface_query(uct_iface_h tl_iface, uct_iface_attr_t *iface_attr)
@@ -238,6 +240,7 @@ static uct_rc_iface_ops_t uct_rc_verbs_iface_ops = {
     .ep_atomic_swap32         = uct_rc_verbs_ep_atomic_swap32,
     .ep_atomic_cswap32        = uct_rc_verbs_ep_atomic_cswap32,
     .ep_pending_add           = uct_rc_ep_pending_add,
+    .ep_pending_add_prio      = uct_rc_ep_pending_add_prio,
     .ep_pending_purge         = uct_rc_ep_pending_purge,
     .ep_flush                 = uct_rc_verbs_ep_flush
     },
@@ -433,25 +433,27 @@ uct_ud_mlx5_iface_poll_tx(uct_ud_mlx5_iface_t *iface)
     iface->super.tx.available = uct_ib_mlx5_txwq_update_bb(&iface->tx.wq, ntohs(cqe->wqe_counter));
 }
 
-static void uct_ud_mlx5_iface_progress(void *arg)
+static unsigned uct_ud_mlx5_iface_progress(void *arg)
 {
     uct_ud_mlx5_iface_t *iface = arg;
     ucs_status_t status;
-    int count;
+    unsigned count = 0;
 
     uct_ud_enter(&iface->super);
     uct_ud_iface_dispatch_zcopy_comps(&iface->super);
     status = uct_ud_iface_dispatch_pending_rx(&iface->super);
     if (ucs_likely(status == UCS_OK)) {
-        count = 0;
         do {
             status = uct_ud_mlx5_iface_poll_rx(iface, 0);
-            count++;
+            if (status == UCS_OK) {
+                ++count;
+            }
         } while ((status == UCS_OK) && (count < iface->super.super.config.rx_max_poll));
     }
     uct_ud_mlx5_iface_poll_tx(iface);
     uct_ud_iface_progress_pending(&iface->super, 0);
     uct_ud_leave(&iface->super);
+    return count;
 }
 
 static void uct_ud_mlx5_iface_async_progress(uct_ud_iface_t *ud_iface)
@@ -629,6 +631,7 @@ static uct_ud_iface_ops_t uct_ud_mlx5_iface_ops = {
     .ep_am_zcopy              = uct_ud_mlx5_ep_am_zcopy,
 
     .ep_pending_add           = uct_ud_ep_pending_add,
+    .ep_pending_add_prio      = uct_ud_ep_pending_add_prio,
     .ep_pending_purge         = uct_ud_ep_pending_purge,
 
     .ep_flush                 = uct_ud_ep_flush
@@ -1020,7 +1020,8 @@ uct_ud_ep_do_pending(ucs_arbiter_t *arbiter, ucs_arbiter_elem_t *elem,
     return uct_ud_ep_ctl_op_next(ep);
 }
 
-ucs_status_t uct_ud_ep_pending_add(uct_ep_h ep_h, uct_pending_req_t *req)
+ucs_status_t uct_ud_ep_pending_add_prio(uct_ep_h ep_h, uct_pending_req_t *req,
+                                        uct_pending_prio_t prio)
 {
     uct_ud_ep_t *ep = ucs_derived_of(ep_h, uct_ud_ep_t);
     uct_ud_iface_t *iface = ucs_derived_of(ep->super.super.iface,
@@ -1041,8 +1042,9 @@ ucs_status_t uct_ud_ep_pending_add(uct_ep_h ep_h, uct_pending_req_t *req)
     }
 
     ucs_arbiter_elem_init((ucs_arbiter_elem_t *)req->priv);
-    ucs_arbiter_group_push_elem(&ep->tx.pending.group,
-                                (ucs_arbiter_elem_t *)req->priv);
+    ucs_arbiter_group_push_elem_prio(&ep->tx.pending.group,
+                                     (ucs_arbiter_elem_t *)req->priv,
+                                     uct_pending_arb_prio(prio));
     ucs_arbiter_group_schedule(&iface->tx.pending_q, &ep->tx.pending.group);
 
     iface->tx.pending_q_len++;
@@ -1050,6 +1052,11 @@ ucs_status_t uct_ud_ep_pending_add(uct_ep_h ep_h, uct_pending_req_t *req)
     return UCS_OK;
 }
 
+ucs_status_t uct_ud_ep_pending_add(uct_ep_h ep_h, uct_pending_req_t *req)
+{
+    return uct_ud_ep_pending_add_prio(ep_h, req, UCT_PENDING_PRIO_BULK);
+}
+
 static ucs_arbiter_cb_result_t
 uct_ud_ep_pending_purge_cb(ucs_arbiter_t *arbiter, ucs_arbiter_elem_t *elem,
                         void *arg)
@@ -261,6 +261,9 @@ ucs_status_t uct_ud_ep_connect_to_ep(uct_ud_ep_t *ep,
 
 ucs_status_t uct_ud_ep_pending_add(uct_ep_h ep, uct_pending_req_t *n);
 
+ucs_status_t uct_ud_ep_pending_add_prio(uct_ep_h ep, uct_pending_req_t *n,
+                                        uct_pending_prio_t prio);
+
 void   uct_ud_ep_pending_purge(uct_ep_h ep, uct_pending_purge_callback_t cb,
                                void *arg);
 
@@ -4,6 +4,7 @@
 */
 
 #include "sm_ep.h"
+#include "sm_iface.h"
 
 #include <ucs/arch/atomic.h>
 
@@ -54,6 +55,48 @@ ucs_status_t uct_sm_ep_get_bcopy(uct_ep_h tl_ep, uct_unpack_callback_t unpack_cb
     return UCS_OK;
 }
 
+ucs_status_t uct_sm_ep_put_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov,
+                                 size_t iovcnt, uint64_t remote_addr,
+                                 uct_rkey_t rkey, uct_completion_t *comp)
+{
+    void *dst = (void *)(rkey + remote_addr);
+    size_t iov_it, length;
+
+    UCT_CHECK_IOV_SIZE(iovcnt, (size_t)UCT_SM_MAX_IOV, "uct_sm_ep_put_zcopy");
+
+    for (iov_it = 0; iov_it < iovcnt; ++iov_it) {
+        length = uct_iov_get_length(&iov[iov_it]);
+        memcpy(dst, iov[iov_it].buffer, length);
+        dst   += length;
+    }
+
+    length = uct_iov_total_length(iov, iovcnt);
+    uct_sm_ep_trace_data(remote_addr, rkey, "PUT_ZCOPY [length %zu]", length);
+    UCT_TL_EP_STAT_OP(ucs_derived_of(tl_ep, uct_base_ep_t), PUT, ZCOPY, length);
+    return UCS_OK;
+}
+
+ucs_status_t uct_sm_ep_get_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov,
+                                 size_t iovcnt, uint64_t remote_addr,
+                                 uct_rkey_t rkey, uct_completion_t *comp)
+{
+    void *src = (void *)(rkey + remote_addr);
+    size_t iov_it, length;
+
+    UCT_CHECK_IOV_SIZE(iovcnt, (size_t)UCT_SM_MAX_IOV, "uct_sm_ep_get_zcopy");
+
+    for (iov_it = 0; iov_it < iovcnt; ++iov_it) {
+        length = uct_iov_get_length(&iov[iov_it]);
+        memcpy(iov[iov_it].buffer, src, length);
+        src   += length;
+    }
+
+    length = uct_iov_total_length(iov, iovcnt);
+    uct_sm_ep_trace_data(remote_addr, rkey, "GET_ZCOPY [length %zu]", length);
+    UCT_TL_EP_STAT_OP(ucs_derived_of(tl_ep, uct_base_ep_t), GET, ZCOPY, length);
+    return UCS_OK;
+}
+
 ucs_status_t uct_sm_ep_atomic_add64(uct_ep_h tl_ep, uint64_t add,
                                     uint64_t remote_addr, uct_rkey_t rkey)
 {
@@ -8,15 +8,26 @@
 #include "knem_md.h"
 #include "knem_io.h"
 
+static ucs_config_field_t uct_knem_md_config_table[] = {
+  {"", "", NULL,
+   ucs_offsetof(uct_knem_md_config_t, super), UCS_CONFIG_TYPE_TABLE(uct_md_config_table)},
+
+  {"", "", NULL,
+   ucs_offsetof(uct_knem_md_config_t, rcache), UCS_CONFIG_TYPE_TABLE(uct_md_config_rcache_table)},
+
+  {NULL}
+};
+
 ucs_status_t uct_knem_md_query(uct_md_h md, uct_md_attr_t *md_attr)
 {
+    uct_knem_md_t *knem_md = ucs_derived_of(md, uct_knem_md_t);
+
     md_attr->rkey_packed_size  = sizeof(uct_knem_key_t);
     md_attr->cap.flags         = UCT_MD_FLAG_REG |
                                  UCT_MD_FLAG_NEED_RKEY;
     md_attr->cap.max_alloc     = 0;
     md_attr->cap.max_reg       = ULONG_MAX;
-    md_attr->reg_cost.overhead = 1200.0e-9;
-    md_attr->reg_cost.growth   = 0.007e-9;
+    md_attr->reg_cost          = knem_md->reg_cost;
 
     memset(&md_attr->local_cpus, 0xff, sizeof(md_attr->local_cpus));
     return UCS_OK;
@@ -67,28 +78,25 @@ static ucs_status_t uct_knem_query_md_resources(uct_md_resource_desc_t **resourc
 static void uct_knem_md_close(uct_md_h md)
 {
     uct_knem_md_t *knem_md = (uct_knem_md_t *)md;
+    if (knem_md->rcache != NULL) {
+        ucs_rcache_destroy(knem_md->rcache);
+    }
     close(knem_md->knem_fd);
     ucs_free(knem_md);
 }
 
-static ucs_status_t uct_knem_mem_reg(uct_md_h md, void *address, size_t length,
-                                     unsigned flags, uct_mem_h *memh_p)
+static ucs_status_t uct_knem_mem_reg_internal(uct_md_h md, void *address,
+                                              size_t length, unsigned flags,
+                                              uct_knem_key_t *key)
 {
     int rc;
     struct knem_cmd_create_region create;
     struct knem_cmd_param_iovec knem_iov[1];
     uct_knem_md_t *knem_md = (uct_knem_md_t *)md;
     int knem_fd = knem_md->knem_fd;
-    uct_knem_key_t *key;
 
     ucs_assert_always(knem_fd > -1);
 
-    key = ucs_malloc(sizeof(uct_knem_key_t), "uct_knem_key_t");
-    if (NULL == key) {
-        ucs_error("Failed to allocate memory for uct_knem_key_t");
-        return UCS_ERR_NO_MEMORY;
-    }
-
     knem_iov[0].base = (uintptr_t) address;
     knem_iov[0].len = length;
 
@@ -101,22 +109,18 @@ static ucs_status_t uct_knem_mem_reg(uct_md_h md, void *address, size_t length,
     rc = ioctl(knem_fd, KNEM_CMD_CREATE_REGION, &create);
     if (rc < 0) {
         ucs_error("KNEM create region failed: %m");
-        ucs_free(key);
         return UCS_ERR_IO_ERROR;
     }
 
     ucs_assert_always(create.cookie != 0);
     key->cookie  = create.cookie;
     key->address = (uintptr_t)address;
-
-    *memh_p = key;
     return UCS_OK;
 }
 
-static ucs_status_t uct_knem_mem_dereg(uct_md_h md, uct_mem_h memh)
+static void uct_knem_mem_dereg_internal(uct_md_h md, uct_knem_key_t *key)
 {
     int rc;
-    uct_knem_key_t *key = (uct_knem_key_t *)memh;
     uct_knem_md_t *knem_md = (uct_knem_md_t *)md;
     int knem_fd = knem_md->knem_fd;
 
@@ -128,11 +132,111 @@ static ucs_status_t uct_knem_mem_dereg(uct_md_h md, uct_mem_h memh)
     if (rc < 0) {
         ucs_error("KNEM destroy region failed, err = %m");
     }
+}
+
+static ucs_status_t uct_knem_mem_reg(uct_md_h md, void *address, size_t length,
+                                     unsigned flags, uct_mem_h *memh_p)
+{
+    uct_knem_key_t *key;
+    ucs_status_t status;
+
+    key = ucs_malloc(sizeof(uct_knem_key_t), "uct_knem_key_t");
+    if (NULL == key) {
+        ucs_error("Failed to allocate memory for uct_knem_key_t");
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    status = uct_knem_mem_reg_internal(md, address, length, flags, key);
+    if (status != UCS_OK) {
+        ucs_free(key);
+        return status;
+    }
+
+    *memh_p = key;
+    return UCS_OK;
+}
 
+static ucs_status_t uct_knem_mem_dereg(uct_md_h md, uct_mem_h memh)
+{
+    uct_knem_key_t *key = (uct_knem_key_t *)memh;
+
+    uct_knem_mem_dereg_internal(md, key);
     ucs_free(key);
     return UCS_OK;
 }
 
+static ucs_status_t uct_knem_mem_rcache_reg(uct_md_h md, void *address,
+                                            size_t length, unsigned flags,
+                                            uct_mem_h *memh_p)
+{
+    uct_knem_md_t *knem_md = ucs_derived_of(md, uct_knem_md_t);
+    ucs_rcache_region_t *rregion;
+    ucs_status_t status;
+
+    status = ucs_rcache_get(knem_md->rcache, address, length,
+                            PROT_READ|PROT_WRITE, &flags, &rregion);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    ucs_assert(rregion->refcount > 0);
+    *memh_p = &ucs_derived_of(rregion, uct_knem_rcache_region_t)->key;
+    return UCS_OK;
+}
+
+static ucs_status_t uct_knem_mem_rcache_dereg(uct_md_h md, uct_mem_h memh)
+{
+    uct_knem_md_t *knem_md = ucs_derived_of(md, uct_knem_md_t);
+    uct_knem_rcache_region_t *region = ucs_container_of(memh,
+                                                        uct_knem_rcache_region_t,
+                                                        key);
+
+    ucs_rcache_region_put(knem_md->rcache, &region->super);
+    return UCS_OK;
+}
+
+static ucs_status_t uct_knem_rcache_mem_reg_cb(void *context, ucs_rcache_t *rcache,
+                                               void *arg, ucs_rcache_region_t *rregion)
+{
+    uct_knem_rcache_region_t *region = ucs_derived_of(rregion,
+                                                      uct_knem_rcache_region_t);
+    uct_knem_md_t *knem_md = context;
+    unsigned *flags = arg;
+
+    return uct_knem_mem_reg_internal(&knem_md->super,
+                                     (void*)region->super.super.start,
+                                     region->super.super.end -
+                                     region->super.super.start,
+                                     *flags, &region->key);
+}
+
+static void uct_knem_rcache_mem_dereg_cb(void *context, ucs_rcache_t *rcache,
+                                         ucs_rcache_region_t *rregion)
+{
+    uct_knem_rcache_region_t *region = ucs_derived_of(rregion,
+                                                      uct_knem_rcache_region_t);
+    uct_knem_md_t *knem_md = context;
+
+    uct_knem_mem_dereg_internal(&knem_md->super, &region->key);
+}
+
+static void uct_knem_rcache_dump_region_cb(void *context, ucs_rcache_t *rcache,
+                                           ucs_rcache_region_t *rregion, char *buf,
+                                           size_t max)
+{
+    uct_knem_rcache_region_t *region = ucs_derived_of(rregion,
+                                                      uct_knem_rcache_region_t);
+
+    snprintf(buf, max, "cookie 0x%"PRIx64" address %"PRIxPTR,
+             region->key.cookie, region->key.address);
+}
+
+static ucs_rcache_ops_t uct_knem_rcache_ops = {
+    .mem_reg     = uct_knem_rcache_mem_reg_cb,
+    .mem_dereg   = uct_knem_rcache_mem_dereg_cb,
+    .dump_region = uct_knem_rcache_dump_region_cb
+};
+
 static ucs_status_t uct_knem_rkey_pack(uct_md_h md, uct_mem_h memh,
                                        void *rkey_buffer)
 {
@@ -174,10 +278,14 @@ static ucs_status_t uct_knem_rkey_release(uct_md_component_t *mdc, uct_rkey_t rk
     return UCS_OK;
 }
 
-static ucs_status_t uct_knem_md_open(const char *md_name, const uct_md_config_t *md_config,
+static ucs_status_t uct_knem_md_open(const char *md_name, const uct_md_config_t *uct_md_config,
                                      uct_md_h *md_p)
 {
+    const uct_knem_md_config_t *md_config = ucs_derived_of(uct_md_config,
+                                                           uct_knem_md_config_t);
+    ucs_rcache_params_t rcache_params;
     uct_knem_md_t *knem_md;
+    ucs_status_t status;
 
     static uct_md_ops_t md_ops = {
         .close        = uct_knem_md_close,
@@ -189,22 +297,53 @@ static ucs_status_t uct_knem_md_open(const char *md_name, const uct_md_config_t
         .mem_dereg    = uct_knem_mem_dereg
     };
 
+    static uct_md_ops_t md_rcache_ops = {
+        .close        = uct_knem_md_close,
+        .query        = uct_knem_md_query,
+        .mem_alloc    = (void*)ucs_empty_function_return_success,
+        .mem_free     = (void*)ucs_empty_function_return_success,
+        .mkey_pack    = uct_knem_rkey_pack,
+        .mem_reg      = uct_knem_mem_rcache_reg,
+        .mem_dereg    = uct_knem_mem_rcache_dereg
+    };
+
     knem_md = ucs_malloc(sizeof(uct_knem_md_t), "uct_knem_md_t");
     if (NULL == knem_md) {
         ucs_error("Failed to allocate memory for uct_knem_md_t");
         return UCS_ERR_NO_MEMORY;
     }
 
-    knem_md->super.ops = &md_ops;
-    knem_md->super.component = &uct_knem_md_component;
+    knem_md->super.ops         = &md_ops;
+    knem_md->super.component   = &uct_knem_md_component;
+    knem_md->reg_cost.overhead = 1200.0e-9;
+    knem_md->reg_cost.growth   = 0.007e-9;
 
     knem_md->knem_fd = open("/dev/knem", O_RDWR);
     if (knem_md->knem_fd < 0) {
         ucs_error("Could not open the KNEM device file at /dev/knem: %m.");
-        free(knem_md);
+        ucs_free(knem_md);
         return UCS_ERR_IO_ERROR;
     }
 
+    /* Every knem registration is an ioctl which pins the pages, so cache the
+     * regions which are registered again and again by the rendezvous protocol */
+    rcache_params.region_struct_size = sizeof(uct_knem_rcache_region_t);
+    rcache_params.context            = knem_md;
+    rcache_params.ops                = &uct_knem_rcache_ops;
+    status = uct_md_rcache_create(&md_config->rcache, &rcache_params, "knem"
+                                  UCS_STATS_ARG(NULL), &knem_md->rcache);
+    if (status != UCS_OK) {
+        close(knem_md->knem_fd);
+        ucs_free(knem_md);
+        return status;
+    }
+
+    if (knem_md->rcache != NULL) {
+        knem_md->super.ops         = &md_rcache_ops;
+        knem_md->reg_cost.overhead = md_config->rcache.overhead;
+        knem_md->reg_cost.growth   = 0; /* It's close enough to 0 */
+    }
+
     *md_p = (uct_md_h)knem_md;
     return UCS_OK;
 }
@@ -212,5 +351,5 @@ static ucs_status_t uct_knem_md_open(const char *md_name, const uct_md_config_t
 UCT_MD_COMPONENT_DEFINE(uct_knem_md_component, "knem",
                         uct_knem_query_md_resources, uct_knem_md_open, 0,
                         uct_knem_rkey_unpack,
-                        uct_knem_rkey_release, "KNEM_", uct_md_config_table,
-                        uct_md_config_t)
+                        uct_knem_rkey_release, "KNEM_", uct_knem_md_config_table,
+                        uct_knem_md_config_t)
@@ -22,8 +22,18 @@ ucs_status_t uct_knem_md_query(uct_md_h md, uct_md_attr_t *md_attr);
 typedef struct uct_knem_md {
     struct uct_md super; /**< Domain info */
     int knem_fd;         /**< File descriptor for /dev/knem */
+    ucs_rcache_t *rcache;             /**< Registration cache (can be NULL) */
+    uct_linear_growth_t reg_cost;     /**< Memory registration cost */
 } uct_knem_md_t;
 
+/**
+ * @brief KNEM MD configuration
+ */
+typedef struct uct_knem_md_config {
+    uct_md_config_t super;            /**< Base MD configuration */
+    uct_md_rcache_config_t rcache;    /**< Registration cache configuration */
+} uct_knem_md_config_t;
+
 /**
  * @brief KNEM packed and remote key
  */
@@ -32,4 +42,12 @@ typedef struct uct_knem_key {
     uintptr_t address; /**< base addr for the registration */
 } uct_knem_key_t;
 
+/**
+ * @brief KNEM memory region in the registration cache
+ */
+typedef struct uct_knem_rcache_region {
+    ucs_rcache_region_t super;
+    uct_knem_key_t      key;      /**< exposed to the user as the memh */
+} uct_knem_rcache_region_t;
+
 #endif
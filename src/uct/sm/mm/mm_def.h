@@ -24,11 +24,13 @@ typedef struct uct_mm_remote_seg        uct_mm_remote_seg_t;
 enum {
     UCT_MM_FIFO_ELEM_FLAG_OWNER  = UCS_BIT(0), /* new/old info */
     UCT_MM_FIFO_ELEM_FLAG_INLINE = UCS_BIT(1), /* if inline or not */
+    UCT_MM_FIFO_ELEM_FLAG_SKIP   = UCS_BIT(2), /* reserved but not used by the sender */
 };
 
 enum {
     UCT_MM_AM_BCOPY,
     UCT_MM_AM_SHORT,
+    UCT_MM_AM_ZCOPY,
 };
 
 #define UCT_MM_IFACE_GET_FIFO_ELEM(_iface, _fifo , _index) \
@@ -49,8 +51,10 @@ enum {
           ucs_likely(((_head) - (_tail)) < (_fifo_size))
 
 typedef struct uct_mm_md_config {
-    uct_md_config_t      super;
-    ucs_ternary_value_t  hugetlb_mode;     /* Enable using huge pages */
+    uct_md_config_t         super;
+    ucs_ternary_value_t     hugetlb_mode;  /* Enable using huge pages */
+    uct_md_rcache_config_t  rcache;        /* Registration cache, used only by
+                                              mappers which can register memory */
 } uct_mm_md_config_t;
 
 
@@ -7,6 +7,7 @@
 
 #include "mm_ep.h"
 
+#include <uct/sm/base/sm_iface.h>
 #include <ucs/arch/atomic.h>
 
 SGLIB_DEFINE_LIST_FUNCTIONS(uct_mm_remote_seg_t, uct_mm_remote_seg_compare, next)
@@ -134,7 +135,9 @@ static UCS_CLASS_INIT_FUNC(uct_mm_ep_t, uct_iface_t *tl_iface,
      * message is sent successfully on the unix socket */
     self->fifo_ctl = &iface->dummy_fifo_ctl;
 
-    self->cached_tail = self->fifo_ctl->tail;
+    self->cached_tail   = self->fifo_ctl->tail;
+    self->reserved_head = 0;
+    self->reserved_end  = 0;
 
     /* set the ep->fifo ptr to point to the beginning of the fifo elements at
      * the remote peer */
@@ -187,6 +190,10 @@ static UCS_CLASS_CLEANUP_FUNC(uct_mm_ep_t)
     uct_worker_progress_unregister(iface->super.worker, uct_mm_iface_progress,
                                    iface);
 
+    if (self->reserved_head != self->reserved_end) {
+        uct_mm_ep_release_reserved(self);
+    }
+
     for (remote_seg = sglib_hashed_uct_mm_remote_seg_t_it_init(&iter, self->remote_segments_hash);
          remote_seg != NULL; remote_seg = sglib_hashed_uct_mm_remote_seg_t_it_next(&iter)) {
             sglib_hashed_uct_mm_remote_seg_t_delete(self->remote_segments_hash, remote_seg);
@@ -254,48 +261,103 @@ void *uct_mm_ep_attach_remote_seg(uct_mm_ep_t *ep, uct_mm_iface_t *iface, uct_mm
 
 }
 
-static inline ucs_status_t uct_mm_ep_get_remote_elem(uct_mm_ep_t *ep, uint64_t head,
-                                                     uct_mm_fifo_element_t **elem)
+static inline void uct_mm_ep_update_cached_tail(uct_mm_ep_t *ep)
+{
+    ucs_memory_cpu_load_fence();
+    ep->cached_tail = ep->fifo_ctl->tail;
+}
+
+static UCS_F_ALWAYS_INLINE void
+uct_mm_ep_set_elem_owner(uct_mm_fifo_element_t *elem, uint64_t head,
+                         unsigned fifo_size)
+{
+    /* change the owner bit to indicate that the writing is complete.
+     * the owner bit flips after every FIFO wraparound */
+    if (head & fifo_size) {
+        elem->flags |= UCT_MM_FIFO_ELEM_FLAG_OWNER;
+    } else {
+        elem->flags &= ~UCT_MM_FIFO_ELEM_FLAG_OWNER;
+    }
+}
+
+/* signal the remote receiver if it's sleeping on its wakeup handle */
+static UCS_F_NOINLINE void uct_mm_ep_wakeup_remote(uct_mm_ep_t *ep)
 {
     uct_mm_iface_t *iface = ucs_derived_of(ep->super.super.iface, uct_mm_iface_t);
-    uint64_t elem_index;       /* the fifo elem's index in the fifo. */
-                               /* must be smaller than fifo size */
-    uint64_t returned_val;
+    uct_mm_iface_conn_signal_t sig = UCT_MM_IFACE_SIGNAL_WAKEUP;
+    uct_mm_fifo_ctl_t *ctl = ep->fifo_ctl;
+    struct sockaddr_un sockaddr;
+    int ret;
 
-    elem_index = ep->fifo_ctl->head & iface->fifo_mask;
-    *elem = UCT_MM_IFACE_GET_FIFO_ELEM(iface, ep->fifo, elem_index);
+    /* the element owner bit must be visible before reading the receiver state,
+     * see uct_mm_iface_wakeup_arm() */
+    ucs_memory_bus_fence();
 
-    /* try to get ownership of the head element */
-    returned_val = ucs_atomic_cswap64(&ep->fifo_ctl->head, head, head+1);
-    if (returned_val != head) {
-        return UCS_ERR_NO_RESOURCE;
+    if (!(ctl->wakeup_flags & UCT_MM_FIFO_CTL_WAKEUP_ARMED)) {
+        return;
     }
 
-    return UCS_OK;
+    /* only one sender has to signal */
+    if (ucs_atomic_cswap32(uct_mm_fifo_ctl_wakeup_flags(ctl),
+                           UCT_MM_FIFO_CTL_WAKEUP_ENABLED |
+                           UCT_MM_FIFO_CTL_WAKEUP_ARMED,
+                           UCT_MM_FIFO_CTL_WAKEUP_ENABLED) !=
+        (UCT_MM_FIFO_CTL_WAKEUP_ENABLED | UCT_MM_FIFO_CTL_WAKEUP_ARMED)) {
+        return;
+    }
+
+    sockaddr = ctl->wakeup_sockaddr;
+    ret      = sendto(iface->signal_fd, &sig, sizeof(sig), 0,
+                      (const struct sockaddr*)&sockaddr, ctl->wakeup_addrlen);
+    if ((ret < 0) && (errno != EAGAIN)) {
+        /* EAGAIN means the receiver has enough signals already */
+        ucs_debug("failed to send wakeup signal: %m");
+    }
 }
 
-static inline void uct_mm_ep_update_cached_tail(uct_mm_ep_t *ep)
+void uct_mm_ep_release_reserved(uct_mm_ep_t *ep)
 {
-    ucs_memory_cpu_load_fence();
-    ep->cached_tail = ep->fifo_ctl->tail;
+    uct_mm_iface_t *iface = ucs_derived_of(ep->super.super.iface, uct_mm_iface_t);
+    uct_mm_fifo_element_t *elem;
+    uint64_t head;
+
+    ucs_trace_data("ep %p: releasing %"PRIu64" reserved FIFO elements", ep,
+                   ep->reserved_end - ep->reserved_head);
+
+    for (head = ep->reserved_head; head != ep->reserved_end; ++head) {
+        elem = UCT_MM_IFACE_GET_FIFO_ELEM(iface, ep->fifo, head & iface->fifo_mask);
+        elem->flags |= UCT_MM_FIFO_ELEM_FLAG_SKIP;
+    }
+
+    /* the receiver must see the skip flag before the owner bit */
+    ucs_memory_cpu_store_fence();
+
+    for (head = ep->reserved_head; head != ep->reserved_end; ++head) {
+        elem = UCT_MM_IFACE_GET_FIFO_ELEM(iface, ep->fifo, head & iface->fifo_mask);
+        uct_mm_ep_set_elem_owner(elem, head, iface->config.fifo_size);
+    }
+
+    ep->reserved_head = ep->reserved_end;
+    ucs_list_del(&ep->reserved_list);
 }
 
-/* A common mm active message sending function.
- * The first parameter indicates the origin of the call.
- * is_short = 1 - perform AM short sending
- * is_short = 0 - perform AM bcopy sending
+/* Get the index of a remote FIFO element the ep can write to. If there are no
+ * elements left from a previous reservation, reserve up to fifo_reserve
+ * elements by moving the remote head with a single atomic operation.
  */
-static UCS_F_ALWAYS_INLINE ssize_t
-uct_mm_ep_am_common_send(const unsigned is_short, uct_mm_ep_t *ep, uct_mm_iface_t *iface,
-                         uint8_t am_id, size_t length, uint64_t header,
-                         const void *payload, uct_pack_callback_t pack_cb, void *arg)
+static UCS_F_ALWAYS_INLINE ucs_status_t
+uct_mm_ep_get_remote_elem(uct_mm_ep_t *ep, uct_mm_iface_t *iface,
+                          uint64_t *head_p)
 {
-    uct_mm_fifo_element_t *elem;
-    ucs_status_t status;
-    void *base_address;
-    uint64_t head;
+    uint64_t head, count;
 
-    UCT_CHECK_AM_ID(am_id);
+    if (ep->reserved_head != ep->reserved_end) {
+        *head_p = ep->reserved_head++;
+        if (ep->reserved_head == ep->reserved_end) {
+            ucs_list_del(&ep->reserved_list);
+        }
+        return UCS_OK;
+    }
 
     head = ep->fifo_ctl->head;
     /* check if there is room in the remote process's receive FIFO to write */
@@ -315,14 +377,53 @@ uct_mm_ep_am_common_send(const unsigned is_short, uct_mm_ep_t *ep, uct_mm_iface_
         }
     }
 
-    status = uct_mm_ep_get_remote_elem(ep, head, &elem);
-    if (status != UCS_OK) {
+    count = ucs_min(iface->config.fifo_reserve,
+                    iface->config.fifo_size - (head - ep->cached_tail));
+
+    /* try to get ownership of the head element(s) */
+    if (ucs_atomic_cswap64(&ep->fifo_ctl->head, head, head + count) != head) {
         ucs_trace_poll("couldn't get an available FIFO element");
         UCS_STATS_UPDATE_COUNTER(ep->super.stats, UCT_EP_STAT_NO_RES, 1);
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    if (count > 1) {
+        ep->reserved_head = head + 1;
+        ep->reserved_end  = head + count;
+        ucs_list_add_tail(&iface->reserved_eps, &ep->reserved_list);
+    }
+
+    *head_p = head;
+    return UCS_OK;
+}
+
+/* A common mm active message sending function.
+ * The first parameter indicates the origin of the call.
+ * UCT_MM_AM_SHORT - perform AM short sending
+ * UCT_MM_AM_BCOPY - perform AM bcopy sending
+ * UCT_MM_AM_ZCOPY - perform AM zcopy sending, pack_cb gathers the user buffers
+ *                   directly into the remote descriptor
+ */
+static UCS_F_ALWAYS_INLINE ssize_t
+uct_mm_ep_am_common_send(const unsigned send_type, uct_mm_ep_t *ep, uct_mm_iface_t *iface,
+                         uint8_t am_id, size_t length, uint64_t header,
+                         const void *payload, uct_pack_callback_t pack_cb, void *arg)
+{
+    uct_mm_fifo_element_t *elem;
+    ucs_status_t status;
+    void *base_address;
+    uint64_t head;
+
+    UCT_CHECK_AM_ID(am_id);
+
+    status = uct_mm_ep_get_remote_elem(ep, iface, &head);
+    if (status != UCS_OK) {
         return status;
     }
 
-    if (is_short) {
+    elem = UCT_MM_IFACE_GET_FIFO_ELEM(iface, ep->fifo, head & iface->fifo_mask);
+
+    if (send_type == UCT_MM_AM_SHORT) {
         /* AM_SHORT */
         /* write to the remote FIFO */
         *(uint64_t*) (elem + 1) = header;
@@ -335,7 +436,7 @@ uct_mm_ep_am_common_send(const unsigned is_short, uct_mm_ep_t *ep, uct_mm_iface_
                            elem + 1, length + sizeof(header), "TX: AM_SHORT");
         UCT_TL_EP_STAT_OP(&ep->super, AM, SHORT, sizeof(header) + length);
     } else {
-        /* AM_BCOPY */
+        /* AM_BCOPY / AM_ZCOPY */
         /* write to the remote descriptor */
         /* get the base_address: local ptr to remote memory chunk after attaching to it */
         base_address = uct_mm_ep_attach_remote_seg(ep, iface, elem);
@@ -344,10 +445,17 @@ uct_mm_ep_am_common_send(const unsigned is_short, uct_mm_ep_t *ep, uct_mm_iface_
         elem->flags &= ~UCT_MM_FIFO_ELEM_FLAG_INLINE;
         elem->length = length;
 
-        uct_iface_trace_am(&iface->super, UCT_AM_TRACE_TYPE_SEND, am_id,
-                           base_address + elem->desc_offset, length, "TX: AM_BCOPY");
-
-        UCT_TL_EP_STAT_OP(&ep->super, AM, BCOPY, length);
+        if (send_type == UCT_MM_AM_BCOPY) {
+            uct_iface_trace_am(&iface->super, UCT_AM_TRACE_TYPE_SEND, am_id,
+                               base_address + elem->desc_offset, length,
+                               "TX: AM_BCOPY");
+            UCT_TL_EP_STAT_OP(&ep->super, AM, BCOPY, length);
+        } else {
+            uct_iface_trace_am(&iface->super, UCT_AM_TRACE_TYPE_SEND, am_id,
+                               base_address + elem->desc_offset, length,
+                               "TX: AM_ZCOPY");
+            UCT_TL_EP_STAT_OP(&ep->super, AM, ZCOPY, length);
+        }
     }
 
     elem->am_id = am_id;
@@ -356,18 +464,16 @@ uct_mm_ep_am_common_send(const unsigned is_short, uct_mm_ep_t *ep, uct_mm_iface_
      * 'writing is complete' flag which the reader checks */
     ucs_memory_cpu_store_fence();
 
-    /* change the owner bit to indicate that the writing is complete.
-     * the owner bit flips after every FIFO wraparound */
-    if (head & iface->config.fifo_size) {
-        elem->flags |= UCT_MM_FIFO_ELEM_FLAG_OWNER;
-    } else {
-        elem->flags &= ~UCT_MM_FIFO_ELEM_FLAG_OWNER;
+    uct_mm_ep_set_elem_owner(elem, head, iface->config.fifo_size);
+
+    if (ucs_unlikely(ep->fifo_ctl->wakeup_flags & UCT_MM_FIFO_CTL_WAKEUP_ENABLED)) {
+        uct_mm_ep_wakeup_remote(ep);
     }
 
-    if (is_short) {
-        return UCS_OK;
-    } else {
+    if (send_type == UCT_MM_AM_BCOPY) {
         return length;
+    } else {
+        return UCS_OK;
     }
 }
 
@@ -395,14 +501,63 @@ ssize_t uct_mm_ep_am_bcopy(uct_ep_h tl_ep, uint8_t id, uct_pack_callback_t pack_
                                     pack_cb, arg);
 }
 
+typedef struct {
+    const void       *header;
+    unsigned         header_length;
+    const uct_iov_t  *iov;
+    size_t           iovcnt;
+} uct_mm_ep_zcopy_args_t;
+
+static size_t uct_mm_ep_am_zcopy_pack(void *dest, void *arg)
+{
+    uct_mm_ep_zcopy_args_t *args = arg;
+    size_t iov_it, length;
+
+    memcpy(dest, args->header, args->header_length);
+    length = args->header_length;
+
+    for (iov_it = 0; iov_it < args->iovcnt; ++iov_it) {
+        memcpy(dest + length, args->iov[iov_it].buffer,
+               uct_iov_get_length(&args->iov[iov_it]));
+        length += uct_iov_get_length(&args->iov[iov_it]);
+    }
+
+    return length;
+}
+
+ucs_status_t uct_mm_ep_am_zcopy(uct_ep_h tl_ep, uint8_t id, const void *header,
+                                unsigned header_length, const uct_iov_t *iov,
+                                size_t iovcnt, uct_completion_t *comp)
+{
+    uct_mm_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_mm_iface_t);
+    uct_mm_ep_t *ep = ucs_derived_of(tl_ep, uct_mm_ep_t);
+    uct_mm_ep_zcopy_args_t args;
+
+    UCT_CHECK_IOV_SIZE(iovcnt, (size_t)UCT_SM_MAX_IOV, "uct_mm_ep_am_zcopy");
+    UCT_CHECK_LENGTH(header_length + uct_iov_total_length(iov, iovcnt),
+                     iface->config.seg_size, "am_zcopy");
+
+    args.header        = header;
+    args.header_length = header_length;
+    args.iov           = iov;
+    args.iovcnt        = iovcnt;
+
+    /* the data is copied to the receive descriptor in the peer's memory
+     * before returning, so the operation is already complete */
+    return uct_mm_ep_am_common_send(UCT_MM_AM_ZCOPY, ep, iface, id, 0, 0, NULL,
+                                    uct_mm_ep_am_zcopy_pack, &args);
+}
+
 static inline int uct_mm_ep_has_tx_resources(uct_mm_ep_t *ep)
 {
     uct_mm_iface_t *iface = ucs_derived_of(ep->super.super.iface, uct_mm_iface_t);
-    return UCT_MM_EP_IS_ABLE_TO_SEND(ep->fifo_ctl->head, ep->cached_tail,
+    return (ep->reserved_head != ep->reserved_end) ||
+           UCT_MM_EP_IS_ABLE_TO_SEND(ep->fifo_ctl->head, ep->cached_tail,
                                      iface->config.fifo_size);
 }
 
-ucs_status_t uct_mm_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n)
+ucs_status_t uct_mm_ep_pending_add_prio(uct_ep_h tl_ep, uct_pending_req_t *n,
+                                        uct_pending_prio_t prio)
 {
     uct_mm_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_mm_iface_t);
     uct_mm_ep_t *ep = ucs_derived_of(tl_ep, uct_mm_ep_t);
@@ -416,18 +571,25 @@ ucs_status_t uct_mm_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n)
 
     ucs_arbiter_elem_init((ucs_arbiter_elem_t *)n->priv);
     /* add the request to the ep's arbiter_group (pending queue) */
-    ucs_arbiter_group_push_elem(&ep->arb_group, (ucs_arbiter_elem_t*) n->priv);
+    ucs_arbiter_group_push_elem_prio(&ep->arb_group, (ucs_arbiter_elem_t*) n->priv,
+                                     uct_pending_arb_prio(prio));
     /* add the ep's group to the arbiter */
     ucs_arbiter_group_schedule(&iface->arbiter, &ep->arb_group);
 
     return UCS_OK;
 }
 
+ucs_status_t uct_mm_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n)
+{
+    return uct_mm_ep_pending_add_prio(tl_ep, n, UCT_PENDING_PRIO_BULK);
+}
+
 ucs_arbiter_cb_result_t uct_mm_ep_process_pending(ucs_arbiter_t *arbiter,
                                                   ucs_arbiter_elem_t *elem,
                                                   void *arg)
 {
     uct_pending_req_t *req = ucs_container_of(elem, uct_pending_req_t, priv);
+    unsigned *count = arg;
     ucs_status_t status;
     uct_mm_ep_t *ep = ucs_container_of(ucs_arbiter_elem_group(elem), uct_mm_ep_t, arb_group);
 
@@ -446,9 +608,11 @@ ucs_arbiter_cb_result_t uct_mm_ep_process_pending(ucs_arbiter_t *arbiter,
 
     if (status == UCS_OK) {
         /* sent successfully. remove from the arbiter */
+        ++(*count);
         return UCS_ARBITER_CB_RESULT_REMOVE_ELEM;
     } else if (status == UCS_INPROGRESS) {
         /* sent but not completed, keep in the arbiter */
+        ++(*count);
         return UCS_ARBITER_CB_RESULT_NEXT_GROUP;
     } else {
         /* couldn't send. keep this request in the arbiter until the next time
@@ -490,6 +654,10 @@ ucs_status_t uct_mm_ep_flush(uct_ep_h tl_ep, unsigned flags,
 {
     uct_mm_ep_t *ep = ucs_derived_of(tl_ep, uct_mm_ep_t);
 
+    if (ep->reserved_head != ep->reserved_end) {
+        uct_mm_ep_release_reserved(ep);
+    }
+
     uct_mm_ep_update_cached_tail(ep);
 
     if (!uct_mm_ep_has_tx_resources(ep)) {
@@ -29,6 +29,18 @@ static ucs_config_field_t uct_mm_iface_config_table[] = {
      "This value refers to the percentage of the FIFO size. (must be >= 0 and < 1)",
      ucs_offsetof(uct_mm_iface_config_t, release_fifo_factor), UCS_CONFIG_TYPE_DOUBLE},
 
+    {"RX_MAX_POLL", "16",
+     "Max number of receive FIFO elements to read during one progress call.",
+     ucs_offsetof(uct_mm_iface_config_t, rx_max_poll), UCS_CONFIG_TYPE_UINT},
+
+    {"FIFO_RESERVE", "1",
+     "Number of elements a sender reserves in the remote receive FIFO with a single\n"
+     "atomic operation on the FIFO head. Values larger than 1 reduce the contention\n"
+     "on the head when many processes send to the same receiver, at the cost of\n"
+     "delaying other senders until the reserved elements are used or released.\n"
+     "Unused elements are released on the next progress or flush.",
+     ucs_offsetof(uct_mm_iface_config_t, fifo_reserve), UCS_CONFIG_TYPE_UINT},
+
     UCT_IFACE_MPOOL_CONFIG_FIELDS("RX_", -1, 256, "receive",
                                   ucs_offsetof(uct_mm_iface_config_t, mp), ""),
 
@@ -62,13 +74,26 @@ void uct_mm_iface_release_am_desc(uct_iface_t *tl_iface, void *desc)
     ucs_mpool_put(mm_desc);
 }
 
+static void uct_mm_iface_release_reserved(uct_mm_iface_t *iface)
+{
+    uct_mm_ep_t *ep, *tmp;
+
+    ucs_list_for_each_safe(ep, tmp, &iface->reserved_eps, reserved_list) {
+        uct_mm_ep_release_reserved(ep);
+    }
+}
+
 ucs_status_t uct_mm_iface_flush(uct_iface_h tl_iface, unsigned flags,
                                 uct_completion_t *comp)
 {
+    uct_mm_iface_t *iface = ucs_derived_of(tl_iface, uct_mm_iface_t);
+
     if (comp != NULL) {
         return UCS_ERR_UNSUPPORTED;
     }
 
+    uct_mm_iface_release_reserved(iface);
+
     ucs_memory_cpu_store_fence();
     UCT_TL_IFACE_STAT_FLUSH(ucs_derived_of(tl_iface, uct_base_iface_t));
     return UCS_OK;
@@ -87,29 +112,31 @@ static ucs_status_t uct_mm_iface_query(uct_iface_h tl_iface,
     iface_attr->cap.put.max_zcopy       = SIZE_MAX;
     iface_attr->cap.put.opt_zcopy_align = UCS_SYS_CACHE_LINE_SIZE;
     iface_attr->cap.put.align_mtu       = iface_attr->cap.put.opt_zcopy_align;
-    iface_attr->cap.put.max_iov         = 1;
+    iface_attr->cap.put.max_iov         = uct_sm_get_max_iov();
 
     iface_attr->cap.get.max_bcopy       = SIZE_MAX;
     iface_attr->cap.get.min_zcopy       = 0;
     iface_attr->cap.get.max_zcopy       = SIZE_MAX;
     iface_attr->cap.get.opt_zcopy_align = UCS_SYS_CACHE_LINE_SIZE;
     iface_attr->cap.get.align_mtu       = iface_attr->cap.get.opt_zcopy_align;
-    iface_attr->cap.get.max_iov         = 1;
+    iface_attr->cap.get.max_iov         = uct_sm_get_max_iov();
 
     iface_attr->cap.am.max_short        = iface->config.fifo_elem_size -
                                           sizeof(uct_mm_fifo_element_t);
     iface_attr->cap.am.max_bcopy        = iface->config.seg_size;
     iface_attr->cap.am.min_zcopy        = 0;
-    iface_attr->cap.am.max_zcopy        = 0;
+    iface_attr->cap.am.max_zcopy        = iface->config.seg_size;
     iface_attr->cap.am.opt_zcopy_align  = UCS_SYS_CACHE_LINE_SIZE;
     iface_attr->cap.am.align_mtu        = iface_attr->cap.am.opt_zcopy_align;
-    iface_attr->cap.am.max_iov          = 1;
+    iface_attr->cap.am.max_hdr          = iface->config.seg_size;
+    iface_attr->cap.am.max_iov          = uct_sm_get_max_iov();
 
     iface_attr->iface_addr_len          = sizeof(uct_mm_iface_addr_t);
     iface_attr->device_addr_len         = UCT_SM_IFACE_DEVICE_ADDR_LEN;
     iface_attr->ep_addr_len             = 0;
     iface_attr->cap.flags               = UCT_IFACE_FLAG_PUT_SHORT        |
                                           UCT_IFACE_FLAG_PUT_BCOPY        |
+                                          UCT_IFACE_FLAG_PUT_ZCOPY        |
                                           UCT_IFACE_FLAG_ATOMIC_ADD32     |
                                           UCT_IFACE_FLAG_ATOMIC_ADD64     |
                                           UCT_IFACE_FLAG_ATOMIC_FADD64    |
@@ -120,10 +147,13 @@ static ucs_status_t uct_mm_iface_query(uct_iface_h tl_iface,
                                           UCT_IFACE_FLAG_ATOMIC_CSWAP32   |
                                           UCT_IFACE_FLAG_ATOMIC_CPU       |
                                           UCT_IFACE_FLAG_GET_BCOPY        |
+                                          UCT_IFACE_FLAG_GET_ZCOPY        |
                                           UCT_IFACE_FLAG_AM_SHORT         |
                                           UCT_IFACE_FLAG_AM_BCOPY         |
+                                          UCT_IFACE_FLAG_AM_ZCOPY         |
                                           UCT_IFACE_FLAG_PENDING          |
                                           UCT_IFACE_FLAG_AM_CB_SYNC       |
+                                          UCT_IFACE_FLAG_WAKEUP           |
                                           UCT_IFACE_FLAG_CONNECT_TO_IFACE;
 
     iface_attr->latency.overhead        = 80e-9; /* 80 ns */
@@ -134,42 +164,12 @@ static ucs_status_t uct_mm_iface_query(uct_iface_h tl_iface,
     return UCS_OK;
 }
 
-static UCS_CLASS_DECLARE_DELETE_FUNC(uct_mm_iface_t, uct_iface_t);
-
-static uct_iface_ops_t uct_mm_iface_ops = {
-    .iface_close         = UCS_CLASS_DELETE_FUNC_NAME(uct_mm_iface_t),
-    .iface_query         = uct_mm_iface_query,
-    .iface_get_address   = uct_mm_iface_get_address,
-    .iface_get_device_address = uct_sm_iface_get_device_address,
-    .iface_is_reachable  = uct_sm_iface_is_reachable,
-    .iface_release_am_desc = uct_mm_iface_release_am_desc,
-    .iface_flush         = uct_mm_iface_flush,
-    .iface_fence         = uct_sm_iface_fence,
-    .ep_put_short        = uct_sm_ep_put_short,
-    .ep_put_bcopy        = uct_sm_ep_put_bcopy,
-    .ep_get_bcopy        = uct_sm_ep_get_bcopy,
-    .ep_am_short         = uct_mm_ep_am_short,
-    .ep_am_bcopy         = uct_mm_ep_am_bcopy,
-    .ep_atomic_add64     = uct_sm_ep_atomic_add64,
-    .ep_atomic_fadd64    = uct_sm_ep_atomic_fadd64,
-    .ep_atomic_cswap64   = uct_sm_ep_atomic_cswap64,
-    .ep_atomic_swap64    = uct_sm_ep_atomic_swap64,
-    .ep_atomic_add32     = uct_sm_ep_atomic_add32,
-    .ep_atomic_fadd32    = uct_sm_ep_atomic_fadd32,
-    .ep_atomic_cswap32   = uct_sm_ep_atomic_cswap32,
-    .ep_atomic_swap32    = uct_sm_ep_atomic_swap32,
-    .ep_pending_add      = uct_mm_ep_pending_add,
-    .ep_pending_purge    = uct_mm_ep_pending_purge,
-    .ep_flush            = uct_mm_ep_flush,
-    .ep_fence            = uct_sm_ep_fence,
-    .ep_create_connected = UCS_CLASS_NEW_FUNC_NAME(uct_mm_ep_t),
-    .ep_destroy          = UCS_CLASS_DELETE_FUNC_NAME(uct_mm_ep_t),
-};
-
-static inline void uct_mm_progress_fifo_tail(uct_mm_iface_t *iface)
+static inline void uct_mm_progress_fifo_tail(uct_mm_iface_t *iface,
+                                             uint64_t prev_read_index)
 {
-    /* don't progress the tail every time - release in batches. improves performance */
-    if (iface->read_index & iface->fifo_release_factor_mask) {
+    /* don't progress the tail every time - release in batches. improves performance.
+     * several elements may be read at once, so check if a batch boundary was crossed */
+    if ((prev_read_index | iface->fifo_release_factor_mask) >= iface->read_index) {
         return;
     }
 
@@ -232,53 +232,93 @@ static inline ucs_status_t uct_mm_iface_process_recv(uct_mm_iface_t *iface,
     return status;
 }
 
-static inline void uct_mm_iface_poll_fifo(uct_mm_iface_t *iface)
+static inline int uct_mm_iface_fifo_elem_ready(uct_mm_iface_t *iface,
+                                               uint64_t read_index,
+                                               uct_mm_fifo_element_t *elem)
 {
-    uint64_t read_index_loc, read_index;
-    uct_mm_fifo_element_t* read_index_elem;
+    /* check the owner bit of the element against the read_index */
+    return ((read_index >> iface->fifo_shift) & 1) == (elem->flags & 1);
+}
+
+static inline unsigned uct_mm_iface_poll_fifo(uct_mm_iface_t *iface)
+{
+    uint64_t prev_read_index, read_index;
+    uct_mm_fifo_element_t *elem;
+    unsigned count, num_elems;
     ucs_status_t status;
 
     /* check the memory pool to make sure that there is a new descriptor available */
     if (ucs_unlikely(iface->last_recv_desc == NULL)) {
         UCT_TL_IFACE_GET_RX_DESC(&iface->super, &iface->recv_desc_mp,
-                                 iface->last_recv_desc, return);
+                                 iface->last_recv_desc, return 0);
+    }
+
+    /* find how many consecutive elements are ready to be read */
+    prev_read_index = iface->read_index;
+    read_index      = prev_read_index;
+    for (num_elems = 0; num_elems < iface->config.rx_max_poll; ++num_elems) {
+        elem = UCT_MM_IFACE_GET_FIFO_ELEM(iface, iface->recv_fifo_elements,
+                                          read_index & iface->fifo_mask);
+        if (!uct_mm_iface_fifo_elem_ready(iface, read_index, elem)) {
+            break;
+        }
+        ++read_index;
     }
 
-    read_index = iface->read_index;
-    read_index_loc = (read_index & iface->fifo_mask);
-    /* the fifo_element which the read_index points to */
-    read_index_elem = UCT_MM_IFACE_GET_FIFO_ELEM(iface, iface->recv_fifo_elements ,read_index_loc);
+    if (num_elems == 0) {
+        return 0;
+    }
+
+    /* read the contents of all ready elements after their owner bits */
+    ucs_memory_cpu_load_fence();
+    ucs_assert(read_index <= iface->recv_fifo_ctl->head);
+
+    count = 0;
+    while (iface->read_index != read_index) {
+        elem = UCT_MM_IFACE_GET_FIFO_ELEM(iface, iface->recv_fifo_elements,
+                                          iface->read_index & iface->fifo_mask);
 
-    /* check the read_index to see if there is a new item to read (checking the owner bit) */
-    if (((read_index >> iface->fifo_shift) & 1) == ((read_index_elem->flags) & 1)) {
+        /* raise the read_index. */
+        ++iface->read_index;
+
+        if (ucs_unlikely(elem->flags & UCT_MM_FIFO_ELEM_FLAG_SKIP)) {
+            /* the sender released this element without writing to it */
+            elem->flags &= ~UCT_MM_FIFO_ELEM_FLAG_SKIP;
+            continue;
+        }
 
-        /* read from read_index_elem */
-        ucs_memory_cpu_load_fence();
-        ucs_assert(iface->read_index <= iface->recv_fifo_ctl->head);
+        status = uct_mm_iface_process_recv(iface, elem);
+        ++count;
 
-        status = uct_mm_iface_process_recv(iface, read_index_elem);
         if (status != UCS_OK) {
             /* the last_recv_desc is in use. get a new descriptor for it */
             UCT_TL_IFACE_GET_RX_DESC(&iface->super, &iface->recv_desc_mp,
-                                     iface->last_recv_desc, ucs_debug("recv mpool is empty"));
+                                     iface->last_recv_desc,
+                                     ucs_debug("recv mpool is empty"); break);
         }
-
-        /* raise the read_index. */
-        iface->read_index++;
     }
 
-    uct_mm_progress_fifo_tail(iface);
+    uct_mm_progress_fifo_tail(iface, prev_read_index);
+    return count;
 }
 
-void uct_mm_iface_progress(void *arg)
+unsigned uct_mm_iface_progress(void *arg)
 {
     uct_mm_iface_t *iface = arg;
+    unsigned count;
 
     /* progress receive */
-    uct_mm_iface_poll_fifo(iface);
+    count = uct_mm_iface_poll_fifo(iface);
 
     /* progress the pending sends (if there are any) */
-    ucs_arbiter_dispatch(&iface->arbiter, 1, uct_mm_ep_process_pending, NULL);
+    ucs_arbiter_dispatch(&iface->arbiter, 1, uct_mm_ep_process_pending, &count);
+
+    /* let the remote receivers read past the elements we did not use */
+    if (ucs_unlikely(!ucs_list_is_empty(&iface->reserved_eps))) {
+        uct_mm_iface_release_reserved(iface);
+    }
+
+    return count;
 }
 
 void uct_mm_iface_recv_desc_init(uct_iface_h tl_iface, void *obj, uct_mem_h memh)
@@ -341,60 +381,224 @@ ucs_status_t uct_mm_allocate_fifo_mem(uct_mm_iface_t *iface,
     return UCS_OK;
 }
 
-static ucs_status_t uct_mm_iface_create_signal_fd(uct_mm_iface_t *iface)
+/*
+ * Create a non-blocking UNIX domain datagram socket bound to an automatic
+ * address, and return the address so it could be shared with remote processes.
+ */
+static ucs_status_t uct_mm_iface_create_socket(const char *name, int *fd_p,
+                                               struct sockaddr_un *sockaddr,
+                                               socklen_t *addrlen_p)
 {
     ucs_status_t status;
     socklen_t addrlen;
     struct sockaddr_un bind_addr;
-    int ret;
+    int ret, fd;
 
-    /* Create a UNIX domain socket to send and receive wakeup signal from remote processes */
-    iface->signal_fd = socket(AF_UNIX, SOCK_DGRAM, 0);
-    if (iface->signal_fd < 0) {
-        ucs_error("Failed to create unix domain socket for signal: %m");
+    fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        ucs_error("Failed to create unix domain socket for %s: %m", name);
         status = UCS_ERR_IO_ERROR;
         goto err;
     }
 
-    /* Set the signal socket to non-blocking mode */
-    status = ucs_sys_fcntl_modfl(iface->signal_fd, O_NONBLOCK, 0);
+    /* Set the socket to non-blocking mode */
+    status = ucs_sys_fcntl_modfl(fd, O_NONBLOCK, 0);
     if (status != UCS_OK) {
         goto err_close;
     }
 
-    /* Bind the signal socket to automatic address */
+    /* Bind the socket to automatic address */
     bind_addr.sun_family = AF_UNIX;
     memset(bind_addr.sun_path, 0, sizeof(bind_addr.sun_path));
-    ret = bind(iface->signal_fd, (struct sockaddr*)&bind_addr, sizeof(sa_family_t));
+    ret = bind(fd, (struct sockaddr*)&bind_addr, sizeof(sa_family_t));
     if (ret < 0) {
         ucs_error("Failed to auto-bind unix domain socket: %m");
         status = UCS_ERR_IO_ERROR;
         goto err_close;
     }
 
-    /* Share the socket address on the FIFO control area, so we would not have
-     * to enlarge the interface address size.
-     */
     addrlen = sizeof(struct sockaddr_un);
-    memset(&iface->recv_fifo_ctl->signal_sockaddr, 0, addrlen);
-    ret = getsockname(iface->signal_fd,
-                      (struct sockaddr *)&iface->recv_fifo_ctl->signal_sockaddr,
-                      &addrlen);
+    memset(sockaddr, 0, addrlen);
+    ret = getsockname(fd, (struct sockaddr *)sockaddr, &addrlen);
     if (ret < 0) {
         ucs_error("Failed to retrieve unix domain socket address: %m");
         status = UCS_ERR_IO_ERROR;
         goto err_close;
     }
 
-    iface->recv_fifo_ctl->signal_addrlen = addrlen;
+    *addrlen_p = addrlen;
+    *fd_p      = fd;
     return UCS_OK;
 
 err_close:
-    close(iface->signal_fd);
+    close(fd);
 err:
     return status;
 }
 
+static ucs_status_t uct_mm_iface_create_signal_fds(uct_mm_iface_t *iface)
+{
+    uct_mm_fifo_ctl_t *ctl = iface->recv_fifo_ctl;
+    struct sockaddr_un signal_sockaddr, wakeup_sockaddr;
+    socklen_t signal_addrlen, wakeup_addrlen;
+    ucs_status_t status;
+
+    /* Create UNIX domain sockets to receive connection and wakeup signals from
+     * remote processes. Share the socket addresses on the FIFO control area,
+     * so we would not have to enlarge the interface address size.
+     */
+    status = uct_mm_iface_create_socket("signal", &iface->signal_fd,
+                                        &signal_sockaddr, &signal_addrlen);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    status = uct_mm_iface_create_socket("wakeup", &iface->wakeup_fd,
+                                        &wakeup_sockaddr, &wakeup_addrlen);
+    if (status != UCS_OK) {
+        close(iface->signal_fd);
+        return status;
+    }
+
+    /* the control area is packed, so copy the addresses by value */
+    ctl->signal_sockaddr = signal_sockaddr;
+    ctl->signal_addrlen  = signal_addrlen;
+    ctl->wakeup_sockaddr = wakeup_sockaddr;
+    ctl->wakeup_addrlen  = wakeup_addrlen;
+    return UCS_OK;
+}
+
+static void uct_mm_iface_close_signal_fds(uct_mm_iface_t *iface)
+{
+    close(iface->wakeup_fd);
+    close(iface->signal_fd);
+}
+
+/* Read all pending wakeup signals, return how many were read */
+static unsigned uct_mm_iface_drain_wakeup_fd(uct_mm_iface_t *iface)
+{
+    uct_mm_iface_conn_signal_t sig;
+    unsigned count = 0;
+    int ret;
+
+    for (;;) {
+        ret = recvfrom(iface->wakeup_fd, &sig, sizeof(sig), 0, NULL, 0);
+        if (ret < 0) {
+            if (errno != EAGAIN) {
+                ucs_error("failed to retrieve message from wakeup socket: %m");
+            }
+            return count;
+        }
+        ++count;
+    }
+}
+
+static ucs_status_t uct_mm_iface_wakeup_open(uct_iface_h tl_iface, unsigned events,
+                                             uct_wakeup_h wakeup)
+{
+    uct_mm_iface_t *iface = ucs_derived_of(tl_iface, uct_mm_iface_t);
+
+    wakeup->fd = iface->wakeup_fd;
+    if (events & (UCT_WAKEUP_RX_AM | UCT_WAKEUP_RX_SIGNALED_AM)) {
+        iface->recv_fifo_ctl->wakeup_flags = UCT_MM_FIFO_CTL_WAKEUP_ENABLED;
+    }
+    return UCS_OK;
+}
+
+/*
+ * Check whether the FIFO has elements which were not reported by a previous
+ * arm. If progress was called since then, all ready elements are new.
+ */
+static int uct_mm_iface_wakeup_check_fifo(uct_mm_iface_t *iface)
+{
+    uint64_t index, end_index;
+    uct_mm_fifo_element_t *elem;
+
+    if (iface->read_index == iface->wakeup_read_index) {
+        index = ucs_max(iface->read_index, iface->wakeup_end_index);
+    } else {
+        index = iface->read_index;
+    }
+
+    for (end_index = index;
+         end_index - iface->read_index < iface->config.fifo_size;
+         ++end_index)
+    {
+        elem = UCT_MM_IFACE_GET_FIFO_ELEM(iface, iface->recv_fifo_elements,
+                                          end_index & iface->fifo_mask);
+        if (!uct_mm_iface_fifo_elem_ready(iface, end_index, elem)) {
+            break;
+        }
+    }
+
+    if (end_index == index) {
+        return 0;
+    }
+
+    iface->wakeup_read_index = iface->read_index;
+    iface->wakeup_end_index  = end_index;
+    return 1;
+}
+
+static ucs_status_t uct_mm_iface_wakeup_arm(uct_wakeup_h wakeup)
+{
+    uct_mm_iface_t *iface = ucs_derived_of(wakeup->iface, uct_mm_iface_t);
+
+    if (uct_mm_iface_drain_wakeup_fd(iface) > 0) {
+        return UCS_ERR_BUSY;
+    }
+
+    /* Sends waiting for FIFO space or reserved elements are completed only
+     * by progress, and nobody would signal us about them */
+    if (!ucs_arbiter_is_empty(&iface->arbiter) ||
+        !ucs_list_is_empty(&iface->reserved_eps)) {
+        return UCS_ERR_BUSY;
+    }
+
+    if (!(iface->recv_fifo_ctl->wakeup_flags & UCT_MM_FIFO_CTL_WAKEUP_ENABLED)) {
+        return UCS_OK;
+    }
+
+    /* The atomic operation orders setting the flag before checking the FIFO.
+     * A sender checks the flag after writing the element, so either we see the
+     * element now, or the sender sees the flag and signals the wakeup socket.
+     */
+    ucs_atomic_swap32(uct_mm_fifo_ctl_wakeup_flags(iface->recv_fifo_ctl),
+                      UCT_MM_FIFO_CTL_WAKEUP_ENABLED | UCT_MM_FIFO_CTL_WAKEUP_ARMED);
+
+    if (uct_mm_iface_wakeup_check_fifo(iface)) {
+        return UCS_ERR_BUSY;
+    }
+
+    return UCS_OK;
+}
+
+static ucs_status_t uct_mm_iface_wakeup_signal(uct_wakeup_h wakeup)
+{
+    uct_mm_iface_t *iface = ucs_derived_of(wakeup->iface, uct_mm_iface_t);
+    uct_mm_iface_conn_signal_t sig = UCT_MM_IFACE_SIGNAL_WAKEUP;
+    struct sockaddr_un sockaddr = iface->recv_fifo_ctl->wakeup_sockaddr;
+    int ret;
+
+    ret = sendto(iface->signal_fd, &sig, sizeof(sig), 0,
+                 (const struct sockaddr*)&sockaddr,
+                 iface->recv_fifo_ctl->wakeup_addrlen);
+    if ((ret < 0) && (errno != EAGAIN)) {
+        /* EAGAIN means there are enough signals already */
+        ucs_error("failed to send wakeup signal: %m");
+        return UCS_ERR_IO_ERROR;
+    }
+
+    return UCS_OK;
+}
+
+static void uct_mm_iface_wakeup_close(uct_wakeup_h wakeup)
+{
+    uct_mm_iface_t *iface = ucs_derived_of(wakeup->iface, uct_mm_iface_t);
+
+    iface->recv_fifo_ctl->wakeup_flags = 0;
+}
+
 static void uct_mm_iface_recv_messages(uct_mm_iface_t *iface)
 {
     uct_mm_iface_conn_signal_t sig;
@@ -429,8 +633,51 @@ static void uct_mm_iface_init_dummy_fifo_ctl(uct_mm_iface_t *iface)
 {
     iface->dummy_fifo_ctl.head = iface->config.fifo_size;
     iface->dummy_fifo_ctl.tail = 0;
+    iface->dummy_fifo_ctl.wakeup_flags = 0;
 }
 
+static UCS_CLASS_DECLARE_DELETE_FUNC(uct_mm_iface_t, uct_iface_t);
+
+static uct_iface_ops_t uct_mm_iface_ops = {
+    .iface_close         = UCS_CLASS_DELETE_FUNC_NAME(uct_mm_iface_t),
+    .iface_query         = uct_mm_iface_query,
+    .iface_get_address   = uct_mm_iface_get_address,
+    .iface_get_device_address = uct_sm_iface_get_device_address,
+    .iface_is_reachable  = uct_sm_iface_is_reachable,
+    .iface_release_am_desc = uct_mm_iface_release_am_desc,
+    .iface_flush         = uct_mm_iface_flush,
+    .iface_fence         = uct_sm_iface_fence,
+    .iface_wakeup_open   = uct_mm_iface_wakeup_open,
+    .iface_wakeup_get_fd = uct_base_iface_wakeup_get_fd,
+    .iface_wakeup_arm    = uct_mm_iface_wakeup_arm,
+    .iface_wakeup_wait   = uct_base_iface_wakeup_wait,
+    .iface_wakeup_signal = uct_mm_iface_wakeup_signal,
+    .iface_wakeup_close  = uct_mm_iface_wakeup_close,
+    .ep_put_short        = uct_sm_ep_put_short,
+    .ep_put_bcopy        = uct_sm_ep_put_bcopy,
+    .ep_put_zcopy        = uct_sm_ep_put_zcopy,
+    .ep_get_bcopy        = uct_sm_ep_get_bcopy,
+    .ep_get_zcopy        = uct_sm_ep_get_zcopy,
+    .ep_am_short         = uct_mm_ep_am_short,
+    .ep_am_bcopy         = uct_mm_ep_am_bcopy,
+    .ep_am_zcopy         = uct_mm_ep_am_zcopy,
+    .ep_atomic_add64     = uct_sm_ep_atomic_add64,
+    .ep_atomic_fadd64    = uct_sm_ep_atomic_fadd64,
+    .ep_atomic_cswap64   = uct_sm_ep_atomic_cswap64,
+    .ep_atomic_swap64    = uct_sm_ep_atomic_swap64,
+    .ep_atomic_add32     = uct_sm_ep_atomic_add32,
+    .ep_atomic_fadd32    = uct_sm_ep_atomic_fadd32,
+    .ep_atomic_cswap32   = uct_sm_ep_atomic_cswap32,
+    .ep_atomic_swap32    = uct_sm_ep_atomic_swap32,
+    .ep_pending_add      = uct_mm_ep_pending_add,
+    .ep_pending_add_prio = uct_mm_ep_pending_add_prio,
+    .ep_pending_purge    = uct_mm_ep_pending_purge,
+    .ep_flush            = uct_mm_ep_flush,
+    .ep_fence            = uct_sm_ep_fence,
+    .ep_create_connected = UCS_CLASS_NEW_FUNC_NAME(uct_mm_ep_t),
+    .ep_destroy          = UCS_CLASS_DELETE_FUNC_NAME(uct_mm_ep_t),
+};
+
 static UCS_CLASS_INIT_FUNC(uct_mm_iface_t, uct_md_h md, uct_worker_h worker,
                            const uct_iface_params_t *params,
                            const uct_iface_config_t *tl_config)
@@ -460,6 +707,22 @@ static UCS_CLASS_INIT_FUNC(uct_mm_iface_t, uct_md_h md, uct_worker_h worker,
         goto err;
     }
 
+    /* check the receive poll budget */
+    if (mm_config->rx_max_poll == 0) {
+        ucs_error("The MM RX_MAX_POLL parameter must be greater than 0.");
+        status = UCS_ERR_INVALID_PARAM;
+        goto err;
+    }
+
+    /* check the number of elements to reserve in a remote FIFO */
+    if ((mm_config->fifo_reserve == 0) ||
+        (mm_config->fifo_reserve > mm_config->fifo_size)) {
+        ucs_error("The MM FIFO_RESERVE parameter must be between 1 and the "
+                  "FIFO size (%u).", mm_config->fifo_size);
+        status = UCS_ERR_INVALID_PARAM;
+        goto err;
+    }
+
     /* check the value defining the size of the FIFO element */
     if (mm_config->super.max_short <= sizeof(uct_mm_fifo_element_t)) {
         ucs_error("The UCT_MM_MAX_SHORT parameter must be larger than the FIFO "
@@ -472,6 +735,8 @@ static UCS_CLASS_INIT_FUNC(uct_mm_iface_t, uct_md_h md, uct_worker_h worker,
     self->config.fifo_size         = mm_config->fifo_size;
     self->config.fifo_elem_size    = mm_config->super.max_short;
     self->config.seg_size          = mm_config->super.max_bcopy;
+    self->config.rx_max_poll       = mm_config->rx_max_poll;
+    self->config.fifo_reserve      = mm_config->fifo_reserve;
     self->fifo_release_factor_mask = UCS_MASK(ucs_ilog2(ucs_max((int)
                                      (mm_config->fifo_size * mm_config->release_fifo_factor),
                                      1)));
@@ -489,9 +754,12 @@ static UCS_CLASS_INIT_FUNC(uct_mm_iface_t, uct_md_h md, uct_worker_h worker,
 
     self->recv_fifo_ctl->head   = 0;
     self->recv_fifo_ctl->tail   = 0;
+    self->recv_fifo_ctl->wakeup_flags = 0;
     self->read_index            = 0;
+    self->wakeup_read_index     = 0;
+    self->wakeup_end_index      = 0;
 
-    status = uct_mm_iface_create_signal_fd(self);
+    status = uct_mm_iface_create_signal_fds(self);
     if (status != UCS_OK) {
         goto err_free_fifo;
     }
@@ -537,6 +805,7 @@ static UCS_CLASS_INIT_FUNC(uct_mm_iface_t, uct_md_h md, uct_worker_h worker,
     uct_mm_iface_init_dummy_fifo_ctl(self);
 
     ucs_arbiter_init(&self->arbiter);
+    ucs_list_head_init(&self->reserved_eps);
 
     ucs_async_set_event_handler((worker->async != NULL) ? worker->async->mode : UCS_ASYNC_MODE_THREAD,
                                 self->signal_fd, POLLIN, uct_mm_iface_singal_handler,
@@ -551,7 +820,7 @@ destroy_descs:
 destroy_recv_mpool:
     ucs_mpool_cleanup(&self->recv_desc_mp, 1);
 err_close_signal_fd:
-    close(self->signal_fd);
+    uct_mm_iface_close_signal_fds(self);
 err_free_fifo:
     uct_mm_md_mapper_ops(md)->free(self->shared_mem, self->fifo_mm_id,
                                    UCT_MM_GET_FIFO_SIZE(self), self->path);
@@ -575,7 +844,7 @@ static UCS_CLASS_CLEANUP_FUNC(uct_mm_iface_t)
 
     ucs_mpool_put(self->last_recv_desc);
     ucs_mpool_cleanup(&self->recv_desc_mp, 1);
-    close(self->signal_fd);
+    uct_mm_iface_close_signal_fds(self);
 
     size_to_free = UCT_MM_GET_FIFO_SIZE(self);
 
@@ -15,6 +15,7 @@
 #include <ucs/arch/cpu.h>
 #include <ucs/debug/memtrack.h>
 #include <ucs/datastruct/arbiter.h>
+#include <ucs/datastruct/list.h>
 #include <ucs/sys/compiler.h>
 #include <ucs/sys/sys.h>
 #include <sys/shm.h>
@@ -32,13 +33,26 @@
 
 typedef enum {
     UCT_MM_IFACE_SIGNAL_CONNECT    = 0,
+    UCT_MM_IFACE_SIGNAL_WAKEUP     = 1,
 } uct_mm_iface_conn_signal_t;
 
 
+/**
+ * Wakeup state of the receiver, in the FIFO control area.
+ */
+enum {
+    UCT_MM_FIFO_CTL_WAKEUP_ENABLED = UCS_BIT(0), /* Receiver has a wakeup handle */
+    UCT_MM_FIFO_CTL_WAKEUP_ARMED   = UCS_BIT(1)  /* Receiver is going to sleep, the
+                                                    next sender has to signal it */
+};
+
+
 typedef struct uct_mm_iface_config {
     uct_iface_config_t       super;
     unsigned                 fifo_size;            /* Size of the receive FIFO */
     double                   release_fifo_factor;
+    unsigned                 rx_max_poll;          /* Max FIFO elements per poll */
+    unsigned                 fifo_reserve;         /* FIFO elements to reserve at once */
     ucs_ternary_value_t      hugetlb_mode;         /* Enable using huge pages for */
                                                    /* shared memory buffers */
     uct_iface_mpool_config_t mp;
@@ -48,15 +62,34 @@ typedef struct uct_mm_iface_config {
 struct uct_mm_fifo_ctl {
     /* 1st cacheline */
     volatile uint64_t  head;       /* where to write next */
+    volatile uint32_t  wakeup_flags;     /* UCT_MM_FIFO_CTL_WAKEUP_xx */
     socklen_t          signal_addrlen;   /* address length of signaling socket */
     struct sockaddr_un signal_sockaddr;  /* address of signaling socket */
-    UCS_CACHELINE_PADDING(uint64_t, socklen_t, struct sockaddr_un);
+    socklen_t          wakeup_addrlen;   /* address length of wakeup socket */
+    struct sockaddr_un wakeup_sockaddr;  /* address of wakeup socket */
+    UCS_CACHELINE_PADDING(uint64_t, uint32_t, socklen_t, struct sockaddr_un,
+                          socklen_t, struct sockaddr_un);
 
     /* 2nd cacheline */
     volatile uint64_t  tail;       /* how much was read */
 } UCS_S_PACKED;
 
 
+/*
+ * Pointer to the wakeup flags, for atomic operations. The FIFO control area is
+ * cache line aligned and the flags follow the 64-bit head, so the pointer is
+ * aligned even though the structure is packed.
+ */
+static UCS_F_ALWAYS_INLINE volatile uint32_t*
+uct_mm_fifo_ctl_wakeup_flags(uct_mm_fifo_ctl_t *ctl)
+{
+    UCS_STATIC_ASSERT(ucs_offsetof(uct_mm_fifo_ctl_t, wakeup_flags) %
+                      sizeof(uint32_t) == 0);
+    return (volatile uint32_t*)((char*)ctl +
+                                ucs_offsetof(uct_mm_fifo_ctl_t, wakeup_flags));
+}
+
+
 struct uct_mm_iface {
     uct_base_iface_t        super;
 
@@ -83,9 +116,17 @@ struct uct_mm_iface {
     uct_mm_recv_desc_t      *last_recv_desc;    /* next receive descriptor to use */
 
     int                     signal_fd;        /* Unix socket for receiving remote signal */
+    int                     wakeup_fd;        /* Unix socket for receiving wakeup
+                                                 signals from remote senders */
+    uint64_t                wakeup_read_index;/* read_index when arm has last
+                                                 found new FIFO elements */
+    uint64_t                wakeup_end_index; /* end of the FIFO elements which
+                                                 arm has already reported */
 
     size_t                  rx_headroom;
     ucs_arbiter_t           arbiter;
+    ucs_list_link_t         reserved_eps;     /* endpoints holding reserved elements */
+                                              /* in remote FIFOs */
     const char              *path;            /* path to the backing file (for 'posix') */
 
     uct_mm_fifo_ctl_t       dummy_fifo_ctl;   /* a dummy fifo_ctl to be used until
@@ -95,6 +136,9 @@ struct uct_mm_iface {
         unsigned fifo_size;
         unsigned fifo_elem_size;
         unsigned seg_size;                    /* size of the receive descriptor (for payload)*/
+        unsigned rx_max_poll;                 /* max FIFO elements to read per progress */
+        unsigned fifo_reserve;                /* remote FIFO elements to reserve with */
+                                              /* one atomic operation */
     } config;
 };
 
@@ -167,7 +211,7 @@ static inline void uct_mm_set_fifo_elems_ptr(void *mem_region, void **fifo_elems
 void uct_mm_iface_release_am_desc(uct_iface_t *tl_iface, void *desc);
 ucs_status_t uct_mm_flush();
 
-void uct_mm_iface_progress(void *arg);
+unsigned uct_mm_iface_progress(void *arg);
 
 extern uct_tl_component_t uct_mm_tl;
 
@@ -7,6 +7,35 @@
 
 #include "mm_md.h"
 
+#include <ucs/type/spinlock.h>
+
+
+#define UCT_MM_RKEY_CACHE_SIZE    64
+
+
+/*
+ * Attached remote segment, shared by all users of the same remote key
+ */
+typedef struct uct_mm_rkey_cache_entry {
+    uct_mm_remote_seg_t  seg;        /* Attached segment */
+    uct_md_component_t   *mdc;       /* Mapper component, NULL if slot is empty */
+    uintptr_t            owner_ptr;  /* Segment address in the owner process */
+    unsigned             refcount;   /* Number of unpacked remote keys */
+} uct_mm_rkey_cache_entry_t;
+
+
+/*
+ * Cache of attached remote segments, indexed by mmid. A segment stays
+ * attached when its last remote key is released, and is detached when
+ * another segment needs the slot, when the last mm memory domain is closed,
+ * or when the library is unloaded.
+ */
+static struct {
+    ucs_spinlock_t             lock;
+    unsigned                   md_count;  /* Number of open mm memory domains */
+    uct_mm_rkey_cache_entry_t  entries[UCT_MM_RKEY_CACHE_SIZE];
+} uct_mm_rkey_cache;
+
 ucs_config_field_t uct_mm_md_config_table[] = {
   {"", "", NULL,
    ucs_offsetof(uct_mm_md_config_t, super), UCS_CONFIG_TYPE_TABLE(uct_md_config_table)},
@@ -66,6 +95,24 @@ ucs_status_t uct_mm_mem_free(uct_md_h md, uct_mem_h memh)
     return UCS_OK;
 }
 
+static ucs_status_t uct_mm_mem_reg_internal(uct_md_h md, void *address,
+                                            size_t length, uct_mm_seg_t *seg)
+{
+    ucs_status_t status;
+
+    status = uct_mm_md_mapper_ops(md)->reg(address, length, &seg->mmid);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    seg->length  = length;
+    seg->address = address;
+
+    ucs_debug("mm registered address %p length %zu mmid %"PRIu64,
+              address, length, seg->mmid);
+    return UCS_OK;
+}
+
 ucs_status_t uct_mm_mem_reg(uct_md_h md, void *address, size_t length,
                             unsigned flags, uct_mem_h *memh_p)
 {
@@ -78,19 +125,13 @@ ucs_status_t uct_mm_mem_reg(uct_md_h md, void *address, size_t length,
         return UCS_ERR_NO_MEMORY;
     }
 
-    status = uct_mm_md_mapper_ops(md)->reg(address, length, 
-                                           &seg->mmid);
+    status = uct_mm_mem_reg_internal(md, address, length, seg);
     if (status != UCS_OK) {
         ucs_free(seg);
         return status;
     }
 
-    seg->length  = length;
-    seg->address = address;
-    *memh_p      = seg;
-
-    ucs_debug("mm registered address %p length %zu mmid %"PRIu64,
-              address, length, seg->mmid);
+    *memh_p = seg;
     return UCS_OK;
 }
 
@@ -108,16 +149,87 @@ ucs_status_t uct_mm_mem_dereg(uct_md_h md, uct_mem_h memh)
     return UCS_OK;
 }
 
+static ucs_status_t uct_mm_mem_rcache_reg(uct_md_h md, void *address,
+                                          size_t length, unsigned flags,
+                                          uct_mem_h *memh_p)
+{
+    uct_mm_md_t *mm_md = ucs_derived_of(md, uct_mm_md_t);
+    ucs_rcache_region_t *rregion;
+    ucs_status_t status;
+
+    status = ucs_rcache_get(mm_md->rcache, address, length,
+                            PROT_READ|PROT_WRITE, NULL, &rregion);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    ucs_assert(rregion->refcount > 0);
+    *memh_p = &ucs_derived_of(rregion, uct_mm_rcache_region_t)->seg;
+    return UCS_OK;
+}
+
+static ucs_status_t uct_mm_mem_rcache_dereg(uct_md_h md, uct_mem_h memh)
+{
+    uct_mm_md_t *mm_md = ucs_derived_of(md, uct_mm_md_t);
+    uct_mm_rcache_region_t *region = ucs_container_of(memh,
+                                                      uct_mm_rcache_region_t,
+                                                      seg);
+
+    ucs_rcache_region_put(mm_md->rcache, &region->super);
+    return UCS_OK;
+}
+
+static ucs_status_t uct_mm_rcache_mem_reg_cb(void *context, ucs_rcache_t *rcache,
+                                             void *arg, ucs_rcache_region_t *rregion)
+{
+    uct_mm_rcache_region_t *region = ucs_derived_of(rregion,
+                                                    uct_mm_rcache_region_t);
+    uct_mm_md_t *mm_md = context;
+
+    return uct_mm_mem_reg_internal(&mm_md->super,
+                                   (void*)region->super.super.start,
+                                   region->super.super.end -
+                                   region->super.super.start,
+                                   &region->seg);
+}
+
+static void uct_mm_rcache_mem_dereg_cb(void *context, ucs_rcache_t *rcache,
+                                       ucs_rcache_region_t *rregion)
+{
+    uct_mm_rcache_region_t *region = ucs_derived_of(rregion,
+                                                    uct_mm_rcache_region_t);
+    uct_mm_md_t *mm_md = context;
+
+    (void)uct_mm_md_mapper_ops(&mm_md->super)->dereg(region->seg.mmid);
+}
+
+static void uct_mm_rcache_dump_region_cb(void *context, ucs_rcache_t *rcache,
+                                         ucs_rcache_region_t *rregion, char *buf,
+                                         size_t max)
+{
+    uct_mm_rcache_region_t *region = ucs_derived_of(rregion,
+                                                    uct_mm_rcache_region_t);
+
+    snprintf(buf, max, "mmid %"PRIu64, region->seg.mmid);
+}
+
+static ucs_rcache_ops_t uct_mm_rcache_ops = {
+    .mem_reg     = uct_mm_rcache_mem_reg_cb,
+    .mem_dereg   = uct_mm_rcache_mem_dereg_cb,
+    .dump_region = uct_mm_rcache_dump_region_cb
+};
+
 ucs_status_t uct_mm_md_query(uct_md_h md, uct_md_attr_t *md_attr)
 {
+    uct_mm_md_t *mm_md = ucs_derived_of(md, uct_mm_md_t);
+
     md_attr->cap.flags     = 0;
     if (uct_mm_md_mapper_ops(md)->alloc != NULL) {
         md_attr->cap.flags |= UCT_MD_FLAG_ALLOC;
     }
     if (uct_mm_md_mapper_ops(md)->reg != NULL) {
         md_attr->cap.flags |= UCT_MD_FLAG_REG;
-        md_attr->reg_cost.overhead = 1000.0e-9;
-        md_attr->reg_cost.growth   = 0.007e-9;
+        md_attr->reg_cost   = mm_md->reg_cost;
     }
     md_attr->cap.flags        |= UCT_MD_FLAG_NEED_RKEY;
     md_attr->cap.max_alloc    = ULONG_MAX;
@@ -146,17 +258,131 @@ ucs_status_t uct_mm_mkey_pack(uct_md_h md, uct_mem_h memh, void *rkey_buffer)
     return UCS_OK;
 }
 
+/* must be called with the cache lock held */
+static void uct_mm_rkey_cache_entry_detach(uct_mm_rkey_cache_entry_t *entry)
+{
+    ucs_status_t status;
+
+    if (entry->mdc == NULL) {
+        return;
+    }
+
+    ucs_trace("mm rkey cache: detaching mmid %"PRIu64" address %p",
+              entry->seg.mmid, entry->seg.address);
+    status = uct_mm_mdc_mapper_ops(entry->mdc)->detach(&entry->seg);
+    if (status != UCS_OK) {
+        ucs_warn("failed to detach cached mm segment mmid %"PRIu64,
+                 entry->seg.mmid);
+    }
+    entry->mdc = NULL;
+}
+
+/* Detach all cached segments which are not used by any remote key */
+static void uct_mm_rkey_cache_purge()
+{
+    uct_mm_rkey_cache_entry_t *entry;
+
+    ucs_spin_lock(&uct_mm_rkey_cache.lock);
+    for (entry = uct_mm_rkey_cache.entries;
+         entry < uct_mm_rkey_cache.entries + UCT_MM_RKEY_CACHE_SIZE; ++entry) {
+        if (entry->refcount == 0) {
+            uct_mm_rkey_cache_entry_detach(entry);
+        } else {
+            ucs_debug("mm rkey cache: mmid %"PRIu64" is still in use",
+                      entry->seg.mmid);
+        }
+    }
+    ucs_spin_unlock(&uct_mm_rkey_cache.lock);
+}
+
+static uct_mm_rkey_cache_entry_t *
+uct_mm_rkey_cache_entry_get(uct_md_component_t *mdc,
+                            const uct_mm_packed_rkey_t *rkey)
+{
+    uct_mm_rkey_cache_entry_t *entry;
+    ucs_status_t status;
+
+    entry = &uct_mm_rkey_cache.entries[rkey->mmid % UCT_MM_RKEY_CACHE_SIZE];
+
+    ucs_spin_lock(&uct_mm_rkey_cache.lock);
+
+    if ((entry->mdc == mdc) && (entry->seg.mmid == rkey->mmid) &&
+        (entry->owner_ptr == rkey->owner_ptr) &&
+        (entry->seg.length == rkey->length))
+    {
+        ++entry->refcount;
+        goto out;
+    }
+
+    if (entry->refcount > 0) {
+        /* the slot is used by another remote segment */
+        entry = NULL;
+        goto out;
+    }
+
+    uct_mm_rkey_cache_entry_detach(entry);
+
+    status = uct_mm_mdc_mapper_ops(mdc)->attach(rkey->mmid, rkey->length,
+                                                (void *)rkey->owner_ptr,
+                                                &entry->seg.address,
+                                                &entry->seg.cookie,
+                                                rkey->path);
+    if (status != UCS_OK) {
+        entry = NULL;
+        goto out;
+    }
+
+    entry->mdc        = mdc;
+    entry->owner_ptr  = rkey->owner_ptr;
+    entry->refcount   = 1;
+    entry->seg.mmid   = rkey->mmid;
+    entry->seg.length = rkey->length;
+
+out:
+    ucs_spin_unlock(&uct_mm_rkey_cache.lock);
+    return entry;
+}
+
+static int uct_mm_rkey_cache_entry_put(uct_mm_rkey_cache_entry_t *entry)
+{
+    if ((entry < uct_mm_rkey_cache.entries) ||
+        (entry >= uct_mm_rkey_cache.entries + UCT_MM_RKEY_CACHE_SIZE)) {
+        return 0;
+    }
+
+    /* keep the segment attached for the next user of the same remote key */
+    ucs_spin_lock(&uct_mm_rkey_cache.lock);
+    ucs_assert(entry->refcount > 0);
+    --entry->refcount;
+    ucs_spin_unlock(&uct_mm_rkey_cache.lock);
+    return 1;
+}
+
 ucs_status_t uct_mm_rkey_unpack(uct_md_component_t *mdc, const void *rkey_buffer,
                                 uct_rkey_t *rkey_p, void **handle_p)
 {
     /* user is responsible to free rkey_buffer */
     const uct_mm_packed_rkey_t *rkey = rkey_buffer;
+    uct_mm_rkey_cache_entry_t *entry;
     uct_mm_remote_seg_t *mm_desc;
     ucs_status_t status;
 
     ucs_trace("unpacking rkey: mmid %"PRIu64" owner_ptr %"PRIxPTR,
               rkey->mmid, rkey->owner_ptr);
 
+    /* Mappers which can register user memory create a new segment id for every
+     * registration, so the attached segment can be reused as long as the id
+     * is the same. It saves attach/detach system calls for every remote key
+     * of a user buffer, for example in the rendezvous protocol. */
+    if (uct_mm_mdc_mapper_ops(mdc)->reg != NULL) {
+        entry = uct_mm_rkey_cache_entry_get(mdc, rkey);
+        if (entry != NULL) {
+            *handle_p = entry;
+            *rkey_p   = (uintptr_t)entry->seg.address - rkey->owner_ptr;
+            return UCS_OK;
+        }
+    }
+
     mm_desc = ucs_malloc(sizeof(*mm_desc), "mm_desc");
     if (mm_desc == NULL) {
         return UCS_ERR_NO_RESOURCE;
@@ -186,6 +412,10 @@ ucs_status_t uct_mm_rkey_release(uct_md_component_t *mdc, uct_rkey_t rkey, void
     ucs_status_t status;
     uct_mm_remote_seg_t *mm_desc = handle;
 
+    if (uct_mm_rkey_cache_entry_put(handle)) {
+        return UCS_OK;
+    }
+
     status = uct_mm_mdc_mapper_ops(mdc)->detach(mm_desc);
     ucs_free(mm_desc);
     return status;
@@ -194,6 +424,18 @@ ucs_status_t uct_mm_rkey_release(uct_md_component_t *mdc, uct_rkey_t rkey, void
 static void uct_mm_md_close(uct_md_h md)
 {
     uct_mm_md_t *mm_md = ucs_derived_of(md, uct_mm_md_t);
+    unsigned md_count;
+
+    if (mm_md->rcache != NULL) {
+        ucs_rcache_destroy(mm_md->rcache);
+    }
+
+    ucs_spin_lock(&uct_mm_rkey_cache.lock);
+    md_count = --uct_mm_rkey_cache.md_count;
+    ucs_spin_unlock(&uct_mm_rkey_cache.lock);
+    if (md_count == 0) {
+        uct_mm_rkey_cache_purge();
+    }
 
     ucs_config_parser_release_opts(mm_md->config, md->component->md_config_table);
     ucs_free(mm_md->config);
@@ -210,9 +452,20 @@ uct_md_ops_t uct_mm_md_ops = {
     .mkey_pack    = uct_mm_mkey_pack,
 };
 
+static uct_md_ops_t uct_mm_md_rcache_ops = {
+    .close        = uct_mm_md_close,
+    .query        = uct_mm_md_query,
+    .mem_alloc    = uct_mm_mem_alloc,
+    .mem_free     = uct_mm_mem_free,
+    .mem_reg      = uct_mm_mem_rcache_reg,
+    .mem_dereg    = uct_mm_mem_rcache_dereg,
+    .mkey_pack    = uct_mm_mkey_pack,
+};
+
 ucs_status_t uct_mm_md_open(const char *md_name, const uct_md_config_t *md_config,
                             uct_md_h *md_p, uct_md_component_t *mdc)
 {
+    ucs_rcache_params_t rcache_params;
     uct_mm_md_t *mm_md;
     ucs_status_t status;
 
@@ -237,12 +490,41 @@ ucs_status_t uct_mm_md_open(const char *md_name, const uct_md_config_t *md_confi
         goto err_free_mm_md_config;
     }
 
-    mm_md->super.ops = &uct_mm_md_ops;
-    mm_md->super.component = mdc;
+    mm_md->super.ops          = &uct_mm_md_ops;
+    mm_md->super.component    = mdc;
+    mm_md->rcache             = NULL;
+    mm_md->reg_cost.overhead  = 1000.0e-9;
+    mm_md->reg_cost.growth    = 0.007e-9;
+
+    /* Mappers which can register user memory (xpmem) make a segment with a
+     * system call on every registration, so cache the registered regions */
+    if (uct_mm_mdc_mapper_ops(mdc)->reg != NULL) {
+        rcache_params.region_struct_size = sizeof(uct_mm_rcache_region_t);
+        rcache_params.context            = mm_md;
+        rcache_params.ops                = &uct_mm_rcache_ops;
+        status = uct_md_rcache_create(&mm_md->config->rcache, &rcache_params,
+                                      mdc->name UCS_STATS_ARG(NULL),
+                                      &mm_md->rcache);
+        if (status != UCS_OK) {
+            goto err_release_config;
+        }
+
+        if (mm_md->rcache != NULL) {
+            mm_md->super.ops         = &uct_mm_md_rcache_ops;
+            mm_md->reg_cost.overhead = mm_md->config->rcache.overhead;
+            mm_md->reg_cost.growth   = 0; /* It's close enough to 0 */
+        }
+    }
+
+    ucs_spin_lock(&uct_mm_rkey_cache.lock);
+    ++uct_mm_rkey_cache.md_count;
+    ucs_spin_unlock(&uct_mm_rkey_cache.lock);
 
     *md_p = &mm_md->super;
     return UCS_OK;
 
+err_release_config:
+    ucs_config_parser_release_opts(mm_md->config, mdc->md_config_table);
 err_free_mm_md_config:
     ucs_free(mm_md->config);
 err_free_mm_md:
@@ -250,3 +532,12 @@ err_free_mm_md:
 err:
     return status;
 }
+
+UCS_STATIC_INIT {
+    ucs_spinlock_init(&uct_mm_rkey_cache.lock);
+}
+
+UCS_STATIC_CLEANUP {
+    uct_mm_rkey_cache_purge();
+    ucs_spinlock_destroy(&uct_mm_rkey_cache.lock);
+}
@@ -132,12 +132,23 @@ typedef struct uct_mm_packed_rkey {
 } uct_mm_packed_rkey_t;
 
 
+/**
+ * Memory region in the registration cache
+ */
+typedef struct uct_mm_rcache_region {
+    ucs_rcache_region_t super;
+    uct_mm_seg_t        seg;       /* Exposed to the user as the memh */
+} uct_mm_rcache_region_t;
+
+
 /**
  * MM MD
  */
 typedef struct uct_mm_md {
-    uct_md_t           super;
-    uct_mm_md_config_t *config;
+    uct_md_t            super;
+    uct_mm_md_config_t  *config;
+    ucs_rcache_t        *rcache;   /* Registration cache (can be NULL) */
+    uct_linear_growth_t reg_cost;  /* Memory registration cost */
 } uct_mm_md_t;
 
 
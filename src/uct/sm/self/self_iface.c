@@ -47,7 +47,8 @@ static ucs_status_t uct_self_iface_query(uct_iface_h iface, uct_iface_attr_t *at
                                    UCT_IFACE_FLAG_ATOMIC_CSWAP32   |
                                    UCT_IFACE_FLAG_ATOMIC_CPU       |
                                    UCT_IFACE_FLAG_PENDING          |
-                                   UCT_IFACE_FLAG_AM_CB_SYNC;
+                                   UCT_IFACE_FLAG_AM_CB_SYNC       |
+                                   UCT_IFACE_FLAG_WAKEUP;
 
     attr->cap.put.max_short       = UINT_MAX;
     attr->cap.put.max_bcopy       = SIZE_MAX;
@@ -117,6 +118,49 @@ static void uct_self_iface_release_am_desc(uct_iface_t *tl_iface, void *desc)
     ucs_mpool_put(self_desc);
 }
 
+static ucs_status_t uct_self_iface_wakeup_open(uct_iface_h tl_iface,
+                                               unsigned events,
+                                               uct_wakeup_h wakeup)
+{
+    uct_self_iface_t *iface = ucs_derived_of(tl_iface, uct_self_iface_t);
+
+    wakeup->fd = iface->wakeup_pipe[0];
+    return UCS_OK;
+}
+
+static ucs_status_t uct_self_iface_wakeup_arm(uct_wakeup_h wakeup)
+{
+    uct_self_iface_t *iface = ucs_derived_of(wakeup->iface, uct_self_iface_t);
+    int signaled = 0;
+    char buf;
+
+    /* Messages are delivered to the handler from the send call, so only an
+     * explicit signal can be pending */
+    while (read(iface->wakeup_pipe[0], &buf, 1) == 1) {
+        signaled = 1;
+    }
+
+    if (errno != EAGAIN) {
+        ucs_error("read from self wakeup pipe failed: %m");
+        return UCS_ERR_IO_ERROR;
+    }
+
+    return signaled ? UCS_ERR_BUSY : UCS_OK;
+}
+
+static ucs_status_t uct_self_iface_wakeup_signal(uct_wakeup_h wakeup)
+{
+    uct_self_iface_t *iface = ucs_derived_of(wakeup->iface, uct_self_iface_t);
+    char buf = 0;
+
+    if ((write(iface->wakeup_pipe[1], &buf, 1) < 0) && (errno != EAGAIN)) {
+        ucs_error("write to self wakeup pipe failed: %m");
+        return UCS_ERR_IO_ERROR;
+    }
+
+    return UCS_OK;
+}
+
 static UCS_CLASS_DEFINE_DELETE_FUNC(uct_self_iface_t, uct_iface_t);
 
 static uct_iface_ops_t uct_self_iface_ops = {
@@ -143,6 +187,12 @@ static uct_iface_ops_t uct_self_iface_ops = {
     .ep_atomic_swap32         = uct_sm_ep_atomic_swap32,
     .ep_pending_add           = ucs_empty_function_return_busy,
     .ep_pending_purge         = ucs_empty_function,
+    .iface_wakeup_open        = uct_self_iface_wakeup_open,
+    .iface_wakeup_get_fd      = uct_base_iface_wakeup_get_fd,
+    .iface_wakeup_arm         = uct_self_iface_wakeup_arm,
+    .iface_wakeup_wait        = uct_base_iface_wakeup_wait,
+    .iface_wakeup_signal      = uct_self_iface_wakeup_signal,
+    .iface_wakeup_close       = (void*)ucs_empty_function,
 };
 
 static UCS_CLASS_INIT_FUNC(uct_self_iface_t, uct_md_h md, uct_worker_h worker,
@@ -195,10 +245,31 @@ static UCS_CLASS_INIT_FUNC(uct_self_iface_t, uct_md_h md, uct_worker_h worker,
         goto destroy_mpool;
     }
 
+    if (pipe(self->wakeup_pipe) != 0) {
+        ucs_error("Failed to create self wakeup pipe: %m");
+        status = UCS_ERR_IO_ERROR;
+        goto put_desc;
+    }
+
+    status = ucs_sys_fcntl_modfl(self->wakeup_pipe[0], O_NONBLOCK, 0);
+    if (status != UCS_OK) {
+        goto close_pipe;
+    }
+
+    status = ucs_sys_fcntl_modfl(self->wakeup_pipe[1], O_NONBLOCK, 0);
+    if (status != UCS_OK) {
+        goto close_pipe;
+    }
+
     ucs_debug("Created a loop-back iface. id=0x%lx, desc=%p, len=%u, tx_hdr=%lu",
               self->id, self->msg_cur_desc, self->data_length, self->rx_headroom);
     return UCS_OK;
 
+close_pipe:
+    close(self->wakeup_pipe[0]);
+    close(self->wakeup_pipe[1]);
+put_desc:
+    ucs_mpool_put(self->msg_cur_desc);
 destroy_mpool:
     ucs_mpool_cleanup(&self->msg_desc_mp, 1);
 err:
@@ -209,6 +280,9 @@ static UCS_CLASS_CLEANUP_FUNC(uct_self_iface_t)
 {
     ucs_trace_func("self=%p", self);
 
+    close(self->wakeup_pipe[0]);
+    close(self->wakeup_pipe[1]);
+
     if (self->msg_cur_desc) {
         ucs_mpool_put(self->msg_cur_desc);
     }
@@ -19,6 +19,7 @@ typedef struct uct_self_iface {
     unsigned              data_length;  /* Maximum size for payload */
     uct_am_recv_desc_t   *msg_cur_desc; /* Current message descriptor to use */
     ucs_mpool_t           msg_desc_mp;  /* Messages memory pool */
+    int                   wakeup_pipe[2]; /* Signaled by uct_wakeup_signal() */
 } UCS_V_ALIGNED(UCS_SYS_CACHE_LINE_SIZE) uct_self_iface_t;
 
 typedef struct uct_self_iface_config {
@@ -7,23 +7,72 @@
 #define UCT_TCP_MD_H
 
 #include <uct/base/uct_md.h>
+#include <ucs/datastruct/arbiter.h>
 #include <ucs/datastruct/khash.h>
+#include <ucs/datastruct/list.h>
+#include <ucs/datastruct/queue.h>
 #include <net/if.h>
+#include <sys/uio.h>
 
 #define UCT_TCP_NAME "tcp"
 
+#define UCT_TCP_MAX_EVENTS        32
+#define UCT_TCP_MAX_RX_BATCH      16
+#define UCT_TCP_MAX_IOV           16
+
+#if HAVE_DECL_MSG_ZEROCOPY && HAVE_DECL_SO_ZEROCOPY && \
+    HAVE_DECL_SO_EE_ORIGIN_ZEROCOPY
+#  define UCT_TCP_HAVE_ZEROCOPY   1
+#else
+#  define UCT_TCP_HAVE_ZEROCOPY   0
+#endif
+
 
 /** Hash of fd->rsock */
 typedef struct uct_tcp_recv_sock uct_tcp_recv_sock_t;
 KHASH_MAP_INIT_INT64(uct_tcp_fd_hash, uct_tcp_recv_sock_t*);
 
 
+/**
+ * TCP active message header, precedes every message on the stream
+ */
+typedef struct uct_tcp_am_hdr {
+    uint8_t                       am_id;          /* Active message id */
+    uint32_t                      length;         /* Length of the payload */
+} UCS_S_PACKED uct_tcp_am_hdr_t;
+
+
+/**
+ * Zero-copy send descriptor, followed by the message header. Released when
+ * the user buffers are not used by the kernel anymore.
+ */
+typedef struct uct_tcp_zcopy_desc {
+    ucs_queue_elem_t              queue;          /* Element in ep zcopy queue */
+    uct_completion_t              *comp;          /* User completion callback */
+    uint32_t                      sn;             /* Number of the last
+                                                     MSG_ZEROCOPY send call */
+} uct_tcp_zcopy_desc_t;
+
+
 /**
  * TCP endpoint
  */
 typedef struct uct_tcp_ep {
     uct_base_ep_t                 super;
     int                           fd;             /* Socket file descriptor */
+    void                          *buf;           /* TX buffer: header + payload */
+    struct iovec                  iov[UCT_TCP_MAX_IOV + 1]; /* Message being sent */
+    size_t                        iov_index;      /* First iov entry to send */
+    size_t                        iovcnt;         /* Number of iov entries */
+    size_t                        length;         /* How much data is left to send */
+    int                           send_flags;     /* Flags of current message */
+    int                           zcopy_enabled;  /* SO_ZEROCOPY is set */
+    uint32_t                      zcopy_sn;       /* Number of MSG_ZEROCOPY sends */
+    uct_tcp_zcopy_desc_t          *zcopy_desc;    /* Zcopy message being sent */
+    ucs_queue_head_t              zcopy_q;        /* Zcopy messages waiting for
+                                                     completion from the kernel */
+    ucs_arbiter_group_t           arb_group;      /* Pending operations */
+    ucs_list_link_t               list;           /* Element in iface TX list */
 } uct_tcp_ep_t;
 
 
@@ -32,15 +81,32 @@ typedef struct uct_tcp_ep {
  */
 typedef struct uct_tcp_iface {
     uct_base_iface_t              super;          /* Parent class */
-    ucs_mpool_t                   mp;             /* Memory pool for TX/RX buffers */
+    ucs_mpool_t                   mp;             /* Memory pool for TX buffers */
+    ucs_mpool_t                   rx_mp;          /* Memory pool for RX descriptors */
+    void                          *rx_desc;       /* Next receive descriptor to use */
+    int                           rx_backlog;     /* Some RX sockets may hold data
+                                                     not dispatched yet */
     int                           listen_fd;      /* Server socket */
+    int                           epfd;           /* Event poll set of RX sockets */
+    int                           wakeup_epfd;    /* Edge-triggered poll set of RX
+                                                     sockets, for wakeup */
     khash_t(uct_tcp_fd_hash)      fd_hash;        /* Hash table of all FDs */
+    ucs_arbiter_t                 arbiter;        /* Pending operations */
+    ucs_list_link_t               tx_list;        /* Endpoints with unsent data or
+                                                     uncompleted zcopy sends */
     char                          if_name[IFNAMSIZ];/* Network interface name */
 
     struct {
         struct sockaddr_in        ifaddr;         /* Network address */
         struct sockaddr_in        netmask;        /* Network address mask */
+        size_t                    max_short;      /* Maximal short size */
         size_t                    max_bcopy;      /* Maximal bcopy size */
+        size_t                    max_zcopy;      /* Maximal zcopy size */
+        size_t                    max_hdr;        /* Maximal zcopy header size */
+        size_t                    seg_size;       /* Maximal active message payload */
+        size_t                    zcopy_thresh;   /* Use MSG_ZEROCOPY from this size */
+        size_t                    rx_buf_size;    /* Size of socket RX buffer */
+        size_t                    rx_headroom;    /* User receive headroom */
         int                       prefer_default; /* prefer default gateway */
         ptrdiff_t                 am_hdr_offset;  /* offset to receive header */
         ptrdiff_t                 headroom_offset;/* offset to receive headroom */
@@ -59,14 +125,22 @@ typedef struct uct_tcp_iface_config {
     uct_iface_config_t            super;
     int                           prefer_default;
     unsigned                      backlog;
+    size_t                        seg_size;
+    size_t                        zcopy_thresh;
+    size_t                        rx_buf_size;
+    uct_iface_mpool_config_t      rx_mpool;
     int                           sockopt_nodelay;
 } uct_tcp_iface_config_t;
 
 
 /**
- * TCP receive socket wrapper/
+ * TCP receive socket wrapper
  */
 struct uct_tcp_recv_sock {
+    int                           fd;             /* Socket file descriptor */
+    void                          *buf;           /* Incoming stream data */
+    size_t                        offset;         /* Offset of next message */
+    size_t                        length;         /* How much data in buffer */
 };
 
 
@@ -93,6 +167,43 @@ ucs_status_t uct_tcp_iface_connection_accepted(uct_tcp_iface_t *iface, int fd);
 
 void uct_tcp_iface_recv_cleanup(uct_tcp_iface_t *iface);
 
+ucs_status_t uct_tcp_iface_wakeup_add_fd(uct_tcp_iface_t *iface, int fd);
+
+unsigned uct_tcp_iface_recv_progress(uct_tcp_iface_t *iface);
+
+unsigned uct_tcp_iface_progress(void *arg);
+
+void uct_tcp_iface_release_am_desc(uct_iface_t *tl_iface, void *desc);
+
+ucs_status_t uct_tcp_ep_am_short(uct_ep_h tl_ep, uint8_t am_id, uint64_t header,
+                                 const void *payload, unsigned length);
+
+ssize_t uct_tcp_ep_am_bcopy(uct_ep_h tl_ep, uint8_t am_id,
+                            uct_pack_callback_t pack_cb, void *arg);
+
+ucs_status_t uct_tcp_ep_am_zcopy(uct_ep_h tl_ep, uint8_t am_id, const void *header,
+                                 unsigned header_length, const uct_iov_t *iov,
+                                 size_t iovcnt, uct_completion_t *comp);
+
+ucs_status_t uct_tcp_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *req);
+
+ucs_status_t uct_tcp_ep_pending_add_prio(uct_ep_h tl_ep, uct_pending_req_t *req,
+                                         uct_pending_prio_t prio);
+
+void uct_tcp_ep_pending_purge(uct_ep_h tl_ep, uct_pending_purge_callback_t cb,
+                              void *arg);
+
+ucs_status_t uct_tcp_ep_flush(uct_ep_h tl_ep, unsigned flags,
+                              uct_completion_t *comp);
+
+ucs_status_t uct_tcp_ep_progress_tx(uct_tcp_ep_t *ep);
+
+unsigned uct_tcp_ep_progress(uct_tcp_ep_t *ep);
+
+ucs_arbiter_cb_result_t uct_tcp_ep_process_pending(ucs_arbiter_t *arbiter,
+                                                   ucs_arbiter_elem_t *elem,
+                                                   void *arg);
+
 UCS_CLASS_DECLARE_NEW_FUNC(uct_tcp_ep_t, uct_ep_t, uct_iface_t *,
                            const uct_device_addr_t *, const uct_iface_addr_t *);
 UCS_CLASS_DECLARE_DELETE_FUNC(uct_tcp_ep_t, uct_ep_t);
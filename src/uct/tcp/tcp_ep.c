@@ -6,6 +6,9 @@
 #include "tcp.h"
 
 #include <ucs/async/async.h>
+#if UCT_TCP_HAVE_ZEROCOPY
+#  include <linux/errqueue.h>
+#endif
 
 
 static UCS_CLASS_INIT_FUNC(uct_tcp_ep_t, uct_iface_t *tl_iface,
@@ -15,12 +18,33 @@ static UCS_CLASS_INIT_FUNC(uct_tcp_ep_t, uct_iface_t *tl_iface,
     uct_tcp_iface_t *iface = ucs_derived_of(tl_iface, uct_tcp_iface_t);
     struct sockaddr_in dest_addr;
     ucs_status_t status;
+#if UCT_TCP_HAVE_ZEROCOPY
+    int optval;
+#endif
 
     UCS_CLASS_CALL_SUPER_INIT(uct_base_ep_t, &iface->super)
 
+    self->buf = ucs_mpool_get(&iface->mp);
+    if (self->buf == NULL) {
+        ucs_error("failed to allocate TCP send buffer");
+        status = UCS_ERR_NO_MEMORY;
+        goto err;
+    }
+
+    self->iov_index     = 0;
+    self->iovcnt        = 0;
+    self->length        = 0;
+    self->send_flags    = 0;
+    self->zcopy_enabled = 0;
+    self->zcopy_sn      = 0;
+    self->zcopy_desc    = NULL;
+    ucs_queue_head_init(&self->zcopy_q);
+    ucs_arbiter_group_init(&self->arb_group);
+    ucs_list_head_init(&self->list);
+
     status = uct_tcp_socket_create(&self->fd);
     if (status != UCS_OK) {
-        goto err;
+        goto err_put_buf;
     }
 
     status = uct_tcp_iface_set_sockopt(iface, self->fd);
@@ -38,19 +62,66 @@ static UCS_CLASS_INIT_FUNC(uct_tcp_ep_t, uct_iface_t *tl_iface,
         goto err_close;
     }
 
+    /* Sends are never blocking, partially sent data is completed by progress */
+    status = ucs_sys_fcntl_modfl(self->fd, O_NONBLOCK, 0);
+    if (status != UCS_OK) {
+        goto err_close;
+    }
+
+#if UCT_TCP_HAVE_ZEROCOPY
+    if (iface->config.zcopy_thresh != UCS_CONFIG_MEMUNITS_INF) {
+        optval = 1;
+        if (setsockopt(self->fd, SOL_SOCKET, SO_ZEROCOPY, &optval,
+                       sizeof(optval)) < 0) {
+            ucs_debug("setsockopt(fd=%d, SO_ZEROCOPY) failed: %m", self->fd);
+        } else {
+            self->zcopy_enabled = 1;
+        }
+    }
+#endif
+
+    /* Register for send side progress */
+    uct_worker_progress_register(iface->super.worker, uct_tcp_iface_progress,
+                                 iface);
+
     ucs_debug("connected to %s:%d", inet_ntoa(dest_addr.sin_addr),
               ntohs(dest_addr.sin_port));
     return UCS_OK;
 
 err_close:
     close(self->fd);
+err_put_buf:
+    ucs_mpool_put(self->buf);
 err:
     return status;
 }
 
 static UCS_CLASS_CLEANUP_FUNC(uct_tcp_ep_t)
 {
+    uct_tcp_iface_t *iface = ucs_derived_of(self->super.super.iface,
+                                            uct_tcp_iface_t);
+    uct_tcp_zcopy_desc_t *desc;
+
     ucs_trace_func("self=%p", self);
+
+    uct_worker_progress_unregister(iface->super.worker, uct_tcp_iface_progress,
+                                   iface);
+    uct_tcp_ep_pending_purge(&self->super.super, NULL, NULL);
+
+    if (!ucs_list_is_empty(&self->list)) {
+        ucs_debug("tcp ep %p: dropping %zu unsent bytes", self, self->length);
+        ucs_list_del(&self->list);
+    }
+
+    if (self->zcopy_desc != NULL) {
+        ucs_mpool_put(self->zcopy_desc);
+    }
+
+    ucs_queue_for_each_extract(desc, &self->zcopy_q, queue, 1) {
+        ucs_mpool_put(desc);
+    }
+
+    ucs_mpool_put(self->buf);
     close(self->fd);
 }
 
@@ -58,3 +129,497 @@ UCS_CLASS_DEFINE(uct_tcp_ep_t, uct_base_ep_t);
 UCS_CLASS_DEFINE_NEW_FUNC(uct_tcp_ep_t, uct_ep_t, uct_iface_t *,
                           const uct_device_addr_t *, const uct_iface_addr_t *);
 UCS_CLASS_DEFINE_DELETE_FUNC(uct_tcp_ep_t, uct_ep_t);
+
+static inline int uct_tcp_ep_can_send(uct_tcp_ep_t *ep)
+{
+    return ep->length == 0;
+}
+
+static void uct_tcp_ep_update_tx_list(uct_tcp_ep_t *ep)
+{
+    uct_tcp_iface_t *iface = ucs_derived_of(ep->super.super.iface,
+                                            uct_tcp_iface_t);
+    int idle = (ep->length == 0) && ucs_queue_is_empty(&ep->zcopy_q);
+
+    if (idle && !ucs_list_is_empty(&ep->list)) {
+        ucs_list_del(&ep->list);
+        ucs_list_head_init(&ep->list);
+    } else if (!idle && ucs_list_is_empty(&ep->list)) {
+        /* Let the iface progress complete the send */
+        ucs_list_add_tail(&iface->tx_list, &ep->list);
+    }
+}
+
+static void uct_tcp_ep_zcopy_complete(uct_tcp_zcopy_desc_t *desc)
+{
+    uct_completion_t *comp = desc->comp;
+
+    ucs_mpool_put(desc);
+    if (comp != NULL) {
+        uct_invoke_completion(comp, UCS_OK);
+    }
+}
+
+/* The whole zcopy message was passed to the kernel. Returns UCS_OK if the
+ * user buffers can be reused now, or UCS_INPROGRESS if the kernel still holds
+ * them, in which case the completion is reported by the socket error queue. */
+static ucs_status_t uct_tcp_ep_zcopy_sent(uct_tcp_ep_t *ep,
+                                          uct_tcp_zcopy_desc_t *desc)
+{
+#if UCT_TCP_HAVE_ZEROCOPY
+    if (ep->send_flags & MSG_ZEROCOPY) {
+        desc->sn = ep->zcopy_sn - 1;
+        ucs_queue_push(&ep->zcopy_q, &desc->queue);
+        uct_tcp_ep_update_tx_list(ep);
+        return UCS_INPROGRESS;
+    }
+#endif
+    return UCS_OK;
+}
+
+/* Push as much of the current message as the socket would take. Returns
+ * UCS_OK if all of it was sent, UCS_ERR_NO_RESOURCE if some data is left. */
+ucs_status_t uct_tcp_ep_progress_tx(uct_tcp_ep_t *ep)
+{
+    uct_tcp_zcopy_desc_t *desc;
+    struct msghdr msg;
+    ssize_t ret;
+    size_t sent;
+
+    ucs_assert(ep->length > 0);
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov    = &ep->iov[ep->iov_index];
+    msg.msg_iovlen = ep->iovcnt - ep->iov_index;
+
+    ret = sendmsg(ep->fd, &msg, MSG_NOSIGNAL | ep->send_flags);
+    if (ucs_unlikely(ret < 0)) {
+        /* ENOBUFS means too many MSG_ZEROCOPY sends are not completed yet */
+        if ((errno != EAGAIN) && (errno != EINTR) && (errno != ENOBUFS)) {
+            ucs_error("sendmsg(fd=%d) failed: %m", ep->fd);
+            return UCS_ERR_IO_ERROR;
+        }
+        ret = 0;
+    } else if (ep->send_flags != 0) {
+        ++ep->zcopy_sn;
+    }
+
+    ep->length -= ret;
+    if (ucs_likely(ep->length == 0)) {
+        ep->iov_index = 0;
+        ep->iovcnt    = 0;
+        desc          = ep->zcopy_desc;
+        if (desc != NULL) {
+            ep->zcopy_desc = NULL;
+            if (uct_tcp_ep_zcopy_sent(ep, desc) == UCS_OK) {
+                uct_tcp_ep_zcopy_complete(desc);
+            }
+        }
+        uct_tcp_ep_update_tx_list(ep);
+        return UCS_OK;
+    }
+
+    /* Skip the fully sent entries, and advance the partially sent one */
+    sent = ret;
+    while (sent >= ep->iov[ep->iov_index].iov_len) {
+        sent -= ep->iov[ep->iov_index].iov_len;
+        ++ep->iov_index;
+    }
+    ep->iov[ep->iov_index].iov_base += sent;
+    ep->iov[ep->iov_index].iov_len  -= sent;
+
+    uct_tcp_ep_update_tx_list(ep);
+    return UCS_ERR_NO_RESOURCE;
+}
+
+/* Release zcopy descriptors whose data the kernel does not use anymore.
+ * Returns the number of completed descriptors. */
+static unsigned uct_tcp_ep_progress_zcopy(uct_tcp_ep_t *ep)
+{
+    unsigned count = 0;
+#if UCT_TCP_HAVE_ZEROCOPY
+    char control[CMSG_SPACE(sizeof(struct sock_extended_err))];
+    struct sock_extended_err *serr;
+    uct_tcp_zcopy_desc_t *desc;
+    struct cmsghdr *cmsg;
+    struct msghdr msg;
+    ssize_t ret;
+
+    for (;;) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control    = control;
+        msg.msg_controllen = sizeof(control);
+
+        ret = recvmsg(ep->fd, &msg, MSG_ERRQUEUE);
+        if (ret < 0) {
+            if ((errno != EAGAIN) && (errno != EINTR)) {
+                ucs_error("recvmsg(fd=%d, MSG_ERRQUEUE) failed: %m", ep->fd);
+            }
+            break;
+        }
+
+        cmsg = CMSG_FIRSTHDR(&msg);
+        if ((cmsg == NULL) || (cmsg->cmsg_level != SOL_IP) ||
+            (cmsg->cmsg_type != IP_RECVERR)) {
+            continue;
+        }
+
+        serr = (struct sock_extended_err*)CMSG_DATA(cmsg);
+        if ((serr->ee_errno != 0) ||
+            (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)) {
+            continue;
+        }
+
+        if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+            /* The kernel had to copy the data anyway (e.g. loopback), so
+             * pinning user pages only adds overhead */
+            ucs_debug("tcp ep %p: zero-copy send fell back to copy", ep);
+            ep->zcopy_enabled = 0;
+        }
+
+        /* Notifications of a TCP socket come in order, serr->ee_data is the
+         * last completed send call */
+        ucs_queue_for_each_extract(desc, &ep->zcopy_q, queue,
+                                   UCS_CIRCULAR_COMPARE32(desc->sn, <=,
+                                                          serr->ee_data)) {
+            uct_tcp_ep_zcopy_complete(desc);
+            ++count;
+        }
+    }
+#endif
+    return count;
+}
+
+unsigned uct_tcp_ep_progress(uct_tcp_ep_t *ep)
+{
+    unsigned count = 0;
+
+    /* a partially sent message which was completed counts as an event */
+    if ((ep->length > 0) && (uct_tcp_ep_progress_tx(ep) == UCS_OK)) {
+        ++count;
+    }
+
+    if (!ucs_queue_is_empty(&ep->zcopy_q)) {
+        count += uct_tcp_ep_progress_zcopy(ep);
+        uct_tcp_ep_update_tx_list(ep);
+    }
+
+    return count;
+}
+
+static UCS_F_ALWAYS_INLINE ucs_status_t
+uct_tcp_ep_check_tx_res(uct_tcp_ep_t *ep)
+{
+    if (!uct_tcp_ep_can_send(ep)) {
+        /* if pending isn't empty, don't send now to prevent out-of-order
+         * sending, otherwise try to complete the previous message */
+        if (!ucs_arbiter_group_is_empty(&ep->arb_group) ||
+            (uct_tcp_ep_progress_tx(ep) != UCS_OK)) {
+            UCS_STATS_UPDATE_COUNTER(ep->super.stats, UCT_EP_STAT_NO_RES, 1);
+            return UCS_ERR_NO_RESOURCE;
+        }
+    }
+    return UCS_OK;
+}
+
+/* Reserve the TX buffer for a new message, if the previous one is done */
+static UCS_F_ALWAYS_INLINE uct_tcp_am_hdr_t*
+uct_tcp_ep_am_prepare(uct_tcp_ep_t *ep, uint8_t am_id)
+{
+    uct_tcp_am_hdr_t *hdr;
+
+    if (uct_tcp_ep_check_tx_res(ep) != UCS_OK) {
+        return NULL;
+    }
+
+    hdr        = ep->buf;
+    hdr->am_id = am_id;
+    return hdr;
+}
+
+static UCS_F_ALWAYS_INLINE ucs_status_t
+uct_tcp_ep_am_send(uct_tcp_ep_t *ep, uct_tcp_am_hdr_t *hdr)
+{
+    ucs_status_t status;
+
+    ep->iov[0].iov_base = hdr;
+    ep->iov[0].iov_len  = sizeof(*hdr) + hdr->length;
+    ep->iovcnt          = 1;
+    ep->length          = ep->iov[0].iov_len;
+    ep->send_flags      = 0;
+
+    status = uct_tcp_ep_progress_tx(ep);
+    if (ucs_likely(status != UCS_ERR_IO_ERROR)) {
+        /* The message is owned by the transport now, even if not all of it
+         * was sent yet */
+        return UCS_OK;
+    }
+
+    ep->length = 0;
+    ep->iovcnt = 0;
+    return status;
+}
+
+ucs_status_t uct_tcp_ep_am_short(uct_ep_h tl_ep, uint8_t am_id, uint64_t header,
+                                 const void *payload, unsigned length)
+{
+    uct_tcp_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_tcp_iface_t);
+    uct_tcp_ep_t *ep = ucs_derived_of(tl_ep, uct_tcp_ep_t);
+    uct_tcp_am_hdr_t *hdr;
+    ucs_status_t status;
+
+    UCT_CHECK_AM_ID(am_id);
+    UCT_CHECK_LENGTH(length + sizeof(header), iface->config.max_short,
+                     "am_short");
+
+    hdr = uct_tcp_ep_am_prepare(ep, am_id);
+    if (hdr == NULL) {
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    *(uint64_t*)(hdr + 1) = header;
+    memcpy((void*)(hdr + 1) + sizeof(header), payload, length);
+    hdr->length = sizeof(header) + length;
+
+    status = uct_tcp_ep_am_send(ep, hdr);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    uct_iface_trace_am(&iface->super, UCT_AM_TRACE_TYPE_SEND, am_id,
+                       hdr + 1, hdr->length, "TX: AM_SHORT");
+    UCT_TL_EP_STAT_OP(&ep->super, AM, SHORT, hdr->length);
+    return UCS_OK;
+}
+
+ssize_t uct_tcp_ep_am_bcopy(uct_ep_h tl_ep, uint8_t am_id,
+                            uct_pack_callback_t pack_cb, void *arg)
+{
+    uct_tcp_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_tcp_iface_t);
+    uct_tcp_ep_t *ep = ucs_derived_of(tl_ep, uct_tcp_ep_t);
+    uct_tcp_am_hdr_t *hdr;
+    ucs_status_t status;
+    size_t length;
+
+    UCT_CHECK_AM_ID(am_id);
+
+    hdr = uct_tcp_ep_am_prepare(ep, am_id);
+    if (hdr == NULL) {
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    length      = pack_cb(hdr + 1, arg);
+    ucs_assert(length <= iface->config.max_bcopy);
+    hdr->length = length;
+
+    status = uct_tcp_ep_am_send(ep, hdr);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    uct_iface_trace_am(&iface->super, UCT_AM_TRACE_TYPE_SEND, am_id,
+                       hdr + 1, length, "TX: AM_BCOPY");
+    UCT_TL_EP_STAT_OP(&ep->super, AM, BCOPY, length);
+    return length;
+}
+
+ucs_status_t uct_tcp_ep_am_zcopy(uct_ep_h tl_ep, uint8_t am_id, const void *header,
+                                 unsigned header_length, const uct_iov_t *iov,
+                                 size_t iovcnt, uct_completion_t *comp)
+{
+    uct_tcp_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_tcp_iface_t);
+    uct_tcp_ep_t *ep = ucs_derived_of(tl_ep, uct_tcp_ep_t);
+    uct_tcp_zcopy_desc_t *desc;
+    uct_tcp_am_hdr_t *hdr;
+    ucs_status_t status;
+    size_t iov_it;
+
+    UCT_CHECK_IOV_SIZE(iovcnt, (size_t)UCT_TCP_MAX_IOV, "uct_tcp_ep_am_zcopy");
+    UCT_CHECK_LENGTH(header_length, iface->config.max_hdr, "am_zcopy header");
+    UCT_CHECK_LENGTH(header_length + uct_iov_total_length(iov, iovcnt),
+                     iface->config.max_zcopy, "am_zcopy");
+
+    UCT_CHECK_AM_ID(am_id);
+
+    status = uct_tcp_ep_check_tx_res(ep);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    /* The header is kept in a descriptor, since the TX buffer may be reused
+     * while the kernel still references the zero-copy message */
+    desc = ucs_mpool_get(&iface->mp);
+    if (desc == NULL) {
+        UCS_STATS_UPDATE_COUNTER(ep->super.stats, UCT_EP_STAT_NO_RES, 1);
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    desc->comp  = comp;
+    hdr         = (uct_tcp_am_hdr_t*)(desc + 1);
+    hdr->am_id  = am_id;
+    hdr->length = header_length;
+    memcpy(hdr + 1, header, header_length);
+
+    ep->iov[0].iov_base = hdr;
+    ep->iov[0].iov_len  = sizeof(*hdr) + header_length;
+    ep->iovcnt          = 1;
+    for (iov_it = 0; iov_it < iovcnt; ++iov_it) {
+        if (uct_iov_get_length(&iov[iov_it]) == 0) {
+            continue;
+        }
+        ep->iov[ep->iovcnt].iov_base = iov[iov_it].buffer;
+        ep->iov[ep->iovcnt].iov_len  = uct_iov_get_length(&iov[iov_it]);
+        hdr->length                 += ep->iov[ep->iovcnt].iov_len;
+        ++ep->iovcnt;
+    }
+
+    ep->length     = sizeof(*hdr) + hdr->length;
+    ep->send_flags = 0;
+#if UCT_TCP_HAVE_ZEROCOPY
+    if (ep->zcopy_enabled && (hdr->length >= iface->config.zcopy_thresh)) {
+        ep->send_flags = MSG_ZEROCOPY;
+    }
+#endif
+
+    uct_iface_trace_am(&iface->super, UCT_AM_TRACE_TYPE_SEND, am_id,
+                       header, header_length, "TX: AM_ZCOPY");
+    UCT_TL_EP_STAT_OP(&ep->super, AM, ZCOPY, hdr->length);
+
+    status = uct_tcp_ep_progress_tx(ep);
+    if (ucs_likely(status == UCS_OK)) {
+        status = uct_tcp_ep_zcopy_sent(ep, desc);
+        if (status == UCS_OK) {
+            ucs_mpool_put(desc);
+        }
+        return status;
+    } else if (status == UCS_ERR_NO_RESOURCE) {
+        /* The rest of the message is sent by progress, which also invokes
+         * the user completion */
+        ep->zcopy_desc = desc;
+        return UCS_INPROGRESS;
+    }
+
+    ep->length = 0;
+    ep->iovcnt = 0;
+    ucs_mpool_put(desc);
+    return status;
+}
+
+ucs_status_t uct_tcp_ep_pending_add_prio(uct_ep_h tl_ep, uct_pending_req_t *req,
+                                         uct_pending_prio_t prio)
+{
+    uct_tcp_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_tcp_iface_t);
+    uct_tcp_ep_t *ep = ucs_derived_of(tl_ep, uct_tcp_ep_t);
+
+    if (uct_tcp_ep_can_send(ep)) {
+        return UCS_ERR_BUSY;
+    }
+
+    UCS_STATIC_ASSERT(sizeof(ucs_arbiter_elem_t) <= UCT_PENDING_REQ_PRIV_LEN);
+
+    ucs_arbiter_elem_init((ucs_arbiter_elem_t *)req->priv);
+    ucs_arbiter_group_push_elem_prio(&ep->arb_group, (ucs_arbiter_elem_t*)req->priv,
+                                     uct_pending_arb_prio(prio));
+    ucs_arbiter_group_schedule(&iface->arbiter, &ep->arb_group);
+    return UCS_OK;
+}
+
+ucs_status_t uct_tcp_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *req)
+{
+    return uct_tcp_ep_pending_add_prio(tl_ep, req, UCT_PENDING_PRIO_BULK);
+}
+
+ucs_arbiter_cb_result_t uct_tcp_ep_process_pending(ucs_arbiter_t *arbiter,
+                                                   ucs_arbiter_elem_t *elem,
+                                                   void *arg)
+{
+    uct_pending_req_t *req = ucs_container_of(elem, uct_pending_req_t, priv);
+    uct_tcp_ep_t *ep = ucs_container_of(ucs_arbiter_elem_group(elem),
+                                        uct_tcp_ep_t, arb_group);
+    unsigned *count = arg;
+    ucs_status_t status;
+
+    if (!uct_tcp_ep_can_send(ep) &&
+        (uct_tcp_ep_progress_tx(ep) != UCS_OK)) {
+        return UCS_ARBITER_CB_RESULT_RESCHED_GROUP;
+    }
+
+    status = req->func(req);
+    ucs_trace_data("progress pending request %p returned %s", req,
+                   ucs_status_string(status));
+
+    if (status == UCS_OK) {
+        ++(*count);
+        return UCS_ARBITER_CB_RESULT_REMOVE_ELEM;
+    } else if (status == UCS_INPROGRESS) {
+        ++(*count);
+        return UCS_ARBITER_CB_RESULT_NEXT_GROUP;
+    } else {
+        return UCS_ARBITER_CB_RESULT_RESCHED_GROUP;
+    }
+}
+
+static ucs_arbiter_cb_result_t uct_tcp_ep_arbiter_purge_cb(ucs_arbiter_t *arbiter,
+                                                           ucs_arbiter_elem_t *elem,
+                                                           void *arg)
+{
+    uct_pending_req_t *req = ucs_container_of(elem, uct_pending_req_t, priv);
+    uct_purge_cb_args_t *cb_args    = arg;
+    uct_pending_purge_callback_t cb = cb_args->cb;
+    uct_tcp_ep_t *ep = ucs_container_of(ucs_arbiter_elem_group(elem),
+                                        uct_tcp_ep_t, arb_group);
+
+    if (cb != NULL) {
+        cb(req, cb_args->arg);
+    } else {
+        ucs_warn("ep=%p canceling user pending request %p", ep, req);
+    }
+    return UCS_ARBITER_CB_RESULT_REMOVE_ELEM;
+}
+
+void uct_tcp_ep_pending_purge(uct_ep_h tl_ep, uct_pending_purge_callback_t cb,
+                              void *arg)
+{
+    uct_tcp_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_tcp_iface_t);
+    uct_tcp_ep_t *ep = ucs_derived_of(tl_ep, uct_tcp_ep_t);
+    uct_purge_cb_args_t args = {cb, arg};
+
+    ucs_arbiter_group_purge(&iface->arbiter, &ep->arb_group,
+                            uct_tcp_ep_arbiter_purge_cb, &args);
+}
+
+ucs_status_t uct_tcp_ep_flush(uct_ep_h tl_ep, unsigned flags,
+                              uct_completion_t *comp)
+{
+    uct_tcp_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_tcp_iface_t);
+    uct_tcp_ep_t *ep = ucs_derived_of(tl_ep, uct_tcp_ep_t);
+    uct_tcp_zcopy_desc_t *desc;
+    ucs_status_t status;
+
+    if (!uct_tcp_ep_can_send(ep)) {
+        status = uct_tcp_ep_progress_tx(ep);
+        if (status != UCS_OK) {
+            return status;
+        }
+    }
+
+    uct_tcp_ep_progress(ep);
+    if (!ucs_queue_is_empty(&ep->zcopy_q)) {
+        if (comp != NULL) {
+            /* Empty descriptor, completed after all previous zcopy sends */
+            desc = ucs_mpool_get(&iface->mp);
+            if (desc == NULL) {
+                return UCS_ERR_NO_RESOURCE;
+            }
+
+            desc->comp = comp;
+            desc->sn   = ep->zcopy_sn - 1;
+            ucs_queue_push(&ep->zcopy_q, &desc->queue);
+        }
+        UCT_TL_EP_STAT_FLUSH_WAIT(&ep->super);
+        return UCS_INPROGRESS;
+    }
+
+    UCT_TL_EP_STAT_FLUSH(&ep->super);
+    return UCS_OK;
+}
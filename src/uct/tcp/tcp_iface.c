@@ -25,6 +25,27 @@ static ucs_config_field_t uct_tcp_iface_config_table[] = {
    "Backlog size of incoming connections",
    ucs_offsetof(uct_tcp_iface_config_t, backlog), UCS_CONFIG_TYPE_UINT},
 
+  {"SEG_SIZE", "64k",
+   "Maximal size of an active message, including the header. Determines the\n"
+   "size of receive descriptors and the maximal zero-copy message.",
+   ucs_offsetof(uct_tcp_iface_config_t, seg_size), UCS_CONFIG_TYPE_MEMUNITS},
+
+  {"ZCOPY_THRESH", "16k",
+   "Minimal zero-copy message size to send with MSG_ZEROCOPY, which lets the\n"
+   "NIC read user memory instead of copying it to the socket buffer. Smaller\n"
+   "messages are copied by the kernel, since pinning pages and reading the\n"
+   "completions from the socket error queue costs more than the copy.\n"
+   "\"inf\" disables MSG_ZEROCOPY.",
+   ucs_offsetof(uct_tcp_iface_config_t, zcopy_thresh), UCS_CONFIG_TYPE_MEMUNITS},
+
+  {"RX_BUF_SIZE", "128k",
+   "Size of the per-connection buffer incoming data is read into. Larger buffer\n"
+   "allows receiving several messages with one system call.",
+   ucs_offsetof(uct_tcp_iface_config_t, rx_buf_size), UCS_CONFIG_TYPE_MEMUNITS},
+
+  UCT_IFACE_MPOOL_CONFIG_FIELDS("RX_", -1, 32, "receive",
+                                ucs_offsetof(uct_tcp_iface_config_t, rx_mpool), ""),
+
   {"TCP_NODELAY", "y",
    "Set TCP_NODELAY socket option to disable Nagle algorithm. Setting this\n"
    "option usually provides better performance",
@@ -74,9 +95,20 @@ static ucs_status_t uct_tcp_iface_query(uct_iface_h tl_iface, uct_iface_attr_t *
     attr->iface_addr_len   = sizeof(in_port_t);
     attr->device_addr_len  = sizeof(struct in_addr);
     attr->cap.flags        = UCT_IFACE_FLAG_CONNECT_TO_IFACE |
-                             UCT_IFACE_FLAG_PENDING;
-
+                             UCT_IFACE_FLAG_AM_SHORT         |
+                             UCT_IFACE_FLAG_AM_BCOPY         |
+                             UCT_IFACE_FLAG_AM_ZCOPY         |
+                             UCT_IFACE_FLAG_AM_CB_SYNC       |
+                             UCT_IFACE_FLAG_PENDING          |
+                             UCT_IFACE_FLAG_WAKEUP;
+
+    attr->cap.am.max_short = iface->config.max_short;
     attr->cap.am.max_bcopy = iface->config.max_bcopy;
+    attr->cap.am.max_zcopy = iface->config.max_zcopy;
+    attr->cap.am.max_hdr   = iface->config.max_hdr;
+    attr->cap.am.max_iov   = UCT_TCP_MAX_IOV;
+    attr->cap.am.opt_zcopy_align = 1;
+    attr->cap.am.align_mtu = 1;
 
     status = uct_tcp_netif_caps(iface->if_name, &attr->latency.overhead,
                                 &attr->bandwidth);
@@ -140,16 +172,172 @@ ucs_status_t uct_tcp_iface_set_sockopt(uct_tcp_iface_t *iface, int fd)
     return UCS_OK;
 }
 
+static ucs_status_t uct_tcp_iface_flush(uct_iface_h tl_iface, unsigned flags,
+                                        uct_completion_t *comp)
+{
+    uct_tcp_iface_t *iface = ucs_derived_of(tl_iface, uct_tcp_iface_t);
+    uct_tcp_ep_t *ep, *tmp;
+
+    if (comp != NULL) {
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    ucs_list_for_each_safe(ep, tmp, &iface->tx_list, list) {
+        uct_tcp_ep_progress(ep);
+    }
+
+    if (!ucs_list_is_empty(&iface->tx_list)) {
+        UCT_TL_IFACE_STAT_FLUSH_WAIT(&iface->super);
+        return UCS_INPROGRESS;
+    }
+
+    UCT_TL_IFACE_STAT_FLUSH(&iface->super);
+    return UCS_OK;
+}
+
+unsigned uct_tcp_iface_progress(void *arg)
+{
+    uct_tcp_iface_t *iface = arg;
+    uct_tcp_ep_t *ep, *tmp;
+    unsigned count;
+
+    /* progress receive */
+    count = uct_tcp_iface_recv_progress(iface);
+
+    /* complete partially sent messages and zero-copy sends */
+    ucs_list_for_each_safe(ep, tmp, &iface->tx_list, list) {
+        count += uct_tcp_ep_progress(ep);
+    }
+
+    /* progress the pending sends (if there are any) */
+    ucs_arbiter_dispatch(&iface->arbiter, 1, uct_tcp_ep_process_pending,
+                         &count);
+    return count;
+}
+
+ucs_status_t uct_tcp_iface_wakeup_add_fd(uct_tcp_iface_t *iface, int fd)
+{
+    struct epoll_event event;
+    int ret;
+
+    memset(&event, 0, sizeof(event));
+    event.events  = EPOLLIN | EPOLLET;
+    event.data.fd = fd;
+    ret = epoll_ctl(iface->wakeup_epfd, EPOLL_CTL_ADD, fd, &event);
+    if (ret < 0) {
+        ucs_error("epoll_ctl(epfd=%d, ADD, fd=%d) failed: %m",
+                  iface->wakeup_epfd, fd);
+        return UCS_ERR_IO_ERROR;
+    }
+
+    return UCS_OK;
+}
+
+static ucs_status_t uct_tcp_iface_wakeup_open(uct_iface_h tl_iface, unsigned events,
+                                              uct_wakeup_h wakeup)
+{
+    uct_tcp_iface_t *iface = ucs_derived_of(tl_iface, uct_tcp_iface_t);
+    ucs_status_t status;
+    uct_tcp_recv_sock_t *rsock;
+
+    if (iface->wakeup_epfd != -1) {
+        ucs_error("tcp iface %p already has a wakeup handle", iface);
+        return UCS_ERR_BUSY;
+    }
+
+    /* The receive sockets are added by the async thread */
+    UCS_ASYNC_BLOCK(iface->super.worker->async);
+
+    iface->wakeup_epfd = epoll_create(1);
+    if (iface->wakeup_epfd < 0) {
+        ucs_error("epoll_create() failed: %m");
+        iface->wakeup_epfd = -1;
+        status = UCS_ERR_IO_ERROR;
+        goto out;
+    }
+
+    /* Edge-triggered, so arm would report only data which arrived after the
+     * previous arm */
+    kh_foreach_value(&iface->fd_hash, rsock, {
+        status = uct_tcp_iface_wakeup_add_fd(iface, rsock->fd);
+        if (status != UCS_OK) {
+            close(iface->wakeup_epfd);
+            iface->wakeup_epfd = -1;
+            goto out;
+        }
+    });
+
+    wakeup->fd = iface->wakeup_epfd;
+    status     = UCS_OK;
+
+out:
+    UCS_ASYNC_UNBLOCK(iface->super.worker->async);
+    return status;
+}
+
+static ucs_status_t uct_tcp_iface_wakeup_arm(uct_wakeup_h wakeup)
+{
+    uct_tcp_iface_t *iface = ucs_derived_of(wakeup->iface, uct_tcp_iface_t);
+    struct epoll_event events[UCT_TCP_MAX_EVENTS];
+    int nevents, busy;
+
+    /* Consume the events of the data which arrived since the previous arm */
+    busy = 0;
+    do {
+        nevents = epoll_wait(iface->wakeup_epfd, events, UCT_TCP_MAX_EVENTS, 0);
+        if (nevents < 0) {
+            if (errno == EINTR) {
+                return UCS_ERR_BUSY;
+            }
+            ucs_error("epoll_wait(epfd=%d) failed: %m", iface->wakeup_epfd);
+            return UCS_ERR_IO_ERROR;
+        }
+        busy |= (nevents > 0);
+    } while (nevents == UCT_TCP_MAX_EVENTS);
+
+    /* Data which was already read from the sockets, unsent data and pending
+     * operations are progressed only by polling */
+    if (busy || iface->rx_backlog || !ucs_list_is_empty(&iface->tx_list) ||
+        !ucs_arbiter_is_empty(&iface->arbiter)) {
+        return UCS_ERR_BUSY;
+    }
+
+    return UCS_OK;
+}
+
+static void uct_tcp_iface_wakeup_close(uct_wakeup_h wakeup)
+{
+    uct_tcp_iface_t *iface = ucs_derived_of(wakeup->iface, uct_tcp_iface_t);
+
+    UCS_ASYNC_BLOCK(iface->super.worker->async);
+    close(iface->wakeup_epfd);
+    iface->wakeup_epfd = -1;
+    UCS_ASYNC_UNBLOCK(iface->super.worker->async);
+}
+
 static uct_iface_ops_t uct_tcp_iface_ops = {
     .iface_close              = UCS_CLASS_DELETE_FUNC_NAME(uct_tcp_iface_t),
     .iface_get_device_address = uct_tcp_iface_get_device_address,
     .iface_get_address        = uct_tcp_iface_get_address,
     .iface_query              = uct_tcp_iface_query,
     .iface_is_reachable       = uct_tcp_iface_is_reachable,
+    .iface_release_am_desc    = uct_tcp_iface_release_am_desc,
+    .iface_flush              = uct_tcp_iface_flush,
+    .iface_wakeup_open        = uct_tcp_iface_wakeup_open,
+    .iface_wakeup_get_fd      = uct_base_iface_wakeup_get_fd,
+    .iface_wakeup_arm         = uct_tcp_iface_wakeup_arm,
+    .iface_wakeup_wait        = uct_base_iface_wakeup_wait,
+    .iface_wakeup_signal      = (void*)ucs_empty_function_return_unsupported,
+    .iface_wakeup_close       = uct_tcp_iface_wakeup_close,
     .ep_create_connected      = UCS_CLASS_NEW_FUNC_NAME(uct_tcp_ep_t),
     .ep_destroy               = UCS_CLASS_DELETE_FUNC_NAME(uct_tcp_ep_t),
-    .ep_pending_add           = ucs_empty_function_return_busy,
-    .ep_pending_purge         = ucs_empty_function,
+    .ep_am_short              = uct_tcp_ep_am_short,
+    .ep_am_bcopy              = uct_tcp_ep_am_bcopy,
+    .ep_am_zcopy              = uct_tcp_ep_am_zcopy,
+    .ep_pending_add           = uct_tcp_ep_pending_add,
+    .ep_pending_add_prio      = uct_tcp_ep_pending_add_prio,
+    .ep_pending_purge         = uct_tcp_ep_pending_purge,
+    .ep_flush                 = uct_tcp_ep_flush,
 };
 
 static ucs_mpool_ops_t uct_tcp_mpool_ops = {
@@ -173,12 +361,37 @@ static UCS_CLASS_INIT_FUNC(uct_tcp_iface_t, uct_md_h md, uct_worker_h worker,
                               tl_config UCS_STATS_ARG(params->stats_root)
                               UCS_STATS_ARG(params->dev_name));
 
+    if (config->seg_size <= sizeof(uct_tcp_am_hdr_t) +
+                            sizeof(uct_tcp_zcopy_desc_t)) {
+        ucs_error("TCP segment size (%zu) is too small", config->seg_size);
+        return UCS_ERR_INVALID_PARAM;
+    }
+
     strncpy(self->if_name, params->dev_name, sizeof(self->if_name));
-    self->config.max_bcopy       = config->super.max_bcopy;
+    self->config.seg_size        = config->seg_size - sizeof(uct_tcp_am_hdr_t);
+    self->config.max_zcopy       = self->config.seg_size;
+    self->config.max_bcopy       = ucs_min(config->super.max_bcopy,
+                                           self->config.seg_size);
+    self->config.max_short       = ucs_min(config->super.max_short,
+                                           self->config.max_bcopy);
+    /* zcopy header is kept in a TX buffer, after the zcopy descriptor */
+    self->config.max_hdr         = ucs_max(self->config.max_bcopy,
+                                           sizeof(uct_tcp_zcopy_desc_t)) -
+                                   sizeof(uct_tcp_zcopy_desc_t);
+    self->config.zcopy_thresh    = config->zcopy_thresh;
+    self->config.rx_headroom     = params->rx_headroom;
+    self->config.headroom_offset = sizeof(uct_am_recv_desc_t);
+    self->config.rx_buf_size     = ucs_max(config->rx_buf_size,
+                                           config->seg_size);
     self->config.prefer_default  = config->prefer_default;
     self->sockopt.nodelay        = config->sockopt_nodelay;
+    self->rx_desc                = NULL;
+    self->rx_backlog             = 0;
+    self->wakeup_epfd            = -1;
 
     kh_init_inplace(uct_tcp_fd_hash, &self->fd_hash);
+    ucs_arbiter_init(&self->arbiter);
+    ucs_list_head_init(&self->tx_list);
 
     status = uct_tcp_netif_inaddr(self->if_name, &self->config.ifaddr,
                                   &self->config.netmask);
@@ -187,7 +400,9 @@ static UCS_CLASS_INIT_FUNC(uct_tcp_iface_t, uct_md_h md, uct_worker_h worker,
     }
 
     status = ucs_mpool_init(&self->mp, 0,
-                            self->config.max_bcopy,
+                            sizeof(uct_tcp_am_hdr_t) +
+                            ucs_max(self->config.max_bcopy,
+                                    sizeof(uct_tcp_zcopy_desc_t)),
                             0,                        /* alignment offset */
                             UCS_SYS_CACHE_LINE_SIZE,  /* alignment */
                             32,                       /* grow */
@@ -198,10 +413,31 @@ static UCS_CLASS_INIT_FUNC(uct_tcp_iface_t, uct_md_h md, uct_worker_h worker,
         goto err;
     }
 
+    status = ucs_mpool_init(&self->rx_mp, 0,
+                            self->config.headroom_offset +
+                            self->config.rx_headroom +
+                            self->config.seg_size,
+                            self->config.headroom_offset,
+                            UCS_SYS_CACHE_LINE_SIZE,
+                            config->rx_mpool.bufs_grow,
+                            config->rx_mpool.max_bufs,
+                            &uct_tcp_mpool_ops,
+                            "tcp_recv_desc");
+    if (status != UCS_OK) {
+        goto err_mpool_cleanup;
+    }
+
+    self->epfd = epoll_create(1);
+    if (self->epfd < 0) {
+        ucs_error("epoll_create() failed: %m");
+        status = UCS_ERR_IO_ERROR;
+        goto err_rx_mpool_cleanup;
+    }
+
     /* Create the server socket for accepting incoming connections */
     status = uct_tcp_socket_create(&self->listen_fd);
     if (status != UCS_OK) {
-        goto err_mpool_cleanup;
+        goto err_close_epfd;
     }
 
     /* Set the server socket to non-blocking mode */
@@ -252,6 +488,10 @@ static UCS_CLASS_INIT_FUNC(uct_tcp_iface_t, uct_md_h md, uct_worker_h worker,
 
 err_close_sock:
     close(self->listen_fd);
+err_close_epfd:
+    close(self->epfd);
+err_rx_mpool_cleanup:
+    ucs_mpool_cleanup(&self->rx_mp, 0);
 err_mpool_cleanup:
     ucs_mpool_cleanup(&self->mp, 0);
 err:
@@ -267,10 +507,19 @@ static UCS_CLASS_CLEANUP_FUNC(uct_tcp_iface_t)
         ucs_warn("failed to remove handler for server socket fd=%d", self->listen_fd);
     }
 
+    ucs_callbackq_remove_all(&self->super.worker->progress_q,
+                             uct_tcp_iface_progress, self);
+
     uct_tcp_iface_recv_cleanup(self);
     close(self->listen_fd);
+    close(self->epfd);
+    if (self->rx_desc != NULL) {
+        ucs_mpool_put(self->rx_desc);
+    }
+    ucs_mpool_cleanup(&self->rx_mp, 1);
     ucs_mpool_cleanup(&self->mp, 1);
     kh_destroy_inplace(uct_tcp_fd_hash, &self->fd_hash);
+    ucs_arbiter_cleanup(&self->arbiter);
 }
 
 UCS_CLASS_DEFINE(uct_tcp_iface_t, uct_base_iface_t);
@@ -8,11 +8,13 @@
 
 static ucs_status_t uct_tcp_md_query(uct_md_h md, uct_md_attr_t *attr)
 {
-    attr->cap.flags         = 0;
+    attr->cap.flags         = UCT_MD_FLAG_REG;
     attr->cap.max_alloc     = 0;
-    attr->cap.max_reg       = 0;
+    attr->cap.max_reg       = ULONG_MAX;
     attr->rkey_packed_size  = 0;
-    attr->reg_cost.overhead = 0;
+    /* Registration is a no-op, but a zero-copy send has to track its
+     * completion, which is what makes it worthwhile only for large messages */
+    attr->reg_cost.overhead = 1e-6;
     attr->reg_cost.growth   = 0;
     memset(&attr->local_cpus, 0xff, sizeof(attr->local_cpus));
     return UCS_OK;
@@ -24,15 +26,25 @@ static ucs_status_t uct_tcp_query_md_resources(uct_md_resource_desc_t **resource
     return uct_single_md_resource(&uct_tcp_md, resources_p, num_resources_p);
 }
 
+static ucs_status_t uct_tcp_mem_reg(uct_md_h md, void *address, size_t length,
+                                    unsigned flags, uct_mem_h *memh_p)
+{
+    /* Sockets work with any virtual memory, zero-copy sends don't need a
+     * registration. Return a valid handle to make the memory usable. */
+    UCS_STATIC_ASSERT((uint64_t)0xdeadbeef != (uint64_t)UCT_INVALID_MEM_HANDLE);
+    *memh_p = (void *) 0xdeadbeef;
+    return UCS_OK;
+}
+
 static ucs_status_t uct_tcp_md_open(const char *md_name, const uct_md_config_t *md_config,
                                     uct_md_h *md_p)
 {
     static uct_md_ops_t md_ops = {
         .close        = ucs_empty_function,
         .query        = uct_tcp_md_query,
-        .mkey_pack    = ucs_empty_function_return_unsupported,
-        .mem_reg      = ucs_empty_function_return_unsupported,
-        .mem_dereg    = ucs_empty_function_return_unsupported
+        .mkey_pack    = ucs_empty_function_return_success,
+        .mem_reg      = uct_tcp_mem_reg,
+        .mem_dereg    = ucs_empty_function_return_success
     };
     static uct_md_t md = {
         .ops          = &md_ops,
@@ -45,6 +57,6 @@ static ucs_status_t uct_tcp_md_open(const char *md_name, const uct_md_config_t *
 
 UCT_MD_COMPONENT_DEFINE(uct_tcp_md, UCT_TCP_NAME,
                         uct_tcp_query_md_resources, uct_tcp_md_open, NULL,
-                        ucs_empty_function_return_unsupported,
+                        uct_md_stub_rkey_unpack,
                         ucs_empty_function_return_success, "TCP_",
                         uct_md_config_table, uct_md_config_t);
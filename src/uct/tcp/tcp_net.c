@@ -113,8 +113,9 @@ ucs_status_t uct_tcp_netif_caps(const char *if_name, double *latency_p,
 #else
         if ((speed_mbps == 0) || ((uint16_t)speed_mbps == (uint16_t)-1)) {
 #endif
-            ucs_error("speed of %s is UNKNOWN", if_name);
-            return UCS_ERR_NO_DEVICE;
+            /* Typical for virtual interfaces */
+            ucs_debug("speed of %s is UNKNOWN, assuming 100 Mbps", if_name);
+            speed_mbps = 100;
         }
     } else {
         speed_mbps = 100; /* Default value if SIOCETHTOOL is not supported */
@@ -36,8 +36,11 @@ static ucs_status_t uct_tcp_iface_recv_sock_add(uct_tcp_iface_t *iface, int fd,
 
 ucs_status_t uct_tcp_iface_connection_accepted(uct_tcp_iface_t *iface, int fd)
 {
+    struct epoll_event event;
     uct_tcp_recv_sock_t *rsock;
     ucs_status_t status;
+    khiter_t hash_it;
+    int ret;
 
     status = ucs_sys_fcntl_modfl(fd, O_NONBLOCK, 0);
     if (status != UCS_OK) {
@@ -49,20 +52,50 @@ ucs_status_t uct_tcp_iface_connection_accepted(uct_tcp_iface_t *iface, int fd)
         goto err_close;
     }
 
-    rsock = ucs_malloc(sizeof(*rsock), "tcp_recv");
+    rsock = ucs_malloc(sizeof(*rsock) + iface->config.rx_buf_size, "tcp_recv");
     if (rsock == NULL) {
         ucs_error("Failed to allocate TCP receive socket");
         status = UCS_ERR_NO_MEMORY;
         goto err_close;
     }
 
+    rsock->fd     = fd;
+    rsock->buf    = rsock + 1;
+    rsock->offset = 0;
+    rsock->length = 0;
+
     status = uct_tcp_iface_recv_sock_add(iface, fd, rsock);
     if (status != UCS_OK) {
         goto err_free;
     }
 
+    memset(&event, 0, sizeof(event));
+    event.events   = EPOLLIN;
+    event.data.ptr = rsock;
+    ret = epoll_ctl(iface->epfd, EPOLL_CTL_ADD, fd, &event);
+    if (ret < 0) {
+        ucs_error("epoll_ctl(epfd=%d, ADD, fd=%d) failed: %m", iface->epfd, fd);
+        status = UCS_ERR_IO_ERROR;
+        goto err_hash_del;
+    }
+
+    if (iface->wakeup_epfd != -1) {
+        status = uct_tcp_iface_wakeup_add_fd(iface, fd);
+        if (status != UCS_OK) {
+            goto err_epoll_del;
+        }
+    }
+
+    /* Start polling for incoming data */
+    ucs_callbackq_add_safe(&iface->super.worker->progress_q,
+                           uct_tcp_iface_progress, iface);
     return UCS_OK;
 
+err_epoll_del:
+    epoll_ctl(iface->epfd, EPOLL_CTL_DEL, fd, NULL);
+err_hash_del:
+    hash_it = kh_get(uct_tcp_fd_hash, &iface->fd_hash, fd);
+    kh_del(uct_tcp_fd_hash, &iface->fd_hash, hash_it);
 err_free:
     ucs_free(rsock);
 err_close:
@@ -74,6 +107,29 @@ static void uct_tcp_iface_recv_sock_destroy(uct_tcp_iface_t *iface,
                                             uct_tcp_recv_sock_t *rsock, int fd,
                                             int sync)
 {
+    khiter_t hash_it;
+    int ret;
+
+    ret = epoll_ctl(iface->epfd, EPOLL_CTL_DEL, fd, NULL);
+    if (ret < 0) {
+        ucs_warn("epoll_ctl(epfd=%d, DEL, fd=%d) failed: %m", iface->epfd, fd);
+    }
+
+    if (iface->wakeup_epfd != -1) {
+        epoll_ctl(iface->wakeup_epfd, EPOLL_CTL_DEL, fd, NULL);
+    }
+
+    if (!sync) {
+        /* Called from progress, the remote side closed the connection */
+        UCS_ASYNC_BLOCK(iface->super.worker->async);
+        hash_it = kh_get(uct_tcp_fd_hash, &iface->fd_hash, fd);
+        kh_del(uct_tcp_fd_hash, &iface->fd_hash, hash_it);
+        UCS_ASYNC_UNBLOCK(iface->super.worker->async);
+
+        ucs_callbackq_remove_safe(&iface->super.worker->progress_q,
+                                  uct_tcp_iface_progress, iface);
+    }
+
     ucs_free(rsock);
     close(fd);
 }
@@ -91,3 +147,166 @@ void uct_tcp_iface_recv_cleanup(uct_tcp_iface_t *iface)
     kh_clear(uct_tcp_fd_hash, &iface->fd_hash);
     UCS_ASYNC_UNBLOCK(iface->super.worker->async);
 }
+
+void uct_tcp_iface_release_am_desc(uct_iface_t *tl_iface, void *desc)
+{
+    uct_tcp_iface_t *iface = ucs_derived_of(tl_iface, uct_tcp_iface_t);
+
+    ucs_mpool_put(desc - iface->config.headroom_offset);
+}
+
+static inline void uct_tcp_iface_invoke_am(uct_tcp_iface_t *iface,
+                                           uct_tcp_am_hdr_t *hdr)
+{
+    void *desc = iface->rx_desc + iface->config.headroom_offset;
+    ucs_status_t status;
+
+    uct_iface_trace_am(&iface->super, UCT_AM_TRACE_TYPE_RECV, hdr->am_id,
+                       hdr + 1, hdr->length, "RX: AM");
+
+    /* The payload stays in the socket buffer, the descriptor is used only if
+     * the user wants to keep the data */
+    status = uct_iface_invoke_am(&iface->super, hdr->am_id, hdr + 1,
+                                 hdr->length, desc);
+    if (status != UCS_OK) {
+        /* save the iface of this desc for its later release */
+        uct_recv_desc_iface(desc) = &iface->super.super;
+        UCT_TL_IFACE_GET_RX_DESC(&iface->super, &iface->rx_mp, iface->rx_desc,
+                                 ucs_debug("tcp recv mpool is empty"));
+    }
+}
+
+/* Dispatch every complete message in the socket buffer. Incomplete data is
+ * kept until the rest of it arrives. */
+static ucs_status_t uct_tcp_iface_recv_sock_dispatch(uct_tcp_iface_t *iface,
+                                                     uct_tcp_recv_sock_t *rsock,
+                                                     unsigned *count_p)
+{
+    uct_tcp_am_hdr_t *hdr;
+    size_t remainder;
+
+    for (;;) {
+        remainder = rsock->length - rsock->offset;
+        if (remainder < sizeof(*hdr)) {
+            break;
+        }
+
+        if (ucs_unlikely((iface->rx_desc == NULL) ||
+                         (*count_p >= UCT_TCP_MAX_RX_BATCH))) {
+            /* Come back to this socket on the next progress */
+            iface->rx_backlog = 1;
+            break;
+        }
+
+        hdr = rsock->buf + rsock->offset;
+        if (ucs_unlikely(hdr->length > iface->config.seg_size)) {
+            ucs_error("tcp rsock %d: invalid message length %u (max: %zu)",
+                      rsock->fd, hdr->length, iface->config.seg_size);
+            return UCS_ERR_IO_ERROR;
+        }
+
+        if (remainder < (sizeof(*hdr) + hdr->length)) {
+            break;
+        }
+
+        uct_tcp_iface_invoke_am(iface, hdr);
+        rsock->offset += sizeof(*hdr) + hdr->length;
+        ++(*count_p);
+    }
+
+    return UCS_OK;
+}
+
+static ucs_status_t uct_tcp_iface_recv_sock_progress(uct_tcp_iface_t *iface,
+                                                     uct_tcp_recv_sock_t *rsock,
+                                                     unsigned *count_p)
+{
+    size_t remainder;
+    ssize_t ret;
+
+    /* Move the beginning of a partial message to the start of the buffer */
+    if (rsock->offset > 0) {
+        remainder = rsock->length - rsock->offset;
+        memmove(rsock->buf, rsock->buf + rsock->offset, remainder);
+        rsock->offset = 0;
+        rsock->length = remainder;
+    }
+
+    if (rsock->length == iface->config.rx_buf_size) {
+        /* Buffer is full of messages which could not be dispatched yet */
+        return uct_tcp_iface_recv_sock_dispatch(iface, rsock, count_p);
+    }
+
+    ret = recv(rsock->fd, rsock->buf + rsock->length,
+               iface->config.rx_buf_size - rsock->length, 0);
+    if (ret < 0) {
+        if ((errno == EAGAIN) || (errno == EINTR)) {
+            return UCS_OK;
+        }
+        ucs_error("recv(fd=%d) failed: %m", rsock->fd);
+        return UCS_ERR_IO_ERROR;
+    } else if (ret == 0) {
+        ucs_debug("tcp rsock %d: connection closed by peer", rsock->fd);
+        return UCS_ERR_CANCELED;
+    }
+
+    if (rsock->length + ret == iface->config.rx_buf_size) {
+        /* The socket could have more data, which would not generate a new
+         * wakeup event */
+        iface->rx_backlog = 1;
+    }
+
+    rsock->length += ret;
+    return uct_tcp_iface_recv_sock_dispatch(iface, rsock, count_p);
+}
+
+/* Dispatch messages which were left in socket buffers when the receive
+ * descriptors ran out or the batch limit was reached */
+static void uct_tcp_iface_recv_resume(uct_tcp_iface_t *iface, unsigned *count_p)
+{
+    uct_tcp_recv_sock_t *rsock;
+
+    UCS_ASYNC_BLOCK(iface->super.worker->async);
+    kh_foreach_value(&iface->fd_hash, rsock, {
+        uct_tcp_iface_recv_sock_dispatch(iface, rsock, count_p);
+    });
+    UCS_ASYNC_UNBLOCK(iface->super.worker->async);
+}
+
+unsigned uct_tcp_iface_recv_progress(uct_tcp_iface_t *iface)
+{
+    struct epoll_event events[UCT_TCP_MAX_EVENTS];
+    uct_tcp_recv_sock_t *rsock;
+    unsigned count = 0;
+    ucs_status_t status;
+    int i, nevents;
+
+    /* Make sure there is a descriptor to hand out with the next message */
+    if (ucs_unlikely(iface->rx_desc == NULL)) {
+        UCT_TL_IFACE_GET_RX_DESC(&iface->super, &iface->rx_mp, iface->rx_desc,
+                                 return 0);
+    }
+
+    if (ucs_unlikely(iface->rx_backlog)) {
+        iface->rx_backlog = 0;
+        uct_tcp_iface_recv_resume(iface, &count);
+    }
+
+    nevents = epoll_wait(iface->epfd, events, UCT_TCP_MAX_EVENTS, 0);
+    if (ucs_unlikely(nevents < 0)) {
+        if (errno != EINTR) {
+            ucs_error("epoll_wait(epfd=%d) failed: %m", iface->epfd);
+        }
+        return count;
+    }
+
+    for (i = 0; i < nevents; ++i) {
+        rsock  = events[i].data.ptr;
+        status = uct_tcp_iface_recv_sock_progress(iface, rsock, &count);
+        if (ucs_unlikely(status != UCS_OK)) {
+            uct_tcp_iface_recv_sock_destroy(iface, rsock, rsock->fd, 0);
+        }
+    }
+
+    return count;
+}
@@ -9,20 +9,26 @@
 SGLIB_DEFINE_LIST_FUNCTIONS(uct_ugni_ep_t, uct_ugni_ep_compare, next);
 SGLIB_DEFINE_HASHED_CONTAINER_FUNCTIONS(uct_ugni_ep_t, UCT_UGNI_HASH_SIZE, uct_ugni_ep_hash);
 
-ucs_status_t uct_ugni_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n){
+ucs_status_t uct_ugni_ep_pending_add_prio(uct_ep_h tl_ep, uct_pending_req_t *n,
+                                          uct_pending_prio_t prio){
     uct_ugni_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_ugni_iface_t);
     uct_ugni_ep_t *ep = ucs_derived_of(tl_ep, uct_ugni_ep_t);
 
     UCS_STATIC_ASSERT(sizeof(ucs_arbiter_elem_t) <= UCT_PENDING_REQ_PRIV_LEN);
     uct_ugni_enter_async(iface);
     ucs_arbiter_elem_init((ucs_arbiter_elem_t *)n->priv);
-    ucs_arbiter_group_push_elem(&ep->arb_group, (ucs_arbiter_elem_t*) n->priv);
+    ucs_arbiter_group_push_elem_prio(&ep->arb_group, (ucs_arbiter_elem_t*) n->priv,
+                                     uct_pending_arb_prio(prio));
     ucs_arbiter_group_schedule(&iface->arbiter, &ep->arb_group);
     ep->arb_size++;
     uct_ugni_leave_async(iface);
     return UCS_OK;
 }
 
+ucs_status_t uct_ugni_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n){
+    return uct_ugni_ep_pending_add_prio(tl_ep, n, UCT_PENDING_PRIO_BULK);
+}
+
 ucs_arbiter_cb_result_t uct_ugni_ep_process_pending(ucs_arbiter_t *arbiter,
                                                     ucs_arbiter_elem_t *elem,
                                                     void *arg){
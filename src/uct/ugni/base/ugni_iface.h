@@ -36,7 +36,7 @@ ucs_status_t uct_ugni_ep_flush(uct_ep_h tl_ep, unsigned flags,
                                uct_completion_t *comp);
 ucs_status_t uct_ugni_iface_get_address(uct_iface_h tl_iface, uct_iface_addr_t *addr);
 int uct_ugni_iface_is_reachable(uct_iface_h tl_iface, const uct_device_addr_t *dev_addr, const uct_iface_addr_t *iface_addr);
-void uct_ugni_progress(void *arg);
+unsigned uct_ugni_progress(void *arg);
 
 typedef struct uct_ugni_base_desc {
     gni_post_descriptor_t desc;
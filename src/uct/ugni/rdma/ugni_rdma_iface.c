@@ -130,6 +130,7 @@ uct_iface_ops_t uct_ugni_rdma_iface_ops = {
     .ep_get_bcopy        = uct_ugni_ep_get_bcopy,
     .ep_get_zcopy        = uct_ugni_ep_get_zcopy,
     .ep_pending_add      = uct_ugni_ep_pending_add,
+    .ep_pending_add_prio = uct_ugni_ep_pending_add_prio,
     .ep_pending_purge    = uct_ugni_ep_pending_purge,
     /* Not supported on Gemini and we overlaod it for Aries */
     .ep_atomic_swap64    = (void*)ucs_empty_function_return_unsupported,
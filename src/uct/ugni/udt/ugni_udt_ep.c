@@ -15,10 +15,11 @@
 
 #define uct_ugni_udt_can_send(_ep) ((uct_ugni_can_send(&_ep->super)) && (_ep->posted_desc == NULL))
 
-ucs_status_t uct_ugni_udt_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n)
+ucs_status_t uct_ugni_udt_ep_pending_add_prio(uct_ep_h tl_ep, uct_pending_req_t *n,
+                                              uct_pending_prio_t prio)
 {
     uct_ugni_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_ugni_iface_t);
-    ucs_status_t status = uct_ugni_ep_pending_add(tl_ep, n);
+    ucs_status_t status = uct_ugni_ep_pending_add_prio(tl_ep, n, prio);
 
     if (UCS_OK == status) {
         uct_worker_progress_register(iface->super.worker, uct_ugni_udt_progress, iface);
@@ -26,6 +27,11 @@ ucs_status_t uct_ugni_udt_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n)
     return status;
 }
 
+ucs_status_t uct_ugni_udt_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n)
+{
+    return uct_ugni_udt_ep_pending_add_prio(tl_ep, n, UCT_PENDING_PRIO_BULK);
+}
+
 ucs_arbiter_cb_result_t uct_ugni_udt_ep_process_pending(ucs_arbiter_t *arbiter,
                                                         ucs_arbiter_elem_t *elem,
                                                         void *arg)
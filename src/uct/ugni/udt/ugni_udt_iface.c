@@ -143,13 +143,15 @@ static void *uct_ugni_udt_device_thread(void *arg)
     return NULL;
 }
 
-void uct_ugni_udt_progress(void *arg)
+unsigned uct_ugni_udt_progress(void *arg)
 {
     uct_ugni_udt_iface_t * iface = (uct_ugni_udt_iface_t *)arg;
 
+    /* receives are handled by the async thread, only pending sends here */
     uct_ugni_enter_async(&iface->super);
     ucs_arbiter_dispatch(&iface->super.arbiter, 1, uct_ugni_udt_ep_process_pending, NULL);
     uct_ugni_leave_async(&iface->super);
+    return 0;
 }
 
 static void uct_ugni_udt_iface_release_am_desc(uct_iface_t *tl_iface, void *desc)
@@ -341,6 +343,7 @@ uct_iface_ops_t uct_ugni_udt_iface_ops = {
     .ep_create_connected   = UCS_CLASS_NEW_FUNC_NAME(uct_ugni_udt_ep_t),
     .ep_destroy            = UCS_CLASS_DELETE_FUNC_NAME(uct_ugni_udt_ep_t),
     .ep_pending_add        = uct_ugni_udt_ep_pending_add,
+    .ep_pending_add_prio   = uct_ugni_udt_ep_pending_add_prio,
     .ep_pending_purge      = uct_ugni_ep_pending_purge,
     .ep_am_short           = uct_ugni_udt_ep_am_short,
     .ep_am_bcopy           = uct_ugni_udt_ep_am_bcopy,
@@ -50,7 +50,7 @@ typedef struct uct_ugni_udt_header {
     uint8_t length;
 } uct_ugni_udt_header_t;
 
-void uct_ugni_udt_progress(void *arg);
+unsigned uct_ugni_udt_progress(void *arg);
 #define uct_ugni_udt_get_offset(i) ((size_t)(ucs_max(sizeof(uct_ugni_udt_header_t), ((i)->config.rx_headroom  + \
                  sizeof(uct_am_recv_desc_t)))))
 
@@ -13,6 +13,7 @@ extern "C" {
 #include <ucs/sys/sys.h>
 }
 #include <pthread.h>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -60,12 +61,19 @@ unsigned test_perf::rte::group_index(void *rte_group) {
 
 void test_perf::rte::barrier(void *rte_group) {
     static const uint32_t magic = 0xdeadbeed;
+
+    /* In a multi-threaded test, only the master thread talks to the peer */
+#pragma omp barrier
+#pragma omp master
+  {
     rte *self = reinterpret_cast<rte*>(rte_group);
     uint32_t dummy = magic;
     self->m_send.push(&dummy, sizeof(dummy));
     dummy = 0;
     self->m_recv.pop(&dummy, sizeof(dummy));
     ucs_assert_always(dummy == magic);
+  }
+#pragma omp barrier
 }
 
 void test_perf::rte::post_vec(void *rte_group, const struct iovec *iovec,
@@ -118,6 +126,11 @@ ucx_perf_rte_t test_perf::rte::test_rte = {
     rte::recv,
     rte::exchange_vec,
     rte::report,
+    NULL
+};
+
+const test_perf::thread_spec test_perf::single_thread = {
+    1, UCX_PERF_THREAD_MODEL_SHARED, false
 };
 
 std::vector<int> test_perf::get_affinity() {
@@ -168,17 +181,41 @@ void* test_perf::thread_func(void *arg)
 test_perf::test_result test_perf::run_multi_threaded(const test_spec &test, unsigned flags,
                                                      const std::string &tl_name,
                                                      const std::string &dev_name,
-                                                     const std::vector<int> &cpus)
+                                                     const std::vector<int> &cpus,
+                                                     const thread_spec &threads)
 {
     rte_comm c0to1, c1to0;
+    std::vector<unsigned> thread_cpus(cpus.size());
+    unsigned thread_cpus_cnt = 0;
+
+    if (threads.bind) {
+        /* Pass the CPUs the same way as the command line of ucx_perftest */
+        std::stringstream cpu_list;
+        for (std::vector<int>::const_iterator iter = cpus.begin();
+             iter != cpus.end(); ++iter) {
+            cpu_list << ((iter == cpus.begin()) ? "" : ",") << *iter;
+        }
+
+        ucs_status_t status = ucx_perf_parse_cpu_list(cpu_list.str().c_str(),
+                                                      &thread_cpus[0],
+                                                      thread_cpus.size(),
+                                                      &thread_cpus_cnt);
+        EXPECT_EQ(UCS_OK, status);
+        EXPECT_EQ(cpus.size(), thread_cpus_cnt);
+    }
 
     ucx_perf_params_t params;
     params.api             = test.api;
     params.command         = test.command;
     params.test_type       = test.test_type;
-    params.thread_mode     = UCS_THREAD_MODE_SINGLE;
+    params.thread_mode     = ((threads.count > 1) &&
+                              (threads.model != UCX_PERF_THREAD_MODEL_WORKER)) ?
+                             UCS_THREAD_MODE_MULTI : UCS_THREAD_MODE_SINGLE;
     params.async_mode      = UCS_ASYNC_MODE_THREAD;
-    params.thread_count    = 1;
+    params.thread_count    = threads.count;
+    params.thread_model    = threads.model;
+    params.thread_cpus     = threads.bind ? &thread_cpus[0] : NULL;
+    params.thread_cpus_cnt = thread_cpus_cnt;
     params.wait_mode       = UCX_PERF_WAIT_MODE_LAST;
     params.flags           = flags;
     params.am_hdr_size     = 8;
@@ -194,6 +231,10 @@ test_perf::test_result test_perf::run_multi_threaded(const test_spec &test, unsi
     }
     params.max_time        = 0.0;
     params.report_interval = 1.0;
+    params.percentiles[0]  = 50.0;
+    params.percentiles[1]  = 99.0;
+    params.percentiles[2]  = 100.0;
+    params.percentiles_cnt = 3;
     params.rte_group       = NULL;
     params.rte             = &rte::test_rte;
     params.report_arg      = NULL;
@@ -249,18 +290,21 @@ test_perf::test_result test_perf::run_multi_threaded(const test_spec &test, unsi
 }
 
 void test_perf::run_test(const test_spec& test, unsigned flags, bool check_perf,
-                         const std::string &tl_name, const std::string &dev_name)
+                         const std::string &tl_name, const std::string &dev_name,
+                         const thread_spec &threads)
 {
     std::vector<int> cpus = get_affinity();
     if (cpus.size() < 2) {
         UCS_TEST_MESSAGE << "Need at least 2 CPUs (got: " << cpus.size() << " )";
         throw ucs::test_abort_exception();
     }
-    cpus.resize(2);
+    if (!threads.bind) {
+        cpus.resize(2);
+    }
 
     for (int i = 0; i < 5; ++i) {
         test_result result = run_multi_threaded(test, flags, tl_name, dev_name,
-                                                cpus);
+                                                cpus, threads);
         if ((result.status == UCS_ERR_UNSUPPORTED) ||
             (result.status == UCS_ERR_UNREACHABLE))
         {
@@ -269,6 +313,12 @@ void test_perf::run_test(const test_spec& test, unsigned flags, bool check_perf,
 
         ASSERT_UCS_OK(result.status);
 
+        ASSERT_EQ(3u, result.result.percentiles_cnt);
+        for (unsigned p = 1; p < result.result.percentiles_cnt; ++p) {
+            EXPECT_LE(result.result.percentiles[p - 1].latency,
+                      result.result.percentiles[p].latency);
+        }
+
         double value = *(double*)( ((char*)&result.result) + test.field_offset) *
                         test.norm;
         char result_str[200] = {0};
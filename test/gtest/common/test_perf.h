@@ -33,10 +33,20 @@ protected:
         double                 max; /* TODO remove this field */
     };
 
+    struct thread_spec {
+        unsigned                count;  /* Number of threads on each side */
+        ucx_perf_thread_model_t model;  /* What the threads share */
+        bool                    bind;   /* Bind the threads to the available
+                                           CPUs, round-robin */
+    };
+
+    static const thread_spec single_thread;
+
     static std::vector<int> get_affinity();
 
     void run_test(const test_spec& test, unsigned flags, bool check_perf,
-                  const std::string &tl_name, const std::string &dev_name);
+                  const std::string &tl_name, const std::string &dev_name,
+                  const thread_spec &threads = single_thread);
 
 private:
     class rte_comm {
@@ -101,7 +111,8 @@ private:
     test_result run_multi_threaded(const test_spec &test, unsigned flags,
                                    const std::string &tl_name,
                                    const std::string &dev_name,
-                                   const std::vector<int> &cpus);
+                                   const std::vector<int> &cpus,
+                                   const thread_spec &threads);
 };
 
 #endif
@@ -18,7 +18,9 @@
 
 extern "C" {
 #include <ucs/sys/sys.h>
+#include <ucs/time/time.h>
 #include <malloc.h>
+#include <sys/mman.h>
 }
 
 class malloc_hook : public ucs::test {
@@ -387,3 +389,208 @@ UCS_TEST_F(malloc_hook_cplusplus, new_delete) {
     ucm_unset_event_handler(UCM_EVENT_VM_UNMAPPED, mem_event_callback,
                             reinterpret_cast<void*>(this));
 }
+
+class malloc_hook_stress : public malloc_hook {
+public:
+    malloc_hook_stress() : m_stop(0), m_thread_index(0), m_unmapped_count(0),
+                           m_range_count(0) {
+        for (int i = 0; i < max_threads; ++i) {
+            m_mapped[i] = NULL;
+        }
+    }
+
+    static void mem_event_callback(ucm_event_type_t event_type, ucm_event_t *event,
+                                   void *arg)
+    {
+        malloc_hook_stress *self = reinterpret_cast<malloc_hook_stress*>(arg);
+
+        /* Count only the buffers which the test threads unmap, since malloc
+         * may or may not release memory */
+        for (int i = 0; i < max_threads; ++i) {
+            if (self->m_mapped[i] == event->vm_unmapped.address) {
+                ucs_atomic_add32(&self->m_unmapped_count, 1);
+                break;
+            }
+        }
+    }
+
+    static void range_event_callback(ucm_event_type_t event_type,
+                                     ucm_event_t *event, void *arg)
+    {
+        malloc_hook_stress *self = reinterpret_cast<malloc_hook_stress*>(arg);
+        uintptr_t address        = (uintptr_t)event->vm_unmapped.address;
+
+        /* Count only events around the test range, since the filter may pass
+         * unrelated events which happen to share a hash bucket */
+        if ((address >= test_range - UCS_MBYTE * 2) &&
+            (address <  test_range + UCS_MBYTE * 4)) {
+            ucs_atomic_add32(&self->m_range_count, 1);
+        }
+    }
+
+    static void *alloc_thread_func(void *arg)
+    {
+        malloc_hook_stress *self = reinterpret_cast<malloc_hook_stress*>(arg);
+        const size_t map_size    = 1 * UCS_MBYTE;
+        unsigned index           = ucs_atomic_fadd32(&self->m_thread_index, 1);
+        ucs_time_t unmap_time    = 0;
+        std::vector<void*> ptrs;
+        ucs_time_t start_time;
+        void *ptr;
+
+        for (int i = 0; i < num_iters; ++i) {
+            ptrs.push_back(malloc(small_alloc_size));
+            if (ptrs.size() > 16) {
+                while (!ptrs.empty()) {
+                    free(ptrs.back());
+                    ptrs.pop_back();
+                }
+            }
+
+            ptr = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ptr == MAP_FAILED) {
+                ADD_FAILURE() << "mmap() failed: " << strerror(errno);
+                break;
+            }
+
+            self->m_mapped[index] = ptr;
+            start_time = ucs_get_time();
+            munmap(ptr, map_size);
+            unmap_time += ucs_get_time() - start_time;
+            self->m_mapped[index] = NULL;
+        }
+        while (!ptrs.empty()) {
+            free(ptrs.back());
+            ptrs.pop_back();
+        }
+
+        UCS_TEST_MESSAGE << "thread " << ucs_get_tid() << ": "
+                         << ucs_time_to_nsec(unmap_time) / num_iters
+                         << " nsec per munmap";
+        return NULL;
+    }
+
+    static void *handler_thread_func(void *arg)
+    {
+        malloc_hook_stress *self = reinterpret_cast<malloc_hook_stress*>(arg);
+        ucs_status_t status;
+        void *ptr;
+
+        /* Add and remove handlers while other threads dispatch events */
+        while (!self->m_stop) {
+            status = ucm_set_event_handler(UCM_EVENT_VM_UNMAPPED |
+                                           UCM_EVENT_FLAG_ADDR_RANGES, 0,
+                                           range_event_callback, self);
+            EXPECT_UCS_OK(status);
+
+            ptr = malloc(small_alloc_size);
+            ucm_add_event_range(range_event_callback, self, ptr,
+                                small_alloc_size);
+            ucm_remove_event_range(range_event_callback, self, ptr,
+                                   small_alloc_size);
+            free(ptr);
+
+            ucm_unset_event_handler(UCM_EVENT_VM_UNMAPPED |
+                                    UCM_EVENT_FLAG_ADDR_RANGES,
+                                    range_event_callback, self);
+        }
+        return NULL;
+    }
+
+protected:
+    static const int       max_threads = 4;
+    static const int       num_iters;
+    static const uintptr_t test_range;
+
+    volatile int           m_stop;
+    volatile uint32_t      m_thread_index;
+    void * volatile        m_mapped[max_threads]; /* Buffer each thread unmaps */
+    volatile uint32_t      m_unmapped_count;
+    volatile uint32_t      m_range_count;
+};
+
+const int malloc_hook_stress::num_iters = 1000 / ucs::test_time_multiplier();
+
+/* 2MB-aligned address which is not expected to be mapped */
+const uintptr_t malloc_hook_stress::test_range = 0x7e0000000000ul;
+
+UCS_TEST_F(malloc_hook_stress, mmap_munmap) {
+    pthread_t alloc_threads[max_threads];
+    pthread_t handler_thread;
+    ucs_status_t status;
+    int num_threads;
+    int ret;
+
+    status = ucm_set_event_handler(UCM_EVENT_VM_UNMAPPED, 0, mem_event_callback,
+                                   reinterpret_cast<void*>(this));
+    ASSERT_UCS_OK(status);
+
+    ret = pthread_create(&handler_thread, NULL, handler_thread_func,
+                         reinterpret_cast<void*>(this));
+    if (ret != 0) {
+        ucm_unset_event_handler(UCM_EVENT_VM_UNMAPPED, mem_event_callback,
+                                reinterpret_cast<void*>(this));
+        UCS_TEST_ABORT("pthread_create() failed: " << strerror(ret));
+    }
+
+    for (num_threads = 0; num_threads < max_threads; ++num_threads) {
+        ret = pthread_create(&alloc_threads[num_threads], NULL,
+                             alloc_thread_func, reinterpret_cast<void*>(this));
+        if (ret != 0) {
+            ADD_FAILURE() << "pthread_create() failed: " << strerror(ret);
+            break;
+        }
+    }
+
+    for (int i = 0; i < num_threads; ++i) {
+        pthread_join(alloc_threads[i], NULL);
+    }
+    m_stop = 1;
+    pthread_join(handler_thread, NULL);
+
+    ucm_unset_event_handler(UCM_EVENT_VM_UNMAPPED, mem_event_callback,
+                            reinterpret_cast<void*>(this));
+
+    /* Every munmap of the threads generated exactly one event */
+    EXPECT_EQ((uint32_t)(num_threads * num_iters), m_unmapped_count);
+    /* No events were generated around the test range */
+    EXPECT_EQ(0u, m_range_count);
+}
+
+UCS_TEST_F(malloc_hook_stress, addr_ranges) {
+    const size_t page_size = ucs_get_page_size();
+    char *range            = (char*)test_range;
+    ucs_status_t status;
+
+    status = ucm_set_event_handler(UCM_EVENT_VM_UNMAPPED |
+                                   UCM_EVENT_FLAG_ADDR_RANGES, 0,
+                                   range_event_callback,
+                                   reinterpret_cast<void*>(this));
+    ASSERT_UCS_OK(status);
+
+    /* No ranges - no events */
+    ucm_vm_munmap(range, page_size);
+    EXPECT_EQ(0u, m_range_count);
+
+    ucm_add_event_range(range_event_callback, this, range, 2 * UCS_MBYTE);
+
+    ucm_vm_munmap(range + page_size, page_size);
+    EXPECT_EQ(1u, m_range_count);
+
+    /* Adjacent 2MB granule does not share a hash bucket with the range */
+    ucm_vm_munmap(range + 2 * UCS_MBYTE, page_size);
+    EXPECT_EQ(1u, m_range_count);
+
+    /* Partial overlap */
+    ucm_vm_munmap(range - page_size, 2 * page_size);
+    EXPECT_EQ(2u, m_range_count);
+
+    ucm_remove_event_range(range_event_callback, this, range, 2 * UCS_MBYTE);
+
+    ucm_vm_munmap(range, page_size);
+    EXPECT_EQ(2u, m_range_count);
+
+    ucm_unset_event_handler(UCM_EVENT_VM_UNMAPPED | UCM_EVENT_FLAG_ADDR_RANGES,
+                            range_event_callback, reinterpret_cast<void*>(this));
+}
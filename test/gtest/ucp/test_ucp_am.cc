@@ -0,0 +1,224 @@
+/**
+* Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+*
+* See file LICENSE for terms.
+*/
+
+#include "ucp_test.h"
+
+#include <common/test_helpers.h>
+
+
+class test_ucp_am : public ucp_test {
+public:
+    static ucp_params_t get_ctx_params() {
+        ucp_params_t params = ucp_test::get_ctx_params();
+        params.features     = UCP_FEATURE_AM;
+        return params;
+    }
+
+    virtual void init() {
+        ucp_test::init();
+        sender().connect(&receiver());
+    }
+
+    virtual void cleanup() {
+        for (std::vector<void*>::iterator iter = m_kept.begin();
+             iter != m_kept.end(); ++iter) {
+            ucp_am_data_release(receiver().worker(), *iter);
+        }
+        m_kept.clear();
+        ucp_test::cleanup();
+    }
+
+protected:
+    static const uint16_t AM_ID = 5;
+
+    struct message {
+        std::string data;
+        unsigned    flags;
+    };
+
+    static ucs_status_t am_handler(void *arg, void *data, size_t length,
+                                   unsigned flags) {
+        test_ucp_am *self = reinterpret_cast<test_ucp_am*>(arg);
+        message msg;
+
+        msg.data  = std::string((const char*)data, length);
+        msg.flags = flags;
+        self->m_received.push_back(msg);
+
+        if (self->m_keep) {
+            EXPECT_TRUE(flags & UCP_AM_FLAG_PERSISTENT_DATA);
+            self->m_kept.push_back(data);
+            return UCS_INPROGRESS;
+        }
+        return UCS_OK;
+    }
+
+    static void send_callback(void *request, ucs_status_t status) {
+    }
+
+    void set_handler(uint16_t id, uint32_t flags = 0) {
+        ucs_status_t status = ucp_worker_set_am_handler(receiver().worker(), id,
+                                                        am_handler, this, flags);
+        ASSERT_UCS_OK(status);
+    }
+
+    void send_b(uint16_t id, const void *buffer, size_t count,
+                ucp_datatype_t datatype) {
+        void *req = ucp_am_send_nb(sender().ep(), id, buffer, count, datatype,
+                                   send_callback);
+        if (UCS_PTR_IS_PTR(req)) {
+            wait(req);
+        } else {
+            ASSERT_UCS_OK(UCS_PTR_STATUS(req));
+        }
+    }
+
+    void wait_for_messages(size_t count) {
+        ucs_time_t deadline = ucs_get_time() + ucs_time_from_sec(10.0);
+        while ((m_received.size() < count) && (ucs_get_time() < deadline)) {
+            progress();
+        }
+        ASSERT_EQ(count, m_received.size());
+    }
+
+    void test_xfer(size_t size, uint32_t handler_flags = 0) {
+        std::string sbuf(size, 0);
+
+        ucs::fill_random(sbuf.begin(), sbuf.end());
+        set_handler(AM_ID, handler_flags);
+        send_b(AM_ID, &sbuf[0], size, ucp_dt_make_contig(1));
+        wait_for_messages(1);
+        EXPECT_EQ(sbuf, m_received.back().data);
+    }
+
+    void test_xfer_sizes(uint32_t handler_flags = 0) {
+        static const size_t sizes[] = { 0, 1, 8, 100, 1000, 10000, 100000,
+                                        1000000 };
+
+        for (unsigned i = 0; i < ucs_static_array_size(sizes); ++i) {
+            m_received.clear();
+            test_xfer(sizes[i], handler_flags);
+        }
+    }
+
+    test_ucp_am() : m_keep(false) {
+    }
+
+    std::vector<message> m_received;
+    std::vector<void*>   m_kept;
+    bool                 m_keep;
+};
+
+
+UCS_TEST_P(test_ucp_am, send_recv) {
+    test_xfer_sizes();
+}
+
+UCS_TEST_P(test_ucp_am, send_recv_zcopy, "ZCOPY_THRESH=1") {
+    test_xfer_sizes();
+}
+
+UCS_TEST_P(test_ucp_am, send_recv_iov) {
+    const size_t iovcnt = 20, length = 5000;
+    std::string sbuf(iovcnt * length, 0), expected;
+    ucp_dt_iov_t iov[iovcnt];
+
+    ucs::fill_random(sbuf.begin(), sbuf.end());
+    for (size_t i = 0; i < iovcnt; ++i) {
+        /* Skip every other half of the buffer */
+        iov[i].buffer = &sbuf[i * length];
+        iov[i].length = length / 2;
+        expected     += sbuf.substr(i * length, length / 2);
+    }
+
+    set_handler(AM_ID);
+    send_b(AM_ID, iov, iovcnt, ucp_dt_make_iov());
+    wait_for_messages(1);
+    EXPECT_EQ(expected, m_received.back().data);
+}
+
+UCS_TEST_P(test_ucp_am, order) {
+    const unsigned count = 1000;
+
+    set_handler(AM_ID);
+    for (unsigned i = 0; i < count; ++i) {
+        /* Mix short, single and multi-fragment messages */
+        std::string sbuf((i % 3) ? 8 : 20000, 0);
+        *(unsigned*)&sbuf[0] = i;
+        send_b(AM_ID, &sbuf[0], sbuf.size(), ucp_dt_make_contig(1));
+    }
+
+    wait_for_messages(count);
+    for (unsigned i = 0; i < count; ++i) {
+        EXPECT_EQ(i, *(const unsigned*)m_received[i].data.data());
+    }
+}
+
+UCS_TEST_P(test_ucp_am, multiple_ids) {
+    const uint16_t max_id = 100;
+
+    for (uint16_t id = 0; id < max_id; id += 7) {
+        set_handler(id);
+    }
+    for (uint16_t id = 0; id < max_id; id += 7) {
+        send_b(id, &id, sizeof(id), ucp_dt_make_contig(1));
+    }
+
+    wait_for_messages((max_id + 6) / 7);
+    for (size_t i = 0; i < m_received.size(); ++i) {
+        EXPECT_EQ(i * 7, *(const uint16_t*)m_received[i].data.data());
+    }
+}
+
+UCS_TEST_P(test_ucp_am, no_handler) {
+    uint64_t data = 0;
+
+    set_handler(AM_ID);
+    ASSERT_UCS_OK(ucp_worker_set_am_handler(receiver().worker(), AM_ID, NULL,
+                                            NULL, 0));
+
+    disable_errors();
+    send_b(AM_ID, &data, sizeof(data), ucp_dt_make_contig(1));
+    send_b(AM_ID + 100, &data, sizeof(data), ucp_dt_make_contig(1));
+    short_progress_loop();
+    restore_errors();
+    EXPECT_EQ(0ul, m_received.size());
+
+    /* The worker is usable after dropping messages */
+    set_handler(AM_ID);
+    send_b(AM_ID, &data, sizeof(data), ucp_dt_make_contig(1));
+    wait_for_messages(1);
+}
+
+UCS_TEST_P(test_ucp_am, keep_data) {
+    static const size_t sizes[] = { 8, 1000, 100000 };
+    std::vector<std::string> sent;
+
+    m_keep = true;
+    set_handler(AM_ID, UCP_AM_FLAG_PERSISTENT_DATA);
+    for (unsigned i = 0; i < ucs_static_array_size(sizes); ++i) {
+        std::string sbuf(sizes[i], 0);
+        ucs::fill_random(sbuf.begin(), sbuf.end());
+        send_b(AM_ID, &sbuf[0], sbuf.size(), ucp_dt_make_contig(1));
+        sent.push_back(sbuf);
+    }
+
+    wait_for_messages(sent.size());
+
+    /* The kept data is still valid after more messages arrived */
+    for (unsigned i = 0; i < sent.size(); ++i) {
+        EXPECT_EQ(sent[i], std::string((const char*)m_kept[i], sent[i].size()));
+        ucp_am_data_release(receiver().worker(), m_kept[i]);
+    }
+    m_kept.clear();
+}
+
+UCS_TEST_P(test_ucp_am, persistent_data_flag) {
+    test_xfer_sizes(UCP_AM_FLAG_PERSISTENT_DATA);
+    EXPECT_TRUE(m_received.back().flags & UCP_AM_FLAG_PERSISTENT_DATA);
+}
+
+UCP_INSTANTIATE_TEST_CASE(test_ucp_am)
@@ -8,8 +8,11 @@
 #include "test_ucp_atomic.h"
 extern "C" {
 #include <ucp/core/ucp_context.h>
+#include <ucp/core/ucp_worker.h>
 }
 
+#include <map>
+
 std::vector<ucp_test_param>
 test_ucp_atomic::enum_test_params(const ucp_params_t& ctx_params,
                                   const ucp_worker_params_t& worker_params,
@@ -209,6 +212,45 @@ void test_ucp_atomic::unaligned_nb_add64(entity *e,  size_t max_size,
     expected_data.clear();
 }
 
+template <typename T>
+void test_ucp_atomic::nb_add_many(entity *e,  size_t max_size, void *memheap_addr,
+                                  ucp_rkey_h rkey, std::string& expected_data)
+{
+    /* Many additions to few counters, mixed with fetching additions which
+     * must observe all previous ones */
+    static const unsigned num_counters = 4;
+    static const unsigned count        = 200;
+    T *counters                        = (T*)memheap_addr;
+    std::vector<T> expected(counters, counters + num_counters);
+    ucs_status_t status;
+    T add, result;
+    void *amo_req;
+
+    for (unsigned i = 0; i < count; ++i) {
+        unsigned index = rand() % num_counters;
+        add            = (T)rand() * (T)rand();
+
+        if ((i % 17) == 0) {
+            amo_req = ucp_atomic_fetch<T>(e->ep(), UCP_ATOMIC_FETCH_OP_FADD,
+                                          add, &result, &counters[index], rkey);
+            if (UCS_PTR_IS_PTR(amo_req)) {
+                wait(amo_req);
+            } else {
+                ASSERT_UCS_OK(UCS_PTR_STATUS(amo_req));
+            }
+            EXPECT_EQ(expected[index], result);
+        } else {
+            status = ucp_atomic_post_nbi<T>(e->ep(), UCP_ATOMIC_POST_OP_ADD,
+                                            add, &counters[index], rkey);
+            ASSERT_TRUE((status == UCS_OK) || (status == UCS_INPROGRESS));
+        }
+        expected[index] += add;
+    }
+
+    expected_data.resize(num_counters * sizeof(T));
+    memcpy(&expected_data[0], &expected[0], num_counters * sizeof(T));
+}
+
 template <typename T>
 ucs_status_ptr_t test_ucp_atomic::ucp_atomic_fetch(ucp_ep_h ep, 
                                                    ucp_atomic_fetch_op_t opcode,
@@ -296,6 +338,172 @@ void test_ucp_atomic::nb_cswap(entity *e,  size_t max_size, void *memheap_addr,
     }
 }
 
+std::map<uct_iface_h, uct_iface_ops_t> test_ucp_atomic::s_orig_ops;
+unsigned test_ucp_atomic::s_num_failures = 0;
+unsigned test_ucp_atomic::s_num_adds     = 0;
+
+void test_ucp_atomic::install_hooks(entity *e, unsigned num_failures) {
+    ucp_worker_h worker = e->worker();
+
+    for (ucp_rsc_index_t rsc = 0; rsc < e->ucph()->num_tls; ++rsc) {
+        uct_iface_h iface           = worker->ifaces[rsc];
+        s_orig_ops[iface]           = iface->ops;
+        iface->ops.ep_atomic_add32  = atomic_add32_hook;
+        iface->ops.ep_atomic_add64  = atomic_add64_hook;
+    }
+    s_num_failures = num_failures;
+    s_num_adds     = 0;
+}
+
+void test_ucp_atomic::restore_ops() {
+    for (std::map<uct_iface_h, uct_iface_ops_t>::iterator iter =
+         s_orig_ops.begin(); iter != s_orig_ops.end(); ++iter) {
+        iter->first->ops = iter->second;
+    }
+    s_orig_ops.clear();
+}
+
+ucs_status_t test_ucp_atomic::atomic_add32_hook(uct_ep_h ep, uint32_t add,
+                                                uint64_t remote_addr,
+                                                uct_rkey_t rkey) {
+    ++s_num_adds;
+    if (s_num_failures > 0) {
+        --s_num_failures;
+        return UCS_ERR_IO_ERROR;
+    }
+    return s_orig_ops[ep->iface].ep_atomic_add32(ep, add, remote_addr, rkey);
+}
+
+ucs_status_t test_ucp_atomic::atomic_add64_hook(uct_ep_h ep, uint64_t add,
+                                                uint64_t remote_addr,
+                                                uct_rkey_t rkey) {
+    ++s_num_adds;
+    if (s_num_failures > 0) {
+        --s_num_failures;
+        return UCS_ERR_IO_ERROR;
+    }
+    return s_orig_ops[ep->iface].ep_atomic_add64(ep, add, remote_addr, rkey);
+}
+
+template <typename T>
+void test_ucp_atomic::nb_add_aggregated(entity *e,  size_t max_size,
+                                        void *memheap_addr, ucp_rkey_h rkey,
+                                        std::string& expected_data)
+{
+    static const unsigned count = 100;
+    T expected                  = *(T*)memheap_addr;
+    ucs_status_t status;
+    T add;
+
+    install_hooks(e);
+    for (unsigned i = 0; i < count; ++i) {
+        add    = (T)rand() * (T)rand();
+        status = ucp_atomic_post_nbi<T>(e->ep(), UCP_ATOMIC_POST_OP_ADD, add,
+                                        memheap_addr, rkey);
+        ASSERT_UCS_OK(status);
+        expected += add;
+    }
+
+    /* Nothing is sent before the flush, which sends one combined atomic */
+    EXPECT_EQ(0u, s_num_adds);
+    e->flush_worker();
+    restore_ops();
+    EXPECT_EQ(1u, s_num_adds);
+
+    expected_data.resize(sizeof(T));
+    *(T*)&expected_data[0] = expected;
+}
+
+template <typename T>
+void test_ucp_atomic::nb_add_aggregated_evict(entity *e,  size_t max_size,
+                                              void *memheap_addr, ucp_rkey_h rkey,
+                                              std::string& expected_data)
+{
+    /* Requires a single aggregation entry, so the counters evict each other */
+    static const unsigned count     = 10;
+    static const unsigned num_steps = 3;
+    static const unsigned order[num_steps] = {0, 1, 0};
+    T *counters                     = (T*)memheap_addr;
+    std::vector<T> expected(counters, counters + 2);
+    ucs_status_t status;
+    T add;
+
+    install_hooks(e);
+    for (unsigned i = 0; i < num_steps; ++i) {
+        for (unsigned j = 0; j < count; ++j) {
+            add    = (T)rand() * (T)rand();
+            status = ucp_atomic_post_nbi<T>(e->ep(), UCP_ATOMIC_POST_OP_ADD,
+                                            add, &counters[order[i]], rkey);
+            ASSERT_UCS_OK(status);
+            expected[order[i]] += add;
+        }
+
+        /* Switching to another counter sent the previous one */
+        EXPECT_EQ(i, s_num_adds);
+    }
+
+    e->flush_worker();
+    restore_ops();
+    EXPECT_EQ(num_steps, s_num_adds);
+
+    expected_data.resize(2 * sizeof(T));
+    memcpy(&expected_data[0], &expected[0], 2 * sizeof(T));
+}
+
+template <typename T>
+void test_ucp_atomic::nb_add_aggregated_fence(entity *e,  size_t max_size,
+                                              void *memheap_addr, ucp_rkey_h rkey,
+                                              std::string& expected_data)
+{
+    static const unsigned count = 10;
+    T expected                  = *(T*)memheap_addr;
+    ucs_status_t status;
+    void *amo_req;
+    T add, result;
+
+    install_hooks(e);
+
+    /* A fence sends the combined addition */
+    for (unsigned i = 0; i < count; ++i) {
+        add    = (T)rand() * (T)rand();
+        status = ucp_atomic_post_nbi<T>(e->ep(), UCP_ATOMIC_POST_OP_ADD, add,
+                                        memheap_addr, rkey);
+        ASSERT_UCS_OK(status);
+        expected += add;
+    }
+    EXPECT_EQ(0u, s_num_adds);
+    status = ucp_worker_fence(e->worker());
+    ASSERT_UCS_OK(status);
+    EXPECT_EQ(1u, s_num_adds);
+
+    /* A fetching atomic to the same address sends it before itself */
+    for (unsigned i = 0; i < count; ++i) {
+        add    = (T)rand() * (T)rand();
+        status = ucp_atomic_post_nbi<T>(e->ep(), UCP_ATOMIC_POST_OP_ADD, add,
+                                        memheap_addr, rkey);
+        ASSERT_UCS_OK(status);
+        expected += add;
+    }
+    EXPECT_EQ(1u, s_num_adds);
+    amo_req = ucp_atomic_fetch<T>(e->ep(), UCP_ATOMIC_FETCH_OP_FADD, 0, &result,
+                                  memheap_addr, rkey);
+    if (UCS_PTR_IS_PTR(amo_req)) {
+        wait(amo_req);
+    } else {
+        ASSERT_UCS_OK(UCS_PTR_STATUS(amo_req));
+    }
+    EXPECT_EQ(2u, s_num_adds);
+    EXPECT_EQ(expected, result);
+
+    /* The flush has nothing left to send */
+    e->flush_worker();
+    restore_ops();
+    EXPECT_EQ(2u, s_num_adds);
+
+    expected_data.resize(sizeof(T));
+    *(T*)&expected_data[0] = expected;
+}
+
 template <typename T, typename F>
 void test_ucp_atomic::test(F f, bool malloc_allocate) {
     test_blocking_xfer(static_cast<blocking_send_func_t>(f), 
@@ -324,6 +532,29 @@ UCS_TEST_P(test_ucp_atomic32, atomic_add_nb) {
     test<uint32_t>(&test_ucp_atomic32::nb_add<uint32_t>, true);
 }
 
+UCS_TEST_P(test_ucp_atomic32, atomic_add_nb_many) {
+    test<uint32_t>(&test_ucp_atomic32::nb_add_many<uint32_t>, false);
+}
+
+UCS_TEST_P(test_ucp_atomic32, atomic_add_nb_aggregate, "AMO_AGGREGATE=16") {
+    test<uint32_t>(&test_ucp_atomic32::nb_add_many<uint32_t>, false);
+    test<uint32_t>(&test_ucp_atomic32::blocking_add<uint32_t>, true);
+}
+
+UCS_TEST_P(test_ucp_atomic32, atomic_add_nb_aggregate_count, "AMO_AGGREGATE=16") {
+    test<uint32_t>(&test_ucp_atomic32::nb_add_aggregated<uint32_t>, false);
+}
+
+UCS_TEST_P(test_ucp_atomic32, atomic_add_nb_aggregate_evict_count,
+           "AMO_AGGREGATE=1") {
+    test<uint32_t>(&test_ucp_atomic32::nb_add_aggregated_evict<uint32_t>, false);
+}
+
+UCS_TEST_P(test_ucp_atomic32, atomic_add_nb_aggregate_fence_count,
+           "AMO_AGGREGATE=16") {
+    test<uint32_t>(&test_ucp_atomic32::nb_add_aggregated_fence<uint32_t>, false);
+}
+
 UCS_TEST_P(test_ucp_atomic32, atomic_fadd) {
     test<uint32_t>(&test_ucp_atomic32::blocking_fadd<uint32_t>, false);
     test<uint32_t>(&test_ucp_atomic32::blocking_fadd<uint32_t>, true);
@@ -363,8 +594,108 @@ public:
         params.features |= UCP_FEATURE_AMO64;
         return params;
     }
+
+    void nb_add_evict_error(entity *e,  size_t max_size, void *memheap_addr,
+                            ucp_rkey_h rkey, std::string& expected_data);
+
+    void nb_add_rkey_destroy(entity *e,  size_t max_size, void *memheap_addr,
+                             ucp_rkey_h rkey, std::string& expected_data);
+
 };
 
+void test_ucp_atomic64::nb_add_evict_error(entity *e,  size_t max_size,
+                                           void *memheap_addr, ucp_rkey_h rkey,
+                                           std::string& expected_data)
+{
+    uint64_t *counters = (uint64_t*)memheap_addr;
+    std::vector<uint64_t> expected(counters, counters + 2);
+    uint64_t add[2];
+    ucs_status_t status;
+
+    add[0] = (uint64_t)rand() * (uint64_t)rand();
+    add[1] = (uint64_t)rand() * (uint64_t)rand();
+
+    /* Kept in the single aggregation entry */
+    status = ucp_atomic_post(e->ep(), UCP_ATOMIC_POST_OP_ADD, add[0],
+                             sizeof(uint64_t), (uintptr_t)&counters[0], rkey);
+    ASSERT_UCS_OK(status);
+
+    /* Evicting the first counter fails. The second addition must still be
+     * posted, and the first one must be sent by the following flush. */
+    install_hooks(e, 1);
+    status = ucp_atomic_post(e->ep(), UCP_ATOMIC_POST_OP_ADD, add[1],
+                             sizeof(uint64_t), (uintptr_t)&counters[1], rkey);
+    restore_ops();
+    ASSERT_UCS_OK(status);
+    EXPECT_EQ(0u, s_num_failures);
+
+    expected[0] += add[0];
+    expected[1] += add[1];
+    expected_data.resize(2 * sizeof(uint64_t));
+    memcpy(&expected_data[0], &expected[0], 2 * sizeof(uint64_t));
+}
+
+void test_ucp_atomic64::nb_add_rkey_destroy(entity *e,  size_t max_size,
+                                            void *memheap_addr, ucp_rkey_h rkey,
+                                            std::string& expected_data)
+{
+    static const unsigned count = 10;
+    uint64_t expected           = 0;
+    ucp_mem_map_params_t params;
+    ucp_rkey_h other_rkey;
+    size_t rkey_buffer_size;
+    void *rkey_buffer;
+    ucs_status_t status;
+    uint64_t *counter;
+    ucp_mem_h memh;
+    uint64_t add;
+
+    /* Additions which use another key of the receiver */
+    params.field_mask = UCP_MEM_MAP_PARAM_FIELD_ADDRESS |
+                        UCP_MEM_MAP_PARAM_FIELD_LENGTH |
+                        UCP_MEM_MAP_PARAM_FIELD_FLAGS;
+    params.address    = NULL;
+    params.length     = sizeof(*counter);
+    params.flags      = GetParam().variant;
+    status = ucp_mem_map(receiver().ucph(), &params, &memh);
+    ASSERT_UCS_OK(status);
+
+    counter  = (uint64_t*)params.address;
+    *counter = 0;
+
+    status = ucp_rkey_pack(receiver().ucph(), memh, &rkey_buffer,
+                           &rkey_buffer_size);
+    ASSERT_UCS_OK(status);
+    status = ucp_ep_rkey_unpack(e->ep(), rkey_buffer, &other_rkey);
+    ASSERT_UCS_OK(status);
+    ucp_rkey_buffer_release(rkey_buffer);
+
+    install_hooks(e);
+    for (unsigned i = 0; i < count; ++i) {
+        add    = (uint64_t)rand() * (uint64_t)rand();
+        status = ucp_atomic_post(e->ep(), UCP_ATOMIC_POST_OP_ADD, add,
+                                 sizeof(uint64_t), (uintptr_t)counter,
+                                 other_rkey);
+        ASSERT_UCS_OK(status);
+        expected += add;
+    }
+    EXPECT_EQ(0u, s_num_adds);
+
+    /* Destroying the key sends the pending addition, which uses it */
+    ucp_rkey_destroy(other_rkey);
+    EXPECT_EQ(1u, s_num_adds);
+
+    e->flush_worker();
+    restore_ops();
+    EXPECT_EQ(1u, s_num_adds);
+    EXPECT_EQ(expected, *counter);
+
+    status = ucp_mem_unmap(receiver().ucph(), memh);
+    ASSERT_UCS_OK(status);
+
+    expected_data.clear();
+}
+
 UCS_TEST_P(test_ucp_atomic64, atomic_add) {
     test<uint64_t>(&test_ucp_atomic64::blocking_add<uint64_t>, false);
     test<uint64_t>(&test_ucp_atomic64::blocking_add<uint64_t>, true);
@@ -375,6 +706,44 @@ UCS_TEST_P(test_ucp_atomic64, atomic_add_nb) {
     test<uint64_t>(&test_ucp_atomic64::nb_add<uint64_t>, true);
 }
 
+UCS_TEST_P(test_ucp_atomic64, atomic_add_nb_many) {
+    test<uint64_t>(&test_ucp_atomic64::nb_add_many<uint64_t>, false);
+}
+
+UCS_TEST_P(test_ucp_atomic64, atomic_add_nb_aggregate, "AMO_AGGREGATE=16") {
+    test<uint64_t>(&test_ucp_atomic64::nb_add_many<uint64_t>, false);
+    test<uint64_t>(&test_ucp_atomic64::blocking_add<uint64_t>, true);
+}
+
+/* A single entry, so additions to different counters evict each other */
+UCS_TEST_P(test_ucp_atomic64, atomic_add_nb_aggregate_evict, "AMO_AGGREGATE=1") {
+    test<uint64_t>(&test_ucp_atomic64::nb_add_many<uint64_t>, false);
+}
+
+UCS_TEST_P(test_ucp_atomic64, atomic_add_nb_aggregate_count, "AMO_AGGREGATE=16") {
+    test<uint64_t>(&test_ucp_atomic64::nb_add_aggregated<uint64_t>, false);
+}
+
+UCS_TEST_P(test_ucp_atomic64, atomic_add_nb_aggregate_evict_count,
+           "AMO_AGGREGATE=1") {
+    test<uint64_t>(&test_ucp_atomic64::nb_add_aggregated_evict<uint64_t>, false);
+}
+
+UCS_TEST_P(test_ucp_atomic64, atomic_add_nb_aggregate_fence_count,
+           "AMO_AGGREGATE=16") {
+    test<uint64_t>(&test_ucp_atomic64::nb_add_aggregated_fence<uint64_t>, false);
+}
+
+UCS_TEST_P(test_ucp_atomic64, atomic_add_nb_aggregate_rkey_destroy,
+           "AMO_AGGREGATE=16") {
+    test<uint64_t>(&test_ucp_atomic64::nb_add_rkey_destroy, false);
+}
+
+UCS_TEST_P(test_ucp_atomic64, atomic_add_nb_aggregate_evict_error,
+           "AMO_AGGREGATE=1") {
+    test<uint64_t>(&test_ucp_atomic64::nb_add_evict_error, false);
+}
+
 UCS_TEST_P(test_ucp_atomic64, atomic_fadd) {
     test<uint64_t>(&test_ucp_atomic64::blocking_fadd<uint64_t>, false);
     test<uint64_t>(&test_ucp_atomic64::blocking_fadd<uint64_t>, true);
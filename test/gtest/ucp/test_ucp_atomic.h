@@ -9,6 +9,11 @@
 #define TEST_UCP_ATOMIC_H_
 
 #include "test_ucp_memheap.h"
+extern "C" {
+#include <uct/api/uct.h>
+}
+
+#include <map>
 
 
 class test_ucp_atomic : public test_ucp_memheap {
@@ -50,6 +55,10 @@ public:
     void unaligned_nb_add64(entity *e,  size_t max_size, void *memheap_addr,
                             ucp_rkey_h rkey, std::string& expected_data);
 
+    template <typename T>
+    void nb_add_many(entity *e,  size_t max_size, void *memheap_addr,
+                     ucp_rkey_h rkey, std::string& expected_data);
+
     template <typename T>
     void nb_fadd(entity *e,  size_t max_size, void *memheap_addr,
                  ucp_rkey_h rkey, std::string& expected_data);
@@ -62,10 +71,40 @@ public:
     void nb_cswap(entity *e,  size_t max_size, void *memheap_addr,
                         ucp_rkey_h rkey, std::string& expected_data);
     
+    template <typename T>
+    void nb_add_aggregated(entity *e,  size_t max_size, void *memheap_addr,
+                           ucp_rkey_h rkey, std::string& expected_data);
+
+    template <typename T>
+    void nb_add_aggregated_evict(entity *e,  size_t max_size, void *memheap_addr,
+                                 ucp_rkey_h rkey, std::string& expected_data);
+
+    template <typename T>
+    void nb_add_aggregated_fence(entity *e,  size_t max_size, void *memheap_addr,
+                                 ucp_rkey_h rkey, std::string& expected_data);
+
     template <typename T, typename F>
     void test(F f, bool malloc_allocate);
 
+protected:
+    /* Count the UCT atomic additions of an entity, and fail the first
+     * num_failures of them */
+    void install_hooks(entity *e, unsigned num_failures = 0);
+
+    void restore_ops();
+
+    static std::map<uct_iface_h, uct_iface_ops_t> s_orig_ops;
+    static unsigned                               s_num_failures;
+    static unsigned                               s_num_adds;
+
 private:
+    static ucs_status_t atomic_add32_hook(uct_ep_h ep, uint32_t add,
+                                          uint64_t remote_addr, uct_rkey_t rkey);
+
+    static ucs_status_t atomic_add64_hook(uct_ep_h ep, uint64_t add,
+                                          uint64_t remote_addr, uct_rkey_t rkey);
+
+
     static void send_completion(void *request, ucs_status_t status){}
     template <typename T>
     ucs_status_t ucp_atomic_post_nbi(ucp_ep_h ep, ucp_atomic_post_op_t opcode,
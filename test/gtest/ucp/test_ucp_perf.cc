@@ -96,4 +96,19 @@ UCS_TEST_P(test_ucp_perf, envelope) {
     }
 }
 
+UCS_TEST_P(test_ucp_perf, worker_threads) {
+    static const thread_spec threads = { 2, UCX_PERF_THREAD_MODEL_WORKER, true };
+
+    /* UCP reuses the endpoint to a remote worker, so only the worker thread
+     * model is supported */
+    std::stringstream ss;
+    ss << GetParam();
+    ucs::scoped_setenv tls("UCX_TLS", ss.str().c_str());
+    for (test_spec *test = tests; test->title != NULL; ++test) {
+        unsigned flags = (test->command == UCX_PERF_CMD_TAG) ? 0 :
+                                 UCX_PERF_TEST_FLAG_ONE_SIDED;
+        run_test(*test, flags, false, "", "", threads);
+    }
+}
+
 UCP_INSTANTIATE_TEST_CASE(test_ucp_perf)
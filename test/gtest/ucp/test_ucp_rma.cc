@@ -82,9 +82,130 @@ public:
         ASSERT_UCS_OK(status);
     }
 
+    void blocking_put_nb(entity *e, size_t max_size,
+                         void *memheap_addr,
+                         ucp_rkey_h rkey,
+                         std::string& expected_data)
+    {
+        void *req = ucp_put_nb(e->ep(), &expected_data[0], expected_data.length(),
+                               (uintptr_t)memheap_addr, rkey, send_callback);
+        wait_nb(req);
+    }
+
+    void blocking_get_nb(entity *e, size_t max_size,
+                         void *memheap_addr,
+                         ucp_rkey_h rkey,
+                         std::string& expected_data)
+    {
+        ucs::fill_random((char*)memheap_addr, (char*)memheap_addr + ucs_min(max_size, 16384U));
+        void *req = ucp_get_nb(e->ep(), (void *)&expected_data[0], expected_data.length(),
+                               (uintptr_t)memheap_addr, rkey, send_callback);
+        wait_nb(req);
+    }
+
+    void nonblocking_put_nb(entity *e, size_t max_size,
+                            void *memheap_addr,
+                            ucp_rkey_h rkey,
+                            std::string& expected_data)
+    {
+        void *req = ucp_put_nb(e->ep(), &expected_data[0], expected_data.length(),
+                               (uintptr_t)memheap_addr, rkey, send_callback);
+        add_request(req);
+    }
+
+    void nonblocking_get_nb(entity *e, size_t max_size,
+                            void *memheap_addr,
+                            ucp_rkey_h rkey,
+                            std::string& expected_data)
+    {
+        ucs::fill_random((char*)memheap_addr, (char*)memheap_addr + ucs_min(max_size, 16384U));
+        void *req = ucp_get_nb(e->ep(), (void *)&expected_data[0], expected_data.length(),
+                               (uintptr_t)memheap_addr, rkey, send_callback);
+        add_request(req);
+    }
+
+    void put_nbi_flush_ep_nb(entity *e, size_t max_size,
+                             void *memheap_addr,
+                             ucp_rkey_h rkey,
+                             std::string& expected_data)
+    {
+        nonblocking_put_nbi(e, max_size, memheap_addr, rkey, expected_data);
+        wait_nb(ucp_ep_flush_nb(e->ep(), 0, send_callback));
+        EXPECT_EQ(expected_data,
+                  std::string((char*)memheap_addr, expected_data.length()));
+    }
+
+    void put_nbi_flush_worker_nb(entity *e, size_t max_size,
+                                 void *memheap_addr,
+                                 ucp_rkey_h rkey,
+                                 std::string& expected_data)
+    {
+        nonblocking_put_nbi(e, max_size, memheap_addr, rkey, expected_data);
+        wait_nb(ucp_worker_flush_nb(e->worker(), 0, send_callback));
+        EXPECT_EQ(expected_data,
+                  std::string((char*)memheap_addr, expected_data.length()));
+    }
+
     void test_message_sizes(blocking_send_func_t func, size_t *msizes, int iters, int is_nbi);
+
+    void wait_requests();
+
+protected:
+    static void send_callback(void *request, ucs_status_t status)
+    {
+        ASSERT_UCS_OK(status);
+        ++m_num_callbacks;
+    }
+
+    void wait_nb(void *req)
+    {
+        size_t num_callbacks = m_num_callbacks;
+
+        if (UCS_PTR_IS_PTR(req)) {
+            wait(req);
+            EXPECT_EQ(num_callbacks + 1, m_num_callbacks);
+        } else {
+            ASSERT_UCS_OK(UCS_PTR_STATUS(req));
+        }
+    }
+
+    void add_request(void *req)
+    {
+        if (UCS_PTR_IS_PTR(req)) {
+            if (m_reqs.empty()) {
+                /* a new batch of requests starts */
+                m_batch_num_callbacks = m_num_callbacks;
+            }
+            m_reqs.push_back(req);
+        } else {
+            ASSERT_UCS_OK(UCS_PTR_STATUS(req));
+        }
+    }
+
+    static size_t      m_num_callbacks;
+    size_t             m_batch_num_callbacks; /* m_num_callbacks when the
+                                                 current batch started */
+    std::vector<void*> m_reqs;
 };
 
+size_t test_ucp_rma::m_num_callbacks = 0;
+
+void test_ucp_rma::wait_requests()
+{
+    if (m_reqs.empty()) {
+        return;
+    }
+
+    /* All requests are completed by the flush, with a callback for each one */
+    EXPECT_EQ(m_reqs.size(), m_num_callbacks - m_batch_num_callbacks);
+    for (std::vector<void*>::iterator iter = m_reqs.begin();
+         iter != m_reqs.end(); ++iter) {
+        EXPECT_EQ(UCS_OK, ucp_request_test(*iter, NULL));
+        ucp_request_release(*iter);
+    }
+    m_reqs.clear();
+}
+
 void test_ucp_rma::test_message_sizes(blocking_send_func_t func, size_t *msizes, int iters, int is_nbi)
 {
    int i;
@@ -255,5 +376,57 @@ UCS_TEST_P(test_ucp_rma, nonblocking_stream_get_nbi_flush_ep) {
                        1, true, true);
 }
 
+UCS_TEST_P(test_ucp_rma, nb_small) {
+    size_t sizes[] = { 8, 24, 96, 120, 250, 0};
+
+    test_message_sizes(static_cast<blocking_send_func_t>(&test_ucp_rma::blocking_put_nb),
+                       sizes, 1000, 0);
+    test_message_sizes(static_cast<blocking_send_func_t>(&test_ucp_rma::blocking_get_nb),
+                       sizes, 1000, 0);
+}
+
+UCS_TEST_P(test_ucp_rma, nb_med) {
+    size_t sizes[] = { 1000, 3000, 9000, 17300, 31000, 99000, 130000, 0};
+
+    test_message_sizes(static_cast<blocking_send_func_t>(&test_ucp_rma::blocking_put_nb),
+                       sizes, 100, 0);
+    test_message_sizes(static_cast<blocking_send_func_t>(&test_ucp_rma::blocking_get_nb),
+                       sizes, 100, 0);
+}
+
+UCS_TEST_P(test_ucp_rma, nonblocking_stream_put_nb) {
+    test_nonblocking_implicit_stream_xfer(static_cast<nonblocking_send_func_t>(&test_ucp_rma::nonblocking_put_nb),
+                       DEFAULT_SIZE, DEFAULT_ITERS,
+                       1, false, false);
+    wait_requests();
+    test_nonblocking_implicit_stream_xfer(static_cast<nonblocking_send_func_t>(&test_ucp_rma::nonblocking_put_nb),
+                       DEFAULT_SIZE, DEFAULT_ITERS,
+                       1, true, true);
+    wait_requests();
+}
+
+UCS_TEST_P(test_ucp_rma, nonblocking_stream_get_nb) {
+    test_nonblocking_implicit_stream_xfer(static_cast<nonblocking_send_func_t>(&test_ucp_rma::nonblocking_get_nb),
+                       DEFAULT_SIZE, DEFAULT_ITERS,
+                       1, false, false);
+    wait_requests();
+    test_nonblocking_implicit_stream_xfer(static_cast<nonblocking_send_func_t>(&test_ucp_rma::nonblocking_get_nb),
+                       DEFAULT_SIZE, DEFAULT_ITERS,
+                       1, true, true);
+    wait_requests();
+}
+
+UCS_TEST_P(test_ucp_rma, nonblocking_put_nbi_flush_ep_nb) {
+    test_blocking_xfer(static_cast<nonblocking_send_func_t>(&test_ucp_rma::put_nbi_flush_ep_nb),
+                       DEFAULT_SIZE, DEFAULT_ITERS,
+                       1, false, true);
+}
+
+UCS_TEST_P(test_ucp_rma, nonblocking_put_nbi_flush_worker_nb) {
+    test_blocking_xfer(static_cast<nonblocking_send_func_t>(&test_ucp_rma::put_nbi_flush_worker_nb),
+                       DEFAULT_SIZE, DEFAULT_ITERS,
+                       1, false, false);
+}
+
 UCP_INSTANTIATE_TEST_CASE(test_ucp_rma)
 
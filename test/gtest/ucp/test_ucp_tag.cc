@@ -127,15 +127,14 @@ void test_ucp_tag::wait_and_validate(request *req)
     request_release(req);
 }
 
-void test_ucp_tag::wait_for_unexpected_msg(ucs_queue_head_t unexpected_q,
-                                           double sec)
+void test_ucp_tag::wait_for_unexpected_msg(ucp_worker_h worker, double sec)
 {
     /* Wait for some message to be added to unexpected queue */
     ucs_time_t timeout = ucs_get_time() + ucs_time_from_sec(sec);
 
     do {
         short_progress_loop();
-    } while (ucs_queue_is_empty(&unexpected_q) &&
+    } while (ucs_list_is_empty(&worker->tm.unexpected.all) &&
             (ucs_get_time() < timeout));
 }
 
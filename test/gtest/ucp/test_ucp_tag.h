@@ -10,8 +10,8 @@
 
 #include "ucp_test.h"
 extern "C" {
-#include <ucp/core/ucp_context.h>
-#include <ucs/datastruct/queue.h>
+#include <ucp/core/ucp_worker.h>
+#include <ucs/datastruct/list.h>
 }
 
 
@@ -84,7 +84,7 @@ protected:
 
     void wait_and_validate(request *req);
 
-    void wait_for_unexpected_msg(ucs_queue_head_t unexpected_q, double sec);
+    void wait_for_unexpected_msg(ucp_worker_h worker, double sec);
 
     static void* dt_common_start(size_t count);
 
@@ -8,6 +8,10 @@
 #include "test_ucp_tag.h"
 
 #include <common/test_helpers.h>
+#include <ucs/sys/sys.h>
+extern "C" {
+#include <ucs/datastruct/queue.h>
+}
 
 using namespace ucs; /* For vector<char> serialization */
 
@@ -537,4 +541,112 @@ UCS_TEST_P(test_ucp_tag_match, rndv_req_exp_auto_thresh, "RNDV_THRESH=auto") {
     request_release(my_recv_req);
 }
 
+UCS_TEST_P(test_ucp_tag_match, send_recv_exp_wildcard_order) {
+    uint64_t send_data[2] = { 0xdeadbeefdeadbeef, 0xfeedbabefeedbabe };
+    uint64_t recv_data[2] = { 0, 0 };
+    request *recv_req[2];
+
+    /* a request posted with a wildcard mask must be matched before a later
+     * request with a full mask, and vice versa */
+    for (int order = 0; order < 2; ++order) {
+        recv_data[0] = recv_data[1] = 0;
+        recv_req[order]     = recv_nb(&recv_data[order], sizeof(recv_data[order]),
+                                      DATATYPE, 0x1337, 0xffff);
+        recv_req[1 - order] = recv_nb(&recv_data[1 - order],
+                                      sizeof(recv_data[1 - order]), DATATYPE,
+                                      0x111337, UCP_TAG_MASK_FULL);
+
+        send_b(&send_data[0], sizeof(send_data[0]), DATATYPE, 0x111337);
+        send_b(&send_data[1], sizeof(send_data[1]), DATATYPE, 0x111337);
+
+        for (int i = 0; i < 2; ++i) {
+            ASSERT_TRUE(!UCS_PTR_IS_ERR(recv_req[i]));
+            wait(recv_req[i]);
+            EXPECT_EQ((ucp_tag_t)0x111337, recv_req[i]->info.sender_tag);
+            request_release(recv_req[i]);
+        }
+
+        EXPECT_EQ(send_data[0], recv_data[order]);
+        EXPECT_EQ(send_data[1], recv_data[1 - order]);
+    }
+}
+
 UCP_INSTANTIATE_TEST_CASE(test_ucp_tag_match)
+
+
+class test_ucp_tag_match_depth : public test_ucp_tag_match {
+protected:
+    /* Longest queue which the matching engine walks to find an expected
+     * request with a full tag mask */
+    size_t max_exp_walk()
+    {
+        ucp_tag_match_t *tm = &receiver().worker()->tm;
+        size_t max_len      = 0;
+
+        for (size_t bucket = 0; bucket < UCP_TAG_MATCH_HASH_SIZE; ++bucket) {
+            max_len = ucs_max(max_len, ucs_queue_length(&tm->expected.hash[bucket]));
+        }
+        return max_len + ucs_queue_length(&tm->expected.wildcard);
+    }
+
+    /* Post receives with distinct tags and measure the average time to match a
+     * message, starting from the most recently posted receive */
+    double match_time_nsec(unsigned depth, size_t *max_walk)
+    {
+        std::vector<uint64_t> recv_data(depth, 0);
+        std::vector<request*> reqs;
+        uint64_t send_data;
+        ucs_time_t start;
+        double time_nsec;
+
+        for (unsigned i = 0; i < depth; ++i) {
+            reqs.push_back(recv_nb(&recv_data[i], sizeof(recv_data[i]), DATATYPE,
+                                   i, UCP_TAG_MASK_FULL));
+            EXPECT_FALSE(UCS_PTR_IS_ERR(reqs.back()));
+        }
+
+        *max_walk = max_exp_walk();
+
+        start = ucs_get_time();
+        for (unsigned i = depth; i > 0; --i) {
+            send_data = i - 1;
+            send_b(&send_data, sizeof(send_data), DATATYPE, i - 1);
+        }
+        for (unsigned i = 0; i < depth; ++i) {
+            wait(reqs[i]);
+        }
+        time_nsec = ucs_time_to_nsec(ucs_get_time() - start) / depth;
+
+        for (unsigned i = 0; i < depth; ++i) {
+            EXPECT_EQ(i, recv_data[i]);
+            request_release(reqs[i]);
+        }
+
+        EXPECT_EQ(0ul, max_exp_walk());
+        return time_nsec;
+    }
+};
+
+UCS_TEST_P(test_ucp_tag_match_depth, flat_cost) {
+    static const unsigned min_depth = 16;
+    static const unsigned max_depth = 16384;
+    size_t max_walk;
+    double time;
+
+    match_time_nsec(min_depth, &max_walk); /* warmup */
+
+    for (unsigned depth = min_depth; depth <= max_depth; depth *= 4) {
+        time = match_time_nsec(depth, &max_walk);
+        UCS_TEST_MESSAGE << "queue depth " << depth << ": " << time
+                         << " nsec per message, at most " << max_walk
+                         << " requests walked";
+
+        /* consecutive tags are spread evenly over the hash buckets, so a
+         * message walks only its own bucket instead of the whole queue */
+        EXPECT_LE(max_walk, ucs_div_round_up(depth, UCP_TAG_MATCH_HASH_SIZE))
+                  << "depth " << depth;
+    }
+}
+
+UCP_INSTANTIATE_TEST_CASE_TLS(test_ucp_tag_match_depth, shm, "\\mm,\\knem,\\cma,\\xpmem,ib")
+UCP_INSTANTIATE_TEST_CASE_TLS(test_ucp_tag_match_depth, self, "\\self")
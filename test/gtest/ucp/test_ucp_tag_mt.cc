@@ -81,4 +81,43 @@ UCS_TEST_P(test_ucp_tag_mt, send_recv) {
 #endif
 }
 
+UCS_TEST_P(test_ucp_tag_mt, worker_isolation) {
+    uint64_t send_data = 0xdeadbeefdeadbeef;
+    uint64_t recv_data = 0;
+    ucp_tag_recv_info_t info;
+    ucp_tag_message_h message;
+    ucs_status_t status;
+
+    if (GetParam().thread_type != MULTI_THREAD_CONTEXT) {
+        UCS_TEST_SKIP_R("single worker");
+    }
+
+    for (int i = 0; i < MT_TEST_NUM_THREADS; i++) {
+        send_b(&send_data, sizeof(send_data), DATATYPE, 0x1337 + i, i);
+
+        /* Wait for the message to arrive on the matching receiver worker */
+        ucs_time_t timeout = ucs_get_time() + ucs_time_from_sec(10.0);
+        do {
+            progress(i);
+            message = ucp_tag_probe_nb(receiver().worker(i), 0x1337 + i,
+                                       0xffff, 0, &info);
+        } while ((message == NULL) && (ucs_get_time() < timeout));
+        ASSERT_TRUE(message != NULL);
+
+        /* Other workers of the same context must not see it */
+        for (int j = 0; j < MT_TEST_NUM_THREADS; j++) {
+            if (j != i) {
+                progress(j);
+                EXPECT_TRUE(ucp_tag_probe_nb(receiver().worker(j), 0x1337 + i,
+                                             0xffff, 0, &info) == NULL);
+            }
+        }
+
+        status = recv_b(&recv_data, sizeof(recv_data), DATATYPE, 0x1337 + i,
+                        0xffff, &info, i);
+        ASSERT_UCS_OK(status);
+        EXPECT_EQ(send_data, recv_data);
+    }
+}
+
 UCP_INSTANTIATE_TEST_CASE(test_ucp_tag_mt)
@@ -14,6 +14,9 @@ extern "C" {
 }
 
 #include <common/test_helpers.h>
+#include <algorithm>
+#include <deque>
+#include <map>
 #include <iostream>
 
 
@@ -24,7 +27,20 @@ public:
     void test_xfer_contig(size_t size, bool expected, bool sync, bool truncated);
     void test_xfer_generic(size_t size, bool expected, bool sync, bool truncated);
     void test_xfer_iov(size_t size, bool expected, bool sync, bool truncated);
+    void test_xfer_send_iov_recv_contig(size_t size, bool expected, bool sync,
+                                        bool truncated);
+    void test_xfer_send_contig_recv_iov(size_t size, bool expected, bool sync,
+                                        bool truncated);
     void test_xfer_generic_err(size_t size, bool expected, bool sync, bool truncated);
+    void test_xfer_strided(size_t size, bool expected, bool sync, bool truncated);
+    void test_xfer_strided_large_blocks(size_t size, bool expected, bool sync,
+                                        bool truncated);
+    void test_xfer_strided_nested(size_t size, bool expected, bool sync,
+                                  bool truncated);
+    void test_xfer_send_strided_recv_contig(size_t size, bool expected, bool sync,
+                                            bool truncated);
+    void test_xfer_send_contig_recv_strided(size_t size, bool expected, bool sync,
+                                            bool truncated);
 
 protected:
     typedef void (test_ucp_tag_xfer::* xfer_func_t)(size_t size, bool expected,
@@ -39,11 +55,18 @@ protected:
                                 ucp_datatype_t *recv_dt);
     void test_xfer_probe(bool send_contig, bool recv_contig,
                          bool expected, bool sync);
+    void test_xfer_iov_dt(size_t size, bool expected, bool sync, bool truncated,
+                          bool send_iov, bool recv_iov);
+    void test_xfer_strided_dt(size_t size, bool expected, bool sync,
+                              bool truncated, bool send_strided,
+                              bool recv_strided, size_t blocklength,
+                              bool nested);
 
 private:
     size_t do_xfer(const void *sendbuf, void *recvbuf, size_t count,
                    ucp_datatype_t send_dt, ucp_datatype_t recv_dt,
-                   bool expected, bool sync, bool truncated);
+                   bool expected, bool sync, bool truncated,
+                   size_t recv_count = SIZE_MAX);
 
     request* do_send(const void *sendbuf, size_t count, ucp_datatype_t dt, bool sync);
 
@@ -300,6 +323,25 @@ void test_ucp_tag_xfer::test_xfer_generic(size_t size, bool expected, bool sync,
 
 void test_ucp_tag_xfer::test_xfer_iov(size_t size, bool expected, bool sync,
                                       bool truncated)
+{
+    test_xfer_iov_dt(size, expected, sync, truncated, true, true);
+}
+
+void test_ucp_tag_xfer::test_xfer_send_iov_recv_contig(size_t size, bool expected,
+                                                       bool sync, bool truncated)
+{
+    test_xfer_iov_dt(size, expected, sync, truncated, true, false);
+}
+
+void test_ucp_tag_xfer::test_xfer_send_contig_recv_iov(size_t size, bool expected,
+                                                       bool sync, bool truncated)
+{
+    test_xfer_iov_dt(size, expected, sync, truncated, false, true);
+}
+
+void test_ucp_tag_xfer::test_xfer_iov_dt(size_t size, bool expected, bool sync,
+                                         bool truncated, bool send_iov,
+                                         bool recv_iov)
 {
     const size_t iovcnt = 20;
     std::vector<char> sendbuf(size, 0);
@@ -307,11 +349,16 @@ void test_ucp_tag_xfer::test_xfer_iov(size_t size, bool expected, bool sync,
 
     ucs::fill_random(sendbuf.begin(), sendbuf.end());
 
-    UCS_TEST_GET_BUFFER_DT_IOV(send_iov, send_iovcnt, sendbuf.data(), sendbuf.size(), iovcnt);
-    UCS_TEST_GET_BUFFER_DT_IOV(recv_iov, recv_iovcnt, recvbuf.data(), recvbuf.size(), iovcnt);
+    UCS_TEST_GET_BUFFER_DT_IOV(send_iov_buf, send_iovcnt, sendbuf.data(), sendbuf.size(), iovcnt);
+    UCS_TEST_GET_BUFFER_DT_IOV(recv_iov_buf, recv_iovcnt, recvbuf.data(), recvbuf.size(), iovcnt);
 
-    size_t recvd = do_xfer(&send_iov, &recv_iov, iovcnt, DATATYPE_IOV, DATATYPE_IOV,
-                           expected, sync, truncated);
+    size_t recvd = do_xfer(send_iov ? (void*)send_iov_buf : (void*)sendbuf.data(),
+                           recv_iov ? (void*)recv_iov_buf : (void*)recvbuf.data(),
+                           send_iov ? iovcnt : size,
+                           send_iov ? DATATYPE_IOV : DATATYPE,
+                           recv_iov ? DATATYPE_IOV : DATATYPE,
+                           expected, sync, truncated,
+                           recv_iov ? iovcnt : size);
     if (!truncated) {
         ASSERT_EQ(sendbuf.size(), recvd);
     }
@@ -319,6 +366,146 @@ void test_ucp_tag_xfer::test_xfer_iov(size_t size, bool expected, bool sync,
                                size, expected, sync, "IOV"));
 }
 
+void test_ucp_tag_xfer::test_xfer_strided(size_t size, bool expected, bool sync,
+                                          bool truncated)
+{
+    test_xfer_strided_dt(size, expected, sync, truncated, true, true, 2, false);
+}
+
+void test_ucp_tag_xfer::test_xfer_strided_large_blocks(size_t size, bool expected,
+                                                       bool sync, bool truncated)
+{
+    test_xfer_strided_dt(size, expected, sync, truncated, true, true, 300, false);
+}
+
+void test_ucp_tag_xfer::test_xfer_strided_nested(size_t size, bool expected,
+                                                 bool sync, bool truncated)
+{
+    test_xfer_strided_dt(size, expected, sync, truncated, true, true, 2, true);
+}
+
+void test_ucp_tag_xfer::test_xfer_send_strided_recv_contig(size_t size,
+                                                           bool expected,
+                                                           bool sync,
+                                                           bool truncated)
+{
+    test_xfer_strided_dt(size, expected, sync, truncated, true, false, 2, false);
+}
+
+void test_ucp_tag_xfer::test_xfer_send_contig_recv_strided(size_t size,
+                                                           bool expected,
+                                                           bool sync,
+                                                           bool truncated)
+{
+    test_xfer_strided_dt(size, expected, sync, truncated, false, true, 2, false);
+}
+
+/*
+ * Every item of the strided datatype is 4 blocks of 'blocklength' uint32
+ * elements, with a gap of one element between the blocks. The nested datatype
+ * takes 3 such items, 'outer_stride' bytes apart.
+ */
+void test_ucp_tag_xfer::test_xfer_strided_dt(size_t size, bool expected,
+                                             bool sync, bool truncated,
+                                             bool send_strided,
+                                             bool recv_strided,
+                                             size_t blocklength, bool nested)
+{
+    const size_t elem_size    = sizeof(uint32_t);
+    const size_t block_count  = 4;
+    const size_t block_stride = (blocklength + 1) * elem_size;
+    const size_t outer_count  = 3;
+    std::vector<size_t> layout; /* buffer offset of every packed byte of an item */
+    ucp_datatype_t inner_dt, dt;
+    ucs_status_t status;
+    size_t extent, outer_stride;
+
+    status = ucp_dt_create_strided(block_count, blocklength, block_stride,
+                                   ucp_dt_make_contig(elem_size), &inner_dt);
+    ASSERT_UCS_OK(status);
+
+    for (size_t block = 0; block < block_count; ++block) {
+        for (size_t i = 0; i < blocklength * elem_size; ++i) {
+            layout.push_back(block * block_stride + i);
+        }
+    }
+    extent = (block_count - 1) * block_stride + blocklength * elem_size;
+
+    if (nested) {
+        outer_stride = extent + 100;
+        status       = ucp_dt_create_strided(outer_count, 1, outer_stride,
+                                             inner_dt, &dt);
+        ucp_dt_destroy(inner_dt);
+        ASSERT_UCS_OK(status);
+
+        std::vector<size_t> inner_layout(layout);
+        layout.clear();
+        for (size_t outer = 0; outer < outer_count; ++outer) {
+            for (size_t i = 0; i < inner_layout.size(); ++i) {
+                layout.push_back(outer * outer_stride + inner_layout[i]);
+            }
+        }
+        extent = (outer_count - 1) * outer_stride + extent;
+    } else {
+        dt = inner_dt;
+    }
+
+    size_t count  = size / layout.size();
+    size_t length = count * layout.size();
+
+    /* if count is zero, truncation has no effect */
+    if ((truncated) && (!count)) {
+        truncated = false;
+    }
+
+    std::vector<char> sendbuf(send_strided ? (count * extent) : length, 0);
+    std::vector<char> recvbuf(recv_strided ? (count * extent) : length, 0);
+    std::vector<char> send_packed(length), recv_packed(length);
+
+    ucs::fill_random(sendbuf);
+
+    size_t recvd = do_xfer(sendbuf.data(), recvbuf.data(),
+                           send_strided ? count : length,
+                           send_strided ? dt : DATATYPE,
+                           recv_strided ? dt : DATATYPE,
+                           expected, sync, truncated,
+                           recv_strided ? count : length);
+    if (!truncated) {
+        ASSERT_EQ(length, recvd);
+    }
+
+    /* bring both buffers to the packed representation */
+    for (size_t offset = 0; offset < length; ++offset) {
+        size_t item = offset / layout.size();
+        size_t idx  = offset % layout.size();
+        send_packed[offset] = send_strided ?
+                              sendbuf[item * extent + layout[idx]] :
+                              sendbuf[offset];
+        recv_packed[offset] = recv_strided ?
+                              recvbuf[item * extent + layout[idx]] :
+                              recvbuf[offset];
+        if (recv_strided) {
+            /* mark the data bytes, to check the gaps later */
+            recvbuf[item * extent + layout[idx]] = 0;
+        }
+    }
+
+    if (truncated) {
+        recvd = ucs_min(recvd, recv_strided ? (count / 2 * layout.size()) :
+                                              (length / 2));
+    }
+    EXPECT_TRUE(!check_buffers(send_packed, recv_packed, recvd, 1, 1, size,
+                               expected, sync, "strided"));
+
+    if (recv_strided) {
+        /* the gaps between the blocks must not be written */
+        EXPECT_EQ(recvbuf.size(),
+                  (size_t)std::count(recvbuf.begin(), recvbuf.end(), 0));
+    }
+
+    ucp_dt_destroy(dt);
+}
+
 void test_ucp_tag_xfer::test_xfer_generic_err(size_t size, bool expected,
                                               bool sync, bool truncated)
 {
@@ -374,12 +561,14 @@ test_ucp_tag_xfer::do_send(const void *sendbuf, size_t count, ucp_datatype_t dt,
 size_t test_ucp_tag_xfer::do_xfer(const void *sendbuf, void *recvbuf,
                                   size_t count, ucp_datatype_t send_dt,
                                   ucp_datatype_t recv_dt, bool expected,
-                                  bool sync, bool truncated)
+                                  bool sync, bool truncated, size_t recv_count)
 {
     request *rreq, *sreq;
     size_t recvd = 0;
-    size_t recv_count = count;
 
+    if (recv_count == SIZE_MAX) {
+        recv_count = count;
+    }
     if (truncated) {
         recv_count /= 2;
     }
@@ -390,7 +579,7 @@ size_t test_ucp_tag_xfer::do_xfer(const void *sendbuf, void *recvbuf,
     } else {
         sreq = do_send(sendbuf, count, send_dt, sync);
 
-        wait_for_unexpected_msg(receiver().ucph()->tag.unexpected, 10.0);
+        wait_for_unexpected_msg(receiver().worker(), 10.0);
 
         if (sync) {
             EXPECT_FALSE(sreq->completed);
@@ -505,6 +694,132 @@ UCS_TEST_P(test_ucp_tag_xfer, iov_unexp_sync) {
     test_xfer(&test_ucp_tag_xfer::test_xfer_iov, false, true, false);
 }
 
+/* rndv with IOV datatypes, read with get_zcopy item by item, or sent with AM
+ * messages if there is no rndv lane */
+
+UCS_TEST_P(test_ucp_tag_xfer, iov_exp_rndv, "RNDV_THRESH=1000") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_iov, true, false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, iov_exp_rndv_truncated, "RNDV_THRESH=1000") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_iov, true, false, true);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, iov_unexp_rndv, "RNDV_THRESH=1000") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_iov, false, false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, iov_exp_sync_rndv, "RNDV_THRESH=1000") {
+    /* because ucp_tag_send_req return status (instead request) if send operation
+     * completed immediately */
+    skip_loopback();
+    test_xfer(&test_ucp_tag_xfer::test_xfer_iov, true, true, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, iov_exp_rndv_multi_lane, "RNDV_THRESH=1000",
+           "MAX_RNDV_LANES=4") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_iov, true, false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, iov_exp_rndv_pipeline, "RNDV_THRESH=1000",
+           "RNDV_FRAG_SIZE=4k", "RNDV_PIPELINE_DEPTH=2") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_iov, true, false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, send_iov_recv_contig_exp_rndv, "RNDV_THRESH=1000") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_send_iov_recv_contig, true, false,
+              false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, send_iov_recv_contig_unexp_rndv, "RNDV_THRESH=1000") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_send_iov_recv_contig, false, false,
+              false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, send_contig_recv_iov_exp_rndv, "RNDV_THRESH=1000") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_send_contig_recv_iov, true, false,
+              false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, send_contig_recv_iov_exp_rndv_truncated,
+           "RNDV_THRESH=1000") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_send_contig_recv_iov, true, false,
+              true);
+}
+
+/* strided datatypes */
+
+UCS_TEST_P(test_ucp_tag_xfer, strided_exp) {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_strided, true, false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, strided_exp_truncated) {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_strided, true, false, true);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, strided_unexp) {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_strided, false, false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, strided_exp_sync) {
+    /* because ucp_tag_send_req return status (instead request) if send operation
+     * completed immediately */
+    skip_loopback();
+    test_xfer(&test_ucp_tag_xfer::test_xfer_strided, true, true, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, strided_nested_exp) {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_strided_nested, true, false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, strided_nested_unexp) {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_strided_nested, false, false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, strided_exp_zcopy, "ZCOPY_THRESH=1") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_strided_large_blocks, true, false,
+              false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, strided_unexp_zcopy, "ZCOPY_THRESH=1") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_strided_large_blocks, false, false,
+              false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, send_strided_recv_contig_exp) {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_send_strided_recv_contig, true,
+              false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, send_contig_recv_strided_exp) {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_send_contig_recv_strided, true,
+              false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, send_contig_recv_strided_exp_truncated) {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_send_contig_recv_strided, true,
+              false, true);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, strided_exp_rndv, "RNDV_THRESH=1000") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_strided, true, false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, strided_unexp_rndv, "RNDV_THRESH=1000") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_strided_nested, false, false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, send_contig_recv_strided_exp_rndv,
+           "RNDV_THRESH=1000") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_send_contig_recv_strided, true,
+              false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, strided_exp_rndv_pipeline, "RNDV_THRESH=1000",
+           "RNDV_FRAG_SIZE=4k", "RNDV_PIPELINE_DEPTH=2") {
+    test_xfer(&test_ucp_tag_xfer::test_xfer_strided, true, false, false);
+}
+
 /* send_contig_recv_contig */
 
 UCS_TEST_P(test_ucp_tag_xfer, send_contig_recv_contig_exp, "RNDV_THRESH=1248576") {
@@ -589,11 +904,40 @@ UCS_TEST_P(test_ucp_tag_xfer, send_contig_recv_contig_exp_sync_rndv_truncated,
     test_run_xfer(true, true, true, false, false);
 }
 
+UCS_TEST_P(test_ucp_tag_xfer, send_contig_recv_contig_exp_rndv_multi_lane,
+           "RNDV_THRESH=1000", "MAX_RNDV_LANES=4") {
+    test_run_xfer(true, true, true, false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, send_contig_recv_contig_unexp_rndv_multi_lane,
+           "RNDV_THRESH=1000", "MAX_RNDV_LANES=4") {
+    test_run_xfer(true, true, false, false, false);
+}
+
 UCS_TEST_P(test_ucp_tag_xfer, send_contig_recv_contig_unexp_rndv, "RNDV_THRESH=1000",
                                                                   "ZCOPY_THRESH=1248576") {
     test_run_xfer(true, true, false, false, false);
 }
 
+/* rndv with the pipelined protocol through staging buffers on the sender side,
+ * and with the plain bcopy protocol */
+
+UCS_TEST_P(test_ucp_tag_xfer, send_contig_recv_contig_exp_rndv_pipeline,
+           "RNDV_THRESH=1000", "ZCOPY_THRESH=1248576", "RNDV_FRAG_SIZE=4k",
+           "RNDV_PIPELINE_DEPTH=2") {
+    test_run_xfer(true, true, true, false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, send_generic_recv_contig_unexp_rndv_pipeline,
+           "RNDV_THRESH=1000", "RNDV_FRAG_SIZE=4k", "RNDV_PIPELINE_DEPTH=1") {
+    test_run_xfer(false, true, false, false, false);
+}
+
+UCS_TEST_P(test_ucp_tag_xfer, send_generic_recv_generic_exp_rndv_no_pipeline,
+           "RNDV_THRESH=1000", "RNDV_PIPELINE_DEPTH=0") {
+    test_run_xfer(false, false, true, false, false);
+}
+
 UCS_TEST_P(test_ucp_tag_xfer, send_contig_recv_contig_unexp_rndv_truncated, "RNDV_THRESH=1000",
                                                                             "ZCOPY_THRESH=1248576") {
     test_run_xfer(true, true, false, false, true);
@@ -815,6 +1159,613 @@ UCS_TEST_P(test_ucp_tag_xfer, send_contig_recv_generic_exp_rndv_probe_zcopy, "RN
 UCP_INSTANTIATE_TEST_CASE(test_ucp_tag_xfer)
 
 
+class test_ucp_tag_rndv_get : public test_ucp_tag {
+public:
+    using test_ucp_tag::get_ctx_params;
+
+protected:
+    static const size_t FRAG_SIZE = 1024;
+    static const size_t MSG_SIZE  = 16 * FRAG_SIZE;
+
+    virtual void init() {
+        test_ucp_tag::init();
+        s_get_count   = 0;
+        s_user_comp   = NULL;
+        s_pending_req = NULL;
+        s_frag_done   = false;
+    }
+
+    virtual void cleanup() {
+        restore_ops();
+        test_ucp_tag::cleanup();
+    }
+
+    /* Replace get_zcopy and pending_add_prio of the receiver interfaces, and
+     * make the rendezvous get lanes read the data in small fragments */
+    void install_hooks() {
+        ucp_worker_h worker = receiver().worker();
+
+        for (unsigned cfg = 0; cfg < worker->ep_config_count; ++cfg) {
+            ucp_ep_config_t *config = &worker->ep_config[cfg];
+            for (ucp_lane_index_t i = 0; i < config->rndv.num_lanes; ++i) {
+                config->rndv.max_get_zcopy[i] = FRAG_SIZE;
+            }
+        }
+
+        for (ucp_rsc_index_t rsc = 0; rsc < receiver().ucph()->num_tls; ++rsc) {
+            uct_iface_h iface              = worker->ifaces[rsc];
+            s_orig_ops[iface]              = iface->ops;
+            iface->ops.ep_get_zcopy        = get_zcopy_hook;
+            iface->ops.ep_pending_add_prio = pending_add_hook;
+        }
+    }
+
+    void restore_ops() {
+        for (std::map<uct_iface_h, uct_iface_ops_t>::iterator iter =
+             s_orig_ops.begin(); iter != s_orig_ops.end(); ++iter) {
+            iter->first->ops = iter->second;
+        }
+        s_orig_ops.clear();
+    }
+
+    static void frag_completion(uct_completion_t *self, ucs_status_t status) {
+        s_frag_done = true;
+    }
+
+    /*
+     * The first fragment is completed only when the test says so, and the
+     * second one fails with NO_RESOURCE and goes to the pending queue.
+     */
+    static ucs_status_t get_zcopy_hook(uct_ep_h ep, const uct_iov_t *iov,
+                                       size_t iovcnt, uint64_t remote_addr,
+                                       uct_rkey_t rkey, uct_completion_t *comp) {
+        const uct_iface_ops_t &ops = s_orig_ops[ep->iface];
+        ucs_status_t status;
+
+        switch (s_get_count++) {
+        case 0:
+            s_user_comp       = comp;
+            s_frag_comp.func  = frag_completion;
+            s_frag_comp.count = 1;
+            status = ops.ep_get_zcopy(ep, iov, iovcnt, remote_addr, rkey,
+                                      &s_frag_comp);
+            if (status == UCS_OK) {
+                s_frag_done = true;
+            } else if (status != UCS_INPROGRESS) {
+                return status;
+            }
+            return UCS_INPROGRESS;
+        case 1:
+            return UCS_ERR_NO_RESOURCE;
+        default:
+            return ops.ep_get_zcopy(ep, iov, iovcnt, remote_addr, rkey, comp);
+        }
+    }
+
+    static ucs_status_t pending_add_hook(uct_ep_h ep, uct_pending_req_t *req,
+                                         uct_pending_prio_t prio) {
+        if ((s_get_count == 2) && (s_pending_req == NULL)) {
+            s_pending_req = req;
+            return UCS_OK;
+        }
+        return s_orig_ops[ep->iface].ep_pending_add_prio(ep, req, prio);
+    }
+
+    static std::map<uct_iface_h, uct_iface_ops_t> s_orig_ops;
+    static unsigned                               s_get_count;
+    static uct_completion_t                       s_frag_comp;
+    static uct_completion_t                       *s_user_comp;
+    static uct_pending_req_t                      *s_pending_req;
+    static volatile bool                          s_frag_done;
+};
+
+std::map<uct_iface_h, uct_iface_ops_t> test_ucp_tag_rndv_get::s_orig_ops;
+unsigned test_ucp_tag_rndv_get::s_get_count                 = 0;
+uct_completion_t test_ucp_tag_rndv_get::s_frag_comp;
+uct_completion_t *test_ucp_tag_rndv_get::s_user_comp        = NULL;
+uct_pending_req_t *test_ucp_tag_rndv_get::s_pending_req     = NULL;
+volatile bool test_ucp_tag_rndv_get::s_frag_done            = false;
+
+UCS_TEST_P(test_ucp_tag_rndv_get, pending_middle_fragment, "RNDV_THRESH=1000",
+           "MAX_RNDV_LANES=4") {
+    std::vector<uint8_t> sendbuf(MSG_SIZE), recvbuf(MSG_SIZE);
+    ucp_tag_recv_info_t info;
+    request *rreq, *sreq;
+    ucs_status_t status;
+
+    /* complete the wireup on both sides */
+    ucs::fill_random(sendbuf);
+    sreq = send_nb(&sendbuf[0], sendbuf.size(), DATATYPE, 0x111337);
+    status = recv_b(&recvbuf[0], recvbuf.size(), DATATYPE, 0x1337, 0xffff,
+                    &info);
+    ASSERT_UCS_OK(status);
+    if (sreq != NULL) {
+        wait(sreq);
+        request_release(sreq);
+    }
+
+    install_hooks();
+
+    ucs::fill_random(sendbuf);
+    rreq = recv_nb(&recvbuf[0], recvbuf.size(), DATATYPE, 0x1337, 0xffff);
+    sreq = send_nb(&sendbuf[0], sendbuf.size(), DATATYPE, 0x111337);
+
+    ucs_time_t deadline = ucs_get_time() + ucs_time_from_sec(10.0);
+    while ((s_pending_req == NULL) && !rreq->completed &&
+           (ucs_get_time() < deadline)) {
+        progress();
+    }
+
+    if (s_pending_req == NULL) {
+        wait(rreq);
+        request_release(rreq);
+        if (sreq != NULL) {
+            wait(sreq);
+            request_release(sreq);
+        }
+        UCS_TEST_SKIP_R("rendezvous get was not fragmented");
+    }
+
+    /* complete the first fragment while the second one is pending. this must
+     * not complete the receive, since the rest of the data was not read yet */
+    while (!s_frag_done) {
+        progress();
+    }
+    if (--s_user_comp->count == 0) {
+        s_user_comp->func(s_user_comp, UCS_OK);
+    }
+    short_progress_loop();
+    ASSERT_FALSE(rreq->completed);
+
+    /* dispatch the pending fragment, as the transport would do */
+    do {
+        status = s_pending_req->func(s_pending_req);
+    } while (status == UCS_INPROGRESS);
+    ASSERT_UCS_OK(status);
+
+    wait(rreq);
+    ASSERT_UCS_OK(rreq->status);
+    EXPECT_EQ(sendbuf.size(), rreq->info.length);
+    EXPECT_EQ(sendbuf, recvbuf);
+    request_release(rreq);
+    if (sreq != NULL) {
+        wait(sreq);
+        request_release(sreq);
+    }
+}
+
+UCP_INSTANTIATE_TEST_CASE(test_ucp_tag_rndv_get)
+
+
+class test_ucp_tag_pending_prio : public test_ucp_tag {
+public:
+    using test_ucp_tag::get_ctx_params;
+
+protected:
+    /* Operations are identified by their AM id, or OP_GET for a get */
+    enum {
+        OP_NONE = -1,
+        OP_GET  = UCP_AM_ID_LAST
+    };
+
+    typedef std::pair<uct_pending_req_t*, uct_pending_prio_t> pending_elem_t;
+    typedef std::pair<int, uct_pending_prio_t>                op_prio_t;
+
+    virtual void init() {
+        test_ucp_tag::init();
+        s_block_am  = false;
+        s_block_get = false;
+        s_capture   = false;
+        s_last_op   = OP_NONE;
+        s_pending.clear();
+        s_dispatched.clear();
+        s_added.clear();
+        s_sent.clear();
+    }
+
+    virtual void cleanup() {
+        restore_ops();
+        test_ucp_tag::cleanup();
+    }
+
+    /* Complete the wireup on both sides, so no wireup messages would be
+     * pending, and create the endpoint of the receiver to the sender */
+    void wireup() {
+        ucp_tag_recv_info_t info;
+        uint8_t data = 0;
+        ucs_status_t status;
+        request *sreq;
+
+        sreq   = send_sync_nb(&data, sizeof(data), DATATYPE, 0x111337);
+        status = recv_b(&data, sizeof(data), DATATYPE, 0x1337, 0xffff, &info);
+        ASSERT_UCS_OK(status);
+        wait_and_release(sreq);
+    }
+
+    void wait_and_release(request *req) {
+        if (req != NULL) {
+            wait(req);
+            request_release(req);
+        }
+    }
+
+    /* Replace the AM, get and pending_add_prio operations of the interfaces
+     * of an entity */
+    void install_hooks(entity &e) {
+        ucp_worker_h worker = e.worker();
+
+        for (ucp_rsc_index_t rsc = 0; rsc < e.ucph()->num_tls; ++rsc) {
+            uct_iface_h iface              = worker->ifaces[rsc];
+            s_orig_ops[iface]              = iface->ops;
+            iface->ops.ep_am_short         = am_short_hook;
+            iface->ops.ep_am_bcopy         = am_bcopy_hook;
+            iface->ops.ep_am_zcopy         = am_zcopy_hook;
+            iface->ops.ep_get_zcopy        = get_zcopy_hook;
+            iface->ops.ep_pending_add_prio = pending_add_hook;
+        }
+    }
+
+    void restore_ops() {
+        for (std::map<uct_iface_h, uct_iface_ops_t>::iterator iter =
+             s_orig_ops.begin(); iter != s_orig_ops.end(); ++iter) {
+            iter->first->ops = iter->second;
+        }
+        s_orig_ops.clear();
+    }
+
+    void progress_until_pending() {
+        ucs_time_t deadline = ucs_get_time() + ucs_time_from_sec(10.0);
+        while (s_pending.empty() && (ucs_get_time() < deadline)) {
+            progress();
+        }
+    }
+
+    /* Dispatch the captured pending requests in order, until one of them
+     * runs out of resources, and record the operation each one performed */
+    void dispatch_pending() {
+        pending_elem_t elem;
+        ucs_status_t status;
+
+        while (!s_pending.empty()) {
+            elem      = s_pending.front();
+            s_last_op = OP_NONE;
+            do {
+                status = elem.first->func(elem.first);
+            } while (status == UCS_INPROGRESS);
+
+            if (status == UCS_ERR_NO_RESOURCE) {
+                return;
+            }
+
+            ASSERT_UCS_OK(status);
+            s_dispatched.push_back(op_prio_t(s_last_op, elem.second));
+            s_pending.pop_front();
+        }
+    }
+
+    static bool is_control(int op) {
+        return (op == UCP_AM_ID_RNDV_RTR) || (op == UCP_AM_ID_RNDV_ATS) ||
+               (op == UCP_AM_ID_EAGER_SYNC_ACK) || (op == UCP_AM_ID_WIREUP);
+    }
+
+    /* Check the priority of every dispatched request */
+    void check_prio() {
+        for (std::vector<op_prio_t>::iterator iter = s_dispatched.begin();
+             iter != s_dispatched.end(); ++iter) {
+            EXPECT_EQ(is_control(iter->first) ? UCT_PENDING_PRIO_CONTROL :
+                                                UCT_PENDING_PRIO_BULK,
+                      iter->second) << "op " << iter->first;
+        }
+    }
+
+    /* Number of dispatched requests which performed the operation */
+    static unsigned num_dispatched(int op) {
+        unsigned count = 0;
+
+        for (std::vector<op_prio_t>::iterator iter = s_dispatched.begin();
+             iter != s_dispatched.end(); ++iter) {
+            count += (iter->first == op);
+        }
+        return count;
+    }
+
+    static ucs_status_t op_start(int op, bool blocked) {
+        if (s_last_op == OP_NONE) {
+            s_last_op = op;
+        }
+        return blocked ? UCS_ERR_NO_RESOURCE : UCS_OK;
+    }
+
+    static void op_sent(int op, ucs_status_t status) {
+        if ((status == UCS_OK) || (status == UCS_INPROGRESS)) {
+            s_sent.push_back(op);
+        }
+    }
+
+    static ucs_status_t am_short_hook(uct_ep_h ep, uint8_t id, uint64_t header,
+                                      const void *payload, unsigned length) {
+        ucs_status_t status = op_start(id, s_block_am);
+
+        if (status == UCS_OK) {
+            status = s_orig_ops[ep->iface].ep_am_short(ep, id, header, payload,
+                                                       length);
+        }
+        op_sent(id, status);
+        return status;
+    }
+
+    static ssize_t am_bcopy_hook(uct_ep_h ep, uint8_t id,
+                                 uct_pack_callback_t pack_cb, void *arg) {
+        ucs_status_t status = op_start(id, s_block_am);
+        ssize_t packed_len;
+
+        if (status != UCS_OK) {
+            return status;
+        }
+
+        packed_len = s_orig_ops[ep->iface].ep_am_bcopy(ep, id, pack_cb, arg);
+        op_sent(id, (packed_len < 0) ? (ucs_status_t)packed_len : UCS_OK);
+        return packed_len;
+    }
+
+    static ucs_status_t am_zcopy_hook(uct_ep_h ep, uint8_t id,
+                                      const void *header,
+                                      unsigned header_length,
+                                      const uct_iov_t *iov, size_t iovcnt,
+                                      uct_completion_t *comp) {
+        ucs_status_t status = op_start(id, s_block_am);
+
+        if (status == UCS_OK) {
+            status = s_orig_ops[ep->iface].ep_am_zcopy(ep, id, header,
+                                                       header_length, iov,
+                                                       iovcnt, comp);
+        }
+        op_sent(id, status);
+        return status;
+    }
+
+    static ucs_status_t get_zcopy_hook(uct_ep_h ep, const uct_iov_t *iov,
+                                       size_t iovcnt, uint64_t remote_addr,
+                                       uct_rkey_t rkey, uct_completion_t *comp) {
+        ucs_status_t status = op_start(OP_GET, s_block_get);
+
+        if (status == UCS_OK) {
+            status = s_orig_ops[ep->iface].ep_get_zcopy(ep, iov, iovcnt,
+                                                        remote_addr, rkey, comp);
+        }
+        op_sent(OP_GET, status);
+        return status;
+    }
+
+    /* Blocked requests are captured, to be dispatched by the test */
+    static ucs_status_t pending_add_hook(uct_ep_h ep, uct_pending_req_t *req,
+                                         uct_pending_prio_t prio) {
+        ucs_status_t status;
+
+        if (s_capture) {
+            s_pending.push_back(pending_elem_t(req, prio));
+            return UCS_OK;
+        }
+
+        status = s_orig_ops[ep->iface].ep_pending_add_prio(ep, req, prio);
+        if (status == UCS_OK) {
+            /* Number of operations sent before the request was added */
+            s_added.push_back(std::make_pair(s_sent.size(), prio));
+        }
+        return status;
+    }
+
+    static std::map<uct_iface_h, uct_iface_ops_t>     s_orig_ops;
+    static bool                                       s_block_am;
+    static bool                                       s_block_get;
+    static bool                                       s_capture;
+    static int                                        s_last_op;
+    static std::deque<pending_elem_t>                 s_pending;
+    static std::vector<op_prio_t>                     s_dispatched;
+    static std::vector<std::pair<size_t,
+                                 uct_pending_prio_t> > s_added;
+    static std::vector<int>                           s_sent;
+};
+
+std::map<uct_iface_h, uct_iface_ops_t> test_ucp_tag_pending_prio::s_orig_ops;
+bool test_ucp_tag_pending_prio::s_block_am                    = false;
+bool test_ucp_tag_pending_prio::s_block_get                   = false;
+bool test_ucp_tag_pending_prio::s_capture                     = false;
+int test_ucp_tag_pending_prio::s_last_op                      = OP_NONE;
+std::deque<test_ucp_tag_pending_prio::pending_elem_t>
+test_ucp_tag_pending_prio::s_pending;
+std::vector<test_ucp_tag_pending_prio::op_prio_t>
+test_ucp_tag_pending_prio::s_dispatched;
+std::vector<std::pair<size_t, uct_pending_prio_t> >
+test_ucp_tag_pending_prio::s_added;
+std::vector<int> test_ucp_tag_pending_prio::s_sent;
+
+UCS_TEST_P(test_ucp_tag_pending_prio, sync_ack) {
+    uint8_t data = 0;
+    request *rreq, *sreq;
+
+    wireup();
+    install_hooks(sender());
+    install_hooks(receiver());
+    s_capture = true;
+
+    /* the sync message is unexpected, so receiving it sends the ack */
+    sreq = send_sync_nb(&data, sizeof(data), DATATYPE, 0x111337);
+    short_progress_loop();
+
+    s_block_am = true;
+    rreq = recv_nb(&data, sizeof(data), DATATYPE, 0x1337, 0xffff);
+    progress_until_pending();
+    ASSERT_FALSE(s_pending.empty());
+
+    s_block_am = false;
+    dispatch_pending();
+    wait_and_release(rreq);
+    wait_and_release(sreq);
+
+    check_prio();
+    EXPECT_EQ(1u, num_dispatched(UCP_AM_ID_EAGER_SYNC_ACK));
+}
+
+UCS_TEST_P(test_ucp_tag_pending_prio, rndv_rtr_data, "RNDV_THRESH=1000") {
+    std::vector<uint8_t> sendbuf(16 * 1024);
+    request *rreq, *sreq;
+    ucp_datatype_t dt;
+    ucs_status_t status;
+
+    /* the receiver has a generic datatype, which checks the data, so it sends
+     * RTR and the sender sends the data in active messages */
+    status = ucp_dt_create_generic(&test_dt_uint8_ops, NULL, &dt);
+    ASSERT_UCS_OK(status);
+
+    wireup();
+    install_hooks(sender());
+    install_hooks(receiver());
+    s_capture = true;
+
+    for (size_t i = 0; i < sendbuf.size(); ++i) {
+        sendbuf[i] = i;
+    }
+    sreq = send_nb(&sendbuf[0], sendbuf.size(), DATATYPE, 0x111337);
+    short_progress_loop();
+
+    /* RTR */
+    s_block_am = true;
+    rreq = recv_nb(NULL, sendbuf.size(), dt, 0x1337, 0xffff);
+    progress_until_pending();
+    ASSERT_FALSE(s_pending.empty());
+    s_block_am = false;
+    dispatch_pending();
+
+    /* Data fragments */
+    s_block_am = true;
+    progress_until_pending();
+    ASSERT_FALSE(s_pending.empty());
+    s_block_am = false;
+    dispatch_pending();
+
+    wait_and_release(rreq);
+    wait_and_release(sreq);
+    ucp_dt_destroy(dt);
+
+    check_prio();
+    EXPECT_EQ(1u, num_dispatched(UCP_AM_ID_RNDV_RTR));
+    EXPECT_GE(num_dispatched(UCP_AM_ID_RNDV_DATA) +
+              num_dispatched(UCP_AM_ID_RNDV_DATA_LAST), 1u);
+}
+
+UCS_TEST_P(test_ucp_tag_pending_prio, rndv_get_ats, "RNDV_THRESH=1000") {
+    std::vector<uint8_t> sendbuf(16 * 1024), recvbuf(sendbuf.size());
+    request *rreq, *sreq;
+
+    wireup();
+    install_hooks(sender());
+    install_hooks(receiver());
+    s_capture = true;
+
+    ucs::fill_random(sendbuf);
+    sreq = send_nb(&sendbuf[0], sendbuf.size(), DATATYPE, 0x111337);
+    short_progress_loop();
+
+    /* Get fragments, and the ATS after the last of them */
+    s_block_am  = true;
+    s_block_get = true;
+    rreq = recv_nb(&recvbuf[0], recvbuf.size(), DATATYPE, 0x1337, 0xffff);
+    progress_until_pending();
+    ASSERT_FALSE(s_pending.empty());
+    s_block_get = false;
+    dispatch_pending();
+    progress_until_pending();
+    s_block_am = false;
+    dispatch_pending();
+
+    wait_and_release(rreq);
+    wait_and_release(sreq);
+    EXPECT_EQ(sendbuf, recvbuf);
+
+    check_prio();
+    if (num_dispatched(OP_GET) == 0) {
+        UCS_TEST_SKIP_R("rendezvous get is not used");
+    }
+    EXPECT_EQ(1u, num_dispatched(UCP_AM_ID_RNDV_ATS));
+}
+
+UCS_TEST_P(test_ucp_tag_pending_prio, control_before_bulk) {
+    static const size_t max_sends   = 100000;
+    static const size_t num_pending = 4;
+    std::vector<request*> reqs;
+    uint64_t data = 0, recv_data;
+    request *rreq, *sreq;
+    size_t i, num_bulk_added, ctrl_sent;
+    ucs_time_t deadline;
+
+    receiver().connect(&sender());
+    wireup();
+    install_hooks(receiver());
+
+    /* Fill the lane from the receiver to the sender, which does not
+     * progress, until bulk messages are pending */
+    num_bulk_added = 0;
+    for (i = 0; (i < max_sends) && (num_bulk_added < num_pending); ++i) {
+        sreq = (request*)ucp_tag_send_nb(receiver().ep(), &data, sizeof(data),
+                                         DATATYPE, 0x2337, send_callback);
+        if (UCS_PTR_IS_ERR(sreq)) {
+            ASSERT_UCS_OK(UCS_PTR_STATUS(sreq));
+        } else if (sreq != NULL) {
+            reqs.push_back(sreq);
+        }
+        receiver().progress();
+        num_bulk_added = s_added.size();
+    }
+
+    /* The ack of a sync message which arrives now is sent on the filled lane */
+    if (num_bulk_added >= num_pending) {
+        sreq = send_sync_nb(&data, sizeof(data), DATATYPE, 0x111337);
+        rreq = recv_nb(&recv_data, sizeof(recv_data), DATATYPE, 0x1337, 0xffff);
+        deadline = ucs_get_time() + ucs_time_from_sec(10.0);
+        while ((s_added.size() == num_bulk_added) &&
+               (ucs_get_time() < deadline)) {
+            receiver().progress();
+        }
+        reqs.push_back(sreq);
+        reqs.push_back(rreq);
+    }
+
+    /* Drain the lane */
+    for (size_t j = 0; j < i; ++j) {
+        rreq = (request*)ucp_tag_recv_nb(sender().worker(), &recv_data,
+                                         sizeof(recv_data), DATATYPE, 0x2337,
+                                         (ucp_tag_t)-1, recv_callback);
+        if (UCS_PTR_IS_ERR(rreq)) {
+            ASSERT_UCS_OK(UCS_PTR_STATUS(rreq));
+        }
+        reqs.push_back(rreq);
+    }
+    for (std::vector<request*>::iterator iter = reqs.begin();
+         iter != reqs.end(); ++iter) {
+        wait_and_release(*iter);
+    }
+
+    if (num_bulk_added < num_pending) {
+        UCS_TEST_SKIP_R("the lane was not filled");
+    }
+
+    ASSERT_EQ(num_bulk_added + 1, s_added.size());
+    for (i = 0; i < num_bulk_added; ++i) {
+        EXPECT_EQ(UCT_PENDING_PRIO_BULK, s_added[i].second);
+    }
+    EXPECT_EQ(UCT_PENDING_PRIO_CONTROL, s_added.back().second);
+
+    /* Only the first pending message may be sent before the ack */
+    ctrl_sent = std::find(s_sent.begin() + s_added.back().first, s_sent.end(),
+                          (int)UCP_AM_ID_EAGER_SYNC_ACK) - s_sent.begin();
+    ASSERT_LT(ctrl_sent, s_sent.size());
+    EXPECT_LE(ctrl_sent - s_added.back().first, 1u);
+}
+
+UCP_INSTANTIATE_TEST_CASE(test_ucp_tag_pending_prio)
+
+
 #if ENABLE_STATS
 
 class test_ucp_tag_stats : public test_ucp_tag_xfer {
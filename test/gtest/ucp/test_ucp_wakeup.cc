@@ -7,6 +7,12 @@
 #include "ucp_test.h"
 #include "poll.h"
 
+extern "C" {
+#include <ucp/core/ucp_worker.h>
+}
+
+#include <pthread.h>
+
 class test_ucp_wakeup : public ucp_test {
 public:
     static ucp_params_t get_ctx_params() {
@@ -29,6 +35,47 @@ protected:
         } while (!ucp_request_is_completed(req));
         ucp_request_release(req);
     }
+
+    static const unsigned NUM_MSGS = 100;
+
+    static void* send_thread_func(void *arg) {
+        test_ucp_wakeup *self = reinterpret_cast<test_ucp_wakeup*>(arg);
+        ucp_worker_h worker = self->sender().worker();
+        uint64_t send_data;
+        void *req;
+
+        for (unsigned i = 0; i < NUM_MSGS; ++i) {
+            if ((i % 10) == 0) {
+                /* let the receiver go to sleep */
+                usleep(1000);
+            }
+
+            send_data = i;
+            req = ucp_tag_send_nb(self->sender().ep(), &send_data,
+                                  sizeof(send_data), ucp_dt_make_contig(1), i,
+                                  send_completion);
+            if (UCS_PTR_IS_PTR(req)) {
+                while (!ucp_request_is_completed(req)) {
+                    ucp_worker_progress(worker);
+                }
+                ucp_request_release(req);
+            }
+        }
+        return NULL;
+    }
+
+    /* keeps waking up the receiver, so a blocking wait always returns */
+    static void* signal_thread_func(void *arg) {
+        test_ucp_wakeup *self = reinterpret_cast<test_ucp_wakeup*>(arg);
+
+        while (!self->m_stop_signal) {
+            ucp_worker_signal(self->receiver().worker());
+            usleep(5000);
+        }
+        return NULL;
+    }
+
+    volatile bool m_stop_signal;
 };
 
 UCS_TEST_P(test_ucp_wakeup, efd)
@@ -104,4 +151,108 @@ UCS_TEST_P(test_ucp_wakeup, signal)
     close(efd);
 }
 
+UCS_TEST_P(test_ucp_wakeup, wait)
+{
+    ucp_worker_h recv_worker;
+    uint64_t recv_data;
+    pthread_t thread;
+    void *req;
+
+    sender().connect(&receiver());
+    recv_worker = receiver().worker();
+
+    pthread_create(&thread, NULL, send_thread_func, this);
+
+    /* the receiver sleeps until each message arrives */
+    for (unsigned i = 0; i < NUM_MSGS; ++i) {
+        recv_data = (uint64_t)-1;
+        req = ucp_tag_recv_nb(recv_worker, &recv_data, sizeof(recv_data),
+                              ucp_dt_make_contig(1), i, (ucp_tag_t)-1,
+                              recv_completion);
+        ASSERT_TRUE(UCS_PTR_IS_PTR(req));
+        while (!ucp_request_is_completed(req)) {
+            ASSERT_UCS_OK(ucp_worker_wait(recv_worker));
+            ucp_worker_progress(recv_worker);
+        }
+        ucp_request_release(req);
+        EXPECT_EQ(i, recv_data);
+    }
+
+    pthread_join(thread, NULL);
+}
+
+UCS_TEST_P(test_ucp_wakeup, spin_time, "WAKEUP_SPIN_TIME=1ms")
+{
+    ucp_worker_h recv_worker = receiver().worker();
+    ucp_worker_wakeup_t *wakeup = &recv_worker->wakeup;
+    ucs_time_t max_spin_time;
+    uint64_t send_data = 0, recv_data;
+    unsigned num_msgs;
+    pthread_t thread;
+    void *req;
+
+    max_spin_time = wakeup->max_spin_time;
+    EXPECT_NEAR(1e-3, ucs_time_to_sec(max_spin_time), 1e-5);
+    EXPECT_EQ(max_spin_time, wakeup->spin_time);
+
+    m_stop_signal = false;
+    pthread_create(&thread, NULL, signal_thread_func, this);
+
+    /* nothing arrives while spinning, so every wait halves the spin time
+     * down to 1/16 of the maximum and then arms and sleeps */
+    for (unsigned i = 1; i <= 6; ++i) {
+        ucs_time_t expected_spin_time = ucs_max(max_spin_time >> i,
+                                                max_spin_time / 16);
+        ASSERT_UCS_OK(ucp_worker_wait(recv_worker));
+        EXPECT_EQ(expected_spin_time, wakeup->spin_time);
+    }
+
+    /* an event found while spinning restores the full spin time. the self
+     * transport delivers messages during the send, so the receiver never
+     * finds them by polling */
+    if ("\\self" != GetParam().transports.front()) {
+        sender().connect(&receiver());
+        for (num_msgs = 0; (num_msgs < 10) &&
+                           (wakeup->spin_time != max_spin_time); ++num_msgs) {
+            req = ucp_tag_send_nb(sender().ep(), &send_data, sizeof(send_data),
+                                  ucp_dt_make_contig(1), num_msgs,
+                                  send_completion);
+            if (UCS_PTR_IS_PTR(req)) {
+                wait(req);
+            } else {
+                ASSERT_UCS_OK(UCS_PTR_STATUS(req));
+            }
+            ASSERT_UCS_OK(ucp_worker_wait(recv_worker));
+        }
+        EXPECT_EQ(max_spin_time, wakeup->spin_time);
+
+        for (unsigned i = 0; i < num_msgs; ++i) {
+            req = ucp_tag_recv_nb(recv_worker, &recv_data, sizeof(recv_data),
+                                  ucp_dt_make_contig(1), i, (ucp_tag_t)-1,
+                                  recv_completion);
+            ASSERT_TRUE(UCS_PTR_IS_PTR(req));
+            wait(req);
+        }
+    }
+
+    m_stop_signal = true;
+    pthread_join(thread, NULL);
+}
+
+UCS_TEST_P(test_ucp_wakeup, no_spin, "WAKEUP_SPIN_TIME=0")
+{
+    ucp_worker_h recv_worker = receiver().worker();
+    pthread_t thread;
+
+    m_stop_signal = false;
+    pthread_create(&thread, NULL, signal_thread_func, this);
+
+    /* without spinning, the wait goes directly to arm and sleep */
+    ASSERT_UCS_OK(ucp_worker_wait(recv_worker));
+    EXPECT_EQ(0u, recv_worker->wakeup.spin_time);
+
+    m_stop_signal = true;
+    pthread_join(thread, NULL);
+}
+
 UCP_INSTANTIATE_TEST_CASE(test_ucp_wakeup)
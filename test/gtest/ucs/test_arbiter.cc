@@ -276,7 +276,7 @@ UCS_TEST_F(test_arbiter, multiple_dispatch) {
 
     ucs_arbiter_dispatch(&arbiter, 1, dispatch_cb, this);
 
-    ASSERT_TRUE(arbiter.current == NULL);
+    ASSERT_TRUE(ucs_arbiter_is_empty(&arbiter));
 
     /* Release detached groups */
     for (unsigned i = 0; i < m_num_groups; ++i) {
@@ -325,7 +325,7 @@ UCS_TEST_F(test_arbiter, resched) {
     m_count = 0;
     ucs_arbiter_dispatch_nonempty(&arbiter, 3, remove_cb, this);
     EXPECT_EQ(1, m_count);
-    ASSERT_TRUE(arbiter.current == NULL);
+    ASSERT_TRUE(ucs_arbiter_is_empty(&arbiter));
 
     ucs_arbiter_group_cleanup(&group2);
     ucs_arbiter_group_cleanup(&group1);
@@ -494,7 +494,7 @@ UCS_TEST_F(test_arbiter, result_stop) {
     for (int i = 0; i < N + 3; i++) {
        ucs_arbiter_dispatch(&m_arb1, 1, stop_cb, this);
        /* arbiter current position must not change on STOP */
-       EXPECT_EQ(m_arb1.current, groups[0].tail->next);
+       EXPECT_EQ(m_arb1.current[UCS_ARBITER_PRIO_BULK], groups[0].tail->next);
     }
 
     m_count = 0;
@@ -506,3 +506,136 @@ UCS_TEST_F(test_arbiter, result_stop) {
     delete [] groups;
     delete [] elems;
 }
+
+class test_arbiter_prio : public test_arbiter {
+protected:
+    struct prio_elem {
+        int                group_idx;
+        int                elem_idx;
+        ucs_arbiter_elem_t elem;
+    };
+
+    static ucs_arbiter_cb_result_t record_cb(ucs_arbiter_t *arbiter,
+                                             ucs_arbiter_elem_t *elem,
+                                             void *arg)
+    {
+        test_arbiter_prio *self = (test_arbiter_prio*)arg;
+        prio_elem *e            = ucs_container_of(elem, prio_elem, elem);
+
+        self->m_order.push_back(std::make_pair(e->group_idx, e->elem_idx));
+        return UCS_ARBITER_CB_RESULT_REMOVE_ELEM;
+    }
+
+    void push(ucs_arbiter_group_t *group, prio_elem *e, int group_idx,
+              int elem_idx, ucs_arbiter_prio_t prio)
+    {
+        e->group_idx = group_idx;
+        e->elem_idx  = elem_idx;
+        ucs_arbiter_elem_init(&e->elem);
+        ucs_arbiter_group_push_elem_prio(group, &e->elem, prio);
+    }
+
+    void expect_order(const int (*expected)[2], size_t count)
+    {
+        ASSERT_EQ(count, m_order.size());
+        for (size_t i = 0; i < count; ++i) {
+            EXPECT_EQ(expected[i][0], m_order[i].first)  << "index " << i;
+            EXPECT_EQ(expected[i][1], m_order[i].second) << "index " << i;
+        }
+    }
+
+    std::vector<std::pair<int, int> > m_order;
+};
+
+/* groups of higher priority are dispatched first */
+UCS_TEST_F(test_arbiter_prio, strict) {
+    static const ucs_arbiter_prio_t prios[] = { UCS_ARBITER_PRIO_BULK,
+                                                UCS_ARBITER_PRIO_CONTROL,
+                                                UCS_ARBITER_PRIO_LATENCY,
+                                                UCS_ARBITER_PRIO_CONTROL };
+    static const int expected[][2] = { {1, 0}, {3, 0}, {1, 1}, {3, 1},
+                                       {2, 0}, {2, 1}, {0, 0}, {0, 1} };
+    const int N = 4;
+    ucs_arbiter_group_t groups[N];
+    prio_elem elems[N][2];
+
+    ucs_arbiter_init(&m_arb1);
+    for (int i = 0; i < N; ++i) {
+        ucs_arbiter_group_init(&groups[i]);
+        for (int j = 0; j < 2; ++j) {
+            push(&groups[i], &elems[i][j], i, j, prios[i]);
+        }
+        ucs_arbiter_group_schedule(&m_arb1, &groups[i]);
+    }
+
+    ucs_arbiter_dispatch(&m_arb1, 1, record_cb, this);
+    expect_order(expected, sizeof(expected) / sizeof(expected[0]));
+    EXPECT_TRUE(ucs_arbiter_is_empty(&m_arb1));
+
+    for (int i = 0; i < N; ++i) {
+        ucs_arbiter_group_cleanup(&groups[i]);
+    }
+    ucs_arbiter_cleanup(&m_arb1);
+}
+
+/* higher priority elements bypass lower priority ones in the same group, but
+ * not the first element, and the group moves to the priority of its head */
+UCS_TEST_F(test_arbiter_prio, in_group) {
+    static const int expected[][2] = { {1, 0}, {0, 0}, {0, 3}, {0, 4},
+                                       {0, 1}, {0, 2} };
+    ucs_arbiter_group_t groups[2];
+    prio_elem elems[5], elem1;
+
+    ucs_arbiter_init(&m_arb1);
+    ucs_arbiter_group_init(&groups[0]);
+    ucs_arbiter_group_init(&groups[1]);
+
+    push(&groups[0], &elems[0], 0, 0, UCS_ARBITER_PRIO_BULK);
+    push(&groups[0], &elems[1], 0, 1, UCS_ARBITER_PRIO_BULK);
+    push(&groups[0], &elems[2], 0, 2, UCS_ARBITER_PRIO_BULK);
+    push(&groups[0], &elems[3], 0, 3, UCS_ARBITER_PRIO_CONTROL);
+    push(&groups[0], &elems[4], 0, 4, UCS_ARBITER_PRIO_LATENCY);
+    push(&groups[1], &elem1,    1, 0, UCS_ARBITER_PRIO_CONTROL);
+    ucs_arbiter_group_schedule(&m_arb1, &groups[0]);
+    ucs_arbiter_group_schedule(&m_arb1, &groups[1]);
+
+    ucs_arbiter_dispatch(&m_arb1, 1, record_cb, this);
+    expect_order(expected, sizeof(expected) / sizeof(expected[0]));
+    EXPECT_TRUE(ucs_arbiter_is_empty(&m_arb1));
+
+    ucs_arbiter_group_cleanup(&groups[1]);
+    ucs_arbiter_group_cleanup(&groups[0]);
+    ucs_arbiter_cleanup(&m_arb1);
+}
+
+/* with weights, lower priorities get a share of every dispatch round */
+UCS_TEST_F(test_arbiter_prio, weighted) {
+    static const int expected[][2] = { {0, 0}, {1, 0}, {3, 0},
+                                       {2, 0}, {0, 1}, {4, 0},
+                                       {1, 1}, {2, 1}, {3, 1},
+                                       {4, 1} };
+    const int N = 5;
+    ucs_arbiter_group_t groups[N];
+    prio_elem elems[N][2];
+
+    ucs_arbiter_init(&m_arb1);
+    ucs_arbiter_set_weight(&m_arb1, UCS_ARBITER_PRIO_CONTROL, 2);
+    ucs_arbiter_set_weight(&m_arb1, UCS_ARBITER_PRIO_BULK,    1);
+    for (int i = 0; i < N; ++i) {
+        ucs_arbiter_group_init(&groups[i]);
+        for (int j = 0; j < 2; ++j) {
+            push(&groups[i], &elems[i][j], i, j,
+                 (i < 3) ? UCS_ARBITER_PRIO_CONTROL : UCS_ARBITER_PRIO_BULK);
+        }
+        ucs_arbiter_group_schedule(&m_arb1, &groups[i]);
+    }
+
+    ucs_arbiter_dispatch(&m_arb1, 1, record_cb, this);
+    expect_order(expected, sizeof(expected) / sizeof(expected[0]));
+    EXPECT_TRUE(ucs_arbiter_is_empty(&m_arb1));
+
+    for (int i = 0; i < N; ++i) {
+        ucs_arbiter_group_cleanup(&groups[i]);
+    }
+    ucs_arbiter_cleanup(&m_arb1);
+}
@@ -44,10 +44,11 @@ protected:
         ucs::test_base::cleanup();
     }
 
-    static void callback_proxy(void *arg)
+    static unsigned callback_proxy(void *arg)
     {
         callback_ctx *ctx = reinterpret_cast<callback_ctx*>(arg);
         ctx->test->callback(ctx);
+        return 1;
     }
 
     static void callback_slow_proxy(ucs_callbackq_slow_elem_t *self)
@@ -138,6 +139,24 @@ UCS_TEST_P(test_callbackq, single) {
     EXPECT_EQ(1u, ctx.count);
 }
 
+UCS_TEST_P(test_callbackq, event_count) {
+    callback_ctx ctx1, ctx2;
+    unsigned count;
+
+    init_ctx(&ctx1);
+    init_ctx(&ctx2);
+    add(&ctx1);
+    add(&ctx2);
+    count = ucs_callbackq_dispatch(&m_cbq);
+    remove(&ctx1);
+    remove(&ctx2);
+
+    /* slow path callbacks do not report events */
+    EXPECT_EQ(is_fast_path ? 2u : 0u, count);
+    EXPECT_EQ(1u, ctx1.count);
+    EXPECT_EQ(1u, ctx2.count);
+}
+
 UCS_TEST_P(test_callbackq, refcount) {
     if (!is_fast_path) {
         UCS_TEST_SKIP;
@@ -10,6 +10,7 @@ extern "C" {
 }
 
 #include <limits.h>
+#include <pthread.h>
 #include <vector>
 #include <queue>
 
@@ -24,6 +25,40 @@ protected:
         free(chunk);
     }
 
+    struct mt_ctx {
+        ucs_mpool_t        *mp;
+        pthread_mutex_t    lock;
+        std::vector<void*> exchange;  /* Objects to be released by other threads */
+    };
+
+    static void *mt_thread_func(void *arg) {
+        mt_ctx *ctx = reinterpret_cast<mt_ctx*>(arg);
+        const unsigned num_iters = 2000 / ucs::test_time_multiplier();
+        std::vector<void*> objs;
+
+        for (unsigned iter = 0; iter < num_iters; ++iter) {
+            for (unsigned i = 0; i < 20; ++i) {
+                void *obj = ucs_mpool_get(ctx->mp);
+                if (obj == NULL) {
+                    return (void*)1;
+                }
+                memset(obj, 0xAA, header_size + data_size);
+                objs.push_back(obj);
+            }
+
+            /* Release some objects which were allocated by other threads */
+            pthread_mutex_lock(&ctx->lock);
+            ctx->exchange.swap(objs);
+            pthread_mutex_unlock(&ctx->lock);
+
+            while (!objs.empty()) {
+                ucs_mpool_put(objs.back());
+                objs.pop_back();
+            }
+        }
+        return NULL;
+    }
+
     static const size_t header_size = 30;
     static const size_t data_size = 152;
     static const size_t align = 128;
@@ -148,3 +183,84 @@ UCS_TEST_F(test_mpool, infinite) {
 
     ucs_mpool_cleanup(&mp, 1);
 }
+
+UCS_TEST_F(test_mpool, thread_safe_quota) {
+    ucs_status_t status;
+    ucs_mpool_t mp;
+
+    ucs_mpool_ops_t ops = {
+       ucs_mpool_chunk_malloc,
+       ucs_mpool_chunk_free,
+       NULL,
+       NULL
+    };
+
+    status = ucs_mpool_init(&mp, 0, header_size + data_size, header_size, align,
+                            6, 18, &ops, "test");
+    ASSERT_UCS_OK(status);
+
+    status = ucs_mpool_set_thread_safe(&mp, 4);
+    ASSERT_UCS_OK(status);
+
+    for (unsigned loop = 0; loop < 10; ++loop) {
+        std::vector<void*> objs;
+        for (unsigned i = 0; i < 18; ++i) {
+            void *ptr = ucs_mpool_get(&mp);
+            ASSERT_TRUE(ptr != NULL);
+            ASSERT_EQ(0ul, ((uintptr_t)ptr + header_size) % align) << ptr;
+            objs.push_back(ptr);
+        }
+
+        ASSERT_TRUE(NULL == ucs_mpool_get(&mp));
+        EXPECT_TRUE(ucs_mpool_is_empty(&mp));
+
+        for (std::vector<void*>::iterator iter = objs.begin(); iter != objs.end(); ++iter) {
+            ucs_mpool_put(*iter);
+        }
+    }
+
+    ucs_mpool_cleanup(&mp, 1);
+}
+
+UCS_TEST_F(test_mpool, thread_safe_mt) {
+    const unsigned num_threads = 8;
+    std::vector<pthread_t> threads(num_threads);
+    ucs_status_t status;
+    ucs_mpool_t mp;
+    mt_ctx ctx;
+
+    ucs_mpool_ops_t ops = {
+       ucs_mpool_chunk_malloc,
+       ucs_mpool_chunk_free,
+       NULL,
+       NULL
+    };
+
+    status = ucs_mpool_init(&mp, 0, header_size + data_size, header_size, align,
+                            32, UINT_MAX, &ops, "test");
+    ASSERT_UCS_OK(status);
+
+    status = ucs_mpool_set_thread_safe(&mp, 8);
+    ASSERT_UCS_OK(status);
+
+    ctx.mp = &mp;
+    pthread_mutex_init(&ctx.lock, NULL);
+
+    for (unsigned i = 0; i < num_threads; ++i) {
+        pthread_create(&threads[i], NULL, mt_thread_func, &ctx);
+    }
+
+    for (unsigned i = 0; i < num_threads; ++i) {
+        void *ret;
+        pthread_join(threads[i], &ret);
+        EXPECT_TRUE(ret == NULL);
+    }
+
+    for (std::vector<void*>::iterator iter = ctx.exchange.begin();
+         iter != ctx.exchange.end(); ++iter) {
+        ucs_mpool_put(*iter);
+    }
+
+    pthread_mutex_destroy(&ctx.lock);
+    ucs_mpool_cleanup(&mp, 1);
+}
@@ -12,6 +12,7 @@ extern "C" {
 
 #include <fstream>
 #include <set>
+#include <pthread.h>
 
 
 #if HAVE_PROFILING
@@ -55,6 +56,15 @@ public:
     void test_header(ucs_profile_header_t *hdr, unsigned exp_mode);
     void test_locations(ucs_profile_location_t *locations, unsigned num_locations,
                         uint64_t exp_count);
+
+    static ucs_profile_thread_header_t*
+    thread_header(ucs_profile_header_t *hdr, unsigned thread_idx);
+    static ucs_profile_thread_location_t*
+    thread_locations(ucs_profile_thread_header_t *thread_hdr);
+    static ucs_profile_record_t*
+    thread_records(ucs_profile_header_t *hdr,
+                   ucs_profile_thread_header_t *thread_hdr);
+    static void *profile_thread_func(void *arg);
 };
 
 const char* test_profile::UCS_PROFILE_FILENAME = "test.prof";
@@ -93,6 +103,46 @@ void test_profile::test_header(ucs_profile_header_t *hdr, unsigned exp_mode)
     EXPECT_NEAR(hdr->one_second / ucs_time_from_sec(1.0), 1.0, 0.01);
 }
 
+ucs_profile_thread_header_t*
+test_profile::thread_header(ucs_profile_header_t *hdr, unsigned thread_idx)
+{
+    ucs_profile_location_t *locations =
+                    reinterpret_cast<ucs_profile_location_t*>(hdr + 1);
+    ucs_profile_thread_header_t *thread_hdr =
+                    reinterpret_cast<ucs_profile_thread_header_t*>(
+                                    locations + hdr->num_locations);
+
+    for (unsigned i = 0; i < thread_idx; ++i) {
+        thread_hdr = reinterpret_cast<ucs_profile_thread_header_t*>(
+                        thread_records(hdr, thread_hdr) + thread_hdr->num_records);
+    }
+    return thread_hdr;
+}
+
+ucs_profile_thread_location_t*
+test_profile::thread_locations(ucs_profile_thread_header_t *thread_hdr)
+{
+    return reinterpret_cast<ucs_profile_thread_location_t*>(thread_hdr + 1);
+}
+
+ucs_profile_record_t*
+test_profile::thread_records(ucs_profile_header_t *hdr,
+                             ucs_profile_thread_header_t *thread_hdr)
+{
+    return reinterpret_cast<ucs_profile_record_t*>(
+                    thread_locations(thread_hdr) + hdr->num_locations);
+}
+
+void *test_profile::profile_thread_func(void *arg)
+{
+    int iters = *reinterpret_cast<int*>(arg);
+    for (int i = 0; i < iters; ++i) {
+        profile_test_func1();
+        profile_test_func2(1, 2);
+    }
+    return NULL;
+}
+
 void test_profile::test_locations(ucs_profile_location_t *locations,
                                   unsigned num_locations, uint64_t exp_count)
 {
@@ -130,6 +180,8 @@ UCS_TEST_F(test_profile, accum) {
                    hdr->num_locations,
                    1);
 
+    EXPECT_EQ(1u, hdr->num_threads);
+    EXPECT_EQ((uint32_t)ucs_get_tid(), thread_header(hdr, 0)->tid);
     EXPECT_EQ(0u, hdr->num_records);
 }
 
@@ -150,8 +202,10 @@ UCS_TEST_F(test_profile, log) {
     test_locations(locations, hdr->num_locations, 0);
 
     EXPECT_EQ(12 * ITER, (int)hdr->num_records);
-    ucs_profile_record_t *records = reinterpret_cast<ucs_profile_record_t*>(locations +
-                                                                            hdr->num_locations);
+    ASSERT_EQ(1u, hdr->num_threads);
+    ucs_profile_thread_header_t *thread_hdr = thread_header(hdr, 0);
+    EXPECT_EQ(hdr->num_records, thread_hdr->num_records);
+    ucs_profile_record_t *records = thread_records(hdr, thread_hdr);
     uint64_t prev_ts = records[0].timestamp;
     for (uint64_t i = 0; i < hdr->num_records; ++i) {
         ucs_profile_record_t *rec = &records[i];
@@ -169,4 +223,62 @@ UCS_TEST_F(test_profile, log) {
     }
 }
 
+UCS_TEST_F(test_profile, multi_thread) {
+    static const int NUM_THREADS = 4;
+    static int ITER              = 10;
+    scoped_profile p(*this, UCS_PROFILE_FILENAME, "accum,log");
+    std::vector<pthread_t> threads(NUM_THREADS);
+
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        pthread_create(&threads[i], NULL, profile_thread_func, &ITER);
+    }
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    std::string data = p.read();
+    ucs_profile_header_t *hdr = reinterpret_cast<ucs_profile_header_t*>(&data[0]);
+    test_header(hdr, UCS_BIT(UCS_PROFILE_MODE_ACCUM) | UCS_BIT(UCS_PROFILE_MODE_LOG));
+
+    /* the counters of all threads are merged */
+    EXPECT_EQ(12u, hdr->num_locations);
+    ucs_profile_location_t *locations = reinterpret_cast<ucs_profile_location_t*>(hdr + 1);
+    for (unsigned i = 0; i < hdr->num_locations; ++i) {
+        EXPECT_EQ((size_t)(NUM_THREADS * ITER), locations[i].count);
+    }
+
+    ASSERT_EQ((unsigned)NUM_THREADS, hdr->num_threads);
+    EXPECT_EQ((uint64_t)(12 * ITER * NUM_THREADS), hdr->num_records);
+
+    std::set<uint32_t> tids;
+    for (unsigned t = 0; t < hdr->num_threads; ++t) {
+        ucs_profile_thread_header_t *thread_hdr = thread_header(hdr, t);
+        tids.insert(thread_hdr->tid);
+        EXPECT_EQ((uint64_t)(12 * ITER), thread_hdr->num_records);
+
+        ucs_profile_thread_location_t *thread_locs = thread_locations(thread_hdr);
+        for (unsigned i = 0; i < hdr->num_locations; ++i) {
+            EXPECT_EQ((size_t)ITER, thread_locs[i].count);
+        }
+
+        /* every thread has its own scope stack, so the nesting is consistent */
+        ucs_profile_record_t *records = thread_records(hdr, thread_hdr);
+        int nesting = 0;
+        for (uint64_t i = 0; i < thread_hdr->num_records; ++i) {
+            ucs_profile_location_t *loc = &locations[records[i].location];
+            if (loc->type == UCS_PROFILE_TYPE_SCOPE_BEGIN) {
+                ++nesting;
+            } else if (loc->type == UCS_PROFILE_TYPE_SCOPE_END) {
+                --nesting;
+                EXPECT_GE(nesting, 0);
+            }
+            if (i > 0) {
+                EXPECT_GE(records[i].timestamp, records[i - 1].timestamp);
+            }
+        }
+        EXPECT_EQ(0, nesting);
+    }
+    EXPECT_EQ((size_t)NUM_THREADS, tids.size());
+}
+
 #endif
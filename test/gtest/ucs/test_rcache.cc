@@ -9,6 +9,7 @@ extern "C" {
 #include <ucs/arch/atomic.h>
 #include <ucs/sys/rcache.h>
 #include <ucs/sys/sys.h>
+#include <ucs/time/time.h>
 }
 
 
@@ -24,8 +25,7 @@ protected:
     test_rcache() : m_reg_count(0), m_ptr(NULL) {
     }
 
-    virtual void init() {
-        ucs::test::init();
+    virtual ucs_rcache_params_t rcache_params() {
         static const ucs_rcache_ops_t ops = {
             mem_reg_cb,
             mem_dereg_cb,
@@ -36,8 +36,16 @@ protected:
             UCS_PGT_ADDR_ALIGN,
             1000,
             &ops,
-            reinterpret_cast<void*>(this)
+            reinterpret_cast<void*>(this),
+            UCS_CONFIG_ULUNITS_INF,
+            UCS_CONFIG_MEMUNITS_INF
         };
+        return params;
+    }
+
+    virtual void init() {
+        ucs::test::init();
+        ucs_rcache_params_t params = rcache_params();
         UCS_TEST_CREATE_HANDLE(ucs_rcache_t*, m_rcache, ucs_rcache_destroy,
                                ucs_rcache_create, &params, "test" UCS_STATS_ARG(NULL));
     }
@@ -474,3 +482,202 @@ UCS_MT_TEST_F(test_rcache_no_register, register_failure, 10) {
 
     free(ptr);
 }
+
+UCS_MT_TEST_F(test_rcache, lookup_perf, 6) {
+    static const size_t size = 1 * 1024 * 1024;
+    const unsigned count     = 1000000 / ucs::test_time_multiplier();
+    ucs_time_t start_time;
+    region *region;
+
+    void *mem = shared_malloc(size);
+
+    /* Create the region, so all lookups below would be cache hits */
+    region = get(mem, size);
+    put(region);
+    barrier();
+
+    start_time = ucs_get_time();
+    for (unsigned i = 0; i < count; ++i) {
+        region = get(mem, size);
+        put(region);
+    }
+    double nsec = ucs_time_to_nsec(ucs_get_time() - start_time) / count;
+    UCS_TEST_MESSAGE << "thread " << ucs_get_tid() << ": " << nsec <<
+                        " nsec per get+put";
+
+    shared_free(mem);
+}
+
+
+class test_rcache_lru : public test_rcache {
+protected:
+    static const unsigned long max_regions = 4;
+    static const size_t        region_size = 16 * 1024;
+
+    virtual ucs_rcache_params_t rcache_params() {
+        ucs_rcache_params_t params = test_rcache::rcache_params();
+        params.max_regions = max_regions;
+        params.max_size    = max_regions * region_size;
+        return params;
+    }
+
+    /* Regions are separated by a page, so they would not be merged */
+    static void *region_ptr(void *mem, unsigned index) {
+        return (char*)mem + index * (region_size + ucs_get_page_size());
+    }
+
+    static size_t mem_size(unsigned num_regions) {
+        return num_regions * (region_size + ucs_get_page_size());
+    }
+};
+
+const unsigned long test_rcache_lru::max_regions;
+const size_t        test_rcache_lru::region_size;
+
+UCS_TEST_F(test_rcache_lru, evict) {
+    static const unsigned num_regions = max_regions * 4;
+    void *mem = alloc_pages(mem_size(num_regions), PROT_READ|PROT_WRITE);
+    region *region;
+    uint32_t id = 0;
+
+    for (unsigned i = 0; i < num_regions; ++i) {
+        region = get(region_ptr(mem, i), region_size);
+        id     = region->id;
+        put(region);
+        EXPECT_LE(m_reg_count, max_regions);
+    }
+
+    /* The most recent region should still be cached */
+    region = get(region_ptr(mem, num_regions - 1), region_size);
+    EXPECT_EQ(id, region->id);
+    put(region);
+
+    munmap(mem, mem_size(num_regions));
+}
+
+UCS_TEST_F(test_rcache_lru, evict_size) {
+    static const unsigned num_regions = max_regions * 2;
+    void *mem = alloc_pages(mem_size(num_regions) + region_size * max_regions,
+                            PROT_READ|PROT_WRITE);
+    region *region;
+
+    /* Large region takes the whole size limit */
+    region = get(mem, region_size * max_regions);
+    put(region);
+    EXPECT_EQ(1u, m_reg_count);
+
+    mem = (char*)mem + region_size * max_regions + ucs_get_page_size();
+    region = get(mem, region_size);
+    put(region);
+    EXPECT_EQ(1u, m_reg_count);
+
+    munmap((char*)mem - region_size * max_regions - ucs_get_page_size(),
+           mem_size(num_regions) + region_size * max_regions);
+}
+
+UCS_TEST_F(test_rcache_lru, inuse_not_evicted) {
+    static const unsigned num_regions = max_regions * 4;
+    void *mem = alloc_pages(mem_size(num_regions), PROT_READ|PROT_WRITE);
+    std::vector<region*> regions;
+
+    /* Regions which are in use are not evicted, even above the limit */
+    for (unsigned i = 0; i < num_regions; ++i) {
+        regions.push_back(get(region_ptr(mem, i), region_size));
+    }
+    EXPECT_EQ(num_regions, m_reg_count);
+
+    for (unsigned i = 0; i < num_regions; ++i) {
+        EXPECT_EQ(uint32_t(MAGIC), regions[i]->magic);
+        EXPECT_FALSE(regions[i]->super.flags & UCS_RCACHE_REGION_FLAG_INVALID);
+    }
+
+    for (unsigned i = 0; i < num_regions; ++i) {
+        put(regions[i]);
+    }
+
+    /* Next update of the cache brings it back to the limit */
+    put(get(region_ptr(mem, 0), region_size * 2));
+    EXPECT_LE(m_reg_count, max_regions);
+
+    munmap(mem, mem_size(num_regions));
+}
+
+
+#if ENABLE_STATS
+
+class test_rcache_stats : public test_rcache {
+protected:
+
+    virtual void init() {
+        ucs_stats_cleanup();
+        push_config();
+        modify_config("STATS_DEST",    "file:/dev/null");
+        modify_config("STATS_TRIGGER", "exit");
+        ucs_stats_init();
+        ASSERT_TRUE(ucs_stats_is_active());
+        test_rcache::init();
+    }
+
+    virtual void cleanup() {
+        test_rcache::cleanup();
+        ucs_stats_cleanup();
+        pop_config();
+        ucs_stats_init();
+    }
+
+    ucs_stats_counter_t counter(int index) {
+        return UCS_STATS_GET_COUNTER(m_rcache.get()->stats, index);
+    }
+};
+
+UCS_TEST_F(test_rcache_stats, get_put_unmap) {
+    static const size_t size = 64 * ucs_get_page_size();
+    void *mem1, *mem2;
+    region *region;
+
+    mem1 = alloc_pages(size, PROT_READ|PROT_WRITE);
+    mem2 = alloc_pages(size, PROT_READ|PROT_WRITE);
+
+    /* New region */
+    region = get(mem1, size);
+    put(region);
+    EXPECT_EQ(1u, counter(UCS_RCACHE_STAT_GETS));
+    EXPECT_EQ(1u, counter(UCS_RCACHE_STAT_MISSES));
+    EXPECT_EQ(0u, counter(UCS_RCACHE_STAT_HITS_FAST));
+    EXPECT_EQ(1u, counter(UCS_RCACHE_STAT_PUTS));
+    EXPECT_EQ(1u, counter(UCS_RCACHE_STAT_REGIONS));
+    EXPECT_EQ(size, counter(UCS_RCACHE_STAT_PINNED_BYTES));
+
+    /* Cached region */
+    region = get(mem1, size);
+    put(region);
+    EXPECT_EQ(2u, counter(UCS_RCACHE_STAT_GETS));
+    EXPECT_EQ(1u, counter(UCS_RCACHE_STAT_MISSES));
+    EXPECT_EQ(1u, counter(UCS_RCACHE_STAT_HITS_FAST));
+    EXPECT_EQ(2u, counter(UCS_RCACHE_STAT_PUTS));
+
+    /* Unmapping the memory only queues the invalidation */
+    munmap(mem1, size);
+    EXPECT_EQ(1u, counter(UCS_RCACHE_STAT_UNMAPS));
+    EXPECT_EQ(0u, counter(UCS_RCACHE_STAT_UNMAP_INVALIDATES));
+    EXPECT_EQ(0u, counter(UCS_RCACHE_STAT_DEREGS));
+
+    /* The next get goes to the slow path, which releases the unmapped region */
+    region = get(mem2, size);
+    put(region);
+    EXPECT_EQ(3u, counter(UCS_RCACHE_STAT_GETS));
+    EXPECT_EQ(2u, counter(UCS_RCACHE_STAT_MISSES));
+    EXPECT_EQ(1u, counter(UCS_RCACHE_STAT_HITS_FAST));
+    EXPECT_EQ(1u, counter(UCS_RCACHE_STAT_UNMAP_INVALIDATES));
+    EXPECT_EQ(1u, counter(UCS_RCACHE_STAT_DEREGS));
+    EXPECT_EQ(1u, counter(UCS_RCACHE_STAT_REGIONS));
+    EXPECT_EQ(size, counter(UCS_RCACHE_STAT_PINNED_BYTES));
+
+    EXPECT_EQ(0u, counter(UCS_RCACHE_STAT_HITS_SLOW));
+    EXPECT_EQ(0u, counter(UCS_RCACHE_STAT_MERGES));
+    EXPECT_EQ(0u, counter(UCS_RCACHE_STAT_LRU_EVICTS));
+
+    munmap(mem2, size);
+}
+
+#endif
@@ -246,3 +246,80 @@ UCS_TEST_F(twheel, delayed_sweep) {
     }
 }
 
+
+UCS_TEST_F(twheel, long_timers) {
+    static const uint64_t ticks[] = { 1, 2, 63, 64, 65, 127, 128, 4095, 4096,
+                                      4097, 262143, 262145, 1000003,
+                                      (1ull << 30) + 3, (1ull << 42) + 5,
+                                      (1ull << 50) - 1 };
+    static const size_t n = sizeof(ticks) / sizeof(ticks[0]);
+    std::vector<struct hr_timer> t(n);
+    ucs_time_t res;
+
+    /* use a synthetic clock, so expiration can be checked exactly */
+    ucs_twheel_cleanup(&m_wheel);
+    ASSERT_UCS_OK(ucs_twheel_init(&m_wheel, 1024, 0));
+    res = m_wheel.res;
+
+    init_timerv(&t[0], n);
+    for (size_t i = 0; i < n; ++i) {
+        t[i].d = ticks[i] * res;
+        add_timer(&t[i]);
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        /* must not expire one tick before its time */
+        ucs_twheel_sweep(&m_wheel, t[i].d - res / 2);
+        EXPECT_EQ(0ull, t[i].end_time) << "ticks=" << ticks[i];
+
+        ucs_twheel_sweep(&m_wheel, t[i].d);
+        EXPECT_EQ(t[i].d, t[i].end_time) << "ticks=" << ticks[i];
+
+        for (size_t j = i + 1; j < n; ++j) {
+            EXPECT_EQ(0ull, t[j].end_time) << "ticks=" << ticks[j];
+        }
+    }
+}
+
+UCS_TEST_F(twheel, add_remove) {
+    std::vector<struct hr_timer> t(N_TIMERS);
+    ucs_time_t now, max_d;
+
+    ucs_twheel_cleanup(&m_wheel);
+    ASSERT_UCS_OK(ucs_twheel_init(&m_wheel, 1024, 0));
+
+    max_d = 0;
+    init_timerv(&t[0], N_TIMERS);
+    for (int i = 0; i < N_TIMERS; ++i) {
+        t[i].d = m_wheel.res * (1 + (::rand() % 100000));
+        max_d  = ucs_max(max_d, t[i].d);
+        add_timer(&t[i]);
+    }
+
+    for (int i = 0; i < N_TIMERS; i += 2) {
+        ucs_wtimer_remove(&t[i].timer);
+    }
+
+    /* sweep with irregular steps, timers must expire on the first sweep at or
+     * after their expiration time */
+    for (now = 0; now <= max_d; now += ::rand() % (m_wheel.res * 64)) {
+        ucs_twheel_sweep(&m_wheel, now);
+        for (int i = 1; i < N_TIMERS; i += 2) {
+            if (t[i].d <= m_wheel.now) {
+                EXPECT_NE(0ull, t[i].end_time);
+            } else {
+                EXPECT_EQ(0ull, t[i].end_time);
+            }
+        }
+    }
+    ucs_twheel_sweep(&m_wheel, max_d + m_wheel.res);
+
+    for (int i = 0; i < N_TIMERS; ++i) {
+        if (i % 2) {
+            EXPECT_GE(t[i].end_time, t[i].d);
+            EXPECT_LT(t[i].end_time, t[i].d + m_wheel.res * 64);
+        } else {
+            EXPECT_EQ(0ull, t[i].end_time);
+        }
+    }
+}
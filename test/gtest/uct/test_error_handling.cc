@@ -116,6 +116,9 @@ UCS_TEST_P(test_error_handling, peer_failure)
               UCS_ERR_ENDPOINT_TIMEOUT);
     EXPECT_EQ(uct_ep_pending_add(m_e1->ep(0), NULL),
               UCS_ERR_ENDPOINT_TIMEOUT);
+    EXPECT_EQ(uct_ep_pending_add_prio(m_e1->ep(0), NULL,
+                                      UCT_PENDING_PRIO_CONTROL),
+              UCS_ERR_ENDPOINT_TIMEOUT);
     EXPECT_EQ(uct_ep_connect_to_ep(m_e1->ep(0), NULL, NULL),
               UCS_ERR_ENDPOINT_TIMEOUT);
 }
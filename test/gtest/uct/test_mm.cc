@@ -51,6 +51,12 @@ public:
         return UCS_OK;
     }
 
+    static ucs_status_t mm_am_count_handler(void *arg, void *data,
+                                            size_t length, void *desc) {
+        ++(*(unsigned*)arg);
+        return UCS_OK;
+    }
+
     void cleanup() {
         uct_test::cleanup();
     }
@@ -99,4 +105,144 @@ UCS_TEST_P(test_uct_mm, open_for_posix) {
     }
 }
 
+UCS_TEST_P(test_uct_mm, rx_max_poll, "RX_MAX_POLL=4") {
+    static const unsigned max_poll = 4;
+    uint64_t send_data = 0xdeadbeef;
+    unsigned count     = 0;
+    ucs_status_t status;
+
+    initialize();
+    check_caps(UCT_IFACE_FLAG_AM_SHORT | UCT_IFACE_FLAG_AM_CB_SYNC);
+
+    uct_iface_set_am_handler(m_e2->iface(), 0, mm_am_count_handler, &count,
+                             UCT_AM_CB_FLAG_SYNC);
+
+    for (unsigned i = 0; i < 2 * max_poll + 1; ++i) {
+        status = uct_ep_am_short(m_e1->ep(0), 0, 0, &send_data,
+                                 sizeof(send_data));
+        ASSERT_UCS_OK(status);
+    }
+
+    /* every progress call reads up to RX_MAX_POLL elements */
+    m_e2->progress();
+    EXPECT_EQ(max_poll, count);
+
+    m_e2->progress();
+    EXPECT_EQ(2 * max_poll, count);
+
+    m_e2->progress();
+    EXPECT_EQ(2 * max_poll + 1, count);
+
+    uct_iface_set_am_handler(m_e2->iface(), 0, NULL, NULL, UCT_AM_CB_FLAG_SYNC);
+}
+
+UCS_TEST_P(test_uct_mm, fifo_reserve, "FIFO_RESERVE=8") {
+    uint64_t send_data = 0xdeadbeef;
+    unsigned count     = 0;
+    entity *e3;
+    ucs_status_t status;
+
+    initialize();
+    check_caps(UCT_IFACE_FLAG_AM_SHORT | UCT_IFACE_FLAG_AM_CB_SYNC);
+
+    e3 = uct_test::create_entity(0);
+    m_entities.push_back(e3);
+    e3->connect(0, *m_e2, 1);
+
+    uct_iface_set_am_handler(m_e2->iface(), 0, mm_am_count_handler, &count,
+                             UCT_AM_CB_FLAG_SYNC);
+
+    /* the first sender reserves several elements, so the message of the
+     * second sender is placed after them */
+    status = uct_ep_am_short(m_e1->ep(0), 0, 0, &send_data, sizeof(send_data));
+    ASSERT_UCS_OK(status);
+    status = uct_ep_am_short(e3->ep(0), 0, 0, &send_data, sizeof(send_data));
+    ASSERT_UCS_OK(status);
+
+    m_e2->progress();
+    EXPECT_EQ(1u, count);
+
+    /* the receiver can't read past the unused reserved elements */
+    m_e2->progress();
+    EXPECT_EQ(1u, count);
+
+    /* progress on the first sender releases them */
+    m_e1->progress();
+    m_e2->progress();
+    EXPECT_EQ(2u, count);
+
+    /* flush releases the reserved elements as well */
+    status = uct_ep_am_short(m_e1->ep(0), 0, 0, &send_data, sizeof(send_data));
+    ASSERT_UCS_OK(status);
+    status = uct_ep_am_short(m_e1->ep(0), 0, 0, &send_data, sizeof(send_data));
+    ASSERT_UCS_OK(status);
+    status = uct_ep_am_short(e3->ep(0), 0, 0, &send_data, sizeof(send_data));
+    ASSERT_UCS_OK(status);
+
+    m_e1->flush();
+    wait_for_value(&count, 5u, true);
+    EXPECT_EQ(5u, count);
+
+    uct_iface_set_am_handler(m_e2->iface(), 0, NULL, NULL, UCT_AM_CB_FLAG_SYNC);
+}
+
+UCS_TEST_P(test_uct_mm, rkey_cache) {
+    static const unsigned num_iters = 16;
+    const size_t length = 4096;
+    uct_rkey_bundle_t rkey_bundle, first_rkey, second_rkey;
+    void *rkey_buffer, *buffer;
+    uct_mem_h memh;
+    ucs_status_t status;
+
+    initialize();
+    if (!(m_e1->md_attr().cap.flags & UCT_MD_FLAG_REG)) {
+        UCS_TEST_SKIP_R("memory registration is not supported");
+    }
+
+    buffer = malloc(length);
+    ASSERT_TRUE(buffer != NULL);
+
+    status = uct_md_mem_reg(m_e1->md(), buffer, length, 0, &memh);
+    ASSERT_UCS_OK(status);
+
+    rkey_buffer = malloc(m_e1->md_attr().rkey_packed_size);
+    ASSERT_TRUE(rkey_buffer != NULL);
+
+    status = uct_md_mkey_pack(m_e1->md(), memh, rkey_buffer);
+    ASSERT_UCS_OK(status);
+
+    status = uct_rkey_unpack(rkey_buffer, &first_rkey);
+    ASSERT_UCS_OK(status);
+    status = uct_rkey_release(&first_rkey);
+    ASSERT_UCS_OK(status);
+
+    /* the segment stays attached after the last remote key is released,
+     * so unpacking the same key again maps it to the same local address */
+    for (unsigned i = 0; i < num_iters; ++i) {
+        status = uct_rkey_unpack(rkey_buffer, &rkey_bundle);
+        ASSERT_UCS_OK(status);
+        EXPECT_EQ(first_rkey.rkey,   rkey_bundle.rkey);
+        EXPECT_EQ(first_rkey.handle, rkey_bundle.handle);
+        status = uct_rkey_release(&rkey_bundle);
+        ASSERT_UCS_OK(status);
+    }
+
+    /* keys which are unpacked at the same time share the segment as well */
+    status = uct_rkey_unpack(rkey_buffer, &first_rkey);
+    ASSERT_UCS_OK(status);
+    status = uct_rkey_unpack(rkey_buffer, &second_rkey);
+    ASSERT_UCS_OK(status);
+    EXPECT_EQ(first_rkey.rkey,   second_rkey.rkey);
+    EXPECT_EQ(first_rkey.handle, second_rkey.handle);
+    status = uct_rkey_release(&second_rkey);
+    ASSERT_UCS_OK(status);
+    status = uct_rkey_release(&first_rkey);
+    ASSERT_UCS_OK(status);
+
+    free(rkey_buffer);
+    status = uct_md_mem_dereg(m_e1->md(), memh);
+    ASSERT_UCS_OK(status);
+    free(buffer);
+}
+
 _UCT_INSTANTIATE_TEST_CASE(test_uct_mm, mm)
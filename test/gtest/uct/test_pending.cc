@@ -245,6 +245,7 @@ UCS_TEST_P(test_uct_pending, send_ooo_with_pending)
 
     /* the receive side checks that the messages were received in order.
      * check the last message here. (counter was raised by one for next iteration) */
+    wait_for_value(&counter, send_data - 0xdeadbeef + 1, true);
     EXPECT_EQ(send_data, 0xdeadbeef + counter - 1);
 }
 
@@ -259,6 +260,12 @@ UCS_TEST_P(test_uct_pending, pending_fairness)
         UCS_TEST_SKIP_R("skipping on valgrind");
     }
 
+    if (GetParam()->tl_name == "tcp") {
+        /* send resources are the kernel socket buffers, exhausting them
+         * 10000 times with short messages takes too long */
+        UCS_TEST_SKIP_R("skipping on tcp");
+    }
+
     initialize();
     check_caps(UCT_IFACE_FLAG_AM_SHORT | UCT_IFACE_FLAG_PENDING);
     if (m_e1->iface_attr().cap.flags & UCT_IFACE_FLAG_CONNECT_TO_IFACE) {
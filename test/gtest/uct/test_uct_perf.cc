@@ -10,6 +10,7 @@
 #include <gtest/common/test_perf.h>
 extern "C" {
 #include <ucs/arch/cpu.h>
+#include <tools/perf/libperf_int.h>
 }
 
 
@@ -39,6 +40,11 @@ test_perf::test_spec test_uct_perf::tests[] =
     UCT_PERF_DATA_LAYOUT_SHORT, 0, 1, { 64 }, 1, 2000000l,
     ucs_offsetof(ucx_perf_result_t, msgrate.total_average), 1e-6, 0.8, 80.0 },
 
+  { "am many2one rate", "Mpps",
+    UCX_PERF_API_UCT, UCX_PERF_CMD_AM, UCX_PERF_TEST_TYPE_MANY2ONE,
+    UCT_PERF_DATA_LAYOUT_SHORT, 0, 1, { 8 }, 1, 2000000l,
+    ucs_offsetof(ucx_perf_result_t, msgrate.total_average), 1e-6, 0.8, 80.0 },
+
   { "am bcopy bw", "MB/sec",
     UCX_PERF_API_UCT, UCX_PERF_CMD_AM, UCX_PERF_TEST_TYPE_STREAM_UNI,
     UCT_PERF_DATA_LAYOUT_BCOPY, 0, 1, { 1000 }, 1, 100000l,
@@ -137,4 +143,223 @@ UCS_TEST_P(test_uct_perf, envelope) {
     }
 }
 
+UCS_TEST_P(test_uct_perf, worker_threads) {
+    static const thread_spec threads = { 2, UCX_PERF_THREAD_MODEL_WORKER, true };
+
+    if (GetParam()->tl_name == "cm" || GetParam()->tl_name == "ugni_udt") {
+        UCS_TEST_SKIP;
+    }
+
+    /* Every thread has its own interface, so all tests are possible */
+    for (test_spec *test = tests; test->title != NULL; ++test) {
+        run_test(*test, 0, false, GetParam()->tl_name, GetParam()->dev_name,
+                 threads);
+    }
+}
+
+UCS_TEST_P(test_uct_perf, ep_threads) {
+    static const thread_spec threads = { 2, UCX_PERF_THREAD_MODEL_EP, false };
+
+    if (GetParam()->tl_name == "cm" || GetParam()->tl_name == "ugni_udt") {
+        UCS_TEST_SKIP;
+    }
+
+    /* The threads progress a shared interface, and active message handlers
+     * are per interface, so run only the short put tests */
+    for (test_spec *test = tests; test->title != NULL; ++test) {
+        if ((test->command != UCX_PERF_CMD_PUT) ||
+            (test->data_layout != UCT_PERF_DATA_LAYOUT_SHORT)) {
+            continue;
+        }
+        run_test(*test, 0, false, GetParam()->tl_name, GetParam()->dev_name,
+                 threads);
+    }
+}
+
 UCT_INSTANTIATE_NO_SELF_TEST_CASE(test_uct_perf);
+
+
+class test_perf_cpu_list : public ucs::test {
+protected:
+    static ucs_log_func_rc_t
+    hide_errors(const char *file, unsigned line, const char *function,
+                ucs_log_level_t level, const char *prefix, const char *message,
+                va_list ap)
+    {
+        return (level == UCS_LOG_LEVEL_ERROR) ? UCS_LOG_FUNC_RC_STOP :
+                                                UCS_LOG_FUNC_RC_CONTINUE;
+    }
+
+    ucs_status_t parse(const char *str, std::vector<unsigned> &cpus,
+                       unsigned max_cpus = 8) {
+        unsigned cpus_cnt = 0;
+        ucs_status_t status;
+
+        cpus.resize(max_cpus);
+        ucs_log_push_handler(hide_errors);
+        status = ucx_perf_parse_cpu_list(str, &cpus[0], max_cpus, &cpus_cnt);
+        ucs_log_pop_handler();
+        cpus.resize(cpus_cnt);
+        return status;
+    }
+};
+
+UCS_TEST_F(test_perf_cpu_list, valid) {
+    std::vector<unsigned> cpus;
+
+    ASSERT_UCS_OK(parse("3", cpus));
+    ASSERT_EQ(1u, cpus.size());
+    EXPECT_EQ(3u, cpus[0]);
+
+    ASSERT_UCS_OK(parse("0,2,15,2", cpus));
+    ASSERT_EQ(4u, cpus.size());
+    EXPECT_EQ(0u,  cpus[0]);
+    EXPECT_EQ(2u,  cpus[1]);
+    EXPECT_EQ(15u, cpus[2]);
+    EXPECT_EQ(2u,  cpus[3]);
+
+    /* As many CPUs as the array can hold */
+    ASSERT_UCS_OK(parse("1,2,3", cpus, 3));
+    EXPECT_EQ(3u, cpus.size());
+}
+
+UCS_TEST_F(test_perf_cpu_list, invalid) {
+    static const char *lists[] = { "", ",", "1,", ",1", "1,,2", "a", "1a",
+                                   "1;2", "1 2", NULL };
+    std::vector<unsigned> cpus;
+
+    for (const char **list = lists; *list != NULL; ++list) {
+        EXPECT_EQ(UCS_ERR_INVALID_PARAM, parse(*list, cpus)) << "'" << *list
+                                                             << "'";
+    }
+
+    /* Too many CPUs for the array */
+    EXPECT_EQ(UCS_ERR_INVALID_PARAM, parse("1,2,3,4", cpus, 3));
+}
+
+
+class test_perf_hist : public ucs::test {
+protected:
+    virtual void init() {
+        ucs::test::init();
+        m_perf.resize(2); /* Zero-initialized */
+    }
+
+    ucx_perf_context_t *perf(unsigned index = 0) {
+        return &m_perf[index];
+    }
+
+    void add(ucx_perf_context_t *perf, ucs_time_t value, unsigned count = 1) {
+        perf->latency_hist[ucx_perf_hist_index(value)] += count;
+    }
+
+    double percentile(ucx_perf_context_t *perf, double rank,
+                      double time_unit = 1.0) {
+        ucx_perf_result_t result;
+
+        perf->params.percentiles[0]  = rank;
+        perf->params.percentiles_cnt = 1;
+        ucx_perf_calc_percentiles(perf, &result, time_unit);
+        EXPECT_EQ(1u, result.percentiles_cnt);
+        EXPECT_EQ(rank, result.percentiles[0].rank);
+        return result.percentiles[0].latency;
+    }
+
+private:
+    std::vector<ucx_perf_context_t> m_perf;
+};
+
+UCS_TEST_F(test_perf_hist, bucket) {
+    /* Small values have a bucket each */
+    for (unsigned value = 0; value < UCX_PERF_HIST_SUB_COUNT; ++value) {
+        EXPECT_EQ(value, ucx_perf_hist_index(value));
+        EXPECT_EQ(value, ucx_perf_hist_value(value));
+    }
+
+    /* Larger powers of 2 are split into UCX_PERF_HIST_SUB_COUNT buckets */
+    EXPECT_EQ(63u,  ucx_perf_hist_index(63));
+    EXPECT_EQ(64u,  ucx_perf_hist_index(64));
+    EXPECT_EQ(64u,  ucx_perf_hist_index(65));
+    EXPECT_EQ(65u,  ucx_perf_hist_index(66));
+    EXPECT_EQ(190u, ucx_perf_hist_index(992));
+    EXPECT_EQ(190u, ucx_perf_hist_index(1007));
+    EXPECT_EQ(191u, ucx_perf_hist_index(1008));
+    EXPECT_EQ(UCX_PERF_HIST_SIZE - 1, ucx_perf_hist_index(UINT64_MAX));
+
+    /* The value of a bucket is the middle of its range */
+    EXPECT_EQ(64.5,  ucx_perf_hist_value(64));
+    EXPECT_EQ(999.5, ucx_perf_hist_value(190));
+
+    for (unsigned bit = UCX_PERF_HIST_SUB_BITS; bit < 64; ++bit) {
+        const ucs_time_t values[] = { UCS_BIT(bit), UCS_BIT(bit) / 3 * 4,
+                                      UCS_BIT(bit) * 2 - 1 };
+
+        EXPECT_LT(ucx_perf_hist_index(UCS_BIT(bit) - 1),
+                  ucx_perf_hist_index(UCS_BIT(bit))) << "bit " << bit;
+        for (unsigned i = 0; i < 3; ++i) {
+            unsigned index = ucx_perf_hist_index(values[i]);
+            EXPECT_LT(index, UCX_PERF_HIST_SIZE);
+            EXPECT_NEAR(values[i], ucx_perf_hist_value(index),
+                        values[i] / UCX_PERF_HIST_SUB_COUNT) << values[i];
+        }
+    }
+}
+
+UCS_TEST_F(test_perf_hist, percentile_rank) {
+    EXPECT_EQ(0.0, percentile(perf(), 50)); /* No samples */
+
+    for (ucs_time_t value = 0; value < 10; ++value) {
+        add(perf(), value);
+    }
+
+    /* The rank is rounded up to a whole sample, and is at least 1 */
+    EXPECT_EQ(0.0, percentile(perf(), 0));
+    EXPECT_EQ(0.0, percentile(perf(), 10));
+    EXPECT_EQ(1.0, percentile(perf(), 10.1));
+    EXPECT_EQ(4.0, percentile(perf(), 50));
+    EXPECT_EQ(5.0, percentile(perf(), 50.1));
+    EXPECT_EQ(8.0, percentile(perf(), 90));
+    EXPECT_EQ(9.0, percentile(perf(), 99));
+    EXPECT_EQ(9.0, percentile(perf(), 100));
+
+    /* Larger values are reported as the middle of their bucket */
+    add(perf(), 1000, 10);
+    EXPECT_EQ(9.0,    percentile(perf(), 50));
+    EXPECT_EQ(999.5,  percentile(perf(), 55));
+    EXPECT_EQ(999.5,  percentile(perf(), 100));
+    EXPECT_EQ(499.75, percentile(perf(), 100, 2.0));
+}
+
+UCS_TEST_F(test_perf_hist, max_percentiles) {
+    ucx_perf_result_t result;
+
+    add(perf(), 1);
+    for (unsigned i = 0; i < UCX_PERF_MAX_PERCENTILES; ++i) {
+        perf()->params.percentiles[i] = 50;
+    }
+    perf()->params.percentiles_cnt = UCX_PERF_MAX_PERCENTILES + 1;
+    ucx_perf_calc_percentiles(perf(), &result, 1.0);
+    EXPECT_EQ((unsigned)UCX_PERF_MAX_PERCENTILES, result.percentiles_cnt);
+}
+
+UCS_TEST_F(test_perf_hist, merge) {
+    add(perf(0), 1,    3);
+    add(perf(1), 20,   3);
+    add(perf(1), 1000, 2);
+
+    /* Percentiles of all samples of both histograms */
+    ucx_perf_hist_merge(perf(0), perf(1));
+    EXPECT_EQ(1.0,   percentile(perf(0), 37.5));
+    EXPECT_EQ(20.0,  percentile(perf(0), 50));
+    EXPECT_EQ(20.0,  percentile(perf(0), 75));
+    EXPECT_EQ(999.5, percentile(perf(0), 87.5));
+
+    /* The merged histogram is not changed */
+    EXPECT_EQ(20.0,  percentile(perf(1), 60));
+    EXPECT_EQ(999.5, percentile(perf(1), 61));
+
+    ucx_perf_hist_merge(perf(0), perf(1));
+    EXPECT_EQ(1.0,   percentile(perf(0), 23));
+    EXPECT_EQ(20.0,  percentile(perf(0), 24));
+    EXPECT_EQ(999.5, percentile(perf(0), 70));
+}